@@ -301,6 +301,14 @@ space_opts_decode(struct space_opts *opts, const char *map,
 	if (opts_decode(opts, space_opts_reg, &map, ER_WRONG_SPACE_OPTIONS,
 			BOX_SPACE_FIELD_OPTS, region) != 0)
 		diag_raise();
+	if (opts->compression == space_compression_MAX) {
+		tnt_raise(ClientError, ER_WRONG_SPACE_OPTIONS,
+			  BOX_SPACE_FIELD_OPTS, "unknown compression type");
+	}
+	if (opts->ttl < 0) {
+		tnt_raise(ClientError, ER_WRONG_SPACE_OPTIONS,
+			  BOX_SPACE_FIELD_OPTS, "ttl must be >= 0");
+	}
 	if (opts->sql != NULL) {
 		char *sql = strdup(opts->sql);
 		if (sql == NULL) {
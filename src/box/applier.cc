@@ -30,6 +30,7 @@
  */
 #include "applier.h"
 
+#include <fcntl.h>
 #include <msgpuck.h>
 
 #include "xlog.h"
@@ -48,9 +49,18 @@
 #include "error.h"
 #include "session.h"
 #include "cfg.h"
+#include "txn.h"
+#include "rmean.h"
+#include "space.h"
+#include "schema.h"
+#include "engine.h"
+#include "scoped_guard.h"
+#include "coio_file.h"
 
 STRS(applier_state, applier_STATE);
 
+static const char *applier_stat_strs[applier_stat_MAX] = { "APPLY" };
+
 static inline void
 applier_set_state(struct applier *applier, enum applier_state state)
 {
@@ -97,6 +107,42 @@ applier_log_error(struct applier *applier, struct error *e)
 	applier->last_logged_errcode = errcode;
 }
 
+static void
+applier_update_durable_vclock(struct applier *applier);
+
+/**
+ * Return the compression state to read and write the applier
+ * connection with or NULL if the connection is not compressed.
+ */
+static inline struct xrow_zstd *
+applier_zstd(struct applier *applier)
+{
+	return applier->zstd.cstream != NULL ? &applier->zstd : NULL;
+}
+
+/**
+ * Enable compression of a connection to the master if it is
+ * configured, see IPROTO_COMPRESS. A master which does not
+ * support compression is talked to uncompressed.
+ */
+static void
+applier_compress(struct ev_io *coio, struct ibuf *ibuf,
+		 struct xrow_zstd *zstd)
+{
+	if (!cfg_geti("replication_compression"))
+		return;
+	struct xrow_header row;
+	xrow_encode_compress(&row);
+	coio_write_xrow(coio, NULL, &row);
+	coio_read_xrow(coio, NULL, ibuf, &row);
+	if (row.type == (IPROTO_TYPE_ERROR | ER_UNKNOWN_REQUEST_TYPE))
+		return;
+	if (row.type != IPROTO_OK)
+		xrow_decode_error_xc(&row);
+	if (xrow_zstd_start(zstd) != 0)
+		diag_raise();
+}
+
 /*
  * Fiber function to write vclock to replication master.
  * To track connection status, replica answers master
@@ -130,8 +176,9 @@ applier_writer_f(va_list ap)
 			continue;
 		try {
 			struct xrow_header xrow;
-			xrow_encode_vclock(&xrow, &replicaset.vclock);
-			coio_write_xrow(&io, &xrow);
+			applier_update_durable_vclock(applier);
+			xrow_encode_vclock(&xrow, &applier->durable_vclock);
+			coio_write_xrow(&io, applier_zstd(applier), &xrow);
 		} catch (SocketError *e) {
 			/*
 			 * There is no point trying to send ACKs if
@@ -212,6 +259,11 @@ applier_connect(struct applier *applier)
 	/* Don't display previous error messages in box.info.replication */
 	diag_clear(&fiber()->diag);
 
+	applier_compress(coio, ibuf, &applier->zstd);
+	struct xrow_zstd *zstd = applier_zstd(applier);
+	if (zstd != NULL)
+		say_info("compression enabled");
+
 	/*
 	 * Tarantool >= 1.7.7: send an IPROTO_REQUEST_VOTE message
 	 * to fetch the master's vclock before proceeding to "join".
@@ -219,8 +271,8 @@ applier_connect(struct applier *applier)
 	 */
 	if (applier->version_id >= version_id(1, 7, 7)) {
 		xrow_encode_request_vote(&row);
-		coio_write_xrow(coio, &row);
-		coio_read_xrow(coio, ibuf, &row);
+		coio_write_xrow(coio, zstd, &row);
+		coio_read_xrow(coio, zstd, ibuf, &row);
 		if (row.type != IPROTO_OK)
 			xrow_decode_error_xc(&row);
 		vclock_create(&applier->vclock);
@@ -242,8 +294,8 @@ applier_connect(struct applier *applier)
 	applier_set_state(applier, APPLIER_AUTH);
 	xrow_encode_auth_xc(&row, greeting.salt, greeting.salt_len, uri->login,
 			    uri->login_len, uri->password, uri->password_len);
-	coio_write_xrow(coio, &row);
-	coio_read_xrow(coio, ibuf, &row);
+	coio_write_xrow(coio, zstd, &row);
+	coio_read_xrow(coio, zstd, ibuf, &row);
 	applier->last_row_time = ev_monotonic_now(loop());
 	if (row.type != IPROTO_OK)
 		xrow_decode_error_xc(&row); /* auth failed */
@@ -254,6 +306,218 @@ done:
 	applier_set_state(applier, APPLIER_READY);
 }
 
+/**
+ * An extra connection initial data is received over on JOIN,
+ * see box_process_join_stream().
+ */
+struct applier_join_stream {
+	struct applier *applier;
+	/** Vclock of the checkpoint received in response to JOIN. */
+	struct vclock vclock;
+	/** Stream id, 1 <= id < count. */
+	uint32_t id;
+	/** Number of streams accepted by the master. */
+	uint32_t count;
+	/** Fiber receiving the stream. */
+	struct fiber *fiber;
+};
+
+static void
+applier_join_stream_recv(struct applier_join_stream *stream,
+			 struct ev_io *coio, struct ibuf *ibuf,
+			 struct xrow_zstd *zstd_buf)
+{
+	struct applier *applier = stream->applier;
+	char greetingbuf[IPROTO_GREETING_SIZE];
+	struct xrow_header row;
+	struct sockaddr_storage addrstorage;
+	socklen_t addr_len = sizeof(addrstorage);
+	coio_connect(coio, &applier->uri, (struct sockaddr *)&addrstorage,
+		     &addr_len);
+	coio_readn(coio, greetingbuf, IPROTO_GREETING_SIZE);
+
+	struct greeting greeting;
+	if (greeting_decode(greetingbuf, &greeting) != 0)
+		tnt_raise(ClientError, ER_PROTOCOL, "Invalid greeting");
+	/* The master must be the one we have sent JOIN to. */
+	if (!tt_uuid_is_equal(&greeting.uuid, &applier->uuid))
+		tnt_raise(ClientError, ER_PROTOCOL, "Master UUID changed");
+
+	applier_compress(coio, ibuf, zstd_buf);
+	struct xrow_zstd *zstd = zstd_buf->cstream != NULL ? zstd_buf : NULL;
+
+	struct uri *uri = &applier->uri;
+	if (uri->login) {
+		xrow_encode_auth_xc(&row, greeting.salt, greeting.salt_len,
+				    uri->login, uri->login_len,
+				    uri->password, uri->password_len);
+		coio_write_xrow(coio, zstd, &row);
+		coio_read_xrow(coio, zstd, ibuf, &row);
+		if (row.type != IPROTO_OK)
+			xrow_decode_error_xc(&row); /* auth failed */
+	}
+
+	xrow_encode_join_stream_xc(&row, &INSTANCE_UUID, &stream->vclock,
+				   stream->id, stream->count);
+	coio_write_xrow(coio, zstd, &row);
+	coio_read_xrow(coio, zstd, ibuf, &row);
+	if (iproto_type_is_error(row.type)) {
+		xrow_decode_error_xc(&row);
+	} else if (row.type != IPROTO_OK) {
+		tnt_raise(ClientError, ER_UNKNOWN_REQUEST_TYPE,
+			  (uint32_t) row.type);
+	}
+
+	while (true) {
+		coio_read_xrow(coio, zstd, ibuf, &row);
+		applier->last_row_time = ev_monotonic_now(loop());
+		if (iproto_type_is_dml(row.type)) {
+			xstream_write_xc(applier->join_stream, &row);
+		} else if (row.type == IPROTO_OK) {
+			break; /* end of stream */
+		} else if (iproto_type_is_error(row.type)) {
+			xrow_decode_error_xc(&row);  /* rethrow error */
+		} else {
+			tnt_raise(ClientError, ER_UNKNOWN_REQUEST_TYPE,
+				  (uint32_t) row.type);
+		}
+		if (ibuf_used(ibuf) == 0)
+			ibuf_reset(ibuf);
+		fiber_gc();
+	}
+}
+
+static int
+applier_join_stream_f(va_list ap)
+{
+	struct applier_join_stream *stream =
+		va_arg(ap, struct applier_join_stream *);
+	struct ev_io coio;
+	coio_create(&coio, -1);
+	struct ibuf ibuf;
+	ibuf_create(&ibuf, &cord()->slabc, 1024);
+	struct xrow_zstd zstd;
+	xrow_zstd_create(&zstd, NULL, NULL);
+	int rc = 0;
+	try {
+		applier_join_stream_recv(stream, &coio, &ibuf, &zstd);
+	} catch (Exception *e) {
+		rc = -1;
+	}
+	coio_close(loop(), &coio);
+	xrow_zstd_stop(&zstd);
+	xrow_zstd_destroy(&zstd);
+	ibuf_destroy(&ibuf);
+	return rc;
+}
+
+/**
+ * Start receiving initial data over extra connections. Called
+ * once the main stream is done with system spaces, so that
+ * all user spaces exist by the time their rows arrive.
+ */
+static void
+applier_start_join_streams(struct applier *applier,
+			   struct applier_join_stream *streams,
+			   uint32_t stream_count)
+{
+	char name[FIBER_NAME_MAX];
+	int pos = snprintf(name, sizeof(name), "applierj/");
+	uri_format(name + pos, sizeof(name) - pos, &applier->uri, false);
+
+	for (uint32_t i = 1; i < stream_count; i++) {
+		struct applier_join_stream *stream = &streams[i];
+		stream->applier = applier;
+		vclock_copy(&stream->vclock, &replicaset.vclock);
+		stream->id = i;
+		stream->count = stream_count;
+		stream->fiber = fiber_new_xc(name, applier_join_stream_f);
+		fiber_set_joinable(stream->fiber, true);
+		fiber_start(stream->fiber, stream);
+	}
+}
+
+/**
+ * The memtx snapshot received on JOIN as a file, see
+ * IPROTO_JOIN_FILE. It is stored in memtx_dir as an
+ * in-progress file until its rows are applied.
+ */
+struct applier_join_file {
+	int fd;
+	char path[PATH_MAX];
+};
+
+static void
+applier_join_file_write(struct applier_join_file *file,
+			struct xrow_header *row)
+{
+	const char *data;
+	uint32_t size;
+	xrow_decode_join_file_xc(row, &data, &size);
+	if (file->fd < 0) {
+		snprintf(file->path, sizeof(file->path),
+			 "%s/%020lld.snap.inprogress", cfg_gets("memtx_dir"),
+			 (long long) vclock_sum(&replicaset.vclock));
+		file->fd = coio_file_open(file->path,
+					  O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		if (file->fd < 0) {
+			tnt_raise(SystemError, "failed to create file '%s'",
+				  file->path);
+		}
+	}
+	while (size > 0) {
+		ssize_t n = coio_write(file->fd, data, size);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			tnt_raise(SystemError, "failed to write file '%s'",
+				  file->path);
+		}
+		data += n;
+		size -= n;
+	}
+}
+
+/**
+ * Apply rows of the snapshot received as a file and remove
+ * the file.
+ */
+static void
+applier_join_file_apply(struct applier *applier,
+			struct applier_join_file *file)
+{
+	coio_file_close(file->fd);
+	file->fd = -1;
+	auto unlink_guard = make_scoped_guard([=] {
+		coio_unlink(file->path);
+	});
+	struct xlog_cursor cursor;
+	if (xlog_cursor_open(&cursor, file->path) < 0)
+		diag_raise();
+	auto cursor_guard = make_scoped_guard([&] {
+		xlog_cursor_close(&cursor, false);
+	});
+	say_info("applying `%s'", file->path);
+	int rc;
+	struct xrow_header row;
+	uint64_t row_count = 0;
+	while ((rc = xlog_cursor_next(&cursor, &row, false)) == 0) {
+		xstream_write_xc(applier->join_stream, &row);
+		if (++row_count % 100000 == 0) {
+			applier->last_row_time = ev_monotonic_now(loop());
+			fiber_yield_timeout(0);
+		}
+		fiber_gc();
+	}
+	if (rc < 0)
+		diag_raise();
+	if (!xlog_cursor_is_eof(&cursor)) {
+		diag_set(XlogError, "snapshot `%s' has no EOF marker",
+			 file->path);
+		diag_raise();
+	}
+}
+
 /**
  * Execute and process JOIN request (bootstrap the instance).
  */
@@ -263,9 +527,20 @@ applier_join(struct applier *applier)
 	/* Send JOIN request */
 	struct ev_io *coio = &applier->io;
 	struct ibuf *ibuf = &applier->ibuf;
+	struct xrow_zstd *zstd = applier_zstd(applier);
 	struct xrow_header row;
-	xrow_encode_join_xc(&row, &INSTANCE_UUID);
-	coio_write_xrow(coio, &row);
+	uint32_t stream_count = cfg_geti("replication_join_streams");
+	stream_count = MAX(stream_count, 1);
+	stream_count = MIN(stream_count, REPLICATION_JOIN_STREAMS_MAX);
+	bool join_files = cfg_geti("replication_join_files");
+	xrow_encode_join_xc(&row, &INSTANCE_UUID, stream_count, join_files);
+	coio_write_xrow(coio, zstd, &row);
+	/*
+	 * Masters unaware of JOIN_STREAM and JOIN_FILES don't
+	 * confirm them and send rows over a single connection.
+	 */
+	stream_count = 1;
+	join_files = false;
 
 	/**
 	 * Tarantool < 1.7.0: if JOIN is successful, there is no "OK"
@@ -273,7 +548,7 @@ applier_join(struct applier *applier)
 	 */
 	if (applier->version_id >= version_id(1, 7, 0)) {
 		/* Decode JOIN response */
-		coio_read_xrow(coio, ibuf, &row);
+		coio_read_xrow(coio, zstd, ibuf, &row);
 		if (iproto_type_is_error(row.type)) {
 			xrow_decode_error_xc(&row); /* re-throw error */
 		} else if (row.type != IPROTO_OK) {
@@ -286,19 +561,73 @@ applier_join(struct applier *applier)
 		 * Used to initialize the replica's initial
 		 * vclock in bootstrap_from_master()
 		 */
-		xrow_decode_vclock_xc(&row, &replicaset.vclock);
+		xrow_decode_join_response_xc(&row, &replicaset.vclock,
+					     &stream_count, &join_files);
+		stream_count = MIN(stream_count, REPLICATION_JOIN_STREAMS_MAX);
 	}
 
 	applier_set_state(applier, APPLIER_INITIAL_JOIN);
 
 	/*
-	 * Receive initial data.
+	 * Receive initial data. If the master splits it into
+	 * several streams, the main one carries system spaces
+	 * first, see box_process_join().
 	 */
+	struct applier_join_stream streams[REPLICATION_JOIN_STREAMS_MAX];
+	bool streams_started = false;
+	auto streams_guard = make_scoped_guard([&] {
+		if (!streams_started)
+			return;
+		/* Don't let stream errors override the original one. */
+		struct diag diag;
+		diag_create(&diag);
+		diag_move(diag_get(), &diag);
+		for (uint32_t i = 1; i < stream_count; i++) {
+			if (streams[i].fiber != NULL)
+				fiber_cancel(streams[i].fiber);
+		}
+		for (uint32_t i = 1; i < stream_count; i++) {
+			if (streams[i].fiber != NULL)
+				fiber_join(streams[i].fiber);
+		}
+		diag_clear(diag_get());
+		diag_move(&diag, diag_get());
+		diag_destroy(&diag);
+	});
+	struct applier_join_file file;
+	file.fd = -1;
+	auto file_guard = make_scoped_guard([&] {
+		if (file.fd >= 0) {
+			coio_file_close(file.fd);
+			coio_unlink(file.path);
+		}
+	});
 	assert(applier->join_stream != NULL);
 	while (true) {
-		coio_read_xrow(coio, ibuf, &row);
+		coio_read_xrow(coio, zstd, ibuf, &row);
 		applier->last_row_time = ev_monotonic_now(loop());
+		if (row.type == IPROTO_JOIN_FILE && join_files) {
+			applier_join_file_write(&file, &row);
+			fiber_gc();
+			continue;
+		}
+		/*
+		 * The snapshot goes first, apply it before
+		 * rows of other engines.
+		 */
+		if (file.fd >= 0)
+			applier_join_file_apply(applier, &file);
 		if (iproto_type_is_dml(row.type)) {
+			if (stream_count > 1 && !streams_started) {
+				struct request request;
+				xrow_decode_dml_xc(&row, &request, 0);
+				if (request.space_id > BOX_SYSTEM_ID_MAX) {
+					memset(streams, 0, sizeof(streams));
+					streams_started = true;
+					applier_start_join_streams(applier,
+						streams, stream_count);
+				}
+			}
 			xstream_write_xc(applier->join_stream, &row);
 		} else if (row.type == IPROTO_OK) {
 			if (applier->version_id < version_id(1, 7, 0)) {
@@ -319,6 +648,18 @@ applier_join(struct applier *applier)
 				  (uint32_t) row.type);
 		}
 	}
+	if (stream_count > 1 && !streams_started) {
+		memset(streams, 0, sizeof(streams));
+		streams_started = true;
+		applier_start_join_streams(applier, streams, stream_count);
+	}
+	/* Wait for the rest of initial data. */
+	for (uint32_t i = 1; streams_started && i < stream_count; i++) {
+		struct fiber *f = streams[i].fiber;
+		streams[i].fiber = NULL;
+		if (fiber_join(f) != 0)
+			diag_raise();
+	}
 	say_info("initial data received");
 
 	applier_set_state(applier, APPLIER_FINAL_JOIN);
@@ -335,7 +676,7 @@ applier_join(struct applier *applier)
 	 * Receive final data.
 	 */
 	while (true) {
-		coio_read_xrow(coio, ibuf, &row);
+		coio_read_xrow(coio, zstd, ibuf, &row);
 		applier->last_row_time = ev_monotonic_now(loop());
 		if (iproto_type_is_dml(row.type)) {
 			vclock_follow(&replicaset.vclock, row.replica_id,
@@ -360,6 +701,542 @@ applier_join(struct applier *applier)
 	applier_set_state(applier, APPLIER_READY);
 }
 
+/* {{{ Applier workers */
+
+/** A row received on SUBSCRIBE waiting to be applied. */
+struct applier_row {
+	/** Link in applier_tx::rows. */
+	struct stailq_entry in_tx;
+	/** The row, the body points to data. */
+	struct xrow_header row;
+	char data[0];
+};
+
+/**
+ * Rows of a transaction received on SUBSCRIBE. A transaction
+ * is applied as a whole so that a replica never exposes a
+ * part of a transaction committed on the master.
+ */
+struct applier_tx {
+	/** Link in applier::queue, then in applier::in_flight. */
+	struct stailq_entry in_queue;
+	/** Rows of the transaction, struct applier_row. */
+	struct stailq rows;
+	/** Number of rows in the transaction. */
+	int row_count;
+	/** Set once a worker is done with the transaction. */
+	bool is_done;
+};
+
+static void
+applier_tx_delete(struct applier_tx *tx)
+{
+	struct applier_row *item, *next;
+	stailq_foreach_entry_safe(item, next, &tx->rows, in_tx)
+		free(item);
+	free(tx);
+}
+
+/**
+ * Bound @a lsn, indexed by replica id, by the rows of
+ * transactions the applier has not applied yet.
+ */
+static void
+applier_bound_in_flight(struct applier *applier, int64_t *lsn)
+{
+	struct applier_tx *tx;
+	stailq_foreach_entry(tx, &applier->in_flight, in_queue) {
+		if (tx->is_done)
+			continue;
+		struct xrow_header *first =
+			&stailq_first_entry(&tx->rows, struct applier_row,
+					    in_tx)->row;
+		lsn[first->replica_id] = MIN(lsn[first->replica_id],
+					     first->lsn - 1);
+	}
+}
+
+/**
+ * Advance the durable vclock of the applier. A component of
+ * the replica set vclock is durable up to the first row of
+ * the same replica id which is still being applied, by this
+ * or any other applier, since the replica set vclock is
+ * promoted before the WAL write.
+ */
+static void
+applier_update_durable_vclock(struct applier *applier)
+{
+	int64_t lsn[VCLOCK_MAX];
+	for (uint32_t id = 0; id < VCLOCK_MAX; id++)
+		lsn[id] = vclock_get(&replicaset.vclock, id);
+	applier_bound_in_flight(applier, lsn);
+	replicaset_foreach(replica) {
+		if (replica->applier != NULL && replica->applier != applier)
+			applier_bound_in_flight(replica->applier, lsn);
+	}
+	for (uint32_t id = 0; id < VCLOCK_MAX; id++) {
+		if (lsn[id] > vclock_get(&applier->durable_vclock, id))
+			vclock_follow(&applier->durable_vclock, id, lsn[id]);
+	}
+}
+
+/**
+ * Mark a transaction applied and free transactions at the
+ * head of the in-flight list which are applied, too.
+ */
+static void
+applier_tx_done(struct applier *applier, struct applier_tx *tx)
+{
+	tx->is_done = true;
+	while (!stailq_empty(&applier->in_flight)) {
+		tx = stailq_first_entry(&applier->in_flight,
+					struct applier_tx, in_queue);
+		if (!tx->is_done)
+			break;
+		stailq_shift(&applier->in_flight);
+		applier_tx_delete(tx);
+	}
+	/* Let the writer send the new durable vclock. */
+	fiber_cond_signal(&applier->writer_cond);
+}
+
+/**
+ * Locks held by a worker while it applies a row, released as
+ * soon as the row is submitted to WAL.
+ */
+struct applier_apply_locks {
+	struct trigger on_yield;
+	struct applier *applier;
+	/** Partition latch, NULL if the row is applied in order. */
+	struct latch *partition;
+	/** Replica order latch, NULL if not taken yet. */
+	struct latch *order_latch;
+	/** Set once the locks are released. */
+	bool is_released;
+};
+
+/** Release row locks and let the next row go to WAL. */
+static void
+applier_apply_locks_release(struct applier_apply_locks *locks)
+{
+	struct applier *applier = locks->applier;
+	trigger_clear(&locks->on_yield);
+	if (locks->order_latch != NULL)
+		latch_unlock(locks->order_latch);
+	if (locks->partition != NULL)
+		latch_unlock(locks->partition);
+	applier->commit_seq++;
+	fiber_cond_broadcast(&applier->commit_cond);
+	locks->is_released = true;
+}
+
+/**
+ * On yield trigger of a worker. A transaction may yield before
+ * its rows are submitted to WAL, e.g. on a vinyl disk read or
+ * while waiting for vinyl memory quota in engine prepare, so
+ * the locks are held until the journal entry is queued. The
+ * commit yields right after that, and since WAL writes
+ * entries in the order they are queued, the next row goes to
+ * WAL after this one.
+ */
+static void
+applier_apply_on_yield(struct trigger *trigger, void *event)
+{
+	(void) event;
+	struct txn *txn = in_txn();
+	if (txn == NULL || !txn->is_in_wal)
+		return;
+	applier_apply_locks_release((struct applier_apply_locks *)
+				    trigger->data);
+}
+
+/** Wait until all rows with seq less than @a seq are in WAL. */
+static void
+applier_wait_commit_seq(struct applier *applier, uint64_t seq)
+{
+	/* The row is taken from the queue, never give up. */
+	while (applier->commit_seq < seq)
+		fiber_cond_wait(&applier->commit_cond);
+}
+
+/**
+ * Return the space a row can be applied to out of order in
+ * the parallel mode, or NULL if the row must be applied in
+ * order. Only rows of vinyl user spaces are applied out of
+ * order: memtx statements never yield, so there is nothing
+ * to overlap, while system space rows change the schema.
+ * A space with triggers is applied in order, too, since a
+ * trigger may read or write other spaces. A transaction is
+ * applied out of order only if all its rows go to the same
+ * space.
+ */
+static struct space *
+applier_parallel_space(struct xrow_header *row)
+{
+	struct request request;
+	if (xrow_decode_dml(row, &request,
+			    dml_request_key_map(row->type)) != 0) {
+		/* Let the in-order path report the error. */
+		diag_clear(diag_get());
+		return NULL;
+	}
+	if (request.space_id < BOX_SYSTEM_ID_MAX)
+		return NULL;
+	struct space *space = space_by_id(request.space_id);
+	if (space == NULL || strcmp(space->engine->name, "vinyl") != 0)
+		return NULL;
+	if (!rlist_empty(&space->before_replace) ||
+	    !rlist_empty(&space->on_replace) ||
+	    !rlist_empty(&space->on_stmt_begin))
+		return NULL;
+	return space;
+}
+
+/** Execute rows of a transaction the replica has not seen yet. */
+static int
+applier_tx_execute(struct applier *applier, struct applier_tx *tx,
+		   int64_t vclock_lsn)
+{
+	struct applier_row *item;
+	stailq_foreach_entry(item, &tx->rows, in_tx) {
+		if (item->row.lsn <= vclock_lsn)
+			continue;
+		if (xstream_write(applier->subscribe_stream, &item->row) != 0)
+			return -1;
+	}
+	return 0;
+}
+
+/**
+ * Apply a transaction, preserving the order of transactions
+ * coming from the same replica id, possibly via different
+ * appliers. On error, stores the error in the applier before
+ * letting the next transaction proceed.
+ *
+ * Transactions are numbered in the order they are taken from
+ * the queue and are submitted to WAL strictly in this order.
+ * In the parallel mode, a transaction of a vinyl user space
+ * is executed as soon as all transactions of the same
+ * partition (spaces are partitioned by id) taken before it
+ * are submitted to WAL and then waits for its turn to commit.
+ * So statements of different spaces, which may yield on disk
+ * reads, are executed concurrently. Any other transaction is
+ * a barrier: it is executed only when all transactions before
+ * it are submitted to WAL and no transaction after it is
+ * executed until it is submitted.
+ */
+static int
+applier_apply_tx(struct applier *applier, struct applier_tx *tx)
+{
+	struct xrow_header *first =
+		&stailq_first_entry(&tx->rows, struct applier_row,
+				    in_tx)->row;
+	struct xrow_header *last =
+		&stailq_last_entry(&tx->rows, struct applier_row,
+				   in_tx)->row;
+
+	struct applier_apply_locks locks;
+	trigger_create(&locks.on_yield, applier_apply_on_yield, &locks, NULL);
+	locks.applier = applier;
+	locks.partition = NULL;
+	locks.order_latch = NULL;
+	locks.is_released = false;
+
+	uint64_t seq = applier->next_seq++;
+	uint64_t barrier_seq = applier->barrier_seq;
+	struct space *space = NULL;
+	if (applier->is_parallel) {
+		space = applier_parallel_space(first);
+		struct applier_row *item;
+		stailq_foreach_entry(item, &tx->rows, in_tx) {
+			if (space == NULL)
+				break;
+			if (applier_parallel_space(&item->row) != space)
+				space = NULL;
+		}
+	}
+
+	int rc = 0;
+	struct txn *txn = NULL;
+	if (space != NULL) {
+		uint32_t partition = space_id(space) % APPLIER_PARTITION_COUNT;
+		locks.partition = &applier->partitions[partition];
+		latch_lock(locks.partition);
+		applier_wait_commit_seq(applier, barrier_seq);
+		txn = txn_begin(false);
+		if (txn == NULL)
+			rc = -1;
+		else
+			rc = applier_tx_execute(applier, tx, 0);
+	} else {
+		applier->barrier_seq = seq + 1;
+	}
+	applier_wait_commit_seq(applier, seq);
+
+	struct replica *replica = replica_by_id(first->replica_id);
+	locks.order_latch = (replica ? &replica->order_latch :
+			     &replicaset.applier.order_latch);
+	/*
+	 * In a full mesh topology, the same set of changes may
+	 * arrive via two concurrently running appliers. The
+	 * latch makes sure only one of them is applied.
+	 */
+	latch_lock(locks.order_latch);
+	int64_t vclock_lsn = vclock_get(&replicaset.vclock, first->replica_id);
+	if (vclock_lsn >= last->lsn) {
+		if (txn != NULL)
+			txn_rollback();
+		diag_clear(diag_get());
+		applier_apply_locks_release(&locks);
+		return 0;
+	}
+	if (txn != NULL && vclock_lsn >= first->lsn) {
+		/*
+		 * The transaction has been partially applied
+		 * via another applier while its rows were
+		 * executed out of order, re-execute the rest.
+		 */
+		txn_rollback();
+		diag_clear(diag_get());
+		txn = NULL;
+		rc = 0;
+	}
+	/**
+	 * Promote the replica set vclock before applying the
+	 * transaction. If there is an exception (conflict)
+	 * applying it, the transaction is skipped when the
+	 * replication is resumed.
+	 */
+	vclock_follow(&replicaset.vclock, first->replica_id, last->lsn);
+	if (txn == NULL && tx->row_count == 1) {
+		trigger_add(&fiber()->on_yield, &locks.on_yield);
+		rc = xstream_write(applier->subscribe_stream, first);
+	} else if (txn == NULL) {
+		txn = txn_begin(false);
+		if (txn == NULL) {
+			rc = -1;
+		} else {
+			rc = applier_tx_execute(applier, tx, vclock_lsn);
+			if (rc == 0) {
+				trigger_add(&fiber()->on_yield,
+					    &locks.on_yield);
+				rc = txn_commit(txn);
+			} else {
+				txn_rollback();
+			}
+		}
+	} else if (rc == 0) {
+		trigger_add(&fiber()->on_yield, &locks.on_yield);
+		rc = txn_commit(txn);
+	} else {
+		txn_rollback();
+	}
+	if (rc != 0) {
+		struct error *e = diag_last_error(diag_get());
+		/**
+		 * Silently skip ER_TUPLE_FOUND error if such
+		 * option is set in config.
+		 */
+		if (e->type == &type_ClientError &&
+		    box_error_code(e) == ER_TUPLE_FOUND &&
+		    replication_skip_conflict) {
+			diag_clear(diag_get());
+			rc = 0;
+		} else if (diag_is_empty(&applier->diag)) {
+			diag_move(diag_get(), &applier->diag);
+		}
+	}
+	/*
+	 * Not released on yield if the transaction was not
+	 * written to WAL.
+	 */
+	if (!locks.is_released)
+		applier_apply_locks_release(&locks);
+	return rc;
+}
+
+/**
+ * Worker fiber function. Workers take transactions from the
+ * queue in turn and apply them. On error, the worker stores the error
+ * in the applier for the reader to raise it and stops, all
+ * other workers stop taking rows.
+ */
+static int
+applier_worker_f(va_list ap)
+{
+	struct applier *applier = va_arg(ap, struct applier *);
+	/*
+	 * Set correct session type for use in on_replace()
+	 * triggers.
+	 */
+	current_session()->type = SESSION_TYPE_APPLIER;
+
+	while (true) {
+		while (stailq_empty(&applier->queue) &&
+		       diag_is_empty(&applier->diag) &&
+		       !fiber_is_cancelled())
+			fiber_cond_wait(&applier->queue_cond);
+		if (!diag_is_empty(&applier->diag) || fiber_is_cancelled())
+			break;
+		struct applier_tx *tx =
+			stailq_shift_entry(&applier->queue,
+					   struct applier_tx, in_queue);
+		stailq_add_tail_entry(&applier->in_flight, tx, in_queue);
+		int row_count = tx->row_count;
+		applier->queue_len -= row_count;
+		fiber_cond_broadcast(&applier->queue_cond);
+		int rc = applier_apply_tx(applier, tx);
+		applier_tx_done(applier, tx);
+		if (rc != 0) {
+			diag_clear(diag_get());
+			fiber_cond_broadcast(&applier->queue_cond);
+			break;
+		}
+		rmean_collect(applier->rmean, APPLIER_STAT_APPLY, row_count);
+		fiber_gc();
+	}
+	return 0;
+}
+
+static void
+applier_start_workers(struct applier *applier)
+{
+	char name[FIBER_NAME_MAX];
+	int pos = snprintf(name, sizeof(name), "applierp/");
+	uri_format(name + pos, sizeof(name) - pos, &applier->uri, false);
+
+	applier->is_parallel = replication_parallel_apply;
+	for (int i = 0; i < APPLIER_WORKER_COUNT; i++) {
+		assert(applier->workers[i] == NULL);
+		struct fiber *f = fiber_new_xc(name, applier_worker_f);
+		fiber_set_joinable(f, true);
+		applier->workers[i] = f;
+		fiber_start(f, applier);
+	}
+}
+
+/**
+ * Stop workers, waiting for WAL writes in progress, and drop
+ * rows which have not been applied. The rows are re-sent by
+ * the master on the next SUBSCRIBE since the replica set
+ * vclock has not been promoted for them.
+ */
+static void
+applier_stop_workers(struct applier *applier)
+{
+	for (int i = 0; i < APPLIER_WORKER_COUNT; i++) {
+		if (applier->workers[i] != NULL)
+			fiber_cancel(applier->workers[i]);
+	}
+	for (int i = 0; i < APPLIER_WORKER_COUNT; i++) {
+		if (applier->workers[i] == NULL)
+			continue;
+		fiber_join(applier->workers[i]);
+		applier->workers[i] = NULL;
+	}
+	struct applier_tx *tx, *next;
+	stailq_foreach_entry_safe(tx, next, &applier->queue, in_queue)
+		applier_tx_delete(tx);
+	stailq_create(&applier->queue);
+	stailq_foreach_entry_safe(tx, next, &applier->in_flight, in_queue)
+		applier_tx_delete(tx);
+	stailq_create(&applier->in_flight);
+	if (applier->tx != NULL) {
+		applier_tx_delete(applier->tx);
+		applier->tx = NULL;
+	}
+	applier->queue_len = 0;
+	applier->next_seq = 0;
+	applier->commit_seq = 0;
+	applier->barrier_seq = 0;
+	diag_clear(&applier->diag);
+}
+
+/** Raise the error a worker failed with, if any. */
+static inline void
+applier_check_workers(struct applier *applier)
+{
+	if (!diag_is_empty(&applier->diag)) {
+		diag_move(&applier->diag, diag_get());
+		diag_raise();
+	}
+}
+
+/**
+ * Queue the transaction being received for workers, waiting
+ * for room in the queue.
+ */
+static void
+applier_queue_tx(struct applier *applier)
+{
+	if (applier->tx == NULL)
+		return;
+	while (applier->queue_len >= APPLIER_QUEUE_MAX &&
+	       diag_is_empty(&applier->diag)) {
+		fiber_cond_wait(&applier->queue_cond);
+		fiber_testcancel();
+	}
+	applier_check_workers(applier);
+	struct applier_tx *tx = applier->tx;
+	applier->tx = NULL;
+	stailq_add_tail_entry(&applier->queue, tx, in_queue);
+	applier->queue_len += tx->row_count;
+	fiber_cond_broadcast(&applier->queue_cond);
+}
+
+/** Append a row to the transaction being received. */
+static void
+applier_add_row(struct applier *applier, struct xrow_header *row)
+{
+	struct applier_tx *tx = applier->tx;
+	if (tx != NULL) {
+		struct xrow_header *first =
+			&stailq_first_entry(&tx->rows, struct applier_row,
+					    in_tx)->row;
+		if (first->replica_id != row->replica_id ||
+		    first->tsn != row->tsn) {
+			/*
+			 * Rows of another transaction before the
+			 * commit row: the master must have failed
+			 * while writing the transaction. Apply the
+			 * rows received so far as is.
+			 */
+			say_warn("transaction %lld of replica %u "
+				 "is incomplete, applying its rows as is",
+				 (long long) first->tsn,
+				 (unsigned) first->replica_id);
+			applier_queue_tx(applier);
+			tx = NULL;
+		}
+	}
+	if (tx == NULL) {
+		tx = (struct applier_tx *) malloc(sizeof(*tx));
+		if (tx == NULL) {
+			tnt_raise(OutOfMemory, sizeof(*tx), "malloc",
+				  "struct applier_tx");
+		}
+		stailq_create(&tx->rows);
+		tx->row_count = 0;
+		tx->is_done = false;
+		applier->tx = tx;
+	}
+	assert(row->bodycnt <= 1);
+	size_t len = row->bodycnt > 0 ? row->body[0].iov_len : 0;
+	size_t size = sizeof(struct applier_row) + len;
+	struct applier_row *item = (struct applier_row *) malloc(size);
+	if (item == NULL)
+		tnt_raise(OutOfMemory, size, "malloc", "struct applier_row");
+	item->row = *row;
+	if (row->bodycnt > 0) {
+		memcpy(item->data, row->body[0].iov_base, len);
+		item->row.body[0].iov_base = item->data;
+	}
+	stailq_add_tail_entry(&tx->rows, item, in_tx);
+	tx->row_count++;
+}
+
+/* }}} */
+
 /**
  * Execute and process SUBSCRIBE request (follow updates from a master).
  */
@@ -371,12 +1248,13 @@ applier_subscribe(struct applier *applier)
 	/* Send SUBSCRIBE request */
 	struct ev_io *coio = &applier->io;
 	struct ibuf *ibuf = &applier->ibuf;
+	struct xrow_zstd *zstd = applier_zstd(applier);
 	struct xrow_header row;
 	struct vclock remote_vclock_at_subscribe;
 
 	xrow_encode_subscribe_xc(&row, &REPLICASET_UUID, &INSTANCE_UUID,
 				 &replicaset.vclock);
-	coio_write_xrow(coio, &row);
+	coio_write_xrow(coio, zstd, &row);
 
 	if (applier->state == APPLIER_READY) {
 		/*
@@ -403,7 +1281,7 @@ applier_subscribe(struct applier *applier)
 	 * Read SUBSCRIBE response
 	 */
 	if (applier->version_id >= version_id(1, 6, 7)) {
-		coio_read_xrow(coio, ibuf, &row);
+		coio_read_xrow(coio, zstd, ibuf, &row);
 		if (iproto_type_is_error(row.type)) {
 			xrow_decode_error_xc(&row);  /* error */
 		} else if (row.type != IPROTO_OK) {
@@ -427,6 +1305,8 @@ applier_subscribe(struct applier *applier)
 
 	/* Re-enable warnings after successful execution of SUBSCRIBE */
 	applier->last_logged_errcode = 0;
+	vclock_create(&applier->durable_vclock);
+	applier_update_durable_vclock(applier);
 	if (applier->version_id >= version_id(1, 7, 4)) {
 		/* Enable replication ACKs for newer servers */
 		assert(applier->writer == NULL);
@@ -439,6 +1319,7 @@ applier_subscribe(struct applier *applier)
 		fiber_set_joinable(applier->writer, true);
 		fiber_start(applier->writer, applier);
 	}
+	applier_start_workers(applier);
 
 	applier->lag = TIMEOUT_INFINITY;
 
@@ -474,14 +1355,16 @@ applier_subscribe(struct applier *applier)
 		 * broken - the master might just be idle.
 		 */
 		if (applier->version_id < version_id(1, 7, 7)) {
-			coio_read_xrow(coio, ibuf, &row);
+			coio_read_xrow(coio, zstd, ibuf, &row);
 		} else {
 			double timeout = replication_disconnect_timeout();
-			coio_read_xrow_timeout_xc(coio, ibuf, &row, timeout);
+			coio_read_xrow_timeout_xc(coio, zstd, ibuf, &row,
+						  timeout);
 		}
 
 		if (iproto_type_is_error(row.type))
 			xrow_decode_error_xc(&row);  /* error */
+		applier_check_workers(applier);
 		/* Replication request. */
 		if (row.replica_id == REPLICA_ID_NIL ||
 		    row.replica_id >= VCLOCK_MAX) {
@@ -497,48 +1380,18 @@ applier_subscribe(struct applier *applier)
 		applier->lag = ev_now(loop()) - row.tm;
 		applier->last_row_time = ev_monotonic_now(loop());
 
-		if (vclock_get(&replicaset.vclock, row.replica_id) < row.lsn) {
-			/**
-			 * Promote the replica set vclock before
-			 * applying the row. If there is an
-			 * exception (conflict) applying the row,
-			 * the row is skipped when the replication
-			 * is resumed.
-			 */
-			vclock_follow(&replicaset.vclock, row.replica_id,
-				      row.lsn);
-			struct replica *replica = replica_by_id(row.replica_id);
-			struct latch *latch = (replica ? &replica->order_latch :
-					       &replicaset.applier.order_latch);
-			/*
-			 * In a full mesh topology, the same set
-			 * of changes may arrive via two
-			 * concurrently running appliers. Thanks
-			 * to vclock_follow() above, the first row
-			 * in the set will be skipped - but the
-			 * remaining may execute out of order,
-			 * when the following xstream_write()
-			 * yields on WAL. Hence we need a latch to
-			 * strictly order all changes which belong
-			 * to the same server id.
-			 */
-			latch_lock(latch);
-			int res = xstream_write(applier->subscribe_stream, &row);
-			latch_unlock(latch);
-			if (res != 0) {
-				struct error *e = diag_last_error(diag_get());
-				/**
-				 * Silently skip ER_TUPLE_FOUND error if such
-				 * option is set in config.
-				 */
-				if (e->type == &type_ClientError &&
-				    box_error_code(e) == ER_TUPLE_FOUND &&
-				    replication_skip_conflict)
-					diag_clear(diag_get());
-				else
-					diag_raise();
-			}
-		}
+		/*
+		 * Rows are grouped into transactions applied by
+		 * workers, see applier_apply_tx(). Rows which
+		 * have already been applied are filtered out here
+		 * to save a copy, the final check is done by the
+		 * worker.
+		 */
+		if (vclock_get(&replicaset.vclock, row.replica_id) < row.lsn)
+			applier_add_row(applier, &row);
+		/* Heartbeats may come between rows of a transaction. */
+		if (row.is_commit && iproto_type_is_dml(row.type))
+			applier_queue_tx(applier);
 		if (applier->state == APPLIER_SYNC ||
 		    applier->state == APPLIER_FOLLOW)
 			fiber_cond_signal(&applier->writer_cond);
@@ -557,10 +1410,12 @@ applier_disconnect(struct applier *applier, enum applier_state state)
 		fiber_join(applier->writer);
 		applier->writer = NULL;
 	}
+	applier_stop_workers(applier);
 
 	coio_close(loop(), &applier->io);
 	/* Clear all unparsed input. */
 	ibuf_reinit(&applier->ibuf);
+	xrow_zstd_stop(&applier->zstd);
 	fiber_gc();
 }
 
@@ -703,6 +1558,7 @@ applier_new(const char *uri, struct xstream *join_stream,
 	}
 	coio_create(&applier->io, -1);
 	ibuf_create(&applier->ibuf, &cord()->slabc, 1024);
+	xrow_zstd_create(&applier->zstd, NULL, NULL);
 
 	/* uri_parse() sets pointers to applier->source buffer */
 	snprintf(applier->source, sizeof(applier->source), "%s", uri);
@@ -717,6 +1573,22 @@ applier_new(const char *uri, struct xstream *join_stream,
 	rlist_create(&applier->on_state);
 	fiber_cond_create(&applier->resume_cond);
 	fiber_cond_create(&applier->writer_cond);
+	stailq_create(&applier->queue);
+	stailq_create(&applier->in_flight);
+	fiber_cond_create(&applier->queue_cond);
+	fiber_cond_create(&applier->commit_cond);
+	for (int i = 0; i < APPLIER_PARTITION_COUNT; i++)
+		latch_create(&applier->partitions[i]);
+	diag_create(&applier->diag);
+	applier->rmean = rmean_new(applier_stat_strs, applier_stat_MAX);
+	if (applier->rmean == NULL) {
+		ibuf_destroy(&applier->ibuf);
+		xrow_zstd_destroy(&applier->zstd);
+		free(applier);
+		diag_set(OutOfMemory, sizeof(struct rmean), "rmean_new",
+			 "struct rmean");
+		return NULL;
+	}
 
 	return applier;
 }
@@ -726,10 +1598,19 @@ applier_delete(struct applier *applier)
 {
 	assert(applier->reader == NULL && applier->writer == NULL);
 	ibuf_destroy(&applier->ibuf);
+	xrow_zstd_destroy(&applier->zstd);
 	assert(applier->io.fd == -1);
 	trigger_destroy(&applier->on_state);
 	fiber_cond_destroy(&applier->resume_cond);
 	fiber_cond_destroy(&applier->writer_cond);
+	assert(stailq_empty(&applier->queue));
+	assert(stailq_empty(&applier->in_flight));
+	fiber_cond_destroy(&applier->queue_cond);
+	fiber_cond_destroy(&applier->commit_cond);
+	for (int i = 0; i < APPLIER_PARTITION_COUNT; i++)
+		latch_destroy(&applier->partitions[i]);
+	diag_destroy(&applier->diag);
+	rmean_delete(applier->rmean);
 	free(applier);
 }
 
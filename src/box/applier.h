@@ -37,18 +37,49 @@
 
 #include <small/ibuf.h>
 
+#include "diag.h"
 #include "fiber_cond.h"
+#include "latch.h"
+#include "salad/stailq.h"
 #include "trigger.h"
 #include "trivia/util.h"
 #include "tt_uuid.h"
 #include "uri.h"
 
 #include "vclock.h"
+#include "xrow_io.h"
 
 struct xstream;
+struct rmean;
+struct applier_tx;
 
 enum { APPLIER_SOURCE_MAXLEN = 1024 }; /* enough to fit URI with passwords */
 
+enum {
+	/**
+	 * Max number of rows received from the master and
+	 * waiting to be applied. The applier stops reading
+	 * when the queue is full.
+	 */
+	APPLIER_QUEUE_MAX = 4096,
+	/**
+	 * Number of fibers applying rows, i.e. max number of
+	 * rows which WAL writes are in progress at a time.
+	 */
+	APPLIER_WORKER_COUNT = 16,
+	/**
+	 * Number of partitions of spaces which rows can be
+	 * executed concurrently in the parallel mode.
+	 */
+	APPLIER_PARTITION_COUNT = 16,
+};
+
+/** Applier statistics, @sa applier::rmean. */
+enum applier_stat {
+	APPLIER_STAT_APPLY,
+	applier_stat_MAX,
+};
+
 #define applier_STATE(_)                                             \
 	_(APPLIER_OFF, 0)                                            \
 	_(APPLIER_CONNECT, 1)                                        \
@@ -109,6 +140,12 @@ struct applier {
 	struct ev_io io;
 	/** Input buffer */
 	struct ibuf ibuf;
+	/**
+	 * Compression state of the connection, the contexts
+	 * are NULL unless replication_compression is set and
+	 * the master has accepted it.
+	 */
+	struct xrow_zstd zstd;
 	/** Triggers invoked on state change */
 	struct rlist on_state;
 	/**
@@ -122,6 +159,67 @@ struct applier {
 	struct xstream *join_stream;
 	/** xstream to process rows during final JOIN and SUBSCRIBE */
 	struct xstream *subscribe_stream;
+	/**
+	 * Fibers applying rows received on SUBSCRIBE. While the
+	 * WAL write of a row is in progress, the next worker
+	 * applies the next row, so that WAL writes of many rows
+	 * are in flight and get batched by the WAL thread.
+	 */
+	struct fiber *workers[APPLIER_WORKER_COUNT];
+	/**
+	 * Transactions received from the master, not applied
+	 * yet. A transaction is queued once its commit row is
+	 * received.
+	 */
+	struct stailq queue;
+	/** Number of rows in the queue. */
+	int queue_len;
+	/**
+	 * Transactions taken from the queue by workers, in
+	 * the order they were taken. A transaction is removed
+	 * once it and all transactions before it are applied.
+	 */
+	struct stailq in_flight;
+	/**
+	 * Vclock of rows received from the master and written
+	 * to WAL of this replica, sent to the master in ACKs.
+	 * Unlike the replica set vclock, which is promoted
+	 * before a transaction is written, it never covers a
+	 * transaction which WAL write is in progress nor any
+	 * transaction after it.
+	 */
+	struct vclock durable_vclock;
+	/** Transaction being received, not queued yet. */
+	struct applier_tx *tx;
+	/** Signaled when the queue or error state changes. */
+	struct fiber_cond queue_cond;
+	/**
+	 * Sequence number of the next row taken from the queue.
+	 * Rows are submitted to WAL in the order of their
+	 * sequence numbers, @sa applier_apply_tx().
+	 */
+	uint64_t next_seq;
+	/** Sequence number of the next row to submit to WAL. */
+	uint64_t commit_seq;
+	/** Signaled when commit_seq is advanced. */
+	struct fiber_cond commit_cond;
+	/**
+	 * Rows with sequence numbers less than this one must
+	 * be in WAL before a row is executed out of order.
+	 */
+	uint64_t barrier_seq;
+	/**
+	 * Held by a worker executing a row out of order till
+	 * the row is submitted to WAL, so that rows of the same
+	 * partition are executed in the order they were received.
+	 */
+	struct latch partitions[APPLIER_PARTITION_COUNT];
+	/** Copy of replication_parallel_apply taken on SUBSCRIBE. */
+	bool is_parallel;
+	/** Error a worker failed with, re-raised by the reader. */
+	struct diag diag;
+	/** Rate of applied rows. */
+	struct rmean *rmean;
 };
 
 /**
@@ -46,6 +46,7 @@
 #include <rmean.h>
 #include "main.h"
 #include "tuple.h"
+#include "tuple_filter.h"
 #include "session.h"
 #include "schema.h"
 #include "engine.h"
@@ -160,6 +161,119 @@ box_check_memtx_min_tuple_size(ssize_t memtx_min_tuple_size)
 		  "specified value is out of bounds");
 }
 
+static double
+box_check_memtx_defrag_threshold(void)
+{
+	double threshold = cfg_getd("memtx_defrag_threshold");
+	if (threshold < 0 || threshold >= 1) {
+		tnt_raise(ClientError, ER_CFG, "memtx_defrag_threshold",
+			  "the value must be >= 0 and < 1");
+	}
+	return threshold;
+}
+
+static double
+box_check_memtx_tree_fill_factor(void)
+{
+	double fill_factor = cfg_getd("memtx_tree_fill_factor");
+	if (fill_factor <= 0 || fill_factor > 1) {
+		tnt_raise(ClientError, ER_CFG, "memtx_tree_fill_factor",
+			  "the value must be > 0 and <= 1");
+	}
+	return fill_factor;
+}
+
+static uint32_t
+box_check_memtx_expire_batch_size(void)
+{
+	int64_t batch_size = cfg_geti64("memtx_expire_batch_size");
+	if (batch_size <= 0 || batch_size > UINT32_MAX) {
+		tnt_raise(ClientError, ER_CFG, "memtx_expire_batch_size",
+			  "the value must be > 0 and fit in uint32_t");
+	}
+	return batch_size;
+}
+
+static double
+box_check_memtx_expire_rate(void)
+{
+	double rate = cfg_getd("memtx_expire_rate");
+	if (rate < 0) {
+		tnt_raise(ClientError, ER_CFG, "memtx_expire_rate",
+			  "the value must be >= 0");
+	}
+	return rate;
+}
+
+static int
+box_check_net_cursor_max(void)
+{
+	int cursor_max = cfg_geti("net_cursor_max");
+	if (cursor_max < 0) {
+		tnt_raise(ClientError, ER_CFG, "net_cursor_max",
+			  "the value must be >= 0");
+	}
+	return cursor_max;
+}
+
+static double
+box_check_net_cursor_timeout(void)
+{
+	double timeout = cfg_getd("net_cursor_timeout");
+	if (timeout <= 0) {
+		tnt_raise(ClientError, ER_CFG, "net_cursor_timeout",
+			  "the value must be > 0");
+	}
+	return timeout;
+}
+
+static size_t
+box_check_net_cursor_memory(void)
+{
+	int64_t memory = cfg_geti64("net_cursor_memory");
+	if (memory < 0) {
+		tnt_raise(ClientError, ER_CFG, "net_cursor_memory",
+			  "the value must be >= 0");
+	}
+	return memory;
+}
+
+static void
+box_check_memtx_arena_opts(struct tuple_arena_opts *opts)
+{
+	const char *huge_pages = cfg_gets("memtx_huge_pages");
+	int mode = strindex(tuple_arena_huge_pages_strs, huge_pages,
+			    tuple_arena_huge_pages_MAX);
+	if (mode == tuple_arena_huge_pages_MAX) {
+		tnt_raise(ClientError, ER_CFG, "memtx_huge_pages",
+			  "expected 'none', 'thp' or 'hugetlb'");
+	}
+	opts->huge_pages = (enum tuple_arena_huge_pages) mode;
+
+	const char *policy = cfg_gets("memtx_numa_policy");
+	int numa_policy = strindex(tuple_arena_numa_policy_strs, policy,
+				   tuple_arena_numa_policy_MAX);
+	if (numa_policy == tuple_arena_numa_policy_MAX) {
+		tnt_raise(ClientError, ER_CFG, "memtx_numa_policy",
+			  "expected 'default', 'interleave' or 'bind'");
+	}
+	opts->numa_policy = (enum tuple_arena_numa_policy) numa_policy;
+
+	const char *nodes = cfg_gets("memtx_numa_nodes");
+	opts->numa_nodes = 0;
+	if (nodes != NULL &&
+	    tuple_arena_parse_numa_nodes(nodes, &opts->numa_nodes) != 0) {
+		tnt_raise(ClientError, ER_CFG, "memtx_numa_nodes",
+			  "expected a list of node numbers below 64, "
+			  "e.g. '0,2-3'");
+	}
+	if (opts->numa_policy == TUPLE_ARENA_NUMA_BIND &&
+	    opts->numa_nodes == 0) {
+		tnt_raise(ClientError, ER_CFG, "memtx_numa_nodes",
+			  "the nodes must be set for the 'bind' policy");
+	}
+}
+
 int
 box_process_rw(struct request *request, struct space *space,
 	       struct tuple **result)
@@ -185,7 +299,7 @@ box_process_rw(struct request *request, struct space *space,
 	if (txn_commit_stmt(txn, request) != 0)
 		return -1;
 	if (result != NULL) {
-		if (tuple != NULL && tuple_bless(tuple) == NULL)
+		if (tuple != NULL && (tuple = tuple_bless(tuple)) == NULL)
 			return -1;
 		*result = tuple;
 	}
@@ -521,6 +635,17 @@ box_check_wal_max_size(int64_t wal_max_size)
 	return wal_max_size;
 }
 
+static size_t
+box_check_wal_ring_size(void)
+{
+	int64_t size = cfg_geti64("wal_ring_size");
+	if (size < 0) {
+		tnt_raise(ClientError, ER_CFG, "wal_ring_size",
+			  "the value must be >= 0");
+	}
+	return size;
+}
+
 static void
 box_check_vinyl_options(void)
 {
@@ -580,9 +705,19 @@ box_check_config()
 	box_check_checkpoint_count(cfg_geti("checkpoint_count"));
 	box_check_wal_max_rows(cfg_geti64("rows_per_wal"));
 	box_check_wal_max_size(cfg_geti64("wal_max_size"));
+	box_check_wal_ring_size();
 	box_check_wal_mode(cfg_gets("wal_mode"));
 	box_check_memtx_min_tuple_size(cfg_geti64("memtx_min_tuple_size"));
+	box_check_memtx_defrag_threshold();
+	box_check_memtx_tree_fill_factor();
+	box_check_memtx_expire_batch_size();
+	box_check_memtx_expire_rate();
+	struct tuple_arena_opts arena_opts;
+	box_check_memtx_arena_opts(&arena_opts);
 	box_check_vinyl_options();
+	box_check_net_cursor_max();
+	box_check_net_cursor_timeout();
+	box_check_net_cursor_memory();
 }
 
 /*
@@ -687,6 +822,12 @@ box_set_replication_skip_conflict(void)
 	replication_skip_conflict = cfg_geti("replication_skip_conflict");
 }
 
+void
+box_set_replication_parallel_apply(void)
+{
+	replication_parallel_apply = cfg_geti("replication_parallel_apply");
+}
+
 void
 box_bind(void)
 {
@@ -740,6 +881,46 @@ box_set_memtx_max_tuple_size(void)
 			cfg_geti("memtx_max_tuple_size"));
 }
 
+void
+box_set_memtx_defrag_threshold(void)
+{
+	double threshold = box_check_memtx_defrag_threshold();
+	struct memtx_engine *memtx;
+	memtx = (struct memtx_engine *)engine_by_name("memtx");
+	assert(memtx != NULL);
+	memtx_defrag_set_threshold(&memtx->defrag, threshold);
+}
+
+void
+box_set_memtx_tree_fill_factor(void)
+{
+	double fill_factor = box_check_memtx_tree_fill_factor();
+	struct memtx_engine *memtx;
+	memtx = (struct memtx_engine *)engine_by_name("memtx");
+	assert(memtx != NULL);
+	memtx_engine_set_tree_fill_factor(memtx, fill_factor);
+}
+
+void
+box_set_memtx_expire_batch_size(void)
+{
+	uint32_t batch_size = box_check_memtx_expire_batch_size();
+	struct memtx_engine *memtx;
+	memtx = (struct memtx_engine *)engine_by_name("memtx");
+	assert(memtx != NULL);
+	memtx_expire_set_batch_size(&memtx->expire, batch_size);
+}
+
+void
+box_set_memtx_expire_rate(void)
+{
+	double rate = box_check_memtx_expire_rate();
+	struct memtx_engine *memtx;
+	memtx = (struct memtx_engine *)engine_by_name("memtx");
+	assert(memtx != NULL);
+	memtx_expire_set_rate(&memtx->expire, rate);
+}
+
 void
 box_set_too_long_threshold(void)
 {
@@ -805,6 +986,30 @@ box_set_net_msg_max(void)
 				IPROTO_FIBER_POOL_SIZE_FACTOR);
 }
 
+void
+box_set_net_cursor_max(void)
+{
+	iproto_set_cursor_max(box_check_net_cursor_max());
+}
+
+void
+box_set_net_cursor_timeout(void)
+{
+	iproto_set_cursor_timeout(box_check_net_cursor_timeout());
+}
+
+void
+box_set_net_cursor_memory(void)
+{
+	iproto_set_cursor_memory(box_check_net_cursor_memory());
+}
+
+void
+box_set_wal_ring_size(void)
+{
+	wal_set_ring_size(box_check_wal_ring_size());
+}
+
 /* }}} configuration bindings */
 
 /**
@@ -945,6 +1150,7 @@ int
 box_select(uint32_t space_id, uint32_t index_id,
 	   int iterator, uint32_t offset, uint32_t limit,
 	   const char *key, const char *key_end,
+	   const struct tuple_filter *filter, bool is_cover,
 	   struct port *port)
 {
 	(void)key_end;
@@ -981,8 +1187,9 @@ box_select(uint32_t space_id, uint32_t index_id,
 	if (txn_begin_ro_stmt(space, &txn) != 0)
 		return -1;
 
-	struct iterator *it = index_create_iterator(index, type,
-						    key, part_count);
+	struct iterator *it = is_cover ?
+		index_create_cover_iterator(index, type, key, part_count) :
+		index_create_iterator(index, type, key, part_count);
 	if (it == NULL) {
 		txn_rollback_stmt();
 		return -1;
@@ -996,6 +1203,24 @@ box_select(uint32_t space_id, uint32_t index_id,
 		rc = iterator_next(it, &tuple);
 		if (rc != 0 || tuple == NULL)
 			break;
+		if (filter != NULL) {
+			/*
+			 * The filter may check any field, while a
+			 * packed tuple keeps only the indexed ones
+			 * plain. The plain copy isn't referenced, so
+			 * drop it once checked: the port makes its own.
+			 */
+			struct tuple *plain = tuple_unpack(tuple);
+			if (plain == NULL) {
+				rc = -1;
+				break;
+			}
+			bool is_match = tuple_filter_match(filter, plain);
+			if (plain != tuple)
+				tuple_delete(plain);
+			if (!is_match)
+				continue;
+		}
 		if (offset > 0) {
 			offset--;
 			continue;
@@ -1292,8 +1517,35 @@ box_process_auth(struct auth_request *request)
 	authenticate(user, len, request->scramble);
 }
 
+/**
+ * A JOIN which initial data is partitioned among several
+ * streams. Registered for the duration of the JOIN, so that
+ * box_process_join_stream() can check streams against it.
+ */
+struct box_join {
+	/** UUID of the joining replica. */
+	struct tt_uuid instance_uuid;
+	/** Vclock of the checkpoint sent to the replica. */
+	struct vclock vclock;
+	/** Number of streams, including the JOIN itself. */
+	uint32_t stream_count;
+	/**
+	 * Bit i is set once stream i has been opened. Stream ids
+	 * are less than REPLICATION_JOIN_STREAMS_MAX.
+	 */
+	uint32_t opened_streams;
+	/** Signaled when a stream is opened. */
+	struct fiber_cond cond;
+	/** Link in box_joins. */
+	struct rlist in_joins;
+};
+
+/** JOINs waiting for their streams, linked by in_joins. */
+static RLIST_HEAD(box_joins);
+
 void
-box_process_join(struct ev_io *io, struct xrow_header *header)
+box_process_join(struct ev_io *io, struct xrow_zstd *zstd,
+		 struct xrow_header *header)
 {
 	/*
 	 * Tarantool 1.7 JOIN protocol diagram (gh-1113)
@@ -1301,10 +1553,24 @@ box_process_join(struct ev_io *io, struct xrow_header *header)
 	 *
 	 * Replica => Master
 	 *
-	 * => JOIN { INSTANCE_UUID: replica_uuid }
-	 * <= OK { VCLOCK: start_vclock }
+	 * => JOIN { INSTANCE_UUID: replica_uuid, JOIN_STREAM_COUNT: count }
+	 * <= OK { VCLOCK: start_vclock, JOIN_STREAM_COUNT: count }
 	 *    Replica has enough permissions and master is ready for JOIN.
 	 *     - start_vclock - vclock of the latest master's checkpoint.
+	 *     - count - number of streams initial data is split into,
+	 *     omitted if 1. If count > 1, only system spaces and user
+	 *     spaces with space_id % count == 0 are sent below, the
+	 *     rest is fetched with JOIN_STREAM, see
+	 *     box_process_join_stream().
+	 *
+	 * If JOIN has JOIN_FILES: true, the response has it too and
+	 * the memtx snapshot is sent as is, in JOIN_FILE chunks,
+	 * instead of the rows it contains. JOIN_STREAM_COUNT is 1
+	 * in this case.
+	 *
+	 * <= JOIN_FILE { DATA: chunk }
+	 *    ...
+	 * <= JOIN_FILE { DATA: chunk }
 	 *
 	 * <= INSERT
 	 *    ...
@@ -1340,7 +1606,14 @@ box_process_join(struct ev_io *io, struct xrow_header *header)
 
 	/* Decode JOIN request */
 	struct tt_uuid instance_uuid = uuid_nil;
-	xrow_decode_join_xc(header, &instance_uuid);
+	uint32_t stream_count = 1;
+	bool join_files = false;
+	xrow_decode_join_xc(header, &instance_uuid, &stream_count,
+			    &join_files);
+	stream_count = MAX(stream_count, 1);
+	stream_count = MIN(stream_count, REPLICATION_JOIN_STREAMS_MAX);
+	if (join_files)
+		stream_count = 1;
 
 	/* Check that bootstrap has been finished */
 	if (!is_box_configured)
@@ -1393,18 +1666,56 @@ box_process_join(struct ev_io *io, struct xrow_header *header)
 		gc_consumer_unregister(gc);
 	});
 
+	struct box_join join;
+	join.instance_uuid = instance_uuid;
+	vclock_copy(&join.vclock, &start_vclock);
+	join.stream_count = stream_count;
+	join.opened_streams = 1;
+	fiber_cond_create(&join.cond);
+	if (stream_count > 1)
+		rlist_add_entry(&box_joins, &join, in_joins);
+	auto join_guard = make_scoped_guard([&]{
+		if (stream_count > 1)
+			rlist_del_entry(&join, in_joins);
+		fiber_cond_destroy(&join.cond);
+	});
+
 	/* Respond to JOIN request with start_vclock. */
 	struct xrow_header row;
-	xrow_encode_vclock_xc(&row, &start_vclock);
+	xrow_encode_join_response_xc(&row, &start_vclock, stream_count,
+				     join_files);
 	row.sync = header->sync;
-	coio_write_xrow(io, &row);
+	coio_write_xrow(io, zstd, &row);
 
 	/*
 	 * Initial stream: feed replica with dirty data from engines.
+	 * The checkpoint is pinned by the gc consumer registered
+	 * above until the replica is done with other streams, because
+	 * it doesn't proceed to the final stage before that.
 	 */
-	relay_initial_join(io->fd, header->sync, &start_vclock);
+	if (join_files) {
+		relay_initial_join_files(io->fd, zstd, header->sync,
+					 &start_vclock);
+	} else {
+		relay_initial_join(io->fd, zstd, header->sync,
+				   &start_vclock, 0, stream_count);
+	}
 	say_info("initial data sent.");
 
+	/*
+	 * The replica opens other streams once it has applied
+	 * system spaces, long before the end of this one. Each of
+	 * them pins the checkpoint with a gc consumer of its own.
+	 */
+	uint32_t all_streams = stream_count == REPLICATION_JOIN_STREAMS_MAX ?
+			       UINT32_MAX : (1U << stream_count) - 1;
+	double deadline = ev_monotonic_now(loop()) +
+			  replication_connect_timeout;
+	while (join.opened_streams != all_streams) {
+		if (fiber_cond_wait_deadline(&join.cond, deadline) != 0)
+			diag_raise();
+	}
+
 	/**
 	 * Call the server-side hook which stores the replica uuid
 	 * in _cluster space after sending the last row but before
@@ -1425,13 +1736,14 @@ box_process_join(struct ev_io *io, struct xrow_header *header)
 	/* Send end of initial stage data marker */
 	xrow_encode_vclock_xc(&row, &stop_vclock);
 	row.sync = header->sync;
-	coio_write_xrow(io, &row);
+	coio_write_xrow(io, zstd, &row);
 
 	/*
 	 * Final stage: feed replica with WALs in range
 	 * (start_vclock, stop_vclock).
 	 */
-	relay_final_join(io->fd, header->sync, &start_vclock, &stop_vclock);
+	relay_final_join(io->fd, zstd, header->sync, &start_vclock,
+			 &stop_vclock);
 	say_info("final data sent.");
 
 	/* Send end of WAL stream marker */
@@ -1439,11 +1751,111 @@ box_process_join(struct ev_io *io, struct xrow_header *header)
 	wal_checkpoint(&current_vclock, false);
 	xrow_encode_vclock_xc(&row, &current_vclock);
 	row.sync = header->sync;
-	coio_write_xrow(io, &row);
+	coio_write_xrow(io, zstd, &row);
+}
+
+void
+box_process_join_stream(struct ev_io *io, struct xrow_zstd *zstd,
+			struct xrow_header *header)
+{
+	/*
+	 * => JOIN_STREAM { INSTANCE_UUID: replica_uuid,
+	 *                  VCLOCK: start_vclock,
+	 *                  JOIN_STREAM_ID: id, JOIN_STREAM_COUNT: count }
+	 * <= OK { VCLOCK: start_vclock }
+	 * <= INSERT
+	 *    ...
+	 *    Initial data of user spaces with space_id % count == id
+	 *    from the checkpoint at start_vclock, which must have
+	 *    been sent in response to JOIN.
+	 *    ...
+	 * <= INSERT
+	 * <= OK { VCLOCK: start_vclock } - end of the stream.
+	 */
+	assert(header->type == IPROTO_JOIN_STREAM);
+
+	struct tt_uuid instance_uuid = uuid_nil;
+	struct vclock start_vclock;
+	vclock_create(&start_vclock);
+	uint32_t stream_id, stream_count;
+	xrow_decode_join_stream_xc(header, &instance_uuid, &start_vclock,
+				   &stream_id, &stream_count);
+
+	/* Check that bootstrap has been finished */
+	if (!is_box_configured)
+		tnt_raise(ClientError, ER_LOADING);
+
+	/* Forbid connection to itself */
+	if (tt_uuid_is_equal(&instance_uuid, &INSTANCE_UUID))
+		tnt_raise(ClientError, ER_CONNECTION_TO_SELF);
+
+	/* Check permissions */
+	access_check_universe_xc(PRIV_R);
+
+	/* Forbid replication with disabled WAL */
+	if (wal_mode() == WAL_NONE) {
+		tnt_raise(ClientError, ER_UNSUPPORTED, "Replication",
+			  "wal_mode = 'none'");
+	}
+
+	if (stream_count > REPLICATION_JOIN_STREAMS_MAX ||
+	    stream_id == 0 || stream_id >= stream_count) {
+		tnt_raise(ClientError, ER_ILLEGAL_PARAMS,
+			  "invalid join stream id");
+	}
+
+	/* The stream must belong to a JOIN in progress. */
+	struct box_join *join = NULL, *j;
+	rlist_foreach_entry(j, &box_joins, in_joins) {
+		if (tt_uuid_is_equal(&j->instance_uuid, &instance_uuid)) {
+			join = j;
+			break;
+		}
+	}
+	if (join == NULL || join->stream_count != stream_count ||
+	    vclock_compare(&join->vclock, &start_vclock) != 0) {
+		tnt_raise(ClientError, ER_ILLEGAL_PARAMS,
+			  "join stream doesn't match any join in progress");
+	}
+	if ((join->opened_streams & (1U << stream_id)) != 0) {
+		tnt_raise(ClientError, ER_ILLEGAL_PARAMS,
+			  "join stream is already open");
+	}
+
+	/*
+	 * Pin the checkpoint until the stream is sent. The JOIN
+	 * keeps it pinned until the stream is registered.
+	 */
+	struct gc_consumer *gc = gc_consumer_register(
+		tt_sprintf("replica %s join stream %u",
+			   tt_uuid_str(&instance_uuid), (unsigned)stream_id),
+		vclock_sum(&start_vclock));
+	if (gc == NULL)
+		diag_raise();
+	auto gc_guard = make_scoped_guard([=]{
+		gc_consumer_unregister(gc);
+	});
+	join->opened_streams |= 1U << stream_id;
+	fiber_cond_signal(&join->cond);
+
+	struct xrow_header row;
+	xrow_encode_vclock_xc(&row, &start_vclock);
+	row.sync = header->sync;
+	coio_write_xrow(io, zstd, &row);
+
+	relay_initial_join(io->fd, zstd, header->sync, &start_vclock,
+			   stream_id, stream_count);
+	say_info("initial data stream %u sent.", (unsigned)stream_id);
+
+	/* Send end of stream marker */
+	xrow_encode_vclock_xc(&row, &start_vclock);
+	row.sync = header->sync;
+	coio_write_xrow(io, zstd, &row);
 }
 
 void
-box_process_subscribe(struct ev_io *io, struct xrow_header *header)
+box_process_subscribe(struct ev_io *io, struct xrow_zstd *zstd,
+		      struct xrow_header *header)
 {
 	assert(header->type == IPROTO_SUBSCRIBE);
 
@@ -1509,7 +1921,7 @@ box_process_subscribe(struct ev_io *io, struct xrow_header *header)
 	assert(self != NULL); /* the local registration is read-only */
 	row.replica_id = self->id;
 	row.sync = header->sync;
-	coio_write_xrow(io, &row);
+	coio_write_xrow(io, zstd, &row);
 
 	/*
 	 * Process SUBSCRIBE request via replication relay
@@ -1523,7 +1935,7 @@ box_process_subscribe(struct ev_io *io, struct xrow_header *header)
 	 * a stall in updates (in this case replica may hang
 	 * indefinitely).
 	 */
-	relay_subscribe(io->fd, header->sync, replica, &replica_clock,
+	relay_subscribe(io->fd, zstd, header->sync, replica, &replica_clock,
 			replica_version_id);
 }
 
@@ -1579,14 +1991,21 @@ engine_init()
 	 * in checkpoints (in enigne_foreach order),
 	 * so it must be registered first.
 	 */
+	struct tuple_arena_opts arena_opts;
+	box_check_memtx_arena_opts(&arena_opts);
 	struct memtx_engine *memtx;
 	memtx = memtx_engine_new_xc(cfg_gets("memtx_dir"),
 				    cfg_geti("force_recovery"),
 				    cfg_getd("memtx_memory"),
 				    cfg_geti("memtx_min_tuple_size"),
-				    cfg_getd("slab_alloc_factor"));
+				    cfg_getd("slab_alloc_factor"),
+				    &arena_opts);
 	engine_register((struct engine *)memtx);
 	box_set_memtx_max_tuple_size();
+	box_set_memtx_defrag_threshold();
+	box_set_memtx_tree_fill_factor();
+	box_set_memtx_expire_batch_size();
+	box_set_memtx_expire_rate();
 
 	struct sysview_engine *sysview = sysview_engine_new_xc();
 	engine_register((struct engine *)sysview);
@@ -1785,12 +2204,16 @@ box_cfg_xc(void)
 	box_check_replicaset_uuid(&replicaset_uuid);
 
 	box_set_net_msg_max();
+	box_set_net_cursor_max();
+	box_set_net_cursor_timeout();
+	box_set_net_cursor_memory();
 	box_set_checkpoint_count();
 	box_set_too_long_threshold();
 	box_set_replication_timeout();
 	box_set_replication_connect_timeout();
 	box_set_replication_connect_quorum();
 	box_set_replication_skip_conflict();
+	box_set_replication_parallel_apply();
 	replication_sync_lag = box_check_replication_sync_lag();
 	xstream_create(&join_stream, apply_initial_join_row);
 	xstream_create(&subscribe_stream, apply_row);
@@ -1957,8 +2380,10 @@ box_cfg_xc(void)
 	int64_t wal_max_rows = box_check_wal_max_rows(cfg_geti64("rows_per_wal"));
 	int64_t wal_max_size = box_check_wal_max_size(cfg_geti64("wal_max_size"));
 	enum wal_mode wal_mode = box_check_wal_mode(cfg_gets("wal_mode"));
+	size_t wal_ring_size = box_check_wal_ring_size();
 	if (wal_init(wal_mode, cfg_gets("wal_dir"), &INSTANCE_UUID,
-		      &replicaset.vclock, wal_max_rows, wal_max_size)) {
+		      &replicaset.vclock, wal_max_rows, wal_max_size,
+		      wal_ring_size)) {
 		diag_raise();
 	}
 
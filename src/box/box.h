@@ -49,8 +49,10 @@ struct request;
 struct xrow_header;
 struct obuf;
 struct ev_io;
+struct xrow_zstd;
 struct auth_request;
 struct space;
+struct tuple_filter;
 
 /*
  * Initialize box library
@@ -153,11 +155,21 @@ box_reset_stat(void);
 void
 box_process_auth(struct auth_request *request);
 
+/*
+ * Replication requests. The replica is talked to over \a io,
+ * compressed with \a zstd unless it is NULL, see IPROTO_COMPRESS.
+ */
+void
+box_process_join(struct ev_io *io, struct xrow_zstd *zstd,
+		 struct xrow_header *header);
+
 void
-box_process_join(struct ev_io *io, struct xrow_header *header);
+box_process_join_stream(struct ev_io *io, struct xrow_zstd *zstd,
+			struct xrow_header *header);
 
 void
-box_process_subscribe(struct ev_io *io, struct xrow_header *header);
+box_process_subscribe(struct ev_io *io, struct xrow_zstd *zstd,
+		      struct xrow_header *header);
 
 /**
  * Check Lua configuration before initialization or
@@ -177,6 +189,10 @@ void box_set_too_long_threshold(void);
 void box_set_readahead(void);
 void box_set_checkpoint_count(void);
 void box_set_memtx_max_tuple_size(void);
+void box_set_memtx_defrag_threshold(void);
+void box_set_memtx_tree_fill_factor(void);
+void box_set_memtx_expire_batch_size(void);
+void box_set_memtx_expire_rate(void);
 void box_set_vinyl_max_tuple_size(void);
 void box_set_vinyl_cache(void);
 void box_set_vinyl_timeout(void);
@@ -184,18 +200,31 @@ void box_set_replication_timeout(void);
 void box_set_replication_connect_timeout(void);
 void box_set_replication_connect_quorum(void);
 void box_set_replication_skip_conflict(void);
+void box_set_replication_parallel_apply(void);
 void box_set_net_msg_max(void);
+void box_set_net_cursor_max(void);
+void box_set_net_cursor_timeout(void);
+void box_set_net_cursor_memory(void);
+void box_set_wal_ring_size(void);
 
 extern "C" {
 #endif /* defined(__cplusplus) */
 
 typedef struct tuple box_tuple_t;
 
-/* box_select is private and used only by FFI */
+/*
+ * box_select is private and used only by FFI.
+ * Tuples not matching @a filter, if it is not NULL, are
+ * skipped and not counted against @a offset and @a limit.
+ * If @a is_cover is set, the port is filled with the fields
+ * covered by the index rather than with the tuples, see
+ * index_create_cover_iterator().
+ */
 API_EXPORT int
 box_select(uint32_t space_id, uint32_t index_id,
 	   int iterator, uint32_t offset, uint32_t limit,
 	   const char *key, const char *key_end,
+	   const struct tuple_filter *filter, bool is_cover,
 	   struct port *port);
 
 /** \cond public */
@@ -171,9 +171,18 @@ engine_backup(struct vclock *vclock, engine_backup_cb cb, void *cb_arg)
 
 int
 engine_join(struct vclock *vclock, struct xstream *stream)
+{
+	return engine_join_except(vclock, stream, NULL);
+}
+
+int
+engine_join_except(struct vclock *vclock, struct xstream *stream,
+		   struct engine *except)
 {
 	struct engine *engine;
 	engine_foreach(engine) {
+		if (engine == except)
+			continue;
 		if (engine->vtab->join(engine, vclock, stream) != 0)
 			return -1;
 	}
@@ -312,6 +312,14 @@ engine_end_recovery(void);
 int
 engine_join(struct vclock *vclock, struct xstream *stream);
 
+/**
+ * Same as engine_join(), but skip the given engine. Used if
+ * its checkpoint is sent to the replica as files.
+ */
+int
+engine_join_except(struct vclock *vclock, struct xstream *stream,
+		   struct engine *except);
+
 int
 engine_begin_checkpoint(void);
 
@@ -421,6 +429,14 @@ engine_join_xc(struct vclock *vclock, struct xstream *stream)
 		diag_raise();
 }
 
+static inline void
+engine_join_except_xc(struct vclock *vclock, struct xstream *stream,
+		      struct engine *except)
+{
+	if (engine_join_except(vclock, stream, except) != 0)
+		diag_raise();
+}
+
 #endif /* defined(__cplusplus) */
 
 #endif /* TARANTOOL_BOX_ENGINE_H_INCLUDED */
@@ -215,6 +215,10 @@ struct errcode_record {
 	/*160 */_(ER_ACTION_MISMATCH,		"Field %d contains %s on conflict action, but %s in index parts") \
 	/*161 */_(ER_VIEW_MISSING_SQL,		"Space declared as a view must have SQL statement") \
 	/*162 */_(ER_FOREIGN_KEY_CONSTRAINT,	"Can not commit transaction: deferred foreign keys violations are not resolved") \
+	/*163 */_(ER_TRANSACTION_YIELD,		"Transaction has been aborted by a fiber yield") \
+	/*164 */_(ER_UNABLE_PROCESS_OUT_OF_STREAM, "Unable to process %s request out of stream") \
+	/*165 */_(ER_NO_SUCH_CURSOR,		"Cursor '%llu' does not exist") \
+	/*166 */_(ER_CURSOR_LIMIT,		"Too many open cursors: %s") \
 
 /*
  * !IMPORTANT! Please follow instructions at start of the file
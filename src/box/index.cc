@@ -220,7 +220,7 @@ box_index_random(uint32_t space_id, uint32_t index_id, uint32_t rnd,
 	/* No tx management, random() is for approximation anyway. */
 	if (index_random(index, rnd, result) != 0)
 		return -1;
-	if (*result != NULL && tuple_bless(*result) == NULL)
+	if (*result != NULL && (*result = tuple_bless(*result)) == NULL)
 		return -1;
 	return 0;
 }
@@ -253,7 +253,7 @@ box_index_get(uint32_t space_id, uint32_t index_id, const char *key,
 	txn_commit_ro_stmt(txn);
 	/* Count statistics. */
 	rmean_collect(rmean_box, IPROTO_SELECT, 1);
-	if (*result != NULL && tuple_bless(*result) == NULL)
+	if (*result != NULL && (*result = tuple_bless(*result)) == NULL)
 		return -1;
 	return 0;
 }
@@ -285,7 +285,7 @@ box_index_min(uint32_t space_id, uint32_t index_id, const char *key,
 		return -1;
 	}
 	txn_commit_ro_stmt(txn);
-	if (*result != NULL && tuple_bless(*result) == NULL)
+	if (*result != NULL && (*result = tuple_bless(*result)) == NULL)
 		return -1;
 	return 0;
 }
@@ -317,7 +317,7 @@ box_index_max(uint32_t space_id, uint32_t index_id, const char *key,
 		return -1;
 	}
 	txn_commit_ro_stmt(txn);
-	if (*result != NULL && tuple_bless(*result) == NULL)
+	if (*result != NULL && (*result = tuple_bless(*result)) == NULL)
 		return -1;
 	return 0;
 }
@@ -358,9 +358,9 @@ box_index_count(uint32_t space_id, uint32_t index_id, int type,
 
 /* {{{ Iterators ************************************************/
 
-box_iterator_t *
-box_index_iterator(uint32_t space_id, uint32_t index_id, int type,
-                   const char *key, const char *key_end)
+static box_iterator_t *
+box_index_iterator_new(uint32_t space_id, uint32_t index_id, int type,
+		       const char *key, const char *key_end, bool is_cover)
 {
 	assert(key != NULL && key_end != NULL);
 	mp_tuple_assert(key, key_end);
@@ -381,8 +381,9 @@ box_index_iterator(uint32_t space_id, uint32_t index_id, int type,
 	struct txn *txn;
 	if (txn_begin_ro_stmt(space, &txn) != 0)
 		return NULL;
-	struct iterator *it = index_create_iterator(index, itype,
-						    key, part_count);
+	struct iterator *it = is_cover ?
+		index_create_cover_iterator(index, itype, key, part_count) :
+		index_create_iterator(index, itype, key, part_count);
 	if (it == NULL) {
 		txn_rollback_stmt();
 		return NULL;
@@ -391,13 +392,29 @@ box_index_iterator(uint32_t space_id, uint32_t index_id, int type,
 	return it;
 }
 
+box_iterator_t *
+box_index_iterator(uint32_t space_id, uint32_t index_id, int type,
+                   const char *key, const char *key_end)
+{
+	return box_index_iterator_new(space_id, index_id, type,
+				      key, key_end, false);
+}
+
+box_iterator_t *
+box_index_cover_iterator(uint32_t space_id, uint32_t index_id, int type,
+			 const char *key, const char *key_end)
+{
+	return box_index_iterator_new(space_id, index_id, type,
+				      key, key_end, true);
+}
+
 int
 box_iterator_next(box_iterator_t *itr, box_tuple_t **result)
 {
 	assert(result != NULL);
 	if (iterator_next(itr, result) != 0)
 		return -1;
-	if (*result != NULL && tuple_bless(*result) == NULL)
+	if (*result != NULL && (*result = tuple_bless(*result)) == NULL)
 		return -1;
 	return 0;
 }
@@ -670,6 +687,17 @@ generic_index_replace(struct index *index, struct tuple *old_tuple,
 	return -1;
 }
 
+struct iterator *
+generic_index_create_cover_iterator(struct index *index, enum iterator_type type,
+				    const char *key, uint32_t part_count)
+{
+	(void)type;
+	(void)key;
+	(void)part_count;
+	diag_set(UnsupportedIndexFeature, index->def, "covered reads");
+	return NULL;
+}
+
 struct snapshot_iterator *
 generic_index_create_snapshot_iterator(struct index *index)
 {
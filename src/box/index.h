@@ -211,6 +211,16 @@ box_tuple_extract_key(const box_tuple_t *tuple, uint32_t space_id,
 
 /** \endcond public */
 
+/**
+ * Allocate and initialize an iterator over the fields covered
+ * by \a index_id, see index_create_cover_iterator(). Arguments
+ * and the return value are the same as of box_index_iterator().
+ * Used only by FFI.
+ */
+box_iterator_t *
+box_index_cover_iterator(uint32_t space_id, uint32_t index_id, int type,
+			 const char *key, const char *key_end);
+
 /**
  * Index introspection (index:info())
  *
@@ -290,10 +300,11 @@ iterator_delete(struct iterator *it);
 struct snapshot_iterator {
 	/**
 	 * Iterate to the next tuple in the snapshot.
-	 * Returns a pointer to the tuple data and its
-	 * size or NULL if EOF.
+	 * Sets @a data to the tuple data and @a size to its
+	 * size or @a data to NULL if EOF. Returns -1 on error.
 	 */
-	const char *(*next)(struct snapshot_iterator *, uint32_t *size);
+	int (*next)(struct snapshot_iterator *, const char **data,
+		    uint32_t *size);
 	/**
 	 * Destroy the iterator.
 	 */
@@ -418,6 +429,14 @@ struct index_vtab {
 	struct iterator *(*create_iterator)(struct index *index,
 			enum iterator_type type,
 			const char *key, uint32_t part_count);
+	/**
+	 * Create an index iterator that returns copies of the
+	 * fields covered by the index instead of the indexed
+	 * tuples, @sa index_create_cover_iterator().
+	 */
+	struct iterator *(*create_cover_iterator)(struct index *index,
+			enum iterator_type type,
+			const char *key, uint32_t part_count);
 	/**
 	 * Create an ALL iterator with personal read view so further
 	 * index modifications will not affect the iteration results.
@@ -610,6 +629,21 @@ index_create_iterator(struct index *index, enum iterator_type type,
 	return index->vtab->create_iterator(index, type, key, part_count);
 }
 
+/**
+ * Create an iterator that returns tuples made of the fields
+ * stored in the index: its key parts, primary key parts and
+ * included fields, at their positions in the indexed tuple,
+ * with other fields set to nil. The tuples are read without
+ * accessing the indexed ones.
+ */
+static inline struct iterator *
+index_create_cover_iterator(struct index *index, enum iterator_type type,
+			    const char *key, uint32_t part_count)
+{
+	return index->vtab->create_cover_iterator(index, type, key,
+						  part_count);
+}
+
 static inline struct snapshot_iterator *
 index_create_snapshot_iterator(struct index *index)
 {
@@ -676,6 +710,9 @@ ssize_t generic_index_count(struct index *, enum iterator_type,
 int generic_index_get(struct index *, const char *, uint32_t, struct tuple **);
 int generic_index_replace(struct index *, struct tuple *, struct tuple *,
 			  enum dup_replace_mode, struct tuple **);
+struct iterator *
+generic_index_create_cover_iterator(struct index *, enum iterator_type,
+				    const char *, uint32_t);
 struct snapshot_iterator *generic_index_create_snapshot_iterator(struct index *);
 void generic_index_info(struct index *, struct info_handler *);
 void generic_index_compact(struct index *);
@@ -31,6 +31,8 @@
 #include "index_def.h"
 #include "schema_def.h"
 #include "identifier.h"
+#include "msgpuck.h"
+#include "small/region.h"
 
 const char *index_type_strs[] = { "HASH", "TREE", "BITSET", "RTREE" };
 
@@ -40,6 +42,7 @@ const struct index_opts index_opts_default = {
 	/* .unique              = */ true,
 	/* .dimension           = */ 2,
 	/* .distance            = */ RTREE_INDEX_DISTANCE_TYPE_EUCLID,
+	/* .is_roaring          = */ false,
 	/* .range_size          = */ 1073741824,
 	/* .page_size           = */ 8192,
 	/* .run_count_per_level = */ 2,
@@ -48,13 +51,45 @@ const struct index_opts index_opts_default = {
 	/* .lsn                 = */ 0,
 	/* .sql                 = */ NULL,
 	/* .stat                = */ NULL,
+	/* .include             = */ NULL,
+	/* .include_count       = */ 0,
 };
 
+static int
+index_opts_decode_include(const char **data, uint32_t len, char *opt,
+			  struct region *region)
+{
+	struct index_opts *opts = container_of((uint32_t **)opt,
+					       struct index_opts, include);
+	uint32_t *include = NULL;
+	if (len > 0) {
+		include = (uint32_t *)region_alloc(region,
+						   len * sizeof(*include));
+		if (include == NULL) {
+			diag_set(OutOfMemory, len * sizeof(*include),
+				 "region", "include");
+			return -1;
+		}
+	}
+	for (uint32_t i = 0; i < len; i++) {
+		if (mp_typeof(**data) != MP_UINT)
+			return -1;
+		uint64_t fieldno = mp_decode_uint(data);
+		if (fieldno >= BOX_FIELD_MAX)
+			return -1;
+		include[i] = fieldno;
+	}
+	opts->include = include;
+	opts->include_count = len;
+	return 0;
+}
+
 const struct opt_def index_opts_reg[] = {
 	OPT_DEF("unique", OPT_BOOL, struct index_opts, is_unique),
 	OPT_DEF("dimension", OPT_INT64, struct index_opts, dimension),
 	OPT_DEF_ENUM("distance", rtree_index_distance_type, struct index_opts,
 		     distance, NULL),
+	OPT_DEF("roaring", OPT_BOOL, struct index_opts, is_roaring),
 	OPT_DEF("range_size", OPT_INT64, struct index_opts, range_size),
 	OPT_DEF("page_size", OPT_INT64, struct index_opts, page_size),
 	OPT_DEF("run_count_per_level", OPT_INT64, struct index_opts, run_count_per_level),
@@ -62,6 +97,8 @@ const struct opt_def index_opts_reg[] = {
 	OPT_DEF("bloom_fpr", OPT_FLOAT, struct index_opts, bloom_fpr),
 	OPT_DEF("lsn", OPT_INT64, struct index_opts, lsn),
 	OPT_DEF("sql", OPT_STRPTR, struct index_opts, sql),
+	OPT_DEF_ARRAY("include", struct index_opts, include,
+		      index_opts_decode_include),
 	OPT_END,
 };
 
@@ -109,6 +146,7 @@ index_def_new(uint32_t space_id, uint32_t iid, const char *name,
 	def->space_id = space_id;
 	def->iid = iid;
 	def->opts = *opts;
+	def->opts.include = NULL;
 	if (opts->sql != NULL) {
 		def->opts.sql = strdup(opts->sql);
 		if (def->opts.sql == NULL) {
@@ -118,6 +156,17 @@ index_def_new(uint32_t space_id, uint32_t iid, const char *name,
 			return NULL;
 		}
 	}
+	if (opts->include_count > 0) {
+		size_t size = opts->include_count * sizeof(*opts->include);
+		def->opts.include = (uint32_t *)malloc(size);
+		if (def->opts.include == NULL) {
+			diag_set(OutOfMemory, size, "malloc",
+				 "def->opts.include");
+			index_def_delete(def);
+			return NULL;
+		}
+		memcpy(def->opts.include, opts->include, size);
+	}
 	/* Statistics are initialized separately. */
 	assert(opts->stat == NULL);
 	return def;
@@ -148,6 +197,7 @@ index_def_dup(const struct index_def *def)
 	}
 	rlist_create(&dup->link);
 	dup->opts = def->opts;
+	dup->opts.include = NULL;
 	if (def->opts.sql != NULL) {
 		dup->opts.sql = strdup(def->opts.sql);
 		if (dup->opts.sql == NULL) {
@@ -157,6 +207,18 @@ index_def_dup(const struct index_def *def)
 			return NULL;
 		}
 	}
+	if (def->opts.include_count > 0) {
+		size_t size = def->opts.include_count *
+			      sizeof(*def->opts.include);
+		dup->opts.include = (uint32_t *)malloc(size);
+		if (dup->opts.include == NULL) {
+			diag_set(OutOfMemory, size, "malloc",
+				 "dup->opts.include");
+			index_def_delete(dup);
+			return NULL;
+		}
+		memcpy(dup->opts.include, def->opts.include, size);
+	}
 	if (def->opts.stat != NULL) {
 		dup->opts.stat = index_stat_dup(def->opts.stat);
 		if (dup->opts.stat == NULL) {
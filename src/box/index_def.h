@@ -135,6 +135,11 @@ struct index_opts {
 	 * RTREE distance type.
 	 */
 	enum rtree_index_distance_type distance;
+	/**
+	 * Store BITSET index values in roaring bitsets, which
+	 * are more compact for sparse and clustered values.
+	 */
+	bool is_roaring;
 	/**
 	 * Vinyl index options.
 	 */
@@ -167,6 +172,14 @@ struct index_opts {
 	 * filled after running ANALYZE command.
 	 */
 	struct index_stat *stat;
+	/**
+	 * Numbers of non-indexed fields to store offsets of in
+	 * the tuple field map along with key parts, so that
+	 * reading them doesn't need to decode preceding fields.
+	 */
+	uint32_t *include;
+	/** Number of entries in the include array. */
+	uint32_t include_count;
 };
 
 extern const struct index_opts index_opts_default;
@@ -189,6 +202,7 @@ index_opts_destroy(struct index_opts *opts)
 {
 	free(opts->sql);
 	free(opts->stat);
+	free(opts->include);
 	TRASH(opts);
 }
 
@@ -201,6 +215,8 @@ index_opts_cmp(const struct index_opts *o1, const struct index_opts *o2)
 		return o1->dimension < o2->dimension ? -1 : 1;
 	if (o1->distance != o2->distance)
 		return o1->distance < o2->distance ? -1 : 1;
+	if (o1->is_roaring != o2->is_roaring)
+		return o1->is_roaring < o2->is_roaring ? -1 : 1;
 	if (o1->range_size != o2->range_size)
 		return o1->range_size < o2->range_size ? -1 : 1;
 	if (o1->page_size != o2->page_size)
@@ -212,6 +228,12 @@ index_opts_cmp(const struct index_opts *o1, const struct index_opts *o2)
 		return o1->run_size_ratio < o2->run_size_ratio ? -1 : 1;
 	if (o1->bloom_fpr != o2->bloom_fpr)
 		return o1->bloom_fpr < o2->bloom_fpr ? -1 : 1;
+	if (o1->include_count != o2->include_count)
+		return o1->include_count < o2->include_count ? -1 : 1;
+	for (uint32_t i = 0; i < o1->include_count; i++) {
+		if (o1->include[i] != o2->include[i])
+			return o1->include[i] < o2->include[i] ? -1 : 1;
+	}
 	return 0;
 }
 
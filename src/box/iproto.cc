@@ -37,9 +37,11 @@
 #include <small/ibuf.h>
 #include <small/obuf.h>
 #include "third_party/base64.h"
+#include "zstd.h"
 
 #include "version.h"
 #include "fiber.h"
+#include "fiber_cond.h"
 #include "cbus.h"
 #include "say.h"
 #include "sio.h"
@@ -52,16 +54,26 @@
 #include "box.h"
 #include "call.h"
 #include "tuple_convert.h"
+#include "tuple_filter.h"
 #include "session.h"
 #include "xrow.h"
+#include "xrow_io.h"
 #include "schema.h" /* schema_version */
 #include "replication.h" /* instance_uuid */
 #include "iproto_constants.h"
 #include "rmean.h"
+#include "latency.h"
+#include "histogram.h"
+#include "latch.h"
+#include "clock.h"
 #include "execute.h"
 #include "errinj.h"
 #include "applier.h"
 #include "cfg.h"
+#include "txn.h"
+#include "assoc.h"
+#include "index.h"
+#include "tuple.h"
 
 /**
  * Network readahead. A signed integer to avoid
@@ -152,6 +164,8 @@ struct iproto_msg
 		struct auth_request auth;
 		/* SQL request, if this is the EXECUTE request. */
 		struct sql_request sql;
+		/** Cursor request, if this is CURSOR_FETCH or CLOSE. */
+		struct cursor_request cursor;
 		/** In case of iproto parse error, saved diagnostics. */
 		struct diag diag;
 	};
@@ -187,10 +201,160 @@ struct iproto_msg
 	 * and the connection must be closed.
 	 */
 	bool close_connection;
+	/**
+	 * Used in COMPRESS msgs, true if tx has replied OK and
+	 * the connection must switch to compressed wire format.
+	 */
+	bool is_compression_accepted;
+	/** Stream the request belongs to, NULL if out of stream. */
+	struct iproto_stream *stream;
+	/**
+	 * Route of a stream message. Stream messages go through
+	 * the stream route first, @sa tx_process_stream().
+	 */
+	const struct cmsg_hop *stream_route;
+	/** Link in iproto_stream::pending. */
+	struct stailq_entry in_stream;
+	/**
+	 * Used in stream msgs, true if the stream still has an
+	 * open transaction after the message is processed and
+	 * must not be deleted.
+	 */
+	bool is_stream_in_txn;
+	/**
+	 * clock_monotonic() of the request receipt, acceptance
+	 * by the tx thread and the end of the reply, set by
+	 * tx_end_msg(). Used for latency statistics.
+	 */
+	double recv_time;
+	double accept_time;
+	double reply_time;
+	/** Time spent by the tx thread waiting for WAL writes. */
+	double wal_time;
 };
 
 static struct mempool iproto_msg_pool;
 
+/**
+ * A stream is a sequence of requests of a single connection
+ * which are processed strictly one after another, in the order
+ * they were received, while requests of other streams and out
+ * of stream requests of the same connection are processed
+ * concurrently. A stream can run an interactive transaction,
+ * which spans several requests: BEGIN, any number of DML, CALL,
+ * EVAL or EXECUTE requests and COMMIT or ROLLBACK. memtx has
+ * no multiversioning and can't take part in such a transaction.
+ *
+ * A stream is created in the network thread on the first
+ * request with a new IPROTO_STREAM_ID and is deleted as soon as
+ * it has no requests in processing and no open transaction.
+ */
+struct iproto_stream {
+	/** Stream id, unique within the connection. */
+	uint64_t id;
+	/** Connection the stream belongs to. */
+	struct iproto_connection *connection;
+	/**
+	 * Message of the stream which is being processed by
+	 * the tx thread, NULL if none.
+	 */
+	struct iproto_msg *current;
+	/**
+	 * Messages waiting for the current message to be
+	 * processed, linked by iproto_msg::in_stream.
+	 */
+	struct stailq pending;
+	/**
+	 * The following fields are used exclusively by the tx
+	 * thread. The network thread learns whether the stream
+	 * has an open transaction from iproto_msg::is_stream_in_txn.
+	 */
+	struct {
+		alignas(CACHELINE_SIZE)
+		/**
+		 * Fiber running the transaction of the stream,
+		 * NULL if there is no open transaction. A
+		 * transaction is bound to the fiber it was
+		 * started in, so all requests of the stream are
+		 * handed over to this fiber until the
+		 * transaction ends.
+		 */
+		struct fiber *fiber;
+		/** Message handed over to the stream fiber. */
+		struct iproto_msg *msg;
+		/** Signaled when the stream fiber is done with msg. */
+		struct fiber_cond cond;
+		/**
+		 * Id of the transaction open in the stream or -1
+		 * if BEGIN has not been processed yet.
+		 */
+		int64_t txn_id;
+		/**
+		 * Set on disconnect to let the stream fiber roll
+		 * back the transaction and exit.
+		 */
+		bool is_closed;
+		/**
+		 * Link in the list of streams with an open
+		 * transaction, iproto_connection::tx::streams.
+		 */
+		struct rlist in_connection;
+	} tx;
+};
+
+static struct mempool iproto_stream_pool;
+
+/**
+ * A server-side cursor: an index iterator kept open between
+ * requests, so that a client can export a big result set in
+ * batches without re-positioning in the index for each batch.
+ * Iterators are stable: they survive concurrent changes of the
+ * index and get invalidated on a schema change, like those used
+ * by Lua pairs(). A cursor is opened by CURSOR_OPEN, read by
+ * CURSOR_FETCH and closed by CURSOR_CLOSE, when exhausted, when
+ * it was not accessed for net_cursor_timeout seconds or when
+ * the connection is closed. The number of cursors per
+ * connection is limited by net_cursor_max, the memory held by
+ * all cursors by net_cursor_memory. Cursors live in the tx
+ * thread.
+ */
+struct iproto_cursor {
+	/** Id of the cursor, unique within the connection. */
+	uint64_t id;
+	/** Connection which opened the cursor. */
+	struct iproto_connection *connection;
+	/** Index iterator. */
+	struct iterator *it;
+	/** ev_monotonic_now() of the last access. */
+	double last_used;
+	/** True while a CURSOR_FETCH is reading the iterator. */
+	bool is_busy;
+	/**
+	 * Memory held by the cursor: the cursor itself and the
+	 * last tuple returned by the iterator. Iterators keep it
+	 * referenced to continue from it, so the tuple is not
+	 * freed even if it is deleted from the space.
+	 */
+	size_t mem_used;
+	/** Link in iproto_cursors. */
+	struct rlist in_lru;
+};
+
+/** Max number of open cursors per connection, net_cursor_max. */
+static int iproto_cursor_max = 64;
+/** Idle time after which a cursor is closed, net_cursor_timeout. */
+static double iproto_cursor_timeout = 60;
+/** Max memory held by all open cursors, net_cursor_memory. */
+static size_t iproto_cursor_memory = 16 * 1024 * 1024;
+/** Memory held by all open cursors, @sa iproto_cursor::mem_used. */
+static size_t iproto_cursor_mem_used;
+/** Allocator of iproto_cursor objects, used in the tx thread. */
+static struct mempool iproto_cursor_pool;
+/** All open cursors, the least recently used first. */
+static RLIST_HEAD(iproto_cursors);
+/** Fiber closing cursors which were idle for too long. */
+static struct fiber *iproto_cursor_gc_fiber;
+
 static struct iproto_msg *
 iproto_msg_new(struct iproto_connection *con);
 
@@ -246,6 +410,31 @@ enum rmean_net_name {
 
 const char *rmean_net_strings[IPROTO_LAST] = { "SENT", "RECEIVED" };
 
+const char *iproto_latency_phase_strs[iproto_latency_phase_MAX] = {
+	"queue", "tx", "wal", "reply", "total"
+};
+
+/** Request types which latency is accounted. */
+enum { IPROTO_LATENCY_TYPE_MAX = IPROTO_CURSOR_CLOSE + 1 };
+
+/**
+ * Latency of requests by request type and processing phase.
+ * Only types which have a name are accounted. Collected, reset
+ * and read by the network thread only.
+ */
+static struct latency
+iproto_latency[IPROTO_LATENCY_TYPE_MAX][iproto_latency_phase_MAX];
+
+/**
+ * Copy of iproto_latency taken by the network thread on
+ * request of the tx thread, see iproto_latency_foreach().
+ */
+static struct latency
+iproto_latency_snapshot[IPROTO_LATENCY_TYPE_MAX][iproto_latency_phase_MAX];
+
+/** Serializes tx fibers using iproto_latency_snapshot. */
+static struct latch iproto_latency_latch;
+
 static void
 tx_process_disconnect(struct cmsg *m);
 
@@ -355,6 +544,38 @@ struct iproto_connection
 	/** True if disconnect message is sent. Debug-only. */
 	bool is_disconnected;
 	struct rlist in_stop_list;
+	/** Streams of the connection: stream id -> iproto_stream. */
+	struct mh_i64ptr_t *streams;
+	/**
+	 * Wire compression state, @sa IPROTO_COMPRESS. Used
+	 * exclusively by the network thread, except that the
+	 * contexts are lent to JOIN and SUBSCRIBE, which write
+	 * to the socket directly. The contexts are NULL until
+	 * the compression is negotiated.
+	 */
+	struct {
+		/** Compressor of the output. */
+		ZSTD_CStream *cstream;
+		/** Decompressor of the input. */
+		ZSTD_DStream *dstream;
+		/** Compressed input which is not decompressed yet. */
+		struct ibuf in;
+		/** Compressed output which is not written yet. */
+		struct ibuf out;
+		/**
+		 * True until the output which precedes the
+		 * COMPRESS reply, inclusive, is flushed raw.
+		 */
+		bool is_pending;
+		/** End of the COMPRESS reply in the output. */
+		struct iproto_wpos raw_end;
+		/**
+		 * True if the last decompression filled up the
+		 * input buffer, so the decompressor may hold more
+		 * data even if there is no compressed input left.
+		 */
+		bool is_draining;
+	} zstd;
 	/**
 	 * The following fields are used exclusively by the tx thread.
 	 * Align them to prevent false-sharing.
@@ -363,12 +584,105 @@ struct iproto_connection
 		alignas(CACHELINE_SIZE)
 		/** Pointer to the current output buffer. */
 		struct obuf *p_obuf;
+		/**
+		 * Open cursors: cursor id -> iproto_cursor.
+		 * Created on the first CURSOR_OPEN.
+		 */
+		struct mh_i64ptr_t *cursors;
+		/** Id of the last opened cursor. */
+		uint64_t last_cursor_id;
+		/**
+		 * Streams with an open transaction, linked by
+		 * iproto_stream::tx::in_connection.
+		 */
+		struct rlist streams;
 	} tx;
 };
 
 static struct mempool iproto_connection_pool;
 static RLIST_HEAD(stopped_connections);
 
+/* {{{ iproto_stream - methods */
+
+/**
+ * Find a stream of the connection by id or create a new one.
+ * Must be called in the network thread.
+ */
+static struct iproto_stream *
+iproto_connection_stream(struct iproto_connection *con, uint64_t stream_id)
+{
+	struct mh_i64ptr_t *streams = con->streams;
+	mh_int_t pos = mh_i64ptr_find(streams, stream_id, NULL);
+	if (pos != mh_end(streams)) {
+		return (struct iproto_stream *)
+			mh_i64ptr_node(streams, pos)->val;
+	}
+	struct iproto_stream *stream = (struct iproto_stream *)
+		mempool_alloc(&iproto_stream_pool);
+	if (stream == NULL) {
+		diag_set(OutOfMemory, sizeof(*stream), "mempool_alloc",
+			 "stream");
+		return NULL;
+	}
+	struct mh_i64ptr_node_t node = { stream_id, stream };
+	if (mh_i64ptr_put(streams, &node, NULL, NULL) == mh_end(streams)) {
+		mempool_free(&iproto_stream_pool, stream);
+		diag_set(OutOfMemory, sizeof(node), "mh_i64ptr_put",
+			 "mh_i64ptr_node_t");
+		return NULL;
+	}
+	stream->id = stream_id;
+	stream->connection = con;
+	stream->current = NULL;
+	stailq_create(&stream->pending);
+	stream->tx.fiber = NULL;
+	stream->tx.msg = NULL;
+	fiber_cond_create(&stream->tx.cond);
+	stream->tx.txn_id = -1;
+	stream->tx.is_closed = false;
+	rlist_create(&stream->tx.in_connection);
+	return stream;
+}
+
+/** Remove a stream from the connection and free it. */
+static void
+iproto_stream_delete(struct iproto_stream *stream)
+{
+	assert(stream->current == NULL);
+	assert(stailq_empty(&stream->pending));
+	struct mh_i64ptr_t *streams = stream->connection->streams;
+	mh_int_t pos = mh_i64ptr_find(streams, stream->id, NULL);
+	assert(pos != mh_end(streams));
+	mh_i64ptr_del(streams, pos, NULL);
+	fiber_cond_destroy(&stream->tx.cond);
+	mempool_free(&iproto_stream_pool, stream);
+}
+
+/**
+ * Make a message the current message of its stream. If
+ * the stream is busy processing a previous message, the
+ * message is queued and will be sent to the tx thread
+ * when all previous messages of the stream are complete,
+ * @sa net_send_stream_msg().
+ *
+ * @retval true the message can be sent to tx right away.
+ * @retval false the message is queued.
+ */
+static inline bool
+iproto_stream_acquire(struct iproto_msg *msg)
+{
+	struct iproto_stream *stream = msg->stream;
+	if (stream->current == NULL) {
+		assert(stailq_empty(&stream->pending));
+		stream->current = msg;
+		return true;
+	}
+	stailq_add_tail_entry(&stream->pending, msg, in_stream);
+	return false;
+}
+
+/* }}} iproto_stream */
+
 /**
  * Return true if we have not enough spare messages
  * in the message pool.
@@ -396,6 +710,9 @@ iproto_msg_new(struct iproto_connection *con)
 		return NULL;
 	}
 	msg->connection = con;
+	msg->stream = NULL;
+	msg->recv_time = clock_monotonic();
+	msg->reply_time = 0;
 	return msg;
 }
 
@@ -642,7 +959,8 @@ iproto_enqueue_batch(struct iproto_connection *con, struct ibuf *in)
 		 * This can't throw, but should not be
 		 * done in case of exception.
 		 */
-		cpipe_push_input(&tx_pipe, &msg->base);
+		if (msg->stream == NULL || iproto_stream_acquire(msg))
+			cpipe_push_input(&tx_pipe, &msg->base);
 		n_requests++;
 		/* Request is parsed */
 		assert(reqend > reqstart);
@@ -731,6 +1049,53 @@ iproto_resume()
 	}
 }
 
+/**
+ * Read compressed input from the socket and decompress as much
+ * of it as fits into the unused space of the input buffer. The
+ * caller advances the buffer write position. Throws on a socket
+ * or decompression error.
+ *
+ * @retval >0 Size of the decompressed data.
+ * @retval  0 EOF.
+ * @retval -1 The socket is not ready.
+ */
+static ssize_t
+iproto_connection_read_compressed(struct iproto_connection *con,
+				  struct ibuf *in)
+{
+	struct ibuf *zin = &con->zstd.in;
+	ZSTD_outBuffer output = { in->wpos, ibuf_unused(in), 0 };
+	while (output.pos == 0) {
+		if (ibuf_used(zin) == 0 && !con->zstd.is_draining) {
+			ibuf_reset(zin);
+			ibuf_reserve_xc(zin, iproto_readahead);
+			ssize_t nrd = sio_read(con->input.fd, zin->wpos,
+					       ibuf_unused(zin));
+			if (nrd <= 0)
+				return nrd;
+			/* Count statistics */
+			rmean_collect(rmean_net, IPROTO_RECEIVED, nrd);
+			zin->wpos += nrd;
+		}
+		ZSTD_inBuffer input = { zin->rpos, ibuf_used(zin), 0 };
+		size_t rc = ZSTD_decompressStream(con->zstd.dstream,
+						  &output, &input);
+		if (ZSTD_isError(rc)) {
+			tnt_raise(ClientError, ER_DECOMPRESSION,
+				  ZSTD_getErrorName(rc));
+		}
+		zin->rpos += input.pos;
+		con->zstd.is_draining = output.pos == output.size;
+	}
+	/*
+	 * The socket may have nothing more to read while there
+	 * is still data to decompress: don't wait for it.
+	 */
+	if (ibuf_used(zin) != 0 || con->zstd.is_draining)
+		ev_feed_event(con->loop, &con->input, EV_READ);
+	return output.pos;
+}
+
 static void
 iproto_connection_on_input(ev_loop *loop, struct ev_io *watcher,
 			   int /* revents */)
@@ -759,7 +1124,15 @@ iproto_connection_on_input(ev_loop *loop, struct ev_io *watcher,
 			return;
 		}
 		/* Read input. */
-		int nrd = sio_read(fd, in->wpos, ibuf_unused(in));
+		ssize_t nrd;
+		if (con->zstd.dstream != NULL) {
+			nrd = iproto_connection_read_compressed(con, in);
+		} else {
+			nrd = sio_read(fd, in->wpos, ibuf_unused(in));
+			/* Count statistics */
+			if (nrd > 0)
+				rmean_collect(rmean_net, IPROTO_RECEIVED, nrd);
+		}
 		if (nrd < 0) {                  /* Socket is not ready. */
 			ev_io_start(loop, &con->input);
 			return;
@@ -768,8 +1141,6 @@ iproto_connection_on_input(ev_loop *loop, struct ev_io *watcher,
 			iproto_connection_close(con);
 			return;
 		}
-		/* Count statistics */
-		rmean_collect(rmean_net, IPROTO_RECEIVED, nrd);
 
 		/* Update the read position and connection state. */
 		in->wpos += nrd;
@@ -785,29 +1156,103 @@ iproto_connection_on_input(ev_loop *loop, struct ev_io *watcher,
 	}
 }
 
+/**
+ * Compress an output chunk into the compressed output buffer.
+ * The compressor is flushed at the end of the chunk, so the
+ * peer can decode all replies of the chunk without waiting
+ * for more data.
+ */
+static void
+iproto_connection_compress(struct iproto_connection *con,
+			   const struct iovec *iov, int iovcnt)
+{
+	ZSTD_CStream *cstream = con->zstd.cstream;
+	struct ibuf *zout = &con->zstd.out;
+	size_t rc;
+	for (int i = 0; i < iovcnt; i++) {
+		ZSTD_inBuffer input = { iov[i].iov_base, iov[i].iov_len, 0 };
+		while (input.pos < input.size) {
+			ibuf_reserve_xc(zout, ZSTD_CStreamOutSize());
+			ZSTD_outBuffer output = {
+				zout->wpos, ibuf_unused(zout), 0
+			};
+			rc = ZSTD_compressStream(cstream, &output, &input);
+			if (ZSTD_isError(rc))
+				goto error;
+			zout->wpos += output.pos;
+		}
+	}
+	do {
+		ibuf_reserve_xc(zout, ZSTD_CStreamOutSize());
+		ZSTD_outBuffer output = { zout->wpos, ibuf_unused(zout), 0 };
+		rc = ZSTD_flushStream(cstream, &output);
+		if (ZSTD_isError(rc))
+			goto error;
+		zout->wpos += output.pos;
+	} while (rc != 0);
+	return;
+error:
+	tnt_raise(ClientError, ER_COMPRESSION, ZSTD_getErrorName(rc));
+}
+
+/**
+ * write() the compressed output to the socket.
+ * @retval 0 All the compressed output is written.
+ * @retval -1 The socket is not ready.
+ */
+static int
+iproto_flush_compressed(struct iproto_connection *con)
+{
+	struct ibuf *zout = &con->zstd.out;
+	ssize_t nwr = sio_write(con->output.fd, zout->rpos, ibuf_used(zout));
+	if (nwr > 0) {
+		/* Count statistics */
+		rmean_collect(rmean_net, IPROTO_SENT, nwr);
+		zout->rpos += nwr;
+	}
+	if (ibuf_used(zout) != 0)
+		return -1;
+	ibuf_reset(zout);
+	return 0;
+}
+
 /** writev() to the socket and handle the result. */
 
 static int
 iproto_flush(struct iproto_connection *con)
 {
+	if (ibuf_used(&con->zstd.out) != 0)
+		return iproto_flush_compressed(con);
 	int fd = con->output.fd;
 	struct obuf *obuf = con->wpos.obuf;
 	struct obuf_svp obuf_end = obuf_create_svp(obuf);
 	struct obuf_svp *begin = &con->wpos.svp;
-	struct obuf_svp *end = &con->wend.svp;
-	if (con->wend.obuf != obuf) {
+	/*
+	 * Output after the COMPRESS reply must be compressed
+	 * even if it was appended while the reply was waiting
+	 * for the socket, so the raw output ends at the reply.
+	 */
+	struct iproto_wpos *wend = con->zstd.is_pending ?
+				   &con->zstd.raw_end : &con->wend;
+	struct obuf_svp *end = &wend->svp;
+	if (wend->obuf != obuf) {
 		/*
 		 * Flush the current buffer before
 		 * advancing to the next one.
 		 */
 		if (begin->used == obuf_end.used) {
-			obuf = con->wpos.obuf = con->wend.obuf;
+			obuf = con->wpos.obuf = wend->obuf;
 			obuf_svp_reset(begin);
 		} else {
 			end = &obuf_end;
 		}
 	}
 	if (begin->used == end->used) {
+		if (con->zstd.is_pending) {
+			/* The reply is sent, compress the rest. */
+			con->zstd.is_pending = false;
+			return 0;
+		}
 		/* Nothing to do. */
 		return 1;
 	}
@@ -824,6 +1269,11 @@ iproto_flush(struct iproto_connection *con)
 	/* *Overwrite* iov_len of the last pos as it may be garbage. */
 	iov[iovcnt-1].iov_len = end->iov_len - begin->iov_len * (iovcnt == 1);
 
+	if (con->zstd.cstream != NULL && !con->zstd.is_pending) {
+		iproto_connection_compress(con, iov, iovcnt);
+		*begin = *end;
+		return iproto_flush_compressed(con);
+	}
 	ssize_t nwr = sio_writev(fd, iov, iovcnt);
 
 	/* Count statistics */
@@ -879,6 +1329,13 @@ iproto_connection_new(int fd)
 		diag_set(OutOfMemory, sizeof(*con), "mempool_alloc", "con");
 		return NULL;
 	}
+	con->streams = mh_i64ptr_new();
+	if (con->streams == NULL) {
+		mempool_free(&iproto_connection_pool, con);
+		diag_set(OutOfMemory, sizeof(*con->streams), "mh_i64ptr_new",
+			 "streams");
+		return NULL;
+	}
 	con->input.data = con->output.data = con;
 	con->loop = loop();
 	ev_io_init(&con->input, iproto_connection_on_input, fd, EV_READ);
@@ -889,9 +1346,18 @@ iproto_connection_new(int fd)
 	obuf_create(&con->obuf[1], &net_slabc, iproto_readahead);
 	con->p_ibuf = &con->ibuf[0];
 	con->tx.p_obuf = &con->obuf[0];
+	con->tx.cursors = NULL;
+	con->tx.last_cursor_id = 0;
+	rlist_create(&con->tx.streams);
 	iproto_wpos_create(&con->wpos, con->tx.p_obuf);
 	iproto_wpos_create(&con->wend, con->tx.p_obuf);
 	con->parse_size = 0;
+	con->zstd.cstream = NULL;
+	con->zstd.dstream = NULL;
+	ibuf_create(&con->zstd.in, cord_slab_cache(), iproto_readahead);
+	ibuf_create(&con->zstd.out, cord_slab_cache(), iproto_readahead);
+	con->zstd.is_pending = false;
+	con->zstd.is_draining = false;
 	con->long_poll_requests = 0;
 	con->session = NULL;
 	rlist_create(&con->in_stop_list);
@@ -915,10 +1381,28 @@ iproto_connection_delete(struct iproto_connection *con)
 	 */
 	ibuf_destroy(&con->ibuf[0]);
 	ibuf_destroy(&con->ibuf[1]);
+	ibuf_destroy(&con->zstd.in);
+	ibuf_destroy(&con->zstd.out);
+	ZSTD_freeCStream(con->zstd.cstream);
+	ZSTD_freeDStream(con->zstd.dstream);
 	assert(con->obuf[0].pos == 0 &&
 	       con->obuf[0].iov[0].iov_base == NULL);
 	assert(con->obuf[1].pos == 0 &&
 	       con->obuf[1].iov[0].iov_base == NULL);
+	/*
+	 * Streams with an open transaction outlive their last
+	 * request. The transactions have been rolled back by
+	 * tx_process_disconnect().
+	 */
+	mh_int_t i;
+	mh_foreach(con->streams, i) {
+		struct iproto_stream *stream = (struct iproto_stream *)
+			mh_i64ptr_node(con->streams, i)->val;
+		assert(stream->tx.fiber == NULL);
+		fiber_cond_destroy(&stream->tx.cond);
+		mempool_free(&iproto_stream_pool, stream);
+	}
+	mh_i64ptr_delete(con->streams);
 	mempool_free(&iproto_connection_pool, con);
 }
 
@@ -941,6 +1425,9 @@ tx_process_select(struct cmsg *msg);
 static void
 tx_process_sql(struct cmsg *msg);
 
+static void
+tx_process_cursor(struct cmsg *msg);
+
 static void
 tx_reply_error(struct iproto_msg *msg);
 
@@ -962,11 +1449,25 @@ net_end_join(struct cmsg *msg);
 static void
 net_end_subscribe(struct cmsg *msg);
 
+static void
+tx_process_stream(struct cmsg *msg);
+
+static void
+net_send_stream_msg(struct cmsg *msg);
+
+static void
+net_send_compress(struct cmsg *msg);
+
 static const struct cmsg_hop misc_route[] = {
 	{ tx_process_misc, &net_pipe },
 	{ net_send_msg, NULL },
 };
 
+static const struct cmsg_hop compress_route[] = {
+	{ tx_process_misc, &net_pipe },
+	{ net_send_compress, NULL },
+};
+
 static const struct cmsg_hop call_route[] = {
 	{ tx_process_call, &net_pipe },
 	{ net_send_msg, NULL },
@@ -987,6 +1488,11 @@ static const struct cmsg_hop sql_route[] = {
 	{ net_send_msg, NULL },
 };
 
+static const struct cmsg_hop cursor_route[] = {
+	{ tx_process_cursor, &net_pipe },
+	{ net_send_msg, NULL },
+};
+
 static const struct cmsg_hop *dml_route[IPROTO_TYPE_STAT_MAX] = {
 	NULL,                                   /* IPROTO_OK */
 	select_route,                           /* IPROTO_SELECT */
@@ -1018,6 +1524,16 @@ static const struct cmsg_hop error_route[] = {
 	{ net_send_error, NULL },
 };
 
+/**
+ * Route of any stream message: the message is processed by its
+ * original route hops, saved in iproto_msg::stream_route, but
+ * in order with other messages of the stream.
+ */
+static const struct cmsg_hop stream_route[] = {
+	{ tx_process_stream, &net_pipe },
+	{ net_send_stream_msg, NULL },
+};
+
 static void
 iproto_msg_decode(struct iproto_msg *msg, const char **pos, const char *reqend,
 		  bool *stop_input)
@@ -1064,11 +1580,16 @@ iproto_msg_decode(struct iproto_msg *msg, const char **pos, const char *reqend,
 		cmsg_init(&msg->base, misc_route);
 		break;
 	case IPROTO_JOIN:
-		cmsg_init(&msg->base, join_route);
-		*stop_input = true;
-		break;
+	case IPROTO_JOIN_STREAM:
 	case IPROTO_SUBSCRIBE:
-		cmsg_init(&msg->base, subscribe_route);
+		/*
+		 * The relay writes to the socket directly,
+		 * bypassing the connection output buffers.
+		 * On a compressed connection it continues the
+		 * connection zstd streams.
+		 */
+		cmsg_init(&msg->base, type == IPROTO_SUBSCRIBE ?
+			  subscribe_route : join_route);
 		*stop_input = true;
 		break;
 	case IPROTO_REQUEST_VOTE:
@@ -1079,18 +1600,70 @@ iproto_msg_decode(struct iproto_msg *msg, const char **pos, const char *reqend,
 			goto error;
 		cmsg_init(&msg->base, misc_route);
 		break;
+	case IPROTO_BEGIN:
+	case IPROTO_COMMIT:
+	case IPROTO_ROLLBACK:
+		if (msg->header.stream_id == 0) {
+			diag_set(ClientError, ER_UNABLE_PROCESS_OUT_OF_STREAM,
+				 iproto_type_name(type));
+			goto error;
+		}
+		cmsg_init(&msg->base, misc_route);
+		break;
+	case IPROTO_CURSOR_OPEN:
+		if (xrow_decode_dml(&msg->header, &msg->dml,
+				    iproto_key_bit(IPROTO_SPACE_ID)))
+			goto error;
+		cmsg_init(&msg->base, cursor_route);
+		break;
+	case IPROTO_CURSOR_FETCH:
+	case IPROTO_CURSOR_CLOSE:
+		if (xrow_decode_cursor(&msg->header, &msg->cursor))
+			goto error;
+		cmsg_init(&msg->base, cursor_route);
+		break;
+	case IPROTO_COMPRESS:
+		if (msg->connection->zstd.cstream != NULL) {
+			diag_set(ClientError, ER_PROTOCOL,
+				 "Compression is already enabled");
+			goto error;
+		}
+		msg->is_compression_accepted = false;
+		cmsg_init(&msg->base, compress_route);
+		break;
 	default:
 		diag_set(ClientError, ER_UNKNOWN_REQUEST_TYPE,
 			 (uint32_t) type);
 		goto error;
 	}
-	return;
+	goto stream;
 error:
 	/** Log and send the error. */
 	diag_log();
 	diag_create(&msg->diag);
 	diag_move(&fiber()->diag, &msg->diag);
 	cmsg_init(&msg->base, error_route);
+stream:
+	/*
+	 * JOIN and SUBSCRIBE take over the connection, so there
+	 * is no point in ordering them within a stream.
+	 */
+	if (msg->header.stream_id == 0 ||
+	    iproto_type_is_sync(msg->header.type))
+		return;
+	msg->stream = iproto_connection_stream(msg->connection,
+					       msg->header.stream_id);
+	if (msg->stream == NULL) {
+		diag_log();
+		if (msg->base.route != error_route) {
+			diag_create(&msg->diag);
+			diag_move(&fiber()->diag, &msg->diag);
+			cmsg_init(&msg->base, error_route);
+		}
+		return;
+	}
+	msg->stream_route = msg->base.route;
+	cmsg_init(&msg->base, stream_route);
 }
 
 static void
@@ -1111,6 +1684,234 @@ tx_fiber_init(struct session *session, uint64_t sync)
 	fiber_set_user(fiber(), &session->credentials);
 }
 
+/* {{{ iproto_cursor - methods */
+
+static void
+iproto_cursor_delete(struct iproto_cursor *cursor)
+{
+	assert(!cursor->is_busy);
+	struct mh_i64ptr_t *cursors = cursor->connection->tx.cursors;
+	mh_int_t pos = mh_i64ptr_find(cursors, cursor->id, NULL);
+	assert(pos != mh_end(cursors));
+	mh_i64ptr_del(cursors, pos, NULL);
+	rlist_del_entry(cursor, in_lru);
+	iterator_delete(cursor->it);
+	assert(iproto_cursor_mem_used >= cursor->mem_used);
+	iproto_cursor_mem_used -= cursor->mem_used;
+	mempool_free(&iproto_cursor_pool, cursor);
+}
+
+static int
+iproto_cursor_gc_f(va_list)
+{
+	while (!fiber_is_cancelled()) {
+		double timeout = iproto_cursor_timeout;
+		double now = ev_monotonic_now(loop());
+		double delay = timeout;
+		struct iproto_cursor *cursor, *tmp;
+		rlist_foreach_entry_safe(cursor, &iproto_cursors,
+					 in_lru, tmp) {
+			if (cursor->last_used + timeout > now) {
+				delay = cursor->last_used + timeout - now;
+				break;
+			}
+			if (cursor->is_busy)
+				continue;
+			say_warn("closing cursor %llu, idle for %.1f sec",
+				 (unsigned long long) cursor->id,
+				 now - cursor->last_used);
+			iproto_cursor_delete(cursor);
+		}
+		fiber_sleep(delay);
+	}
+	return 0;
+}
+
+/** Mark a cursor used, postponing its idle timeout. */
+static inline void
+iproto_cursor_touch(struct iproto_cursor *cursor)
+{
+	cursor->last_used = ev_monotonic_now(loop());
+	rlist_move_tail_entry(&iproto_cursors, cursor, in_lru);
+}
+
+/**
+ * Open a cursor for a CURSOR_OPEN request and position it
+ * after @a request->offset tuples.
+ */
+static struct iproto_cursor *
+iproto_cursor_new(struct iproto_connection *con,
+		  const struct request *request)
+{
+	if (con->tx.cursors == NULL) {
+		con->tx.cursors = mh_i64ptr_new();
+		if (con->tx.cursors == NULL) {
+			diag_set(OutOfMemory, sizeof(*con->tx.cursors),
+				 "mh_i64ptr_new", "cursors");
+			return NULL;
+		}
+	}
+	if (mh_size(con->tx.cursors) >= (uint32_t) iproto_cursor_max) {
+		diag_set(ClientError, ER_CURSOR_LIMIT,
+			 tt_sprintf("net_cursor_max is %d",
+				    iproto_cursor_max));
+		return NULL;
+	}
+	if (iproto_cursor_mem_used + sizeof(struct iproto_cursor) >
+	    iproto_cursor_memory) {
+		diag_set(ClientError, ER_CURSOR_LIMIT,
+			 tt_sprintf("net_cursor_memory is %zu bytes",
+				    iproto_cursor_memory));
+		return NULL;
+	}
+	struct iproto_cursor *cursor = (struct iproto_cursor *)
+		mempool_alloc(&iproto_cursor_pool);
+	if (cursor == NULL) {
+		diag_set(OutOfMemory, sizeof(*cursor), "mempool_alloc",
+			 "cursor");
+		return NULL;
+	}
+	/* An empty key, if the request has none. */
+	const char *key = "\x90";
+	const char *key_end = key + 1;
+	if (request->key != NULL) {
+		key = request->key;
+		key_end = request->key_end;
+	}
+	cursor->it = box_index_iterator(request->space_id,
+					request->index_id,
+					request->iterator, key, key_end);
+	if (cursor->it == NULL)
+		goto fail;
+	for (uint32_t i = 0; i < request->offset; i++) {
+		struct tuple *tuple;
+		if (iterator_next(cursor->it, &tuple) != 0)
+			goto fail_it;
+		if (tuple == NULL)
+			break;
+	}
+	cursor->id = ++con->tx.last_cursor_id;
+	cursor->connection = con;
+	cursor->is_busy = false;
+	cursor->last_used = ev_monotonic_now(loop());
+	cursor->mem_used = sizeof(*cursor);
+	struct mh_i64ptr_node_t node;
+	node.key = cursor->id;
+	node.val = cursor;
+	if (mh_i64ptr_put(con->tx.cursors, &node, NULL, NULL) ==
+	    mh_end(con->tx.cursors)) {
+		diag_set(OutOfMemory, sizeof(node), "mh_i64ptr_put",
+			 "mh_i64ptr_node_t");
+		goto fail_it;
+	}
+	rlist_add_tail_entry(&iproto_cursors, cursor, in_lru);
+	iproto_cursor_mem_used += cursor->mem_used;
+	if (iproto_cursor_gc_fiber == NULL) {
+		iproto_cursor_gc_fiber = fiber_new("iproto_cursor_gc",
+						   iproto_cursor_gc_f);
+		if (iproto_cursor_gc_fiber != NULL)
+			fiber_start(iproto_cursor_gc_fiber);
+		else
+			diag_log();
+	}
+	return cursor;
+fail_it:
+	iterator_delete(cursor->it);
+fail:
+	mempool_free(&iproto_cursor_pool, cursor);
+	return NULL;
+}
+
+/** Find an open cursor of the connection by id. */
+static struct iproto_cursor *
+iproto_cursor_find(struct iproto_connection *con, uint64_t cursor_id)
+{
+	struct mh_i64ptr_t *cursors = con->tx.cursors;
+	mh_int_t pos;
+	if (cursors == NULL ||
+	    (pos = mh_i64ptr_find(cursors, cursor_id, NULL)) ==
+	    mh_end(cursors)) {
+		diag_set(ClientError, ER_NO_SUCH_CURSOR,
+			 (unsigned long long) cursor_id);
+		return NULL;
+	}
+	struct iproto_cursor *cursor = (struct iproto_cursor *)
+		mh_i64ptr_node(cursors, pos)->val;
+	if (cursor->is_busy) {
+		diag_set(ClientError, ER_PROTOCOL,
+			 "Cursor is busy with another request");
+		return NULL;
+	}
+	return cursor;
+}
+
+/**
+ * Read up to @a limit tuples from a cursor into @a port. The
+ * cursor is closed once it is exhausted, so the client knows
+ * the cursor is gone when it gets less tuples than requested.
+ */
+static int
+iproto_cursor_fetch(struct iproto_cursor *cursor, uint32_t limit,
+		    struct port *port)
+{
+	port_tuple_create(port);
+	cursor->is_busy = true;
+	int rc = 0;
+	uint32_t count = 0;
+	struct tuple *last = NULL;
+	while (count < limit) {
+		struct tuple *tuple;
+		rc = iterator_next(cursor->it, &tuple);
+		if (rc != 0 || tuple == NULL)
+			break;
+		rc = port_tuple_add(port, tuple);
+		if (rc != 0)
+			break;
+		last = tuple;
+		count++;
+	}
+	cursor->is_busy = false;
+	if (rc != 0) {
+		port_destroy(port);
+		return -1;
+	}
+	if (count < limit) {
+		iproto_cursor_delete(cursor);
+		return 0;
+	}
+	if (last != NULL) {
+		iproto_cursor_mem_used -= cursor->mem_used;
+		cursor->mem_used = sizeof(*cursor) + tuple_size(last);
+		iproto_cursor_mem_used += cursor->mem_used;
+	}
+	iproto_cursor_touch(cursor);
+	return 0;
+}
+
+/** Close all cursors of a connection. */
+static void
+iproto_connection_delete_cursors(struct iproto_connection *con)
+{
+	struct mh_i64ptr_t *cursors = con->tx.cursors;
+	if (cursors == NULL)
+		return;
+	mh_int_t i;
+	mh_foreach(cursors, i) {
+		struct iproto_cursor *cursor = (struct iproto_cursor *)
+			mh_i64ptr_node(cursors, i)->val;
+		assert(!cursor->is_busy);
+		rlist_del_entry(cursor, in_lru);
+		iterator_delete(cursor->it);
+		assert(iproto_cursor_mem_used >= cursor->mem_used);
+		iproto_cursor_mem_used -= cursor->mem_used;
+		mempool_free(&iproto_cursor_pool, cursor);
+	}
+	mh_i64ptr_delete(cursors);
+	con->tx.cursors = NULL;
+}
+
+/* }}} iproto_cursor */
+
 /**
  * Fire on_disconnect triggers in the tx
  * thread and destroy the session object,
@@ -1121,6 +1922,22 @@ tx_process_disconnect(struct cmsg *m)
 {
 	struct iproto_connection *con =
 		container_of(m, struct iproto_connection, disconnect);
+	/*
+	 * Roll back transactions left open in streams. The
+	 * network thread never deletes a stream with an open
+	 * transaction, so the streams are still alive.
+	 */
+	while (!rlist_empty(&con->tx.streams)) {
+		struct iproto_stream *stream =
+			rlist_first_entry(&con->tx.streams,
+					  struct iproto_stream,
+					  tx.in_connection);
+		stream->tx.is_closed = true;
+		fiber_wakeup(stream->tx.fiber);
+		while (stream->tx.fiber != NULL)
+			fiber_cond_wait(&stream->tx.cond);
+	}
+	iproto_connection_delete_cursors(con);
 	if (con->session) {
 		tx_fiber_init(con->session, 0);
 		/*
@@ -1226,9 +2043,25 @@ tx_accept_msg(struct cmsg *m)
 		 */
 		con->tx.p_obuf = prev;
 	}
+	msg->accept_time = clock_monotonic();
+	msg->wal_time = 0;
+	fiber_set_key(fiber(), FIBER_KEY_WAL_TIME, &msg->wal_time);
 	return msg;
 }
 
+/**
+ * Mark the end of the reply to a message in the output buffer
+ * and stop accounting WAL writes of the current fiber in the
+ * message latency.
+ */
+static inline void
+tx_end_msg(struct iproto_msg *msg, struct obuf *out)
+{
+	iproto_wpos_create(&msg->wpos, out);
+	msg->reply_time = clock_monotonic();
+	fiber_set_key(fiber(), FIBER_KEY_WAL_TIME, NULL);
+}
+
 /**
  * Write error message to the output buffer and advance
  * write position. Doesn't throw.
@@ -1239,7 +2072,7 @@ tx_reply_error(struct iproto_msg *msg)
 	struct obuf *out = msg->connection->tx.p_obuf;
 	iproto_reply_error(out, diag_last_error(&fiber()->diag),
 			   msg->header.sync, ::schema_version);
-	iproto_wpos_create(&msg->wpos, out);
+	tx_end_msg(msg, out);
 }
 
 /**
@@ -1253,7 +2086,7 @@ tx_reply_iproto_error(struct cmsg *m)
 	struct obuf *out = msg->connection->tx.p_obuf;
 	iproto_reply_error(out, diag_last_error(&msg->diag),
 			   msg->header.sync, ::schema_version);
-	iproto_wpos_create(&msg->wpos, out);
+	tx_end_msg(msg, out);
 }
 
 /** Inject a short delay on tx request processing for testing. */
@@ -1288,7 +2121,7 @@ tx_process1(struct cmsg *m)
 		goto error;
 	iproto_reply_select(out, &svp, msg->header.sync, ::schema_version,
 			    tuple != 0);
-	iproto_wpos_create(&msg->wpos, out);
+	tx_end_msg(msg, out);
 	return;
 error:
 	tx_reply_error(msg);
@@ -1304,16 +2137,26 @@ tx_process_select(struct cmsg *m)
 	int count;
 	int rc;
 	struct request *req = &msg->dml;
+	struct tuple_filter *filter = NULL;
+	struct region *gc = &fiber()->gc;
+	size_t gc_svp = region_used(gc);
 
 	tx_fiber_init(msg->connection->session, msg->header.sync);
 
 	if (tx_check_schema(msg->header.schema_version))
 		goto error;
 
+	if (req->filter != NULL) {
+		filter = tuple_filter_new(gc, req->filter, req->filter_end,
+					  req->index_base);
+		if (filter == NULL)
+			goto error;
+	}
 	tx_inject_delay();
 	rc = box_select(req->space_id, req->index_id,
 			req->iterator, req->offset, req->limit,
-			req->key, req->key_end, &port);
+			req->key, req->key_end, filter, false, &port);
+	region_truncate(gc, gc_svp);
 	if (rc < 0)
 		goto error;
 
@@ -1334,7 +2177,73 @@ tx_process_select(struct cmsg *m)
 	}
 	iproto_reply_select(out, &svp, msg->header.sync,
 			    ::schema_version, count);
-	iproto_wpos_create(&msg->wpos, out);
+	tx_end_msg(msg, out);
+	return;
+error:
+	tx_reply_error(msg);
+}
+
+static void
+tx_process_cursor(struct cmsg *m)
+{
+	struct iproto_msg *msg = tx_accept_msg(m);
+	struct iproto_connection *con = msg->connection;
+	struct obuf *out = con->tx.p_obuf;
+	struct iproto_cursor *cursor;
+	struct obuf_svp svp;
+	struct port port;
+	int count;
+
+	tx_fiber_init(con->session, msg->header.sync);
+
+	if (tx_check_schema(msg->header.schema_version))
+		goto error;
+
+	switch (msg->header.type) {
+	case IPROTO_CURSOR_OPEN:
+		cursor = iproto_cursor_new(con, &msg->dml);
+		if (cursor == NULL)
+			goto error;
+		if (iproto_reply_cursor(out, msg->header.sync,
+					::schema_version, cursor->id) != 0) {
+			iproto_cursor_delete(cursor);
+			goto error;
+		}
+		break;
+	case IPROTO_CURSOR_FETCH:
+		cursor = iproto_cursor_find(con, msg->cursor.cursor_id);
+		if (cursor == NULL)
+			goto error;
+		if (iproto_cursor_fetch(cursor, msg->cursor.limit,
+					&port) != 0)
+			goto error;
+		if (iproto_prepare_select(out, &svp) != 0) {
+			port_destroy(&port);
+			goto error;
+		}
+		count = port_dump_16(&port, out);
+		port_destroy(&port);
+		if (count < 0) {
+			/* Discard the prepared select. */
+			obuf_rollback_to_svp(out, &svp);
+			goto error;
+		}
+		iproto_reply_select(out, &svp, msg->header.sync,
+				    ::schema_version, count);
+		break;
+	case IPROTO_CURSOR_CLOSE:
+		cursor = iproto_cursor_find(con, msg->cursor.cursor_id);
+		if (cursor == NULL)
+			goto error;
+		iproto_cursor_delete(cursor);
+		if (iproto_reply_ok(out, msg->header.sync,
+				    ::schema_version) != 0)
+			goto error;
+		break;
+	default:
+		unreachable();
+	}
+	tx_end_msg(msg, out);
 	return;
 error:
 	tx_reply_error(msg);
@@ -1426,7 +2335,7 @@ tx_process_call(struct cmsg *m)
 
 	iproto_reply_select(out, &svp, msg->header.sync,
 			    ::schema_version, count);
-	iproto_wpos_create(&msg->wpos, out);
+	tx_end_msg(msg, out);
 	return;
 error:
 	tx_reply_error(msg);
@@ -1460,10 +2369,38 @@ tx_process_misc(struct cmsg *m)
 						     &replicaset.vclock,
 						     cfg_geti("read_only"));
 			break;
+		case IPROTO_BEGIN:
+			if (box_txn_begin() != 0)
+				diag_raise();
+			/*
+			 * The stream fiber yields waiting for the
+			 * next request of the transaction.
+			 */
+			in_txn()->can_yield = true;
+			iproto_reply_ok_xc(out, msg->header.sync,
+					   ::schema_version);
+			break;
+		case IPROTO_COMMIT:
+			if (box_txn_commit() != 0)
+				diag_raise();
+			iproto_reply_ok_xc(out, msg->header.sync,
+					   ::schema_version);
+			break;
+		case IPROTO_ROLLBACK:
+			if (box_txn_rollback() != 0)
+				diag_raise();
+			iproto_reply_ok_xc(out, msg->header.sync,
+					   ::schema_version);
+			break;
+		case IPROTO_COMPRESS:
+			iproto_reply_ok_xc(out, msg->header.sync,
+					   ::schema_version);
+			msg->is_compression_accepted = true;
+			break;
 		default:
 			unreachable();
 		}
-		iproto_wpos_create(&msg->wpos, out);
+		tx_end_msg(msg, out);
 	} catch (Exception *e) {
 		tx_reply_error(msg);
 	}
@@ -1494,20 +2431,60 @@ tx_process_sql(struct cmsg *m)
 	out = msg->connection->tx.p_obuf;
 	if (sql_response_dump(&response, out) != 0)
 		goto error;
-	iproto_wpos_create(&msg->wpos, out);
+	tx_end_msg(msg, out);
 	return;
 error:
 	tx_reply_error(msg);
 }
 
+/**
+ * Like iproto_write_error(), but continues the compressed
+ * output of the connection. Errors are ignored.
+ */
+static void
+tx_write_error_zstd(struct ev_io *io, struct xrow_zstd *zstd,
+		    const struct error *e, uint64_t sync)
+{
+	struct obuf out;
+	obuf_create(&out, &cord()->slabc, 256);
+	if (iproto_reply_error(&out, e, sync, ::schema_version) == 0) {
+		try {
+			coio_writev_zstd(io, zstd, out.iov,
+					 obuf_iovcnt(&out), obuf_size(&out));
+		} catch (Exception *) {
+		}
+	}
+	obuf_destroy(&out);
+}
+
 static void
 tx_process_join_subscribe(struct cmsg *m)
 {
 	struct iproto_msg *msg = tx_accept_msg(m);
 	struct iproto_connection *con = msg->connection;
+	/* Replication requests are not accounted in latency. */
+	fiber_set_key(fiber(), FIBER_KEY_WAL_TIME, NULL);
 
 	tx_fiber_init(con->session, msg->header.sync);
 
+	/*
+	 * The input is stopped and the output is flushed while
+	 * the request is processed, so the network thread does
+	 * not touch the zstd streams of the connection until
+	 * the watchers are re-activated.
+	 */
+	struct xrow_zstd zstd_buf;
+	struct xrow_zstd *zstd = NULL;
+	if (con->zstd.cstream != NULL) {
+		xrow_zstd_create(&zstd_buf, con->zstd.cstream,
+				 con->zstd.dstream);
+		zstd = &zstd_buf;
+	}
+	auto zstd_guard = make_scoped_guard([=] {
+		if (zstd != NULL)
+			xrow_zstd_destroy(zstd);
+	});
+
 	try {
 		switch (msg->header.type) {
 		case IPROTO_JOIN:
@@ -1516,7 +2493,11 @@ tx_process_join_subscribe(struct cmsg *m)
 			 * the lambda in the beginning of the block
 			 * will re-activate the watchers for us.
 			 */
-			box_process_join(&con->input, &msg->header);
+			box_process_join(&con->input, zstd, &msg->header);
+			break;
+		case IPROTO_JOIN_STREAM:
+			box_process_join_stream(&con->input, zstd,
+						&msg->header);
 			break;
 		case IPROTO_SUBSCRIBE:
 			/*
@@ -1525,7 +2506,7 @@ tx_process_join_subscribe(struct cmsg *m)
 			 * the write watcher will be re-activated
 			 * the same way as for JOIN.
 			 */
-			box_process_subscribe(&con->input, &msg->header);
+			box_process_subscribe(&con->input, zstd, &msg->header);
 			break;
 		default:
 			unreachable();
@@ -1533,17 +2514,164 @@ tx_process_join_subscribe(struct cmsg *m)
 	} catch (SocketError *e) {
 		throw; /* don't write error response to prevent SIGPIPE */
 	} catch (Exception *e) {
-		iproto_write_error(con->input.fd, e, ::schema_version,
-				   msg->header.sync);
+		if (zstd == NULL) {
+			iproto_write_error(con->input.fd, e, ::schema_version,
+					   msg->header.sync);
+			return;
+		}
+		tx_write_error_zstd(&con->input, zstd, e, msg->header.sync);
 	}
 }
 
+/**
+ * Main function of a fiber running an interactive transaction
+ * of a stream. The fiber processes messages of the stream
+ * handed over to it by tx_process_stream() until the
+ * transaction ends.
+ */
+static int
+tx_stream_f(va_list ap)
+{
+	struct iproto_stream *stream = va_arg(ap, struct iproto_stream *);
+	/*
+	 * Requests must not be aborted half-way by a stray
+	 * fiber.kill(): the fiber ends along with the
+	 * transaction.
+	 */
+	fiber_set_cancellable(false);
+	while (true) {
+		struct iproto_msg *msg = stream->tx.msg;
+		if (msg == NULL) {
+			if (stream->tx.is_closed) {
+				/* The client is gone. */
+				txn_rollback();
+				break;
+			}
+			fiber_yield();
+			continue;
+		}
+		uint32_t type = msg->header.type;
+		/*
+		 * The transaction may have been aborted while the
+		 * fiber was waiting for the next request. Fail all
+		 * requests but ROLLBACK until the client ends the
+		 * transaction.
+		 */
+		bool is_aborted = stream->tx.txn_id >= 0 &&
+				  box_txn_id() != stream->tx.txn_id;
+		if (is_aborted && type != IPROTO_ROLLBACK) {
+			tx_accept_msg(&msg->base);
+			diag_set(ClientError, ER_TRANSACTION_YIELD);
+			tx_reply_error(msg);
+		} else {
+			msg->stream_route[0].f(&msg->base);
+		}
+		if (is_aborted ? (type == IPROTO_COMMIT ||
+				  type == IPROTO_ROLLBACK) : !box_txn())
+			break;
+		if (!is_aborted)
+			stream->tx.txn_id = box_txn_id();
+		stream->tx.msg = NULL;
+		fiber_cond_signal(&stream->tx.cond);
+	}
+	stream->tx.fiber = NULL;
+	stream->tx.msg = NULL;
+	stream->tx.txn_id = -1;
+	rlist_del_entry(stream, tx.in_connection);
+	fiber_cond_signal(&stream->tx.cond);
+	return 0;
+}
+
+/**
+ * Process a stream message. The network thread guarantees
+ * that only one message of a stream is processed at a time.
+ * A message which starts a transaction, as well as all
+ * subsequent messages of the stream until the transaction
+ * ends, are processed in a dedicated fiber, since
+ * a transaction is bound to the fiber it was started in.
+ * Other messages are processed in the current fiber.
+ */
+static void
+tx_process_stream(struct cmsg *m)
+{
+	struct iproto_msg *msg = (struct iproto_msg *) m;
+	struct iproto_stream *stream = msg->stream;
+	assert(stream->tx.msg == NULL);
+	msg->is_stream_in_txn = false;
+	if (stream->tx.fiber == NULL && msg->header.type != IPROTO_BEGIN) {
+		msg->stream_route[0].f(m);
+		return;
+	}
+	stream->tx.msg = msg;
+	if (stream->tx.fiber == NULL) {
+		char name[FIBER_NAME_MAX];
+		snprintf(name, sizeof(name), "stream %llu",
+			 (unsigned long long) stream->id);
+		struct fiber *f = fiber_new(name, tx_stream_f);
+		if (f == NULL) {
+			stream->tx.msg = NULL;
+			tx_accept_msg(m);
+			tx_reply_error(msg);
+			return;
+		}
+		stream->tx.fiber = f;
+		rlist_add_tail_entry(&msg->connection->tx.streams, stream,
+				     tx.in_connection);
+		fiber_start(f, stream);
+	} else {
+		fiber_wakeup(stream->tx.fiber);
+	}
+	while (stream->tx.msg != NULL)
+		fiber_cond_wait(&stream->tx.cond);
+	msg->is_stream_in_txn = stream->tx.fiber != NULL;
+}
+
+/**
+ * Create a latency counter with no observations. Unlike
+ * latency_create() and latency_reset(), which collect a zero
+ * to make a percentile of an empty counter zero, it doesn't
+ * skew the percentiles, but they must not be read while the
+ * counter is empty.
+ */
+static int
+iproto_latency_create(struct latency *latency)
+{
+	if (latency_create(latency) != 0)
+		return -1;
+	histogram_discard(latency->histogram, 0);
+	return 0;
+}
+
+/** Account latency of a message which reply is complete. */
+static void
+net_collect_latency(struct iproto_msg *msg)
+{
+	uint32_t type = msg->header.type;
+	if (msg->reply_time == 0 || type >= IPROTO_LATENCY_TYPE_MAX)
+		return;
+	struct latency *latency = iproto_latency[type];
+	if (latency[0].histogram == NULL)
+		return;
+	double now = clock_monotonic();
+	double tx_time = msg->reply_time - msg->accept_time;
+	double wal_time = MIN(msg->wal_time, tx_time);
+	latency_collect(&latency[IPROTO_LATENCY_QUEUE],
+			msg->accept_time - msg->recv_time);
+	latency_collect(&latency[IPROTO_LATENCY_TX], tx_time - wal_time);
+	latency_collect(&latency[IPROTO_LATENCY_WAL], wal_time);
+	latency_collect(&latency[IPROTO_LATENCY_REPLY],
+			now - msg->reply_time);
+	latency_collect(&latency[IPROTO_LATENCY_TOTAL],
+			now - msg->recv_time);
+}
+
 static void
 net_send_msg(struct cmsg *m)
 {
 	struct iproto_msg *msg = (struct iproto_msg *) m;
 	struct iproto_connection *con = msg->connection;
 
+	net_collect_latency(msg);
 	if (msg->len != 0) {
 		/* Discard request (see iproto_enqueue_batch()). */
 		msg->p_ibuf->rpos += msg->len;
@@ -1576,6 +2704,65 @@ net_send_error(struct cmsg *m)
 	net_send_msg(m);
 }
 
+/**
+ * Complete a stream message and send the next message of the
+ * stream, if any, to the tx thread.
+ */
+static void
+net_send_stream_msg(struct cmsg *m)
+{
+	struct iproto_msg *msg = (struct iproto_msg *) m;
+	struct iproto_stream *stream = msg->stream;
+	assert(stream->current == msg);
+	if (!stailq_empty(&stream->pending)) {
+		stream->current = stailq_shift_entry(&stream->pending,
+						     struct iproto_msg,
+						     in_stream);
+		cpipe_push(&tx_pipe, &stream->current->base);
+	} else {
+		stream->current = NULL;
+		/* Keep the stream while its transaction is open. */
+		if (!msg->is_stream_in_txn)
+			iproto_stream_delete(stream);
+	}
+	msg->stream_route[1].f(m);
+}
+
+/**
+ * Switch the connection to compressed wire format once the
+ * COMPRESS reply is in the output. The reply itself and all
+ * output before it are still sent raw, @sa iproto_flush().
+ * The peer must not send anything after COMPRESS until it
+ * receives the reply, so the input switches right away.
+ */
+static void
+net_send_compress(struct cmsg *m)
+{
+	struct iproto_msg *msg = (struct iproto_msg *) m;
+	struct iproto_connection *con = msg->connection;
+	if (msg->is_compression_accepted && evio_has_fd(&con->output)) {
+		assert(con->zstd.cstream == NULL);
+		con->zstd.cstream = ZSTD_createCStream();
+		con->zstd.dstream = ZSTD_createDStream();
+		if (con->zstd.cstream == NULL || con->zstd.dstream == NULL ||
+		    ZSTD_isError(ZSTD_initCStream(con->zstd.cstream, 1)) ||
+		    ZSTD_isError(ZSTD_initDStream(con->zstd.dstream))) {
+			/*
+			 * The peer has been promised compression,
+			 * there is no way back.
+			 */
+			say_error("failed to enable compression on "
+				  "connection %s",
+				  sio_socketname(con->input.fd));
+			iproto_connection_close(con);
+		} else {
+			con->zstd.raw_end = msg->wpos;
+			con->zstd.is_pending = true;
+		}
+	}
+	net_send_msg(m);
+}
+
 static void
 net_end_join(struct cmsg *m)
 {
@@ -1713,6 +2900,7 @@ iproto_on_accept(struct evio_service * /* service */, int fd,
 	cpipe_push(&tx_pipe, &msg->base);
 	return;
 error_msg:
+	mh_i64ptr_delete(con->streams);
 	mempool_free(&iproto_connection_pool, con);
 error_conn:
 	close(fd);
@@ -1732,6 +2920,8 @@ net_cord_f(va_list /* ap */)
 		       sizeof(struct iproto_msg));
 	mempool_create(&iproto_connection_pool, &cord()->slabc,
 		       sizeof(struct iproto_connection));
+	mempool_create(&iproto_stream_pool, &cord()->slabc,
+		       sizeof(struct iproto_stream));
 
 	evio_service_init(loop(), &binary, "binary",
 			  iproto_on_accept, NULL);
@@ -1744,6 +2934,17 @@ net_cord_f(va_list /* ap */)
 		tnt_raise(OutOfMemory, sizeof(struct rmean),
 			  "rmean", "struct rmean");
 	}
+	for (uint32_t type = 0; type < IPROTO_LATENCY_TYPE_MAX; type++) {
+		if (iproto_type_name(type) == NULL)
+			continue;
+		struct latency *latency = iproto_latency[type];
+		for (int i = 0; i < iproto_latency_phase_MAX; i++) {
+			if (iproto_latency_create(&latency[i]) != 0) {
+				tnt_raise(OutOfMemory, sizeof(struct histogram),
+					  "malloc", "struct histogram");
+			}
+		}
+	}
 
 	struct cbus_endpoint endpoint;
 	/* Create "net" endpoint. */
@@ -1764,6 +2965,13 @@ net_cord_f(va_list /* ap */)
 		evio_service_stop(&binary);
 
 	rmean_delete(rmean_net);
+	for (uint32_t type = 0; type < IPROTO_LATENCY_TYPE_MAX; type++) {
+		struct latency *latency = iproto_latency[type];
+		if (latency[0].histogram == NULL)
+			continue;
+		for (int i = 0; i < iproto_latency_phase_MAX; i++)
+			latency_destroy(&latency[i]);
+	}
 	return 0;
 }
 
@@ -1776,6 +2984,22 @@ iproto_init()
 	if (cord_costart(&net_cord, "iproto", net_cord_f, NULL))
 		panic("failed to initialize iproto thread");
 
+	mempool_create(&iproto_cursor_pool, &cord()->slabc,
+		       sizeof(struct iproto_cursor));
+
+	latch_create(&iproto_latency_latch);
+	for (uint32_t type = 0; type < IPROTO_LATENCY_TYPE_MAX; type++) {
+		if (iproto_type_name(type) == NULL)
+			continue;
+		struct latency *latency = iproto_latency_snapshot[type];
+		for (int i = 0; i < iproto_latency_phase_MAX; i++) {
+			if (iproto_latency_create(&latency[i]) != 0) {
+				panic("failed to allocate iproto latency "
+				      "statistics");
+			}
+		}
+	}
+
 	/* Create a pipe to "net" thread. */
 	cpipe_create(&net_pipe, "net");
 	cpipe_set_max_input(&net_pipe, iproto_msg_max / 2);
@@ -1879,10 +3103,78 @@ iproto_mem_used(void)
 	return slab_cache_used(&net_cord.slabc) + slab_cache_used(&net_slabc);
 }
 
+/** Reset latency counters in the network thread. */
+static int
+iproto_reset_latency_f(struct cbus_call_msg *m)
+{
+	(void)m;
+	for (uint32_t type = 0; type < IPROTO_LATENCY_TYPE_MAX; type++) {
+		struct latency *latency = iproto_latency[type];
+		if (latency[0].histogram == NULL)
+			continue;
+		for (int i = 0; i < iproto_latency_phase_MAX; i++)
+			histogram_reset(latency[i].histogram);
+	}
+	return 0;
+}
+
+/** Copy latency counters to the snapshot in the network thread. */
+static int
+iproto_snapshot_latency_f(struct cbus_call_msg *m)
+{
+	(void)m;
+	for (uint32_t type = 0; type < IPROTO_LATENCY_TYPE_MAX; type++) {
+		struct latency *latency = iproto_latency[type];
+		struct latency *snapshot = iproto_latency_snapshot[type];
+		if (latency[0].histogram == NULL)
+			continue;
+		for (int i = 0; i < iproto_latency_phase_MAX; i++) {
+			histogram_copy(snapshot[i].histogram,
+				       latency[i].histogram);
+		}
+	}
+	return 0;
+}
+
+/**
+ * Run a function on latency counters in the network thread,
+ * which is the one updating them.
+ */
+static void
+iproto_latency_call(cbus_call_f func)
+{
+	struct cbus_call_msg msg;
+	/* The message is on stack, wait for it to complete. */
+	bool cancellable = fiber_set_cancellable(false);
+	cbus_call(&net_pipe, &tx_pipe, &msg, func, NULL, TIMEOUT_INFINITY);
+	fiber_set_cancellable(cancellable);
+}
+
 void
 iproto_reset_stat(void)
 {
 	rmean_cleanup(rmean_net);
+	iproto_latency_call(iproto_reset_latency_f);
+}
+
+int
+iproto_latency_foreach(iproto_latency_cb cb, void *cb_ctx)
+{
+	latch_lock(&iproto_latency_latch);
+	iproto_latency_call(iproto_snapshot_latency_f);
+	int rc = 0;
+	for (uint32_t type = 0; type < IPROTO_LATENCY_TYPE_MAX; type++) {
+		struct latency *latency = iproto_latency_snapshot[type];
+		/* Percentiles of an empty counter are meaningless. */
+		if (latency[0].histogram == NULL ||
+		    latency[IPROTO_LATENCY_TOTAL].histogram->total == 0)
+			continue;
+		rc = cb(iproto_type_name(type), latency, cb_ctx);
+		if (rc != 0)
+			break;
+	}
+	latch_unlock(&iproto_latency_latch);
+	return rc;
 }
 
 void
@@ -1899,3 +3191,24 @@ iproto_set_msg_max(int new_iproto_msg_max)
 	iproto_do_cfg(&cfg_msg);
 	cpipe_set_max_input(&net_pipe, new_iproto_msg_max / 2);
 }
+
+void
+iproto_set_cursor_max(int cursor_max)
+{
+	iproto_cursor_max = cursor_max;
+}
+
+void
+iproto_set_cursor_timeout(double timeout)
+{
+	iproto_cursor_timeout = timeout;
+	/* Let the gc fiber reschedule with the new timeout. */
+	if (iproto_cursor_gc_fiber != NULL)
+		fiber_wakeup(iproto_cursor_gc_fiber);
+}
+
+void
+iproto_set_cursor_memory(size_t memory)
+{
+	iproto_cursor_memory = memory;
+}
@@ -68,6 +68,41 @@ iproto_mem_used(void);
 void
 iproto_reset_stat(void);
 
+struct latency;
+
+/**
+ * Phases of IPROTO request processing, which latency is
+ * accounted separately.
+ */
+enum iproto_latency_phase {
+	/** Waiting in the queue to the tx thread. */
+	IPROTO_LATENCY_QUEUE,
+	/** Processing in the tx thread, except WAL writes. */
+	IPROTO_LATENCY_TX,
+	/** Waiting for WAL writes. */
+	IPROTO_LATENCY_WAL,
+	/** Waiting for the network thread to take the reply. */
+	IPROTO_LATENCY_REPLY,
+	/** From receipt of the request till its reply. */
+	IPROTO_LATENCY_TOTAL,
+	iproto_latency_phase_MAX,
+};
+
+extern const char *iproto_latency_phase_strs[];
+
+typedef int
+(*iproto_latency_cb)(const char *name, struct latency *latency,
+		     void *cb_ctx);
+
+/**
+ * Invoke @a cb for each request type, which was served since
+ * the last statistics reset, with the type name and an array
+ * of iproto_latency_phase_MAX latency counters. Stops and
+ * returns the value returned by @a cb if it is not 0.
+ */
+int
+iproto_latency_foreach(iproto_latency_cb cb, void *cb_ctx);
+
 #if defined(__cplusplus)
 } /* extern "C" */
 
@@ -83,6 +118,15 @@ iproto_listen();
 void
 iproto_set_msg_max(int iproto_msg_max);
 
+void
+iproto_set_cursor_max(int cursor_max);
+
+void
+iproto_set_cursor_timeout(double timeout);
+
+void
+iproto_set_cursor_memory(size_t memory);
+
 #endif /* defined(__cplusplus) */
 
 #endif
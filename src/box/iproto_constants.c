@@ -43,10 +43,13 @@ const unsigned char iproto_key_type[IPROTO_KEY_MAX] =
 		/* 0x07 */	MP_UINT,   /* IPROTO_SERVER_IS_RO */
 	/* }}} */
 
+	/* {{{ header */
+		/* 0x08 */	MP_UINT,   /* IPROTO_TSN */
+		/* 0x09 */	MP_UINT,   /* IPROTO_FLAGS */
+		/* 0x0a */	MP_UINT,   /* IPROTO_STREAM_ID */
+	/* }}} */
+
 	/* {{{ unused */
-		/* 0x08 */	MP_UINT,
-		/* 0x09 */	MP_UINT,
-		/* 0x0a */	MP_UINT,
 		/* 0x0b */	MP_UINT,
 		/* 0x0c */	MP_UINT,
 		/* 0x0d */	MP_UINT,
@@ -61,10 +64,10 @@ const unsigned char iproto_key_type[IPROTO_KEY_MAX] =
 		/* 0x13 */	MP_UINT, /* IPROTO_OFFSET */
 		/* 0x14 */	MP_UINT, /* IPROTO_ITERATOR */
 		/* 0x15 */	MP_UINT, /* IPROTO_INDEX_BASE */
+		/* 0x16 */	MP_UINT, /* IPROTO_CURSOR_ID */
 	/* }}} */
 
 	/* {{{ unused */
-		/* 0x16 */	MP_UINT,
 		/* 0x17 */	MP_UINT,
 		/* 0x18 */	MP_UINT,
 		/* 0x19 */	MP_UINT,
@@ -87,6 +90,10 @@ const unsigned char iproto_key_type[IPROTO_KEY_MAX] =
 	/* 0x27 */	MP_STR, /* IPROTO_EXPR */
 	/* 0x28 */	MP_ARRAY, /* IPROTO_OPS */
 	/* 0x29 */	MP_MAP, /* IPROTO_OPTIONS */
+	/* 0x2a */	MP_ARRAY, /* IPROTO_FILTER */
+	/* 0x2b */	MP_UINT, /* IPROTO_JOIN_STREAM_COUNT */
+	/* 0x2c */	MP_UINT, /* IPROTO_JOIN_STREAM_ID */
+	/* 0x2d */	MP_BOOL, /* IPROTO_JOIN_FILES */
 	/* }}} */
 };
 
@@ -134,9 +141,9 @@ const char *iproto_key_strs[IPROTO_KEY_MAX] = {
 	"schema version",   /* 0x05 */
 	"server version",   /* 0x06 */
 	NULL,               /* 0x07 */
-	NULL,               /* 0x08 */
-	NULL,               /* 0x09 */
-	NULL,               /* 0x0a */
+	"tsn",              /* 0x08 */
+	"flags",            /* 0x09 */
+	"stream id",        /* 0x0a */
 	NULL,               /* 0x0b */
 	NULL,               /* 0x0c */
 	NULL,               /* 0x0d */
@@ -148,7 +155,7 @@ const char *iproto_key_strs[IPROTO_KEY_MAX] = {
 	"offset",           /* 0x13 */
 	"iterator",         /* 0x14 */
 	"index base",       /* 0x15 */
-	NULL,               /* 0x16 */
+	"cursor id",        /* 0x16 */
 	NULL,               /* 0x17 */
 	NULL,               /* 0x18 */
 	NULL,               /* 0x19 */
@@ -168,10 +175,10 @@ const char *iproto_key_strs[IPROTO_KEY_MAX] = {
 	"expression",       /* 0x27 */
 	"operations",       /* 0x28 */
 	"options",          /* 0x29 */
-	NULL,               /* 0x2a */
-	NULL,               /* 0x2b */
-	NULL,               /* 0x2c */
-	NULL,               /* 0x2d */
+	"filter",           /* 0x2a */
+	"join stream count", /* 0x2b */
+	"join stream id",   /* 0x2c */
+	"join files",       /* 0x2d */
 	NULL,               /* 0x2e */
 	NULL,               /* 0x2f */
 	"data",             /* 0x30 */
@@ -60,6 +60,16 @@ enum iproto_key {
 	IPROTO_SCHEMA_VERSION = 0x05,
 	IPROTO_SERVER_VERSION = 0x06,
 	IPROTO_SERVER_IS_RO = 0x07,
+	/**
+	 * Transaction id of a row: the difference between
+	 * the row LSN and the LSN of the first row of the
+	 * transaction. Omitted for single-row transactions.
+	 */
+	IPROTO_TSN = 0x08,
+	/** Row flags, see enum iproto_flag. */
+	IPROTO_FLAGS = 0x09,
+	/** Id of a stream the request belongs to. */
+	IPROTO_STREAM_ID = 0x0a,
 	/* Leave a gap for other keys in the header. */
 	IPROTO_SPACE_ID = 0x10,
 	IPROTO_INDEX_ID = 0x11,
@@ -67,6 +77,8 @@ enum iproto_key {
 	IPROTO_OFFSET = 0x13,
 	IPROTO_ITERATOR = 0x14,
 	IPROTO_INDEX_BASE = 0x15,
+	/** Id of a server-side cursor. */
+	IPROTO_CURSOR_ID = 0x16,
 
 	/* Leave a gap between integer values and other keys */
 	IPROTO_KEY = 0x20,
@@ -89,6 +101,13 @@ enum iproto_key {
 	IPROTO_EXPR = 0x27, /* EVAL */
 	IPROTO_OPS = 0x28, /* UPSERT but not UPDATE ops, because of legacy */
 	IPROTO_OPTIONS = 0x29,
+	IPROTO_FILTER = 0x2a, /* SELECT */
+	/** Number of initial join streams, JOIN and JOIN_STREAM. */
+	IPROTO_JOIN_STREAM_COUNT = 0x2b,
+	/** Id of an initial join stream, JOIN_STREAM. */
+	IPROTO_JOIN_STREAM_ID = 0x2c,
+	/** Send the memtx snapshot as a file, JOIN. */
+	IPROTO_JOIN_FILES = 0x2d,
 
 	/* Leave a gap between request keys and response keys */
 	IPROTO_DATA = 0x30,
@@ -114,6 +133,12 @@ enum iproto_key {
 	IPROTO_KEY_MAX
 };
 
+/** Flags of IPROTO_FLAGS header key. */
+enum iproto_flag {
+	/** The last row of a transaction. */
+	IPROTO_FLAG_COMMIT = 0x01,
+};
+
 /**
  * Keys, stored in IPROTO_METADATA. They can not be received
  * in a request. Only sent as response, so no necessity in _strs
@@ -126,10 +151,12 @@ enum iproto_metadata_key {
 #define bit(c) (1ULL<<IPROTO_##c)
 
 #define IPROTO_HEAD_BMAP (bit(REQUEST_TYPE) | bit(SYNC) | bit(REPLICA_ID) |\
-			  bit(LSN) | bit(SCHEMA_VERSION))
+			  bit(LSN) | bit(SCHEMA_VERSION) | bit(STREAM_ID) |\
+			  bit(TSN) | bit(FLAGS))
 #define IPROTO_DML_BODY_BMAP (bit(SPACE_ID) | bit(INDEX_ID) | bit(LIMIT) |\
 			      bit(OFFSET) | bit(ITERATOR) | bit(INDEX_BASE) |\
 			      bit(KEY) | bit(TUPLE) | bit(OPS))
+#define IPROTO_SELECT_BODY_BMAP (IPROTO_DML_BODY_BMAP | bit(FILTER))
 
 static inline bool
 xrow_header_has_key(const char *pos, const char *end)
@@ -145,6 +172,13 @@ iproto_dml_body_has_key(const char *pos, const char *end)
 	return key < IPROTO_KEY_MAX && IPROTO_DML_BODY_BMAP & (1ULL<<key);
 }
 
+static inline bool
+iproto_select_body_has_key(const char *pos, const char *end)
+{
+	unsigned char key = pos < end ? *pos : (unsigned char) IPROTO_KEY_MAX;
+	return key < IPROTO_KEY_MAX && IPROTO_SELECT_BODY_BMAP & (1ULL<<key);
+}
+
 #undef bit
 
 static inline uint64_t
@@ -189,6 +223,19 @@ enum iproto_type {
 	/** The maximum typecode used for box.stat() */
 	IPROTO_TYPE_STAT_MAX,
 
+	/** Begin a transaction in a stream. */
+	IPROTO_BEGIN = 14,
+	/** Commit the transaction open in a stream. */
+	IPROTO_COMMIT = 15,
+	/** Rollback the transaction open in a stream. */
+	IPROTO_ROLLBACK = 16,
+	/** Open a server-side cursor over an index. */
+	IPROTO_CURSOR_OPEN = 17,
+	/** Fetch the next tuples of a cursor. */
+	IPROTO_CURSOR_FETCH = 18,
+	/** Close a cursor. */
+	IPROTO_CURSOR_CLOSE = 19,
+
 	/** PING request */
 	IPROTO_PING = 64,
 	/** Replication JOIN command */
@@ -197,6 +244,22 @@ enum iproto_type {
 	IPROTO_SUBSCRIBE = 66,
 	/** Vote request command for master election */
 	IPROTO_REQUEST_VOTE = 67,
+	/**
+	 * Switch the connection to zstd compressed wire format.
+	 * Everything sent in both directions after the reply is
+	 * a single zstd stream.
+	 */
+	IPROTO_COMPRESS = 68,
+	/**
+	 * Receive a part of initial join data over an extra
+	 * connection while JOIN is in progress.
+	 */
+	IPROTO_JOIN_STREAM = 69,
+	/**
+	 * A raw chunk of a checkpoint file sent in the initial
+	 * join stream instead of the rows it contains.
+	 */
+	IPROTO_JOIN_FILE = 70,
 
 	/** Vinyl run info stored in .index file */
 	VY_INDEX_RUN_INFO = 100,
@@ -232,6 +295,18 @@ iproto_type_name(uint32_t type)
 		return iproto_type_strs[type];
 
 	switch (type) {
+	case IPROTO_BEGIN:
+		return "BEGIN";
+	case IPROTO_COMMIT:
+		return "COMMIT";
+	case IPROTO_ROLLBACK:
+		return "ROLLBACK";
+	case IPROTO_CURSOR_OPEN:
+		return "CURSOR_OPEN";
+	case IPROTO_CURSOR_FETCH:
+		return "CURSOR_FETCH";
+	case IPROTO_CURSOR_CLOSE:
+		return "CURSOR_CLOSE";
 	case VY_INDEX_RUN_INFO:
 		return "RUNINFO";
 	case VY_INDEX_PAGE_INFO:
@@ -303,7 +378,8 @@ iproto_type_is_request(uint32_t type)
 static inline bool
 iproto_type_is_sync(uint32_t type)
 {
-	return type == IPROTO_JOIN || type == IPROTO_SUBSCRIBE;
+	return type == IPROTO_JOIN || type == IPROTO_SUBSCRIBE ||
+	       type == IPROTO_JOIN_STREAM;
 }
 
 /** This is an error. */
@@ -132,6 +132,23 @@ typedef uint32_t (*tuple_hash_t)(const struct tuple *tuple,
 typedef uint32_t (*key_hash_t)(const char *key,
 				const struct key_def *key_def);
 
+/**
+ * Comparison hint. If the hint of value a is less than the hint
+ * of value b, then a < b. Equal hints tell nothing, the values
+ * must be compared in full. @sa tuple_hint().
+ */
+typedef uint64_t hint_t;
+
+/** A hint that does not allow to order values. */
+#define HINT_NONE ((hint_t)UINT64_MAX)
+
+/** @copydoc tuple_hint() */
+typedef hint_t (*tuple_hint_t)(const struct tuple *tuple,
+			       const struct key_def *key_def);
+/** @copydoc key_hint() */
+typedef hint_t (*key_hint_t)(const char *key, uint32_t part_count,
+			     const struct key_def *key_def);
+
 /* Definition of a multipart key. */
 struct key_def {
 	/** @see tuple_compare() */
@@ -146,6 +163,10 @@ struct key_def {
 	tuple_hash_t tuple_hash;
 	/** @see key_hash() */
 	key_hash_t key_hash;
+	/** @see tuple_hint() */
+	tuple_hint_t tuple_hint;
+	/** @see key_hint() */
+	key_hint_t key_hint;
 	/**
 	 * Minimal part count which always is unique. For example,
 	 * if a secondary index is unique, then
@@ -535,6 +556,47 @@ tuple_compare_with_key(const struct tuple *tuple, const char *key,
 	return key_def->tuple_compare_with_key(tuple, key, part_count, key_def);
 }
 
+/**
+ * Compute the comparison hint of a tuple: an order-preserving
+ * 64-bit digest of the first key part. Comparing hints first
+ * saves a tuple dereference on most comparisons.
+ * @param tuple tuple
+ * @param key_def key definition
+ * @retval hint, HINT_NONE if the key parts can't be hinted
+ */
+static inline hint_t
+tuple_hint(const struct tuple *tuple, const struct key_def *key_def)
+{
+	return key_def->tuple_hint(tuple, key_def);
+}
+
+/**
+ * Compute the comparison hint of a key, consistent with
+ * tuple_hint() of the same key definition.
+ * @param key key parts without MessagePack array header
+ * @param part_count the number of parts in @a key
+ * @param key_def key definition
+ * @retval hint, HINT_NONE if @a key is empty
+ */
+static inline hint_t
+key_hint(const char *key, uint32_t part_count, const struct key_def *key_def)
+{
+	return key_def->key_hint(key, part_count, key_def);
+}
+
+/**
+ * Compare two comparison hints.
+ * @retval <0, >0 if the hints order the values
+ * @retval 0 if the values must be compared in full
+ */
+static inline int
+hint_cmp(hint_t hint_a, hint_t hint_b)
+{
+	if (hint_a != hint_b && hint_a != HINT_NONE && hint_b != HINT_NONE)
+		return hint_a < hint_b ? -1 : 1;
+	return 0;
+}
+
 #if defined(__cplusplus)
 } /* extern "C" */
 #endif /* defined(__cplusplus) */
@@ -37,7 +37,7 @@
 #include "lua/utils.h"
 
 #include "box/box.h"
-#include "libeio/eio.h"
+#include "coio_task.h"
 
 extern "C" {
 	#include <lua.h>
@@ -187,6 +187,50 @@ lbox_cfg_set_memtx_max_tuple_size(struct lua_State *L)
 	return 0;
 }
 
+static int
+lbox_cfg_set_memtx_defrag_threshold(struct lua_State *L)
+{
+	try {
+		box_set_memtx_defrag_threshold();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
+static int
+lbox_cfg_set_memtx_tree_fill_factor(struct lua_State *L)
+{
+	try {
+		box_set_memtx_tree_fill_factor();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
+static int
+lbox_cfg_set_memtx_expire_batch_size(struct lua_State *L)
+{
+	try {
+		box_set_memtx_expire_batch_size();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
+static int
+lbox_cfg_set_memtx_expire_rate(struct lua_State *L)
+{
+	try {
+		box_set_memtx_expire_rate();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
 static int
 lbox_cfg_set_vinyl_max_tuple_size(struct lua_State *L)
 {
@@ -231,12 +275,55 @@ lbox_cfg_set_net_msg_max(struct lua_State *L)
 	return 0;
 }
 
+static int
+lbox_cfg_set_net_cursor_max(struct lua_State *L)
+{
+	try {
+		box_set_net_cursor_max();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
+static int
+lbox_cfg_set_net_cursor_timeout(struct lua_State *L)
+{
+	try {
+		box_set_net_cursor_timeout();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
+static int
+lbox_cfg_set_net_cursor_memory(struct lua_State *L)
+{
+	try {
+		box_set_net_cursor_memory();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
+static int
+lbox_cfg_set_wal_ring_size(struct lua_State *L)
+{
+	try {
+		box_set_wal_ring_size();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
 static int
 lbox_cfg_set_worker_pool_threads(struct lua_State *L)
 {
 	(void) L;
-	eio_set_min_parallel(cfg_geti("worker_pool_threads"));
-	eio_set_max_parallel(cfg_geti("worker_pool_threads"));
+	coio_set_worker_count(cfg_geti("worker_pool_threads"));
 	return 0;
 }
 
@@ -281,6 +368,14 @@ lbox_cfg_set_replication_skip_conflict(struct lua_State *L)
 	return 0;
 }
 
+static int
+lbox_cfg_set_replication_parallel_apply(struct lua_State *L)
+{
+	(void) L;
+	box_set_replication_parallel_apply();
+	return 0;
+}
+
 void
 box_lua_cfg_init(struct lua_State *L)
 {
@@ -299,14 +394,23 @@ box_lua_cfg_init(struct lua_State *L)
 		{"cfg_set_checkpoint_count", lbox_cfg_set_checkpoint_count},
 		{"cfg_set_read_only", lbox_cfg_set_read_only},
 		{"cfg_set_memtx_max_tuple_size", lbox_cfg_set_memtx_max_tuple_size},
+		{"cfg_set_memtx_defrag_threshold", lbox_cfg_set_memtx_defrag_threshold},
+		{"cfg_set_memtx_tree_fill_factor", lbox_cfg_set_memtx_tree_fill_factor},
+		{"cfg_set_memtx_expire_batch_size", lbox_cfg_set_memtx_expire_batch_size},
+		{"cfg_set_memtx_expire_rate", lbox_cfg_set_memtx_expire_rate},
 		{"cfg_set_vinyl_max_tuple_size", lbox_cfg_set_vinyl_max_tuple_size},
 		{"cfg_set_vinyl_cache", lbox_cfg_set_vinyl_cache},
 		{"cfg_set_vinyl_timeout", lbox_cfg_set_vinyl_timeout},
 		{"cfg_set_replication_timeout", lbox_cfg_set_replication_timeout},
 		{"cfg_set_replication_connect_quorum", lbox_cfg_set_replication_connect_quorum},
 		{"cfg_set_replication_skip_conflict", lbox_cfg_set_replication_skip_conflict},
+		{"cfg_set_replication_parallel_apply", lbox_cfg_set_replication_parallel_apply},
 		{"cfg_set_replication_connect_timeout", lbox_cfg_set_replication_connect_timeout},
 		{"cfg_set_net_msg_max", lbox_cfg_set_net_msg_max},
+		{"cfg_set_net_cursor_max", lbox_cfg_set_net_cursor_max},
+		{"cfg_set_net_cursor_timeout", lbox_cfg_set_net_cursor_timeout},
+		{"cfg_set_net_cursor_memory", lbox_cfg_set_net_cursor_memory},
+		{"cfg_set_wal_ring_size", lbox_cfg_set_wal_ring_size},
 		{NULL, NULL}
 	};
 
@@ -242,9 +242,10 @@ box_index_init_iterator_types(struct lua_State *L, int idx)
 static int
 lbox_index_iterator(lua_State *L)
 {
-	if (lua_gettop(L) != 4 || !lua_isnumber(L, 1) || !lua_isnumber(L, 2) ||
-	    !lua_isnumber(L, 3))
-		return luaL_error(L, "usage index.iterator(space_id, index_id, type, key)");
+	int argc = lua_gettop(L);
+	if (argc < 4 || argc > 5 || !lua_isnumber(L, 1) ||
+	    !lua_isnumber(L, 2) || !lua_isnumber(L, 3))
+		return luaL_error(L, "usage index.iterator(space_id, index_id, type, key[, is_cover])");
 
 	uint32_t space_id = lua_tonumber(L, 1);
 	uint32_t index_id = lua_tonumber(L, 2);
@@ -252,8 +253,12 @@ lbox_index_iterator(lua_State *L)
 	size_t mpkey_len;
 	const char *mpkey = lua_tolstring(L, 4, &mpkey_len); /* Key encoded by Lua */
 	/* const char *key = lbox_encode_tuple_on_gc(L, 4, key_len); */
-	struct iterator *it = box_index_iterator(space_id, index_id, iterator,
-						 mpkey, mpkey + mpkey_len);
+	bool is_cover = argc == 5 && lua_toboolean(L, 5);
+	struct iterator *it = is_cover ?
+		box_index_cover_iterator(space_id, index_id, iterator,
+					 mpkey, mpkey + mpkey_len) :
+		box_index_iterator(space_id, index_id, iterator,
+				   mpkey, mpkey + mpkey_len);
 	if (it == NULL)
 		return luaT_error(L);
 
@@ -53,6 +53,7 @@
 #include "box/box.h"
 #include "lua/utils.h"
 #include "fiber.h"
+#include "rmean.h"
 
 static void
 lbox_pushvclock(struct lua_State *L, const struct vclock *vclock)
@@ -100,6 +101,19 @@ lbox_pushapplier(lua_State *L, struct applier *applier)
 		lua_pushlstring(L, name, total);
 		lua_settable(L, -3);
 
+		lua_pushstring(L, "queue");
+		lua_pushinteger(L, applier->queue_len);
+		lua_settable(L, -3);
+
+		lua_pushstring(L, "apply_rps");
+		lua_pushinteger(L, rmean_mean(applier->rmean,
+					      APPLIER_STAT_APPLY));
+		lua_settable(L, -3);
+
+		lua_pushstring(L, "vclock");
+		lbox_pushvclock(L, &applier->durable_vclock);
+		lua_settable(L, -3);
+
 		struct error *e = diag_last_error(&applier->reader->diag);
 		if (e != NULL) {
 			lua_pushstring(L, "message");
@@ -12,6 +12,13 @@ local default_cfg = {
     memtx_memory        = 256 * 1024 *1024,
     memtx_min_tuple_size = 16,
     memtx_max_tuple_size = 1024 * 1024,
+    memtx_defrag_threshold = 0,
+    memtx_tree_fill_factor = 1,
+    memtx_expire_batch_size = 100,
+    memtx_expire_rate   = 10000,
+    memtx_huge_pages    = 'none',
+    memtx_numa_policy   = 'default',
+    memtx_numa_nodes    = nil,
     slab_alloc_factor   = 1.05,
     work_dir            = nil,
     memtx_dir           = ".",
@@ -40,6 +47,7 @@ local default_cfg = {
     wal_mode            = "write",
     rows_per_wal        = 500000,
     wal_max_size        = 256 * 1024 * 1024,
+    wal_ring_size       = 16 * 1024 * 1024,
     wal_dir_rescan_delay= 2,
     force_recovery      = false,
     replication         = nil,
@@ -60,10 +68,17 @@ local default_cfg = {
     replication_connect_timeout = 30,
     replication_connect_quorum = nil, -- connect all
     replication_skip_conflict = false,
+    replication_parallel_apply = false,
+    replication_join_streams = 1,
+    replication_join_files = false,
+    replication_compression = false,
     feedback_enabled      = true,
     feedback_host         = "https://feedback.tarantool.io",
     feedback_interval     = 3600,
     net_msg_max           = 768,
+    net_cursor_max        = 64,
+    net_cursor_timeout    = 60,
+    net_cursor_memory     = 16 * 1024 * 1024,
 }
 
 -- types of available options
@@ -73,6 +88,13 @@ local template_cfg = {
     memtx_memory        = 'number',
     memtx_min_tuple_size  = 'number',
     memtx_max_tuple_size  = 'number',
+    memtx_defrag_threshold = 'number',
+    memtx_tree_fill_factor = 'number',
+    memtx_expire_batch_size = 'number',
+    memtx_expire_rate   = 'number',
+    memtx_huge_pages    = 'string',
+    memtx_numa_policy   = 'string',
+    memtx_numa_nodes    = 'string, number',
     slab_alloc_factor   = 'number',
     work_dir            = 'string',
     memtx_dir            = 'string',
@@ -101,6 +123,7 @@ local template_cfg = {
     wal_mode            = 'string',
     rows_per_wal        = 'number',
     wal_max_size        = 'number',
+    wal_ring_size       = 'number',
     wal_dir_rescan_delay= 'number',
     force_recovery      = 'boolean',
     replication         = 'string, number, table',
@@ -121,10 +144,17 @@ local template_cfg = {
     replication_connect_timeout = 'number',
     replication_connect_quorum = 'number',
     replication_skip_conflict = 'boolean',
+    replication_parallel_apply = 'boolean',
+    replication_join_streams = 'number',
+    replication_join_files = 'boolean',
+    replication_compression = 'boolean',
     feedback_enabled      = 'boolean',
     feedback_host         = 'string',
     feedback_interval     = 'number',
     net_msg_max           = 'number',
+    net_cursor_max        = 'number',
+    net_cursor_timeout    = 'number',
+    net_cursor_memory     = 'number',
 }
 
 local function normalize_uri(port)
@@ -179,6 +209,10 @@ local dynamic_cfg = {
     snap_io_rate_limit      = private.cfg_set_snap_io_rate_limit,
     read_only               = private.cfg_set_read_only,
     memtx_max_tuple_size    = private.cfg_set_memtx_max_tuple_size,
+    memtx_defrag_threshold  = private.cfg_set_memtx_defrag_threshold,
+    memtx_tree_fill_factor  = private.cfg_set_memtx_tree_fill_factor,
+    memtx_expire_batch_size = private.cfg_set_memtx_expire_batch_size,
+    memtx_expire_rate       = private.cfg_set_memtx_expire_rate,
     vinyl_max_tuple_size    = private.cfg_set_vinyl_max_tuple_size,
     vinyl_cache             = private.cfg_set_vinyl_cache,
     vinyl_timeout           = private.cfg_set_vinyl_timeout,
@@ -198,7 +232,17 @@ local dynamic_cfg = {
     replication_connect_timeout = private.cfg_set_replication_connect_timeout,
     replication_connect_quorum = private.cfg_set_replication_connect_quorum,
     replication_skip_conflict = private.cfg_set_replication_skip_conflict,
+    replication_parallel_apply = private.cfg_set_replication_parallel_apply,
+    -- read on each JOIN
+    replication_join_streams = function() end,
+    replication_join_files = function() end,
+    -- read on each connect
+    replication_compression = function() end,
     net_msg_max             = private.cfg_set_net_msg_max,
+    net_cursor_max          = private.cfg_set_net_cursor_max,
+    net_cursor_timeout      = private.cfg_set_net_cursor_timeout,
+    net_cursor_memory       = private.cfg_set_net_cursor_memory,
+    wal_ring_size           = private.cfg_set_wal_ring_size,
 }
 
 local dynamic_cfg_skip_at_load = {
@@ -209,6 +253,7 @@ local dynamic_cfg_skip_at_load = {
     replication_connect_timeout = true,
     replication_connect_quorum = true,
     wal_dir_rescan_delay    = true,
+    wal_ring_size           = true,
     custom_proc_title       = true,
     force_recovery          = true,
 }
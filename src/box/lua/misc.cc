@@ -37,6 +37,7 @@
 
 #include "box/box.h"
 #include "box/port.h"
+#include "box/tuple_filter.h"
 #include "box/lua/tuple.h"
 
 /** {{{ Miscellaneous utils **/
@@ -75,10 +76,12 @@ lbox_port_to_table(lua_State *L, struct port *port_base)
 static int
 lbox_select(lua_State *L)
 {
-	if (lua_gettop(L) != 6 || !lua_isnumber(L, 1) || !lua_isnumber(L, 2) ||
-		!lua_isnumber(L, 3) || !lua_isnumber(L, 4) || !lua_isnumber(L, 5)) {
+	int argc = lua_gettop(L);
+	if (argc < 6 || argc > 8 || !lua_isnumber(L, 1) ||
+	    !lua_isnumber(L, 2) || !lua_isnumber(L, 3) ||
+	    !lua_isnumber(L, 4) || !lua_isnumber(L, 5)) {
 		return luaL_error(L, "Usage index:select(iterator, offset, "
-				  "limit, key)");
+				  "limit, key[, filter[, is_cover]])");
 	}
 
 	uint32_t space_id = lua_tonumber(L, 1);
@@ -90,9 +93,21 @@ lbox_select(lua_State *L)
 	size_t key_len;
 	const char *key = lbox_encode_tuple_on_gc(L, 6, &key_len);
 
+	struct tuple_filter *filter = NULL;
+	if (argc >= 7 && !lua_isnil(L, 7)) {
+		size_t filter_len;
+		const char *expr = lbox_encode_tuple_on_gc(L, 7, &filter_len);
+		filter = tuple_filter_new(&fiber()->gc, expr,
+					  expr + filter_len, 1);
+		if (filter == NULL)
+			return luaT_error(L);
+	}
+
+	bool is_cover = argc == 8 && lua_toboolean(L, 8);
+
 	struct port port;
 	if (box_select(space_id, index_id, iterator, offset, limit,
-		       key, key + key_len, &port) != 0) {
+		       key, key + key_len, filter, is_cover, &port) != 0) {
 		return luaT_error(L);
 	}
 
@@ -45,8 +45,10 @@
 #include "third_party/base64.h"
 
 #include "coio.h"
+#include "fiber.h"
 #include "box/errcode.h"
 #include "lua/fiber.h"
+#include "zstd.h"
 
 #define cfg luaL_msgpack_default
 
@@ -55,6 +57,8 @@ netbox_prepare_request(lua_State *L, struct mpstream *stream, uint32_t r_type)
 {
 	struct ibuf *ibuf = (struct ibuf *) lua_topointer(L, 1);
 	uint64_t sync = luaL_touint64(L, 2);
+	/* Stream id is optional, nil means out of stream. */
+	uint64_t stream_id = luaL_touint64(L, 3);
 
 	mpstream_init(stream, ibuf, ibuf_reserve_cb, ibuf_alloc_cb,
 		      luamp_error, L);
@@ -68,7 +72,7 @@ netbox_prepare_request(lua_State *L, struct mpstream *stream, uint32_t r_type)
 	mpstream_advance(stream, fixheader_size);
 
 	/* encode header */
-	luamp_encode_map(cfg, stream, 2);
+	luamp_encode_map(cfg, stream, stream_id != 0 ? 3 : 2);
 
 	luamp_encode_uint(cfg, stream, IPROTO_SYNC);
 	luamp_encode_uint(cfg, stream, sync);
@@ -76,6 +80,11 @@ netbox_prepare_request(lua_State *L, struct mpstream *stream, uint32_t r_type)
 	luamp_encode_uint(cfg, stream, IPROTO_REQUEST_TYPE);
 	luamp_encode_uint(cfg, stream, r_type);
 
+	if (stream_id != 0) {
+		luamp_encode_uint(cfg, stream, IPROTO_STREAM_ID);
+		luamp_encode_uint(cfg, stream, stream_id);
+	}
+
 	/* Caller should remember how many bytes was used in ibuf */
 	return used;
 }
@@ -109,8 +118,9 @@ netbox_encode_request(struct mpstream *stream, size_t initial_size)
 static int
 netbox_encode_ping(lua_State *L)
 {
-	if (lua_gettop(L) < 2)
-		return luaL_error(L, "Usage: netbox.encode_ping(ibuf, sync)");
+	if (lua_gettop(L) < 3)
+		return luaL_error(L, "Usage: netbox.encode_ping(ibuf, sync, "
+				     "stream_id)");
 
 	struct mpstream stream;
 	size_t svp = netbox_prepare_request(L, &stream, IPROTO_PING);
@@ -118,23 +128,67 @@ netbox_encode_ping(lua_State *L)
 	return 0;
 }
 
+static int
+netbox_encode_compress(lua_State *L)
+{
+	if (lua_gettop(L) < 3)
+		return luaL_error(L, "Usage: netbox.encode_compress(ibuf, "
+				     "sync, stream_id)");
+
+	struct mpstream stream;
+	size_t svp = netbox_prepare_request(L, &stream, IPROTO_COMPRESS);
+	netbox_encode_request(&stream, svp);
+	return 0;
+}
+
+static inline int
+netbox_encode_txn_control(lua_State *L, uint32_t reqtype)
+{
+	if (lua_gettop(L) < 3) {
+		return luaL_error(L, "Usage: netbox.encode_begin(ibuf, sync, "
+				     "stream_id)");
+	}
+	struct mpstream stream;
+	size_t svp = netbox_prepare_request(L, &stream, reqtype);
+	netbox_encode_request(&stream, svp);
+	return 0;
+}
+
+static int
+netbox_encode_begin(lua_State *L)
+{
+	return netbox_encode_txn_control(L, IPROTO_BEGIN);
+}
+
+static int
+netbox_encode_commit(lua_State *L)
+{
+	return netbox_encode_txn_control(L, IPROTO_COMMIT);
+}
+
+static int
+netbox_encode_rollback(lua_State *L)
+{
+	return netbox_encode_txn_control(L, IPROTO_ROLLBACK);
+}
+
 static int
 netbox_encode_auth(lua_State *L)
 {
-	if (lua_gettop(L) < 5) {
+	if (lua_gettop(L) < 6) {
 		return luaL_error(L, "Usage: netbox.encode_update(ibuf, sync, "
-				     "user, password, greeting)");
+				     "stream_id, user, password, greeting)");
 	}
 
 	struct mpstream stream;
 	size_t svp = netbox_prepare_request(L, &stream, IPROTO_AUTH);
 
 	size_t user_len;
-	const char *user = lua_tolstring(L, 3, &user_len);
+	const char *user = lua_tolstring(L, 4, &user_len);
 	size_t password_len;
-	const char *password = lua_tolstring(L, 4, &password_len);
+	const char *password = lua_tolstring(L, 5, &password_len);
 	size_t salt_len;
-	const char *salt = lua_tolstring(L, 5, &salt_len);
+	const char *salt = lua_tolstring(L, 6, &salt_len);
 	if (salt_len < SCRAMBLE_SIZE)
 		return luaL_error(L, "Invalid salt");
 
@@ -158,9 +212,9 @@ netbox_encode_auth(lua_State *L)
 static int
 netbox_encode_call_impl(lua_State *L, enum iproto_type type)
 {
-	if (lua_gettop(L) < 4) {
+	if (lua_gettop(L) < 5) {
 		return luaL_error(L, "Usage: netbox.encode_call(ibuf, sync, "
-				     "function_name, args)");
+				     "stream_id, function_name, args)");
 	}
 
 	struct mpstream stream;
@@ -170,13 +224,13 @@ netbox_encode_call_impl(lua_State *L, enum iproto_type type)
 
 	/* encode proc name */
 	size_t name_len;
-	const char *name = lua_tolstring(L, 3, &name_len);
+	const char *name = lua_tolstring(L, 4, &name_len);
 	luamp_encode_uint(cfg, &stream, IPROTO_FUNCTION_NAME);
 	luamp_encode_str(cfg, &stream, name, name_len);
 
 	/* encode args */
 	luamp_encode_uint(cfg, &stream, IPROTO_TUPLE);
-	luamp_encode_tuple(L, cfg, &stream, 4);
+	luamp_encode_tuple(L, cfg, &stream, 5);
 
 	netbox_encode_request(&stream, svp);
 	return 0;
@@ -197,9 +251,9 @@ netbox_encode_call(lua_State *L)
 static int
 netbox_encode_eval(lua_State *L)
 {
-	if (lua_gettop(L) < 4) {
+	if (lua_gettop(L) < 5) {
 		return luaL_error(L, "Usage: netbox.encode_eval(ibuf, sync, "
-				     "expr, args)");
+				     "stream_id, expr, args)");
 	}
 
 	struct mpstream stream;
@@ -209,13 +263,13 @@ netbox_encode_eval(lua_State *L)
 
 	/* encode expr */
 	size_t expr_len;
-	const char *expr = lua_tolstring(L, 3, &expr_len);
+	const char *expr = lua_tolstring(L, 4, &expr_len);
 	luamp_encode_uint(cfg, &stream, IPROTO_EXPR);
 	luamp_encode_str(cfg, &stream, expr, expr_len);
 
 	/* encode args */
 	luamp_encode_uint(cfg, &stream, IPROTO_TUPLE);
-	luamp_encode_tuple(L, cfg, &stream, 4);
+	luamp_encode_tuple(L, cfg, &stream, 5);
 
 	netbox_encode_request(&stream, svp);
 	return 0;
@@ -224,22 +278,23 @@ netbox_encode_eval(lua_State *L)
 static int
 netbox_encode_select(lua_State *L)
 {
-	if (lua_gettop(L) < 8) {
+	if (lua_gettop(L) < 9) {
 		return luaL_error(L, "Usage netbox.encode_select(ibuf, sync, "
-				     "space_id, index_id, iterator, offset, "
-				     "limit, key)");
+				     "stream_id, space_id, index_id, iterator, "
+				     "offset, limit, key[, filter])");
 	}
 
 	struct mpstream stream;
 	size_t svp = netbox_prepare_request(L, &stream, IPROTO_SELECT);
 
-	luamp_encode_map(cfg, &stream, 6);
+	bool has_filter = lua_gettop(L) >= 10 && !lua_isnil(L, 10);
+	luamp_encode_map(cfg, &stream, has_filter ? 8 : 6);
 
-	uint32_t space_id = lua_tonumber(L, 3);
-	uint32_t index_id = lua_tonumber(L, 4);
-	int iterator = lua_tointeger(L, 5);
-	uint32_t offset = lua_tonumber(L, 6);
-	uint32_t limit = lua_tonumber(L, 7);
+	uint32_t space_id = lua_tonumber(L, 4);
+	uint32_t index_id = lua_tonumber(L, 5);
+	int iterator = lua_tointeger(L, 6);
+	uint32_t offset = lua_tonumber(L, 7);
+	uint32_t limit = lua_tonumber(L, 8);
 
 	/* encode space_id */
 	luamp_encode_uint(cfg, &stream, IPROTO_SPACE_ID);
@@ -263,7 +318,15 @@ netbox_encode_select(lua_State *L)
 
 	/* encode key */
 	luamp_encode_uint(cfg, &stream, IPROTO_KEY);
-	luamp_convert_key(L, cfg, &stream, 8);
+	luamp_convert_key(L, cfg, &stream, 9);
+
+	if (has_filter) {
+		/* encode filter, field numbers are 1-based in Lua */
+		luamp_encode_uint(cfg, &stream, IPROTO_FILTER);
+		luamp_encode_tuple(L, cfg, &stream, 10);
+		luamp_encode_uint(cfg, &stream, IPROTO_INDEX_BASE);
+		luamp_encode_uint(cfg, &stream, 1);
+	}
 
 	netbox_encode_request(&stream, svp);
 	return 0;
@@ -272,9 +335,9 @@ netbox_encode_select(lua_State *L)
 static inline int
 netbox_encode_insert_or_replace(lua_State *L, uint32_t reqtype)
 {
-	if (lua_gettop(L) < 4) {
+	if (lua_gettop(L) < 5) {
 		return luaL_error(L, "Usage: netbox.encode_insert(ibuf, sync, "
-				     "space_id, tuple)");
+				     "stream_id, space_id, tuple)");
 	}
 	struct mpstream stream;
 	size_t svp = netbox_prepare_request(L, &stream, reqtype);
@@ -282,13 +345,87 @@ netbox_encode_insert_or_replace(lua_State *L, uint32_t reqtype)
 	luamp_encode_map(cfg, &stream, 2);
 
 	/* encode space_id */
-	uint32_t space_id = lua_tonumber(L, 3);
+	uint32_t space_id = lua_tonumber(L, 4);
 	luamp_encode_uint(cfg, &stream, IPROTO_SPACE_ID);
 	luamp_encode_uint(cfg, &stream, space_id);
 
 	/* encode args */
 	luamp_encode_uint(cfg, &stream, IPROTO_TUPLE);
-	luamp_encode_tuple(L, cfg, &stream, 4);
+	luamp_encode_tuple(L, cfg, &stream, 5);
+
+	netbox_encode_request(&stream, svp);
+	return 0;
+}
+
+static int
+netbox_encode_cursor_open(lua_State *L)
+{
+	if (lua_gettop(L) < 8) {
+		return luaL_error(L, "Usage netbox.encode_cursor_open(ibuf, "
+				     "sync, stream_id, space_id, index_id, "
+				     "iterator, offset, key)");
+	}
+
+	struct mpstream stream;
+	size_t svp = netbox_prepare_request(L, &stream, IPROTO_CURSOR_OPEN);
+
+	luamp_encode_map(cfg, &stream, 5);
+
+	uint32_t space_id = lua_tonumber(L, 4);
+	uint32_t index_id = lua_tonumber(L, 5);
+	int iterator = lua_tointeger(L, 6);
+	uint32_t offset = lua_tonumber(L, 7);
+
+	luamp_encode_uint(cfg, &stream, IPROTO_SPACE_ID);
+	luamp_encode_uint(cfg, &stream, space_id);
+	luamp_encode_uint(cfg, &stream, IPROTO_INDEX_ID);
+	luamp_encode_uint(cfg, &stream, index_id);
+	luamp_encode_uint(cfg, &stream, IPROTO_ITERATOR);
+	luamp_encode_uint(cfg, &stream, iterator);
+	luamp_encode_uint(cfg, &stream, IPROTO_OFFSET);
+	luamp_encode_uint(cfg, &stream, offset);
+	luamp_encode_uint(cfg, &stream, IPROTO_KEY);
+	luamp_convert_key(L, cfg, &stream, 8);
+
+	netbox_encode_request(&stream, svp);
+	return 0;
+}
+
+static int
+netbox_encode_cursor_fetch(lua_State *L)
+{
+	if (lua_gettop(L) < 5) {
+		return luaL_error(L, "Usage netbox.encode_cursor_fetch(ibuf, "
+				     "sync, stream_id, cursor_id, limit)");
+	}
+
+	struct mpstream stream;
+	size_t svp = netbox_prepare_request(L, &stream, IPROTO_CURSOR_FETCH);
+
+	luamp_encode_map(cfg, &stream, 2);
+	luamp_encode_uint(cfg, &stream, IPROTO_CURSOR_ID);
+	luamp_encode_uint(cfg, &stream, luaL_touint64(L, 4));
+	luamp_encode_uint(cfg, &stream, IPROTO_LIMIT);
+	luamp_encode_uint(cfg, &stream, (uint32_t) lua_tonumber(L, 5));
+
+	netbox_encode_request(&stream, svp);
+	return 0;
+}
+
+static int
+netbox_encode_cursor_close(lua_State *L)
+{
+	if (lua_gettop(L) < 4) {
+		return luaL_error(L, "Usage netbox.encode_cursor_close(ibuf, "
+				     "sync, stream_id, cursor_id)");
+	}
+
+	struct mpstream stream;
+	size_t svp = netbox_prepare_request(L, &stream, IPROTO_CURSOR_CLOSE);
+
+	luamp_encode_map(cfg, &stream, 1);
+	luamp_encode_uint(cfg, &stream, IPROTO_CURSOR_ID);
+	luamp_encode_uint(cfg, &stream, luaL_touint64(L, 4));
 
 	netbox_encode_request(&stream, svp);
 	return 0;
@@ -309,9 +446,9 @@ netbox_encode_replace(lua_State *L)
 static int
 netbox_encode_delete(lua_State *L)
 {
-	if (lua_gettop(L) < 5) {
+	if (lua_gettop(L) < 6) {
 		return luaL_error(L, "Usage: netbox.encode_delete(ibuf, sync, "
-				     "space_id, index_id, key)");
+				     "stream_id, space_id, index_id, key)");
 	}
 
 	struct mpstream stream;
@@ -320,18 +457,18 @@ netbox_encode_delete(lua_State *L)
 	luamp_encode_map(cfg, &stream, 3);
 
 	/* encode space_id */
-	uint32_t space_id = lua_tonumber(L, 3);
+	uint32_t space_id = lua_tonumber(L, 4);
 	luamp_encode_uint(cfg, &stream, IPROTO_SPACE_ID);
 	luamp_encode_uint(cfg, &stream, space_id);
 
 	/* encode space_id */
-	uint32_t index_id = lua_tonumber(L, 4);
+	uint32_t index_id = lua_tonumber(L, 5);
 	luamp_encode_uint(cfg, &stream, IPROTO_INDEX_ID);
 	luamp_encode_uint(cfg, &stream, index_id);
 
 	/* encode key */
 	luamp_encode_uint(cfg, &stream, IPROTO_KEY);
-	luamp_convert_key(L, cfg, &stream, 5);
+	luamp_convert_key(L, cfg, &stream, 6);
 
 	netbox_encode_request(&stream, svp);
 	return 0;
@@ -340,9 +477,9 @@ netbox_encode_delete(lua_State *L)
 static int
 netbox_encode_update(lua_State *L)
 {
-	if (lua_gettop(L) < 6) {
+	if (lua_gettop(L) < 7) {
 		return luaL_error(L, "Usage: netbox.encode_update(ibuf, sync, "
-				     "space_id, index_id, key, ops)");
+				     "stream_id, space_id, index_id, key, ops)");
 	}
 
 	struct mpstream stream;
@@ -351,12 +488,12 @@ netbox_encode_update(lua_State *L)
 	luamp_encode_map(cfg, &stream, 5);
 
 	/* encode space_id */
-	uint32_t space_id = lua_tonumber(L, 3);
+	uint32_t space_id = lua_tonumber(L, 4);
 	luamp_encode_uint(cfg, &stream, IPROTO_SPACE_ID);
 	luamp_encode_uint(cfg, &stream, space_id);
 
 	/* encode index_id */
-	uint32_t index_id = lua_tonumber(L, 4);
+	uint32_t index_id = lua_tonumber(L, 5);
 	luamp_encode_uint(cfg, &stream, IPROTO_INDEX_ID);
 	luamp_encode_uint(cfg, &stream, index_id);
 
@@ -367,12 +504,12 @@ netbox_encode_update(lua_State *L)
 	/* encode in reverse order for speedup - see luamp_encode() code */
 	/* encode ops */
 	luamp_encode_uint(cfg, &stream, IPROTO_TUPLE);
-	luamp_encode_tuple(L, cfg, &stream, 6);
+	luamp_encode_tuple(L, cfg, &stream, 7);
 	lua_pop(L, 1); /* ops */
 
 	/* encode key */
 	luamp_encode_uint(cfg, &stream, IPROTO_KEY);
-	luamp_convert_key(L, cfg, &stream, 5);
+	luamp_convert_key(L, cfg, &stream, 6);
 
 	netbox_encode_request(&stream, svp);
 	return 0;
@@ -381,9 +518,9 @@ netbox_encode_update(lua_State *L)
 static int
 netbox_encode_upsert(lua_State *L)
 {
-	if (lua_gettop(L) != 5) {
+	if (lua_gettop(L) != 6) {
 		return luaL_error(L, "Usage: netbox.encode_upsert(ibuf, sync, "
-				     "space_id, tuple, ops)");
+				     "stream_id, space_id, tuple, ops)");
 	}
 
 	struct mpstream stream;
@@ -392,7 +529,7 @@ netbox_encode_upsert(lua_State *L)
 	luamp_encode_map(cfg, &stream, 4);
 
 	/* encode space_id */
-	uint32_t space_id = lua_tonumber(L, 3);
+	uint32_t space_id = lua_tonumber(L, 4);
 	luamp_encode_uint(cfg, &stream, IPROTO_SPACE_ID);
 	luamp_encode_uint(cfg, &stream, space_id);
 
@@ -403,12 +540,12 @@ netbox_encode_upsert(lua_State *L)
 	/* encode in reverse order for speedup - see luamp_encode() code */
 	/* encode ops */
 	luamp_encode_uint(cfg, &stream, IPROTO_OPS);
-	luamp_encode_tuple(L, cfg, &stream, 5);
+	luamp_encode_tuple(L, cfg, &stream, 6);
 	lua_pop(L, 1); /* ops */
 
 	/* encode tuple */
 	luamp_encode_uint(cfg, &stream, IPROTO_TUPLE);
-	luamp_encode_tuple(L, cfg, &stream, 4);
+	luamp_encode_tuple(L, cfg, &stream, 5);
 
 	netbox_encode_request(&stream, svp);
 	return 0;
@@ -448,8 +585,136 @@ netbox_decode_greeting(lua_State *L)
 	return 1;
 }
 
+/** Wire compression state of a connection, @sa IPROTO_COMPRESS. */
+struct netbox_zstd {
+	/** Compressor of the output. */
+	ZSTD_CStream *cstream;
+	/** Decompressor of the input. */
+	ZSTD_DStream *dstream;
+	/** Compressed input which is not decompressed yet. */
+	struct ibuf in;
+	/** Compressed output which is not sent yet. */
+	struct ibuf out;
+	/**
+	 * True if the last decompression filled up the receive
+	 * buffer, so the decompressor may hold more data.
+	 */
+	bool is_draining;
+};
+
+static const char *netbox_zstd_typename = "net.box.zstd";
+
+/**
+ * zstd_new() -> compression state to be passed to communicate()
+ * once the connection has switched to compressed wire format.
+ */
+static int
+netbox_zstd_new(struct lua_State *L)
+{
+	struct netbox_zstd *zstd = (struct netbox_zstd *)
+		lua_newuserdata(L, sizeof(*zstd));
+	zstd->cstream = ZSTD_createCStream();
+	zstd->dstream = ZSTD_createDStream();
+	ibuf_create(&zstd->in, cord_slab_cache(), 16320);
+	ibuf_create(&zstd->out, cord_slab_cache(), 16320);
+	zstd->is_draining = false;
+	luaL_getmetatable(L, netbox_zstd_typename);
+	lua_setmetatable(L, -2);
+	if (zstd->cstream == NULL || zstd->dstream == NULL ||
+	    ZSTD_isError(ZSTD_initCStream(zstd->cstream, 1)) ||
+	    ZSTD_isError(ZSTD_initDStream(zstd->dstream)))
+		return luaL_error(L, "failed to create zstd context");
+	return 1;
+}
+
+static int
+netbox_zstd_gc(struct lua_State *L)
+{
+	struct netbox_zstd *zstd = (struct netbox_zstd *)
+		luaL_checkudata(L, 1, netbox_zstd_typename);
+	ZSTD_freeCStream(zstd->cstream);
+	ZSTD_freeDStream(zstd->dstream);
+	ibuf_destroy(&zstd->in);
+	ibuf_destroy(&zstd->out);
+	return 0;
+}
+
+/**
+ * Move the whole send buffer through the compressor into
+ * the compressed output buffer.
+ * @retval 0 Success.
+ * @retval -1 Error, errno is set.
+ */
+static int
+netbox_zstd_compress(struct netbox_zstd *zstd, struct ibuf *send_buf)
+{
+	ZSTD_inBuffer input = { send_buf->rpos, ibuf_used(send_buf), 0 };
+	size_t rc;
+	do {
+		if (ibuf_reserve(&zstd->out, ZSTD_CStreamOutSize()) == NULL) {
+			errno = ENOMEM;
+			return -1;
+		}
+		ZSTD_outBuffer output = {
+			zstd->out.wpos, ibuf_unused(&zstd->out), 0
+		};
+		if (input.pos < input.size)
+			rc = ZSTD_compressStream(zstd->cstream, &output,
+						 &input);
+		else
+			rc = ZSTD_flushStream(zstd->cstream, &output);
+		if (ZSTD_isError(rc)) {
+			errno = EPROTO;
+			return -1;
+		}
+		zstd->out.wpos += output.pos;
+	} while (input.pos < input.size || rc != 0);
+	send_buf->rpos = send_buf->wpos;
+	return 0;
+}
+
 /**
- * communicate(fd, send_buf, recv_buf, limit_or_boundary, timeout)
+ * Receive compressed data and decompress as much of it as
+ * fits into the receive buffer.
+ * @retval >0 Size of the decompressed data.
+ * @retval 0 EOF.
+ * @retval -1 Error or nothing to read, errno is set.
+ */
+static ssize_t
+netbox_zstd_recv(struct netbox_zstd *zstd, int fd, struct ibuf *recv_buf)
+{
+	struct ibuf *zin = &zstd->in;
+	ZSTD_outBuffer output = {
+		recv_buf->wpos, ibuf_unused(recv_buf), 0
+	};
+	while (output.pos == 0) {
+		if (ibuf_used(zin) == 0 && !zstd->is_draining) {
+			ibuf_reset(zin);
+			if (ibuf_reserve(zin, 16320) == NULL) {
+				errno = ENOMEM;
+				return -1;
+			}
+			ssize_t rc = recv(fd, zin->wpos, ibuf_unused(zin), 0);
+			if (rc <= 0)
+				return rc;
+			zin->wpos += rc;
+		}
+		ZSTD_inBuffer input = { zin->rpos, ibuf_used(zin), 0 };
+		size_t rc = ZSTD_decompressStream(zstd->dstream, &output,
+						  &input);
+		if (ZSTD_isError(rc)) {
+			errno = EPROTO;
+			return -1;
+		}
+		zin->rpos += input.pos;
+		zstd->is_draining = output.pos == output.size;
+	}
+	return output.pos;
+}
+
+/**
+ * communicate(fd, send_buf, recv_buf, limit_or_boundary, timeout,
+ *             zstd)
  *  -> errno, error
  *  -> nil, limit/boundary_pos
  *
@@ -461,6 +726,9 @@ netbox_decode_greeting(lua_State *L)
  * Instead, this function takes an fd, input and output buffer,
  * and does sending and receiving on it in a single event loop
  * interaction.
+ *
+ * If zstd state is given, the wire data is compressed, while
+ * the buffers keep it raw.
  */
 static int
 netbox_communicate(lua_State *L)
@@ -489,6 +757,13 @@ netbox_communicate(lua_State *L)
 		lua_pushstring(L, "Timeout exceeded");
 		return 2;
 	}
+	struct netbox_zstd *zstd = NULL;
+	struct ibuf *out = send_buf;
+	if (!lua_isnoneornil(L, 6)) {
+		zstd = (struct netbox_zstd *)
+			luaL_checkudata(L, 6, netbox_zstd_typename);
+		out = &zstd->out;
+	}
 	int revents = COIO_READ;
 	while (true) {
 		/* reader serviced first */
@@ -513,8 +788,10 @@ check_limit:
 			void *p = ibuf_reserve(recv_buf, NETBOX_READAHEAD);
 			if (p == NULL)
 				luaL_error(L, "out of memory");
-			ssize_t rc = recv(
-				fd, recv_buf->wpos, ibuf_unused(recv_buf), 0);
+			ssize_t rc = zstd == NULL ?
+				recv(fd, recv_buf->wpos,
+				     ibuf_unused(recv_buf), 0) :
+				netbox_zstd_recv(zstd, fd, recv_buf);
 			if (rc == 0) {
 				lua_pushinteger(L, ER_NO_CONNECTION);
 				lua_pushstring(L, "Peer closed");
@@ -528,11 +805,14 @@ check_limit:
 				goto handle_error;
 		}
 
-		while ((revents & COIO_WRITE) && ibuf_used(send_buf) != 0) {
-			ssize_t rc = send(
-				fd, send_buf->rpos, ibuf_used(send_buf), 0);
+		if (zstd != NULL && ibuf_used(send_buf) != 0 &&
+		    netbox_zstd_compress(zstd, send_buf) != 0)
+			goto handle_error;
+
+		while ((revents & COIO_WRITE) && ibuf_used(out) != 0) {
+			ssize_t rc = send(fd, out->rpos, ibuf_used(out), 0);
 			if (rc >= 0)
-				send_buf->rpos += rc;
+				out->rpos += rc;
 			else if (errno == EAGAIN || errno == EWOULDBLOCK)
 				revents &= ~COIO_WRITE;
 			else if (errno != EINTR)
@@ -540,7 +820,13 @@ check_limit:
 		}
 
 		ev_tstamp deadline = ev_monotonic_now(loop()) + timeout;
-		revents = coio_wait(fd, EV_READ | (ibuf_used(send_buf) != 0 ?
+		/* The decompressor may have data to read already. */
+		if (zstd != NULL && (ibuf_used(&zstd->in) != 0 ||
+				     zstd->is_draining)) {
+			revents = COIO_READ | COIO_WRITE;
+			continue;
+		}
+		revents = coio_wait(fd, EV_READ | (ibuf_used(out) != 0 ?
 				EV_WRITE : 0), timeout);
 		luaL_testcancel(L);
 		timeout = deadline - ev_monotonic_now(loop());
@@ -560,24 +846,24 @@ handle_error:
 static int
 netbox_encode_execute(lua_State *L)
 {
-	if (lua_gettop(L) < 5)
+	if (lua_gettop(L) < 6)
 		return luaL_error(L, "Usage: netbox.encode_execute(ibuf, "\
-				  "sync, query, parameters, options)");
+				  "sync, stream_id, query, parameters, options)");
 	struct mpstream stream;
 	size_t svp = netbox_prepare_request(L, &stream, IPROTO_EXECUTE);
 
 	luamp_encode_map(cfg, &stream, 3);
 
 	size_t len;
-	const char *query = lua_tolstring(L, 3, &len);
+	const char *query = lua_tolstring(L, 4, &len);
 	luamp_encode_uint(cfg, &stream, IPROTO_SQL_TEXT);
 	luamp_encode_str(cfg, &stream, query, len);
 
 	luamp_encode_uint(cfg, &stream, IPROTO_SQL_BIND);
-	luamp_encode_tuple(L, cfg, &stream, 4);
+	luamp_encode_tuple(L, cfg, &stream, 5);
 
 	luamp_encode_uint(cfg, &stream, IPROTO_OPTIONS);
-	luamp_encode_tuple(L, cfg, &stream, 5);
+	luamp_encode_tuple(L, cfg, &stream, 6);
 
 	netbox_encode_request(&stream, svp);
 	return 0;
@@ -726,10 +1012,17 @@ luaopen_net_box(struct lua_State *L)
 {
 	static const luaL_Reg net_box_lib[] = {
 		{ "encode_ping",    netbox_encode_ping },
+		{ "encode_begin",   netbox_encode_begin },
+		{ "encode_commit",  netbox_encode_commit },
+		{ "encode_rollback",netbox_encode_rollback },
+		{ "encode_compress",netbox_encode_compress },
 		{ "encode_call_16", netbox_encode_call_16 },
 		{ "encode_call",    netbox_encode_call },
 		{ "encode_eval",    netbox_encode_eval },
 		{ "encode_select",  netbox_encode_select },
+		{ "encode_cursor_open", netbox_encode_cursor_open },
+		{ "encode_cursor_fetch", netbox_encode_cursor_fetch },
+		{ "encode_cursor_close", netbox_encode_cursor_close },
 		{ "encode_insert",  netbox_encode_insert },
 		{ "encode_replace", netbox_encode_replace },
 		{ "encode_delete",  netbox_encode_delete },
@@ -739,10 +1032,16 @@ luaopen_net_box(struct lua_State *L)
 		{ "encode_auth",    netbox_encode_auth },
 		{ "decode_greeting",netbox_decode_greeting },
 		{ "communicate",    netbox_communicate },
+		{ "zstd_new",       netbox_zstd_new },
 		{ "decode_select",  netbox_decode_select },
 		{ "decode_execute", netbox_decode_execute },
 		{ NULL, NULL}
 	};
+	static const luaL_Reg netbox_zstd_meta[] = {
+		{ "__gc",           netbox_zstd_gc },
+		{ NULL, NULL}
+	};
+	luaL_register_type(L, netbox_zstd_typename, netbox_zstd_meta);
 	/* luaL_register_module polutes _G */
 	lua_newtable(L);
 	luaL_openlib(L, NULL, net_box_lib, 0);
@@ -24,6 +24,7 @@ local check_primary_index = box.internal.check_primary_index
 
 local communicate     = internal.communicate
 local encode_auth     = internal.encode_auth
+local encode_compress = internal.encode_compress
 local encode_select   = internal.encode_select
 local decode_greeting = internal.decode_greeting
 
@@ -36,6 +37,7 @@ local IPROTO_STATUS_KEY    = 0x00
 local IPROTO_ERRNO_MASK    = 0x7FFF
 local IPROTO_SYNC_KEY      = 0x01
 local IPROTO_SCHEMA_VERSION_KEY = 0x05
+local IPROTO_CURSOR_ID_KEY = 0x16
 local IPROTO_METADATA_KEY = 0x32
 local IPROTO_SQL_INFO_KEY = 0x42
 local SQL_INFO_ROW_COUNT_KEY = 0
@@ -49,6 +51,7 @@ local E_UNKNOWN              = box.error.UNKNOWN
 local E_NO_CONNECTION        = box.error.NO_CONNECTION
 local E_TIMEOUT              = box.error.TIMEOUT
 local E_PROC_LUA             = box.error.PROC_LUA
+local E_UNKNOWN_REQUEST_TYPE = box.error.UNKNOWN_REQUEST_TYPE
 
 -- utility tables
 local is_final_state         = {closed = 1, error = 1}
@@ -75,9 +78,16 @@ local function decode_count(raw_data)
     local response, raw_end = decode(raw_data)
     return response[IPROTO_DATA_KEY][1], raw_end
 end
+local function decode_cursor_id(raw_data)
+    local response, raw_end = decode(raw_data)
+    return response[IPROTO_CURSOR_ID_KEY], raw_end
+end
 
 local method_encoder = {
     ping    = internal.encode_ping,
+    begin   = internal.encode_begin,
+    commit  = internal.encode_commit,
+    rollback = internal.encode_rollback,
     call_16 = internal.encode_call_16,
     call_17 = internal.encode_call,
     eval    = internal.encode_eval,
@@ -92,8 +102,11 @@ local method_encoder = {
     min     = internal.encode_select,
     max     = internal.encode_select,
     count   = internal.encode_call,
+    cursor_open = internal.encode_cursor_open,
+    cursor_fetch = internal.encode_cursor_fetch,
+    cursor_close = internal.encode_cursor_close,
     -- inject raw data into connection, used by console and tests
-    inject = function(buf, id, bytes)
+    inject = function(buf, id, stream_id, bytes)
         local ptr = buf:reserve(#bytes)
         ffi.copy(ptr, bytes, #bytes)
         buf.wpos = ptr + #bytes
@@ -102,6 +115,9 @@ local method_encoder = {
 
 local method_decoder = {
     ping    = decode_nil,
+    begin   = decode_nil,
+    commit  = decode_nil,
+    rollback = decode_nil,
     call_16 = internal.decode_select,
     call_17 = decode_data,
     eval    = decode_data,
@@ -116,6 +132,9 @@ local method_decoder = {
     min     = decode_get,
     max     = decode_get,
     count   = decode_count,
+    cursor_open = decode_cursor_id,
+    cursor_fetch = internal.decode_select,
+    cursor_close = decode_nil,
     inject  = decode_data,
 }
 
@@ -229,6 +248,8 @@ local function create_transport(host, port, user, password, callback,
     local worker_fiber
     local send_buf         = buffer.ibuf(buffer.READAHEAD)
     local recv_buf         = buffer.ibuf(buffer.READAHEAD)
+    -- Wire compression state, nil unless negotiated.
+    local wire_zstd
 
     --
     -- Async request metamethods.
@@ -397,6 +418,8 @@ local function create_transport(host, port, user, password, callback,
 
     --
     -- Send a request and do not wait for response.
+    -- Arguments following the method are passed to the method
+    -- encoder, the first of them is a stream id or nil.
     -- @retval nil, error Error occured.
     -- @retval not nil Future object.
     --
@@ -487,7 +510,7 @@ local function create_transport(host, port, user, password, callback,
     -- IO (WORKER FIBER) --
     local function send_and_recv(limit_or_boundary, timeout)
         return communicate(connection:fd(), send_buf, recv_buf,
-                           limit_or_boundary, timeout)
+                           limit_or_boundary, timeout, wire_zstd)
     end
 
     local function send_and_recv_iproto(timeout)
@@ -533,7 +556,8 @@ local function create_transport(host, port, user, password, callback,
     -- tail-recursive calls to each other. Yep, Lua optimizes
     -- such calls, and yep, this is the canonical way to implement
     -- a state machine in Lua.
-    local console_sm, iproto_auth_sm, iproto_schema_sm, iproto_sm, error_sm
+    local console_sm, iproto_compress_sm, iproto_auth_sm, iproto_schema_sm
+    local iproto_sm, error_sm
 
     --
     -- Protocol_sm is a core function of netbox. It calls all
@@ -555,7 +579,7 @@ local function create_transport(host, port, user, password, callback,
             log.warn("Netbox text protocol support is deprecated since 1.10, "..
                      "please use require('console').connect() instead")
             local setup_delimiter = 'require("console").delimiter("$EOF$")\n'
-            method_encoder.inject(send_buf, nil, setup_delimiter)
+            method_encoder.inject(send_buf, nil, nil, setup_delimiter)
             local err, response = send_and_recv_console()
             if err then
                 return error_sm(err, response)
@@ -566,6 +590,9 @@ local function create_transport(host, port, user, password, callback,
             set_state('active')
             return console_sm(rid)
         elseif greeting.protocol == 'Binary' then
+            if callback('compression') then
+                return iproto_compress_sm(greeting.salt)
+            end
             return iproto_auth_sm(greeting.salt)
         else
             return error_sm(E_NO_CONNECTION,
@@ -591,13 +618,34 @@ local function create_transport(host, port, user, password, callback,
         end
     end
 
+    --
+    -- Ask the server to switch the connection to compressed
+    -- wire format. A server which does not support it is
+    -- talked to uncompressed.
+    --
+    iproto_compress_sm = function(salt)
+        encode_compress(send_buf, new_request_id(), nil)
+        local err, hdr, body_rpos = send_and_recv_iproto()
+        if err then
+            return error_sm(err, hdr)
+        end
+        local status = hdr[IPROTO_STATUS_KEY]
+        if status == 0 then
+            wire_zstd = internal.zstd_new()
+        elseif band(status, IPROTO_ERRNO_MASK) ~= E_UNKNOWN_REQUEST_TYPE then
+            local body = decode(body_rpos)
+            return error_sm(E_NO_CONNECTION, body[IPROTO_ERROR_KEY])
+        end
+        return iproto_auth_sm(salt)
+    end
+
     iproto_auth_sm = function(salt)
         set_state('auth')
         if not user or not password then
             set_state('fetch_schema')
             return iproto_schema_sm()
         end
-        encode_auth(send_buf, new_request_id(), user, password, salt)
+        encode_auth(send_buf, new_request_id(), nil, user, password, salt)
         local err, hdr, body_rpos, body_end = send_and_recv_iproto()
         if err then
             return error_sm(err, hdr)
@@ -620,9 +668,11 @@ local function create_transport(host, port, user, password, callback,
         local select2_id = new_request_id()
         local response = {}
         -- fetch everything from space _vspace, 2 = ITER_ALL
-        encode_select(send_buf, select1_id, VSPACE_ID, 0, 2, 0, 0xFFFFFFFF, nil)
+        encode_select(send_buf, select1_id, nil, VSPACE_ID, 0, 2, 0,
+                      0xFFFFFFFF, nil)
         -- fetch everything from space _vindex, 2 = ITER_ALL
-        encode_select(send_buf, select2_id, VINDEX_ID, 0, 2, 0, 0xFFFFFFFF, nil)
+        encode_select(send_buf, select2_id, nil, VINDEX_ID, 0, 2, 0,
+                      0xFFFFFFFF, nil)
         schema_version = nil -- any schema_version will do provided that
                              -- it is consistent across responses
         repeat
@@ -678,6 +728,7 @@ local function create_transport(host, port, user, password, callback,
         if connection then connection:close(); connection = nil end
         send_buf:recycle()
         recv_buf:recycle()
+        wire_zstd = nil
         if state ~= 'closed' then
             if callback('reconnect_timeout') then
                 set_state('error_reconnect', err, msg)
@@ -776,9 +827,12 @@ local console_mt = {
     __metatable = false
 }
 
-local space_metatable, index_metatable
+local space_metatable, index_metatable, cursor_mt
 
 local function new_sm(host, port, opts, connection, greeting)
+    if opts.compression ~= nil and opts.compression ~= 'zstd' then
+        error("Unsupported compression: "..tostring(opts.compression))
+    end
     local user, password = opts.user, opts.password; opts.password = nil
     local last_reconnect_error
     local remote = {host = host, port = port, opts = opts, state = 'initial'}
@@ -816,6 +870,8 @@ local function new_sm(host, port, opts, connection, greeting)
             remote.peer_version_id = greeting.version_id
         elseif what == 'will_fetch_schema' then
             return not opts.console
+        elseif what == 'compression' then
+            return opts.compression == 'zstd'
         elseif what == 'fetch_connect_timeout' then
             return opts.connect_timeout or DEFAULT_CONNECT_TIMEOUT
         elseif what == 'did_fetch_schema' then
@@ -839,6 +895,7 @@ local function new_sm(host, port, opts, connection, greeting)
 
         remote._space_mt = space_metatable(remote)
         remote._index_mt = index_metatable(remote)
+        remote._next_stream_id = 1
         if opts.call_16 then
             remote.call = remote.call_16
             remote.eval = remote.eval_16
@@ -952,7 +1009,8 @@ function remote_methods:_request(method, opts, ...)
     local transport = self._transport
     local buffer = opts and opts.buffer
     if opts and opts.is_async then
-        return transport.perform_async_request(buffer, method, ...)
+        return transport.perform_async_request(buffer, method,
+                                               self._stream_id, ...)
     end
     local deadline
     if opts and opts.timeout then
@@ -968,7 +1026,8 @@ function remote_methods:_request(method, opts, ...)
         transport.wait_state('active', timeout)
         timeout = deadline and max(0, deadline - fiber_clock())
     end
-    local res, err = transport.perform_request(timeout, buffer, method, ...)
+    local res, err = transport.perform_request(timeout, buffer, method,
+                                               self._stream_id, ...)
     if err then
         box.error(err)
     end
@@ -1059,6 +1118,104 @@ function remote_methods:timeout(timeout)
     return self
 end
 
+--
+-- A stream is a view of a connection, which requests are
+-- executed by the server strictly one after another in the order
+-- they were sent. A stream can run an interactive transaction:
+-- stream:begin(), any requests, then stream:commit() or
+-- stream:rollback(). A transaction left open is rolled back
+-- when the connection is closed. memtx spaces can't be used
+-- in a stream transaction.
+--
+local stream_methods = {}
+
+function stream_methods:begin(opts)
+    check_remote_arg(self, 'begin')
+    self:_request('begin', opts)
+end
+
+function stream_methods:commit(opts)
+    check_remote_arg(self, 'commit')
+    self:_request('commit', opts)
+end
+
+function stream_methods:rollback(opts)
+    check_remote_arg(self, 'rollback')
+    self:_request('rollback', opts)
+end
+
+function stream_methods:new_stream()
+    check_remote_arg(self, 'new_stream')
+    return self._conn:new_stream()
+end
+
+--
+-- Spaces of a stream are copies of the connection spaces bound
+-- to the stream. They are rebuilt once the connection schema
+-- changes.
+--
+local function stream_spaces(stream)
+    local conn = stream._conn
+    if stream._schema_version == conn.schema_version then
+        return stream._space
+    end
+    local sl, copies = {}, {}
+    for key, space in pairs(conn.space or {}) do
+        local s = copies[space]
+        if s == nil then
+            s = setmetatable({}, stream._space_mt)
+            for k, v in pairs(space) do
+                s[k] = v
+            end
+            s.connection = stream
+            s.index = {}
+            for ikey, index in pairs(space.index) do
+                local idx = copies[index]
+                if idx == nil then
+                    idx = setmetatable({}, stream._index_mt)
+                    for k, v in pairs(index) do
+                        idx[k] = v
+                    end
+                    idx.space = s
+                    copies[index] = idx
+                end
+                s.index[ikey] = idx
+            end
+            copies[space] = s
+        end
+        sl[key] = s
+    end
+    stream._space = sl
+    stream._schema_version = conn.schema_version
+    return sl
+end
+
+local stream_mt = {
+    __index = function(stream, key)
+        local method = stream_methods[key]
+        if method ~= nil then
+            return method
+        end
+        if key == 'space' then
+            return stream_spaces(stream)
+        end
+        return stream._conn[key]
+    end
+}
+
+function remote_methods:new_stream()
+    check_remote_arg(self, 'new_stream')
+    local stream_id = self._next_stream_id
+    self._next_stream_id = stream_id + 1
+    local stream = setmetatable({
+        _conn = self,
+        _stream_id = stream_id,
+    }, stream_mt)
+    stream._space_mt = space_metatable(stream)
+    stream._index_mt = index_metatable(stream)
+    return stream
+end
+
 function remote_methods:_install_schema(schema_version, spaces, indices)
     local sl, space_mt, index_mt = {}, self._space_mt, self._index_mt
     for _, space in pairs(spaces) do
@@ -1171,10 +1328,10 @@ function console_methods:eval(line, timeout)
     end
     if self.protocol == 'Binary' then
         local loader = 'return require("console").eval(...)'
-        res, err = pr(timeout, nil, 'eval', loader, {line})
+        res, err = pr(timeout, nil, 'eval', nil, loader, {line})
     else
         assert(self.protocol == 'Lua console')
-        res, err = pr(timeout, nil, 'inject', line..'$EOF$\n')
+        res, err = pr(timeout, nil, 'inject', nil, line..'$EOF$\n')
     end
     if err then
         box.error(err)
@@ -1238,6 +1395,34 @@ space_metatable = function(remote)
     return { __index = methods, __metatable = false }
 end
 
+local cursor_methods = {}
+
+function cursor_methods:fetch(limit, opts)
+    if type(self) ~= 'table' or type(limit) ~= 'number' then
+        error('Use cursor:fetch(limit, opts)')
+    end
+    if self.is_exhausted then
+        return {}
+    end
+    local tuples = self.remote:_request('cursor_fetch', opts, self.id,
+                                        limit)
+    self.is_exhausted = #tuples < limit
+    return tuples
+end
+
+function cursor_methods:close(opts)
+    if type(self) ~= 'table' then
+        error('Use cursor:close(opts)')
+    end
+    if self.is_exhausted then
+        return
+    end
+    self.is_exhausted = true
+    self.remote:_request('cursor_close', opts, self.id)
+end
+
+cursor_mt = { __index = cursor_methods }
+
 index_metatable = function(remote)
     local methods = {}
 
@@ -1248,8 +1433,30 @@ index_metatable = function(remote)
         local iterator = check_iterator_type(opts, key_is_nil)
         local offset = tonumber(opts and opts.offset) or 0
         local limit = tonumber(opts and opts.limit) or 0xFFFFFFFF
+        local filter = opts and opts.filter
         return (remote:_request('select', opts, self.space.id, self.id,
-                                iterator, offset, limit, key))
+                                iterator, offset, limit, key, filter))
+    end
+
+    --
+    -- Open a server-side cursor. Unlike select(), the result
+    -- set is not read at once, but in batches by cursor:fetch().
+    -- The cursor is closed on the server when fetch() returns
+    -- less tuples than requested, by cursor:close() or after
+    -- net_cursor_timeout seconds of inactivity.
+    --
+    function methods:cursor(key, opts)
+        check_index_arg(self, 'cursor')
+        local key_is_nil = (key == nil or
+                            (type(key) == 'table' and #key == 0))
+        local iterator = check_iterator_type(opts, key_is_nil)
+        local offset = tonumber(opts and opts.offset) or 0
+        local cursor_id = remote:_request('cursor_open', opts,
+                                          self.space.id, self.id,
+                                          iterator, offset, key)
+        return setmetatable({
+            remote = remote, id = cursor_id, is_exhausted = false,
+        }, cursor_mt)
     end
 
     function methods:get(key, opts)
@@ -93,11 +93,17 @@ ffi.cdef[[
     void
     port_destroy(struct port *port);
 
+    struct tuple_filter;
+
     int
     box_select(uint32_t space_id, uint32_t index_id,
                int iterator, uint32_t offset, uint32_t limit,
                const char *key, const char *key_end,
+               const struct tuple_filter *filter, bool is_cover,
                struct port *port);
+    box_iterator_t *
+    box_index_cover_iterator(uint32_t space_id, uint32_t index_id, int type,
+                             const char *key, const char *key_end);
 
     void password_prepare(const char *password, int len,
                           char *out, int out_len);
@@ -386,6 +392,9 @@ box.schema.space.create = function(name, options)
         user = 'string, number',
         format = 'table',
         temporary = 'boolean',
+        compression = 'string',
+        ttl = 'number',
+        ttl_field = 'string, number',
     }
     local options_defaults = {
         engine = 'memtx',
@@ -426,9 +435,34 @@ box.schema.space.create = function(name, options)
     local format = options.format and options.format or {}
     check_param(format, 'format', 'table')
     format = update_format(format)
+    -- convert the time field, given by name or one-based
+    -- number, to a zero-based field number
+    local ttl_field = options.ttl_field
+    if type(ttl_field) == 'string' then
+        for k, v in pairs(format) do
+            if v.name == ttl_field then
+                ttl_field = k
+                break
+            end
+        end
+        if type(ttl_field) == 'string' then
+            box.error(box.error.ILLEGAL_PARAMS,
+                      "options.ttl_field: field was not found by name '" .. ttl_field .. "'")
+        end
+    elseif ttl_field ~= nil and ttl_field <= 0 then
+        box.error(box.error.ILLEGAL_PARAMS,
+                  "options.ttl_field: field (number) must be one-based")
+    end
+    if options.ttl ~= nil and ttl_field == nil then
+        box.error(box.error.ILLEGAL_PARAMS,
+                  "options.ttl_field is required with options.ttl")
+    end
     -- filter out global parameters from the options array
     local space_options = setmap({
         temporary = options.temporary and true or nil,
+        compression = options.compression,
+        ttl = options.ttl,
+        ttl_field = ttl_field and ttl_field - 1 or nil,
     })
     _space:insert{id, uid, name, options.engine, options.field_count,
         space_options, format}
@@ -612,6 +646,36 @@ local function update_index_parts(format, parts)
     return result, parts_can_be_simplified
 end
 
+--
+-- Convert fields included into an index, given by names or
+-- one-based numbers, to zero-based field numbers.
+--
+local function update_index_include(format, include)
+    local result = setmetatable({}, { __serialize = 'seq' })
+    for i, field in ipairs(include) do
+        if type(field) == 'string' then
+            for k, v in pairs(format) do
+                if v.name == field then
+                    field = k
+                    break
+                end
+            end
+            if type(field) == 'string' then
+                box.error(box.error.ILLEGAL_PARAMS,
+                          "options.include[" .. i .. "]: field was not found by name '" .. field .. "'")
+            end
+        elseif type(field) ~= 'number' then
+            box.error(box.error.ILLEGAL_PARAMS,
+                      "options.include[" .. i .. "]: field (name or number) is expected")
+        elseif field <= 0 then
+            box.error(box.error.ILLEGAL_PARAMS,
+                      "options.include[" .. i .. "]: field (number) must be one-based")
+        end
+        table.insert(result, field - 1)
+    end
+    return result
+end
+
 --
 -- Convert index parts into 1.6.6 format if they
 -- doesn't use collation and is_nullable options
@@ -634,11 +698,13 @@ local index_options = {
     unique = 'boolean',
     dimension = 'number',
     distance = 'string',
+    roaring = 'boolean',
     run_count_per_level = 'number',
     run_size_ratio = 'number',
     range_size = 'number',
     page_size = 'number',
     bloom_fpr = 'number',
+    include = 'table',
 }
 
 --
@@ -738,12 +804,16 @@ box.schema.index.create = function(space_id, name, options)
             dimension = options.dimension,
             unique = options.unique,
             distance = options.distance,
+            roaring = options.roaring,
             page_size = options.page_size,
             range_size = options.range_size,
             run_count_per_level = options.run_count_per_level,
             run_size_ratio = options.run_size_ratio,
             bloom_fpr = options.bloom_fpr,
     }
+    if options.include ~= nil then
+        index_opts.include = update_index_include(format, options.include)
+    end
     local field_type_aliases = {
         num = 'unsigned'; -- Deprecated since 1.7.2
         uint = 'unsigned';
@@ -895,6 +965,9 @@ box.schema.index.alter = function(space_id, index_id, options)
             index_opts[k] = options[k]
         end
     end
+    if options.include ~= nil then
+        index_opts.include = update_index_include(format, options.include)
+    end
     if options.parts then
         local parts_can_be_simplified
         parts, parts_can_be_simplified =
@@ -1087,6 +1160,21 @@ end
 
 internal.check_iterator_type = check_iterator_type -- export for net.box
 
+--
+-- Return true if the fields covered by the index are requested
+-- instead of the tuples, see index_create_cover_iterator().
+--
+local function check_covered_opt(opts)
+    if type(opts) ~= 'table' or opts.covered == nil then
+        return false
+    end
+    if type(opts.covered) ~= 'boolean' then
+        box.error(box.error.ILLEGAL_PARAMS,
+                  "options.covered: boolean expected")
+    end
+    return opts.covered
+end
+
 local base_index_mt = {}
 base_index_mt.__index = base_index_mt
 --
@@ -1184,10 +1272,12 @@ base_index_mt.pairs_ffi = function(index, key, opts)
     check_index_arg(index, 'pairs')
     local pkey, pkey_end = tuple_encode(key)
     local itype = check_iterator_type(opts, pkey + 1 >= pkey_end);
+    local new_iterator = check_covered_opt(opts) and
+        builtin.box_index_cover_iterator or builtin.box_index_iterator
 
     local keybuf = ffi.string(pkey, pkey_end - pkey)
     local pkeybuf = ffi.cast('const char *', keybuf)
-    local cdata = builtin.box_index_iterator(index.space_id, index.id,
+    local cdata = new_iterator(index.space_id, index.id,
         itype, pkeybuf, pkeybuf + #keybuf);
     if cdata == nil then
         box.error()
@@ -1199,9 +1289,11 @@ base_index_mt.pairs_luac = function(index, key, opts)
     check_index_arg(index, 'pairs')
     key = keify(key)
     local itype = check_iterator_type(opts, #key == 0);
+    local is_cover = check_covered_opt(opts)
     local keymp = msgpack.encode(key)
     local keybuf = ffi.string(keymp, #keymp)
-    local cdata = internal.iterator(index.space_id, index.id, itype, keymp);
+    local cdata = internal.iterator(index.space_id, index.id, itype, keymp,
+                                    is_cover);
     return fun.wrap(iterator_gen_luac, keybuf,
         ffi.gc(cdata, builtin.box_iterator_free))
 end
@@ -1260,13 +1352,18 @@ end
 
 base_index_mt.select_ffi = function(index, key, opts)
     check_index_arg(index, 'select')
+    if opts ~= nil and opts.filter ~= nil then
+        -- The filter is compiled from a Lua table in C.
+        return base_index_mt.select_luac(index, key, opts)
+    end
     local key, key_end = tuple_encode(key)
     local iterator, offset, limit = check_select_opts(opts, key + 1 >= key_end)
+    local is_cover = check_covered_opt(opts)
 
     local port = ffi.cast('struct port *', port_tuple)
 
     if builtin.box_select(index.space_id, index.id,
-        iterator, offset, limit, key, key_end, port) ~= 0 then
+        iterator, offset, limit, key, key_end, nil, is_cover, port) ~= 0 then
         return box.error()
     end
 
@@ -1284,8 +1381,10 @@ base_index_mt.select_luac = function(index, key, opts)
     check_index_arg(index, 'select')
     local key = keify(key)
     local iterator, offset, limit = check_select_opts(opts, #key == 0)
+    local filter = opts ~= nil and opts.filter or nil
+    local is_cover = check_covered_opt(opts)
     return internal.select(index.space_id, index.id, iterator,
-        offset, limit, key)
+        offset, limit, key, filter, is_cover)
 end
 
 base_index_mt.update = function(index, key, ops)
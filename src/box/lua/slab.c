@@ -198,6 +198,25 @@ lbox_slab_info(struct lua_State *L)
 	lua_pushstring(L, ratio_buf);
 	lua_settable(L, -3);
 
+	/*
+	 * How much of the touched address space is backed by
+	 * huge pages. Reading the kernel page map is costly,
+	 * so only do it if huge pages were requested.
+	 */
+	size_t huge_size = 0;
+	if (memtx->arena_opts.huge_pages != TUPLE_ARENA_HUGE_PAGES_NONE)
+		huge_size = tuple_arena_huge_size(&memtx->arena);
+	lua_pushstring(L, "arena_huge_size");
+	luaL_pushuint64(L, huge_size);
+	lua_settable(L, -3);
+
+	ratio = 100 * ((double) huge_size / ((double) arena_size + 0.0001));
+	snprintf(ratio_buf, sizeof(ratio_buf), "%0.1lf%%", ratio);
+
+	lua_pushstring(L, "arena_huge_ratio");
+	lua_pushstring(L, ratio_buf);
+	lua_settable(L, -3);
+
 	/*
 	 * This is pretty much the same as
 	 * box.cfg.slab_alloc_arena, but in bytes
@@ -263,6 +282,47 @@ lbox_slab_check(MAYBE_UNUSED struct lua_State *L)
 	return 0;
 }
 
+/** Request a tuple memory defragmentation pass. */
+static int
+lbox_slab_defrag(MAYBE_UNUSED struct lua_State *L)
+{
+	struct memtx_engine *memtx;
+	memtx = (struct memtx_engine *)engine_by_name("memtx");
+	memtx_defrag_request(&memtx->defrag);
+	return 0;
+}
+
+static int
+lbox_slab_defrag_stat(struct lua_State *L)
+{
+	struct memtx_engine *memtx;
+	memtx = (struct memtx_engine *)engine_by_name("memtx");
+	struct memtx_defrag *defrag = &memtx->defrag;
+	lua_newtable(L);
+
+	lua_pushstring(L, "passes");
+	luaL_pushuint64(L, defrag->stat.passes);
+	lua_settable(L, -3);
+
+	lua_pushstring(L, "moved");
+	luaL_pushuint64(L, defrag->stat.moved);
+	lua_settable(L, -3);
+
+	lua_pushstring(L, "moved_bytes");
+	luaL_pushuint64(L, defrag->stat.moved_bytes);
+	lua_settable(L, -3);
+
+	lua_pushstring(L, "reclaimed");
+	luaL_pushuint64(L, defrag->stat.reclaimed);
+	lua_settable(L, -3);
+
+	lua_pushstring(L, "running");
+	lua_pushboolean(L, defrag->is_running);
+	lua_settable(L, -3);
+
+	return 1;
+}
+
 /** Initialize box.slab package. */
 void
 box_lua_slab_init(struct lua_State *L)
@@ -283,6 +343,14 @@ box_lua_slab_init(struct lua_State *L)
 	lua_pushcfunction(L, lbox_slab_check);
 	lua_settable(L, -3);
 
+	lua_pushstring(L, "defrag");
+	lua_pushcfunction(L, lbox_slab_defrag);
+	lua_settable(L, -3);
+
+	lua_pushstring(L, "defrag_stat");
+	lua_pushcfunction(L, lbox_slab_defrag_stat);
+	lua_settable(L, -3);
+
 	lua_settable(L, -3); /* box.slab */
 
 	lua_pushstring(L, "runtime");
@@ -58,12 +58,18 @@ lbox_push_txn_stmt(struct lua_State *L, void *event)
 	struct txn_stmt *stmt = txn_current_stmt((struct txn *) event);
 
 	if (stmt->old_tuple) {
-		luaT_pushtuple(L, stmt->old_tuple);
+		struct tuple *tuple = tuple_unpack(stmt->old_tuple);
+		if (tuple == NULL)
+			diag_raise();
+		luaT_pushtuple(L, tuple);
 	} else {
 		lua_pushnil(L);
 	}
 	if (stmt->new_tuple) {
-		luaT_pushtuple(L, stmt->new_tuple);
+		struct tuple *tuple = tuple_unpack(stmt->new_tuple);
+		if (tuple == NULL)
+			diag_raise();
+		luaT_pushtuple(L, tuple);
 	} else {
 		lua_pushnil(L);
 	}
@@ -261,6 +267,9 @@ lbox_fillspace(struct lua_State *L, struct space *space, int i)
 		} else if (index_def->type == RTREE) {
 			lua_pushnumber(L, index_opts->dimension);
 			lua_setfield(L, -2, "dimension");
+		} else if (index_def->type == BITSET) {
+			lua_pushboolean(L, index_opts->is_roaring);
+			lua_setfield(L, -2, "roaring");
 		}
 
 		lua_pushstring(L, index_type_strs[index_def->type]);
@@ -33,6 +33,7 @@
 
 #include <string.h>
 #include <rmean.h>
+#include <latency.h>
 
 #include <lua.h>
 #include <lauxlib.h>
@@ -40,7 +41,9 @@
 
 #include "box/box.h"
 #include "box/iproto.h"
+#include "box/memtx_engine.h"
 #include "lua/utils.h"
+#include "coio_task.h"
 
 extern struct rmean *rmean_box;
 extern struct rmean *rmean_error;
@@ -117,13 +120,52 @@ lbox_stat_reset(struct lua_State *L)
 	(void)L;
 	box_reset_stat();
 	iproto_reset_stat();
+	coio_reset_stat();
 	return 0;
 }
 
+/**
+ * An iproto_latency_foreach() callback, which pushes latency
+ * percentiles of a request type to the table on top of the
+ * stack, e.g. box.stat.net.LATENCY.SELECT.wal.p99.
+ */
+static int
+set_latency_item(const char *name, struct latency *latency, void *cb_ctx)
+{
+	struct lua_State *L = (struct lua_State *) cb_ctx;
+	static const int pcts[] = { 50, 90, 99 };
+
+	lua_pushstring(L, name);
+	lua_newtable(L);
+	for (int i = 0; i < iproto_latency_phase_MAX; i++) {
+		lua_pushstring(L, iproto_latency_phase_strs[i]);
+		lua_newtable(L);
+		for (size_t j = 0; j < lengthof(pcts); j++) {
+			lua_pushfstring(L, "p%d", pcts[j]);
+			lua_pushnumber(L, latency_get(&latency[i], pcts[j]));
+			lua_settable(L, -3);
+		}
+		lua_settable(L, -3);
+	}
+	lua_settable(L, -3);
+	return 0;
+}
+
+static void
+push_latency(struct lua_State *L)
+{
+	lua_newtable(L);
+	iproto_latency_foreach(set_latency_item, L);
+}
+
 static int
 lbox_stat_net_index(struct lua_State *L)
 {
-	luaL_checkstring(L, -1);
+	const char *key = luaL_checkstring(L, -1);
+	if (strcmp(key, "LATENCY") == 0) {
+		push_latency(L);
+		return 1;
+	}
 	return rmean_foreach(rmean_net, seek_stat_item, L);
 }
 
@@ -132,6 +174,84 @@ lbox_stat_net_call(struct lua_State *L)
 {
 	lua_newtable(L);
 	rmean_foreach(rmean_net, set_stat_item, L);
+	lua_pushstring(L, "LATENCY");
+	push_latency(L);
+	lua_settable(L, -3);
+	return 1;
+}
+
+/**
+ * Push coio task statistics of a priority class,
+ * e.g. box.stat.coio.bulk.
+ */
+static void
+push_coio_stat(struct lua_State *L, enum coio_class cls)
+{
+	struct coio_class_stat stat;
+	coio_class_stat(cls, &stat);
+	lua_newtable(L);
+	lua_pushstring(L, "queued");
+	lua_pushnumber(L, stat.queued);
+	lua_settable(L, -3);
+	lua_pushstring(L, "running");
+	lua_pushnumber(L, stat.running);
+	lua_settable(L, -3);
+	lua_pushstring(L, "total");
+	lua_pushnumber(L, stat.total);
+	lua_settable(L, -3);
+	lua_pushstring(L, "queue_time");
+	lua_newtable(L);
+	lua_pushstring(L, "avg");
+	lua_pushnumber(L, stat.total == 0 ? 0 : stat.queue_time / stat.total);
+	lua_settable(L, -3);
+	lua_pushstring(L, "max");
+	lua_pushnumber(L, stat.queue_time_max);
+	lua_settable(L, -3);
+	lua_settable(L, -3);
+}
+
+static int
+lbox_stat_coio_index(struct lua_State *L)
+{
+	const char *key = luaL_checkstring(L, -1);
+	for (int cls = 0; cls < coio_class_MAX; cls++) {
+		if (strcmp(key, coio_class_strs[cls]) == 0) {
+			push_coio_stat(L, cls);
+			return 1;
+		}
+	}
+	return 0;
+}
+
+static int
+lbox_stat_coio_call(struct lua_State *L)
+{
+	lua_newtable(L);
+	for (int cls = 0; cls < coio_class_MAX; cls++) {
+		lua_pushstring(L, coio_class_strs[cls]);
+		push_coio_stat(L, cls);
+		lua_settable(L, -3);
+	}
+	return 1;
+}
+
+/** Push tuple expiration statistics, box.stat.expire(). */
+static int
+lbox_stat_expire(struct lua_State *L)
+{
+	struct memtx_engine *memtx;
+	memtx = (struct memtx_engine *)engine_by_name("memtx");
+	struct memtx_expire_stat *stat = &memtx->expire.stat;
+	lua_newtable(L);
+	lua_pushstring(L, "expired");
+	luaL_pushuint64(L, stat->expired);
+	lua_settable(L, -3);
+	lua_pushstring(L, "batches");
+	luaL_pushuint64(L, stat->batches);
+	lua_settable(L, -3);
+	lua_pushstring(L, "errors");
+	luaL_pushuint64(L, stat->errors);
+	lua_settable(L, -3);
 	return 1;
 }
 
@@ -147,6 +267,12 @@ static const struct luaL_Reg lbox_stat_net_meta [] = {
 	{NULL, NULL}
 };
 
+static const struct luaL_Reg lbox_stat_coio_meta [] = {
+	{"__index", lbox_stat_coio_index},
+	{"__call",  lbox_stat_coio_call},
+	{NULL, NULL}
+};
+
 /** Initialize box.stat package. */
 void
 box_lua_stat_init(struct lua_State *L)
@@ -158,6 +284,9 @@ box_lua_stat_init(struct lua_State *L)
 
 	luaL_register_module(L, "box.stat", statlib);
 
+	lua_pushcfunction(L, lbox_stat_expire);
+	lua_setfield(L, -2, "expire");
+
 	lua_newtable(L);
 	luaL_register(L, NULL, lbox_stat_meta);
 	lua_setmetatable(L, -2);
@@ -170,5 +299,12 @@ box_lua_stat_init(struct lua_State *L)
 	luaL_register(L, NULL, lbox_stat_net_meta);
 	lua_setmetatable(L, -2);
 	lua_pop(L, 1); /* stat net module */
+
+	luaL_register_module(L, "box.stat.coio", statlib);
+
+	lua_newtable(L);
+	luaL_register(L, NULL, lbox_stat_coio_meta);
+	lua_setmetatable(L, -2);
+	lua_pop(L, 1); /* stat coio module */
 }
 
@@ -211,6 +211,15 @@ memtx_bitset_index_destroy(struct index *base)
 	free(index);
 }
 
+static bool
+memtx_bitset_index_def_change_requires_rebuild(struct index *index,
+					       const struct index_def *new_def)
+{
+	if (memtx_index_def_change_requires_rebuild(index, new_def))
+		return true;
+	return index->def->opts.is_roaring != new_def->opts.is_roaring;
+}
+
 static ssize_t
 memtx_bitset_index_size(struct index *base)
 {
@@ -463,7 +472,7 @@ static const struct index_vtab memtx_bitset_index_vtab = {
 	/* .update_def = */ generic_index_update_def,
 	/* .depends_on_pk = */ generic_index_depends_on_pk,
 	/* .def_change_requires_rebuild = */
-		memtx_index_def_change_requires_rebuild,
+		memtx_bitset_index_def_change_requires_rebuild,
 	/* .size = */ memtx_bitset_index_size,
 	/* .bsize = */ memtx_bitset_index_bsize,
 	/* .min = */ generic_index_min,
@@ -473,6 +482,7 @@ static const struct index_vtab memtx_bitset_index_vtab = {
 	/* .get = */ generic_index_get,
 	/* .replace = */ memtx_bitset_index_replace,
 	/* .create_iterator = */ memtx_bitset_index_create_iterator,
+	/* .create_cover_iterator = */ generic_index_create_cover_iterator,
 	/* .create_snapshot_iterator = */
 		generic_index_create_snapshot_iterator,
 	/* .info = */ generic_index_info,
@@ -521,6 +531,9 @@ memtx_bitset_index_new(struct memtx_engine *memtx, struct index_def *def)
 		panic("failed to allocate memtx bitset index");
 #endif /* #ifndef OLD_GOOD_BITSET */
 
-	bitset_index_create(&index->index, realloc);
+	if (def->opts.is_roaring)
+		bitset_index_create_roaring(&index->index, realloc);
+	else
+		bitset_index_create(&index->index, realloc);
 	return index;
 }
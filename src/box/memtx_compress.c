@@ -0,0 +1,565 @@
+/*
+ * Copyright 2010-2019, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include "memtx_compress.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <msgpuck.h>
+#include <small/region.h>
+#include <zstd.h>
+#include <zdict.h>
+
+#include "fiber.h"
+#include "diag.h"
+#include "say.h"
+#include "key_def.h"
+#include "tuple_format.h"
+#include "memtx_engine.h"
+
+enum {
+	/** Size of samples to train a dictionary on. */
+	MEMTX_ZSTD_SAMPLE_SIZE = 512 * 1024,
+	/** Max size of one sample, longer tuples are cut. */
+	MEMTX_ZSTD_SAMPLE_SIZE_MAX = MEMTX_ZSTD_SAMPLE_SIZE / 16,
+	/** Max number of samples to train a dictionary on. */
+	MEMTX_ZSTD_SAMPLE_COUNT = 16 * 1024,
+	/** Max size of a dictionary. */
+	MEMTX_ZSTD_DICT_SIZE = 32 * 1024,
+	/** zstd compression level. */
+	MEMTX_ZSTD_LEVEL = 3,
+};
+
+struct memtx_zstd_dict {
+	/**
+	 * Number of spaces using the dictionary plus
+	 * the number of tuples compressed with it. Changed
+	 * only in the tx thread: read views in other threads
+	 * don't reference dictionaries, see
+	 * memtx_zstd_set_delayed_free().
+	 */
+	int64_t refs;
+	/**
+	 * Digested dictionary, NULL if training failed and
+	 * tuples are compressed without a dictionary.
+	 */
+	ZSTD_CDict *cdict;
+	ZSTD_DDict *ddict;
+	/** Link in the list of unreferenced dictionaries. */
+	struct memtx_zstd_dict *next_garbage;
+};
+
+/** zstd contexts of the tx thread, created on demand. */
+static ZSTD_CCtx *memtx_zstd_cctx;
+static ZSTD_DCtx *memtx_zstd_dctx;
+
+/** Set while tuple memory is freed in the delayed mode. */
+static bool memtx_zstd_is_delayed_free;
+/**
+ * Dictionaries which were unreferenced in the delayed free
+ * mode, freed when the mode is left.
+ */
+static struct memtx_zstd_dict *memtx_zstd_garbage;
+
+static void
+memtx_zstd_dict_delete(struct memtx_zstd_dict *dict)
+{
+	ZSTD_freeCDict(dict->cdict);
+	ZSTD_freeDDict(dict->ddict);
+	free(dict);
+}
+
+void
+memtx_zstd_dict_ref(struct memtx_zstd_dict *dict)
+{
+	assert(cord_is_main());
+	dict->refs++;
+}
+
+void
+memtx_zstd_dict_unref(struct memtx_zstd_dict *dict)
+{
+	assert(cord_is_main());
+	assert(dict->refs > 0);
+	if (--dict->refs > 0)
+		return;
+	if (memtx_zstd_is_delayed_free) {
+		/*
+		 * Tuples compressed with the dictionary may
+		 * still be read by a read view.
+		 */
+		dict->next_garbage = memtx_zstd_garbage;
+		memtx_zstd_garbage = dict;
+		return;
+	}
+	memtx_zstd_dict_delete(dict);
+}
+
+void
+memtx_zstd_set_delayed_free(bool is_delayed)
+{
+	memtx_zstd_is_delayed_free = is_delayed;
+	if (is_delayed)
+		return;
+	while (memtx_zstd_garbage != NULL) {
+		struct memtx_zstd_dict *dict = memtx_zstd_garbage;
+		memtx_zstd_garbage = dict->next_garbage;
+		memtx_zstd_dict_delete(dict);
+	}
+}
+
+/**
+ * Train a dictionary on the collected samples. If training
+ * fails, tuples are compressed without a dictionary.
+ */
+static struct memtx_zstd_dict *
+memtx_zstd_dict_train(const char *samples, const size_t *sample_sizes,
+		      uint32_t sample_count)
+{
+	struct memtx_zstd_dict *dict = calloc(1, sizeof(*dict));
+	if (dict == NULL) {
+		diag_set(OutOfMemory, sizeof(*dict), "calloc", "dict");
+		return NULL;
+	}
+	dict->refs = 1;
+	char *buf = malloc(MEMTX_ZSTD_DICT_SIZE);
+	if (buf == NULL) {
+		diag_set(OutOfMemory, MEMTX_ZSTD_DICT_SIZE, "malloc", "dict");
+		free(dict);
+		return NULL;
+	}
+	size_t size = ZDICT_trainFromBuffer(buf, MEMTX_ZSTD_DICT_SIZE, samples,
+					    sample_sizes, sample_count);
+	if (ZDICT_isError(size)) {
+		say_warn("failed to train tuple compression dictionary: %s",
+			 ZDICT_getErrorName(size));
+		free(buf);
+		return dict;
+	}
+	dict->cdict = ZSTD_createCDict(buf, size, MEMTX_ZSTD_LEVEL);
+	dict->ddict = ZSTD_createDDict(buf, size);
+	free(buf);
+	if (dict->cdict == NULL || dict->ddict == NULL) {
+		say_warn("failed to load tuple compression dictionary");
+		ZSTD_freeCDict(dict->cdict);
+		ZSTD_freeDDict(dict->ddict);
+		dict->cdict = NULL;
+		dict->ddict = NULL;
+		return dict;
+	}
+	say_verbose("trained %zu byte tuple compression dictionary "
+		    "on %u samples", size, (unsigned)sample_count);
+	return dict;
+}
+
+void
+memtx_compressor_create(struct memtx_compressor *compressor)
+{
+	memset(compressor, 0, sizeof(*compressor));
+}
+
+static void
+memtx_compressor_free_samples(struct memtx_compressor *compressor)
+{
+	free(compressor->samples);
+	free(compressor->sample_sizes);
+	compressor->samples = NULL;
+	compressor->sample_sizes = NULL;
+	compressor->samples_size = 0;
+	compressor->sample_count = 0;
+}
+
+void
+memtx_compressor_destroy(struct memtx_compressor *compressor)
+{
+	if (compressor->dict != NULL)
+		memtx_zstd_dict_unref(compressor->dict);
+	memtx_compressor_free_samples(compressor);
+}
+
+void
+memtx_compressor_inherit(struct memtx_compressor *dst,
+			 struct memtx_compressor *src)
+{
+	assert(dst->dict == NULL);
+	if (src->dict == NULL)
+		return;
+	memtx_zstd_dict_ref(src->dict);
+	dst->dict = src->dict;
+	memtx_compressor_free_samples(dst);
+}
+
+/**
+ * Add a tuple to the training samples. Train the dictionary
+ * once enough samples are collected.
+ */
+static void
+memtx_compressor_add_sample(struct memtx_compressor *compressor,
+			    const char *data, size_t size)
+{
+	if (compressor->samples == NULL) {
+		compressor->samples = malloc(MEMTX_ZSTD_SAMPLE_SIZE);
+		compressor->sample_sizes = malloc(MEMTX_ZSTD_SAMPLE_COUNT *
+					sizeof(*compressor->sample_sizes));
+		if (compressor->samples == NULL ||
+		    compressor->sample_sizes == NULL) {
+			/* Try again with the next tuple. */
+			memtx_compressor_free_samples(compressor);
+			return;
+		}
+	}
+	size = MIN(size, (size_t)MEMTX_ZSTD_SAMPLE_SIZE_MAX);
+	if (compressor->samples_size + size <= MEMTX_ZSTD_SAMPLE_SIZE) {
+		memcpy(compressor->samples + compressor->samples_size,
+		       data, size);
+		compressor->samples_size += size;
+		compressor->sample_sizes[compressor->sample_count++] = size;
+		if (compressor->sample_count < MEMTX_ZSTD_SAMPLE_COUNT)
+			return;
+	}
+	/*
+	 * Training blocks the tx thread, but it is done only
+	 * once per space and takes a few tens of milliseconds
+	 * on this amount of samples.
+	 */
+	compressor->dict = memtx_zstd_dict_train(compressor->samples,
+						 compressor->sample_sizes,
+						 compressor->sample_count);
+	if (compressor->dict == NULL)
+		diag_log();
+	memtx_compressor_free_samples(compressor);
+}
+
+/**
+ * Build the key image of a tuple: the indexed fields at their
+ * positions, other fields replaced with nil. The image is
+ * allocated on the fiber region.
+ */
+static char *
+memtx_zstd_key_image(struct tuple_format *format, const char *data,
+		     const char *end, uint32_t *size)
+{
+	char *image = region_alloc(&fiber()->gc, end - data);
+	if (image == NULL) {
+		diag_set(OutOfMemory, end - data, "region", "key image");
+		return NULL;
+	}
+	const char *pos = data;
+	uint32_t field_count = mp_decode_array(&pos);
+	uint32_t image_field_count = MIN(field_count,
+					 format->index_field_count);
+	char *wpos = mp_encode_array(image, image_field_count);
+	for (uint32_t i = 0; i < image_field_count; i++) {
+		const char *field = pos;
+		mp_next(&pos);
+		if (format->fields[i].is_key_part) {
+			memcpy(wpos, field, pos - field);
+			wpos += pos - field;
+		} else {
+			wpos = mp_encode_nil(wpos);
+		}
+	}
+	/* Every MessagePack value takes at least one byte. */
+	assert(wpos <= image + (end - data));
+	*size = wpos - image;
+	return image;
+}
+
+/** Fill the field map of a tuple pointing into its key image. */
+static void
+memtx_zstd_init_field_map(struct tuple_format *format, struct tuple *tuple)
+{
+	char *image = (char *)tuple_data(tuple);
+	uint32_t slot_size = field_map_slot_size(tuple->bsize);
+	size_t field_map_size = tuple_format_field_map_size(format,
+							    tuple->bsize);
+	/* Key fields absent in the tuple have zero offsets. */
+	memset(image - field_map_size, 0, field_map_size);
+	const char *pos = image;
+	uint32_t field_count = mp_decode_array(&pos);
+	for (uint32_t i = 0; i < field_count; i++) {
+		int32_t slot = format->fields[i].offset_slot;
+		if (slot != TUPLE_OFFSET_SLOT_NIL)
+			field_map_set_offset(image, slot_size, slot,
+					     pos - image);
+		mp_next(&pos);
+	}
+}
+
+static ZSTD_CCtx *
+memtx_zstd_get_cctx(void)
+{
+	if (memtx_zstd_cctx == NULL) {
+		memtx_zstd_cctx = ZSTD_createCCtx();
+		if (memtx_zstd_cctx == NULL)
+			diag_set(OutOfMemory, 0, "ZSTD_createCCtx", "cctx");
+	}
+	return memtx_zstd_cctx;
+}
+
+/**
+ * Create a compressed tuple. Fall back on a plain tuple if
+ * compression doesn't save memory.
+ */
+static struct tuple *
+memtx_zstd_tuple_new(struct memtx_zstd_dict *dict,
+		     struct tuple_format *format,
+		     const char *data, const char *end)
+{
+	struct region *gc = &fiber()->gc;
+	size_t size = end - data;
+	/* Validate the tuple before spending time on compression. */
+	size_t map_size = tuple_format_field_map_size(format, size);
+	char *map = region_alloc(gc, map_size);
+	if (map == NULL && map_size > 0) {
+		diag_set(OutOfMemory, map_size, "region", "field map");
+		return NULL;
+	}
+	if (tuple_init_field_map(format, map + map_size,
+				 field_map_slot_size(size), data) != 0)
+		return NULL;
+
+	ZSTD_CCtx *cctx = memtx_zstd_get_cctx();
+	if (cctx == NULL)
+		return NULL;
+	size_t bound = ZSTD_compressBound(size);
+	char *frame = region_alloc(gc, bound);
+	if (frame == NULL) {
+		diag_set(OutOfMemory, bound, "region", "zstd frame");
+		return NULL;
+	}
+	size_t zsize;
+	if (dict->cdict != NULL) {
+		zsize = ZSTD_compress_usingCDict(cctx, frame, bound,
+						 data, size, dict->cdict);
+	} else {
+		zsize = ZSTD_compressCCtx(cctx, frame, bound, data, size,
+					  MEMTX_ZSTD_LEVEL);
+	}
+	if (ZSTD_isError(zsize)) {
+		diag_set(ClientError, ER_COMPRESSION,
+			 ZSTD_getErrorName(zsize));
+		return NULL;
+	}
+	uint32_t image_size;
+	char *image = memtx_zstd_key_image(format, data, end, &image_size);
+	if (image == NULL)
+		return NULL;
+	if (image_size + zsize >= size)
+		return memtx_tuple_new(format, data, end);
+
+	struct tuple *tuple = memtx_tuple_alloc(format, image_size, zsize);
+	if (tuple == NULL)
+		return NULL;
+	char *raw = (char *)tuple_data(tuple);
+	memcpy(raw, image, image_size);
+	memcpy(raw + image_size, frame, zsize);
+	memtx_zstd_init_field_map(format, tuple);
+	memtx_zstd_header(tuple)->dict = dict;
+	memtx_zstd_dict_ref(dict);
+	return tuple;
+}
+
+struct tuple *
+memtx_compressor_tuple_new(struct memtx_compressor *compressor,
+			   struct tuple_format *format,
+			   const char *data, const char *end)
+{
+	assert(memtx_format_is_compressed(format));
+	if (compressor->dict == NULL) {
+		memtx_compressor_add_sample(compressor, data, end - data);
+		return memtx_tuple_new(format, data, end);
+	}
+	struct region *gc = &fiber()->gc;
+	size_t used = region_used(gc);
+	struct tuple *tuple = memtx_zstd_tuple_new(compressor->dict, format,
+						   data, end);
+	region_truncate(gc, used);
+	return tuple;
+}
+
+/** Decompress a tuple to a buffer of the given capacity. */
+static int
+memtx_zstd_decompress(ZSTD_DCtx *dctx, const struct tuple *tuple,
+		      char *buf, size_t capacity)
+{
+	struct memtx_zstd_header *header = memtx_zstd_header(tuple);
+	const char *frame = tuple_data(tuple) + tuple->bsize;
+	size_t size;
+	if (header->dict->ddict != NULL) {
+		size = ZSTD_decompress_usingDDict(dctx, buf, capacity, frame,
+						  header->zsize,
+						  header->dict->ddict);
+	} else {
+		size = ZSTD_decompressDCtx(dctx, buf, capacity, frame,
+					   header->zsize);
+	}
+	if (ZSTD_isError(size) || size != capacity) {
+		diag_set(ClientError, ER_DECOMPRESSION,
+			 ZSTD_isError(size) ? ZSTD_getErrorName(size) :
+			 "unexpected tuple size");
+		return -1;
+	}
+	return 0;
+}
+
+/** Size of the original data of a compressed tuple. */
+static size_t
+memtx_zstd_raw_size(const struct tuple *tuple)
+{
+	const char *frame = tuple_data(tuple) + tuple->bsize;
+	unsigned long long size = ZSTD_getFrameContentSize(frame,
+					memtx_zstd_header(tuple)->zsize);
+	/* The size is always stored in frames we write. */
+	assert(size != ZSTD_CONTENTSIZE_UNKNOWN &&
+	       size != ZSTD_CONTENTSIZE_ERROR);
+	return size;
+}
+
+const char *
+memtx_tuple_decompress(const struct tuple *tuple, uint32_t *size)
+{
+	if (!memtx_tuple_is_compressed(tuple))
+		return tuple_data_range(tuple, size);
+	if (memtx_zstd_dctx == NULL) {
+		memtx_zstd_dctx = ZSTD_createDCtx();
+		if (memtx_zstd_dctx == NULL) {
+			diag_set(OutOfMemory, 0, "ZSTD_createDCtx", "dctx");
+			return NULL;
+		}
+	}
+	size_t raw_size = memtx_zstd_raw_size(tuple);
+	char *buf = region_alloc(&fiber()->gc, raw_size);
+	if (buf == NULL) {
+		diag_set(OutOfMemory, raw_size, "region", "tuple data");
+		return NULL;
+	}
+	if (memtx_zstd_decompress(memtx_zstd_dctx, tuple, buf, raw_size) != 0)
+		return NULL;
+	*size = raw_size;
+	return buf;
+}
+
+struct tuple *
+memtx_zstd_tuple_unpack(struct tuple_format *format, struct tuple *tuple)
+{
+	if (memtx_zstd_header(tuple)->dict == NULL)
+		return tuple;
+	struct region *gc = &fiber()->gc;
+	size_t used = region_used(gc);
+	uint32_t size;
+	const char *data = memtx_tuple_decompress(tuple, &size);
+	struct tuple *result = NULL;
+	if (data != NULL)
+		result = tuple_new(format->unpack_format, data, data + size);
+	region_truncate(gc, used);
+	return result;
+}
+
+int
+memtx_tuple_validate(struct tuple_format *format, struct tuple *tuple)
+{
+	if (!memtx_tuple_is_compressed(tuple))
+		return tuple_validate(format, tuple);
+	struct region *gc = &fiber()->gc;
+	size_t used = region_used(gc);
+	uint32_t size;
+	const char *data = memtx_tuple_decompress(tuple, &size);
+	int rc = data != NULL ? tuple_validate_raw(format, data) : -1;
+	region_truncate(gc, used);
+	return rc;
+}
+
+bool
+memtx_tuple_has_key(const struct tuple *tuple, const struct key_def *key_def)
+{
+	if (!memtx_tuple_is_compressed(tuple))
+		return true;
+	struct tuple_format *format = tuple_format(tuple);
+	for (uint32_t i = 0; i < key_def->part_count; i++) {
+		uint32_t fieldno = key_def->parts[i].fieldno;
+		if (fieldno >= format->field_count ||
+		    !format->fields[fieldno].is_key_part)
+			return false;
+	}
+	return true;
+}
+
+void
+memtx_decompressor_create(struct memtx_decompressor *decompressor)
+{
+	memset(decompressor, 0, sizeof(*decompressor));
+}
+
+void
+memtx_decompressor_destroy(struct memtx_decompressor *decompressor)
+{
+	ZSTD_freeDCtx((ZSTD_DCtx *)decompressor->dctx);
+	free(decompressor->buf);
+}
+
+const char *
+memtx_decompressor_data(struct memtx_decompressor *decompressor,
+			const struct tuple *tuple, uint32_t *size)
+{
+	if (!memtx_tuple_is_compressed(tuple))
+		return tuple_data_range(tuple, size);
+	if (decompressor->dctx == NULL) {
+		decompressor->dctx = ZSTD_createDCtx();
+		if (decompressor->dctx == NULL) {
+			diag_set(OutOfMemory, 0, "ZSTD_createDCtx", "dctx");
+			return NULL;
+		}
+	}
+	size_t raw_size = memtx_zstd_raw_size(tuple);
+	if (raw_size > decompressor->capacity) {
+		char *buf = realloc(decompressor->buf, raw_size);
+		if (buf == NULL) {
+			diag_set(OutOfMemory, raw_size, "realloc", "buf");
+			return NULL;
+		}
+		decompressor->buf = buf;
+		decompressor->capacity = raw_size;
+	}
+	if (memtx_zstd_decompress((ZSTD_DCtx *)decompressor->dctx, tuple,
+				  decompressor->buf, raw_size) != 0)
+		return NULL;
+	*size = raw_size;
+	return decompressor->buf;
+}
+
+void
+memtx_zstd_free(void)
+{
+	ZSTD_freeCCtx(memtx_zstd_cctx);
+	ZSTD_freeDCtx(memtx_zstd_dctx);
+	memtx_zstd_cctx = NULL;
+	memtx_zstd_dctx = NULL;
+}
@@ -0,0 +1,211 @@
+#ifndef TARANTOOL_BOX_MEMTX_COMPRESS_H_INCLUDED
+#define TARANTOOL_BOX_MEMTX_COMPRESS_H_INCLUDED
+/*
+ * Copyright 2010-2019, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "trivia/util.h"
+#include "tuple.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+struct key_def;
+struct memtx_zstd_dict;
+
+/**
+ * Tuple compression in memtx.
+ *
+ * Tuples of a space with compression = 'zstd' are stored as
+ *
+ *   memtx_zstd_header | field map | key image | zstd frame
+ *
+ * The key image is a MessagePack array holding the indexed
+ * fields of the tuple at their original positions with all
+ * other fields replaced by nil, so the field map, comparators
+ * and key extraction work on it as on plain tuple data. The
+ * zstd frame holds the whole original tuple, compressed with
+ * a dictionary trained from the first tuples of the space.
+ *
+ * Until the dictionary is trained, and whenever compression
+ * doesn't pay off, tuples are stored plain (header->dict is
+ * NULL). A compressed tuple is decompressed into a new plain
+ * tuple of tuple_format::unpack_format, allocated from the
+ * runtime arena, when it is returned to the user, see
+ * tuple_unpack().
+ */
+struct PACKED memtx_zstd_header {
+	/** Dictionary the tuple is compressed with or NULL. */
+	struct memtx_zstd_dict *dict;
+	/** Size of the zstd frame following the key image. */
+	uint32_t zsize;
+};
+
+extern struct tuple_format_vtab memtx_zstd_tuple_format_vtab;
+
+struct tuple *
+memtx_zstd_tuple_unpack(struct tuple_format *format, struct tuple *tuple);
+
+/** Return true if tuples of the format may be compressed. */
+static inline bool
+memtx_format_is_compressed(const struct tuple_format *format)
+{
+	return format->vtab.tuple_unpack == memtx_zstd_tuple_unpack;
+}
+
+static inline struct memtx_zstd_header *
+memtx_zstd_header(const struct tuple *tuple)
+{
+	return (struct memtx_zstd_header *)tuple_extra(tuple);
+}
+
+/** Return true if the tuple data is compressed. */
+static inline bool
+memtx_tuple_is_compressed(const struct tuple *tuple)
+{
+	return memtx_format_is_compressed(tuple_format(tuple)) &&
+	       memtx_zstd_header(tuple)->dict != NULL;
+}
+
+/** Size of the data stored in a tuple, compressed or not. */
+static inline size_t
+memtx_tuple_stored_bsize(const struct tuple *tuple)
+{
+	size_t size = tuple->bsize;
+	if (memtx_format_is_compressed(tuple_format(tuple)))
+		size += memtx_zstd_header(tuple)->zsize;
+	return size;
+}
+
+void
+memtx_zstd_dict_ref(struct memtx_zstd_dict *dict);
+
+void
+memtx_zstd_dict_unref(struct memtx_zstd_dict *dict);
+
+/**
+ * Enter or leave the delayed free mode. While a read view
+ * is open, tuples deleted in the tx thread are freed only
+ * once the read view is closed, and so are dictionaries the
+ * read view may need to decompress them.
+ */
+void
+memtx_zstd_set_delayed_free(bool is_delayed);
+
+/** Compression state of a memtx space. */
+struct memtx_compressor {
+	/** Trained dictionary, NULL while samples are collected. */
+	struct memtx_zstd_dict *dict;
+	/** Samples of tuple data to train the dictionary on. */
+	char *samples;
+	size_t samples_size;
+	size_t *sample_sizes;
+	uint32_t sample_count;
+};
+
+void
+memtx_compressor_create(struct memtx_compressor *compressor);
+
+void
+memtx_compressor_destroy(struct memtx_compressor *compressor);
+
+/** Make @a dst use the dictionary of @a src on space alter. */
+void
+memtx_compressor_inherit(struct memtx_compressor *dst,
+			 struct memtx_compressor *src);
+
+/**
+ * Create a tuple of a compressed space. Tuples created while
+ * the dictionary is not trained yet are stored plain and
+ * serve as training samples.
+ */
+struct tuple *
+memtx_compressor_tuple_new(struct memtx_compressor *compressor,
+			   struct tuple_format *format,
+			   const char *data, const char *end);
+
+/**
+ * Get the plain MessagePack of a tuple. Compressed data is
+ * decompressed to the fiber region. Tx thread only.
+ */
+const char *
+memtx_tuple_decompress(const struct tuple *tuple, uint32_t *size);
+
+/** Check the plain data of a tuple against a format. */
+int
+memtx_tuple_validate(struct tuple_format *format, struct tuple *tuple);
+
+/**
+ * Return false if the key image of a compressed tuple lacks
+ * some fields of the key definition: they were not indexed
+ * when the tuple was created.
+ */
+bool
+memtx_tuple_has_key(const struct tuple *tuple, const struct key_def *key_def);
+
+/**
+ * Decompression context for reading tuples outside the tx
+ * thread, e.g. by checkpoint and join read views.
+ */
+struct memtx_decompressor {
+	/** zstd context, created on demand. */
+	void *dctx;
+	/** Buffer for decompressed data. */
+	char *buf;
+	size_t capacity;
+};
+
+void
+memtx_decompressor_create(struct memtx_decompressor *decompressor);
+
+void
+memtx_decompressor_destroy(struct memtx_decompressor *decompressor);
+
+/**
+ * Get the plain MessagePack of a tuple. The data is valid
+ * until the next call.
+ */
+const char *
+memtx_decompressor_data(struct memtx_decompressor *decompressor,
+			const struct tuple *tuple, uint32_t *size);
+
+/** Free the tx thread compression contexts. */
+void
+memtx_zstd_free(void);
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
+
+#endif /* TARANTOOL_BOX_MEMTX_COMPRESS_H_INCLUDED */
@@ -0,0 +1,444 @@
+/*
+ * Copyright 2010-2019, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include "memtx_defrag.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <msgpuck.h>
+#include <small/small.h>
+
+#include "fiber.h"
+#include "diag.h"
+#include "say.h"
+#include "schema.h"
+#include "space.h"
+#include "index.h"
+#include "tuple.h"
+#include "memtx_engine.h"
+
+enum {
+	/** Number of tuples visited in one step. */
+	MEMTX_DEFRAG_STEP_SIZE = 256,
+};
+
+/** How often to check fragmentation, in seconds. */
+static const double MEMTX_DEFRAG_CHECK_PERIOD = 1.0;
+/** How long to wait for transactions or read views to end. */
+static const double MEMTX_DEFRAG_RETRY_PERIOD = 0.01;
+
+static inline struct memtx_engine *
+memtx_defrag_engine(struct memtx_defrag *defrag)
+{
+	return container_of(defrag, struct memtx_engine, defrag);
+}
+
+/** Context of small_stats() callback collecting size classes. */
+struct memtx_defrag_pools_ctx {
+	struct memtx_defrag *defrag;
+	/** Free share of a size class making it sparse. */
+	double threshold;
+	/** Set if a sparse size class is found. */
+	bool has_sparse;
+	/** Set on memory error. */
+	bool is_oom;
+};
+
+static int
+memtx_defrag_pools_cb(const struct mempool_stats *stats, void *cb_ctx)
+{
+	struct memtx_defrag_pools_ctx *ctx =
+		(struct memtx_defrag_pools_ctx *)cb_ctx;
+	struct memtx_defrag *defrag = ctx->defrag;
+	if (stats->slabcount == 0 || ctx->is_oom)
+		return 0;
+	size_t size = (defrag->pool_count + 1) * sizeof(*defrag->pools);
+	struct memtx_defrag_pool *pools =
+		(struct memtx_defrag_pool *)realloc(defrag->pools, size);
+	if (pools == NULL) {
+		ctx->is_oom = true;
+		return 0;
+	}
+	defrag->pools = pools;
+	struct memtx_defrag_pool *pool = &pools[defrag->pool_count++];
+	pool->objsize = stats->objsize;
+	/* Tuples of a single slab have nowhere to go. */
+	pool->is_sparse = stats->slabcount > 1 &&
+		stats->totals.total - stats->totals.used >=
+		ctx->threshold * stats->totals.total &&
+		stats->totals.total - stats->totals.used >= stats->slabsize;
+	if (pool->is_sparse)
+		ctx->has_sparse = true;
+	return 0;
+}
+
+static int
+memtx_defrag_pool_cmp(const void *a, const void *b)
+{
+	uint32_t size_a = ((const struct memtx_defrag_pool *)a)->objsize;
+	uint32_t size_b = ((const struct memtx_defrag_pool *)b)->objsize;
+	return size_a < size_b ? -1 : size_a > size_b;
+}
+
+/**
+ * Refresh the list of size classes. Return true if there are
+ * sparse ones.
+ */
+static bool
+memtx_defrag_scan_pools(struct memtx_defrag *defrag, double threshold,
+			size_t *items_size)
+{
+	struct memtx_engine *memtx = memtx_defrag_engine(defrag);
+	struct memtx_defrag_pools_ctx ctx;
+	ctx.defrag = defrag;
+	ctx.threshold = threshold;
+	ctx.has_sparse = false;
+	ctx.is_oom = false;
+	defrag->pool_count = 0;
+	struct small_stats totals;
+	small_stats(&memtx->alloc, &totals, memtx_defrag_pools_cb, &ctx);
+	qsort(defrag->pools, defrag->pool_count, sizeof(*defrag->pools),
+	      memtx_defrag_pool_cmp);
+	*items_size = totals.total;
+	return ctx.has_sparse && !ctx.is_oom;
+}
+
+/** Return true if a tuple of the given size is in a sparse class. */
+static bool
+memtx_defrag_size_is_sparse(struct memtx_defrag *defrag, size_t size)
+{
+	uint32_t begin = 0, end = defrag->pool_count;
+	while (begin < end) {
+		uint32_t mid = begin + (end - begin) / 2;
+		if (defrag->pools[mid].objsize < size)
+			begin = mid + 1;
+		else
+			end = mid;
+	}
+	return begin < defrag->pool_count && defrag->pools[begin].is_sparse;
+}
+
+static int
+memtx_defrag_add_space(struct space *space, void *arg)
+{
+	struct memtx_defrag *defrag = (struct memtx_defrag *)arg;
+	if (space->engine != &memtx_defrag_engine(defrag)->base)
+		return 0;
+	size_t size = (defrag->space_count + 1) * sizeof(*defrag->space_ids);
+	uint32_t *space_ids = (uint32_t *)realloc(defrag->space_ids, size);
+	if (space_ids == NULL) {
+		diag_set(OutOfMemory, size, "realloc", "space_ids");
+		return -1;
+	}
+	defrag->space_ids = space_ids;
+	defrag->space_ids[defrag->space_count++] = space_id(space);
+	return 0;
+}
+
+/** Start a pass if there is something to defragment. */
+static bool
+memtx_defrag_begin(struct memtx_defrag *defrag)
+{
+	struct memtx_engine *memtx = memtx_defrag_engine(defrag);
+	if (memtx->state != MEMTX_OK)
+		return false;
+	if (defrag->threshold == 0 && !defrag->is_requested)
+		return false;
+	/* A requested pass compacts every class with a free slab. */
+	double threshold = defrag->is_requested ? 0 : defrag->threshold;
+	defrag->is_requested = false;
+	if (!memtx_defrag_scan_pools(defrag, threshold, &defrag->items_size))
+		return false;
+	defrag->space_count = 0;
+	defrag->space_pos = 0;
+	defrag->last_key_size = 0;
+	if (space_foreach(memtx_defrag_add_space, defrag) != 0) {
+		diag_log();
+		return false;
+	}
+	say_verbose("memtx defragmentation started");
+	defrag->is_running = true;
+	return true;
+}
+
+static void
+memtx_defrag_end(struct memtx_defrag *defrag)
+{
+	size_t items_size;
+	memtx_defrag_scan_pools(defrag, 0, &items_size);
+	size_t reclaimed = 0;
+	if (items_size < defrag->items_size)
+		reclaimed = defrag->items_size - items_size;
+	defrag->stat.reclaimed += reclaimed;
+	defrag->stat.passes++;
+	defrag->is_running = false;
+	say_verbose("memtx defragmentation completed, %zu bytes reclaimed",
+		    reclaimed);
+}
+
+/**
+ * Return true if tuples of the space can be moved: pointers
+ * are swapped in place in TREE and HASH indexes only, and the
+ * space is scanned by a TREE primary key.
+ */
+static bool
+memtx_defrag_space_is_supported(struct space *space)
+{
+	if (space->index_count == 0 || space->index[0]->def->iid != 0 ||
+	    space->index[0]->def->type != TREE)
+		return false;
+	for (uint32_t i = 0; i < space->index_count; i++) {
+		enum index_type type = space->index[i]->def->type;
+		if (type != TREE && type != HASH)
+			return false;
+	}
+	return true;
+}
+
+/**
+ * Move a tuple to a new memory block if the block lies below
+ * the current one.
+ */
+static int
+memtx_defrag_move(struct memtx_defrag *defrag, struct space *space,
+		  struct tuple *old_tuple)
+{
+	struct tuple_format *format = tuple_format(old_tuple);
+	struct tuple *new_tuple = memtx_tuple_dup(old_tuple);
+	if (new_tuple == NULL)
+		return -1;
+	if ((uintptr_t)new_tuple > (uintptr_t)old_tuple) {
+		/* No free block below, leave the tuple in place. */
+		memtx_tuple_delete(format, new_tuple);
+		return 0;
+	}
+	struct tuple *unused;
+	for (uint32_t i = 0; i < space->index_count; i++) {
+		if (index_replace(space->index[i], old_tuple, new_tuple,
+				  DUP_REPLACE, &unused) == 0)
+			continue;
+		/* Indexes replace tuples in place, can't happen. */
+		while (i-- > 0) {
+			if (index_replace(space->index[i], new_tuple,
+					  old_tuple, DUP_REPLACE,
+					  &unused) != 0)
+				panic("failed to rollback tuple move");
+		}
+		memtx_tuple_delete(format, new_tuple);
+		return -1;
+	}
+	defrag->stat.moved++;
+	defrag->stat.moved_bytes += memtx_tuple_size(format, new_tuple);
+	tuple_ref(new_tuple);
+	tuple_unref(old_tuple);
+	return 0;
+}
+
+/** Save the primary key of the last tuple visited in a space. */
+static int
+memtx_defrag_save_key(struct memtx_defrag *defrag, struct index *pk,
+		      struct tuple *tuple)
+{
+	uint32_t size;
+	const char *key = tuple_extract_key(tuple, pk->def->key_def, &size);
+	if (key == NULL)
+		return -1;
+	if (size > defrag->last_key_capacity) {
+		char *buf = (char *)realloc(defrag->last_key, size);
+		if (buf == NULL) {
+			diag_set(OutOfMemory, size, "realloc", "last_key");
+			return -1;
+		}
+		defrag->last_key = buf;
+		defrag->last_key_capacity = size;
+	}
+	memcpy(defrag->last_key, key, size);
+	defrag->last_key_size = size;
+	return 0;
+}
+
+/**
+ * Visit the next batch of tuples of a space. Set @a done if
+ * the whole space has been visited.
+ */
+static int
+memtx_defrag_space_step(struct memtx_defrag *defrag, struct space *space,
+			bool *done)
+{
+	struct index *pk = space->index[0];
+	enum iterator_type type = ITER_ALL;
+	const char *key = NULL;
+	uint32_t part_count = 0;
+	if (defrag->last_key_size > 0) {
+		type = ITER_GT;
+		key = defrag->last_key;
+		part_count = mp_decode_array(&key);
+	}
+	struct iterator *it = index_create_iterator(pk, type, key, part_count);
+	if (it == NULL)
+		return -1;
+	/*
+	 * Collect the batch first so that the iterator does not
+	 * hold a reference to a tuple being moved. Nothing can
+	 * free the tuples until the next yield.
+	 */
+	struct tuple *batch[MEMTX_DEFRAG_STEP_SIZE];
+	int count = 0;
+	struct tuple *tuple;
+	while (count < MEMTX_DEFRAG_STEP_SIZE) {
+		if (iterator_next(it, &tuple) != 0) {
+			iterator_delete(it);
+			return -1;
+		}
+		if (tuple == NULL)
+			break;
+		batch[count++] = tuple;
+	}
+	iterator_delete(it);
+	*done = count < MEMTX_DEFRAG_STEP_SIZE;
+	if (*done)
+		defrag->last_key_size = 0;
+	else if (memtx_defrag_save_key(defrag, pk, batch[count - 1]) != 0)
+		return -1;
+
+	for (int i = 0; i < count; i++) {
+		tuple = batch[i];
+		/*
+		 * Referenced by a fiber, an iterator or
+		 * an uncommitted statement.
+		 */
+		if (tuple->refs != 1)
+			continue;
+		size_t size = memtx_tuple_size(tuple_format(tuple), tuple);
+		if (!memtx_defrag_size_is_sparse(defrag, size))
+			continue;
+		if (memtx_defrag_move(defrag, space, tuple) != 0)
+			return -1;
+	}
+	return 0;
+}
+
+/** Process the next batch of tuples of the pass. */
+static int
+memtx_defrag_step(struct memtx_defrag *defrag)
+{
+	while (defrag->space_pos < defrag->space_count) {
+		uint32_t id = defrag->space_ids[defrag->space_pos];
+		struct space *space = space_by_id(id);
+		bool done = true;
+		if (space != NULL && memtx_defrag_space_is_supported(space) &&
+		    memtx_defrag_space_step(defrag, space, &done) != 0) {
+			/* Skip the space on error. */
+			defrag->space_pos++;
+			defrag->last_key_size = 0;
+			return -1;
+		}
+		if (!done)
+			return 0;
+		defrag->space_pos++;
+		/* Don't visit more than one batch per step. */
+		if (space != NULL)
+			return 0;
+	}
+	memtx_defrag_end(defrag);
+	return 0;
+}
+
+/**
+ * Return true if tuples can be moved now: a read view relies on
+ * tuples staying in place until it is closed. Tuples inserted by
+ * uncommitted transactions are pinned by their statements and
+ * are skipped one by one, see memtx_engine_commit().
+ */
+static bool
+memtx_defrag_can_move(struct memtx_defrag *defrag)
+{
+	struct memtx_engine *memtx = memtx_defrag_engine(defrag);
+	return memtx->alloc.free_mode != SMALL_DELAYED_FREE;
+}
+
+static int
+memtx_defrag_f(va_list ap)
+{
+	struct memtx_defrag *defrag = va_arg(ap, struct memtx_defrag *);
+	while (!fiber_is_cancelled()) {
+		if (!defrag->is_running && !memtx_defrag_begin(defrag)) {
+			fiber_yield_timeout(MEMTX_DEFRAG_CHECK_PERIOD);
+			continue;
+		}
+		if (!memtx_defrag_can_move(defrag)) {
+			fiber_sleep(MEMTX_DEFRAG_RETRY_PERIOD);
+			continue;
+		}
+		if (memtx_defrag_step(defrag) != 0)
+			diag_log();
+		fiber_gc();
+		/* Let other fibers run between steps. */
+		fiber_sleep(0);
+	}
+	return 0;
+}
+
+int
+memtx_defrag_create(struct memtx_defrag *defrag, struct memtx_engine *memtx)
+{
+	assert(defrag == &memtx->defrag);
+	(void)memtx;
+	memset(defrag, 0, sizeof(*defrag));
+	defrag->fiber = fiber_new("memtx.defrag", memtx_defrag_f);
+	if (defrag->fiber == NULL)
+		return -1;
+	fiber_start(defrag->fiber, defrag);
+	return 0;
+}
+
+void
+memtx_defrag_destroy(struct memtx_defrag *defrag)
+{
+	free(defrag->pools);
+	free(defrag->space_ids);
+	free(defrag->last_key);
+}
+
+void
+memtx_defrag_set_threshold(struct memtx_defrag *defrag, double threshold)
+{
+	defrag->threshold = threshold;
+	if (threshold > 0)
+		fiber_wakeup(defrag->fiber);
+}
+
+void
+memtx_defrag_request(struct memtx_defrag *defrag)
+{
+	defrag->is_requested = true;
+	if (!defrag->is_running)
+		fiber_wakeup(defrag->fiber);
+}
@@ -0,0 +1,138 @@
+#ifndef TARANTOOL_BOX_MEMTX_DEFRAG_H_INCLUDED
+#define TARANTOOL_BOX_MEMTX_DEFRAG_H_INCLUDED
+/*
+ * Copyright 2010-2019, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+struct fiber;
+struct memtx_engine;
+
+/** Tuple memory defragmentation statistics. */
+struct memtx_defrag_stat {
+	/** Number of completed passes. */
+	uint64_t passes;
+	/** Number of tuples moved. */
+	uint64_t moved;
+	/** Total size of tuples moved, in bytes. */
+	uint64_t moved_bytes;
+	/** Tuple slab memory released by completed passes. */
+	uint64_t reclaimed;
+};
+
+/** Size class of the tuple allocator. */
+struct memtx_defrag_pool {
+	/** Size of objects allocated from the pool. */
+	uint32_t objsize;
+	/** Set if tuples of the pool should be moved. */
+	bool is_sparse;
+};
+
+/**
+ * Tuple memory defragmenter.
+ *
+ * After heavy churn, tuple slabs end up sparsely filled, and
+ * the memory can't be returned to the arena until every tuple
+ * of a slab is freed. The defragmenter walks memtx spaces in
+ * the background and copies tuples of sparse size classes:
+ * the allocator hands out the lowest free address of a size
+ * class, so a copy that lands below the original packs the
+ * class towards its first slabs and lets the last ones empty.
+ * Tuple pointers are swapped in all indexes of the space in
+ * place, a few hundred tuples per step between yields.
+ *
+ * Only tuples referenced by nothing but the space are moved,
+ * and only when no memtx transaction is in progress and no
+ * read view (checkpoint or join) relies on delayed free.
+ */
+struct memtx_defrag {
+	/** Background fiber. */
+	struct fiber *fiber;
+	/**
+	 * A pass starts when a size class has at least this
+	 * share of its slab memory free, 0 disables.
+	 */
+	double threshold;
+	/** Set if a pass was requested by the user. */
+	bool is_requested;
+	/** Set while a pass is in progress. */
+	bool is_running;
+	/** Size classes of the allocator, sorted by object size. */
+	struct memtx_defrag_pool *pools;
+	uint32_t pool_count;
+	/** Ids of spaces to visit during the pass. */
+	uint32_t *space_ids;
+	uint32_t space_count;
+	/** Position of the space being processed in space_ids. */
+	uint32_t space_pos;
+	/**
+	 * Primary key of the last tuple processed in the current
+	 * space, with the MsgPack array header. Empty if the
+	 * space has not been started.
+	 */
+	char *last_key;
+	uint32_t last_key_size;
+	uint32_t last_key_capacity;
+	/** Size of tuple slabs at the beginning of the pass. */
+	size_t items_size;
+	/** Statistics. */
+	struct memtx_defrag_stat stat;
+};
+
+/** Create a defragmenter and start its fiber. */
+int
+memtx_defrag_create(struct memtx_defrag *defrag, struct memtx_engine *memtx);
+
+/** Destroy a defragmenter. */
+void
+memtx_defrag_destroy(struct memtx_defrag *defrag);
+
+/** Set the free memory share starting a pass, 0 disables. */
+void
+memtx_defrag_set_threshold(struct memtx_defrag *defrag, double threshold);
+
+/**
+ * Request a pass over all size classes with free memory
+ * regardless of the threshold.
+ */
+void
+memtx_defrag_request(struct memtx_defrag *defrag);
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
+
+#endif /* TARANTOOL_BOX_MEMTX_DEFRAG_H_INCLUDED */
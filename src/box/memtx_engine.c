@@ -30,6 +30,7 @@
  */
 #include "memtx_engine.h"
 #include "memtx_space.h"
+#include "memtx_compress.h"
 
 #include <small/quota.h>
 #include <small/small.h>
@@ -129,6 +130,9 @@ static void
 memtx_engine_shutdown(struct engine *engine)
 {
 	struct memtx_engine *memtx = (struct memtx_engine *)engine;
+	memtx_defrag_destroy(&memtx->defrag);
+	memtx_expire_destroy(&memtx->expire);
+	memtx_zstd_free();
 	if (mempool_is_initialized(&memtx->tree_iterator_pool))
 		mempool_destroy(&memtx->tree_iterator_pool);
 	if (mempool_is_initialized(&memtx->rtree_iterator_pool))
@@ -201,6 +205,14 @@ memtx_engine_recover_snapshot(struct memtx_engine *memtx,
 	return 0;
 }
 
+const char *
+memtx_engine_snapshot_path(struct memtx_engine *memtx,
+			   const struct vclock *vclock)
+{
+	return xdir_format_filename(&memtx->snap_dir, vclock_sum(vclock),
+				    NONE);
+}
+
 static int
 memtx_engine_recover_snapshot_row(struct memtx_engine *memtx,
 				  struct xrow_header *row)
@@ -337,6 +349,15 @@ static int
 memtx_engine_begin(struct engine *engine, struct txn *txn)
 {
 	(void)engine;
+	/*
+	 * There is no multiversioning in memtx, so a transaction
+	 * can't be kept open while other fibers run.
+	 */
+	if (txn->can_yield) {
+		diag_set(ClientError, ER_UNSUPPORTED, "memtx",
+			 "interactive transactions");
+		return -1;
+	}
 	/*
 	 * Register a trigger to rollback transaction on yield.
 	 * This must be done in begin(), since it's
@@ -406,8 +427,12 @@ memtx_engine_rollback_statement(struct engine *engine, struct txn *txn,
 		memtx_space_update_bsize(space, stmt->new_tuple,
 					 stmt->old_tuple);
 
-	if (stmt->new_tuple)
+	if (stmt->new_tuple) {
+		/* Drop the pin, see memtx_engine_commit(). */
+		if (stmt->engine_savepoint != NULL)
+			tuple_unref(stmt->new_tuple);
 		tuple_unref(stmt->new_tuple);
+	}
 
 	stmt->old_tuple = NULL;
 	stmt->new_tuple = NULL;
@@ -431,6 +456,13 @@ memtx_engine_commit(struct engine *engine, struct txn *txn)
 	stailq_foreach_entry(stmt, &txn->stmts, next) {
 		if (stmt->old_tuple)
 			tuple_unref(stmt->old_tuple);
+		/*
+		 * A tuple inserted by a statement is pinned until
+		 * the transaction ends so that the defragmenter
+		 * doesn't move it while the statement refers to it.
+		 */
+		if (stmt->new_tuple && stmt->engine_savepoint != NULL)
+			tuple_unref(stmt->new_tuple);
 	}
 }
 
@@ -628,8 +660,13 @@ checkpoint_f(va_list ap)
 		uint32_t size;
 		const char *data;
 		struct snapshot_iterator *it = entry->iterator;
-		for (data = it->next(it, &size); data != NULL;
-		     data = it->next(it, &size)) {
+		while (true) {
+			if (it->next(it, &data, &size) != 0) {
+				xlog_close(&snap, false);
+				return -1;
+			}
+			if (data == NULL)
+				break;
 			if (checkpoint_write_tuple(&snap,
 					space_id(entry->space),
 					data, size) != 0) {
@@ -673,6 +710,7 @@ memtx_engine_begin_checkpoint(struct engine *engine)
 	/* increment snapshot version; set tuple deletion to delayed mode */
 	memtx->snapshot_version++;
 	small_alloc_setopt(&memtx->alloc, SMALL_DELAYED_FREE_MODE, true);
+	memtx_zstd_set_delayed_free(true);
 	return 0;
 }
 
@@ -719,6 +757,7 @@ memtx_engine_commit_checkpoint(struct engine *engine, struct vclock *vclock)
 	assert(!memtx->checkpoint->waiting_for_snap_thread);
 
 	small_alloc_setopt(&memtx->alloc, SMALL_DELAYED_FREE_MODE, false);
+	memtx_zstd_set_delayed_free(false);
 
 	if (!memtx->checkpoint->touch) {
 		int64_t lsn = vclock_sum(memtx->checkpoint->vclock);
@@ -762,6 +801,7 @@ memtx_engine_abort_checkpoint(struct engine *engine)
 	}
 
 	small_alloc_setopt(&memtx->alloc, SMALL_DELAYED_FREE_MODE, false);
+	memtx_zstd_set_delayed_free(false);
 
 	/** Remove garbage .inprogress file. */
 	char *filename =
@@ -834,6 +874,18 @@ memtx_initial_join_f(va_list ap)
 
 	struct xrow_header row;
 	while ((rc = xlog_cursor_next(&cursor, &row, true)) == 0) {
+		if (stream->skip_space != NULL &&
+		    iproto_type_is_dml(row.type)) {
+			/*
+			 * Rows of all spaces are stored in one file,
+			 * so they have to be read anyway, but there
+			 * is no point in passing them on.
+			 */
+			struct request request;
+			if (xrow_decode_dml(&row, &request, 0) == 0 &&
+			    xstream_skip_space(stream, request.space_id))
+				continue;
+		}
 		rc = xstream_write(stream, &row);
 		if (rc < 0)
 			break;
@@ -976,7 +1028,7 @@ memtx_engine_gc_f(va_list va)
 struct memtx_engine *
 memtx_engine_new(const char *snap_dirname, bool force_recovery,
 		 uint64_t tuple_arena_max_size, uint32_t objsize_min,
-		 float alloc_factor)
+		 float alloc_factor, const struct tuple_arena_opts *arena_opts)
 {
 	struct memtx_engine *memtx = calloc(1, sizeof(*memtx));
 	if (memtx == NULL) {
@@ -1002,8 +1054,9 @@ memtx_engine_new(const char *snap_dirname, bool force_recovery,
 
 	/* Initialize tuple allocator. */
 	quota_init(&memtx->quota, tuple_arena_max_size);
+	memtx->arena_opts = *arena_opts;
 	tuple_arena_create(&memtx->arena, &memtx->quota, tuple_arena_max_size,
-			   SLAB_SIZE, "memtx");
+			   SLAB_SIZE, arena_opts, "memtx");
 	slab_cache_create(&memtx->slab_cache, &memtx->arena);
 	small_alloc_create(&memtx->alloc, &memtx->slab_cache,
 			   objsize_min, alloc_factor);
@@ -1017,13 +1070,27 @@ memtx_engine_new(const char *snap_dirname, bool force_recovery,
 
 	memtx->state = MEMTX_INITIALIZED;
 	memtx->max_tuple_size = MAX_TUPLE_SIZE;
+	memtx->tree_fill_factor = 1;
 	memtx->force_recovery = force_recovery;
 
 	memtx->base.vtab = &memtx_engine_vtab;
 	memtx->base.name = "memtx";
 
+	if (memtx_defrag_create(&memtx->defrag, memtx) != 0)
+		goto fail_defrag;
+	if (memtx_expire_create(&memtx->expire, memtx) != 0)
+		goto fail_expire;
+
 	fiber_start(memtx->gc_fiber, memtx);
 	return memtx;
+fail_expire:
+	memtx_defrag_destroy(&memtx->defrag);
+fail_defrag:
+	mempool_destroy(&memtx->index_extent_pool);
+	slab_cache_destroy(&memtx->index_slab_cache);
+	small_alloc_destroy(&memtx->alloc);
+	slab_cache_destroy(&memtx->slab_cache);
+	tuple_arena_destroy(&memtx->arena);
 fail:
 	xdir_destroy(&memtx->snap_dir);
 	free(memtx);
@@ -1050,14 +1117,20 @@ memtx_engine_set_max_tuple_size(struct memtx_engine *memtx, size_t max_size)
 	memtx->max_tuple_size = max_size;
 }
 
+void
+memtx_engine_set_tree_fill_factor(struct memtx_engine *memtx,
+				  double fill_factor)
+{
+	memtx->tree_fill_factor = fill_factor;
+}
+
 struct tuple *
-memtx_tuple_new(struct tuple_format *format, const char *data, const char *end)
+memtx_tuple_alloc(struct tuple_format *format, uint32_t bsize,
+		  uint32_t zsize)
 {
 	struct memtx_engine *memtx = (struct memtx_engine *)format->engine;
-	assert(mp_typeof(*data) == MP_ARRAY);
-	size_t tuple_len = end - data;
-	size_t meta_size = tuple_format_meta_size(format);
-	size_t total = sizeof(struct memtx_tuple) + meta_size + tuple_len;
+	size_t meta_size = tuple_format_meta_size(format, bsize);
+	size_t total = sizeof(struct memtx_tuple) + meta_size + bsize + zsize;
 
 	ERROR_INJECT(ERRINJ_TUPLE_ALLOC, {
 		diag_set(OutOfMemory, total, "slab allocator", "memtx_tuple");
@@ -1083,8 +1156,7 @@ memtx_tuple_new(struct tuple_format *format, const char *data, const char *end)
 	struct tuple *tuple = &memtx_tuple->base;
 	tuple->refs = 0;
 	memtx_tuple->version = memtx->snapshot_version;
-	assert(tuple_len <= UINT32_MAX); /* bsize is UINT32_MAX */
-	tuple->bsize = tuple_len;
+	tuple->bsize = bsize;
 	tuple->format_id = tuple_format_id(format);
 	tuple_format_ref(format);
 	/*
@@ -1093,25 +1165,64 @@ memtx_tuple_new(struct tuple_format *format, const char *data, const char *end)
 	 * tuple is not the first field of the memtx_tuple.
 	 */
 	tuple->data_offset = sizeof(struct tuple) + meta_size;
+	if (memtx_format_is_compressed(format)) {
+		struct memtx_zstd_header *header = memtx_zstd_header(tuple);
+		header->dict = NULL;
+		header->zsize = zsize;
+	} else {
+		assert(zsize == 0);
+	}
+	return tuple;
+}
+
+struct tuple *
+memtx_tuple_new(struct tuple_format *format, const char *data, const char *end)
+{
+	assert(mp_typeof(*data) == MP_ARRAY);
+	size_t tuple_len = end - data;
+	assert(tuple_len <= UINT32_MAX); /* bsize is UINT32_MAX */
+	struct tuple *tuple = memtx_tuple_alloc(format, tuple_len, 0);
+	if (tuple == NULL)
+		return NULL;
 	char *raw = (char *) tuple + tuple->data_offset;
-	uint32_t *field_map = (uint32_t *) raw;
 	memcpy(raw, data, tuple_len);
-	if (tuple_init_field_map(format, field_map, raw)) {
+	if (tuple_init_field_map(format, raw, field_map_slot_size(tuple_len),
+				 raw)) {
 		memtx_tuple_delete(format, tuple);
 		return NULL;
 	}
-	say_debug("%s(%zu) = %p", __func__, tuple_len, memtx_tuple);
+	say_debug("%s(%zu) = %p", __func__, tuple_len, tuple);
 	return tuple;
 }
 
+struct tuple *
+memtx_tuple_dup(struct tuple *tuple)
+{
+	struct tuple_format *format = tuple_format(tuple);
+	uint32_t zsize = 0;
+	if (memtx_format_is_compressed(format))
+		zsize = memtx_zstd_header(tuple)->zsize;
+	struct tuple *copy = memtx_tuple_alloc(format, tuple->bsize, zsize);
+	if (copy == NULL)
+		return NULL;
+	size_t meta_size = tuple_format_meta_size(format, tuple->bsize);
+	memcpy((char *)tuple_data(copy) - meta_size,
+	       tuple_data(tuple) - meta_size,
+	       meta_size + tuple->bsize + zsize);
+	if (memtx_tuple_is_compressed(copy))
+		memtx_zstd_dict_ref(memtx_zstd_header(copy)->dict);
+	return copy;
+}
+
 void
 memtx_tuple_delete(struct tuple_format *format, struct tuple *tuple)
 {
 	struct memtx_engine *memtx = (struct memtx_engine *)format->engine;
 	say_debug("%s(%p)", __func__, tuple);
 	assert(tuple->refs == 0);
-	size_t total = sizeof(struct memtx_tuple) +
-		       tuple_format_meta_size(format) + tuple->bsize;
+	size_t total = memtx_tuple_size(format, tuple);
+	if (memtx_tuple_is_compressed(tuple))
+		memtx_zstd_dict_unref(memtx_zstd_header(tuple)->dict);
 	tuple_format_unref(format);
 	struct memtx_tuple *memtx_tuple =
 		container_of(tuple, struct memtx_tuple, base);
@@ -1122,9 +1233,24 @@ memtx_tuple_delete(struct tuple_format *format, struct tuple *tuple)
 		smfree_delayed(&memtx->alloc, memtx_tuple, total);
 }
 
+size_t
+memtx_tuple_size(struct tuple_format *format, const struct tuple *tuple)
+{
+	return sizeof(struct memtx_tuple) +
+	       tuple_format_meta_size(format, tuple->bsize) +
+	       memtx_tuple_stored_bsize(tuple);
+}
+
 struct tuple_format_vtab memtx_tuple_format_vtab = {
 	memtx_tuple_delete,
 	memtx_tuple_new,
+	NULL,
+};
+
+struct tuple_format_vtab memtx_zstd_tuple_format_vtab = {
+	memtx_tuple_delete,
+	memtx_tuple_new,
+	memtx_zstd_tuple_unpack,
 };
 
 /**
@@ -1217,6 +1343,13 @@ memtx_index_def_change_requires_rebuild(struct index *index,
 		return true;
 	if (!old_def->opts.is_unique && new_def->opts.is_unique)
 		return true;
+	/* Included fields are copied to TREE index elements. */
+	if (old_def->opts.include_count != new_def->opts.include_count)
+		return true;
+	for (uint32_t i = 0; i < new_def->opts.include_count; i++) {
+		if (old_def->opts.include[i] != new_def->opts.include[i])
+			return true;
+	}
 
 	const struct key_def *old_cmp_def, *new_cmp_def;
 	if (index_depends_on_pk(index)) {
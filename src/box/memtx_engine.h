@@ -40,6 +40,9 @@
 #include "engine.h"
 #include "xlog.h"
 #include "salad/stailq.h"
+#include "memtx_defrag.h"
+#include "memtx_expire.h"
+#include "tuple.h"
 
 #if defined(__cplusplus)
 extern "C" {
@@ -116,6 +119,8 @@ struct memtx_engine {
 	struct slab_cache index_slab_cache;
 	/** Index extent allocator. */
 	struct mempool index_extent_pool;
+	/** Huge page and NUMA placement of the arena. */
+	struct tuple_arena_opts arena_opts;
 	/**
 	 * To ensure proper statement-level rollback in case
 	 * of out of memory conditions, we maintain a number
@@ -127,6 +132,11 @@ struct memtx_engine {
 	void *reserved_extents;
 	/** Maximal allowed tuple size, box.cfg.memtx_max_tuple_size. */
 	size_t max_tuple_size;
+	/**
+	 * Share of a TREE index leaf filled on bulk load of
+	 * sorted input, box.cfg.memtx_tree_fill_factor.
+	 */
+	double tree_fill_factor;
 	/** Incremented with each next snapshot. */
 	uint32_t snapshot_version;
 	/** Memory pool for tree index iterator. */
@@ -147,6 +157,10 @@ struct memtx_engine {
 	 * memtx_gc_task::link.
 	 */
 	struct stailq gc_queue;
+	/** Tuple memory defragmenter. */
+	struct memtx_defrag defrag;
+	/** Tuple expiration. */
+	struct memtx_expire expire;
 };
 
 struct memtx_gc_task;
@@ -181,26 +195,56 @@ memtx_engine_schedule_gc(struct memtx_engine *memtx,
 struct memtx_engine *
 memtx_engine_new(const char *snap_dirname, bool force_recovery,
 		 uint64_t tuple_arena_max_size,
-		 uint32_t objsize_min, float alloc_factor);
+		 uint32_t objsize_min, float alloc_factor,
+		 const struct tuple_arena_opts *arena_opts);
 
 int
 memtx_engine_recover_snapshot(struct memtx_engine *memtx,
 			      const struct vclock *vclock);
 
+/**
+ * Return the path to the snapshot of the checkpoint with
+ * the given vclock. The path is stored in a static buffer.
+ */
+const char *
+memtx_engine_snapshot_path(struct memtx_engine *memtx,
+			   const struct vclock *vclock);
+
 void
 memtx_engine_set_snap_io_rate_limit(struct memtx_engine *memtx, double limit);
 
 void
 memtx_engine_set_max_tuple_size(struct memtx_engine *memtx, size_t max_size);
 
+void
+memtx_engine_set_tree_fill_factor(struct memtx_engine *memtx,
+				  double fill_factor);
+
 /** Allocate a memtx tuple. @sa tuple_new(). */
 struct tuple *
 memtx_tuple_new(struct tuple_format *format, const char *data, const char *end);
 
+/**
+ * Allocate an uninitialized memtx tuple with @a bsize bytes of
+ * MessagePack data followed by @a zsize bytes of compressed
+ * data, see memtx_zstd_header.
+ */
+struct tuple *
+memtx_tuple_alloc(struct tuple_format *format, uint32_t bsize,
+		  uint32_t zsize);
+
+/** Copy a memtx tuple to a new memory block. */
+struct tuple *
+memtx_tuple_dup(struct tuple *tuple);
+
 /** Free a memtx tuple. @sa tuple_delete(). */
 void
 memtx_tuple_delete(struct tuple_format *format, struct tuple *tuple);
 
+/** Size of the memory block allocated for a memtx tuple. */
+size_t
+memtx_tuple_size(struct tuple_format *format, const struct tuple *tuple);
+
 /** Tuple format vtab for memtx engine. */
 extern struct tuple_format_vtab memtx_tuple_format_vtab;
 
@@ -246,12 +290,13 @@ memtx_index_def_change_requires_rebuild(struct index *index,
 static inline struct memtx_engine *
 memtx_engine_new_xc(const char *snap_dirname, bool force_recovery,
 		    uint64_t tuple_arena_max_size,
-		    uint32_t objsize_min, float alloc_factor)
+		    uint32_t objsize_min, float alloc_factor,
+		    const struct tuple_arena_opts *arena_opts)
 {
 	struct memtx_engine *memtx;
 	memtx = memtx_engine_new(snap_dirname, force_recovery,
 				 tuple_arena_max_size,
-				 objsize_min, alloc_factor);
+				 objsize_min, alloc_factor, arena_opts);
 	if (memtx == NULL)
 		diag_raise();
 	return memtx;
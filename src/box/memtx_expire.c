@@ -0,0 +1,301 @@
+/*
+ * Copyright 2010-2019, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include "memtx_expire.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <msgpuck.h>
+
+#include "fiber.h"
+#include "diag.h"
+#include "say.h"
+#include "schema.h"
+#include "space.h"
+#include "index.h"
+#include "tuple.h"
+#include "txn.h"
+#include "session.h"
+#include "box.h"
+#include "memtx_engine.h"
+
+/** How often to look for expired tuples, in seconds. */
+static const double MEMTX_EXPIRE_CHECK_PERIOD = 1.0;
+
+static inline struct memtx_engine *
+memtx_expire_engine(struct memtx_expire *expire)
+{
+	return container_of(expire, struct memtx_engine, expire);
+}
+
+static int
+memtx_expire_add_space(struct space *space, void *arg)
+{
+	struct memtx_expire *expire = (struct memtx_expire *)arg;
+	if (space->engine != &memtx_expire_engine(expire)->base ||
+	    space->def->opts.ttl <= 0)
+		return 0;
+	if (expire->space_count == expire->space_capacity) {
+		uint32_t capacity = MAX(expire->space_capacity * 2, 8);
+		size_t size = capacity * sizeof(*expire->space_ids);
+		uint32_t *space_ids = (uint32_t *)realloc(expire->space_ids,
+							  size);
+		if (space_ids == NULL) {
+			diag_set(OutOfMemory, size, "realloc", "space_ids");
+			return -1;
+		}
+		expire->space_ids = space_ids;
+		expire->space_capacity = capacity;
+	}
+	expire->space_ids[expire->space_count++] = space_id(space);
+	return 0;
+}
+
+/**
+ * Find a TREE index ordering tuples of a space by time, i.e.
+ * with the time field as the first part. The field must be
+ * a mandatory number, so that every tuple has a time.
+ */
+struct index *
+memtx_expire_index(struct space *space)
+{
+	uint32_t fieldno = space->def->opts.ttl_field;
+	for (uint32_t i = 0; i < space->index_count; i++) {
+		struct index *index = space->index[i];
+		const struct key_part *part = &index->def->key_def->parts[0];
+		if (index->def->type != TREE || part->fieldno != fieldno ||
+		    key_part_is_nullable(part))
+			continue;
+		if (part->type == FIELD_TYPE_UNSIGNED ||
+		    part->type == FIELD_TYPE_INTEGER ||
+		    part->type == FIELD_TYPE_NUMBER)
+			return index;
+	}
+	return NULL;
+}
+
+/** Return the time of a tuple, its type is checked by the index. */
+static double
+memtx_expire_tuple_time(struct tuple *tuple, uint32_t fieldno)
+{
+	const char *field = tuple_field(tuple, fieldno);
+	assert(field != NULL);
+	switch (mp_typeof(*field)) {
+	case MP_UINT:
+		return mp_decode_uint(&field);
+	case MP_INT:
+		return mp_decode_int(&field);
+	case MP_FLOAT:
+		return mp_decode_float(&field);
+	case MP_DOUBLE:
+		return mp_decode_double(&field);
+	default:
+		unreachable();
+	}
+	return 0;
+}
+
+/** Primary key of an expired tuple. */
+struct memtx_expire_key {
+	const char *data;
+	uint32_t size;
+};
+
+/**
+ * Delete up to batch_size expired tuples of a space in one
+ * transaction. Return the number of deleted tuples in @a count.
+ */
+static int
+memtx_expire_space(struct memtx_expire *expire, struct space *space,
+		   uint32_t *count)
+{
+	*count = 0;
+	struct index *index = memtx_expire_index(space);
+	struct index *pk = space_index(space, 0);
+	if (index == NULL || pk == NULL)
+		return 0;
+	double deadline = fiber_time() - space->def->opts.ttl;
+	uint32_t fieldno = space->def->opts.ttl_field;
+	uint32_t batch_size = expire->batch_size;
+
+	/*
+	 * Collect the keys first so that the iterator is not
+	 * used across deletions.
+	 */
+	struct region *region = &fiber()->gc;
+	size_t size = batch_size * sizeof(struct memtx_expire_key);
+	struct memtx_expire_key *keys =
+		(struct memtx_expire_key *)region_alloc(region, size);
+	if (keys == NULL) {
+		diag_set(OutOfMemory, size, "region", "keys");
+		return -1;
+	}
+	struct iterator *it = index_create_iterator(index, ITER_ALL, NULL, 0);
+	if (it == NULL)
+		return -1;
+	uint32_t key_count = 0;
+	while (key_count < batch_size) {
+		struct tuple *tuple;
+		if (iterator_next(it, &tuple) != 0)
+			goto fail;
+		/* Tuples are ordered by time, the rest are alive. */
+		if (tuple == NULL ||
+		    memtx_expire_tuple_time(tuple, fieldno) > deadline)
+			break;
+		struct memtx_expire_key *key = &keys[key_count++];
+		key->data = tuple_extract_key(tuple, pk->def->key_def,
+					      &key->size);
+		if (key->data == NULL)
+			goto fail;
+	}
+	iterator_delete(it);
+	if (key_count == 0)
+		return 0;
+
+	uint32_t id = space_id(space);
+	if (box_txn_begin() != 0)
+		goto fail_txn;
+	for (uint32_t i = 0; i < key_count; i++) {
+		struct memtx_expire_key *key = &keys[i];
+		if (box_delete(id, 0, key->data, key->data + key->size,
+			       NULL) != 0) {
+			box_txn_rollback();
+			goto fail_txn;
+		}
+	}
+	if (box_txn_commit() != 0)
+		goto fail_txn;
+	expire->stat.expired += key_count;
+	expire->stat.batches++;
+	*count = key_count;
+	return 0;
+fail:
+	iterator_delete(it);
+	return -1;
+fail_txn:
+	expire->stat.errors++;
+	return -1;
+}
+
+/** Return true if tuples can be deleted now. */
+static bool
+memtx_expire_can_run(struct memtx_expire *expire)
+{
+	struct memtx_engine *memtx = memtx_expire_engine(expire);
+	return memtx->state == MEMTX_OK && !box_is_ro();
+}
+
+/**
+ * Delete a batch of expired tuples from every space with
+ * expiration. Return the number of deleted tuples in @a count.
+ */
+static int
+memtx_expire_round(struct memtx_expire *expire, uint32_t *count)
+{
+	*count = 0;
+	expire->space_count = 0;
+	if (space_foreach(memtx_expire_add_space, expire) != 0)
+		return -1;
+	for (uint32_t i = 0; i < expire->space_count; i++) {
+		/* A space may be dropped while the fiber yields. */
+		struct space *space = space_by_id(expire->space_ids[i]);
+		if (space == NULL || !memtx_expire_can_run(expire))
+			continue;
+		uint32_t deleted;
+		if (memtx_expire_space(expire, space, &deleted) != 0)
+			diag_log();
+		fiber_gc();
+		*count += deleted;
+		/* Keep the deletion rate under the limit. */
+		if (deleted > 0 && expire->rate > 0)
+			fiber_sleep(deleted / expire->rate);
+		if (fiber_is_cancelled())
+			break;
+	}
+	return 0;
+}
+
+static int
+memtx_expire_f(va_list ap)
+{
+	struct memtx_expire *expire = va_arg(ap, struct memtx_expire *);
+	while (!fiber_is_cancelled()) {
+		uint32_t count = 0;
+		if (memtx_expire_can_run(expire)) {
+			/* Expired tuples are deleted on behalf of admin. */
+			fiber_set_user(fiber(), &admin_credentials);
+			if (memtx_expire_round(expire, &count) != 0)
+				diag_log();
+		}
+		/* More tuples may have expired if a batch was full. */
+		if (count == 0)
+			fiber_yield_timeout(MEMTX_EXPIRE_CHECK_PERIOD);
+		else
+			fiber_sleep(0);
+	}
+	return 0;
+}
+
+int
+memtx_expire_create(struct memtx_expire *expire, struct memtx_engine *memtx)
+{
+	assert(expire == &memtx->expire);
+	(void)memtx;
+	memset(expire, 0, sizeof(*expire));
+	expire->fiber = fiber_new("memtx.expire", memtx_expire_f);
+	if (expire->fiber == NULL)
+		return -1;
+	fiber_start(expire->fiber, expire);
+	return 0;
+}
+
+void
+memtx_expire_destroy(struct memtx_expire *expire)
+{
+	fiber_cancel(expire->fiber);
+	free(expire->space_ids);
+}
+
+void
+memtx_expire_set_batch_size(struct memtx_expire *expire, uint32_t batch_size)
+{
+	assert(batch_size > 0);
+	expire->batch_size = batch_size;
+}
+
+void
+memtx_expire_set_rate(struct memtx_expire *expire, double rate)
+{
+	/*
+	 * Don't wake the fiber up: it may be waiting for a WAL
+	 * write. The new rate applies from the next batch on.
+	 */
+	expire->rate = rate;
+}
@@ -0,0 +1,113 @@
+#ifndef TARANTOOL_BOX_MEMTX_EXPIRE_H_INCLUDED
+#define TARANTOOL_BOX_MEMTX_EXPIRE_H_INCLUDED
+/*
+ * Copyright 2010-2019, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+struct fiber;
+struct index;
+struct space;
+struct memtx_engine;
+
+/** Tuple expiration statistics. */
+struct memtx_expire_stat {
+	/** Number of expired tuples deleted. */
+	uint64_t expired;
+	/** Number of committed delete transactions. */
+	uint64_t batches;
+	/** Number of transactions failed with an error. */
+	uint64_t errors;
+};
+
+/**
+ * Tuple expiration.
+ *
+ * A tuple of a memtx space with the ttl option expires ttl
+ * seconds after the time stored in its ttl_field field. The
+ * field must be the first part of a TREE index, which the
+ * expiration fiber scans from the oldest time on, deleting
+ * expired tuples until it meets one that is still alive.
+ *
+ * Tuples are deleted in transactions of at most batch_size
+ * statements, so the deletions are written to WAL, replicated
+ * and fire triggers like any other. The fiber sleeps between
+ * transactions to keep the deletion rate under the limit, and
+ * does nothing while the instance is read-only.
+ */
+struct memtx_expire {
+	/** Background fiber. */
+	struct fiber *fiber;
+	/** Maximal number of tuples deleted in one transaction. */
+	uint32_t batch_size;
+	/** Maximal number of tuples deleted per second, 0 disables. */
+	double rate;
+	/** Ids of spaces with expiration, refreshed every round. */
+	uint32_t *space_ids;
+	uint32_t space_count;
+	uint32_t space_capacity;
+	/** Statistics. */
+	struct memtx_expire_stat stat;
+};
+
+/**
+ * Find a TREE index ordering tuples of a space with ttl by time,
+ * return NULL if there is none and so tuples don't expire.
+ */
+struct index *
+memtx_expire_index(struct space *space);
+
+/** Create a tuple expiration and start its fiber. */
+int
+memtx_expire_create(struct memtx_expire *expire, struct memtx_engine *memtx);
+
+/** Stop the fiber and destroy a tuple expiration. */
+void
+memtx_expire_destroy(struct memtx_expire *expire);
+
+/** Set the maximal number of tuples deleted in one transaction. */
+void
+memtx_expire_set_batch_size(struct memtx_expire *expire, uint32_t batch_size);
+
+/** Set the maximal number of tuples deleted per second, 0 disables. */
+void
+memtx_expire_set_rate(struct memtx_expire *expire, double rate);
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
+
+#endif /* TARANTOOL_BOX_MEMTX_EXPIRE_H_INCLUDED */
@@ -34,6 +34,7 @@
 #include "tuple.h"
 #include "tuple_hash.h"
 #include "memtx_engine.h"
+#include "memtx_compress.h"
 #include "space.h"
 #include "schema.h" /* space_cache_find() */
 #include "errinj.h"
@@ -358,6 +359,8 @@ struct hash_snapshot_iterator {
 	struct snapshot_iterator base;
 	struct light_index_core *hash_table;
 	struct light_index_iterator iterator;
+	/** Decompresses tuples of compressed spaces. */
+	struct memtx_decompressor decompressor;
 };
 
 /**
@@ -372,6 +375,7 @@ hash_snapshot_iterator_free(struct snapshot_iterator *iterator)
 	struct hash_snapshot_iterator *it =
 		(struct hash_snapshot_iterator *) iterator;
 	light_index_iterator_destroy(it->hash_table, &it->iterator);
+	memtx_decompressor_destroy(&it->decompressor);
 	free(iterator);
 }
 
@@ -380,17 +384,21 @@ hash_snapshot_iterator_free(struct snapshot_iterator *iterator)
  * Virtual method of snapshot iterator.
  * @sa index_vtab::create_snapshot_iterator.
  */
-static const char *
-hash_snapshot_iterator_next(struct snapshot_iterator *iterator, uint32_t *size)
+static int
+hash_snapshot_iterator_next(struct snapshot_iterator *iterator,
+			    const char **data, uint32_t *size)
 {
 	assert(iterator->free == hash_snapshot_iterator_free);
 	struct hash_snapshot_iterator *it =
 		(struct hash_snapshot_iterator *) iterator;
 	struct tuple **res = light_index_iterator_get_and_next(it->hash_table,
 							       &it->iterator);
-	if (res == NULL)
-		return NULL;
-	return tuple_data_range(*res, size);
+	if (res == NULL) {
+		*data = NULL;
+		return 0;
+	}
+	*data = memtx_decompressor_data(&it->decompressor, *res, size);
+	return *data != NULL ? 0 : -1;
 }
 
 /**
@@ -415,6 +423,7 @@ memtx_hash_index_create_snapshot_iterator(struct index *base)
 	it->hash_table = &index->hash_table;
 	light_index_iterator_begin(it->hash_table, &it->iterator);
 	light_index_iterator_freeze(it->hash_table, &it->iterator);
+	memtx_decompressor_create(&it->decompressor);
 	return (struct snapshot_iterator *) it;
 }
 
@@ -437,6 +446,7 @@ static const struct index_vtab memtx_hash_index_vtab = {
 	/* .get = */ memtx_hash_index_get,
 	/* .replace = */ memtx_hash_index_replace,
 	/* .create_iterator = */ memtx_hash_index_create_iterator,
+	/* .create_cover_iterator = */ generic_index_create_cover_iterator,
 	/* .create_snapshot_iterator = */
 		memtx_hash_index_create_snapshot_iterator,
 	/* .info = */ generic_index_info,
@@ -150,6 +150,7 @@ static void
 memtx_rtree_index_destroy(struct index *base)
 {
 	struct memtx_rtree_index *index = (struct memtx_rtree_index *)base;
+	rtree_builder_destroy(&index->builder);
 	rtree_destroy(&index->tree);
 	free(index);
 }
@@ -232,6 +233,59 @@ memtx_rtree_index_replace(struct index *base, struct tuple *old_tuple,
 	return 0;
 }
 
+static void
+memtx_rtree_index_begin_build(struct index *base)
+{
+	struct memtx_rtree_index *index = (struct memtx_rtree_index *)base;
+	assert(rtree_number_of_records(&index->tree) == 0);
+	assert(index->builder.count == 0);
+	(void)index;
+}
+
+static int
+memtx_rtree_index_reserve(struct index *base, uint32_t size_hint)
+{
+	struct memtx_rtree_index *index = (struct memtx_rtree_index *)base;
+	if (rtree_builder_reserve(&index->builder, size_hint) != 0) {
+		diag_set(OutOfMemory, size_hint * index->tree.page_branch_size,
+			 "memtx_rtree_index", "reserve");
+		return -1;
+	}
+	return 0;
+}
+
+static int
+memtx_rtree_index_build_next(struct index *base, struct tuple *tuple)
+{
+	struct memtx_rtree_index *index = (struct memtx_rtree_index *)base;
+	struct rtree_rect rect;
+	if (extract_rectangle(&rect, tuple, base->def) != 0)
+		return -1;
+	if (rtree_builder_append(&index->builder, &rect, tuple) != 0) {
+		diag_set(OutOfMemory, index->builder.capacity *
+			 index->tree.page_branch_size,
+			 "memtx_rtree_index", "build_next");
+		return -1;
+	}
+	return 0;
+}
+
+static void
+memtx_rtree_index_end_build(struct index *base)
+{
+	struct memtx_rtree_index *index = (struct memtx_rtree_index *)base;
+	/*
+	 * Tuples are packed into the tree with the STR
+	 * algorithm, which gives better filled pages and is
+	 * much faster than inserting them one by one.
+	 */
+	if (rtree_builder_finish(&index->builder) != 0) {
+		panic("failed to allocate memory for index '%s'",
+		      base->def->name);
+	}
+	rtree_builder_destroy(&index->builder);
+}
+
 static struct iterator *
 memtx_rtree_index_create_iterator(struct index *base,  enum iterator_type type,
 				  const char *key, uint32_t part_count)
@@ -317,15 +371,16 @@ static const struct index_vtab memtx_rtree_index_vtab = {
 	/* .get = */ memtx_rtree_index_get,
 	/* .replace = */ memtx_rtree_index_replace,
 	/* .create_iterator = */ memtx_rtree_index_create_iterator,
+	/* .create_cover_iterator = */ generic_index_create_cover_iterator,
 	/* .create_snapshot_iterator = */
 		generic_index_create_snapshot_iterator,
 	/* .info = */ generic_index_info,
 	/* .compact = */ generic_index_compact,
 	/* .reset_stat = */ generic_index_reset_stat,
-	/* .begin_build = */ generic_index_begin_build,
-	/* .reserve = */ generic_index_reserve,
-	/* .build_next = */ generic_index_build_next,
-	/* .end_build = */ generic_index_end_build,
+	/* .begin_build = */ memtx_rtree_index_begin_build,
+	/* .reserve = */ memtx_rtree_index_reserve,
+	/* .build_next = */ memtx_rtree_index_build_next,
+	/* .end_build = */ memtx_rtree_index_end_build,
 };
 
 struct memtx_rtree_index *
@@ -372,5 +427,6 @@ memtx_rtree_index_new(struct memtx_engine *memtx, struct index_def *def)
 	rtree_init(&index->tree, index->dimension, MEMTX_EXTENT_SIZE,
 		   memtx_index_extent_alloc, memtx_index_extent_free, memtx,
 		   distance_type);
+	rtree_builder_create(&index->builder, &index->tree);
 	return index;
 }
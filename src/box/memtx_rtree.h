@@ -47,6 +47,11 @@ struct memtx_rtree_index {
 	struct index base;
 	unsigned dimension;
 	struct rtree tree;
+	/**
+	 * Collects tuples passed to build_next() to bulk load
+	 * them into the tree in end_build().
+	 */
+	struct rtree_builder builder;
 };
 
 struct memtx_rtree_index *
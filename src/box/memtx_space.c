@@ -40,12 +40,15 @@
 #include "memtx_rtree.h"
 #include "memtx_bitset.h"
 #include "memtx_engine.h"
+#include "memtx_compress.h"
 #include "column_mask.h"
 #include "sequence.h"
 
 static void
 memtx_space_destroy(struct space *space)
 {
+	struct memtx_space *memtx_space = (struct memtx_space *)space;
+	memtx_compressor_destroy(&memtx_space->compressor);
 	free(space);
 }
 
@@ -58,14 +61,25 @@ memtx_space_bsize(struct space *space)
 
 /* {{{ DML */
 
+/** Create a tuple of the space, compressed if configured. */
+static struct tuple *
+memtx_space_tuple_new(struct space *space, const char *data, const char *end)
+{
+	if (space->def->opts.compression == SPACE_COMPRESSION_NONE)
+		return memtx_tuple_new(space->format, data, end);
+	struct memtx_space *memtx_space = (struct memtx_space *)space;
+	return memtx_compressor_tuple_new(&memtx_space->compressor,
+					  space->format, data, end);
+}
+
 void
 memtx_space_update_bsize(struct space *space,
 			 const struct tuple *old_tuple,
 			 const struct tuple *new_tuple)
 {
 	struct memtx_space *memtx_space = (struct memtx_space *)space;
-	ssize_t old_bsize = old_tuple ? box_tuple_bsize(old_tuple) : 0;
-	ssize_t new_bsize = new_tuple ? box_tuple_bsize(new_tuple) : 0;
+	ssize_t old_bsize = old_tuple ? memtx_tuple_stored_bsize(old_tuple) : 0;
+	ssize_t new_bsize = new_tuple ? memtx_tuple_stored_bsize(new_tuple) : 0;
 	assert((ssize_t)memtx_space->bsize + new_bsize - old_bsize >= 0);
 	memtx_space->bsize += new_bsize - old_bsize;
 }
@@ -291,6 +305,19 @@ rollback:
 	return -1;
 }
 
+/**
+ * Mark the changes of a statement made. A tuple inserted by the
+ * statement is pinned until the transaction ends, see
+ * memtx_engine_commit().
+ */
+static inline void
+memtx_space_stmt_done(struct txn_stmt *stmt)
+{
+	stmt->engine_savepoint = stmt;
+	if (stmt->new_tuple != NULL)
+		tuple_ref(stmt->new_tuple);
+}
+
 static inline enum dup_replace_mode
 dup_replace_mode(uint32_t op)
 {
@@ -310,8 +337,8 @@ memtx_space_apply_initial_join_row(struct space *space, struct request *request)
 	if (txn == NULL)
 		return -1;
 	struct txn_stmt *stmt = txn_current_stmt(txn);
-	stmt->new_tuple = memtx_tuple_new(space->format, request->tuple,
-					  request->tuple_end);
+	stmt->new_tuple = memtx_space_tuple_new(space, request->tuple,
+						request->tuple_end);
 	if (stmt->new_tuple == NULL)
 		goto rollback;
 	tuple_ref(stmt->new_tuple);
@@ -333,8 +360,8 @@ memtx_space_execute_replace(struct space *space, struct txn *txn,
 	struct memtx_space *memtx_space = (struct memtx_space *)space;
 	struct txn_stmt *stmt = txn_current_stmt(txn);
 	enum dup_replace_mode mode = dup_replace_mode(request->type);
-	stmt->new_tuple = memtx_tuple_new(space->format, request->tuple,
-					  request->tuple_end);
+	stmt->new_tuple = memtx_space_tuple_new(space, request->tuple,
+						request->tuple_end);
 	if (stmt->new_tuple == NULL)
 		return -1;
 	tuple_ref(stmt->new_tuple);
@@ -343,7 +370,7 @@ memtx_space_execute_replace(struct space *space, struct txn *txn,
 				 mode, &old_tuple) != 0)
 		return -1;
 	stmt->old_tuple = old_tuple;
-	stmt->engine_savepoint = stmt;
+	memtx_space_stmt_done(stmt);
 	/** The new tuple is referenced by the primary key. */
 	*result = stmt->new_tuple;
 	return 0;
@@ -371,7 +398,7 @@ memtx_space_execute_delete(struct space *space, struct txn *txn,
 				 DUP_REPLACE_OR_INSERT, &old_tuple) != 0)
 		return -1;
 	stmt->old_tuple = old_tuple;
-	stmt->engine_savepoint = stmt;
+	memtx_space_stmt_done(stmt);
 	*result = stmt->old_tuple;
 	return 0;
 }
@@ -400,7 +427,9 @@ memtx_space_execute_update(struct space *space, struct txn *txn,
 
 	/* Update the tuple; legacy, request ops are in request->tuple */
 	uint32_t new_size = 0, bsize;
-	const char *old_data = tuple_data_range(stmt->old_tuple, &bsize);
+	const char *old_data = memtx_tuple_decompress(stmt->old_tuple, &bsize);
+	if (old_data == NULL)
+		return -1;
 	const char *new_data =
 		tuple_update_execute(region_aligned_alloc_cb, &fiber()->gc,
 				     request->tuple, request->tuple_end,
@@ -409,8 +438,8 @@ memtx_space_execute_update(struct space *space, struct txn *txn,
 	if (new_data == NULL)
 		return -1;
 
-	stmt->new_tuple = memtx_tuple_new(space->format, new_data,
-					  new_data + new_size);
+	stmt->new_tuple = memtx_space_tuple_new(space, new_data,
+						new_data + new_size);
 	if (stmt->new_tuple == NULL)
 		return -1;
 	tuple_ref(stmt->new_tuple);
@@ -420,7 +449,7 @@ memtx_space_execute_update(struct space *space, struct txn *txn,
 				 DUP_REPLACE, &old_tuple) != 0)
 		return -1;
 	stmt->old_tuple = old_tuple;
-	stmt->engine_savepoint = stmt;
+	memtx_space_stmt_done(stmt);
 	*result = stmt->new_tuple;
 	return 0;
 }
@@ -478,16 +507,18 @@ memtx_space_execute_upsert(struct space *space, struct txn *txn,
 				       request->index_base)) {
 			return -1;
 		}
-		stmt->new_tuple = memtx_tuple_new(space->format,
-						  request->tuple,
-						  request->tuple_end);
+		stmt->new_tuple = memtx_space_tuple_new(space,
+							request->tuple,
+							request->tuple_end);
 		if (stmt->new_tuple == NULL)
 			return -1;
 		tuple_ref(stmt->new_tuple);
 	} else {
 		uint32_t new_size = 0, bsize;
-		const char *old_data = tuple_data_range(stmt->old_tuple,
-							&bsize);
+		const char *old_data = memtx_tuple_decompress(stmt->old_tuple,
+							      &bsize);
+		if (old_data == NULL)
+			return -1;
 		/*
 		 * Update the tuple.
 		 * tuple_upsert_execute() fails on totally wrong
@@ -505,8 +536,8 @@ memtx_space_execute_upsert(struct space *space, struct txn *txn,
 		if (new_data == NULL)
 			return -1;
 
-		stmt->new_tuple = memtx_tuple_new(space->format, new_data,
-						  new_data + new_size);
+		stmt->new_tuple = memtx_space_tuple_new(space, new_data,
+							new_data + new_size);
 		if (stmt->new_tuple == NULL)
 			return -1;
 		tuple_ref(stmt->new_tuple);
@@ -537,7 +568,7 @@ memtx_space_execute_upsert(struct space *space, struct txn *txn,
 				 DUP_REPLACE_OR_INSERT, &old_tuple) != 0)
 		return -1;
 	stmt->old_tuple = old_tuple;
-	stmt->engine_savepoint = stmt;
+	memtx_space_stmt_done(stmt);
 	/* Return nothing: UPSERT does not return data. */
 	return 0;
 }
@@ -625,6 +656,16 @@ memtx_space_check_index_def(struct space *space, struct index_def *index_def)
 			return -1;
 		}
 	}
+	if (index_def->opts.include_count > 0 && index_def->type != TREE) {
+		diag_set(ClientError, ER_UNSUPPORTED,
+			 index_type_strs[index_def->type], "included fields");
+		return -1;
+	}
+	if (index_def->opts.is_roaring && index_def->type != BITSET) {
+		diag_set(ClientError, ER_UNSUPPORTED,
+			 index_type_strs[index_def->type], "roaring bitsets");
+		return -1;
+	}
 	switch (index_def->type) {
 	case HASH:
 		if (! index_def->opts.is_unique) {
@@ -811,7 +852,7 @@ memtx_space_check_format(struct space *space, struct tuple_format *format)
 		 * Check that the tuple is OK according to the
 		 * new format.
 		 */
-		rc = tuple_validate(format, tuple);
+		rc = memtx_tuple_validate(format, tuple);
 		if (rc != 0)
 			break;
 	}
@@ -891,9 +932,21 @@ memtx_space_build_index(struct space *src_space, struct index *new_index,
 		 * Check that the tuple is OK according to the
 		 * new format.
 		 */
-		rc = tuple_validate(new_format, tuple);
+		rc = memtx_tuple_validate(new_format, tuple);
 		if (rc != 0)
 			break;
+		/*
+		 * A compressed tuple keeps plain only the fields
+		 * indexed when it was created.
+		 */
+		if (!memtx_tuple_has_key(tuple, new_index->def->key_def)) {
+			diag_set(ClientError, ER_UNSUPPORTED,
+				 "Compressed space",
+				 "indexing fields of existing tuples "
+				 "which were not indexed before");
+			rc = -1;
+			break;
+		}
 		/*
 		 * @todo: better message if there is a duplicate.
 		 */
@@ -915,6 +968,37 @@ memtx_space_build_index(struct space *src_space, struct index *new_index,
 	return rc;
 }
 
+/**
+ * Check that tuples of a space with ttl can expire, i.e. that
+ * the space has a TREE index starting with ttl_field. A space
+ * is created before its indexes and dropped after them, so
+ * only setting ttl on a space which has indexes fails, while
+ * changing indexes just logs a warning.
+ */
+static int
+memtx_space_check_ttl(struct space *old_space, struct space *new_space)
+{
+	const struct space_opts *opts = &new_space->def->opts;
+	const struct space_opts *old_opts = &old_space->def->opts;
+	if (opts->ttl <= 0 || new_space->index_count == 0 ||
+	    memtx_expire_index(new_space) != NULL)
+		return 0;
+	if (opts->ttl != old_opts->ttl ||
+	    opts->ttl_field != old_opts->ttl_field) {
+		diag_set(ClientError, ER_ALTER_SPACE, space_name(new_space),
+			 "ttl_field must be the first part of a TREE index");
+		return -1;
+	}
+	struct memtx_engine *memtx = (struct memtx_engine *)new_space->engine;
+	if (memtx->state == MEMTX_OK && (old_space->index_count == 0 ||
+					 memtx_expire_index(old_space) != NULL)) {
+		say_warn("space '%s' has ttl, but ttl_field is not the first "
+			 "part of any TREE index, tuples won't expire",
+			 space_name(new_space));
+	}
+	return 0;
+}
+
 static int
 memtx_space_prepare_alter(struct space *old_space, struct space *new_space)
 {
@@ -927,9 +1011,14 @@ memtx_space_prepare_alter(struct space *old_space, struct space *new_space)
 			 "can not switch temporary flag on a non-empty space");
 		return -1;
 	}
+	if (memtx_space_check_ttl(old_space, new_space) != 0)
+		return -1;
 
 	new_memtx_space->replace = old_memtx_space->replace;
 	new_memtx_space->bsize = old_memtx_space->bsize;
+	if (new_space->def->opts.compression == SPACE_COMPRESSION_ZSTD)
+		memtx_compressor_inherit(&new_memtx_space->compressor,
+					 &old_memtx_space->compressor);
 	return 0;
 }
 
@@ -957,6 +1046,35 @@ static const struct space_vtab memtx_space_vtab = {
 	/* .prepare_alter = */ memtx_space_prepare_alter,
 };
 
+/**
+ * Create a key definition over the fields included into an
+ * index, so that the tuple format stores offsets of them too.
+ * Parts repeat types and nullability of the space format and
+ * hence don't impose any new constraints on tuples.
+ */
+static struct key_def *
+memtx_space_include_key_def(struct space_def *def,
+			    struct index_def *index_def)
+{
+	uint32_t count = index_def->opts.include_count;
+	struct key_def *key_def = key_def_new(count);
+	if (key_def == NULL)
+		return NULL;
+	for (uint32_t i = 0; i < count; i++) {
+		uint32_t fieldno = index_def->opts.include[i];
+		enum field_type type = FIELD_TYPE_ANY;
+		enum on_conflict_action nullable_action =
+			ON_CONFLICT_ACTION_NONE;
+		if (fieldno < def->field_count) {
+			type = def->fields[fieldno].type;
+			nullable_action = def->fields[fieldno].nullable_action;
+		}
+		key_def_set_part(key_def, i, fieldno, type, nullable_action,
+				 NULL, COLL_NONE, SORT_ORDER_ASC);
+	}
+	return key_def;
+}
+
 struct space *
 memtx_space_new(struct memtx_engine *memtx,
 		struct space_def *def, struct rlist *key_list)
@@ -970,22 +1088,72 @@ memtx_space_new(struct memtx_engine *memtx,
 
 	/* Create a format from key and field definitions. */
 	int key_count = 0;
+	int include_count = 0;
 	struct index_def *index_def;
-	rlist_foreach_entry(index_def, key_list, link)
+	rlist_foreach_entry(index_def, key_list, link) {
 		key_count++;
-	struct key_def **keys = region_alloc(&fiber()->gc,
-					     sizeof(*keys) * key_count);
+		if (index_def->opts.include_count > 0)
+			include_count++;
+	}
+	struct key_def **keys = region_alloc(&fiber()->gc, sizeof(*keys) *
+					     (include_count + key_count));
 	if (keys == NULL) {
+		diag_set(OutOfMemory, sizeof(*keys) *
+			 (include_count + key_count), "region", "keys");
 		free(memtx_space);
 		return NULL;
 	}
-	key_count = 0;
+	/*
+	 * Included fields go first, so that nullability of
+	 * the fields which are also indexed is set by the key
+	 * parts.
+	 */
+	include_count = 0;
+	rlist_foreach_entry(index_def, key_list, link) {
+		if (index_def->opts.include_count == 0)
+			continue;
+		keys[include_count] =
+			memtx_space_include_key_def(def, index_def);
+		if (keys[include_count] == NULL)
+			goto fail_include;
+		include_count++;
+	}
+	key_count = include_count;
 	rlist_foreach_entry(index_def, key_list, link)
 		keys[key_count++] = index_def->key_def;
 
-	struct tuple_format *format =
-		tuple_format_new(&memtx_tuple_format_vtab, keys, key_count, 0,
-				 def->fields, def->field_count, def->dict);
+	struct tuple_format *format;
+	if (def->opts.compression == SPACE_COMPRESSION_ZSTD) {
+		format = tuple_format_new(&memtx_zstd_tuple_format_vtab,
+					  keys, key_count,
+					  sizeof(struct memtx_zstd_header),
+					  def->fields, def->field_count,
+					  def->dict);
+		/*
+		 * Plain copies of compressed tuples returned to
+		 * the user are allocated from the runtime arena,
+		 * not to eat memtx memory.
+		 */
+		struct tuple_format *unpack_format = NULL;
+		if (format != NULL) {
+			unpack_format = tuple_format_new(
+				&tuple_format_runtime->vtab, keys, key_count,
+				0, def->fields, def->field_count, def->dict);
+		}
+		if (unpack_format != NULL) {
+			tuple_format_ref(unpack_format);
+			format->unpack_format = unpack_format;
+		} else if (format != NULL) {
+			tuple_format_delete(format);
+			format = NULL;
+		}
+	} else {
+		format = tuple_format_new(&memtx_tuple_format_vtab, keys,
+					  key_count, 0, def->fields,
+					  def->field_count, def->dict);
+	}
+	for (int i = 0; i < include_count; i++)
+		key_def_delete(keys[i]);
 	if (format == NULL) {
 		free(memtx_space);
 		return NULL;
@@ -1006,5 +1174,11 @@ memtx_space_new(struct memtx_engine *memtx,
 
 	memtx_space->bsize = 0;
 	memtx_space->replace = memtx_space_replace_no_keys;
+	memtx_compressor_create(&memtx_space->compressor);
 	return (struct space *)memtx_space;
+fail_include:
+	for (int i = 0; i < include_count; i++)
+		key_def_delete(keys[i]);
+	free(memtx_space);
+	return NULL;
 }
@@ -31,6 +31,7 @@
  * SUCH DAMAGE.
  */
 #include "space.h"
+#include "memtx_compress.h"
 
 #if defined(__cplusplus)
 extern "C" {
@@ -48,6 +49,8 @@ struct memtx_space {
 	 */
 	int (*replace)(struct space *, struct tuple *, struct tuple *,
 		       enum dup_replace_mode, struct tuple **);
+	/** Tuple compression state, used if compression is on. */
+	struct memtx_compressor compressor;
 };
 
 /**
@@ -30,6 +30,7 @@
  */
 #include "memtx_tree.h"
 #include "memtx_engine.h"
+#include "memtx_compress.h"
 #include "space.h"
 #include "schema.h" /* space_cache_find() */
 #include "errinj.h"
@@ -38,14 +39,114 @@
 #include "tuple.h"
 #include <third_party/qsort_arg.h>
 #include <small/mempool.h>
+#include <msgpuck.h>
 
 /* {{{ Utilities. *************************************************/
 
 static int
 memtx_tree_qcompare(const void* a, const void *b, void *c)
 {
-	return tuple_compare(*(struct tuple **)a,
-		*(struct tuple **)b, (struct key_def *)c);
+	return memtx_tree_compare((const struct memtx_tree_data *)a,
+				  (const struct memtx_tree_data *)b,
+				  (struct key_def *)c);
+}
+
+/**
+ * Encode the fields of a tuple covered by an index on the fiber
+ * region, see memtx_tree_data::cover.
+ */
+static char *
+memtx_tree_index_encode_cover(struct memtx_tree_index *index,
+			      struct tuple *tuple, uint32_t *size)
+{
+	assert(index->cover_field_count > 0);
+	/* Every MessagePack value takes at least one byte. */
+	char *buf = (char *)region_alloc(&fiber()->gc, tuple->bsize);
+	if (buf == NULL) {
+		diag_set(OutOfMemory, tuple->bsize, "region", "cover");
+		return NULL;
+	}
+	/*
+	 * Covered fields are key parts of the space format, so
+	 * they are kept plain in compressed tuples too.
+	 */
+	const char *pos = tuple_data(tuple);
+	uint32_t field_count = mp_decode_array(&pos);
+	const uint32_t *fieldno = index->cover_fields;
+	field_count = MIN(field_count,
+			  fieldno[index->cover_field_count - 1] + 1);
+	char *wpos = mp_encode_array(buf, field_count);
+	for (uint32_t i = 0; i < field_count; i++) {
+		const char *field = pos;
+		mp_next(&pos);
+		if (i == *fieldno) {
+			memcpy(wpos, field, pos - field);
+			wpos += pos - field;
+			fieldno++;
+		} else {
+			wpos = mp_encode_nil(wpos);
+		}
+	}
+	assert(wpos <= buf + tuple->bsize);
+	*size = wpos - buf;
+	return buf;
+}
+
+/**
+ * Copy the fields of a tuple covered by an index to a new tuple
+ * of the given format.
+ */
+static struct tuple *
+memtx_tree_index_new_cover(struct memtx_tree_index *index,
+			   struct tuple_format *format, struct tuple *tuple)
+{
+	struct region *region = &fiber()->gc;
+	size_t region_svp = region_used(region);
+	uint32_t size;
+	char *data = memtx_tree_index_encode_cover(index, tuple, &size);
+	struct tuple *cover = NULL;
+	if (data != NULL)
+		cover = tuple_new(format, data, data + size);
+	region_truncate(region, region_svp);
+	return cover;
+}
+
+/**
+ * Fill a tree element for a tuple. Failure to copy the covered
+ * fields is not an error: the element then refers to the tuple
+ * only, and cover iterators copy the fields on read. So adding
+ * a tuple to the index doesn't fail because of the copy, which
+ * matters for rollback.
+ */
+static void
+memtx_tree_index_make_data(struct memtx_tree_index *index,
+			   struct tuple *tuple, struct memtx_tree_data *data)
+{
+	data->tuple = tuple;
+	data->hint = tuple_hint(tuple, index->tree.arg);
+	data->cover = NULL;
+	if (index->cover_format == NULL)
+		return;
+	struct tuple *cover = memtx_tree_index_new_cover(index,
+					index->cover_format, tuple);
+	if (cover == NULL)
+		return;
+	tuple_ref(cover);
+	index->cover_bsize += memtx_tuple_size(index->cover_format, cover);
+	data->cover = cover;
+}
+
+/** Drop the copy of covered fields of a removed tree element. */
+static void
+memtx_tree_index_release_data(struct memtx_tree_index *index,
+			      struct memtx_tree_data *data)
+{
+	if (data->cover == NULL)
+		return;
+	index->cover_bsize -= memtx_tuple_size(index->cover_format,
+					       data->cover);
+	tuple_unref(data->cover);
+	data->cover = NULL;
 }
 
 /* {{{ MemtxTree Iterators ****************************************/
@@ -56,7 +157,15 @@ struct tree_iterator {
 	struct memtx_tree_iterator tree_iterator;
 	enum iterator_type type;
 	struct memtx_tree_key_data key_data;
-	struct tuple *current_tuple;
+	/**
+	 * Last returned tuple and its hint, tuple is referenced.
+	 * For a cover iterator, the tuple is the returned copy of
+	 * covered fields and cover is the copy stored in the tree
+	 * element, if any. Otherwise cover is NULL.
+	 */
+	struct memtx_tree_data current;
+	/** Set if the iterator returns copies of covered fields. */
+	bool is_cover;
 	/** Memory pool the iterator was allocated from. */
 	struct mempool *pool;
 };
@@ -75,8 +184,8 @@ static void
 tree_iterator_free(struct iterator *iterator)
 {
 	struct tree_iterator *it = tree_iterator(iterator);
-	if (it->current_tuple != NULL)
-		tuple_unref(it->current_tuple);
+	if (it->current.tuple != NULL)
+		tuple_unref(it->current.tuple);
 	mempool_free(it->pool, it);
 }
 
@@ -88,117 +197,156 @@ tree_iterator_dummie(struct iterator *iterator, struct tuple **ret)
 	return 0;
 }
 
+/**
+ * Remember the tuple returned by the iterator and return it.
+ * A cover iterator returns the copy of covered fields instead,
+ * and makes one if the tree element has none.
+ */
+static inline int
+tree_iterator_set_current(struct tree_iterator *it,
+			  const struct memtx_tree_data *res,
+			  struct tuple **ret)
+{
+	struct memtx_tree_data current = *res;
+	if (!it->is_cover) {
+		/* Not referenced by the iterator. */
+		current.cover = NULL;
+	} else if (res->cover != NULL) {
+		current.tuple = res->cover;
+	} else {
+		struct memtx_tree_index *index =
+			(struct memtx_tree_index *)it->base.index;
+		current.tuple = memtx_tree_index_new_cover(index,
+					tuple_format_runtime, res->tuple);
+		if (current.tuple == NULL) {
+			it->base.next = tree_iterator_dummie;
+			*ret = NULL;
+			return -1;
+		}
+	}
+	it->current = current;
+	tuple_ref(it->current.tuple);
+	*ret = it->current.tuple;
+	return 0;
+}
+
+/**
+ * Return true if the tree iterator still points to the tuple
+ * returned last. A cover iterator doesn't reference the tuple,
+ * so it recognizes the tree element by the copy of covered
+ * fields, which it references.
+ */
+static inline bool
+tree_iterator_is_current(struct tree_iterator *it)
+{
+	struct memtx_tree_data *check =
+		memtx_tree_iterator_get_elem(it->tree, &it->tree_iterator);
+	if (check == NULL)
+		return false;
+	if (!it->is_cover)
+		return check->tuple == it->current.tuple;
+	return it->current.cover != NULL &&
+	       check->cover == it->current.cover;
+}
+
 static int
 tree_iterator_next(struct iterator *iterator, struct tuple **ret)
 {
-	struct tuple **res;
+	struct memtx_tree_data *res;
 	struct tree_iterator *it = tree_iterator(iterator);
-	assert(it->current_tuple != NULL);
-	struct tuple **check = memtx_tree_iterator_get_elem(it->tree, &it->tree_iterator);
-	if (check == NULL || *check != it->current_tuple)
+	assert(it->current.tuple != NULL);
+	if (!tree_iterator_is_current(it))
 		it->tree_iterator =
-			memtx_tree_upper_bound_elem(it->tree, it->current_tuple,
+			memtx_tree_upper_bound_elem(it->tree, it->current,
 						    NULL);
 	else
 		memtx_tree_iterator_next(it->tree, &it->tree_iterator);
-	tuple_unref(it->current_tuple);
-	it->current_tuple = NULL;
+	tuple_unref(it->current.tuple);
+	it->current.tuple = NULL;
 	res = memtx_tree_iterator_get_elem(it->tree, &it->tree_iterator);
 	if (res == NULL) {
 		iterator->next = tree_iterator_dummie;
 		*ret = NULL;
-	} else {
-		*ret = it->current_tuple = *res;
-		tuple_ref(it->current_tuple);
+		return 0;
 	}
-	return 0;
+	return tree_iterator_set_current(it, res, ret);
 }
 
 static int
 tree_iterator_prev(struct iterator *iterator, struct tuple **ret)
 {
 	struct tree_iterator *it = tree_iterator(iterator);
-	assert(it->current_tuple != NULL);
-	struct tuple **check = memtx_tree_iterator_get_elem(it->tree, &it->tree_iterator);
-	if (check == NULL || *check != it->current_tuple)
+	assert(it->current.tuple != NULL);
+	if (!tree_iterator_is_current(it))
 		it->tree_iterator =
-			memtx_tree_lower_bound_elem(it->tree, it->current_tuple,
+			memtx_tree_lower_bound_elem(it->tree, it->current,
 						    NULL);
 	memtx_tree_iterator_prev(it->tree, &it->tree_iterator);
-	tuple_unref(it->current_tuple);
-	it->current_tuple = NULL;
-	struct tuple **res = memtx_tree_iterator_get_elem(it->tree, &it->tree_iterator);
+	tuple_unref(it->current.tuple);
+	it->current.tuple = NULL;
+	struct memtx_tree_data *res =
+		memtx_tree_iterator_get_elem(it->tree, &it->tree_iterator);
 	if (!res) {
 		iterator->next = tree_iterator_dummie;
 		*ret = NULL;
-	} else {
-		*ret = it->current_tuple = *res;
-		tuple_ref(it->current_tuple);
+		return 0;
 	}
-	return 0;
+	return tree_iterator_set_current(it, res, ret);
 }
 
 static int
 tree_iterator_next_equal(struct iterator *iterator, struct tuple **ret)
 {
 	struct tree_iterator *it = tree_iterator(iterator);
-	assert(it->current_tuple != NULL);
-	struct tuple **check = memtx_tree_iterator_get_elem(it->tree,
-						&it->tree_iterator);
-	if (check == NULL || *check != it->current_tuple)
+	assert(it->current.tuple != NULL);
+	if (!tree_iterator_is_current(it))
 		it->tree_iterator =
-			memtx_tree_upper_bound_elem(it->tree, it->current_tuple,
+			memtx_tree_upper_bound_elem(it->tree, it->current,
 						    NULL);
 	else
 		memtx_tree_iterator_next(it->tree, &it->tree_iterator);
-	tuple_unref(it->current_tuple);
-	it->current_tuple = NULL;
-	struct tuple **res = memtx_tree_iterator_get_elem(it->tree,
-						&it->tree_iterator);
+	tuple_unref(it->current.tuple);
+	it->current.tuple = NULL;
+	struct memtx_tree_data *res =
+		memtx_tree_iterator_get_elem(it->tree, &it->tree_iterator);
 	/* Use user key def to save a few loops. */
-	if (!res || memtx_tree_compare_key(*res, &it->key_data,
+	if (!res || memtx_tree_compare_key(res, &it->key_data,
 					   it->index_def->key_def) != 0) {
 		iterator->next = tree_iterator_dummie;
 		*ret = NULL;
-	} else {
-		*ret = it->current_tuple = *res;
-		tuple_ref(it->current_tuple);
+		return 0;
 	}
-	return 0;
+	return tree_iterator_set_current(it, res, ret);
 }
 
 static int
 tree_iterator_prev_equal(struct iterator *iterator, struct tuple **ret)
 {
 	struct tree_iterator *it = tree_iterator(iterator);
-	assert(it->current_tuple != NULL);
-	struct tuple **check = memtx_tree_iterator_get_elem(it->tree,
-						&it->tree_iterator);
-	if (check == NULL || *check != it->current_tuple)
+	assert(it->current.tuple != NULL);
+	if (!tree_iterator_is_current(it))
 		it->tree_iterator =
-			memtx_tree_lower_bound_elem(it->tree, it->current_tuple,
+			memtx_tree_lower_bound_elem(it->tree, it->current,
 						    NULL);
 	memtx_tree_iterator_prev(it->tree, &it->tree_iterator);
-	tuple_unref(it->current_tuple);
-	it->current_tuple = NULL;
-	struct tuple **res = memtx_tree_iterator_get_elem(it->tree,
-						&it->tree_iterator);
+	tuple_unref(it->current.tuple);
+	it->current.tuple = NULL;
+	struct memtx_tree_data *res =
+		memtx_tree_iterator_get_elem(it->tree, &it->tree_iterator);
 	/* Use user key def to save a few loops. */
-	if (!res || memtx_tree_compare_key(*res, &it->key_data,
+	if (!res || memtx_tree_compare_key(res, &it->key_data,
 					   it->index_def->key_def) != 0) {
 		iterator->next = tree_iterator_dummie;
 		*ret = NULL;
-	} else {
-		*ret = it->current_tuple = *res;
-		tuple_ref(it->current_tuple);
+		return 0;
 	}
-	return 0;
+	return tree_iterator_set_current(it, res, ret);
 }
 
 static void
 tree_iterator_set_next_method(struct tree_iterator *it)
 {
-	assert(it->current_tuple != NULL);
+	assert(it->current.tuple != NULL);
 	switch (it->type) {
 	case ITER_EQ:
 		it->base.next = tree_iterator_next_equal;
@@ -232,7 +380,7 @@ tree_iterator_start(struct iterator *iterator, struct tuple **ret)
 	const struct memtx_tree *tree = it->tree;
 	enum iterator_type type = it->type;
 	bool exact = false;
-	assert(it->current_tuple == NULL);
+	assert(it->current.tuple == NULL);
 	if (it->key_data.key == 0) {
 		if (iterator_type_is_reverse(it->type))
 			it->tree_iterator = memtx_tree_iterator_last(tree);
@@ -269,12 +417,12 @@ tree_iterator_start(struct iterator *iterator, struct tuple **ret)
 		}
 	}
 
-	struct tuple **res = memtx_tree_iterator_get_elem(it->tree,
-						&it->tree_iterator);
+	struct memtx_tree_data *res =
+		memtx_tree_iterator_get_elem(it->tree, &it->tree_iterator);
 	if (!res)
 		return 0;
-	*ret = it->current_tuple = *res;
-	tuple_ref(it->current_tuple);
+	if (tree_iterator_set_current(it, res, ret) != 0)
+		return -1;
 	tree_iterator_set_next_method(it);
 	return 0;
 }
@@ -303,8 +451,14 @@ memtx_tree_index_cmp_def(struct memtx_tree_index *index)
 static void
 memtx_tree_index_free(struct memtx_tree_index *index)
 {
+	/* Left if the build failed. */
+	for (size_t i = 0; i < index->build_array_size; i++)
+		memtx_tree_index_release_data(index, &index->build_array[i]);
 	memtx_tree_destroy(&index->tree);
 	free(index->build_array);
+	if (index->cover_format != NULL)
+		tuple_format_unref(index->cover_format);
+	free(index->cover_fields);
 	free(index);
 }
 
@@ -328,9 +482,15 @@ memtx_tree_index_gc_run(struct memtx_gc_task *task, bool *done)
 
 	unsigned int loops = 0;
 	while (!memtx_tree_iterator_is_invalid(itr)) {
-		struct tuple *tuple = *memtx_tree_iterator_get_elem(tree, itr);
+		struct memtx_tree_data *res =
+			memtx_tree_iterator_get_elem(tree, itr);
+		struct tuple *tuple = res->tuple;
+		struct tuple *cover = res->cover;
 		memtx_tree_iterator_next(tree, itr);
-		tuple_unref(tuple);
+		if (index->gc_unref_tuples)
+			tuple_unref(tuple);
+		if (cover != NULL)
+			tuple_unref(cover);
 		if (++loops >= YIELD_LOOPS) {
 			*done = false;
 			return;
@@ -357,12 +517,15 @@ memtx_tree_index_destroy(struct index *base)
 {
 	struct memtx_tree_index *index = (struct memtx_tree_index *)base;
 	struct memtx_engine *memtx = (struct memtx_engine *)base->engine;
-	if (base->def->iid == 0) {
+	if (base->def->iid == 0 || index->cover_format != NULL) {
 		/*
-		 * Primary index. We need to free all tuples stored
-		 * in the index, which may take a while. Schedule a
-		 * background task in order not to block tx thread.
+		 * Primary index or an index with included fields.
+		 * We need to free all tuples or copies of covered
+		 * fields stored in the index, which may take a while.
+		 * Schedule a background task in order not to block
+		 * tx thread.
 		 */
+		index->gc_unref_tuples = base->def->iid == 0;
 		index->gc_task.vtab = &memtx_tree_index_gc_vtab;
 		index->gc_iterator = memtx_tree_iterator_first(&index->tree);
 		memtx_engine_schedule_gc(memtx, &index->gc_task);
@@ -386,6 +549,9 @@ static bool
 memtx_tree_index_depends_on_pk(struct index *base)
 {
 	struct index_def *def = base->def;
+	/* Primary key parts are covered by the index. */
+	if (def->opts.include_count > 0)
+		return true;
 	/* See comment to memtx_tree_index_cmp_def(). */
 	return !def->opts.is_unique || def->key_def->is_nullable;
 }
@@ -401,15 +567,15 @@ static ssize_t
 memtx_tree_index_bsize(struct index *base)
 {
 	struct memtx_tree_index *index = (struct memtx_tree_index *)base;
-	return memtx_tree_mem_used(&index->tree);
+	return memtx_tree_mem_used(&index->tree) + index->cover_bsize;
 }
 
 static int
 memtx_tree_index_random(struct index *base, uint32_t rnd, struct tuple **result)
 {
 	struct memtx_tree_index *index = (struct memtx_tree_index *)base;
-	struct tuple **res = memtx_tree_random(&index->tree, rnd);
-	*result = res != NULL ? *res : NULL;
+	struct memtx_tree_data *res = memtx_tree_random(&index->tree, rnd);
+	*result = res != NULL ? res->tuple : NULL;
 	return 0;
 }
 
@@ -432,8 +598,9 @@ memtx_tree_index_get(struct index *base, const char *key,
 	struct memtx_tree_key_data key_data;
 	key_data.key = key;
 	key_data.part_count = part_count;
-	struct tuple **res = memtx_tree_find(&index->tree, &key_data);
-	*result = res != NULL ? *res : NULL;
+	key_data.hint = key_hint(key, part_count, index->tree.arg);
+	struct memtx_tree_data *res = memtx_tree_find(&index->tree, &key_data);
+	*result = res != NULL ? res->tuple : NULL;
 	return 0;
 }
 
@@ -443,24 +610,32 @@ memtx_tree_index_replace(struct index *base, struct tuple *old_tuple,
 			 struct tuple **result)
 {
 	struct memtx_tree_index *index = (struct memtx_tree_index *)base;
+	struct key_def *cmp_def = index->tree.arg;
 	if (new_tuple) {
-		struct tuple *dup_tuple = NULL;
+		struct memtx_tree_data new_data;
+		memtx_tree_index_make_data(index, new_tuple, &new_data);
+		struct memtx_tree_data dup_data;
+		dup_data.tuple = NULL;
+		dup_data.cover = NULL;
 
 		/* Try to optimistically replace the new_tuple. */
 		int tree_res = memtx_tree_insert(&index->tree,
-						 new_tuple, &dup_tuple);
+						 new_data, &dup_data);
 		if (tree_res) {
+			memtx_tree_index_release_data(index, &new_data);
 			diag_set(OutOfMemory, MEMTX_EXTENT_SIZE,
 				 "memtx_tree_index", "replace");
 			return -1;
 		}
 
+		struct tuple *dup_tuple = dup_data.tuple;
 		uint32_t errcode = replace_check_dup(old_tuple,
 						     dup_tuple, mode);
 		if (errcode) {
-			memtx_tree_delete(&index->tree, new_tuple);
+			memtx_tree_delete(&index->tree, new_data);
 			if (dup_tuple)
-				memtx_tree_insert(&index->tree, dup_tuple, 0);
+				memtx_tree_insert(&index->tree, dup_data, 0);
+			memtx_tree_index_release_data(index, &new_data);
 			struct space *sp = space_cache_find(base->def->space_id);
 			if (sp != NULL)
 				diag_set(ClientError, errcode, base->def->name,
@@ -468,20 +643,29 @@ memtx_tree_index_replace(struct index *base, struct tuple *old_tuple,
 			return -1;
 		}
 		if (dup_tuple) {
+			memtx_tree_index_release_data(index, &dup_data);
 			*result = dup_tuple;
 			return 0;
 		}
 	}
 	if (old_tuple) {
-		memtx_tree_delete(&index->tree, old_tuple);
+		struct memtx_tree_data old_data;
+		old_data.tuple = old_tuple;
+		old_data.hint = tuple_hint(old_tuple, cmp_def);
+		old_data.cover = NULL;
+		struct memtx_tree_data deleted_data;
+		deleted_data.cover = NULL;
+		memtx_tree_delete_value(&index->tree, old_data, &deleted_data);
+		memtx_tree_index_release_data(index, &deleted_data);
 	}
 	*result = old_tuple;
 	return 0;
 }
 
 static struct iterator *
-memtx_tree_index_create_iterator(struct index *base, enum iterator_type type,
-				 const char *key, uint32_t part_count)
+memtx_tree_index_new_iterator(struct index *base, enum iterator_type type,
+			      const char *key, uint32_t part_count,
+			      bool is_cover)
 {
 	struct memtx_tree_index *index = (struct memtx_tree_index *)base;
 	struct memtx_engine *memtx = (struct memtx_engine *)base->engine;
@@ -515,29 +699,64 @@ memtx_tree_index_create_iterator(struct index *base, enum iterator_type type,
 	it->type = type;
 	it->key_data.key = key;
 	it->key_data.part_count = part_count;
+	it->key_data.hint = key_hint(key, part_count, index->tree.arg);
 	it->index_def = base->def;
 	it->tree = &index->tree;
 	it->tree_iterator = memtx_tree_invalid_iterator();
-	it->current_tuple = NULL;
+	it->current.tuple = NULL;
+	it->is_cover = is_cover;
 	return (struct iterator *)it;
 }
 
+static struct iterator *
+memtx_tree_index_create_iterator(struct index *base, enum iterator_type type,
+				 const char *key, uint32_t part_count)
+{
+	return memtx_tree_index_new_iterator(base, type, key, part_count,
+					     false);
+}
+
+static struct iterator *
+memtx_tree_index_create_cover_iterator(struct index *base,
+				       enum iterator_type type,
+				       const char *key, uint32_t part_count)
+{
+	struct memtx_tree_index *index = (struct memtx_tree_index *)base;
+	if (index->cover_format == NULL) {
+		return generic_index_create_cover_iterator(base, type, key,
+							   part_count);
+	}
+	return memtx_tree_index_new_iterator(base, type, key, part_count,
+					     true);
+}
+
 static void
 memtx_tree_index_begin_build(struct index *base)
 {
 	struct memtx_tree_index *index = (struct memtx_tree_index *)base;
 	assert(memtx_tree_size(&index->tree) == 0);
-	(void)index;
+	assert(index->build_array == NULL);
+	struct memtx_engine *memtx = (struct memtx_engine *)base->engine;
+	memtx_tree_builder_create(&index->builder, &index->tree,
+				  memtx->tree_fill_factor);
+	index->build_size_hint = 0;
 }
 
 static int
 memtx_tree_index_reserve(struct index *base, uint32_t size_hint)
 {
 	struct memtx_tree_index *index = (struct memtx_tree_index *)base;
+	/*
+	 * The array is only needed if the input turns out to be
+	 * unsorted, so postpone the allocation until then.
+	 */
+	index->build_size_hint = size_hint;
+	if (index->build_array == NULL)
+		return 0;
 	if (size_hint < index->build_array_alloc_size)
 		return 0;
-	struct tuple **tmp = (struct tuple **)realloc(index->build_array,
-						      size_hint * sizeof(*tmp));
+	struct memtx_tree_data *tmp = (struct memtx_tree_data *)
+		realloc(index->build_array, size_hint * sizeof(*tmp));
 	if (tmp == NULL) {
 		diag_set(OutOfMemory, size_hint * sizeof(*tmp),
 			 "memtx_tree_index", "reserve");
@@ -548,45 +767,102 @@ memtx_tree_index_reserve(struct index *base, uint32_t size_hint)
 	return 0;
 }
 
+/**
+ * Called when build_next() is passed a tuple out of order.
+ * Move the tuples appended to the tree so far to build_array,
+ * where the rest of the input is collected to be sorted in
+ * end_build().
+ */
+static int
+memtx_tree_index_build_unsorted(struct memtx_tree_index *index)
+{
+	assert(index->build_array == NULL);
+	size_t count = memtx_tree_size(&index->tree);
+	size_t alloc_size = MAX(index->build_size_hint,
+				MEMTX_EXTENT_SIZE / sizeof(*index->build_array));
+	alloc_size = MAX(alloc_size, count + count / 2);
+	struct memtx_tree_data *array = (struct memtx_tree_data *)
+		malloc(alloc_size * sizeof(*array));
+	if (array == NULL) {
+		diag_set(OutOfMemory, alloc_size * sizeof(*array),
+			 "memtx_tree_index", "build_next");
+		return -1;
+	}
+	if (memtx_tree_builder_finish(&index->builder) != 0) {
+		free(array);
+		return -1;
+	}
+	struct memtx_tree_iterator itr;
+	itr = memtx_tree_iterator_first(&index->tree);
+	for (size_t i = 0; i < count; i++) {
+		array[i] = *memtx_tree_iterator_get_elem(&index->tree, &itr);
+		memtx_tree_iterator_next(&index->tree, &itr);
+	}
+	struct key_def *cmp_def = index->tree.arg;
+	memtx_tree_destroy(&index->tree);
+	memtx_tree_create(&index->tree, cmp_def, memtx_index_extent_alloc,
+			  memtx_index_extent_free, index->base.engine);
+	index->build_array = array;
+	index->build_array_size = count;
+	index->build_array_alloc_size = alloc_size;
+	return 0;
+}
+
 static int
 memtx_tree_index_build_next(struct index *base, struct tuple *tuple)
 {
 	struct memtx_tree_index *index = (struct memtx_tree_index *)base;
+	struct memtx_tree_data data;
+	memtx_tree_index_make_data(index, tuple, &data);
 	if (index->build_array == NULL) {
-		index->build_array = (struct tuple **)malloc(MEMTX_EXTENT_SIZE);
-		if (index->build_array == NULL) {
-			diag_set(OutOfMemory, MEMTX_EXTENT_SIZE,
-				 "memtx_tree_index", "build_next");
-			return -1;
+		/*
+		 * Append tuples coming in key order to the tree
+		 * directly, sparing the array and the sort.
+		 */
+		if (memtx_tree_size(&index->tree) == 0 ||
+		    memtx_tree_compare(&index->tree.max_elem, &data,
+				       index->tree.arg) < 0) {
+			if (memtx_tree_builder_append(&index->builder,
+						      data) != 0)
+				goto fail;
+			return 0;
 		}
-		index->build_array_alloc_size =
-			MEMTX_EXTENT_SIZE / sizeof(struct tuple*);
+		if (memtx_tree_index_build_unsorted(index) != 0)
+			goto fail;
 	}
 	assert(index->build_array_size <= index->build_array_alloc_size);
 	if (index->build_array_size == index->build_array_alloc_size) {
 		index->build_array_alloc_size = index->build_array_alloc_size +
 					index->build_array_alloc_size / 2;
-		struct tuple **tmp = (struct tuple **)
+		struct memtx_tree_data *tmp = (struct memtx_tree_data *)
 			realloc(index->build_array,
 				index->build_array_alloc_size * sizeof(*tmp));
 		if (tmp == NULL) {
 			diag_set(OutOfMemory, index->build_array_alloc_size *
 				 sizeof(*tmp), "memtx_tree_index", "build_next");
-			return -1;
+			goto fail;
 		}
 		index->build_array = tmp;
 	}
-	index->build_array[index->build_array_size++] = tuple;
+	index->build_array[index->build_array_size++] = data;
 	return 0;
+fail:
+	memtx_tree_index_release_data(index, &data);
+	return -1;
 }
 
 static void
 memtx_tree_index_end_build(struct index *base)
 {
 	struct memtx_tree_index *index = (struct memtx_tree_index *)base;
+	if (index->build_array == NULL) {
+		/* The input was sorted, only inner levels are left. */
+		memtx_tree_builder_finish(&index->builder);
+		return;
+	}
 	struct key_def *cmp_def = memtx_tree_index_cmp_def(index);
 	qsort_arg(index->build_array, index->build_array_size,
-		  sizeof(struct tuple *),
+		  sizeof(index->build_array[0]),
 		  memtx_tree_qcompare, cmp_def);
 	memtx_tree_build(&index->tree, index->build_array,
 			 index->build_array_size);
@@ -601,6 +877,8 @@ struct tree_snapshot_iterator {
 	struct snapshot_iterator base;
 	struct memtx_tree *tree;
 	struct memtx_tree_iterator tree_iterator;
+	/** Decompresses tuples of compressed spaces. */
+	struct memtx_decompressor decompressor;
 };
 
 static void
@@ -611,21 +889,26 @@ tree_snapshot_iterator_free(struct snapshot_iterator *iterator)
 		(struct tree_snapshot_iterator *)iterator;
 	struct memtx_tree *tree = (struct memtx_tree *)it->tree;
 	memtx_tree_iterator_destroy(tree, &it->tree_iterator);
+	memtx_decompressor_destroy(&it->decompressor);
 	free(iterator);
 }
 
-static const char *
-tree_snapshot_iterator_next(struct snapshot_iterator *iterator, uint32_t *size)
+static int
+tree_snapshot_iterator_next(struct snapshot_iterator *iterator,
+			    const char **data, uint32_t *size)
 {
 	assert(iterator->free == tree_snapshot_iterator_free);
 	struct tree_snapshot_iterator *it =
 		(struct tree_snapshot_iterator *)iterator;
-	struct tuple **res = memtx_tree_iterator_get_elem(it->tree,
-						&it->tree_iterator);
-	if (res == NULL)
-		return NULL;
+	struct memtx_tree_data *res =
+		memtx_tree_iterator_get_elem(it->tree, &it->tree_iterator);
+	if (res == NULL) {
+		*data = NULL;
+		return 0;
+	}
 	memtx_tree_iterator_next(it->tree, &it->tree_iterator);
-	return tuple_data_range(*res, size);
+	*data = memtx_decompressor_data(&it->decompressor, res->tuple, size);
+	return *data != NULL ? 0 : -1;
 }
 
 /**
@@ -650,6 +933,7 @@ memtx_tree_index_create_snapshot_iterator(struct index *base)
 	it->tree = &index->tree;
 	it->tree_iterator = memtx_tree_iterator_first(&index->tree);
 	memtx_tree_iterator_freeze(&index->tree, &it->tree_iterator);
+	memtx_decompressor_create(&it->decompressor);
 	return (struct snapshot_iterator *) it;
 }
 
@@ -672,6 +956,7 @@ static const struct index_vtab memtx_tree_index_vtab = {
 	/* .get = */ memtx_tree_index_get,
 	/* .replace = */ memtx_tree_index_replace,
 	/* .create_iterator = */ memtx_tree_index_create_iterator,
+	/* .create_cover_iterator = */ memtx_tree_index_create_cover_iterator,
 	/* .create_snapshot_iterator = */
 		memtx_tree_index_create_snapshot_iterator,
 	/* .info = */ generic_index_info,
@@ -683,6 +968,54 @@ static const struct index_vtab memtx_tree_index_vtab = {
 	/* .end_build = */ memtx_tree_index_end_build,
 };
 
+/**
+ * Set up copying of covered fields to tree elements for an index
+ * with included fields, see memtx_tree_data::cover.
+ */
+static int
+memtx_tree_index_create_cover(struct memtx_tree_index *index,
+			      struct memtx_engine *memtx)
+{
+	struct index_def *def = index->base.def;
+	struct key_def *cmp_def = def->cmp_def;
+	uint32_t max_count = cmp_def->part_count + def->opts.include_count;
+	uint32_t *fields = (uint32_t *)malloc(max_count * sizeof(*fields));
+	if (fields == NULL) {
+		diag_set(OutOfMemory, max_count * sizeof(*fields),
+			 "malloc", "cover_fields");
+		return -1;
+	}
+	uint32_t count = 0;
+	for (uint32_t i = 0; i < max_count; i++) {
+		uint32_t fieldno = i < cmp_def->part_count ?
+				   cmp_def->parts[i].fieldno :
+				   def->opts.include[i - cmp_def->part_count];
+		/* Keep the array sorted and free of duplicates. */
+		uint32_t pos = count;
+		while (pos > 0 && fields[pos - 1] > fieldno)
+			pos--;
+		if (pos > 0 && fields[pos - 1] == fieldno)
+			continue;
+		memmove(fields + pos + 1, fields + pos,
+			(count - pos) * sizeof(*fields));
+		fields[pos] = fieldno;
+		count++;
+	}
+	struct tuple_format *format =
+		tuple_format_new(&memtx_tuple_format_vtab, NULL, 0, 0,
+				 NULL, 0, NULL);
+	if (format == NULL) {
+		free(fields);
+		return -1;
+	}
+	format->engine = memtx;
+	tuple_format_ref(format);
+	index->cover_format = format;
+	index->cover_fields = fields;
+	index->cover_field_count = count;
+	return 0;
+}
+
 struct memtx_tree_index *
 memtx_tree_index_new(struct memtx_engine *memtx, struct index_def *def)
 {
@@ -704,6 +1037,13 @@ memtx_tree_index_new(struct memtx_engine *memtx, struct index_def *def)
 		return NULL;
 	}
 
+	if (def->opts.include_count > 0 &&
+	    memtx_tree_index_create_cover(index, memtx) != 0) {
+		index_def_delete(index->base.def);
+		free(index);
+		return NULL;
+	}
+
 	struct key_def *cmp_def = memtx_tree_index_cmp_def(index);
 	memtx_tree_create(&index->tree, cmp_def, memtx_index_extent_alloc,
 			  memtx_index_extent_free, memtx);
@@ -51,12 +51,62 @@ struct memtx_tree_key_data
 	const char *key;
 	/** Number of msgpacked search fields */
 	uint32_t part_count;
+	/** Comparison hint of the key, @sa key_hint(). */
+	hint_t hint;
 };
 
+/**
+ * BPS tree element. The comparison hint is stored next to the
+ * tuple pointer so that most comparisons on tree descent are
+ * resolved without dereferencing the tuple.
+ */
+struct memtx_tree_data {
+	struct tuple *tuple;
+	/** Comparison hint of the tuple, @sa tuple_hint(). */
+	hint_t hint;
+	/**
+	 * For an index with included fields, a copy of the
+	 * fields covered by the index: key parts, primary key
+	 * parts and included fields at their positions in the
+	 * tuple, other fields replaced with nil. Referenced by
+	 * the tree. Comparisons and covered reads use it instead
+	 * of the tuple. NULL if the index has no included fields
+	 * or the copy failed to allocate.
+	 */
+	struct tuple *cover;
+};
+
+/** Return the tuple to compare a tree element by. */
+static inline struct tuple *
+memtx_tree_data_cmp_tuple(const struct memtx_tree_data *data)
+{
+	return data->cover != NULL ? data->cover : data->tuple;
+}
+
+/**
+ * BPS tree element comparator.
+ * Defined in header in order to allow compiler to inline it.
+ * @param a, b - tree elements to compare.
+ * @param def - key definition.
+ * @retval 0  if a == b in terms of def.
+ * @retval <0 if a < b in terms of def.
+ * @retval >0 if a > b in terms of def.
+ */
+static inline int
+memtx_tree_compare(const struct memtx_tree_data *a,
+		   const struct memtx_tree_data *b, struct key_def *def)
+{
+	int rc = hint_cmp(a->hint, b->hint);
+	if (rc != 0)
+		return rc;
+	return tuple_compare(memtx_tree_data_cmp_tuple(a),
+			     memtx_tree_data_cmp_tuple(b), def);
+}
+
 /**
  * BPS tree element vs key comparator.
  * Defined in header in order to allow compiler to inline it.
- * @param tuple - tuple to compare.
+ * @param data - tree element to compare.
  * @param key_data - key to compare with.
  * @param def - key definition.
  * @retval 0  if tuple == key in terms of def.
@@ -64,22 +114,27 @@ struct memtx_tree_key_data
  * @retval >0 if tuple > key in terms of def.
  */
 static inline int
-memtx_tree_compare_key(const struct tuple *tuple,
+memtx_tree_compare_key(const struct memtx_tree_data *data,
 		       const struct memtx_tree_key_data *key_data,
 		       struct key_def *def)
 {
-	return tuple_compare_with_key(tuple, key_data->key,
-				      key_data->part_count, def);
+	int rc = hint_cmp(data->hint, key_data->hint);
+	if (rc != 0)
+		return rc;
+	return tuple_compare_with_key(memtx_tree_data_cmp_tuple(data),
+				      key_data->key, key_data->part_count,
+				      def);
 }
 
 #define BPS_TREE_NAME memtx_tree
 #define BPS_TREE_BLOCK_SIZE (512)
 #define BPS_TREE_EXTENT_SIZE MEMTX_EXTENT_SIZE
-#define BPS_TREE_COMPARE(a, b, arg) tuple_compare(a, b, arg)
-#define BPS_TREE_COMPARE_KEY(a, b, arg) memtx_tree_compare_key(a, b, arg)
-#define bps_tree_elem_t struct tuple *
+#define BPS_TREE_COMPARE(a, b, arg) memtx_tree_compare(&(a), &(b), arg)
+#define BPS_TREE_COMPARE_KEY(a, b, arg) memtx_tree_compare_key(&(a), b, arg)
+#define bps_tree_elem_t struct memtx_tree_data
 #define bps_tree_key_t struct memtx_tree_key_data *
 #define bps_tree_arg_t struct key_def *
+#define BPS_TREE_NO_DEBUG
 
 #include "salad/bps_tree.h"
 
@@ -91,14 +146,42 @@ memtx_tree_compare_key(const struct tuple *tuple,
 #undef bps_tree_elem_t
 #undef bps_tree_key_t
 #undef bps_tree_arg_t
+#undef BPS_TREE_NO_DEBUG
 
 struct memtx_tree_index {
 	struct index base;
 	struct memtx_tree tree;
-	struct tuple **build_array;
+	/**
+	 * Tuples fed to build_next() are appended to the tree
+	 * directly while they come in key order, which is the
+	 * case for a snapshot primary key. Once an out of order
+	 * tuple is met, the index falls back on collecting tuples
+	 * in build_array and sorting them in end_build().
+	 */
+	struct memtx_tree_builder builder;
+	struct memtx_tree_data *build_array;
 	size_t build_array_size, build_array_alloc_size;
+	/** Size hint passed to reserve(), used on fallback. */
+	uint32_t build_size_hint;
 	struct memtx_gc_task gc_task;
 	struct memtx_tree_iterator gc_iterator;
+	/**
+	 * Set if the gc task must unreference the indexed tuples,
+	 * i.e. the index is primary, not only copies of covered
+	 * fields.
+	 */
+	bool gc_unref_tuples;
+	/**
+	 * Format of the copies of covered fields stored in tree
+	 * elements, NULL if the index has no included fields.
+	 * @sa memtx_tree_data::cover.
+	 */
+	struct tuple_format *cover_format;
+	/** Numbers of the covered fields in ascending order. */
+	uint32_t *cover_fields;
+	uint32_t cover_field_count;
+	/** Size of the copies referenced by the tree, in bytes. */
+	size_t cover_bsize;
 };
 
 struct memtx_tree_index *
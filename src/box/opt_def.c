@@ -44,6 +44,7 @@ const char *opt_type_strs[] = {
 	/* [OPT_STR]	= */ "string",
 	/* [OPT_STRPTR] = */ "string",
 	/* [OPT_ENUM]   = */ "enum",
+	/* [OPT_ARRAY]  = */ "array",
 };
 
 static int
@@ -54,6 +55,7 @@ opt_set(void *opts, const struct opt_def *def, const char **val,
 	uint64_t uval;
 	double dval;
 	uint32_t str_len;
+	uint32_t len;
 	const char *str;
 	char *ptr;
 	char *opt = ((char *) opts) + def->offset;
@@ -135,6 +137,13 @@ opt_set(void *opts, const struct opt_def *def, const char **val,
 			unreachable();
 		};
 		break;
+	case OPT_ARRAY:
+		if (mp_typeof(**val) != MP_ARRAY)
+			return -1;
+		len = mp_decode_array(val);
+		if (def->to_array(val, len, opt, region) != 0)
+			return -1;
+		break;
 	default:
 		unreachable();
 	}
@@ -47,6 +47,7 @@ enum opt_type {
 	OPT_STR,	/* char[] */
 	OPT_STRPTR,	/* char*  */
 	OPT_ENUM,	/* enum */
+	OPT_ARRAY,	/* array */
 	opt_type_MAX,
 };
 
@@ -54,6 +55,16 @@ extern const char *opt_type_strs[];
 
 typedef int64_t (*opt_def_to_enum_cb)(const char *str, uint32_t len);
 
+struct region;
+
+/**
+ * Decode @a len items of a msgpack array option, @a data points
+ * to the first one. Auxiliary memory is allocated on @a region.
+ * @retval 0 on success, -1 if the value is invalid.
+ */
+typedef int (*opt_def_to_array_cb)(const char **data, uint32_t len,
+				   char *opt, struct region *region);
+
 struct opt_def {
 	const char *name;
 	enum opt_type type;
@@ -66,19 +77,24 @@ struct opt_def {
 	uint32_t enum_max;
 	/** If not NULL, used to get a enum value by a string. */
 	opt_def_to_enum_cb to_enum;
+	/** Used to decode an array option. */
+	opt_def_to_array_cb to_array;
 };
 
 #define OPT_DEF(key, type, opts, field) \
 	{ key, type, offsetof(opts, field), sizeof(((opts *)0)->field), \
-	  NULL, 0, NULL, 0, NULL }
+	  NULL, 0, NULL, 0, NULL, NULL }
 
 #define OPT_DEF_ENUM(key, enum_name, opts, field, to_enum) \
 	{ key, OPT_ENUM, offsetof(opts, field), sizeof(int), #enum_name, \
-	  sizeof(enum enum_name), enum_name##_strs, enum_name##_MAX, to_enum }
+	  sizeof(enum enum_name), enum_name##_strs, enum_name##_MAX, to_enum, \
+	  NULL }
 
-#define OPT_END {NULL, opt_type_MAX, 0, 0, NULL, 0, NULL, 0, NULL}
+#define OPT_DEF_ARRAY(key, opts, field, to_array) \
+	{ key, OPT_ARRAY, offsetof(opts, field), sizeof(((opts *)0)->field), \
+	  NULL, 0, NULL, 0, NULL, to_array }
 
-struct region;
+#define OPT_END {NULL, opt_type_MAX, 0, 0, NULL, 0, NULL, 0, NULL, NULL}
 
 /**
  * Populate key options from their msgpack-encoded representation
@@ -30,6 +30,11 @@
  */
 #include "relay.h"
 
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <msgpuck.h>
+
 #include "trivia/config.h"
 #include "trivia/util.h"
 #include "cbus.h"
@@ -37,14 +42,17 @@
 #include "errinj.h"
 #include "fiber.h"
 #include "say.h"
+#include "scoped_guard.h"
 
 #include "coio.h"
 #include "coio_task.h"
 #include "engine.h"
 #include "gc.h"
 #include "iproto_constants.h"
+#include "memtx_engine.h"
 #include "recovery.h"
 #include "replication.h"
+#include "schema_def.h"
 #include "trigger.h"
 #include "vclock.h"
 #include "version.h"
@@ -53,6 +61,21 @@
 #include "xstream.h"
 #include "wal.h"
 
+enum {
+	/**
+	 * Max number of WAL ring rows sent with one writev(),
+	 * see relay_send_wal_ring_rows().
+	 */
+	RELAY_WAL_RING_IOVMAX = 64,
+	/** Size of a checkpoint file chunk sent on JOIN. */
+	RELAY_JOIN_FILE_CHUNK_SIZE = 1024 * 1024,
+	/**
+	 * Rows of a transaction are written to the socket at
+	 * once, unless they take more than this.
+	 */
+	RELAY_TX_BUF_MAX = 1024 * 1024,
+};
+
 /**
  * Cbus message to send status updates from relay to tx thread.
  */
@@ -88,6 +111,13 @@ struct relay {
 	struct cord cord;
 	/** Replica connection */
 	struct ev_io io;
+	/**
+	 * Compression state of the replica connection, NULL if
+	 * it is not compressed. Only used for output: the reader
+	 * fiber decompresses the input with its own state around
+	 * the same contexts, see relay_reader_f().
+	 */
+	struct xrow_zstd *zstd;
 	/** Request sync */
 	uint64_t sync;
 	/** Recovery instance to read xlog from the disk */
@@ -100,6 +130,17 @@ struct relay {
 	struct replica *replica;
 	/** WAL event watcher. */
 	struct wal_watcher wal_watcher;
+	/**
+	 * Position in the WAL ring if rows are sent from the
+	 * ring, WAL_RING_POS_NONE if they are read from xlog.
+	 */
+	uint64_t wal_ring_pos;
+	/**
+	 * Initial JOIN stream this relay feeds and the total
+	 * number of streams, see relay_initial_join().
+	 */
+	uint32_t join_stream_id;
+	uint32_t join_stream_count;
 	/** Set before exiting the relay loop. */
 	bool exiting;
 	/** Relay reader cond. */
@@ -131,6 +172,11 @@ struct relay {
 	struct stailq pending_gc;
 	/** Time when last row was sent to peer. */
 	double last_row_tm;
+	/**
+	 * Encoded rows of the transaction being sent, written
+	 * to the socket when its commit row is sent.
+	 */
+	struct ibuf tx_buf;
 
 	struct {
 		/* Align to prevent false-sharing with tx thread */
@@ -149,18 +195,29 @@ relay_vclock(const struct relay *relay)
 static void
 relay_send(struct relay *relay, struct xrow_header *packet);
 static void
+relay_send_iov(struct relay *relay, struct iovec *iov, int iovcnt,
+	       size_t size);
+static bool
+relay_needs_row(struct relay *relay, uint32_t replica_id, int64_t lsn);
+static void
 relay_send_initial_join_row(struct xstream *stream, struct xrow_header *row);
 static void
 relay_send_row(struct xstream *stream, struct xrow_header *row);
+static void
+relay_flush_tx(struct relay *relay);
 
 static void
-relay_create(struct relay *relay, int fd, uint64_t sync,
+relay_create(struct relay *relay, int fd, struct xrow_zstd *zstd,
+	     uint64_t sync,
 	     void (*stream_write)(struct xstream *, struct xrow_header *))
 {
 	memset(relay, 0, sizeof(*relay));
 	xstream_create(&relay->stream, stream_write);
 	coio_create(&relay->io, fd);
+	relay->zstd = zstd;
 	relay->sync = sync;
+	relay->wal_ring_pos = WAL_RING_POS_NONE;
+	relay->join_stream_count = 1;
 	fiber_cond_create(&relay->reader_cond);
 	diag_create(&relay->diag);
 	stailq_create(&relay->pending_gc);
@@ -196,37 +253,181 @@ relay_set_cord_name(int fd)
 	cord_set_name(name);
 }
 
+/**
+ * Initial data is partitioned among JOIN streams by space id.
+ * System spaces go first in the snapshot and are sent over the
+ * main stream only: the replica needs them to apply the rest.
+ * Engines skip the spaces of other streams while reading the
+ * checkpoint. Called from engine reader threads, so it must
+ * only look at fields which don't change during JOIN.
+ */
+static bool
+relay_skip_join_space(struct xstream *stream, uint32_t space_id)
+{
+	struct relay *relay = container_of(stream, struct relay, stream);
+	uint32_t stream_id = space_id <= BOX_SYSTEM_ID_MAX ? 0 :
+			     space_id % relay->join_stream_count;
+	return stream_id != relay->join_stream_id;
+}
+
 void
-relay_initial_join(int fd, uint64_t sync, struct vclock *vclock)
+relay_initial_join(int fd, struct xrow_zstd *zstd, uint64_t sync,
+		   struct vclock *vclock, uint32_t stream_id,
+		   uint32_t stream_count)
 {
+	assert(stream_id < stream_count);
 	struct relay relay;
-	relay_create(&relay, fd, sync, relay_send_initial_join_row);
+	relay_create(&relay, fd, zstd, sync, relay_send_initial_join_row);
+	relay.join_stream_id = stream_id;
+	relay.join_stream_count = stream_count;
+	if (stream_count > 1)
+		relay.stream.skip_space = relay_skip_join_space;
 	assert(relay.stream.write != NULL);
 	engine_join_xc(vclock, &relay.stream);
 	relay_destroy(&relay);
 }
 
+/** Used to pass arguments to relay_send_file_f(). */
+struct relay_file_arg {
+	struct relay *relay;
+	const char *path;
+};
+
+/**
+ * Read a chunk of a file to the fiber region. Blocks, so it
+ * may only be called from a separate thread.
+ */
+static char *
+relay_read_file_chunk(int fd, const char *path, off_t offset, size_t size)
+{
+	char *buf = (char *)region_alloc(&fiber()->gc, size);
+	if (buf == NULL)
+		tnt_raise(OutOfMemory, size, "region", "file chunk");
+	size_t done = 0;
+	while (done < size) {
+		ssize_t n = pread(fd, buf + done, size - done, offset + done);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0) {
+			tnt_raise(SystemError, "failed to read file '%s'",
+				  path);
+		}
+		done += n;
+	}
+	return buf;
+}
+
+/**
+ * Send a file as a sequence of IPROTO_JOIN_FILE rows.
+ * Invoked from a thread not to block tx on disk reads.
+ * Only row headers are encoded here, chunks go from the
+ * file to the socket with coio_sendfile(), unless the
+ * connection is compressed.
+ */
+static int
+relay_send_file_f(va_list ap)
+{
+	struct relay_file_arg *arg = va_arg(ap, struct relay_file_arg *);
+	struct relay *relay = arg->relay;
+	const char *path = arg->path;
+
+	int fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		diag_set(SystemError, "failed to open file '%s'", path);
+		return -1;
+	}
+	struct stat st;
+	if (fstat(fd, &st) != 0) {
+		diag_set(SystemError, "failed to stat file '%s'", path);
+		close(fd);
+		return -1;
+	}
+	int rc = 0;
+	try {
+		/* The checkpoint is pinned, the file doesn't change. */
+		off_t offset = 0;
+		while (offset < st.st_size) {
+			uint32_t size = MIN(st.st_size - offset,
+					    RELAY_JOIN_FILE_CHUNK_SIZE);
+			struct xrow_header row;
+			xrow_encode_join_file_xc(&row, NULL, size);
+			row.sync = relay->sync;
+			struct iovec iov[XROW_IOVMAX];
+			int iovcnt = xrow_to_iovec_xc(&row, iov);
+			/* The last iovec stands for the chunk. */
+			relay->last_row_tm = ev_monotonic_now(loop());
+			if (relay->zstd != NULL) {
+				iov[iovcnt - 1].iov_base =
+					relay_read_file_chunk(fd, path,
+							      offset, size);
+				coio_writev_zstd(&relay->io, relay->zstd,
+						 iov, iovcnt, 0);
+			} else {
+				coio_writev(&relay->io, iov, iovcnt - 1, 0);
+				coio_sendfile(&relay->io, fd, offset, size);
+			}
+			fiber_gc();
+			offset += size;
+		}
+	} catch (Exception *e) {
+		rc = -1;
+	}
+	close(fd);
+	return rc;
+}
+
+void
+relay_initial_join_files(int fd, struct xrow_zstd *zstd, uint64_t sync,
+			 struct vclock *vclock)
+{
+	struct relay relay;
+	relay_create(&relay, fd, zstd, sync, relay_send_initial_join_row);
+	struct memtx_engine *memtx;
+	memtx = (struct memtx_engine *)engine_by_name("memtx");
+	assert(memtx != NULL);
+	char path[PATH_MAX];
+	snprintf(path, sizeof(path), "%s",
+		 memtx_engine_snapshot_path(memtx, vclock));
+
+	struct relay_file_arg arg = { &relay, path };
+	int rc = cord_costart(&relay.cord, "join_files",
+			      relay_send_file_f, &arg);
+	if (rc == 0)
+		rc = cord_cojoin(&relay.cord);
+	if (rc == 0)
+		rc = engine_join_except(vclock, &relay.stream,
+					(struct engine *)memtx);
+	relay_destroy(&relay);
+	if (rc != 0)
+		diag_raise();
+}
+
 int
 relay_final_join_f(va_list ap)
 {
 	struct relay *relay = va_arg(ap, struct relay *);
 	coio_enable();
 	relay_set_cord_name(relay->io.fd);
+	ibuf_create(&relay->tx_buf, &cord()->slabc, 16 * 1024);
+	auto tx_buf_guard = make_scoped_guard([=] {
+		ibuf_destroy(&relay->tx_buf);
+	});
 
 	/* Send all WALs until stop_vclock */
 	assert(relay->stream.write != NULL);
 	recover_remaining_wals(relay->r, &relay->stream,
 			       &relay->stop_vclock, true);
+	relay_flush_tx(relay);
 	assert(vclock_compare(&relay->r->vclock, &relay->stop_vclock) == 0);
 	return 0;
 }
 
 void
-relay_final_join(int fd, uint64_t sync, struct vclock *start_vclock,
-	         struct vclock *stop_vclock)
+relay_final_join(int fd, struct xrow_zstd *zstd, uint64_t sync,
+		 struct vclock *start_vclock, struct vclock *stop_vclock)
 {
 	struct relay relay;
-	relay_create(&relay, fd, sync, relay_send_row);
+	relay_create(&relay, fd, zstd, sync, relay_send_row);
 	relay.r = recovery_new(cfg_gets("wal_dir"),
 			       cfg_geti("force_recovery"),
 			       start_vclock);
@@ -284,13 +485,16 @@ tx_gc_advance(struct cmsg *msg)
 	free(m);
 }
 
+/**
+ * Create a garbage collection message for xlog files preceding
+ * the current relay position.
+ */
 static void
-relay_on_close_log_f(struct trigger *trigger, void * /* event */)
+relay_add_pending_gc(struct relay *relay)
 {
 	static const struct cmsg_hop route[] = {
 		{tx_gc_advance, NULL}
 	};
-	struct relay *relay = (struct relay *)trigger->data;
 	struct relay_gc_msg *m = (struct relay_gc_msg *)malloc(sizeof(*m));
 	if (m == NULL) {
 		say_warn("failed to allocate relay gc message");
@@ -307,6 +511,12 @@ relay_on_close_log_f(struct trigger *trigger, void * /* event */)
 	stailq_add_tail_entry(&relay->pending_gc, m, in_pending);
 }
 
+static void
+relay_on_close_log_f(struct trigger *trigger, void * /* event */)
+{
+	relay_add_pending_gc((struct relay *)trigger->data);
+}
+
 /**
  * Invoke pending garbage collection requests.
  *
@@ -330,6 +540,123 @@ relay_schedule_pending_gc(struct relay *relay, int64_t signature)
 		cpipe_push(&relay->tx_pipe, &gc_msg->msg);
 }
 
+/**
+ * Account rows of a WAL ring chunk which have been written to
+ * the socket or skipped in the relay vclock.
+ */
+static void
+relay_follow_wal_ring_rows(struct relay *relay, const char *data,
+			   const char *data_end)
+{
+	struct recovery *r = relay->r;
+	while (data < data_end) {
+		const struct wal_ring_rec *rec =
+			(const struct wal_ring_rec *)data;
+		data += wal_ring_rec_size(rec);
+		if (rec->lsn > vclock_get(&r->vclock, rec->replica_id))
+			vclock_follow(&r->vclock, rec->replica_id, rec->lsn);
+	}
+}
+
+/**
+ * Send rows stored in a WAL ring chunk. Unless the replica
+ * passed a sync in SUBSCRIBE, rows are written to the socket
+ * right from the chunk, as they were encoded by WAL, so that
+ * the cost of an extra replica is close to a writev() call.
+ *
+ * The relay vclock is advanced only after a successful write:
+ * it may be used while the write blocks, and must not cover
+ * rows which never made it to the socket if the write fails.
+ */
+static void
+relay_send_wal_ring_rows(struct relay *relay, const char *data,
+			 const char *data_end)
+{
+	struct recovery *r = relay->r;
+	struct iovec iov[RELAY_WAL_RING_IOVMAX];
+	int iovcnt = 0;
+	size_t size = 0;
+	/* Beginning of the rows not accounted in the vclock yet. */
+	const char *unsent = data;
+	/* Rows read from xlog before switching to the ring go first. */
+	relay_flush_tx(relay);
+	while (data < data_end) {
+		const struct wal_ring_rec *rec =
+			(const struct wal_ring_rec *)data;
+		data += wal_ring_rec_size(rec);
+		/*
+		 * Rows of a chunk are ordered by LSN, so rows
+		 * which aren't accounted yet can't be duplicates.
+		 */
+		if (rec->lsn <= vclock_get(&r->vclock, rec->replica_id))
+			continue; /* already sent */
+		if (!relay_needs_row(relay, rec->replica_id, rec->lsn))
+			continue;
+		const char *row_data = (const char *)(rec + 1);
+		if (relay->sync != 0) {
+			struct xrow_header row;
+			mp_decode_uint(&row_data);
+			xrow_header_decode_xc(&row, &row_data,
+					      (const char *)(rec + 1) +
+					      rec->len);
+			relay_send(relay, &row);
+			relay_follow_wal_ring_rows(relay, unsent, data);
+			unsent = data;
+			continue;
+		}
+		iov[iovcnt].iov_base = (void *)row_data;
+		iov[iovcnt].iov_len = rec->len;
+		size += rec->len;
+		if (++iovcnt == RELAY_WAL_RING_IOVMAX) {
+			relay_send_iov(relay, iov, iovcnt, size);
+			relay_follow_wal_ring_rows(relay, unsent, data);
+			unsent = data;
+			iovcnt = 0;
+			size = 0;
+		}
+	}
+	if (iovcnt > 0)
+		relay_send_iov(relay, iov, iovcnt, size);
+	relay_follow_wal_ring_rows(relay, unsent, data_end);
+}
+
+/**
+ * Send rows following the relay vclock from the WAL ring.
+ *
+ * @retval true  all rows written to WAL are sent
+ * @retval false the ring doesn't have all rows the replica
+ *               needs, they must be read from xlog files
+ */
+static bool
+relay_send_from_wal_ring(struct relay *relay)
+{
+	struct recovery *r = relay->r;
+	while (true) {
+		struct wal_ring_chunk *chunk;
+		const char *data, *data_end;
+		if (wal_ring_get(&relay->wal_ring_pos, &r->vclock, &chunk,
+				 &data, &data_end) != 0) {
+			if (relay->wal_ring_pos != WAL_RING_POS_NONE)
+				say_info("fell behind WAL ring, reading xlogs");
+			relay->wal_ring_pos = WAL_RING_POS_NONE;
+			return false;
+		}
+		if (xlog_cursor_is_open(&r->cursor)) {
+			/*
+			 * Caught up with the ring, the rest of
+			 * the current xlog is sent from memory.
+			 */
+			xlog_cursor_close(&r->cursor, false);
+		}
+		if (chunk == NULL)
+			return true;
+		auto chunk_guard = make_scoped_guard([=] {
+			wal_ring_chunk_unref(chunk);
+		});
+		relay_send_wal_ring_rows(relay, data, data_end);
+	}
+}
+
 static void
 relay_process_wal_event(struct wal_watcher *watcher, unsigned events)
 {
@@ -341,9 +668,25 @@ relay_process_wal_event(struct wal_watcher *watcher, unsigned events)
 		 */
 		return;
 	}
+	/*
+	 * Xlog files may have been created while rows were sent
+	 * from the ring, rescan the directory when switching back.
+	 */
+	bool scan_dir = (events & WAL_EVENT_ROTATE) != 0 ||
+			relay->wal_ring_pos != WAL_RING_POS_NONE;
 	try {
+		if (relay_send_from_wal_ring(relay)) {
+			/*
+			 * Xlog files aren't read, so let gc know
+			 * the replica doesn't need the files which
+			 * were closed by WAL.
+			 */
+			if ((events & WAL_EVENT_ROTATE) != 0)
+				relay_add_pending_gc(relay);
+			return;
+		}
 		recover_remaining_wals(relay->r, &relay->stream, NULL,
-				       (events & WAL_EVENT_ROTATE) != 0);
+				       scan_dir);
 	} catch (Exception *e) {
 		e->log();
 		diag_move(diag_get(), &relay->diag);
@@ -365,10 +708,21 @@ relay_reader_f(va_list ap)
 	struct ev_io io;
 	coio_create(&io, relay->io.fd);
 	ibuf_create(&ibuf, &cord()->slabc, 1024);
+	/*
+	 * The replica sends nothing after SUBSCRIBE until it gets
+	 * rows, so there is no compressed input left in the iproto
+	 * connection and the decompressor can be taken over as is.
+	 */
+	struct xrow_zstd zstd_buf, *zstd = NULL;
+	if (relay->zstd != NULL) {
+		xrow_zstd_create(&zstd_buf, relay->zstd->cstream,
+				 relay->zstd->dstream);
+		zstd = &zstd_buf;
+	}
 	try {
 		while (!fiber_is_cancelled()) {
 			struct xrow_header xrow;
-			coio_read_xrow_timeout_xc(&io, &ibuf, &xrow,
+			coio_read_xrow_timeout_xc(&io, zstd, &ibuf, &xrow,
 					replication_disconnect_timeout());
 			/* vclock is followed while decoding, zeroing it. */
 			vclock_create(&relay->recv_vclock);
@@ -388,6 +742,8 @@ relay_reader_f(va_list ap)
 			e->log();
 		}
 	}
+	if (zstd != NULL)
+		xrow_zstd_destroy(zstd);
 	ibuf_destroy(&ibuf);
 	return 0;
 }
@@ -419,6 +775,7 @@ relay_subscribe_f(va_list ap)
 	struct recovery *r = relay->r;
 
 	coio_enable();
+	ibuf_create(&relay->tx_buf, &cord()->slabc, 16 * 1024);
 	cbus_endpoint_create(&relay->endpoint, cord_name(cord()),
 			     fiber_schedule_cb, fiber());
 	cbus_pair("tx", cord_name(cord()), &relay->tx_pipe, &relay->relay_pipe,
@@ -428,6 +785,7 @@ relay_subscribe_f(va_list ap)
 		RLIST_LINK_INITIALIZER, relay_on_close_log_f, relay, NULL
 	};
 	trigger_add(&r->on_close_log, &on_close_log);
+	wal_ring_attach();
 	wal_set_watcher(&relay->wal_watcher, cord_name(cord()),
 			relay_process_wal_event, cbus_process);
 
@@ -498,9 +856,11 @@ relay_subscribe_f(va_list ap)
 	relay->exiting = true;
 	trigger_clear(&on_close_log);
 	wal_clear_watcher(&relay->wal_watcher, cbus_process);
+	wal_ring_detach();
 	cbus_unpair(&relay->tx_pipe, &relay->relay_pipe,
 		    NULL, NULL, cbus_process);
 	cbus_endpoint_destroy(&relay->endpoint, cbus_process);
+	ibuf_destroy(&relay->tx_buf);
 	if (!diag_is_empty(&relay->diag)) {
 		/* An error has occured while ACKs of xlog reading */
 		diag_move(&relay->diag, diag_get());
@@ -514,8 +874,9 @@ relay_subscribe_f(va_list ap)
 
 /** Replication acceptor fiber handler. */
 void
-relay_subscribe(int fd, uint64_t sync, struct replica *replica,
-		struct vclock *replica_clock, uint32_t replica_version_id)
+relay_subscribe(int fd, struct xrow_zstd *zstd, uint64_t sync,
+		struct replica *replica, struct vclock *replica_clock,
+		uint32_t replica_version_id)
 {
 	assert(replica->id != REPLICA_ID_NIL);
 	/* Don't allow multiple relays for the same replica */
@@ -538,7 +899,7 @@ relay_subscribe(int fd, uint64_t sync, struct replica *replica,
 	}
 
 	struct relay relay;
-	relay_create(&relay, fd, sync, relay_send_row);
+	relay_create(&relay, fd, zstd, sync, relay_send_row);
 	relay.r = recovery_new(cfg_gets("wal_dir"),
 			       cfg_geti("force_recovery"),
 			       replica_clock);
@@ -565,7 +926,7 @@ relay_send(struct relay *relay, struct xrow_header *packet)
 {
 	packet->sync = relay->sync;
 	relay->last_row_tm = ev_monotonic_now(loop());
-	coio_write_xrow(&relay->io, packet);
+	coio_write_xrow(&relay->io, relay->zstd, packet);
 	fiber_gc();
 
 	struct errinj *inj = errinj(ERRINJ_RELAY_TIMEOUT, ERRINJ_DOUBLE);
@@ -573,6 +934,19 @@ relay_send(struct relay *relay, struct xrow_header *packet)
 		fiber_sleep(inj->dparam);
 }
 
+/** Send rows encoded in advance. */
+static void
+relay_send_iov(struct relay *relay, struct iovec *iov, int iovcnt,
+	       size_t size)
+{
+	relay->last_row_tm = ev_monotonic_now(loop());
+	coio_writev_zstd(&relay->io, relay->zstd, iov, iovcnt, size);
+
+	struct errinj *inj = errinj(ERRINJ_RELAY_TIMEOUT, ERRINJ_DOUBLE);
+	if (inj != NULL && inj->dparam > 0)
+		fiber_sleep(inj->dparam);
+}
+
 static void
 relay_send_initial_join_row(struct xstream *stream, struct xrow_header *row)
 {
@@ -580,12 +954,10 @@ relay_send_initial_join_row(struct xstream *stream, struct xrow_header *row)
 	relay_send(relay, row);
 }
 
-/** Send a single row to the client. */
-static void
-relay_send_row(struct xstream *stream, struct xrow_header *packet)
+/** Check if a row written to WAL must be sent to the replica. */
+static bool
+relay_needs_row(struct relay *relay, uint32_t replica_id, int64_t lsn)
 {
-	struct relay *relay = container_of(stream, struct relay, stream);
-	assert(iproto_type_is_dml(packet->type));
 	/*
 	 * We're feeding a WAL, thus responding to SUBSCRIBE request.
 	 * In that case, only send a row if it is not from the same replica
@@ -595,10 +967,65 @@ relay_send_row(struct xstream *stream, struct xrow_header *packet)
 	 * it). In the latter case packet's LSN is less than or equal to
 	 * local master's LSN at the moment it received 'SUBSCRIBE' request.
 	 */
-	if (relay->replica == NULL ||
-	    packet->replica_id != relay->replica->id ||
-	    packet->lsn <= vclock_get(&relay->local_vclock_at_subscribe,
-				      packet->replica_id)) {
+	return relay->replica == NULL ||
+	       replica_id != relay->replica->id ||
+	       lsn <= vclock_get(&relay->local_vclock_at_subscribe,
+				 replica_id);
+}
+
+/** Write the buffered rows of a transaction to the socket. */
+static void
+relay_flush_tx(struct relay *relay)
+{
+	size_t size = ibuf_used(&relay->tx_buf);
+	if (size == 0)
+		return;
+	struct iovec iov;
+	iov.iov_base = relay->tx_buf.rpos;
+	iov.iov_len = size;
+	relay_send_iov(relay, &iov, 1, size);
+	ibuf_reset(&relay->tx_buf);
+}
+
+/** Encode a row and append it to the transaction buffer. */
+static void
+relay_buffer_row(struct relay *relay, struct xrow_header *packet)
+{
+	packet->sync = relay->sync;
+	struct iovec iov[XROW_IOVMAX];
+	int iovcnt = xrow_to_iovec_xc(packet, iov);
+	for (int i = 0; i < iovcnt; i++) {
+		void *p = ibuf_alloc(&relay->tx_buf, iov[i].iov_len);
+		if (p == NULL) {
+			tnt_raise(OutOfMemory, iov[i].iov_len,
+				  "ibuf", "relay transaction");
+		}
+		memcpy(p, iov[i].iov_base, iov[i].iov_len);
+	}
+	fiber_gc();
+}
+
+/**
+ * Send a row to the client. Rows of a multi-statement
+ * transaction are buffered and sent with one write when the
+ * commit row arrives, so the replica gets the transaction
+ * as a whole. Rows of a transaction share the replica id,
+ * so relay_needs_row() never splits a transaction.
+ */
+static void
+relay_send_row(struct xstream *stream, struct xrow_header *packet)
+{
+	struct relay *relay = container_of(stream, struct relay, stream);
+	assert(iproto_type_is_dml(packet->type));
+	if (!relay_needs_row(relay, packet->replica_id, packet->lsn))
+		return;
+	if (packet->is_commit && ibuf_used(&relay->tx_buf) == 0) {
+		/* A single-row transaction. */
 		relay_send(relay, packet);
+		return;
 	}
+	relay_buffer_row(relay, packet);
+	if (packet->is_commit ||
+	    ibuf_used(&relay->tx_buf) >= RELAY_TX_BUF_MAX)
+		relay_flush_tx(relay);
 }
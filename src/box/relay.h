@@ -41,6 +41,7 @@ struct relay;
 struct replica;
 struct tt_uuid;
 struct vclock;
+struct xrow_zstd;
 
 /**
  * Returns relay's vclock
@@ -58,29 +59,55 @@ relay_vclock(const struct relay *relay);
  * Send initial JOIN rows to the replica
  *
  * @param fd        client connection
+ * @param zstd      compression state of the connection or
+ *                  NULL, see IPROTO_COMPRESS
  * @param sync      sync from incoming JOIN request
  * @param vclock    vclock of the last checkpoint
+ * @param stream_id id of the stream to feed
+ * @param stream_count number of streams initial data is
+ *                  partitioned among; system spaces are
+ *                  sent over stream 0, user spaces over
+ *                  stream space_id % stream_count
  */
 void
-relay_initial_join(int fd, uint64_t sync, struct vclock *vclock);
+relay_initial_join(int fd, struct xrow_zstd *zstd, uint64_t sync,
+		   struct vclock *vclock, uint32_t stream_id,
+		   uint32_t stream_count);
+
+/**
+ * Send initial JOIN data to the replica, the memtx snapshot
+ * as a file, see IPROTO_JOIN_FILE, other engines as rows.
+ *
+ * @param fd        client connection
+ * @param zstd      compression state of the connection or NULL
+ * @param sync      sync from incoming JOIN request
+ * @param vclock    vclock of the last checkpoint
+ */
+void
+relay_initial_join_files(int fd, struct xrow_zstd *zstd, uint64_t sync,
+			 struct vclock *vclock);
 
 /**
  * Send final JOIN rows to the replica.
  *
  * @param fd        client connection
+ * @param zstd      compression state of the connection or NULL
  * @param sync      sync from incoming JOIN request
  */
 void
-relay_final_join(int fd, uint64_t sync, struct vclock *start_vclock,
-	         struct vclock *stop_vclock);
+relay_final_join(int fd, struct xrow_zstd *zstd, uint64_t sync,
+		 struct vclock *start_vclock, struct vclock *stop_vclock);
 
 /**
  * Subscribe a replica to updates.
  *
+ * @param zstd compression state of the connection or NULL
+ *
  * @return none.
  */
 void
-relay_subscribe(int fd, uint64_t sync, struct replica *replica,
-		struct vclock *replica_vclock, uint32_t replica_version_id);
+relay_subscribe(int fd, struct xrow_zstd *zstd, uint64_t sync,
+		struct replica *replica, struct vclock *replica_vclock,
+		uint32_t replica_version_id);
 
 #endif /* TARANTOOL_REPLICATION_RELAY_H_INCLUDED */
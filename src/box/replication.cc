@@ -50,6 +50,7 @@ double replication_connect_timeout = 4.0; /* seconds */
 int replication_connect_quorum = REPLICATION_CONNECT_QUORUM_ALL;
 double replication_sync_lag = 10.0; /* seconds */
 bool replication_skip_conflict = false;
+bool replication_parallel_apply = false;
 
 struct replicaset replicaset;
 
@@ -99,6 +99,12 @@ struct gc_consumer;
 
 static const int REPLICATION_CONNECT_QUORUM_ALL = INT_MAX;
 
+/**
+ * Max number of connections initial data may be sent over
+ * on JOIN, see box.cfg.replication_join_streams.
+ */
+static const uint32_t REPLICATION_JOIN_STREAMS_MAX = 32;
+
 /**
  * Network timeout. Determines how often master and slave exchange
  * heartbeat messages. Set by box.cfg.replication_timeout.
@@ -132,6 +138,12 @@ extern double replication_sync_lag;
  */
 extern bool replication_skip_conflict;
 
+/**
+ * Apply rows of vinyl spaces received from a master in parallel,
+ * @sa applier_apply_tx(). Takes effect on the next SUBSCRIBE.
+ */
+extern bool replication_parallel_apply;
+
 /**
  * Wait for the given period of time before trying to reconnect
  * to a master.
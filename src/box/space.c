@@ -322,6 +322,15 @@ space_before_replace(struct space *space, struct txn *txn,
 	struct tuple *old_tuple;
 	if (index_get(index, key, part_count, &old_tuple) != 0)
 		return -1;
+	/* Triggers and the request need the plain tuple data. */
+	if (old_tuple != NULL) {
+		old_tuple = tuple_unpack(old_tuple);
+		if (old_tuple == NULL)
+			return -1;
+		tuple_ref(old_tuple);
+	}
+	struct tuple *new_tuple = NULL;
+	int rc = -1;
 
 	/*
 	 * Create the new tuple.
@@ -348,7 +357,7 @@ space_before_replace(struct space *space, struct txn *txn,
 					old_data, old_data_end, &new_size,
 					request->index_base, NULL);
 		if (new_data == NULL)
-			return -1;
+			goto out;
 		new_data_end = new_data + new_size;
 		break;
 	case IPROTO_DELETE:
@@ -369,7 +378,7 @@ space_before_replace(struct space *space, struct txn *txn,
 			if (tuple_update_check_ops(region_aligned_alloc_cb, gc,
 					request->ops, request->ops_end,
 					request->index_base) != 0)
-				return -1;
+				goto out;
 			break;
 		}
 		old_data = tuple_data_range(old_tuple, &old_size);
@@ -384,12 +393,11 @@ space_before_replace(struct space *space, struct txn *txn,
 		unreachable();
 	}
 
-	struct tuple *new_tuple = NULL;
 	if (new_data != NULL) {
 		new_tuple = tuple_new(tuple_format_runtime,
 				      new_data, new_data_end);
 		if (new_tuple == NULL)
-			return -1;
+			goto out;
 		tuple_ref(new_tuple);
 	}
 
@@ -412,7 +420,7 @@ space_before_replace(struct space *space, struct txn *txn,
 	stmt->old_tuple = old_tuple;
 	stmt->new_tuple = new_tuple;
 
-	int rc = trigger_run(&space->before_replace, txn);
+	rc = trigger_run(&space->before_replace, txn);
 
 	/*
 	 * BEFORE riggers cannot change the old tuple,
@@ -449,6 +457,8 @@ space_before_replace(struct space *space, struct txn *txn,
 out:
 	if (new_tuple != NULL)
 		tuple_unref(new_tuple);
+	if (old_tuple != NULL)
+		tuple_unref(old_tuple);
 	return rc;
 }
 
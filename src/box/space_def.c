@@ -34,16 +34,28 @@
 #include "error.h"
 #include "sql.h"
 
+const char *space_compression_strs[] = {
+	"none",
+	"zstd",
+};
+
 const struct space_opts space_opts_default = {
 	/* .temporary = */ false,
 	/* .view = */ false,
 	/* .sql        = */ NULL,
+	/* .compression = */ SPACE_COMPRESSION_NONE,
+	/* .ttl = */ 0,
+	/* .ttl_field = */ 0,
 };
 
 const struct opt_def space_opts_reg[] = {
 	OPT_DEF("temporary", OPT_BOOL, struct space_opts, temporary),
 	OPT_DEF("view", OPT_BOOL, struct space_opts, is_view),
 	OPT_DEF("sql", OPT_STRPTR, struct space_opts, sql),
+	OPT_DEF_ENUM("compression", space_compression, struct space_opts,
+		     compression, NULL),
+	OPT_DEF("ttl", OPT_FLOAT, struct space_opts, ttl),
+	OPT_DEF("ttl_field", OPT_UINT32, struct space_opts, ttl_field),
 	OPT_END,
 };
 
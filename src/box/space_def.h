@@ -40,6 +40,15 @@
 extern "C" {
 #endif /* defined(__cplusplus) */
 
+/** Tuple compression of a space. */
+enum space_compression {
+	SPACE_COMPRESSION_NONE = 0,
+	SPACE_COMPRESSION_ZSTD,
+	space_compression_MAX
+};
+
+extern const char *space_compression_strs[];
+
 /** Space options */
 struct space_opts {
         /**
@@ -61,6 +70,19 @@ struct space_opts {
 	 * SQL statement that produced this space.
 	 */
 	char *sql;
+	/**
+	 * Compression of tuple data in memory. Supported
+	 * by memtx only.
+	 */
+	enum space_compression compression;
+	/**
+	 * Time to live of tuples, in seconds: a tuple expires
+	 * ttl seconds after the time stored in field ttl_field.
+	 * 0 disables expiration. Supported by memtx only.
+	 */
+	double ttl;
+	/** Number of the field storing tuple time. */
+	uint32_t ttl_field;
 };
 
 extern const struct space_opts space_opts_default;
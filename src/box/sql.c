@@ -947,7 +947,7 @@ tarantoolSqlite3IdxKeyCompare(struct BtCursor *cursor,
 	const struct tuple *tuple;
 	const char *base;
 	const struct tuple_format *format;
-	const uint32_t *field_map;
+	struct field_map field_map;
 	uint32_t field_count, next_fieldno = 0;
 	const char *p, *field0;
 	u32 i, n;
@@ -992,9 +992,8 @@ tarantoolSqlite3IdxKeyCompare(struct BtCursor *cursor,
 				while (j++ != fieldno)
 					mp_next(&p);
 			} else {
-				p = base + field_map[
-					format->fields[fieldno].offset_slot
-					];
+				p = base + field_map_get_offset(field_map,
+					format->fields[fieldno].offset_slot);
 			}
 		}
 		next_fieldno = fieldno + 1;
@@ -1147,6 +1146,8 @@ cursor_advance(BtCursor *pCur, int *pRes)
 	struct tuple *tuple;
 	if (iterator_next(pCur->iter, &tuple) != 0)
 		return SQL_TARANTOOL_ITERATOR_FAIL;
+	if (tuple != NULL && (tuple = tuple_unpack(tuple)) == NULL)
+		return SQL_TARANTOOL_ITERATOR_FAIL;
 	if (pCur->last_tuple)
 		box_tuple_unref(pCur->last_tuple);
 	if (tuple) {
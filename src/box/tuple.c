@@ -30,6 +30,15 @@
  */
 #include "tuple.h"
 
+#include <sys/mman.h>
+#include <stdio.h>
+#if defined(HAVE_MBIND)
+#include <limits.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+#endif /* defined(HAVE_MBIND) */
+
 #include "trivia/util.h"
 #include "memory.h"
 #include "fiber.h"
@@ -68,6 +77,7 @@ runtime_tuple_new(struct tuple_format *format, const char *data, const char *end
 static struct tuple_format_vtab tuple_format_runtime_vtab = {
 	runtime_tuple_delete,
 	runtime_tuple_new,
+	NULL,
 };
 
 static struct tuple *
@@ -77,7 +87,7 @@ runtime_tuple_new(struct tuple_format *format, const char *data, const char *end
 
 	mp_tuple_assert(data, end);
 	size_t data_len = end - data;
-	size_t meta_size = tuple_format_meta_size(format);
+	size_t meta_size = tuple_format_meta_size(format, data_len);
 	size_t total = sizeof(struct tuple) + meta_size + data_len;
 
 	struct tuple *tuple = (struct tuple *) smalloc(&runtime_alloc, total);
@@ -93,9 +103,9 @@ runtime_tuple_new(struct tuple_format *format, const char *data, const char *end
 	tuple_format_ref(format);
 	tuple->data_offset = sizeof(struct tuple) + meta_size;
 	char *raw = (char *) tuple + tuple->data_offset;
-	uint32_t *field_map = (uint32_t *) raw;
 	memcpy(raw, data, data_len);
-	if (tuple_init_field_map(format, field_map, raw)) {
+	if (tuple_init_field_map(format, raw, field_map_slot_size(data_len),
+				 raw)) {
 		runtime_tuple_delete(format, tuple);
 		return NULL;
 	}
@@ -109,8 +119,8 @@ runtime_tuple_delete(struct tuple_format *format, struct tuple *tuple)
 	assert(format->vtab.tuple_delete == tuple_format_runtime_vtab.tuple_delete);
 	say_debug("%s(%p)", __func__, tuple);
 	assert(tuple->refs == 0);
-	size_t total = sizeof(struct tuple) + tuple_format_meta_size(format) +
-		tuple->bsize;
+	size_t total = sizeof(struct tuple) +
+		tuple_format_meta_size(format, tuple->bsize) + tuple->bsize;
 	tuple_format_unref(format);
 	smfree(&runtime_alloc, tuple, total);
 }
@@ -217,11 +227,123 @@ tuple_init(field_name_hash_f hash)
 	return 0;
 }
 
+const char *tuple_arena_huge_pages_strs[] = { "none", "thp", "hugetlb" };
+
+const char *tuple_arena_numa_policy_strs[] = {
+	"default", "interleave", "bind"
+};
+
+int
+tuple_arena_parse_numa_nodes(const char *str, uint64_t *mask)
+{
+	*mask = 0;
+	const char *p = str;
+	while (*p != '\0') {
+		char *end;
+		unsigned long first = strtoul(p, &end, 10);
+		if (end == p)
+			return -1;
+		unsigned long last = first;
+		p = end;
+		if (*p == '-') {
+			p++;
+			last = strtoul(p, &end, 10);
+			if (end == p)
+				return -1;
+			p = end;
+		}
+		if (first > last || last >= 64)
+			return -1;
+		for (unsigned long node = first; node <= last; node++)
+			*mask |= 1ULL << node;
+		if (*p == ',' && p[1] != '\0')
+			p++;
+		else if (*p != '\0')
+			return -1;
+	}
+	return *mask != 0 ? 0 : -1;
+}
+
+/** Apply the NUMA policy to the arena before any page is touched. */
+static void
+tuple_arena_set_numa_policy(struct slab_arena *arena,
+			    const struct tuple_arena_opts *opts,
+			    const char *arena_name)
+{
+	if (opts->numa_policy == TUPLE_ARENA_NUMA_DEFAULT)
+		return;
+#if defined(HAVE_MBIND)
+	uint64_t nodes = opts->numa_nodes;
+	if (nodes == 0) {
+		char buf[256];
+		FILE *f = fopen("/sys/devices/system/node/online", "r");
+		if (f != NULL) {
+			if (fgets(buf, sizeof(buf), f) != NULL) {
+				buf[strcspn(buf, "\n")] = '\0';
+				tuple_arena_parse_numa_nodes(buf, &nodes);
+			}
+			fclose(f);
+		}
+		if (nodes == 0)
+			nodes = 1;
+	}
+	unsigned long mask = nodes;
+	int mode = opts->numa_policy == TUPLE_ARENA_NUMA_INTERLEAVE ?
+		   MPOL_INTERLEAVE : MPOL_BIND;
+	/* The kernel reads maxnode - 1 bits of the mask. */
+	if (syscall(SYS_mbind, arena->arena, arena->prealloc, mode,
+		    &mask, sizeof(mask) * CHAR_BIT + 1, 0) != 0) {
+		/*
+		 * Interleaving is a hint, but 'bind' is a promise
+		 * about where the tuples live: don't start without it.
+		 */
+		if (opts->numa_policy == TUPLE_ARENA_NUMA_BIND) {
+			panic_syserror("failed to bind %s tuple arena to "
+				       "NUMA nodes", arena_name);
+		}
+		say_syserror("failed to set NUMA policy '%s' for %s tuple "
+			     "arena", tuple_arena_numa_policy_strs[
+				     opts->numa_policy], arena_name);
+	}
+#else
+	if (opts->numa_policy == TUPLE_ARENA_NUMA_BIND) {
+		panic("NUMA policy 'bind' is not supported on this "
+		      "platform");
+	}
+	say_warn("NUMA policy is not supported on this platform, "
+		 "ignoring it for %s tuple arena", arena_name);
+#endif
+}
+
+/** Advise the kernel to back the arena with huge pages. */
+static void
+tuple_arena_advise_huge_pages(struct slab_arena *arena,
+			      const char *arena_name)
+{
+#if defined(HAVE_MADV_HUGEPAGE)
+	if (madvise(arena->arena, arena->prealloc, MADV_HUGEPAGE) != 0) {
+		say_syserror("failed to enable transparent huge pages "
+			     "for %s tuple arena", arena_name);
+	}
+#else
+	say_warn("transparent huge pages are not supported on this "
+		 "platform, ignoring them for %s tuple arena", arena_name);
+#endif
+}
+
 void
 tuple_arena_create(struct slab_arena *arena, struct quota *quota,
 		   uint64_t arena_max_size, uint32_t slab_size,
+		   const struct tuple_arena_opts *opts,
 		   const char *arena_name)
 {
+	struct tuple_arena_opts default_opts = {
+		.huge_pages = TUPLE_ARENA_HUGE_PAGES_NONE,
+		.numa_policy = TUPLE_ARENA_NUMA_DEFAULT,
+		.numa_nodes = 0,
+	};
+	if (opts == NULL)
+		opts = &default_opts;
 	/*
 	 * Ensure that quota is a multiple of slab_size, to
 	 * have accurate value of quota_used_ratio.
@@ -231,6 +353,26 @@ tuple_arena_create(struct slab_arena *arena, struct quota *quota,
 	say_info("mapping %zu bytes for %s tuple arena...", prealloc,
 		 arena_name);
 
+	enum tuple_arena_huge_pages huge_pages = opts->huge_pages;
+	if (huge_pages == TUPLE_ARENA_HUGE_PAGES_HUGETLB) {
+#if defined(HAVE_MAP_HUGETLB)
+		/*
+		 * The slab size is a multiple of the huge page size,
+		 * so slab alignment keeps the mapping unmappable in
+		 * whole huge pages.
+		 */
+		if (slab_arena_create(arena, quota, prealloc, slab_size,
+				      MAP_PRIVATE | MAP_HUGETLB) == 0)
+			goto done;
+		say_syserror("failed to map %s tuple arena from the huge "
+			     "page pool, falling back to transparent huge "
+			     "pages", arena_name);
+#else
+		say_warn("huge page pool is not supported on this platform, "
+			 "falling back to transparent huge pages");
+#endif
+		huge_pages = TUPLE_ARENA_HUGE_PAGES_THP;
+	}
 	if (slab_arena_create(arena, quota, prealloc, slab_size,
 			      MAP_PRIVATE) != 0) {
 		if (errno == ENOMEM) {
@@ -242,6 +384,47 @@ tuple_arena_create(struct slab_arena *arena, struct quota *quota,
 				       " tuple arena", prealloc, arena_name);
 		}
 	}
+	if (huge_pages == TUPLE_ARENA_HUGE_PAGES_THP)
+		tuple_arena_advise_huge_pages(arena, arena_name);
+#if defined(HAVE_MAP_HUGETLB)
+done:
+#endif
+	tuple_arena_set_numa_policy(arena, opts, arena_name);
+}
+
+size_t
+tuple_arena_huge_size(struct slab_arena *arena)
+{
+#if defined(TARGET_OS_LINUX)
+	FILE *f = fopen("/proc/self/smaps", "r");
+	if (f == NULL)
+		return 0;
+	uintptr_t begin = (uintptr_t)arena->arena;
+	uintptr_t end = begin + arena->prealloc;
+	bool inside = false;
+	size_t total = 0;
+	char line[256];
+	while (fgets(line, sizeof(line), f) != NULL) {
+		unsigned long from, to;
+		size_t kb;
+		if (sscanf(line, "%lx-%lx ", &from, &to) == 2) {
+			/* A mapping header line. */
+			inside = from < end && to > begin;
+			continue;
+		}
+		if (!inside)
+			continue;
+		if (sscanf(line, "AnonHugePages: %zu kB", &kb) == 1 ||
+		    sscanf(line, "Private_Hugetlb: %zu kB", &kb) == 1 ||
+		    sscanf(line, "Shared_Hugetlb: %zu kB", &kb) == 1)
+			total += kb * 1024;
+	}
+	fclose(f);
+	return total;
+#else
+	(void)arena;
+	return 0;
+#endif
 }
 
 void
@@ -58,18 +58,69 @@ tuple_init(field_name_hash_f hash);
 void
 tuple_free(void);
 
+/** How a tuple arena uses huge pages. */
+enum tuple_arena_huge_pages {
+	/** Regular pages only. */
+	TUPLE_ARENA_HUGE_PAGES_NONE,
+	/** Advise the kernel to use transparent huge pages. */
+	TUPLE_ARENA_HUGE_PAGES_THP,
+	/** Map the arena from the reserved huge page pool. */
+	TUPLE_ARENA_HUGE_PAGES_HUGETLB,
+	tuple_arena_huge_pages_MAX
+};
+
+extern const char *tuple_arena_huge_pages_strs[];
+
+/** NUMA memory policy of a tuple arena. */
+enum tuple_arena_numa_policy {
+	/** Allocate pages on the node of the touching thread. */
+	TUPLE_ARENA_NUMA_DEFAULT,
+	/** Spread pages evenly over the given nodes. */
+	TUPLE_ARENA_NUMA_INTERLEAVE,
+	/** Allocate pages only on the given nodes. */
+	TUPLE_ARENA_NUMA_BIND,
+	tuple_arena_numa_policy_MAX
+};
+
+extern const char *tuple_arena_numa_policy_strs[];
+
+/** Placement of tuple arena pages in physical memory. */
+struct tuple_arena_opts {
+	enum tuple_arena_huge_pages huge_pages;
+	enum tuple_arena_numa_policy numa_policy;
+	/** Mask of NUMA nodes, 0 means all online nodes. */
+	uint64_t numa_nodes;
+};
+
+/**
+ * Parse a list of NUMA nodes, e.g. "0,2-3", into a mask.
+ * @retval 0 success.
+ * @retval -1 malformed list or a node number is out of range.
+ */
+int
+tuple_arena_parse_numa_nodes(const char *str, uint64_t *mask);
+
 /**
  * Initialize tuples arena.
  * @param arena[out] Arena to initialize.
  * @param quota Arena's quota.
  * @param arena_max_size Maximal size of @arena.
+ * @param opts Page placement options, NULL for defaults.
  * @param arena_name Name of @arena for logs.
  */
 void
 tuple_arena_create(struct slab_arena *arena, struct quota *quota,
 		   uint64_t arena_max_size, uint32_t slab_size,
+		   const struct tuple_arena_opts *opts,
 		   const char *arena_name);
 
+/**
+ * Return the number of bytes of @arena backed by huge pages,
+ * either transparent or from the huge page pool.
+ */
+size_t
+tuple_arena_huge_size(struct slab_arena *arena);
+
 void
 tuple_arena_destroy(struct slab_arena *arena);
 
@@ -301,9 +352,12 @@ box_tuple_upsert(const box_tuple_t *tuple, const char *expr, const
  *   +----------------------+-----------------------+
  *   |      extra_size      | offset N ... offset 1 |
  *   +----------------------+-----------------------+
- *    @sa tuple_format_new()   uint32  ...  uint32
+ *    @sa tuple_format_new()     slot   ...   slot
  *
- * Each 'off_i' is the offset to the i-th indexed field.
+ * Each 'off_i' is the offset to the i-th indexed field. A slot
+ * is 1, 2 or 4 bytes depending on bsize, so the size of
+ * tuple_meta varies among tuples of the same format.
+ * @sa field_map_slot_size()
  */
 struct PACKED tuple
 {
@@ -426,7 +480,8 @@ static inline const char *
 tuple_extra(const struct tuple *tuple)
 {
 	struct tuple_format *format = tuple_format(tuple);
-	return tuple_data(tuple) - tuple_format_meta_size(format);
+	return tuple_data(tuple) -
+	       tuple_format_meta_size(format, tuple->bsize);
 }
 
 /**
@@ -491,10 +546,13 @@ tuple_validate(struct tuple_format *format, struct tuple *tuple)
  * @returns a field map for the tuple.
  * @sa tuple_init_field_map()
  */
-static inline const uint32_t *
+static inline struct field_map
 tuple_field_map(const struct tuple *tuple)
 {
-	return (const uint32_t *) ((const char *) tuple + tuple->data_offset);
+	struct field_map field_map;
+	field_map.end = (const char *) tuple + tuple->data_offset;
+	field_map.slot_size = field_map_slot_size(tuple->bsize);
+	return field_map;
 }
 
 /**
@@ -820,8 +878,26 @@ tuple_unref(struct tuple *tuple)
 
 extern struct tuple *box_tuple_last;
 
+/**
+ * Get a tuple suitable for returning to the user: if the
+ * engine stores the tuple packed (e.g. compressed), a new
+ * unreferenced tuple with plain data is returned.
+ * \retval tuple on success
+ * \retval NULL on error, check diag
+ */
+static inline struct tuple *
+tuple_unpack(struct tuple *tuple)
+{
+	struct tuple_format *format = tuple_format(tuple);
+	if (likely(format->vtab.tuple_unpack == NULL))
+		return tuple;
+	return format->vtab.tuple_unpack(format, tuple);
+}
+
 /**
  * Convert internal `struct tuple` to public `box_tuple_t`.
+ * The returned tuple may differ from \a tuple,
+ * see tuple_unpack().
  * \retval tuple on success
  * \retval NULL on error, check diag
  * \post \a tuple ref counted until the next call.
@@ -832,6 +908,9 @@ static inline box_tuple_t *
 tuple_bless(struct tuple *tuple)
 {
 	assert(tuple != NULL);
+	tuple = tuple_unpack(tuple);
+	if (tuple == NULL)
+		return NULL;
 	/* Ensure tuple can be referenced at least once after return */
 	if (tuple->refs + 2 > TUPLE_REF_MAX) {
 		diag_set(ClientError, ER_TUPLE_REF_OVERFLOW);
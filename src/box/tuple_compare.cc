@@ -32,6 +32,7 @@
 #include "tuple.h"
 #include "coll.h"
 #include "trivia/util.h" /* NOINLINE */
+#include <limits.h>
 #include <math.h>
 
 /* {{{ tuple_compare */
@@ -355,6 +356,22 @@ mp_compare_scalar_coll(const char *field_a, const char *field_b,
 	return mp_compare_scalar_with_hint(field_a, type_a, field_b, type_b);
 }
 
+int
+mp_compare_any_scalar(const char *field_a, const char *field_b)
+{
+	enum mp_type a_type = mp_typeof(*field_a);
+	enum mp_type b_type = mp_typeof(*field_b);
+	enum mp_class a_class = mp_classof(a_type);
+	enum mp_class b_class = mp_classof(b_type);
+	if (a_class != b_class)
+		return COMPARE_RESULT(a_class, b_class);
+	if (a_class == MP_CLASS_NIL)
+		return 0;
+	mp_compare_f cmp = mp_class_comparators[a_class];
+	assert(cmp != NULL);
+	return cmp(field_a, field_b);
+}
+
 /**
  * @brief Compare two fields parts using a type definition
  * @param field_a field
@@ -486,8 +503,8 @@ tuple_compare_slowpath(const struct tuple *tuple_a, const struct tuple *tuple_b,
 	bool was_null_met = false;
 	const struct tuple_format *format_a = tuple_format(tuple_a);
 	const struct tuple_format *format_b = tuple_format(tuple_b);
-	const uint32_t *field_map_a = tuple_field_map(tuple_a);
-	const uint32_t *field_map_b = tuple_field_map(tuple_b);
+	struct field_map field_map_a = tuple_field_map(tuple_a);
+	struct field_map field_map_b = tuple_field_map(tuple_b);
 	const struct key_part *end;
 	const char *field_a, *field_b;
 	enum mp_type a_type, b_type;
@@ -579,7 +596,7 @@ tuple_compare_with_key_slowpath(const struct tuple *tuple, const char *key,
 	const struct key_part *part = key_def->parts;
 	const struct tuple_format *format = tuple_format(tuple);
 	const char *tuple_raw = tuple_data(tuple);
-	const uint32_t *field_map = tuple_field_map(tuple);
+	struct field_map field_map = tuple_field_map(tuple);
 	enum mp_type a_type, b_type;
 	if (likely(part_count == 1)) {
 		const char *field;
@@ -1268,3 +1285,192 @@ tuple_compare_with_key_create(const struct key_def *def)
 }
 
 /* }}} tuple_compare_with_key */
+
+/* {{{ tuple_hint */
+
+/*
+ * A hint is composed of the MsgPack class of the first key part
+ * in the upper bits and an order-preserving digest of the value
+ * in the lower bits. Classes are ordered the same way as
+ * mp_compare_scalar() orders them, so hints of different
+ * classes are comparable. Values which do not fit into the
+ * digest are clamped: equal hints are resolved by a full
+ * comparison anyway.
+ */
+enum {
+	HINT_CLASS_BITS = 3,
+	HINT_VALUE_BITS = sizeof(hint_t) * CHAR_BIT - HINT_CLASS_BITS,
+	/** Number of leading bytes of a string stored in a hint. */
+	HINT_STR_BYTES = HINT_VALUE_BITS / CHAR_BIT,
+};
+
+static_assert(MP_CLASS_BIN < (1 << HINT_CLASS_BITS) - 1,
+	      "a hint never equals HINT_NONE");
+
+#define HINT_VALUE_MAX ((1ULL << HINT_VALUE_BITS) - 1)
+/** Integers in [-HINT_INT_BIAS, HINT_INT_BIAS) are hinted exactly. */
+#define HINT_INT_BIAS (1LL << (HINT_VALUE_BITS - 1))
+
+static inline hint_t
+hint_create(enum mp_class cls, uint64_t value)
+{
+	assert(cls <= MP_CLASS_BIN);
+	assert(value <= HINT_VALUE_MAX);
+	return ((hint_t)cls << HINT_VALUE_BITS) | value;
+}
+
+static inline hint_t
+hint_uint(uint64_t val)
+{
+	uint64_t value = val >= (uint64_t)HINT_INT_BIAS ? HINT_VALUE_MAX :
+			 val + HINT_INT_BIAS;
+	return hint_create(MP_CLASS_NUMBER, value);
+}
+
+static inline hint_t
+hint_int(int64_t val)
+{
+	uint64_t value = val < -HINT_INT_BIAS ? 0 :
+			 val >= HINT_INT_BIAS ? HINT_VALUE_MAX :
+			 (uint64_t)(val + HINT_INT_BIAS);
+	return hint_create(MP_CLASS_NUMBER, value);
+}
+
+static inline hint_t
+hint_double(double val)
+{
+	/* NaN is less than any number, see mp_compare_number(). */
+	if (isnan(val) || val < -HINT_INT_BIAS)
+		return hint_create(MP_CLASS_NUMBER, 0);
+	if (val >= HINT_INT_BIAS)
+		return hint_create(MP_CLASS_NUMBER, HINT_VALUE_MAX);
+	return hint_int((int64_t)floor(val));
+}
+
+/** Hint of a byte string compared with memcmp(). */
+static inline hint_t
+hint_bytes(enum mp_class cls, const unsigned char *s, uint32_t len)
+{
+	uint64_t value = 0;
+	for (uint32_t i = 0; i < HINT_STR_BYTES; i++) {
+		value <<= CHAR_BIT;
+		if (i < len)
+			value |= s[i];
+	}
+	value <<= HINT_VALUE_BITS - HINT_STR_BYTES * CHAR_BIT;
+	return hint_create(cls, value);
+}
+
+static inline hint_t
+hint_str_coll(const char *s, uint32_t len, struct coll *coll)
+{
+	/* Strings are ordered by their ICU sort keys. */
+	unsigned char sort_key[HINT_STR_BYTES];
+	size_t size = coll->hint(s, len, (char *)sort_key,
+				 sizeof(sort_key), coll);
+	return hint_bytes(MP_CLASS_STR, sort_key, size);
+}
+
+/** Compute the hint of a MsgPack field. */
+static hint_t
+field_hint(const char *field, struct coll *coll)
+{
+	uint32_t len;
+	switch (mp_typeof(*field)) {
+	case MP_NIL:
+		return hint_create(MP_CLASS_NIL, 0);
+	case MP_BOOL:
+		return hint_create(MP_CLASS_BOOL, mp_decode_bool(&field));
+	case MP_UINT:
+		return hint_uint(mp_decode_uint(&field));
+	case MP_INT:
+		return hint_int(mp_decode_int(&field));
+	case MP_FLOAT:
+		return hint_double(mp_decode_float(&field));
+	case MP_DOUBLE:
+		return hint_double(mp_decode_double(&field));
+	case MP_STR:
+		field = mp_decode_str(&field, &len);
+		if (coll != NULL)
+			return hint_str_coll(field, len, coll);
+		return hint_bytes(MP_CLASS_STR, (const unsigned char *)field,
+				  len);
+	case MP_BIN:
+		field = mp_decode_bin(&field, &len);
+		return hint_bytes(MP_CLASS_BIN, (const unsigned char *)field,
+				  len);
+	default:
+		return HINT_NONE;
+	}
+}
+
+static hint_t
+tuple_hint_first_part(const struct tuple *tuple,
+		      const struct key_def *key_def)
+{
+	const struct key_part *part = &key_def->parts[0];
+	const char *field = tuple_field_raw(tuple_format(tuple),
+					    tuple_data(tuple),
+					    tuple_field_map(tuple),
+					    part->fieldno);
+	/* An absent optional field is compared as NULL. */
+	if (field == NULL)
+		return hint_create(MP_CLASS_NIL, 0);
+	return field_hint(field, part->coll);
+}
+
+static hint_t
+key_hint_first_part(const char *key, uint32_t part_count,
+		    const struct key_def *key_def)
+{
+	if (part_count == 0)
+		return HINT_NONE;
+	return field_hint(key, key_def->parts[0].coll);
+}
+
+static hint_t
+tuple_hint_none(const struct tuple *tuple, const struct key_def *key_def)
+{
+	(void)tuple;
+	(void)key_def;
+	return HINT_NONE;
+}
+
+static hint_t
+key_hint_none(const char *key, uint32_t part_count,
+	      const struct key_def *key_def)
+{
+	(void)key;
+	(void)part_count;
+	(void)key_def;
+	return HINT_NONE;
+}
+
+void
+key_def_set_hint_func(struct key_def *def)
+{
+	def->tuple_hint = tuple_hint_none;
+	def->key_hint = key_hint_none;
+	if (def->part_count == 0)
+		return;
+	/*
+	 * Hints depend on the value only, not on the field type,
+	 * so an index altered to a compatible type without rebuild
+	 * keeps valid hints.
+	 */
+	switch (def->parts[0].type) {
+	case FIELD_TYPE_UNSIGNED:
+	case FIELD_TYPE_STRING:
+	case FIELD_TYPE_NUMBER:
+	case FIELD_TYPE_INTEGER:
+	case FIELD_TYPE_BOOLEAN:
+	case FIELD_TYPE_SCALAR:
+		def->tuple_hint = tuple_hint_first_part;
+		def->key_hint = key_hint_first_part;
+		break;
+	default:
+		break;
+	}
+}
+
+/* }}} tuple_hint */
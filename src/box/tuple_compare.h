@@ -68,6 +68,24 @@ tuple_compare_create(const struct key_def *key_def);
 tuple_compare_with_key_t
 tuple_compare_with_key_create(const struct key_def *key_def);
 
+/**
+ * Initialize tuple_hint() and key_hint() functions of
+ * the key definition.
+ * @param key_def key definition
+ */
+void
+key_def_set_hint_func(struct key_def *key_def);
+
+/**
+ * Compare two MsgPack values of arbitrary scalar types.
+ * Values of different classes (nil, boolean, number, string,
+ * binary) are ordered by class, two nils are equal. At least
+ * one of the arguments must be a scalar.
+ * @retval <0, 0, >0 - strcmp-style comparison result.
+ */
+int
+mp_compare_any_scalar(const char *field_a, const char *field_b);
+
 #if defined(__cplusplus)
 } /* extern "C" */
 #endif /* defined(__cplusplus) */
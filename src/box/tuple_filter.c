@@ -0,0 +1,252 @@
+/*
+ * Copyright 2010-2019, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include "tuple_filter.h"
+
+#include <assert.h>
+#include <string.h>
+#include <msgpuck.h>
+#include "trivia/util.h"
+#include "small/region.h"
+#include "diag.h"
+#include "errcode.h"
+#include "tuple.h"
+#include "tuple_compare.h"
+
+enum tuple_filter_op {
+	TUPLE_FILTER_EQ,
+	TUPLE_FILTER_NE,
+	TUPLE_FILTER_LT,
+	TUPLE_FILTER_LE,
+	TUPLE_FILTER_GT,
+	TUPLE_FILTER_GE,
+	TUPLE_FILTER_AND,
+	TUPLE_FILTER_OR,
+	TUPLE_FILTER_NOT,
+	tuple_filter_op_MAX,
+};
+
+static const char *tuple_filter_op_strs[] = {
+	/* [TUPLE_FILTER_EQ]  = */ "==",
+	/* [TUPLE_FILTER_NE]  = */ "!=",
+	/* [TUPLE_FILTER_LT]  = */ "<",
+	/* [TUPLE_FILTER_LE]  = */ "<=",
+	/* [TUPLE_FILTER_GT]  = */ ">",
+	/* [TUPLE_FILTER_GE]  = */ ">=",
+	/* [TUPLE_FILTER_AND] = */ "and",
+	/* [TUPLE_FILTER_OR]  = */ "or",
+	/* [TUPLE_FILTER_NOT] = */ "not",
+};
+
+struct tuple_filter {
+	enum tuple_filter_op op;
+	/** Zero-based field number, for comparisons. */
+	uint32_t fieldno;
+	/** MsgPack value to compare the field with. */
+	const char *value;
+	/** Operands of AND, OR and NOT. */
+	struct tuple_filter **args;
+	uint32_t arg_count;
+};
+
+static inline bool
+tuple_filter_op_is_logical(enum tuple_filter_op op)
+{
+	return op >= TUPLE_FILTER_AND;
+}
+
+static int
+tuple_filter_error(const char *msg)
+{
+	diag_set(ClientError, ER_ILLEGAL_PARAMS, tt_sprintf("filter: %s", msg));
+	return -1;
+}
+
+static int
+tuple_filter_decode_op(const char **data, enum tuple_filter_op *op)
+{
+	if (mp_typeof(**data) != MP_STR)
+		return tuple_filter_error("operator must be a string");
+	uint32_t len;
+	const char *str = mp_decode_str(data, &len);
+	for (int i = 0; i < tuple_filter_op_MAX; i++) {
+		if (strlen(tuple_filter_op_strs[i]) == len &&
+		    memcmp(tuple_filter_op_strs[i], str, len) == 0) {
+			*op = (enum tuple_filter_op) i;
+			return 0;
+		}
+	}
+	return tuple_filter_error(tt_sprintf("unknown operator '%.*s'",
+					     (int) len, str));
+}
+
+static struct tuple_filter *
+tuple_filter_decode(struct region *region, const char **data,
+		    uint32_t index_base, int depth)
+{
+	if (depth > TUPLE_FILTER_DEPTH_MAX) {
+		tuple_filter_error("expression is nested too deep");
+		return NULL;
+	}
+	if (mp_typeof(**data) != MP_ARRAY) {
+		tuple_filter_error("expression must be an array");
+		return NULL;
+	}
+	uint32_t size = mp_decode_array(data);
+	if (size == 0) {
+		tuple_filter_error("expression must not be empty");
+		return NULL;
+	}
+	struct tuple_filter *filter =
+		(struct tuple_filter *) region_alloc(region, sizeof(*filter));
+	if (filter == NULL) {
+		diag_set(OutOfMemory, sizeof(*filter), "region_alloc",
+			 "struct tuple_filter");
+		return NULL;
+	}
+	memset(filter, 0, sizeof(*filter));
+	if (tuple_filter_decode_op(data, &filter->op) != 0)
+		return NULL;
+	if (tuple_filter_op_is_logical(filter->op)) {
+		filter->arg_count = size - 1;
+		if (filter->arg_count == 0 ||
+		    (filter->op == TUPLE_FILTER_NOT && filter->arg_count != 1)) {
+			tuple_filter_error(tt_sprintf("wrong number of "
+						      "operands for '%s'",
+					tuple_filter_op_strs[filter->op]));
+			return NULL;
+		}
+		size_t args_size = sizeof(filter->args[0]) * filter->arg_count;
+		filter->args = (struct tuple_filter **)
+			region_alloc(region, args_size);
+		if (filter->args == NULL) {
+			diag_set(OutOfMemory, args_size, "region_alloc",
+				 "filter->args");
+			return NULL;
+		}
+		for (uint32_t i = 0; i < filter->arg_count; i++) {
+			filter->args[i] = tuple_filter_decode(region, data,
+							      index_base,
+							      depth + 1);
+			if (filter->args[i] == NULL)
+				return NULL;
+		}
+		return filter;
+	}
+	if (size != 3) {
+		tuple_filter_error("comparison must have a field number "
+				   "and a value");
+		return NULL;
+	}
+	if (mp_typeof(**data) != MP_UINT) {
+		tuple_filter_error("field number must be unsigned");
+		return NULL;
+	}
+	uint64_t fieldno = mp_decode_uint(data);
+	if (fieldno < index_base || fieldno - index_base >= UINT32_MAX) {
+		tuple_filter_error("invalid field number");
+		return NULL;
+	}
+	filter->fieldno = fieldno - index_base;
+	enum mp_type type = mp_typeof(**data);
+	if (type == MP_ARRAY || type == MP_MAP || type == MP_EXT) {
+		tuple_filter_error("value must be a scalar");
+		return NULL;
+	}
+	filter->value = *data;
+	mp_next(data);
+	return filter;
+}
+
+struct tuple_filter *
+tuple_filter_new(struct region *region, const char *expr,
+		 const char *expr_end, uint32_t index_base)
+{
+	const char *data = expr;
+	if (mp_check(&data, expr_end) != 0) {
+		tuple_filter_error("invalid MsgPack");
+		return NULL;
+	}
+	data = expr;
+	struct tuple_filter *filter =
+		tuple_filter_decode(region, &data, index_base, 0);
+	if (filter != NULL && data != expr_end) {
+		tuple_filter_error("junk after expression");
+		return NULL;
+	}
+	return filter;
+}
+
+bool
+tuple_filter_match(const struct tuple_filter *filter, struct tuple *tuple)
+{
+	switch (filter->op) {
+	case TUPLE_FILTER_AND:
+		for (uint32_t i = 0; i < filter->arg_count; i++) {
+			if (!tuple_filter_match(filter->args[i], tuple))
+				return false;
+		}
+		return true;
+	case TUPLE_FILTER_OR:
+		for (uint32_t i = 0; i < filter->arg_count; i++) {
+			if (tuple_filter_match(filter->args[i], tuple))
+				return true;
+		}
+		return false;
+	case TUPLE_FILTER_NOT:
+		return !tuple_filter_match(filter->args[0], tuple);
+	default:
+		break;
+	}
+	const char *field = tuple_field(tuple, filter->fieldno);
+	if (field == NULL)
+		return false;
+	enum mp_type type = mp_typeof(*field);
+	if (type == MP_ARRAY || type == MP_MAP || type == MP_EXT)
+		return false;
+	int rc = mp_compare_any_scalar(field, filter->value);
+	switch (filter->op) {
+	case TUPLE_FILTER_EQ:
+		return rc == 0;
+	case TUPLE_FILTER_NE:
+		return rc != 0;
+	case TUPLE_FILTER_LT:
+		return rc < 0;
+	case TUPLE_FILTER_LE:
+		return rc <= 0;
+	case TUPLE_FILTER_GT:
+		return rc > 0;
+	case TUPLE_FILTER_GE:
+		return rc >= 0;
+	default:
+		unreachable();
+		return false;
+	}
+}
@@ -0,0 +1,88 @@
+#ifndef TARANTOOL_BOX_TUPLE_FILTER_H_INCLUDED
+#define TARANTOOL_BOX_TUPLE_FILTER_H_INCLUDED
+/*
+ * Copyright 2010-2019, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+struct region;
+struct tuple;
+
+/**
+ * A predicate over tuple fields which can be evaluated
+ * during index iteration without leaving C.
+ *
+ * A predicate is a MsgPack array of one of the following
+ * forms:
+ *
+ *   [op, fieldno, value]    op is one of '==', '!=', '<', '<=',
+ *                           '>', '>='; value is a scalar
+ *   ['and', pred, ...]      all of the predicates hold
+ *   ['or', pred, ...]       at least one predicate holds
+ *   ['not', pred]           the predicate does not hold
+ *
+ * Scalars are compared the same way the SCALAR index type
+ * does. A comparison with a field that is absent from the
+ * tuple or is an array or a map never holds.
+ */
+struct tuple_filter;
+
+/** Maximal nesting depth of a filter expression. */
+enum { TUPLE_FILTER_DEPTH_MAX = 32 };
+
+/**
+ * Compile a filter expression.
+ * @param region Region to allocate the filter on.
+ * @param expr MsgPack encoded expression. It is referenced
+ *        by the compiled filter so must outlive it.
+ * @param expr_end End of the expression.
+ * @param index_base Base of field numbers in the expression.
+ * @retval NULL Memory or format error, diag is set.
+ * @retval not NULL Compiled filter.
+ */
+struct tuple_filter *
+tuple_filter_new(struct region *region, const char *expr,
+		 const char *expr_end, uint32_t index_base);
+
+/** Check if a tuple matches a filter. */
+bool
+tuple_filter_match(const struct tuple_filter *filter, struct tuple *tuple);
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
+
+#endif /* TARANTOOL_BOX_TUPLE_FILTER_H_INCLUDED */
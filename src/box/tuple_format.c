@@ -56,7 +56,7 @@ tuple_format_create(struct tuple_format *format, struct key_def * const *keys,
 		tuple_format_min_field_count(keys, key_count, fields,
 					     field_count);
 	if (format->field_count == 0) {
-		format->field_map_size = 0;
+		format->field_map_count = 0;
 		return 0;
 	}
 	/* Initialize defined fields */
@@ -180,6 +180,7 @@ tuple_format_create(struct tuple_format *format, struct key_def * const *keys,
 	}
 
 	assert(format->fields[0].offset_slot == TUPLE_OFFSET_SLOT_NIL);
+	/* Field map of a big tuple has 4-byte slots. */
 	size_t field_map_size = -current_slot * sizeof(uint32_t);
 	if (field_map_size + format->extra_size > UINT16_MAX) {
 		/** tuple->data_offset is 16 bits */
@@ -187,7 +188,7 @@ tuple_format_create(struct tuple_format *format, struct key_def * const *keys,
 			 -current_slot);
 		return -1;
 	}
-	format->field_map_size = field_map_size;
+	format->field_map_count = -current_slot;
 	return 0;
 }
 
@@ -279,6 +280,7 @@ tuple_format_alloc(struct key_def * const *keys, uint16_t key_count,
 	format->index_field_count = index_field_count;
 	format->exact_field_count = 0;
 	format->min_field_count = 0;
+	format->unpack_format = NULL;
 	return format;
 }
 
@@ -287,6 +289,8 @@ static inline void
 tuple_format_destroy(struct tuple_format *format)
 {
 	tuple_dictionary_unref(format->dict);
+	if (format->unpack_format != NULL)
+		tuple_format_unref(format->unpack_format);
 }
 
 void
@@ -377,6 +381,8 @@ tuple_format_dup(struct tuple_format *src)
 	}
 	memcpy(format, src, total);
 	tuple_dictionary_ref(format->dict);
+	if (format->unpack_format != NULL)
+		tuple_format_ref(format->unpack_format);
 	format->id = FORMAT_ID_NIL;
 	format->refs = 0;
 	if (tuple_format_register(format) != 0) {
@@ -389,8 +395,8 @@ tuple_format_dup(struct tuple_format *src)
 
 /** @sa declaration for details. */
 int
-tuple_init_field_map(const struct tuple_format *format, uint32_t *field_map,
-		     const char *tuple)
+tuple_init_field_map(const struct tuple_format *format, char *field_map,
+		     uint32_t slot_size, const char *tuple)
 {
 	if (format->field_count == 0)
 		return 0; /* Nothing to initialize */
@@ -429,8 +435,8 @@ tuple_init_field_map(const struct tuple_format *format, uint32_t *field_map,
 		 * Nullify field map to be able to detect by 0,
 		 * which key fields are absent in tuple_field().
 		 */
-		memset((char *)field_map - format->field_map_size, 0,
-		       format->field_map_size);
+		size_t field_map_size = format->field_map_count * slot_size;
+		memset(field_map - field_map_size, 0, field_map_size);
 	}
 	for (; i < defined_field_count; ++i, ++field) {
 		mp_type = mp_typeof(*pos);
@@ -439,8 +445,8 @@ tuple_init_field_map(const struct tuple_format *format, uint32_t *field_map,
 					 tuple_field_is_nullable(field)))
 			return -1;
 		if (field->offset_slot != TUPLE_OFFSET_SLOT_NIL) {
-			field_map[field->offset_slot] =
-				(uint32_t) (pos - tuple);
+			field_map_set_offset(field_map, slot_size,
+					     field->offset_slot, pos - tuple);
 		}
 		mp_next(&pos);
 	}
@@ -584,7 +590,7 @@ tuple_field_go_to_key(const char **field, const char *key, int len)
 
 int
 tuple_field_raw_by_path(struct tuple_format *format, const char *tuple,
-                        const uint32_t *field_map, const char *path,
+                        struct field_map field_map, const char *path,
                         uint32_t path_len, uint32_t path_hash,
                         const char **field)
 {
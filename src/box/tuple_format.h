@@ -31,6 +31,7 @@
  * SUCH DAMAGE.
  */
 
+#include "bit/bit.h"
 #include "key_def.h"
 #include "field_def.h"
 #include "errinj.h"
@@ -80,6 +81,14 @@ struct tuple_format_vtab {
 	struct tuple*
 	(*tuple_new)(struct tuple_format *format, const char *data,
 	             const char *end);
+	/**
+	 * Return a tuple with plain MessagePack data for a tuple
+	 * the engine stores in a packed form, or the tuple itself.
+	 * A new tuple is returned unreferenced. May be NULL if
+	 * tuples of the format are always plain.
+	 */
+	struct tuple *
+	(*tuple_unpack)(struct tuple_format *format, struct tuple *tuple);
 };
 
 /** Tuple field meta information for tuple_format. */
@@ -147,10 +156,11 @@ struct tuple_format {
 	 */
 	uint16_t extra_size;
 	/**
-	 * Size of field map of tuple in bytes.
-	 * \sa struct tuple
+	 * Number of slots in field map of tuple. The size of a
+	 * slot depends on the tuple size.
+	 * \sa struct tuple, field_map_slot_size()
 	 */
-	uint16_t field_map_size;
+	uint16_t field_map_count;
 	/**
 	 * If not set (== 0), any tuple in the space can have any number of
 	 * fields. If set, each tuple must have exactly this number of fields.
@@ -172,6 +182,12 @@ struct tuple_format {
 	 * Shared names storage used by all formats of a space.
 	 */
 	struct tuple_dictionary *dict;
+	/**
+	 * Runtime format of the tuples returned by
+	 * vtab.tuple_unpack, NULL if the format doesn't pack
+	 * tuples. Referenced by the format.
+	 */
+	struct tuple_format *unpack_format;
 	/* Formats of the fields */
 	struct tuple_field fields[0];
 };
@@ -253,17 +269,46 @@ tuple_format1_can_store_format2_tuples(const struct tuple_format *format1,
 struct tuple_format *
 tuple_format_dup(struct tuple_format *src);
 
+/**
+ * Return the size of a field map slot of a tuple having
+ * @a bsize bytes of MessagePack data. Field offsets are counted
+ * from the data start and are less than @a bsize, so small
+ * tuples store them in 1 or 2 bytes instead of 4.
+ */
+static inline uint32_t
+field_map_slot_size(uint32_t bsize)
+{
+	if (bsize <= UINT8_MAX)
+		return 1;
+	if (bsize <= UINT16_MAX)
+		return 2;
+	return 4;
+}
+
+/**
+ * Return the size of field map of a tuple of this format.
+ * @param format Tuple format.
+ * @param bsize Size of the tuple MessagePack data.
+ */
+static inline uint32_t
+tuple_format_field_map_size(const struct tuple_format *format,
+			    uint32_t bsize)
+{
+	return format->field_map_count * field_map_slot_size(bsize);
+}
+
 /**
  * Returns the total size of tuple metadata of this format.
  * See @link struct tuple @endlink for explanation of tuple layout.
  *
  * @param format Tuple Format.
+ * @param bsize Size of the tuple MessagePack data.
  * @returns the total size of tuple metadata
  */
 static inline uint16_t
-tuple_format_meta_size(const struct tuple_format *format)
+tuple_format_meta_size(const struct tuple_format *format, uint32_t bsize)
 {
-	return format->extra_size + format->field_map_size;
+	return format->extra_size + tuple_format_field_map_size(format, bsize);
 }
 
 /**
@@ -314,11 +359,65 @@ box_tuple_format_unref(box_tuple_format_t *format);
 
 /** \endcond public */
 
+/**
+ * Field map of a tuple: offsets of the indexed fields stored
+ * before the tuple data in slots of the same size.
+ * @sa tuple_init_field_map()
+ */
+struct field_map {
+	/** A pointer behind the last slot of the map. */
+	const char *end;
+	/** Size of a slot, 1, 2 or 4 bytes. */
+	uint32_t slot_size;
+};
+
+/**
+ * Return the field offset stored in a slot of a field map,
+ * 0 if the field is absent.
+ */
+static inline uint32_t
+field_map_get_offset(struct field_map field_map, int32_t offset_slot)
+{
+	assert(offset_slot < 0);
+	switch (field_map.slot_size) {
+	case 1:
+		return load_u8(field_map.end + offset_slot);
+	case 2:
+		return load_u16(field_map.end + offset_slot * 2);
+	default:
+		assert(field_map.slot_size == 4);
+		return load_u32(field_map.end + offset_slot * 4);
+	}
+}
+
+/** Store a field offset in a slot of a field map. */
+static inline void
+field_map_set_offset(char *field_map, uint32_t slot_size,
+		     int32_t offset_slot, uint32_t offset)
+{
+	assert(offset_slot < 0);
+	switch (slot_size) {
+	case 1:
+		assert(offset <= UINT8_MAX);
+		store_u8(field_map + offset_slot, offset);
+		break;
+	case 2:
+		assert(offset <= UINT16_MAX);
+		store_u16(field_map + offset_slot * 2, offset);
+		break;
+	default:
+		assert(slot_size == 4);
+		store_u32(field_map + offset_slot * 4, offset);
+		break;
+	}
+}
+
 /**
  * Fill the field map of tuple with field offsets.
  * @param format    Tuple format.
  * @param field_map A pointer behind the last element of the field
  *                  map.
+ * @param slot_size Size of a field map slot.
  * @param tuple     MessagePack array.
  *
  * @retval  0 Success.
@@ -329,17 +428,18 @@ box_tuple_format_unref(box_tuple_format_t *format);
  *                                ^
  *                             field_map
  * tuple + off_i = indexed_field_i;
+ * @sa field_map_slot_size()
  */
 int
-tuple_init_field_map(const struct tuple_format *format, uint32_t *field_map,
-		     const char *tuple);
+tuple_init_field_map(const struct tuple_format *format, char *field_map,
+		     uint32_t slot_size, const char *tuple);
 
 /**
  * Get a field at the specific position in this MessagePack array.
  * Returns a pointer to MessagePack data.
  * @param format tuple format
  * @param tuple a pointer to MessagePack array
- * @param field_map a pointer to the LAST element of field map
+ * @param field_map field map of the tuple
  * @param field_no the index of field to return
  *
  * @returns field data if field exists or NULL
@@ -347,7 +447,7 @@ tuple_init_field_map(const struct tuple_format *format, uint32_t *field_map,
  */
 static inline const char *
 tuple_field_raw(const struct tuple_format *format, const char *tuple,
-		const uint32_t *field_map, uint32_t field_no)
+		struct field_map field_map, uint32_t field_no)
 {
 	if (likely(field_no < format->index_field_count)) {
 		/* Indexed field */
@@ -359,10 +459,9 @@ tuple_field_raw(const struct tuple_format *format, const char *tuple,
 
 		int32_t offset_slot = format->fields[field_no].offset_slot;
 		if (offset_slot != TUPLE_OFFSET_SLOT_NIL) {
-			if (field_map[offset_slot] != 0)
-				return tuple + field_map[offset_slot];
-			else
-				return NULL;
+			uint32_t offset = field_map_get_offset(field_map,
+							       offset_slot);
+			return offset != 0 ? tuple + offset : NULL;
 		}
 	}
 	ERROR_INJECT(ERRINJ_TUPLE_FIELD, return NULL);
@@ -388,7 +487,7 @@ tuple_field_raw(const struct tuple_format *format, const char *tuple,
  */
 static inline const char *
 tuple_field_raw_by_name(struct tuple_format *format, const char *tuple,
-			const uint32_t *field_map, const char *name,
+			struct field_map field_map, const char *name,
 			uint32_t name_len, uint32_t name_hash)
 {
 	uint32_t fieldno;
@@ -413,7 +512,7 @@ tuple_field_raw_by_name(struct tuple_format *format, const char *tuple,
  */
 int
 tuple_field_raw_by_path(struct tuple_format *format, const char *tuple,
-                        const uint32_t *field_map, const char *path,
+                        struct field_map field_map, const char *path,
                         uint32_t path_len, uint32_t path_hash,
                         const char **field);
 
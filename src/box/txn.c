@@ -64,6 +64,8 @@ txn_add_redo(struct txn_stmt *stmt, struct request *request)
 	row->lsn = 0;
 	row->sync = 0;
 	row->tm = 0;
+	row->tsn = 0;
+	row->is_commit = false;
 	row->bodycnt = xrow_encode_dml(request, row->body);
 	if (row->bodycnt < 0)
 		return -1;
@@ -131,6 +133,8 @@ txn_begin(bool is_autocommit)
 	txn->n_rows = 0;
 	txn->is_autocommit = is_autocommit;
 	txn->has_triggers  = false;
+	txn->is_in_wal = false;
+	txn->can_yield = false;
 	txn->in_sub_stmt = 0;
 	txn->id = ++txn_id;
 	txn->signature = -1;
@@ -148,7 +152,11 @@ txn_begin_in_engine(struct engine *engine, struct txn *txn)
 	if (txn->engine == NULL) {
 		assert(stailq_empty(&txn->stmts));
 		txn->engine = engine;
-		return engine_begin(engine, txn);
+		if (engine_begin(engine, txn) != 0) {
+			txn->engine = NULL;
+			return -1;
+		}
+		return 0;
 	} else if (txn->engine != engine) {
 		/**
 		 * Only one engine can be used in
@@ -259,6 +267,7 @@ txn_write_to_wal(struct txn *txn)
 	assert(row == req->rows + req->n_rows);
 
 	ev_tstamp start = ev_monotonic_now(loop());
+	txn->is_in_wal = true;
 	int64_t res = journal_write(req);
 	ev_tstamp stop = ev_monotonic_now(loop());
 
@@ -277,6 +286,11 @@ txn_write_to_wal(struct txn *txn)
 		say_warn("too long WAL write: %d rows at LSN %lld: %.3f sec",
 			 txn->n_rows, res - txn->n_rows + 1, stop - start);
 	}
+	/* Account the write in the latency of the current request. */
+	double *wal_time = (double *) fiber_get_key(fiber(),
+						    FIBER_KEY_WAL_TIME);
+	if (wal_time != NULL)
+		*wal_time += stop - start;
 	/*
 	 * Use vclock_sum() from WAL writer as transaction signature.
 	 */
@@ -137,6 +137,18 @@ struct txn {
 	bool is_autocommit;
 	/** True if on_commit and on_rollback lists are non-empty. */
 	bool has_triggers;
+	/**
+	 * True once the rows are submitted to the journal and
+	 * the transaction is waiting for them to be written.
+	 */
+	bool is_in_wal;
+	/**
+	 * True if the transaction may yield between statements,
+	 * like an interactive transaction of an iproto stream.
+	 * An engine which can't keep a transaction open across
+	 * yields refuses to take part in it.
+	 */
+	bool can_yield;
 	/** The number of active nested statement-level transactions. */
 	int in_sub_stmt;
 	/**
@@ -595,6 +595,16 @@ vinyl_engine_check_space_def(struct space_def *def)
 			 def->name, "engine does not support temporary flag");
 		return -1;
 	}
+	if (def->opts.compression != SPACE_COMPRESSION_NONE) {
+		diag_set(ClientError, ER_ALTER_SPACE,
+			 def->name, "engine does not support tuple compression");
+		return -1;
+	}
+	if (def->opts.ttl > 0) {
+		diag_set(ClientError, ER_ALTER_SPACE,
+			 def->name, "engine does not support tuple expiration");
+		return -1;
+	}
 	return 0;
 }
 
@@ -685,6 +695,11 @@ vinyl_space_check_index_def(struct space *space, struct index_def *index_def)
 		diag_set(ClientError, ER_NULLABLE_PRIMARY, space_name(space));
 		return -1;
 	}
+	if (index_def->opts.include_count > 0) {
+		diag_set(ClientError, ER_UNSUPPORTED, "Vinyl",
+			 "included fields");
+		return -1;
+	}
 	/* Check that there are no ANY, ARRAY, MAP parts */
 	for (uint32_t i = 0; i < index_def->key_def->part_count; i++) {
 		struct key_part *part = &index_def->key_def->parts[i];
@@ -3149,6 +3164,9 @@ vy_send_lsm(struct vy_join_ctx *ctx, struct vy_lsm_recovery_info *lsm_info)
 	if (lsm_info->index_id != 0)
 		return 0;
 
+	if (xstream_skip_space(ctx->stream, lsm_info->space_id))
+		return 0;
+
 	ctx->space_id = lsm_info->space_id;
 
 	/* Create key definition and tuple format. */
@@ -4106,6 +4124,7 @@ static const struct index_vtab vinyl_index_vtab = {
 	/* .get = */ vinyl_index_get,
 	/* .replace = */ generic_index_replace,
 	/* .create_iterator = */ vinyl_index_create_iterator,
+	/* .create_cover_iterator = */ generic_index_create_cover_iterator,
 	/* .create_snapshot_iterator = */
 		generic_index_create_snapshot_iterator,
 	/* .info = */ vinyl_index_info,
@@ -113,6 +113,7 @@ vy_run_reader_f(va_list ap)
 	cpipe_create(&reader->tx_pipe, "tx_prio");
 	cbus_endpoint_create(&endpoint, cord_name(cord()),
 			     fiber_schedule_cb, fiber());
+	cbus_endpoint_set_spin(&endpoint, CBUS_SPIN_TIMEOUT);
 	cbus_loop(&endpoint);
 	cbus_endpoint_destroy(&endpoint, cbus_process);
 	cpipe_destroy(&reader->tx_pipe);
@@ -54,6 +54,7 @@ vy_tuple_new(struct tuple_format *format, const char *data, const char *end)
 struct tuple_format_vtab vy_tuple_format_vtab = {
 	vy_tuple_delete,
 	vy_tuple_new,
+	NULL,
 };
 
 size_t vy_max_tuple_size = 1024 * 1024;
@@ -89,7 +90,7 @@ vy_tuple_delete(struct tuple_format *format, struct tuple *tuple)
 static struct tuple *
 vy_stmt_alloc(struct tuple_format *format, uint32_t bsize)
 {
-	uint32_t meta_size = tuple_format_meta_size(format);
+	uint32_t meta_size = tuple_format_meta_size(format, bsize);
 	uint32_t total_size = sizeof(struct vy_stmt) + meta_size + bsize;
 	if (unlikely(total_size > vy_max_tuple_size)) {
 		diag_set(ClientError, ER_VINYL_MAX_TUPLE_SIZE,
@@ -103,7 +104,7 @@ vy_stmt_alloc(struct tuple_format *format, uint32_t bsize)
 		return NULL;
 	}
 	say_debug("vy_stmt_alloc(format = %d %u, bsize = %zu) = %p",
-		format->id, tuple_format_meta_size(format), bsize, tuple);
+		format->id, meta_size, bsize, tuple);
 	tuple->refs = 1;
 	tuple->format_id = tuple_format_id(format);
 	if (cord_is_main())
@@ -186,7 +187,7 @@ vy_stmt_new_select(struct tuple_format *format, const char *key,
 {
 	assert(part_count == 0 || key != NULL);
 	/* Key don't have field map */
-	assert(format->field_map_size == 0);
+	assert(format->field_map_count == 0);
 
 	/* Calculate key length */
 	const char *key_end = key;
@@ -266,7 +267,8 @@ vy_stmt_new_with_ops(struct tuple_format *format, const char *tuple_begin,
 	vy_stmt_set_type(stmt, type);
 
 	/* Calculate offsets for key parts */
-	if (tuple_init_field_map(format, (uint32_t *) raw, raw)) {
+	if (tuple_init_field_map(format, raw, field_map_slot_size(bsize),
+				 raw)) {
 		tuple_unref(stmt);
 		return NULL;
 	}
@@ -312,10 +314,26 @@ vy_stmt_replace_from_upsert(const struct tuple *upsert)
 	struct tuple *replace = vy_stmt_alloc(format, bsize);
 	if (replace == NULL)
 		return NULL;
-	/* Copy both data and field_map. */
-	char *dst = (char *)replace + sizeof(struct vy_stmt);
-	char *src = (char *)upsert + sizeof(struct vy_stmt);
-	memcpy(dst, src, format->field_map_size + bsize);
+	char *dst = (char *)tuple_data(replace);
+	const char *src = tuple_data(upsert);
+	memcpy(dst, src, bsize);
+	memcpy((char *)tuple_extra(replace), tuple_extra(upsert),
+	       format->extra_size);
+	/*
+	 * The statement is shorter than the upsert, so it may
+	 * need a narrower field map.
+	 */
+	uint32_t slot_size = field_map_slot_size(bsize);
+	if (slot_size == field_map_slot_size(upsert->bsize)) {
+		/* Copy the field map as is. */
+		size_t field_map_size = tuple_format_field_map_size(format,
+								    bsize);
+		memcpy(dst - field_map_size, src - field_map_size,
+		       field_map_size);
+	} else if (tuple_init_field_map(format, dst, slot_size, dst) != 0) {
+		tuple_unref(replace);
+		return NULL;
+	}
 	vy_stmt_set_type(replace, IPROTO_REPLACE);
 	vy_stmt_set_lsn(replace, vy_stmt_lsn(upsert));
 	return replace;
@@ -359,12 +377,14 @@ vy_stmt_new_surrogate_from_key(const char *key, enum iproto_type type,
 		return NULL;
 
 	char *raw = (char *) tuple_data(stmt);
-	uint32_t *field_map = (uint32_t *) raw;
+	uint32_t slot_size = field_map_slot_size(bsize);
 	char *wpos = mp_encode_array(raw, field_count);
 	for (uint32_t i = 0; i < field_count; ++i) {
 		const struct tuple_field *field = &format->fields[i];
-		if (field->offset_slot != TUPLE_OFFSET_SLOT_NIL)
-			field_map[field->offset_slot] = wpos - raw;
+		if (field->offset_slot != TUPLE_OFFSET_SLOT_NIL) {
+			field_map_set_offset(raw, slot_size,
+					     field->offset_slot, wpos - raw);
+		}
 		if (iov[i].iov_base == NULL) {
 			wpos = mp_encode_nil(wpos);
 		} else {
@@ -392,14 +412,19 @@ vy_stmt_new_surrogate_delete(struct tuple_format *format,
 {
 	uint32_t src_size;
 	const char *src_data = tuple_data_range(src, &src_size);
-	uint32_t total_size = src_size + format->field_map_size;
+	/*
+	 * The size of the surrogate tuple is unknown until it is
+	 * built, so collect offsets in 4-byte slots and convert
+	 * them to the tuple slot size after that.
+	 */
+	uint32_t field_map_size = format->field_map_count * sizeof(uint32_t);
+	uint32_t total_size = src_size + field_map_size;
 	/* Surrogate tuple uses less memory than the original tuple */
 	char *data = region_alloc(&fiber()->gc, total_size);
 	if (data == NULL) {
 		diag_set(OutOfMemory, src_size, "region", "tuple");
 		return NULL;
 	}
-	char *field_map_begin = data + src_size;
 	uint32_t *field_map = (uint32_t *) (data + total_size);
 
 	const char *src_pos = src_data;
@@ -412,8 +437,7 @@ vy_stmt_new_surrogate_delete(struct tuple_format *format,
 		 * Nullify field map to be able to detect by 0,
 		 * which key fields are absent in tuple_field().
 		 */
-		memset((char *)field_map - format->field_map_size, 0,
-		       format->field_map_size);
+		memset((char *)field_map - field_map_size, 0, field_map_size);
 	} else {
 		field_count = format->index_field_count;
 	}
@@ -441,9 +465,13 @@ vy_stmt_new_surrogate_delete(struct tuple_format *format,
 	if (stmt == NULL)
 		return NULL;
 	char *stmt_data = (char *) tuple_data(stmt);
-	char *stmt_field_map_begin = stmt_data - format->field_map_size;
 	memcpy(stmt_data, data, bsize);
-	memcpy(stmt_field_map_begin, field_map_begin, format->field_map_size);
+	uint32_t slot_size = field_map_slot_size(bsize);
+	int32_t slot_count = format->field_map_count;
+	for (int32_t slot = -slot_count; slot < 0; slot++) {
+		field_map_set_offset(stmt_data, slot_size, slot,
+				     field_map[slot]);
+	}
 	vy_stmt_set_type(stmt, IPROTO_DELETE);
 
 	return stmt;
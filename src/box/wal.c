@@ -34,6 +34,8 @@
 #include "fiber.h"
 #include "fio.h"
 #include "errinj.h"
+#include "error.h"
+#include "tt_pthread.h"
 
 #include "xlog.h"
 #include "xrow.h"
@@ -53,6 +55,90 @@ wal_write(struct journal *, struct journal_entry *);
 static int64_t
 wal_write_in_wal_mode_none(struct journal *, struct journal_entry *);
 
+enum {
+	/** Size of a WAL ring chunk, unless a row is bigger. */
+	WAL_RING_CHUNK_SIZE = 256 * 1024,
+};
+
+/**
+ * A chunk of memory storing rows of the WAL ring. Relays send
+ * rows right from the chunk, so it is reference counted and
+ * outlives the ring if a relay is still writing it.
+ */
+struct wal_ring_chunk {
+	/** Link in wal_ring::chunks. */
+	struct stailq_entry in_ring;
+	/**
+	 * Number of references, including the one of the ring.
+	 * Protected by wal_ring::mutex.
+	 */
+	int refs;
+	/** Ring position of the first row of the chunk. */
+	uint64_t pos;
+	/** Size of rows stored in the chunk. */
+	size_t used;
+	/** Size of the chunk data. */
+	size_t size;
+	/** Rows, see struct wal_ring_rec. */
+	char data[0];
+};
+
+/**
+ * In-memory ring of rows recently written to WAL. Relays stream
+ * rows from the ring instead of re-reading and decoding xlog
+ * files, falling back on files only when a replica falls behind
+ * the ring. Rows are encoded by the WAL thread once, as they are
+ * sent to replicas, and every relay writes them to its socket
+ * right from the ring memory. Rows are appended to the ring as
+ * soon as they are written to disk.
+ *
+ * Rows are appended only while there are relays reading the
+ * ring, so an instance without replicas doesn't pay for copying
+ * them. Chunks are allocated on demand and are freed once the
+ * last reader is gone.
+ *
+ * Positions in the ring are byte offsets which only grow. Rows
+ * are stored in a list of chunks, each chunk starting at the
+ * position the previous one ends at.
+ */
+struct wal_ring {
+	/** Protects chunks, begin, end, vclock and chunk refs. */
+	pthread_mutex_t mutex;
+	/** Chunks ordered by position. */
+	struct stailq chunks;
+	/** Total size of the chunks. */
+	size_t size;
+	/**
+	 * Max total size of the chunks, 0 if the ring is disabled.
+	 * Protected by mutex.
+	 */
+	size_t max_size;
+	/** Number of relays reading the ring. Protected by mutex. */
+	int readers;
+	/**
+	 * Set if rows of the current WAL write are appended to
+	 * the ring, see wal_ring_begin().
+	 */
+	bool is_active;
+	/** Position of the oldest row. */
+	uint64_t begin;
+	/** Position following the newest row written to disk. */
+	uint64_t end;
+	/**
+	 * Position following the newest row appended to the
+	 * ring. Rows between end and wpos are not visible to
+	 * relays until they are written to disk.
+	 */
+	uint64_t wpos;
+	/** WAL vclock before the oldest row. */
+	struct vclock vclock;
+	/**
+	 * Set if a row could not be appended to the ring. The
+	 * ring is emptied when the WAL write is over.
+	 */
+	bool is_broken;
+};
+
 /* WAL thread. */
 struct wal_thread {
 	/** 'wal' thread doing the writes. */
@@ -117,6 +203,8 @@ struct wal_writer
 	 * Used for replication relays.
 	 */
 	struct rlist watchers;
+	/** Rows recently written to WAL. */
+	struct wal_ring ring;
 };
 
 struct wal_msg {
@@ -255,6 +343,338 @@ tx_schedule_rollback(struct cmsg *msg)
 	stailq_create(&writer->rollback);
 }
 
+/* {{{ WAL ring */
+
+static void
+wal_ring_create(struct wal_ring *ring, size_t max_size,
+		const struct vclock *vclock)
+{
+	memset(ring, 0, sizeof(*ring));
+	tt_pthread_mutex_init(&ring->mutex, NULL);
+	stailq_create(&ring->chunks);
+	ring->max_size = max_size;
+	vclock_copy(&ring->vclock, vclock);
+}
+
+/** Drop a reference to a chunk, must be called under the mutex. */
+static inline bool
+wal_ring_chunk_unref_locked(struct wal_ring_chunk *chunk)
+{
+	assert(chunk->refs > 0);
+	return --chunk->refs == 0;
+}
+
+/**
+ * Remove all chunks from the ring. The ring starts past any
+ * position a relay may have, so that relays don't take the ring
+ * for having all rows following their position and read the rows
+ * written meanwhile from xlog files.
+ */
+static void
+wal_ring_clear(struct wal_ring *ring)
+{
+	struct stailq garbage;
+	stailq_create(&garbage);
+	tt_pthread_mutex_lock(&ring->mutex);
+	struct wal_ring_chunk *chunk, *next;
+	stailq_foreach_entry_safe(chunk, next, &ring->chunks, in_ring) {
+		if (wal_ring_chunk_unref_locked(chunk))
+			stailq_add_tail_entry(&garbage, chunk, in_ring);
+	}
+	stailq_create(&ring->chunks);
+	ring->begin = ring->end = ++ring->wpos;
+	tt_pthread_mutex_unlock(&ring->mutex);
+	ring->size = 0;
+	stailq_foreach_entry_safe(chunk, next, &garbage, in_ring)
+		free(chunk);
+}
+
+static void
+wal_ring_destroy(struct wal_ring *ring)
+{
+	wal_ring_clear(ring);
+	tt_pthread_mutex_destroy(&ring->mutex);
+}
+
+/**
+ * Drop the oldest chunk from the ring.
+ *
+ * @retval 0 success
+ * @retval -1 the chunk has rows not written to disk yet
+ */
+static int
+wal_ring_evict(struct wal_ring *ring)
+{
+	struct wal_ring_chunk *chunk =
+		stailq_first_entry(&ring->chunks, struct wal_ring_chunk,
+				   in_ring);
+	uint64_t chunk_end = chunk->pos + chunk->used;
+	if (chunk_end > ring->end)
+		return -1;
+	tt_pthread_mutex_lock(&ring->mutex);
+	const char *data = chunk->data;
+	while (data < chunk->data + chunk->used) {
+		const struct wal_ring_rec *rec =
+			(const struct wal_ring_rec *)data;
+		vclock_follow(&ring->vclock, rec->replica_id, rec->lsn);
+		data += wal_ring_rec_size(rec);
+	}
+	stailq_shift(&ring->chunks);
+	ring->begin = chunk_end;
+	/*
+	 * Once the ring reference is dropped, a relay may free
+	 * the chunk, so don't touch it after unlocking.
+	 */
+	ring->size -= chunk->size;
+	bool is_garbage = wal_ring_chunk_unref_locked(chunk);
+	tt_pthread_mutex_unlock(&ring->mutex);
+	if (is_garbage)
+		free(chunk);
+	return 0;
+}
+
+/**
+ * Check if rows of a WAL write are to be appended to the ring.
+ * Called once per write, so as not to take the mutex per row.
+ */
+static void
+wal_ring_begin(struct wal_ring *ring)
+{
+	tt_pthread_mutex_lock(&ring->mutex);
+	ring->is_active = ring->max_size > 0 && ring->readers > 0;
+	tt_pthread_mutex_unlock(&ring->mutex);
+}
+
+/**
+ * Append a row to the ring. The row isn't visible to relays
+ * until wal_ring_commit() is called.
+ */
+static void
+wal_ring_append(struct wal_ring *ring, struct xrow_header *row)
+{
+	if (!ring->is_active || ring->is_broken)
+		return;
+	ERROR_INJECT(ERRINJ_WAL_RING_APPEND, {
+		diag_set(ClientError, ER_INJECTION, "WAL ring append");
+		goto fail;
+	});
+	/* Replicas don't need the sync of the original request. */
+	struct xrow_header copy = *row;
+	copy.sync = 0;
+	struct iovec iov[XROW_IOVMAX];
+	int iovcnt = xrow_to_iovec(&copy, iov);
+	if (iovcnt < 0)
+		goto fail;
+	struct wal_ring_rec rec;
+	rec.len = 0;
+	for (int i = 0; i < iovcnt; i++)
+		rec.len += iov[i].iov_len;
+	rec.replica_id = row->replica_id;
+	rec.lsn = row->lsn;
+
+	size_t size = wal_ring_rec_size(&rec);
+	struct wal_ring_chunk *chunk = NULL;
+	if (!stailq_empty(&ring->chunks)) {
+		chunk = stailq_last_entry(&ring->chunks,
+					  struct wal_ring_chunk, in_ring);
+	}
+	if (chunk == NULL || chunk->size - chunk->used < size) {
+		size_t chunk_size = MAX((size_t)WAL_RING_CHUNK_SIZE, size);
+		while (ring->size + chunk_size > ring->max_size &&
+		       !stailq_empty(&ring->chunks)) {
+			if (wal_ring_evict(ring) != 0)
+				goto fail;
+		}
+		chunk = (struct wal_ring_chunk *)
+			malloc(sizeof(*chunk) + chunk_size);
+		if (chunk == NULL) {
+			diag_set(OutOfMemory, sizeof(*chunk) + chunk_size,
+				 "malloc", "struct wal_ring_chunk");
+			goto fail;
+		}
+		chunk->refs = 1;
+		chunk->pos = ring->wpos;
+		chunk->used = 0;
+		chunk->size = chunk_size;
+		tt_pthread_mutex_lock(&ring->mutex);
+		stailq_add_tail_entry(&ring->chunks, chunk, in_ring);
+		tt_pthread_mutex_unlock(&ring->mutex);
+		ring->size += chunk_size;
+	}
+	char *data = chunk->data + chunk->used;
+	memcpy(data, &rec, sizeof(rec));
+	data += sizeof(rec);
+	for (int i = 0; i < iovcnt; i++) {
+		memcpy(data, iov[i].iov_base, iov[i].iov_len);
+		data += iov[i].iov_len;
+	}
+	chunk->used += size;
+	ring->wpos += size;
+	return;
+fail:
+	diag_clear(diag_get());
+	ring->is_broken = true;
+}
+
+/**
+ * Drop all rows from the ring. @a vclock is the WAL vclock
+ * after the last row appended to the ring.
+ */
+static void
+wal_ring_reset(struct wal_ring *ring, const struct vclock *vclock)
+{
+	wal_ring_clear(ring);
+	tt_pthread_mutex_lock(&ring->mutex);
+	vclock_copy(&ring->vclock, vclock);
+	tt_pthread_mutex_unlock(&ring->mutex);
+	ring->is_broken = false;
+}
+
+/**
+ * Make rows appended to the ring visible to relays once they
+ * have been written to disk.
+ */
+static void
+wal_ring_commit(struct wal_ring *ring, const struct vclock *vclock)
+{
+	/*
+	 * An inactive ring is kept empty and following the WAL
+	 * vclock, so that a relay which has just attached to it
+	 * reads the rows it missed from xlog files.
+	 */
+	if (ring->is_broken || !ring->is_active)
+		return wal_ring_reset(ring, vclock);
+	tt_pthread_mutex_lock(&ring->mutex);
+	ring->end = ring->wpos;
+	tt_pthread_mutex_unlock(&ring->mutex);
+}
+
+int
+wal_ring_get(uint64_t *pos, const struct vclock *vclock,
+	     struct wal_ring_chunk **chunk,
+	     const char **data, const char **data_end)
+{
+	struct wal_ring *ring = &wal_writer_singleton.ring;
+	int rc = 0;
+	*chunk = NULL;
+	tt_pthread_mutex_lock(&ring->mutex);
+	if (*pos == WAL_RING_POS_NONE) {
+		/*
+		 * The ring has all rows following the vclock
+		 * only if it starts before it.
+		 */
+		if (ring->max_size == 0 ||
+		    vclock_compare(&ring->vclock, vclock) > 0) {
+			rc = 1;
+			goto out;
+		}
+		*pos = ring->begin;
+	} else if (*pos < ring->begin) {
+		/* The reader fell behind. */
+		rc = 1;
+		goto out;
+	}
+	struct wal_ring_chunk *curr;
+	stailq_foreach_entry(curr, &ring->chunks, in_ring) {
+		if (*pos >= ring->end)
+			break;
+		/*
+		 * Rows following the end position may be being
+		 * appended, so the chunk size can't be used.
+		 */
+		struct stailq_entry *next = stailq_next(&curr->in_ring);
+		uint64_t curr_end = next == NULL ? ring->end :
+			stailq_entry(next, struct wal_ring_chunk,
+				     in_ring)->pos;
+		curr_end = MIN(curr_end, ring->end);
+		if (*pos >= curr_end)
+			continue;
+		assert(*pos >= curr->pos);
+		curr->refs++;
+		*chunk = curr;
+		*data = curr->data + (*pos - curr->pos);
+		*data_end = curr->data + (curr_end - curr->pos);
+		*pos = curr_end;
+		break;
+	}
+out:
+	tt_pthread_mutex_unlock(&ring->mutex);
+	return rc;
+}
+
+void
+wal_ring_chunk_unref(struct wal_ring_chunk *chunk)
+{
+	struct wal_ring *ring = &wal_writer_singleton.ring;
+	tt_pthread_mutex_lock(&ring->mutex);
+	bool is_garbage = wal_ring_chunk_unref_locked(chunk);
+	tt_pthread_mutex_unlock(&ring->mutex);
+	if (is_garbage)
+		free(chunk);
+}
+
+void
+wal_ring_attach(void)
+{
+	struct wal_ring *ring = &wal_writer_singleton.ring;
+	tt_pthread_mutex_lock(&ring->mutex);
+	ring->readers++;
+	tt_pthread_mutex_unlock(&ring->mutex);
+}
+
+void
+wal_ring_detach(void)
+{
+	struct wal_ring *ring = &wal_writer_singleton.ring;
+	tt_pthread_mutex_lock(&ring->mutex);
+	assert(ring->readers > 0);
+	ring->readers--;
+	tt_pthread_mutex_unlock(&ring->mutex);
+}
+
+struct wal_ring_size_msg {
+	struct cbus_call_msg base;
+	size_t size;
+};
+
+static int
+wal_set_ring_size_f(struct cbus_call_msg *data)
+{
+	struct wal_writer *writer = &wal_writer_singleton;
+	struct wal_ring *ring = &writer->ring;
+	size_t size = ((struct wal_ring_size_msg *)data)->size;
+	tt_pthread_mutex_lock(&ring->mutex);
+	ring->max_size = size;
+	tt_pthread_mutex_unlock(&ring->mutex);
+	/* All rows in the ring have been written by now. */
+	if (size == 0) {
+		wal_ring_reset(ring, &writer->vclock);
+		return 0;
+	}
+	while (ring->size > size && !stailq_empty(&ring->chunks)) {
+		int rc = wal_ring_evict(ring);
+		assert(rc == 0);
+		(void)rc;
+	}
+	return 0;
+}
+
+void
+wal_set_ring_size(size_t size)
+{
+	struct wal_writer *writer = &wal_writer_singleton;
+	if (writer->wal_mode == WAL_NONE)
+		return;
+	struct wal_ring_size_msg msg;
+	msg.size = size;
+	bool cancellable = fiber_set_cancellable(false);
+	cbus_call(&wal_thread.wal_pipe, &wal_thread.tx_pipe, &msg.base,
+		  wal_set_ring_size_f, NULL, TIMEOUT_INFINITY);
+	fiber_set_cancellable(cancellable);
+}
+
+/* }}} */
+
 /**
  * Initialize WAL writer context. Even though it's a singleton,
  * encapsulate the details just in case we may use
@@ -264,7 +684,7 @@ static void
 wal_writer_create(struct wal_writer *writer, enum wal_mode wal_mode,
 		  const char *wal_dirname, const struct tt_uuid *instance_uuid,
 		  struct vclock *vclock, int64_t wal_max_rows,
-		  int64_t wal_max_size)
+		  int64_t wal_max_size, size_t wal_ring_size)
 {
 	writer->wal_mode = wal_mode;
 	writer->wal_max_rows = wal_max_rows;
@@ -285,6 +705,8 @@ wal_writer_create(struct wal_writer *writer, enum wal_mode wal_mode,
 	vclock_copy(&writer->vclock, vclock);
 
 	rlist_create(&writer->watchers);
+	wal_ring_create(&writer->ring, wal_mode == WAL_NONE ? 0 :
+			wal_ring_size, vclock);
 }
 
 /** Destroy a WAL writer structure. */
@@ -292,6 +714,7 @@ static void
 wal_writer_destroy(struct wal_writer *writer)
 {
 	xdir_destroy(&writer->wal_dir);
+	wal_ring_destroy(&writer->ring);
 }
 
 /** WAL thread routine. */
@@ -320,14 +743,14 @@ wal_thread_start()
 int
 wal_init(enum wal_mode wal_mode, const char *wal_dirname,
 	 const struct tt_uuid *instance_uuid, struct vclock *vclock,
-	 int64_t wal_max_rows, int64_t wal_max_size)
+	 int64_t wal_max_rows, int64_t wal_max_size, size_t wal_ring_size)
 {
 	assert(wal_max_rows > 1);
 
 	struct wal_writer *writer = &wal_writer_singleton;
 
 	wal_writer_create(writer, wal_mode, wal_dirname, instance_uuid,
-			  vclock, wal_max_rows, wal_max_size);
+			  vclock, wal_max_rows, wal_max_size, wal_ring_size);
 
 	if (xdir_scan(&writer->wal_dir))
 		return -1;
@@ -570,20 +993,36 @@ wal_writer_begin_rollback(struct wal_writer *writer)
 	cpipe_push(&wal_thread.tx_pipe, &writer->in_rollback);
 }
 
+/**
+ * Assign LSN to all local rows of a transaction. Local rows
+ * get the LSN of the first of them as the transaction id, and
+ * the last of them is marked as the commit row, so that
+ * replicas apply them in one transaction. Rows received from
+ * other replicas keep the transaction ids assigned by their
+ * origin.
+ */
 static void
 wal_assign_lsn(struct wal_writer *writer, struct xrow_header **row,
 	       struct xrow_header **end)
 {
-	/** Assign LSN to all local rows. */
+	int64_t tsn = 0;
+	struct xrow_header *last = NULL;
 	for ( ; row < end; row++) {
 		if ((*row)->replica_id == 0) {
 			(*row)->lsn = vclock_inc(&writer->vclock, instance_id);
 			(*row)->replica_id = instance_id;
+			if (tsn == 0)
+				tsn = (*row)->lsn;
+			(*row)->tsn = tsn;
+			(*row)->is_commit = false;
+			last = *row;
 		} else {
 			vclock_follow(&writer->vclock, (*row)->replica_id,
 				      (*row)->lsn);
 		}
 	}
+	if (last != NULL)
+		last->is_commit = true;
 }
 
 static void
@@ -637,6 +1076,7 @@ wal_write_to_disk(struct cmsg *msg)
 	 */
 	struct journal_entry *entry;
 	struct stailq_entry *last_committed = NULL;
+	wal_ring_begin(&writer->ring);
 	stailq_foreach_entry(entry, &wal_msg->commit, fifo) {
 		wal_assign_lsn(writer, entry->rows, entry->rows + entry->n_rows);
 		entry->res = vclock_sum(&writer->vclock);
@@ -646,6 +1086,9 @@ wal_write_to_disk(struct cmsg *msg)
 		if (rc > 0)
 			last_committed = &entry->fifo;
 		/* rc == 0: the write is buffered in xlog_tx */
+		struct xrow_header **row = entry->rows;
+		for (; row < entry->rows + entry->n_rows; row++)
+			wal_ring_append(&writer->ring, *row);
 	}
 	if (xlog_flush(l) < 0)
 		goto done;
@@ -653,6 +1096,15 @@ wal_write_to_disk(struct cmsg *msg)
 	last_committed = stailq_last(&wal_msg->commit);
 
 done:
+	if (last_committed == stailq_last(&wal_msg->commit)) {
+		wal_ring_commit(&writer->ring, &writer->vclock);
+	} else {
+		/*
+		 * Some rows may have been written to disk,
+		 * don't bother finding out which.
+		 */
+		wal_ring_reset(&writer->ring, &writer->vclock);
+	}
 	error = diag_last_error(diag_get());
 	if (error) {
 		/* Until we can pass the error to tx, log it and clear. */
@@ -687,11 +1139,12 @@ wal_thread_f(va_list ap)
 {
 	(void) ap;
 
-	/** Initialize eio in this thread */
+	/** Initialize coio in this thread */
 	coio_enable();
 
 	struct cbus_endpoint endpoint;
 	cbus_endpoint_create(&endpoint, "wal", fiber_schedule_cb, fiber());
+	cbus_endpoint_set_spin(&endpoint, CBUS_SPIN_TIMEOUT);
 	/*
 	 * Create a pipe to TX thread. Use a high priority
 	 * endpoint, to ensure that WAL messages are delivered
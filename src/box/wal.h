@@ -58,7 +58,7 @@ wal_thread_start();
 int
 wal_init(enum wal_mode wal_mode, const char *wal_dirname,
 	 const struct tt_uuid *instance_uuid, struct vclock *vclock,
-	 int64_t wal_max_rows, int64_t wal_max_size);
+	 int64_t wal_max_rows, int64_t wal_max_size, size_t wal_ring_size);
 
 void
 wal_thread_stop();
@@ -138,6 +138,83 @@ void
 wal_clear_watcher(struct wal_watcher *watcher,
 		  void (*process_cb)(struct cbus_endpoint *));
 
+/** Position of a reader in the WAL ring, see wal_ring_get(). */
+#define WAL_RING_POS_NONE UINT64_MAX
+
+struct wal_ring_chunk;
+
+/**
+ * A row stored in the WAL ring. The header is followed by the
+ * row encoded as it is sent to replicas: prefixed with its
+ * length (MP_UINT32) and with no sync.
+ */
+struct wal_ring_rec {
+	/** Size of the encoded row, not counting alignment. */
+	uint32_t len;
+	/** Replica id of the row. */
+	uint32_t replica_id;
+	/** LSN of the row. */
+	int64_t lsn;
+};
+
+/** Size of a WAL ring row, including the header. */
+static inline size_t
+wal_ring_rec_size(const struct wal_ring_rec *rec)
+{
+	/* Keep headers aligned. */
+	size_t align = sizeof(int64_t) - 1;
+	return sizeof(*rec) + ((rec->len + align) & ~align);
+}
+
+/**
+ * Get rows written to WAL from the in-memory ring kept by the
+ * WAL thread. Rows are not copied: the chunk storing them is
+ * referenced and must be released with wal_ring_chunk_unref().
+ *
+ * @param[inout] pos  Position to read from. Set it to
+ *                    WAL_RING_POS_NONE to start reading from
+ *                    the oldest row which may follow @a vclock.
+ *                    Advanced past the returned rows.
+ * @param vclock      Vclock of the reader, used only if @a pos
+ *                    is WAL_RING_POS_NONE. The reader is supposed
+ *                    to skip rows it has already seen.
+ * @param[out] chunk  Referenced chunk or NULL if there are no
+ *                    new rows.
+ * @param[out] data   Rows, see struct wal_ring_rec.
+ * @param[out] data_end End of the rows.
+ *
+ * @retval 0 success
+ * @retval 1 the ring doesn't have all rows following the reader
+ *           position, the reader has to read them from xlog files
+ */
+int
+wal_ring_get(uint64_t *pos, const struct vclock *vclock,
+	     struct wal_ring_chunk **chunk,
+	     const char **data, const char **data_end);
+
+/** Release a chunk returned by wal_ring_get(). */
+void
+wal_ring_chunk_unref(struct wal_ring_chunk *chunk);
+
+/**
+ * Register a reader of the WAL ring. Rows are appended to the
+ * ring only while it has readers, starting from the next WAL
+ * write.
+ */
+void
+wal_ring_attach(void);
+
+/** Unregister a reader registered with wal_ring_attach(). */
+void
+wal_ring_detach(void);
+
+/**
+ * Set the max size of memory used by the WAL ring, 0 disables
+ * the ring.
+ */
+void
+wal_set_ring_size(size_t size);
+
 void
 wal_atfork();
 
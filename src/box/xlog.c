@@ -37,10 +37,10 @@
 #include "exception.h"
 #include "crc32.h"
 #include "fio.h"
-#include "third_party/tarantool_eio.h"
 #include <msgpuck.h>
 
 #include "coio_file.h"
+#include "coio_task.h"
 
 #include "error.h"
 #include "xrow.h"
@@ -1234,17 +1234,29 @@ xlog_flush(struct xlog *log)
 	return xlog_tx_write(log);
 }
 
+struct xlog_sync_task {
+	struct coio_task base;
+	/** A duplicate of the xlog descriptor, closed when done. */
+	int fd;
+};
+
 static int
-sync_cb(eio_req *req)
+xlog_sync_cb(struct coio_task *ptr)
 {
-	int fd = (intptr_t) req->data;
-	if (req->result) {
-		errno = req->errorno;
+	struct xlog_sync_task *task = (struct xlog_sync_task *) ptr;
+	if (fsync(task->fd) < 0) {
 		say_syserror("%s: fsync() failed",
-			     fio_filename(fd));
-		errno = 0;
+			     fio_filename(task->fd));
 	}
-	close(fd);
+	close(task->fd);
+	return 0;
+}
+
+static int
+xlog_sync_free_cb(struct coio_task *ptr)
+{
+	coio_task_destroy(ptr);
+	free(ptr);
 	return 0;
 }
 
@@ -1252,12 +1264,22 @@ int
 xlog_sync(struct xlog *l)
 {
 	if (l->sync_is_async) {
-		int fd = dup(l->fd);
-		if (fd == -1) {
+		struct xlog_sync_task *task =
+			(struct xlog_sync_task *) malloc(sizeof(*task));
+		if (task == NULL) {
+			say_error("%s: failed to allocate fsync task",
+				  l->filename);
+			return -1;
+		}
+		task->fd = dup(l->fd);
+		if (task->fd == -1) {
 			say_syserror("%s: dup() failed", l->filename);
+			free(task);
 			return -1;
 		}
-		eio_fsync(fd, 0, sync_cb, (void *) (intptr_t) fd);
+		coio_task_create(&task->base, xlog_sync_cb, xlog_sync_free_cb);
+		task->base.cls = COIO_BULK;
+		coio_task_post(&task->base, 0);
 	} else if (fsync(l->fd) < 0) {
 		say_syserror("%s: fsync failed", l->filename);
 		return -1;
@@ -62,6 +62,8 @@ error:
 	if (mp_typeof(**pos) != MP_MAP)
 		goto error;
 
+	bool has_tsn = false;
+	uint64_t flags = 0;
 	uint32_t size = mp_decode_map(pos);
 	for (uint32_t i = 0; i < size; i++) {
 		if (mp_typeof(**pos) != MP_UINT)
@@ -89,11 +91,30 @@ error:
 		case IPROTO_SCHEMA_VERSION:
 			header->schema_version = mp_decode_uint(pos);
 			break;
+		case IPROTO_STREAM_ID:
+			header->stream_id = mp_decode_uint(pos);
+			break;
+		case IPROTO_TSN:
+			has_tsn = true;
+			header->tsn = mp_decode_uint(pos);
+			break;
+		case IPROTO_FLAGS:
+			flags = mp_decode_uint(pos);
+			break;
 		default:
 			/* unknown header */
 			mp_next(pos);
 		}
 	}
+	if (has_tsn) {
+		/* TSN is encoded as the distance from LSN. */
+		header->tsn = header->lsn - header->tsn;
+		header->is_commit = (flags & IPROTO_FLAG_COMMIT) != 0;
+	} else {
+		/* A single-row transaction. */
+		header->tsn = header->lsn;
+		header->is_commit = true;
+	}
 	assert(*pos <= end);
 	if (*pos < end) {
 		const char *body = *pos;
@@ -172,6 +193,22 @@ xrow_header_encode(const struct xrow_header *header, uint64_t sync,
 		d = mp_encode_double(d, header->tm);
 		map_size++;
 	}
+
+	/*
+	 * Rows of single-row transactions, which are the vast
+	 * majority, carry no transaction id, see the decoder.
+	 */
+	if (header->tsn != 0 &&
+	    (header->tsn != header->lsn || !header->is_commit)) {
+		d = mp_encode_uint(d, IPROTO_TSN);
+		d = mp_encode_uint(d, header->lsn - header->tsn);
+		map_size++;
+		if (header->is_commit) {
+			d = mp_encode_uint(d, IPROTO_FLAGS);
+			d = mp_encode_uint(d, IPROTO_FLAG_COMMIT);
+			map_size++;
+		}
+	}
 	assert(d <= data + XROW_HEADER_LEN_MAX);
 	mp_encode_map(data, map_size);
 	out->iov_len = d - (char *) out->iov_base;
@@ -267,6 +304,27 @@ iproto_reply_ok(struct obuf *out, uint64_t sync, uint32_t schema_version)
 	return 0;
 }
 
+int
+iproto_reply_cursor(struct obuf *out, uint64_t sync,
+		    uint32_t schema_version, uint64_t cursor_id)
+{
+	size_t size = IPROTO_HEADER_LEN + mp_sizeof_map(1) +
+		mp_sizeof_uint(IPROTO_CURSOR_ID) + mp_sizeof_uint(cursor_id);
+	char *buf = (char *)obuf_alloc(out, size);
+	if (buf == NULL) {
+		diag_set(OutOfMemory, size, "obuf_alloc", "buf");
+		return -1;
+	}
+	iproto_header_encode(buf, IPROTO_OK, sync, schema_version,
+			     size - IPROTO_HEADER_LEN);
+	char *data = buf + IPROTO_HEADER_LEN;
+	data = mp_encode_map(data, 1);
+	data = mp_encode_uint(data, IPROTO_CURSOR_ID);
+	data = mp_encode_uint(data, cursor_id);
+	assert(data == buf + size);
+	return 0;
+}
+
 int
 iproto_reply_request_vote(struct obuf *out, uint64_t sync,
 			  uint32_t schema_version, const struct vclock *vclock,
@@ -467,9 +525,12 @@ error:
 	request->header = row;
 	request->type = row->type;
 
+	/* Only SELECT takes a filter, other requests ignore it. */
+	bool is_select = row->type == IPROTO_SELECT;
 	uint32_t size = mp_decode_map(&data);
 	for (uint32_t i = 0; i < size; i++) {
-		if (! iproto_dml_body_has_key(data, end)) {
+		if (is_select ? ! iproto_select_body_has_key(data, end) :
+		    ! iproto_dml_body_has_key(data, end)) {
 			if (mp_check(&data, end) != 0 ||
 			    mp_check(&data, end) != 0)
 				goto error;
@@ -513,6 +574,10 @@ error:
 			request->ops = value;
 			request->ops_end = data;
 			break;
+		case IPROTO_FILTER:
+			request->filter = value;
+			request->filter_end = data;
+			break;
 		default:
 			break;
 		}
@@ -715,6 +780,71 @@ error:
 	return 0;
 }
 
+int
+xrow_decode_cursor(const struct xrow_header *row,
+		   struct cursor_request *request)
+{
+	if (row->bodycnt == 0) {
+		diag_set(ClientError, ER_INVALID_MSGPACK,
+			 "missing request body");
+		return -1;
+	}
+
+	assert(row->bodycnt == 1);
+	const char *data = (const char *) row->body[0].iov_base;
+	const char *end = data + row->body[0].iov_len;
+	assert((end - data) > 0);
+
+	if (mp_typeof(*data) != MP_MAP || mp_check_map(data, end) > 0) {
+error:
+		diag_set(ClientError, ER_INVALID_MSGPACK, "packet body");
+		return -1;
+	}
+
+	memset(request, 0, sizeof(*request));
+	uint64_t key_map = iproto_key_bit(IPROTO_CURSOR_ID);
+	if (row->type == IPROTO_CURSOR_FETCH)
+		key_map |= iproto_key_bit(IPROTO_LIMIT);
+
+	uint32_t map_size = mp_decode_map(&data);
+	for (uint32_t i = 0; i < map_size; ++i) {
+		if ((end - data) < 1 || mp_typeof(*data) != MP_UINT)
+			goto error;
+
+		uint64_t key = mp_decode_uint(&data);
+		const char *value = data;
+		if (mp_check(&data, end) != 0)
+			goto error;
+
+		switch (key) {
+		case IPROTO_CURSOR_ID:
+			if (mp_typeof(*value) != MP_UINT)
+				goto error;
+			request->cursor_id = mp_decode_uint(&value);
+			break;
+		case IPROTO_LIMIT:
+			if (mp_typeof(*value) != MP_UINT)
+				goto error;
+			request->limit = mp_decode_uint(&value);
+			break;
+		default:
+			continue; /* unknown key */
+		}
+		key_map &= ~iproto_key_bit(key);
+	}
+	if (data != end) {
+		diag_set(ClientError, ER_INVALID_MSGPACK, "packet end");
+		return -1;
+	}
+	if (key_map != 0) {
+		enum iproto_key key = (enum iproto_key) bit_ctz_u64(key_map);
+		diag_set(ClientError, ER_MISSING_REQUEST_FIELD,
+			 iproto_key_name(key));
+		return -1;
+	}
+	return 0;
+}
+
 int
 xrow_decode_auth(const struct xrow_header *row, struct auth_request *request)
 {
@@ -864,6 +994,13 @@ xrow_encode_request_vote(struct xrow_header *row)
 	row->type = IPROTO_REQUEST_VOTE;
 }
 
+void
+xrow_encode_compress(struct xrow_header *row)
+{
+	memset(row, 0, sizeof(*row));
+	row->type = IPROTO_COMPRESS;
+}
+
 int
 xrow_encode_subscribe(struct xrow_header *row,
 		      const struct tt_uuid *replicaset_uuid,
@@ -1005,63 +1142,217 @@ xrow_decode_subscribe(struct xrow_header *row, struct tt_uuid *replicaset_uuid,
 	return 0;
 }
 
-int
-xrow_encode_join(struct xrow_header *row, const struct tt_uuid *instance_uuid)
+/**
+ * Encode a JOIN, JOIN_STREAM or a response to them. Keys with
+ * NULL, zero or false values are omitted, so is
+ * IPROTO_JOIN_STREAM_COUNT equal to 1.
+ */
+static int
+xrow_encode_join_body(struct xrow_header *row, uint32_t type,
+		      const struct tt_uuid *instance_uuid,
+		      const struct vclock *vclock,
+		      uint32_t stream_id, uint32_t stream_count,
+		      bool join_files)
 {
 	memset(row, 0, sizeof(*row));
 
-	size_t size = 64;
+	uint32_t replicaset_size = vclock != NULL ? vclock_size(vclock) : 0;
+	size_t size = 64 + replicaset_size *
+		(mp_sizeof_uint(UINT32_MAX) + mp_sizeof_uint(UINT64_MAX));
 	char *buf = (char *) region_alloc(&fiber()->gc, size);
 	if (buf == NULL) {
 		diag_set(OutOfMemory, size, "region_alloc", "buf");
 		return -1;
 	}
+	uint32_t map_size = (instance_uuid != NULL) + (vclock != NULL) +
+			    (stream_id != 0) + (stream_count > 1) +
+			    join_files;
 	char *data = buf;
-	data = mp_encode_map(data, 1);
-	data = mp_encode_uint(data, IPROTO_INSTANCE_UUID);
-	/* Greet the remote replica with our replica UUID */
-	data = xrow_encode_uuid(data, instance_uuid);
+	data = mp_encode_map(data, map_size);
+	if (instance_uuid != NULL) {
+		data = mp_encode_uint(data, IPROTO_INSTANCE_UUID);
+		/* Greet the remote replica with our replica UUID */
+		data = xrow_encode_uuid(data, instance_uuid);
+	}
+	if (vclock != NULL) {
+		data = mp_encode_uint(data, IPROTO_VCLOCK);
+		data = mp_encode_map(data, replicaset_size);
+		struct vclock_iterator it;
+		vclock_iterator_init(&it, vclock);
+		vclock_foreach(&it, replica) {
+			data = mp_encode_uint(data, replica.id);
+			data = mp_encode_uint(data, replica.lsn);
+		}
+	}
+	if (stream_id != 0) {
+		data = mp_encode_uint(data, IPROTO_JOIN_STREAM_ID);
+		data = mp_encode_uint(data, stream_id);
+	}
+	if (stream_count > 1) {
+		data = mp_encode_uint(data, IPROTO_JOIN_STREAM_COUNT);
+		data = mp_encode_uint(data, stream_count);
+	}
+	if (join_files) {
+		data = mp_encode_uint(data, IPROTO_JOIN_FILES);
+		data = mp_encode_bool(data, true);
+	}
 	assert(data <= buf + size);
 
 	row->body[0].iov_base = buf;
 	row->body[0].iov_len = (data - buf);
 	row->bodycnt = 1;
-	row->type = IPROTO_JOIN;
+	row->type = type;
+	return 0;
+}
+
+int
+xrow_encode_join(struct xrow_header *row, const struct tt_uuid *instance_uuid,
+		 uint32_t stream_count, bool join_files)
+{
+	return xrow_encode_join_body(row, IPROTO_JOIN, instance_uuid, NULL,
+				     0, stream_count, join_files);
+}
+
+int
+xrow_encode_join_response(struct xrow_header *row,
+			  const struct vclock *vclock, uint32_t stream_count,
+			  bool join_files)
+{
+	return xrow_encode_join_body(row, IPROTO_OK, NULL, vclock,
+				     0, stream_count, join_files);
+}
+
+int
+xrow_encode_join_stream(struct xrow_header *row,
+			const struct tt_uuid *instance_uuid,
+			const struct vclock *vclock,
+			uint32_t stream_id, uint32_t stream_count)
+{
+	return xrow_encode_join_body(row, IPROTO_JOIN_STREAM, instance_uuid,
+				     vclock, stream_id, stream_count, false);
+}
+
+int
+xrow_decode_join_stream(struct xrow_header *row, struct tt_uuid *instance_uuid,
+			struct vclock *vclock, uint32_t *stream_id,
+			uint32_t *stream_count, bool *join_files)
+{
+	if (xrow_decode_subscribe(row, NULL, instance_uuid, vclock,
+				  NULL, NULL) != 0)
+		return -1;
+	/* The body has been checked by xrow_decode_subscribe(). */
+	if (stream_id != NULL)
+		*stream_id = 0;
+	if (stream_count != NULL)
+		*stream_count = 1;
+	if (join_files != NULL)
+		*join_files = false;
+	const char *d = (const char *) row->body[0].iov_base;
+	uint32_t map_size = mp_decode_map(&d);
+	for (uint32_t i = 0; i < map_size; i++) {
+		if (mp_typeof(*d) != MP_UINT) {
+			mp_next(&d); /* key */
+			mp_next(&d); /* value */
+			continue;
+		}
+		uint64_t key = mp_decode_uint(&d);
+		if (key == IPROTO_JOIN_FILES && join_files != NULL) {
+			if (mp_typeof(*d) != MP_BOOL) {
+				diag_set(ClientError, ER_INVALID_MSGPACK,
+					 "invalid JOIN_FILES");
+				return -1;
+			}
+			*join_files = mp_decode_bool(&d);
+			continue;
+		}
+		uint32_t *value;
+		if (key == IPROTO_JOIN_STREAM_ID)
+			value = stream_id;
+		else if (key == IPROTO_JOIN_STREAM_COUNT)
+			value = stream_count;
+		else
+			value = NULL;
+		if (value == NULL) {
+			mp_next(&d);
+			continue;
+		}
+		if (mp_typeof(*d) != MP_UINT) {
+			diag_set(ClientError, ER_INVALID_MSGPACK,
+				 "invalid JOIN_STREAM");
+			return -1;
+		}
+		*value = mp_decode_uint(&d);
+	}
 	return 0;
 }
 
 int
 xrow_encode_vclock(struct xrow_header *row, const struct vclock *vclock)
 {
-	memset(row, 0, sizeof(*row));
+	return xrow_encode_join_body(row, IPROTO_OK, NULL, vclock,
+				     0, 0, false);
+}
 
-	/* Add vclock to response body */
-	uint32_t replicaset_size = vclock_size(vclock);
-	size_t size = 8 + replicaset_size *
-		(mp_sizeof_uint(UINT32_MAX) + mp_sizeof_uint(UINT64_MAX));
-	char *buf = (char *) region_alloc(&fiber()->gc, size);
+int
+xrow_encode_join_file(struct xrow_header *row, const char *data,
+		      uint32_t size)
+{
+	memset(row, 0, sizeof(*row));
+	size_t buf_size = mp_sizeof_map(1) + mp_sizeof_uint(IPROTO_DATA) +
+			  mp_sizeof_binl(size);
+	char *buf = (char *) region_alloc(&fiber()->gc, buf_size);
 	if (buf == NULL) {
-		diag_set(OutOfMemory, size, "region_alloc", "buf");
+		diag_set(OutOfMemory, buf_size, "region_alloc", "buf");
 		return -1;
 	}
-	char *data = buf;
-	data = mp_encode_map(data, 1);
-	data = mp_encode_uint(data, IPROTO_VCLOCK);
-	data = mp_encode_map(data, replicaset_size);
-	struct vclock_iterator it;
-	vclock_iterator_init(&it, vclock);
-	vclock_foreach(&it, replica) {
-		data = mp_encode_uint(data, replica.id);
-		data = mp_encode_uint(data, replica.lsn);
-	}
-	assert(data <= buf + size);
+	char *d = buf;
+	d = mp_encode_map(d, 1);
+	d = mp_encode_uint(d, IPROTO_DATA);
+	d = mp_encode_binl(d, size);
+	assert(d == buf + buf_size);
+	/* The chunk is sent as is, without copying. */
 	row->body[0].iov_base = buf;
-	row->body[0].iov_len = (data - buf);
-	row->bodycnt = 1;
-	row->type = IPROTO_OK;
+	row->body[0].iov_len = buf_size;
+	row->body[1].iov_base = (void *) data;
+	row->body[1].iov_len = size;
+	row->bodycnt = 2;
+	row->type = IPROTO_JOIN_FILE;
 	return 0;
 }
 
+int
+xrow_decode_join_file(struct xrow_header *row, const char **data,
+		      uint32_t *size)
+{
+	if (row->bodycnt == 0)
+		goto error;
+	assert(row->bodycnt == 1);
+	const char *d = (const char *) row->body[0].iov_base;
+	const char *end = d + row->body[0].iov_len;
+	const char *tmp = d;
+	if (mp_check(&tmp, end) != 0 || mp_typeof(*d) != MP_MAP)
+		goto error;
+	uint32_t map_size = mp_decode_map(&d);
+	for (uint32_t i = 0; i < map_size; i++) {
+		if (mp_typeof(*d) != MP_UINT) {
+			mp_next(&d); /* key */
+			mp_next(&d); /* value */
+			continue;
+		}
+		if (mp_decode_uint(&d) != IPROTO_DATA) {
+			mp_next(&d);
+			continue;
+		}
+		if (mp_typeof(*d) != MP_BIN)
+			goto error;
+		*data = mp_decode_bin(&d, size);
+		return 0;
+	}
+error:
+	diag_set(ClientError, ER_INVALID_MSGPACK, "invalid JOIN_FILE");
+	return -1;
+}
+
 void
 xrow_encode_timestamp(struct xrow_header *row, uint32_t replica_id, double tm)
 {
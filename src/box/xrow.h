@@ -47,7 +47,7 @@ enum {
 	XROW_HEADER_IOVMAX = 1,
 	XROW_BODY_IOVMAX = 2,
 	XROW_IOVMAX = XROW_HEADER_IOVMAX + XROW_BODY_IOVMAX,
-	XROW_HEADER_LEN_MAX = 40,
+	XROW_HEADER_LEN_MAX = 52,
 	XROW_BODY_LEN_MAX = 128,
 	IPROTO_HEADER_LEN = 28,
 	/** 7 = sizeof(iproto_body_bin). */
@@ -76,6 +76,20 @@ struct xrow_header {
 
 	int bodycnt;
 	uint32_t schema_version;
+	/**
+	 * Id of the stream the request belongs to, 0 if the
+	 * request is not bound to any stream. Streams are
+	 * a property of a client session and so the id is
+	 * never written to WAL.
+	 */
+	uint64_t stream_id;
+	/**
+	 * Transaction id: LSN of the first row of the
+	 * transaction the row belongs to.
+	 */
+	int64_t tsn;
+	/** True for the last row of a transaction. */
+	bool is_commit;
 	struct iovec body[XROW_BODY_IOVMAX];
 };
 
@@ -139,7 +153,13 @@ struct request {
 	/** Upsert operations. */
 	const char *ops;
 	const char *ops_end;
-	/** Base field offset for UPDATE/UPSERT, e.g. 0 for C and 1 for Lua. */
+	/** SELECT filter expression, see tuple_filter.h. */
+	const char *filter;
+	const char *filter_end;
+	/**
+	 * Base field offset for UPDATE/UPSERT and SELECT filter,
+	 * e.g. 0 for C and 1 for Lua.
+	 */
 	int index_base;
 };
 
@@ -217,6 +237,26 @@ struct auth_request {
 int
 xrow_decode_auth(const struct xrow_header *row, struct auth_request *request);
 
+/** CURSOR_FETCH or CURSOR_CLOSE request. */
+struct cursor_request {
+	/** Cursor id, returned by CURSOR_OPEN. */
+	uint64_t cursor_id;
+	/** Max number of tuples to fetch. */
+	uint32_t limit;
+};
+
+/**
+ * Decode CURSOR_FETCH or CURSOR_CLOSE request from MessagePack.
+ * IPROTO_LIMIT is mandatory for CURSOR_FETCH.
+ * @param row request header.
+ * @param[out] request Request to decode.
+ * @retval  0 on success
+ * @retval -1 on error
+ */
+int
+xrow_decode_cursor(const struct xrow_header *row,
+		   struct cursor_request *request);
+
 /**
  * Encode AUTH command.
  * @param[out] Row.
@@ -242,6 +282,14 @@ xrow_encode_auth(struct xrow_header *row, const char *salt, size_t salt_len,
 void
 xrow_encode_request_vote(struct xrow_header *row);
 
+/**
+ * Encode a request to switch the connection to compressed
+ * wire format, see IPROTO_COMPRESS.
+ * @param row[out] Row to encode into.
+ */
+void
+xrow_encode_compress(struct xrow_header *row);
+
 /**
  * Encode SUBSCRIBE command.
  * @param[out] Row.
@@ -279,28 +327,134 @@ xrow_decode_subscribe(struct xrow_header *row, struct tt_uuid *replicaset_uuid,
  * Encode JOIN command.
  * @param[out] row Row to encode into.
  * @param instance_uuid.
+ * @param stream_count Number of connections the replica may
+ *        receive initial data over, see IPROTO_JOIN_STREAM.
+ * @param join_files Ask the master to send the memtx snapshot
+ *        as a file, see IPROTO_JOIN_FILE.
  *
  * @retval  0 Success.
  * @retval -1 Memory error.
  */
 int
-xrow_encode_join(struct xrow_header *row, const struct tt_uuid *instance_uuid);
+xrow_encode_join(struct xrow_header *row, const struct tt_uuid *instance_uuid,
+		 uint32_t stream_count, bool join_files);
+
+/**
+ * Decode JOIN_STREAM command. Also used to decode JOIN and
+ * the response to JOIN.
+ * @param row Row to decode.
+ * @param[out] instance_uuid.
+ * @param[out] vclock.
+ * @param[out] stream_id. Set to 0 if absent.
+ * @param[out] stream_count. Set to 1 if absent.
+ * @param[out] join_files. Set to false if absent.
+ *
+ * @retval  0 Success.
+ * @retval -1 Memory or format error.
+ */
+int
+xrow_decode_join_stream(struct xrow_header *row, struct tt_uuid *instance_uuid,
+			struct vclock *vclock, uint32_t *stream_id,
+			uint32_t *stream_count, bool *join_files);
 
 /**
  * Decode JOIN command.
  * @param row Row to decode.
  * @param[out] instance_uuid.
+ * @param[out] stream_count.
+ * @param[out] join_files.
  *
  * @retval  0 Success.
  * @retval -1 Memory or format error.
  */
 static inline int
-xrow_decode_join(struct xrow_header *row, struct tt_uuid *instance_uuid)
+xrow_decode_join(struct xrow_header *row, struct tt_uuid *instance_uuid,
+		 uint32_t *stream_count, bool *join_files)
 {
-	return xrow_decode_subscribe(row, NULL, instance_uuid, NULL, NULL,
-				     NULL);
+	return xrow_decode_join_stream(row, instance_uuid, NULL, NULL,
+				       stream_count, join_files);
 }
 
+/**
+ * Encode a response to JOIN command.
+ * @param[out] row Row to encode into.
+ * @param vclock Vclock of the checkpoint sent to the replica.
+ * @param stream_count Number of connections initial data is
+ *        sent over.
+ * @param join_files Set if the memtx snapshot is sent as a file.
+ *
+ * @retval  0 Success.
+ * @retval -1 Memory error.
+ */
+int
+xrow_encode_join_response(struct xrow_header *row,
+			  const struct vclock *vclock, uint32_t stream_count,
+			  bool join_files);
+
+/**
+ * Decode a response to JOIN command.
+ * @param row Row to decode.
+ * @param[out] vclock.
+ * @param[out] stream_count.
+ * @param[out] join_files.
+ *
+ * @retval  0 Success.
+ * @retval -1 Memory or format error.
+ */
+static inline int
+xrow_decode_join_response(struct xrow_header *row, struct vclock *vclock,
+			  uint32_t *stream_count, bool *join_files)
+{
+	return xrow_decode_join_stream(row, NULL, vclock, NULL, stream_count,
+				       join_files);
+}
+
+/**
+ * Encode a chunk of a checkpoint file sent on JOIN.
+ * @param[out] row Row to encode into.
+ * @param data Chunk data, referenced by the row. May be NULL
+ *        if the caller sends the chunk by other means, e.g.
+ *        with sendfile(), then the last iovec of the encoded
+ *        row stands for the chunk and must not be written.
+ * @param size Chunk size.
+ *
+ * @retval  0 Success.
+ * @retval -1 Memory error.
+ */
+int
+xrow_encode_join_file(struct xrow_header *row, const char *data,
+		      uint32_t size);
+
+/**
+ * Decode a chunk of a checkpoint file sent on JOIN.
+ * @param row Row to decode.
+ * @param[out] data Chunk data, points to the row body.
+ * @param[out] size Chunk size.
+ *
+ * @retval  0 Success.
+ * @retval -1 Format error.
+ */
+int
+xrow_decode_join_file(struct xrow_header *row, const char **data,
+		      uint32_t *size);
+
+/**
+ * Encode JOIN_STREAM command.
+ * @param[out] row Row to encode into.
+ * @param instance_uuid.
+ * @param vclock Vclock of the checkpoint received on JOIN.
+ * @param stream_id Id of the stream, 1 <= id < stream_count.
+ * @param stream_count Number of streams accepted by the master.
+ *
+ * @retval  0 Success.
+ * @retval -1 Memory error.
+ */
+int
+xrow_encode_join_stream(struct xrow_header *row,
+			const struct tt_uuid *instance_uuid,
+			const struct vclock *vclock,
+			uint32_t stream_id, uint32_t stream_count);
+
 /**
  * Encode end of stream command (a response to JOIN command).
  * @param row[out] Row to encode into.
@@ -448,6 +602,21 @@ iproto_reply_request_vote(struct obuf *out, uint64_t sync,
 			 uint32_t schema_version, const struct vclock *vclock,
 			 bool read_only);
 
+/**
+ * Encode a reply to CURSOR_OPEN: iproto header with IPROTO_OK
+ * response code and the cursor id in the body.
+ * @param out Encode to.
+ * @param sync Request sync.
+ * @param schema_version.
+ * @param cursor_id Id of the opened cursor.
+ *
+ * @retval  0 Success.
+ * @retval -1 Memory error.
+ */
+int
+iproto_reply_cursor(struct obuf *out, uint64_t sync,
+		    uint32_t schema_version, uint64_t cursor_id);
+
 /**
  * Write an error packet int output buffer. Doesn't throw if out
  * of memory
@@ -656,17 +825,84 @@ xrow_decode_subscribe_xc(struct xrow_header *row,
 /** @copydoc xrow_encode_join. */
 static inline void
 xrow_encode_join_xc(struct xrow_header *row,
-		    const struct tt_uuid *instance_uuid)
+		    const struct tt_uuid *instance_uuid,
+		    uint32_t stream_count, bool join_files)
 {
-	if (xrow_encode_join(row, instance_uuid) != 0)
+	if (xrow_encode_join(row, instance_uuid, stream_count,
+			     join_files) != 0)
 		diag_raise();
 }
 
 /** @copydoc xrow_decode_join. */
 static inline void
-xrow_decode_join_xc(struct xrow_header *row, struct tt_uuid *instance_uuid)
+xrow_decode_join_xc(struct xrow_header *row, struct tt_uuid *instance_uuid,
+		    uint32_t *stream_count, bool *join_files)
+{
+	if (xrow_decode_join(row, instance_uuid, stream_count,
+			     join_files) != 0)
+		diag_raise();
+}
+
+/** @copydoc xrow_encode_join_response. */
+static inline void
+xrow_encode_join_response_xc(struct xrow_header *row,
+			     const struct vclock *vclock,
+			     uint32_t stream_count, bool join_files)
+{
+	if (xrow_encode_join_response(row, vclock, stream_count,
+				      join_files) != 0)
+		diag_raise();
+}
+
+/** @copydoc xrow_decode_join_response. */
+static inline void
+xrow_decode_join_response_xc(struct xrow_header *row, struct vclock *vclock,
+			     uint32_t *stream_count, bool *join_files)
+{
+	if (xrow_decode_join_response(row, vclock, stream_count,
+				      join_files) != 0)
+		diag_raise();
+}
+
+/** @copydoc xrow_encode_join_file. */
+static inline void
+xrow_encode_join_file_xc(struct xrow_header *row, const char *data,
+			 uint32_t size)
+{
+	if (xrow_encode_join_file(row, data, size) != 0)
+		diag_raise();
+}
+
+/** @copydoc xrow_decode_join_file. */
+static inline void
+xrow_decode_join_file_xc(struct xrow_header *row, const char **data,
+			 uint32_t *size)
+{
+	if (xrow_decode_join_file(row, data, size) != 0)
+		diag_raise();
+}
+
+/** @copydoc xrow_encode_join_stream. */
+static inline void
+xrow_encode_join_stream_xc(struct xrow_header *row,
+			   const struct tt_uuid *instance_uuid,
+			   const struct vclock *vclock,
+			   uint32_t stream_id, uint32_t stream_count)
+{
+	if (xrow_encode_join_stream(row, instance_uuid, vclock,
+				    stream_id, stream_count) != 0)
+		diag_raise();
+}
+
+/** @copydoc xrow_decode_join_stream. */
+static inline void
+xrow_decode_join_stream_xc(struct xrow_header *row,
+			   struct tt_uuid *instance_uuid,
+			   struct vclock *vclock, uint32_t *stream_id,
+			   uint32_t *stream_count)
 {
-	if (xrow_decode_join(row, instance_uuid) != 0)
+	if (xrow_decode_join_stream(row, instance_uuid, vclock,
+				    stream_id, stream_count, NULL) != 0)
 		diag_raise();
 }
 
@@ -33,43 +33,113 @@
 #include "coio.h"
 #include "coio_buf.h"
 #include "error.h"
+#include "fiber.h"
+#include "scoped_guard.h"
 #include "msgpuck/msgpuck.h"
 
+enum {
+	/** Size of a compressed input read from the socket at once. */
+	XROW_ZSTD_READAHEAD = 16320,
+};
+
 void
-coio_read_xrow(struct ev_io *coio, struct ibuf *in, struct xrow_header *row)
+xrow_zstd_create(struct xrow_zstd *zstd, ZSTD_CStream *cstream,
+		 ZSTD_DStream *dstream)
 {
-	/* Read fixed header */
-	if (ibuf_used(in) < 1)
-		coio_breadn(coio, in, 1);
+	zstd->cstream = cstream;
+	zstd->dstream = dstream;
+	ibuf_create(&zstd->in, &cord()->slabc, XROW_ZSTD_READAHEAD);
+	zstd->is_draining = false;
+}
 
-	/* Read length */
-	if (mp_typeof(*in->rpos) != MP_UINT) {
-		tnt_raise(ClientError, ER_INVALID_MSGPACK,
-			  "packet length");
+void
+xrow_zstd_destroy(struct xrow_zstd *zstd)
+{
+	ibuf_destroy(&zstd->in);
+}
+
+int
+xrow_zstd_start(struct xrow_zstd *zstd)
+{
+	assert(zstd->cstream == NULL && zstd->dstream == NULL);
+	zstd->cstream = ZSTD_createCStream();
+	zstd->dstream = ZSTD_createDStream();
+	if (zstd->cstream == NULL || zstd->dstream == NULL ||
+	    ZSTD_isError(ZSTD_initCStream(zstd->cstream, 1)) ||
+	    ZSTD_isError(ZSTD_initDStream(zstd->dstream))) {
+		xrow_zstd_stop(zstd);
+		diag_set(OutOfMemory, ZSTD_estimateCStreamSize(1),
+			 "zstd", "stream");
+		return -1;
 	}
-	ssize_t to_read = mp_check_uint(in->rpos, in->wpos);
-	if (to_read > 0)
-		coio_breadn(coio, in, to_read);
+	return 0;
+}
 
-	uint32_t len = mp_decode_uint((const char **) &in->rpos);
+void
+xrow_zstd_stop(struct xrow_zstd *zstd)
+{
+	ZSTD_freeCStream(zstd->cstream);
+	ZSTD_freeDStream(zstd->dstream);
+	zstd->cstream = NULL;
+	zstd->dstream = NULL;
+	ibuf_reinit(&zstd->in);
+	zstd->is_draining = false;
+}
 
-	/* Read header and body */
-	to_read = len - ibuf_used(in);
-	if (to_read > 0)
-		coio_breadn(coio, in, to_read);
+/**
+ * Read at least sz bytes to the input buffer, decompressing
+ * them if the connection is compressed. Throws on EOF, timeout
+ * or decompression error.
+ */
+static void
+coio_breadn_zstd_timeout(struct ev_io *coio, struct xrow_zstd *zstd,
+			 struct ibuf *in, size_t sz, ev_tstamp timeout)
+{
+	if (zstd == NULL) {
+		coio_breadn_timeout(coio, in, sz, timeout);
+		return;
+	}
+	ev_tstamp start, delay;
+	coio_timeout_init(&start, &delay, timeout);
+	struct ibuf *zin = &zstd->in;
+	ibuf_reserve_xc(in, MAX(sz, (size_t)XROW_ZSTD_READAHEAD));
+	ZSTD_outBuffer output = { in->wpos, ibuf_unused(in), 0 };
+	while (output.pos < sz) {
+		if (ibuf_used(zin) == 0 && !zstd->is_draining) {
+			ibuf_reset(zin);
+			coio_breadn_timeout(coio, zin, 1, delay);
+			coio_timeout_update(start, &delay);
+		}
+		ZSTD_inBuffer input = { zin->rpos, ibuf_used(zin), 0 };
+		size_t rc = ZSTD_decompressStream(zstd->dstream, &output,
+						  &input);
+		if (ZSTD_isError(rc)) {
+			tnt_raise(ClientError, ER_DECOMPRESSION,
+				  ZSTD_getErrorName(rc));
+		}
+		zin->rpos += input.pos;
+		zstd->is_draining = output.pos == output.size;
+	}
+	in->wpos += output.pos;
+}
 
-	xrow_header_decode_xc(row, (const char **) &in->rpos, in->rpos + len);
+void
+coio_read_xrow(struct ev_io *coio, struct xrow_zstd *zstd, struct ibuf *in,
+	       struct xrow_header *row)
+{
+	coio_read_xrow_timeout_xc(coio, zstd, in, row, TIMEOUT_INFINITY);
 }
 
 void
-coio_read_xrow_timeout_xc(struct ev_io *coio, struct ibuf *in,
-			  struct xrow_header *row, ev_tstamp timeout)
+coio_read_xrow_timeout_xc(struct ev_io *coio, struct xrow_zstd *zstd,
+			  struct ibuf *in, struct xrow_header *row,
+			  ev_tstamp timeout)
 {
 	ev_tstamp start, delay;
 	coio_timeout_init(&start, &delay, timeout);
 	/* Read fixed header */
 	if (ibuf_used(in) < 1)
-		coio_breadn_timeout(coio, in, 1, delay);
+		coio_breadn_zstd_timeout(coio, zstd, in, 1, delay);
 	coio_timeout_update(start, &delay);
 
 	/* Read length */
@@ -79,7 +149,7 @@ coio_read_xrow_timeout_xc(struct ev_io *coio, struct ibuf *in,
 	}
 	ssize_t to_read = mp_check_uint(in->rpos, in->wpos);
 	if (to_read > 0)
-		coio_breadn_timeout(coio, in, to_read, delay);
+		coio_breadn_zstd_timeout(coio, zstd, in, to_read, delay);
 	coio_timeout_update(start, &delay);
 
 	uint32_t len = mp_decode_uint((const char **) &in->rpos);
@@ -87,17 +157,62 @@ coio_read_xrow_timeout_xc(struct ev_io *coio, struct ibuf *in,
 	/* Read header and body */
 	to_read = len - ibuf_used(in);
 	if (to_read > 0)
-		coio_breadn_timeout(coio, in, to_read, delay);
+		coio_breadn_zstd_timeout(coio, zstd, in, to_read, delay);
 
 	xrow_header_decode_xc(row, (const char **) &in->rpos, in->rpos + len);
 }
 
+void
+coio_writev_zstd(struct ev_io *coio, struct xrow_zstd *zstd,
+		 struct iovec *iov, int iovcnt, size_t size)
+{
+	if (zstd == NULL) {
+		coio_writev(coio, iov, iovcnt, size);
+		return;
+	}
+	struct region *region = &fiber()->gc;
+	size_t region_svp = region_used(region);
+	auto region_guard = make_scoped_guard([=] {
+		region_truncate(region, region_svp);
+	});
+	size_t buf_size = ZSTD_CStreamOutSize();
+	char *buf = (char *)region_alloc(region, buf_size);
+	if (buf == NULL)
+		tnt_raise(OutOfMemory, buf_size, "region", "zstd output");
+	ZSTD_outBuffer output = { buf, buf_size, 0 };
+	size_t rc;
+	for (int i = 0; i < iovcnt; i++) {
+		ZSTD_inBuffer input = { iov[i].iov_base, iov[i].iov_len, 0 };
+		while (input.pos < input.size) {
+			rc = ZSTD_compressStream(zstd->cstream, &output,
+						 &input);
+			if (ZSTD_isError(rc))
+				goto error;
+			if (output.pos == output.size) {
+				coio_write(coio, buf, output.pos);
+				output.pos = 0;
+			}
+		}
+	}
+	do {
+		rc = ZSTD_flushStream(zstd->cstream, &output);
+		if (ZSTD_isError(rc))
+			goto error;
+		if (output.pos > 0)
+			coio_write(coio, buf, output.pos);
+		output.pos = 0;
+	} while (rc != 0);
+	return;
+error:
+	tnt_raise(ClientError, ER_COMPRESSION, ZSTD_getErrorName(rc));
+}
 
 void
-coio_write_xrow(struct ev_io *coio, const struct xrow_header *row)
+coio_write_xrow(struct ev_io *coio, struct xrow_zstd *zstd,
+		const struct xrow_header *row)
 {
 	struct iovec iov[XROW_IOVMAX];
 	int iovcnt = xrow_to_iovec_xc(row, iov);
-	coio_writev(coio, iov, iovcnt, 0);
+	coio_writev_zstd(coio, zstd, iov, iovcnt, 0);
 }
 
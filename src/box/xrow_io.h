@@ -30,23 +30,96 @@
  * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
  * SUCH DAMAGE.
  */
+#include <stdbool.h>
+#include <sys/uio.h>
+#include <small/ibuf.h>
+
+#include "zstd.h"
+
 #if defined(__cplusplus)
 extern "C" {
 #endif
 
 struct ev_io;
-struct ibuf;
 struct xrow_header;
 
+/**
+ * Compression state of a connection read and written with
+ * coio, see IPROTO_COMPRESS. The zstd contexts are not owned
+ * by the state: a relay borrows them from the iproto connection
+ * the replica sent JOIN or SUBSCRIBE over. Compressed output is
+ * made on the fiber region, so only the input buffer is bound
+ * to the thread which created the state.
+ */
+struct xrow_zstd {
+	/** Compressor of the output. */
+	ZSTD_CStream *cstream;
+	/** Decompressor of the input. */
+	ZSTD_DStream *dstream;
+	/** Compressed input which is not decompressed yet. */
+	struct ibuf in;
+	/**
+	 * True if the last decompression filled up the input
+	 * buffer, so the decompressor may hold more data even
+	 * if there is no compressed input left.
+	 */
+	bool is_draining;
+};
+
+/**
+ * Initialize a compression state with the given contexts,
+ * which may be NULL if the connection is not compressed yet.
+ */
+void
+xrow_zstd_create(struct xrow_zstd *zstd, ZSTD_CStream *cstream,
+		 ZSTD_DStream *dstream);
+
+/** Destroy a compression state. The contexts are not freed. */
+void
+xrow_zstd_destroy(struct xrow_zstd *zstd);
+
+/**
+ * Create the contexts of a compression state once the peer
+ * has accepted compression.
+ * @retval 0 Success.
+ * @retval -1 Memory error.
+ */
+int
+xrow_zstd_start(struct xrow_zstd *zstd);
+
+/**
+ * Free the contexts created by xrow_zstd_start() and drop
+ * the buffered input, e.g. when the connection is closed.
+ */
 void
-coio_read_xrow(struct ev_io *coio, struct ibuf *in, struct xrow_header *row);
+xrow_zstd_stop(struct xrow_zstd *zstd);
 
+/**
+ * Read a row. The input is decompressed with \a zstd unless
+ * it is NULL. Throws on error.
+ */
+void
+coio_read_xrow(struct ev_io *coio, struct xrow_zstd *zstd, struct ibuf *in,
+	       struct xrow_header *row);
+
+void
+coio_read_xrow_timeout_xc(struct ev_io *coio, struct xrow_zstd *zstd,
+			  struct ibuf *in, struct xrow_header *row,
+			  double timeout);
+
+/**
+ * Write data to the socket, compressed with \a zstd unless it
+ * is NULL. The compressor is flushed at the end of the data,
+ * so the peer can decode all of it without waiting for more.
+ * Throws on error.
+ */
 void
-coio_read_xrow_timeout_xc(struct ev_io *coio, struct ibuf *in,
-			  struct xrow_header *row, double timeout);
+coio_writev_zstd(struct ev_io *coio, struct xrow_zstd *zstd,
+		 struct iovec *iov, int iovcnt, size_t size);
 
 void
-coio_write_xrow(struct ev_io *coio, const struct xrow_header *row);
+coio_write_xrow(struct ev_io *coio, struct xrow_zstd *zstd,
+		const struct xrow_header *row);
 
 
 #if defined(__cplusplus)
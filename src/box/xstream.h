@@ -32,6 +32,8 @@
  * SUCH DAMAGE.
  */
 
+#include <stdbool.h>
+#include <stdint.h>
 #include "diag.h"
 
 #if defined(__cplusplus)
@@ -42,15 +44,33 @@ struct xrow_header;
 struct xstream;
 
 typedef void (*xstream_write_f)(struct xstream *, struct xrow_header *);
+typedef bool (*xstream_skip_space_f)(struct xstream *, uint32_t space_id);
 
 struct xstream {
 	xstream_write_f write;
+	/**
+	 * Optional filter of spaces which rows the stream doesn't
+	 * need, so that a reader may skip them without reading,
+	 * e.g. spaces sent over another initial join stream. May
+	 * be called from engine reader threads. NULL if all rows
+	 * are needed.
+	 */
+	xstream_skip_space_f skip_space;
 };
 
 static inline void
 xstream_create(struct xstream *xstream, xstream_write_f write)
 {
 	xstream->write = write;
+	xstream->skip_space = NULL;
+}
+
+/** Return true if the stream doesn't need rows of a space. */
+static inline bool
+xstream_skip_space(struct xstream *stream, uint32_t space_id)
+{
+	return stream->skip_space != NULL &&
+	       stream->skip_space(stream, space_id);
 }
 
 int
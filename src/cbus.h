@@ -251,10 +251,19 @@ struct cbus_endpoint {
 	char name[FIBER_NAME_MAX];
 	/** Member of cbus->endpoints */
 	struct rlist in_cbus;
-	/** The lock around the pipe. */
+	/**
+	 * The lock serializing pipe destruction with endpoint
+	 * destruction, see cpipe_destroy().
+	 */
 	pthread_mutex_t mutex;
-	/** A queue with incoming messages. */
-	struct stailq output;
+	/**
+	 * A lock-free queue with incoming messages, linked
+	 * through cmsg::fifo, the most recent message first.
+	 * Producers push batches of messages with a single
+	 * compare-and-swap, the consumer takes all of them at
+	 * once with an atomic exchange.
+	 */
+	struct stailq_entry *output;
 	/** Consumer cord loop */
 	ev_loop *consumer;
 	/** Async to notify the consumer */
@@ -263,18 +272,25 @@ struct cbus_endpoint {
 	uint32_t n_pipes;
 	/** Condition for endpoint destroy */
 	struct fiber_cond cond;
+	/**
+	 * Set while the consumer polls the queue before going
+	 * to sleep, producers needn't wake it up then.
+	 */
+	bool is_spinning;
+	/**
+	 * Max time to poll the queue before sleeping, 0 if the
+	 * consumer doesn't poll, see cbus_endpoint_set_spin().
+	 */
+	double spin_timeout;
+	/** Current time to poll the queue before sleeping. */
+	double spin_time;
 };
 
 /**
  * Fetch incomming messages to output
  */
-static inline void
-cbus_endpoint_fetch(struct cbus_endpoint *endpoint, struct stailq *output)
-{
-	tt_pthread_mutex_lock(&endpoint->mutex);
-	stailq_concat(output, &endpoint->output);
-	tt_pthread_mutex_unlock(&endpoint->mutex);
-}
+void
+cbus_endpoint_fetch(struct cbus_endpoint *endpoint, struct stailq *output);
 
 /** Initialize the global singleton bus. */
 void
@@ -295,6 +311,22 @@ int
 cbus_endpoint_create(struct cbus_endpoint *endpoint, const char *name,
 		     void (*fetch_cb)(ev_loop *, struct ev_watcher *, int), void *fetch_data);
 
+/**
+ * Default max time a consumer polls its queue before sleeping,
+ * see cbus_endpoint_set_spin().
+ */
+#define CBUS_SPIN_TIMEOUT 5e-5
+
+/**
+ * Let cbus_loop() poll the endpoint queue for up to @a timeout
+ * seconds before going to sleep in the event loop, 0 disables
+ * polling, which is the default. Events aren't handled while
+ * polling, so it only suits cords which don't serve sockets or
+ * timers, such as WAL or vinyl readers.
+ */
+void
+cbus_endpoint_set_spin(struct cbus_endpoint *endpoint, double timeout);
+
 /**
  * One round for message fetch and deliver */
 void
@@ -35,6 +35,10 @@
 #include <netinet/tcp.h>
 #include <stdio.h>
 #include <arpa/inet.h>
+#include <unistd.h>
+#ifdef TARGET_OS_LINUX
+#include <sys/sendfile.h>
+#endif /* #ifdef TARGET_OS_LINUX */
 
 #include "sio.h"
 #include "scoped_guard.h"
@@ -495,6 +499,57 @@ coio_writev_timeout(struct ev_io *coio, struct iovec *iov, int iovcnt,
 	return total;
 }
 
+/**
+ * Send size bytes of a file starting at offset to a socket.
+ * On Linux the data goes from the page cache to the socket
+ * with sendfile(), without copying it to the user space.
+ *
+ * Throws SocketError in case of write error and SystemError
+ * in case of read error or if the file is shorter than
+ * expected. Yields the current fiber until the socket becomes
+ * ready.
+ */
+void
+coio_sendfile(struct ev_io *coio, int file_fd, off_t offset, size_t size)
+{
+	CoioGuard coio_guard(coio);
+#if !defined(HAVE_SENDFILE_LINUX)
+	char buf[16384];
+#endif
+	while (size > 0) {
+#if defined(HAVE_SENDFILE_LINUX)
+		ssize_t nwr = sendfile(coio->fd, file_fd, &offset, size);
+		if (nwr == 0)
+			tnt_raise(SystemError, "unexpected end of file");
+		if (nwr < 0 && errno != EAGAIN && errno != EWOULDBLOCK &&
+		    errno != EINTR)
+			tnt_raise(SocketError, coio->fd, "sendfile");
+		if (nwr > 0) {
+			size -= nwr;
+			continue;
+		}
+#else
+		ssize_t nrd = pread(file_fd, buf, MIN(size, sizeof(buf)),
+				    offset);
+		if (nrd < 0)
+			tnt_raise(SystemError, "pread");
+		if (nrd == 0)
+			tnt_raise(SystemError, "unexpected end of file");
+		coio_write(coio, buf, nrd);
+		offset += nrd;
+		size -= nrd;
+		continue;
+#endif
+		if (! ev_is_active(coio)) {
+			ev_io_set(coio, coio->fd, EV_WRITE);
+			ev_io_start(loop(), coio);
+		}
+		fiber_testcancel();
+		coio_fiber_yield_timeout(coio, TIMEOUT_INFINITY);
+		fiber_testcancel();
+	}
+}
+
 /**
  * Send up to sz bytes to a UDP socket.
  * Return the number of bytes sent.
@@ -149,6 +149,9 @@ coio_writev(struct ev_io *coio, struct iovec *iov, int iovcnt, size_t size)
 	return coio_writev_timeout(coio, iov, iovcnt, size, TIMEOUT_INFINITY);
 }
 
+void
+coio_sendfile(struct ev_io *coio, int file_fd, off_t offset, size_t size);
+
 ssize_t
 coio_sendto_timeout(struct ev_io *coio, const void *buf, size_t sz, int flags,
 		    const struct sockaddr *dest_addr, socklen_t addrlen,
@@ -34,148 +34,81 @@
 #include "say.h"
 #include "fio.h"
 #include <stdio.h>
+#include <string.h>
+#include <errno.h>
 #include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include <dirent.h>
 
-/**
- * A context of libeio request for any
- * coio task.
+/*
+ * File operations are executed in the coio worker pool.
+ * Operations which may take long regardless of the amount of
+ * data, like fsync() or unlink() of a huge file, go to the
+ * bulk class, so that they don't delay other tasks.
  */
-struct coio_file_task {
-	ssize_t result;
-	int errorno;
-	struct fiber *fiber;
-	bool done;
-
-	union {
-		struct {
-			int fd;
-			struct stat *buf;
-		} fstat;
-
-		struct {
-			struct stat *buf;
-			const char *pathname;
-		} lstat;
-
-		struct {
-			const char *pattern;
-			int flags;
-			int (*errfunc) (const char *epath, int eerrno);
-			glob_t *pglob;
-		} glob;
-
-		struct {
-			int fd;
-			off_t offset;
-			int whence;
-		} lseek;
-
-		struct {
-			int fd;
-			const void *buf;
-			size_t count;
-		} write;
-
-		struct {
-			int fd;
-			void *buf;
-			size_t count;
-		} read;
-
-		struct {
-			const char *pathname;
-			char *buf;
-			size_t bufsize;
-		} readlink;
-
-		struct {
-			char *tpl;
-		} tempdir;
-
-		struct {
-			char **bufp;
-			const char *pathname;
-		} readdir;
-
-		struct {
-			const char *source;
-			const char *dest;
-		} copyfile;
-	};
-};
-
-#define INIT_COEIO_FILE(name)			\
-	struct coio_file_task name;		\
-	memset(&name, 0, sizeof(name));		\
-	name.fiber = fiber();			\
-
-/** A callback invoked by eio when a task is complete. */
-static int
-coio_complete(eio_req *req)
-{
-	struct coio_file_task *eio = (struct coio_file_task *)req->data;
-
-	eio->errorno = req->errorno;
-	eio->done = true;
-	eio->result = req->result;
-
-	fiber_wakeup(eio->fiber);
-	return 0;
-}
 
-/**
- * Synchronously (from cooperative multitasking point of view)
- * wait for task completion.
- */
 static ssize_t
-coio_wait_done(eio_req *req, struct coio_file_task *eio)
+coio_do_open(va_list ap)
 {
-	if (!req) {
-		errno = ENOMEM;
-		return -1;
-	}
-
-	while (!eio->done)
-		fiber_yield();
-
-	errno = eio->errorno;
-	return eio->result;
+	const char *path = va_arg(ap, const char *);
+	int flags = va_arg(ap, int);
+	mode_t mode = (mode_t) va_arg(ap, int);
+	return open(path, flags, mode);
 }
 
 int
 coio_file_open(const char *path, int flags, mode_t mode)
 {
-	INIT_COEIO_FILE(eio);
-	eio_req *req = eio_open(path, flags, mode, 0,
-				coio_complete, &eio);
-	return coio_wait_done(req, &eio);
+	return coio_call_class(COIO_BACKGROUND, coio_do_open,
+			       path, flags, mode);
+}
+
+static ssize_t
+coio_do_close(va_list ap)
+{
+	int fd = va_arg(ap, int);
+	return close(fd);
 }
 
 int
 coio_file_close(int fd)
 {
-	INIT_COEIO_FILE(eio);
-	eio_req *req = eio_close(fd, 0, coio_complete, &eio);
-	return coio_wait_done(req, &eio);
+	return coio_call_class(COIO_BACKGROUND, coio_do_close, fd);
+}
+
+static ssize_t
+coio_do_pwrite(va_list ap)
+{
+	int fd = va_arg(ap, int);
+	const void *buf = va_arg(ap, const void *);
+	size_t count = va_arg(ap, size_t);
+	off_t offset = va_arg(ap, off_t);
+	return pwrite(fd, buf, count, offset);
 }
 
 ssize_t
 coio_pwrite(int fd, const void *buf, size_t count, off_t offset)
 {
-	INIT_COEIO_FILE(eio);
-	eio_req *req = eio_write(fd, (void *) buf, count, offset,
-				 0, coio_complete, &eio);
-	return coio_wait_done(req, &eio);
+	return coio_call_class(COIO_BACKGROUND, coio_do_pwrite,
+			       fd, buf, count, offset);
+}
+
+static ssize_t
+coio_do_pread(va_list ap)
+{
+	int fd = va_arg(ap, int);
+	void *buf = va_arg(ap, void *);
+	size_t count = va_arg(ap, size_t);
+	off_t offset = va_arg(ap, off_t);
+	return pread(fd, buf, count, offset);
 }
 
 ssize_t
 coio_pread(int fd, void *buf, size_t count, off_t offset)
 {
-	INIT_COEIO_FILE(eio);
-	eio_req *req = eio_read(fd, buf, count,
-				offset, 0, coio_complete, &eio);
-	return coio_wait_done(req, &eio);
+	return coio_call_class(COIO_BACKGROUND, coio_do_pread,
+			       fd, buf, count, offset);
 }
 
 ssize_t
@@ -196,169 +129,164 @@ coio_preadn(int fd, void *buf, size_t count, off_t offset)
 	return n;
 }
 
-static void
-coio_do_write(eio_req *req)
+static ssize_t
+coio_do_write(va_list ap)
 {
-	struct coio_file_task *eio = (struct coio_file_task *)req->data;
-	req->result = write(eio->write.fd, eio->write.buf, eio->write.count);
-	eio->errorno = errno;
+	int fd = va_arg(ap, int);
+	const void *buf = va_arg(ap, const void *);
+	size_t count = va_arg(ap, size_t);
+	return write(fd, buf, count);
 }
 
 ssize_t
 coio_write(int fd, const void *buf, size_t count)
 {
-	INIT_COEIO_FILE(eio);
-	eio.write.buf = buf;
-	eio.write.count = count;
-	eio.write.fd = fd;
-	eio_req *req = eio_custom(coio_do_write, 0,
-				  coio_complete, &eio);
-	return coio_wait_done(req, &eio);
+	return coio_call_class(COIO_BACKGROUND, coio_do_write,
+			       fd, buf, count);
 }
 
-static void
-coio_do_read(eio_req *req)
+static ssize_t
+coio_do_read(va_list ap)
 {
-	struct coio_file_task *eio = (struct coio_file_task *)req->data;
-	req->result = read(eio->read.fd, eio->read.buf, eio->read.count);
-	req->errorno = errno;
+	int fd = va_arg(ap, int);
+	void *buf = va_arg(ap, void *);
+	size_t count = va_arg(ap, size_t);
+	return read(fd, buf, count);
 }
 
 ssize_t
 coio_read(int fd, void *buf, size_t count)
 {
-	INIT_COEIO_FILE(eio);
-	eio.read.buf = buf;
-	eio.read.count = count;
-	eio.read.fd = fd;
-	eio_req *req = eio_custom(coio_do_read, 0,
-				  coio_complete, &eio);
-	return coio_wait_done(req, &eio);
+	return coio_call_class(COIO_BACKGROUND, coio_do_read,
+			       fd, buf, count);
 }
 
-
-static void
-coio_do_lseek(eio_req *req)
+static ssize_t
+coio_do_lseek(va_list ap)
 {
-	struct coio_file_task *eio = (struct coio_file_task *)req->data;
-	req->result =
-		lseek(eio->lseek.fd, eio->lseek.offset, eio->lseek.whence);
-	req->errorno = errno;
+	int fd = va_arg(ap, int);
+	off_t offset = va_arg(ap, off_t);
+	int whence = va_arg(ap, int);
+	return lseek(fd, offset, whence);
 }
 
 off_t
 coio_lseek(int fd, off_t offset, int whence)
 {
-	INIT_COEIO_FILE(eio);
-
-	eio.lseek.whence = whence;
-	eio.lseek.offset = offset;
-	eio.lseek.fd = fd;
-
-	eio_req *req = eio_custom(coio_do_lseek, 0,
-				  coio_complete, &eio);
-	return coio_wait_done(req, &eio);
+	return coio_call_class(COIO_BACKGROUND, coio_do_lseek,
+			       fd, offset, whence);
 }
 
-static void
-coio_do_lstat(eio_req *req)
+static ssize_t
+coio_do_lstat(va_list ap)
 {
-	struct coio_file_task *eio = (struct coio_file_task *)req->data;
-	req->result = lstat(eio->lstat.pathname, eio->lstat.buf);
-	req->errorno = errno;
+	const char *pathname = va_arg(ap, const char *);
+	struct stat *buf = va_arg(ap, struct stat *);
+	return lstat(pathname, buf);
 }
 
 int
 coio_lstat(const char *pathname, struct stat *buf)
 {
-	INIT_COEIO_FILE(eio);
-	eio.lstat.pathname = pathname;
-	eio.lstat.buf = buf;
-	eio_req *req = eio_custom(coio_do_lstat, 0,
-				  coio_complete, &eio);
-	return coio_wait_done(req, &eio);
+	return coio_call_class(COIO_BACKGROUND, coio_do_lstat,
+			       pathname, buf);
 }
 
-static void
-coio_do_stat(eio_req *req)
+static ssize_t
+coio_do_stat(va_list ap)
 {
-	struct coio_file_task *eio = (struct coio_file_task *)req->data;
-	req->result = stat(eio->lstat.pathname, eio->lstat.buf);
-	req->errorno = errno;
+	const char *pathname = va_arg(ap, const char *);
+	struct stat *buf = va_arg(ap, struct stat *);
+	return stat(pathname, buf);
 }
 
 int
 coio_stat(const char *pathname, struct stat *buf)
 {
-	INIT_COEIO_FILE(eio);
-	eio.lstat.pathname = pathname;
-	eio.lstat.buf = buf;
-	eio_req *req = eio_custom(coio_do_stat, 0,
-				  coio_complete, &eio);
-	return coio_wait_done(req, &eio);
+	return coio_call_class(COIO_BACKGROUND, coio_do_stat,
+			       pathname, buf);
 }
 
-static void
-coio_do_fstat(eio_req *req)
+static ssize_t
+coio_do_fstat(va_list ap)
 {
-	struct coio_file_task *eio = (struct coio_file_task *)req->data;
-	req->result = fstat(eio->fstat.fd, eio->fstat.buf);
-	req->errorno = errno;
+	int fd = va_arg(ap, int);
+	struct stat *buf = va_arg(ap, struct stat *);
+	return fstat(fd, buf);
 }
 
 int
 coio_fstat(int fd, struct stat *stat)
 {
-	INIT_COEIO_FILE(eio);
-	eio.fstat.fd = fd;
-	eio.fstat.buf = stat;
+	return coio_call_class(COIO_BACKGROUND, coio_do_fstat, fd, stat);
+}
 
-	eio_req *req = eio_custom(coio_do_fstat, 0,
-				  coio_complete, &eio);
-	return coio_wait_done(req, &eio);
+static ssize_t
+coio_do_rename(va_list ap)
+{
+	const char *oldpath = va_arg(ap, const char *);
+	const char *newpath = va_arg(ap, const char *);
+	return rename(oldpath, newpath);
 }
 
 int
 coio_rename(const char *oldpath, const char *newpath)
 {
-	INIT_COEIO_FILE(eio);
-	eio_req *req = eio_rename(oldpath, newpath, 0,
-				  coio_complete, &eio);
-	return coio_wait_done(req, &eio);
+	return coio_call_class(COIO_BACKGROUND, coio_do_rename,
+			       oldpath, newpath);
+}
 
+static ssize_t
+coio_do_unlink(va_list ap)
+{
+	const char *pathname = va_arg(ap, const char *);
+	return unlink(pathname);
 }
 
 int
 coio_unlink(const char *pathname)
 {
-	INIT_COEIO_FILE(eio);
-	eio_req *req = eio_unlink(pathname, 0, coio_complete, &eio);
-	return coio_wait_done(req, &eio);
+	/* Unlinking a big file may take seconds on some file systems. */
+	return coio_call_class(COIO_BULK, coio_do_unlink, pathname);
+}
+
+static ssize_t
+coio_do_ftruncate(va_list ap)
+{
+	int fd = va_arg(ap, int);
+	off_t length = va_arg(ap, off_t);
+	return ftruncate(fd, length);
 }
 
 int
 coio_ftruncate(int fd, off_t length)
 {
-	INIT_COEIO_FILE(eio);
-	eio_req *req = eio_ftruncate(fd, length, 0, coio_complete, &eio);
-	return coio_wait_done(req, &eio);
+	return coio_call_class(COIO_BULK, coio_do_ftruncate, fd, length);
+}
+
+static ssize_t
+coio_do_truncate(va_list ap)
+{
+	const char *path = va_arg(ap, const char *);
+	off_t length = va_arg(ap, off_t);
+	return truncate(path, length);
 }
 
 int
 coio_truncate(const char *path, off_t length)
 {
-	INIT_COEIO_FILE(eio);
-	eio_req *req = eio_truncate(path, length, 0, coio_complete, &eio);
-	return coio_wait_done(req, &eio);
+	return coio_call_class(COIO_BULK, coio_do_truncate, path, length);
 }
 
-static void
-coio_do_glob(eio_req *req)
+static ssize_t
+coio_do_glob(va_list ap)
 {
-	struct coio_file_task *eio = (struct coio_file_task *)req->data;
-	req->result = glob(eio->glob.pattern,
-			   eio->glob.flags, eio->glob.errfunc, eio->glob.pglob);
-	req->errorno = errno;
+	const char *pattern = va_arg(ap, const char *);
+	int flags = va_arg(ap, int);
+	int (*errfunc) (const char *, int) =
+		va_arg(ap, int (*)(const char *, int));
+	glob_t *pglob = va_arg(ap, glob_t *);
+	return glob(pattern, flags, errfunc, pglob);
 }
 
 int
@@ -366,156 +294,188 @@ coio_glob(const char *pattern, int flags,
 		int (*errfunc) (const char *epath, int eerrno),
 		glob_t *pglob)
 {
-	INIT_COEIO_FILE(eio);
-	eio.glob.pattern = pattern;
-	eio.glob.flags = flags;
-	eio.glob.errfunc = errfunc;
-	eio.glob.pglob = pglob;
-	eio_req *req =
-		eio_custom(coio_do_glob, 0, coio_complete, &eio);
-	return coio_wait_done(req, &eio);
+	return coio_call_class(COIO_BACKGROUND, coio_do_glob,
+			       pattern, flags, errfunc, pglob);
+}
+
+static ssize_t
+coio_do_chown(va_list ap)
+{
+	const char *path = va_arg(ap, const char *);
+	uid_t owner = va_arg(ap, uid_t);
+	gid_t group = va_arg(ap, gid_t);
+	return chown(path, owner, group);
 }
 
 int
 coio_chown(const char *path, uid_t owner, gid_t group)
 {
-	INIT_COEIO_FILE(eio);
-	eio_req *req =
-		eio_chown(path, owner, group, 0, coio_complete, &eio);
-	return coio_wait_done(req, &eio);
+	return coio_call_class(COIO_BACKGROUND, coio_do_chown,
+			       path, owner, group);
+}
+
+static ssize_t
+coio_do_chmod(va_list ap)
+{
+	const char *path = va_arg(ap, const char *);
+	mode_t mode = (mode_t) va_arg(ap, int);
+	return chmod(path, mode);
 }
 
 int
 coio_chmod(const char *path, mode_t mode)
 {
-	INIT_COEIO_FILE(eio);
-	eio_req *req = eio_chmod(path, mode, 0, coio_complete, &eio);
-	return coio_wait_done(req, &eio);
+	return coio_call_class(COIO_BACKGROUND, coio_do_chmod, path, mode);
+}
+
+static ssize_t
+coio_do_mkdir(va_list ap)
+{
+	const char *pathname = va_arg(ap, const char *);
+	mode_t mode = (mode_t) va_arg(ap, int);
+	return mkdir(pathname, mode);
 }
 
 int
 coio_mkdir(const char *pathname, mode_t mode)
 {
-	INIT_COEIO_FILE(eio);
-	eio_req *req = eio_mkdir(pathname, mode, 0, coio_complete, &eio);
-	return coio_wait_done(req, &eio);
+	return coio_call_class(COIO_BACKGROUND, coio_do_mkdir,
+			       pathname, mode);
+}
+
+static ssize_t
+coio_do_rmdir(va_list ap)
+{
+	const char *pathname = va_arg(ap, const char *);
+	return rmdir(pathname);
 }
 
 int
 coio_rmdir(const char *pathname)
 {
-	INIT_COEIO_FILE(eio);
-	eio_req *req = eio_rmdir(pathname, 0, coio_complete, &eio);
-	return coio_wait_done(req, &eio);
+	return coio_call_class(COIO_BACKGROUND, coio_do_rmdir, pathname);
+}
+
+static ssize_t
+coio_do_link(va_list ap)
+{
+	const char *oldpath = va_arg(ap, const char *);
+	const char *newpath = va_arg(ap, const char *);
+	return link(oldpath, newpath);
 }
 
 int
 coio_link(const char *oldpath, const char *newpath)
 {
-	INIT_COEIO_FILE(eio);
-	eio_req *req = eio_link(oldpath, newpath, 0, coio_complete, &eio);
-	return coio_wait_done(req, &eio);
+	return coio_call_class(COIO_BACKGROUND, coio_do_link,
+			       oldpath, newpath);
+}
+
+static ssize_t
+coio_do_symlink(va_list ap)
+{
+	const char *target = va_arg(ap, const char *);
+	const char *linkpath = va_arg(ap, const char *);
+	return symlink(target, linkpath);
 }
 
 int
 coio_symlink(const char *target, const char *linkpath)
 {
-	INIT_COEIO_FILE(eio);
-	eio_req *req =
-		eio_symlink(target, linkpath, 0, coio_complete, &eio);
-	return coio_wait_done(req, &eio);
+	return coio_call_class(COIO_BACKGROUND, coio_do_symlink,
+			       target, linkpath);
 }
 
-static void
-coio_do_readlink(eio_req *req)
+static ssize_t
+coio_do_readlink(va_list ap)
 {
-	struct coio_file_task *eio = (struct coio_file_task *)req->data;
-	req->result = readlink(eio->readlink.pathname,
-			       eio->readlink.buf, eio->readlink.bufsize);
-	req->errorno = errno;
+	const char *pathname = va_arg(ap, const char *);
+	char *buf = va_arg(ap, char *);
+	size_t bufsize = va_arg(ap, size_t);
+	return readlink(pathname, buf, bufsize);
 }
 
 int
 coio_readlink(const char *pathname, char *buf, size_t bufsize)
 {
-	INIT_COEIO_FILE(eio);
-	eio.readlink.pathname = pathname;
-	eio.readlink.buf = buf;
-	eio.readlink.bufsize = bufsize;
-	eio_req *req = eio_custom(coio_do_readlink, 0,
-				  coio_complete, &eio);
-	return coio_wait_done(req, &eio);
-}
-
-static void
-coio_do_tempdir(eio_req *req)
-{
-	struct coio_file_task *eio = (struct coio_file_task *)req->data;
-	char *res = mkdtemp(eio->tempdir.tpl);
-	req->errorno = errno;
-	if (res == NULL) {
-		req->result = -1;
-	} else {
-		req->result = 0;
-	}
+	return coio_call_class(COIO_BACKGROUND, coio_do_readlink,
+			       pathname, buf, bufsize);
+}
+
+static ssize_t
+coio_do_tempdir(va_list ap)
+{
+	char *tpl = va_arg(ap, char *);
+	return mkdtemp(tpl) == NULL ? -1 : 0;
 }
 
 int
 coio_tempdir(char *path, size_t path_len)
 {
-	INIT_COEIO_FILE(eio);
-
 	if (path_len < sizeof("/tmp/XXXXXX") + 1) {
 		errno = ENOMEM;
 		return -1;
 	}
 
 	snprintf(path, path_len, "/tmp/XXXXXX");
+	return coio_call_class(COIO_BACKGROUND, coio_do_tempdir, path);
+}
 
-	eio.tempdir.tpl = path;
-	eio_req *req =
-		eio_custom(coio_do_tempdir, 0, coio_complete, &eio);
-	return coio_wait_done(req, &eio);
+static ssize_t
+coio_do_sync(va_list ap)
+{
+	(void) ap;
+	sync();
+	return 0;
 }
 
 int
 coio_sync()
 {
-	INIT_COEIO_FILE(eio);
-	eio_req *req = eio_sync(0, coio_complete, &eio);
-	return coio_wait_done(req, &eio);
+	return coio_call_class(COIO_BULK, coio_do_sync);
+}
+
+static ssize_t
+coio_do_fsync(va_list ap)
+{
+	int fd = va_arg(ap, int);
+	return fsync(fd);
 }
 
 int
 coio_fsync(int fd)
 {
-	INIT_COEIO_FILE(eio);
-	eio_req *req = eio_fsync(fd, 0, coio_complete, &eio);
-	return coio_wait_done(req, &eio);
+	return coio_call_class(COIO_BULK, coio_do_fsync, fd);
+}
+
+static ssize_t
+coio_do_fdatasync(va_list ap)
+{
+	int fd = va_arg(ap, int);
+	return fdatasync(fd);
 }
 
 int
 coio_fdatasync(int fd)
 {
-	INIT_COEIO_FILE(eio);
-	eio_req *req = eio_fdatasync(fd, 0, coio_complete, &eio);
-	return coio_wait_done(req, &eio);
+	return coio_call_class(COIO_BULK, coio_do_fdatasync, fd);
 }
 
-static void
-coio_do_readdir(eio_req *req)
+static ssize_t
+coio_do_readdir(va_list ap)
 {
-	struct coio_file_task *eio = (struct coio_file_task *)req->data;
-	DIR *dirp = opendir(eio->readdir.pathname);
+	const char *pathname = va_arg(ap, const char *);
+	char **bufp = va_arg(ap, char **);
+	DIR *dirp = opendir(pathname);
 	if (dirp == NULL)
-		goto error;
+		return -1;
 	size_t capacity = 128;
 	size_t len = 0;
+	ssize_t count = 0;
 	struct dirent *entry;
 	char *buf = (char *) malloc(capacity);
 	if (buf == NULL)
 		goto mem_error;
-	req->result = 0;
 	do {
 		entry = readdir(dirp);
 		if (entry == NULL ||
@@ -537,7 +497,7 @@ coio_do_readdir(eio_req *req)
 		memcpy(&buf[len], entry->d_name, namlen);
 		len += namlen;
 		buf[len++] = '\n';
-		req->result++;
+		count++;
 	} while(entry != NULL);
 
 	if (len > 0)
@@ -545,45 +505,40 @@ coio_do_readdir(eio_req *req)
 	else
 		buf[0] = 0;
 
-	*eio->readdir.bufp = buf;
+	*bufp = buf;
 	closedir(dirp);
-	return;
+	return count;
 
 mem_error:
 	free(buf);
 	closedir(dirp);
-error:
-	req->result = -1;
-	req->errorno = errno;
+	return -1;
 }
 
 int
 coio_readdir(const char *dir_path, char **buf)
 {
-	INIT_COEIO_FILE(eio)
-	eio.readdir.bufp = buf;
-	eio.readdir.pathname = dir_path;
-	eio_req *req = eio_custom(coio_do_readdir, 0, coio_complete, &eio);
-	return coio_wait_done(req, &eio);
+	return coio_call_class(COIO_BACKGROUND, coio_do_readdir,
+			       dir_path, buf);
 }
 
-static void
-coio_do_copyfile(eio_req *req)
+static ssize_t
+coio_do_copyfile(va_list ap)
 {
-	struct coio_file_task *eio = (struct coio_file_task *)req->data;
+	const char *source = va_arg(ap, const char *);
+	const char *dest = va_arg(ap, const char *);
 
 	struct stat st;
-	if (stat(eio->copyfile.source, &st) < 0) {
+	if (stat(source, &st) < 0) {
 		goto error;
 	}
 
-	int source_fd = open(eio->copyfile.source, O_RDONLY);
+	int source_fd = open(source, O_RDONLY);
 	if (source_fd < 0) {
 		goto error;
 	}
 
-	int dest_fd = open(eio->copyfile.dest, O_WRONLY | O_CREAT,
-			   st.st_mode & 0777);
+	int dest_fd = open(dest, O_WRONLY | O_CREAT, st.st_mode & 0777);
 	if (dest_fd < 0) {
 		goto error_dest;
 	}
@@ -604,27 +559,20 @@ coio_do_copyfile(eio_req *req)
 		if (nwritten < 0)
 			goto error_copy;
 	}
-	req->result = 0;
 	close(source_fd);
 	close(dest_fd);
-	return;
+	return 0;
 
 error_copy:
 	close(dest_fd);
 error_dest:
 	close(source_fd);
 error:
-	req->errorno = errno;
-	req->result = -1;
-	return;
+	return -1;
 }
 
 int
 coio_copyfile(const char *source, const char *dest)
 {
-	INIT_COEIO_FILE(eio)
-	eio.copyfile.source = source;
-	eio.copyfile.dest = dest;
-	eio_req *req = eio_custom(coio_do_copyfile, 0, coio_complete, &eio);
-	return coio_wait_done(req, &eio);
+	return coio_call_class(COIO_BULK, coio_do_copyfile, source, dest);
 }
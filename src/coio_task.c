@@ -37,167 +37,494 @@
 #include <unistd.h>
 #include <netdb.h>
 #include <sys/socket.h>
+#include <pmatomic.h>
 
 #include "fiber.h"
+#include "clock.h"
+#include "say.h"
 #include "third_party/tarantool_ev.h"
 
 /*
- * Asynchronous IO Tasks (libeio wrapper).
- * ---------------------------------------
+ * Asynchronous IO Tasks.
+ * ----------------------
  *
- * libeio request processing is designed in edge-trigger
- * manner, when libeio is ready to process some requests it
- * calls coio_poller callback.
+ * Tasks are executed by a pool of worker threads. Each worker
+ * has its own queue per priority class. A cord submits tasks to
+ * the workers in round-robin order, and a worker which has
+ * nothing to do steals tasks from the queues of its peers, so
+ * a slow task doesn't hold up the tasks queued behind it.
  *
- * Due to libeio design, want_poll callback is called while
- * locks are being held, so it's not possible to call any libeio
- * function inside this callback. Thus coio_want_poll raises an
- * async event which will be dealt with normally as part of the
- * main Tarantool event loop.
+ * A worker looks for a task of the highest priority class
+ * first. The number of workers busy with background and bulk
+ * tasks is limited, so there is always a worker available for
+ * a latency-critical task.
  *
- * The async event handler, in turn, performs eio_poll(), which
- * will run on_complete callback for all ready eio tasks.
- * In case if some of the requests are not complete by the time
- * eio_poll() has been called, coio_idle watcher is started, which
- * would periodically invoke eio_poll() until all requests are
- * complete.
- *
- * See for details:
- * http://pod.tst.eu/http://cvs.schmorp.de/libeio/eio.pod
-*/
+ * A finished task is returned to the cord which submitted it:
+ * the worker puts it to the cord's completion queue and raises
+ * an async event, which is handled in the cord's event loop.
+ */
+
+const char *coio_class_strs[] = { "latency", "background", "bulk" };
+
+enum {
+	/** The default number of workers, see coio_set_worker_count(). */
+	COIO_WORKER_COUNT_DEFAULT = 4,
+	COIO_WORKER_COUNT_MAX = 128,
+};
+
+struct coio_worker {
+	/** Protects the queues. */
+	pthread_mutex_t mutex;
+	/** Tasks submitted to this worker, by priority class. */
+	struct stailq queue[coio_class_MAX];
+};
 
+static struct coio_pool {
+	/** Protects worker start and the wait for tasks. */
+	pthread_mutex_t mutex;
+	/** Signalled when there are tasks to take. */
+	pthread_cond_t cond;
+	/** Number of workers allowed to take tasks. */
+	int size;
+	/** Number of started workers. */
+	int started;
+	/** Number of workers waiting for tasks. */
+	int idle;
+	/** Number of queued and running tasks, by class. */
+	int queued[coio_class_MAX];
+	int running[coio_class_MAX];
+	/** Number of running background and bulk tasks. */
+	int running_low;
+	bool is_shutdown;
+	struct coio_worker workers[COIO_WORKER_COUNT_MAX];
+} coio_pool = {
+	.mutex = PTHREAD_MUTEX_INITIALIZER,
+	.cond = PTHREAD_COND_INITIALIZER,
+	.size = COIO_WORKER_COUNT_DEFAULT,
+};
+
+/** Completion queue of a cord. */
 struct coio_manager {
 	ev_loop *loop;
-	ev_idle coio_idle;
 	ev_async coio_async;
+	/** Protects the completion queue. */
+	pthread_mutex_t mutex;
+	/** Tasks finished by workers. */
+	struct stailq done;
+	/** The worker to submit the next task to. */
+	unsigned next_worker;
+	/** Number of completed tasks and their queue time, by class. */
+	int64_t total[coio_class_MAX];
+	double queue_time[coio_class_MAX];
+	double queue_time_max[coio_class_MAX];
 };
 
 static __thread struct coio_manager coio_manager;
 
-static void
-coio_idle_cb(ev_loop *loop, struct ev_idle *w, int events)
+/** Max number of running background and bulk tasks. */
+static inline int
+coio_pool_low_limit(int size)
+{
+	return size > 1 ? size - 1 : 1;
+}
+
+/** Max number of running bulk tasks. */
+static inline int
+coio_pool_bulk_limit(int size)
+{
+	return size > 1 ? size / 2 : 1;
+}
+
+/** Try to increment a counter unless it reached the limit. */
+static bool
+coio_pool_inc(int *counter, int limit)
+{
+	int value = pm_atomic_load(counter);
+	do {
+		if (value >= limit)
+			return false;
+	} while (!pm_atomic_compare_exchange_weak(counter, &value,
+						  value + 1));
+	return true;
+}
+
+/** Reserve a slot for a task of the given class. */
+static bool
+coio_pool_reserve(enum coio_class cls)
 {
-	(void) events;
-	if (eio_poll() != -1) {
-		/* nothing to do */
-		ev_idle_stop(loop, w);
+	struct coio_pool *pool = &coio_pool;
+	int size = pm_atomic_load(&pool->size);
+	if (cls == COIO_BULK &&
+	    !coio_pool_inc(&pool->running[cls], coio_pool_bulk_limit(size)))
+		return false;
+	if (cls != COIO_LATENCY &&
+	    !coio_pool_inc(&pool->running_low, coio_pool_low_limit(size))) {
+		if (cls == COIO_BULK)
+			pm_atomic_fetch_sub(&pool->running[cls], 1);
+		return false;
 	}
+	if (cls != COIO_BULK)
+		pm_atomic_fetch_add(&pool->running[cls], 1);
+	return true;
 }
 
 static void
-coio_async_cb(ev_loop *loop, MAYBE_UNUSED struct ev_async *w,
-	       MAYBE_UNUSED int events)
+coio_pool_wakeup(void)
+{
+	struct coio_pool *pool = &coio_pool;
+	if (pm_atomic_load(&pool->idle) == 0)
+		return;
+	tt_pthread_mutex_lock(&pool->mutex);
+	tt_pthread_cond_broadcast(&pool->cond);
+	tt_pthread_mutex_unlock(&pool->mutex);
+}
+
+/** Release a slot taken by coio_pool_reserve(). */
+static void
+coio_pool_release(enum coio_class cls)
+{
+	struct coio_pool *pool = &coio_pool;
+	pm_atomic_fetch_sub(&pool->running[cls], 1);
+	if (cls == COIO_LATENCY)
+		return;
+	pm_atomic_fetch_sub(&pool->running_low, 1);
+	/* A worker may be waiting for the slot. */
+	coio_pool_wakeup();
+}
+
+/** True if a worker can take a task right now. */
+static bool
+coio_pool_has_work(void)
 {
-	if (eio_poll() == -1) {
-		/* not all tasks are complete. */
-		ev_idle_start(loop, &coio_manager.coio_idle);
+	struct coio_pool *pool = &coio_pool;
+	int size = pm_atomic_load(&pool->size);
+	if (pm_atomic_load(&pool->queued[COIO_LATENCY]) > 0)
+		return true;
+	if (pm_atomic_load(&pool->running_low) >= coio_pool_low_limit(size))
+		return false;
+	if (pm_atomic_load(&pool->queued[COIO_BACKGROUND]) > 0)
+		return true;
+	return pm_atomic_load(&pool->queued[COIO_BULK]) > 0 &&
+	       pm_atomic_load(&pool->running[COIO_BULK]) <
+	       coio_pool_bulk_limit(size);
+}
+
+/**
+ * Take a task of the given class from the queue of the given
+ * worker or, if it is empty, steal one from its peers.
+ */
+static struct coio_task *
+coio_pool_steal(int id, enum coio_class cls)
+{
+	struct coio_pool *pool = &coio_pool;
+	int count = pm_atomic_load(&pool->started);
+	/* A just started worker may not be accounted yet. */
+	if (count == 0)
+		return NULL;
+	for (int i = 0; i < count; i++) {
+		struct coio_worker *worker = &pool->workers[(id + i) % count];
+		struct coio_task *task = NULL;
+		tt_pthread_mutex_lock(&worker->mutex);
+		if (!stailq_empty(&worker->queue[cls])) {
+			task = stailq_shift_entry(&worker->queue[cls],
+						  struct coio_task, in_queue);
+		}
+		tt_pthread_mutex_unlock(&worker->mutex);
+		if (task != NULL) {
+			pm_atomic_fetch_sub(&pool->queued[cls], 1);
+			return task;
+		}
 	}
+	return NULL;
 }
 
+/** Take the task of the highest priority class available. */
+static struct coio_task *
+coio_pool_take(int id)
+{
+	struct coio_pool *pool = &coio_pool;
+	for (int cls = 0; cls < coio_class_MAX; cls++) {
+		if (pm_atomic_load(&pool->queued[cls]) == 0)
+			continue;
+		if (!coio_pool_reserve(cls))
+			continue;
+		struct coio_task *task = coio_pool_steal(id, cls);
+		if (task != NULL)
+			return task;
+		coio_pool_release(cls);
+	}
+	return NULL;
+}
+
+/** Return a finished task to the cord which submitted it. */
 static void
-coio_want_poll_cb(void *ptr)
+coio_manager_complete(struct coio_manager *manager, struct coio_task *task)
 {
-	struct coio_manager *manager = ptr;
-	ev_async_send(manager->loop, &manager->coio_async);
+	tt_pthread_mutex_lock(&manager->mutex);
+	bool was_empty = stailq_empty(&manager->done);
+	stailq_add_tail_entry(&manager->done, task, in_queue);
+	tt_pthread_mutex_unlock(&manager->mutex);
+	/* The task may be freed as soon as the mutex is released. */
+	if (was_empty)
+		ev_async_send(manager->loop, &manager->coio_async);
 }
 
 static void
-coio_done_poll_cb(void *ptr)
+coio_worker_run(struct coio_task *task)
 {
-	(void)ptr;
+	enum coio_class cls = task->cls;
+	struct coio_manager *manager = task->manager;
+	task->start_time = clock_monotonic();
+	task->exec(task);
+	task->errorno = errno;
+	coio_pool_release(cls);
+	coio_manager_complete(manager, task);
 }
 
-static int
-coio_on_start(void *data)
+static void *
+coio_worker_f(void *arg)
 {
-	(void) data;
-	struct cord *cord = (struct cord *)calloc(sizeof(struct cord), 1);
-	if (!cord)
-		return -1;
+	struct coio_pool *pool = &coio_pool;
+	int id = (int) (intptr_t) arg;
+	struct cord *cord = (struct cord *) calloc(1, sizeof(*cord));
+	if (cord == NULL)
+		panic("failed to allocate coio worker cord");
 	cord_create(cord, "coio");
-	return 0;
+
+	while (true) {
+		if (id < pm_atomic_load(&pool->size)) {
+			struct coio_task *task = coio_pool_take(id);
+			if (task != NULL) {
+				coio_worker_run(task);
+				continue;
+			}
+		}
+		tt_pthread_mutex_lock(&pool->mutex);
+		pm_atomic_fetch_add(&pool->idle, 1);
+		while (!pool->is_shutdown &&
+		       (id >= pm_atomic_load(&pool->size) ||
+			!coio_pool_has_work()))
+			tt_pthread_cond_wait(&pool->cond, &pool->mutex);
+		pm_atomic_fetch_sub(&pool->idle, 1);
+		bool is_shutdown = pool->is_shutdown;
+		tt_pthread_mutex_unlock(&pool->mutex);
+		if (is_shutdown)
+			break;
+	}
+	cord_destroy(cord);
+	free(cord);
+	return NULL;
 }
 
-static int
-coio_on_stop(void *data)
+/**
+ * Start one more worker unless all of them are busy
+ * or the limit is reached. Workers are started on demand
+ * so that none exist before the process daemonizes.
+ */
+static void
+coio_pool_grow(void)
 {
-	(void) data;
-	cord_destroy(cord());
-	return 0;
+	struct coio_pool *pool = &coio_pool;
+	int started = pm_atomic_load(&pool->started);
+	if (started > 0 && (started >= pm_atomic_load(&pool->size) ||
+			    pm_atomic_load(&pool->idle) > 0))
+		return;
+	tt_pthread_mutex_lock(&pool->mutex);
+	started = pool->started;
+	if (started == 0 || (started < pool->size && pool->idle == 0)) {
+		struct coio_worker *worker = &pool->workers[started];
+		tt_pthread_mutex_init(&worker->mutex, NULL);
+		for (int cls = 0; cls < coio_class_MAX; cls++)
+			stailq_create(&worker->queue[cls]);
+		pthread_t thread;
+		if (tt_pthread_create(&thread, NULL, coio_worker_f,
+				      (void *) (intptr_t) started) == 0) {
+			pthread_detach(thread);
+			pm_atomic_store(&pool->started, started + 1);
+		} else if (started == 0) {
+			panic("failed to start a coio worker");
+		}
+	}
+	tt_pthread_mutex_unlock(&pool->mutex);
+}
+
+static void
+coio_pool_submit(struct coio_task *task)
+{
+	struct coio_pool *pool = &coio_pool;
+	struct coio_manager *manager = &coio_manager;
+	/* coio_enable() must be called in every cord using coio. */
+	assert(manager->loop != NULL);
+	task->manager = manager;
+	task->submit_time = clock_monotonic();
+	coio_pool_grow();
+
+	int count = MIN(pm_atomic_load(&pool->started),
+			pm_atomic_load(&pool->size));
+	assert(count > 0);
+	struct coio_worker *worker =
+		&pool->workers[manager->next_worker++ % count];
+	tt_pthread_mutex_lock(&worker->mutex);
+	stailq_add_tail_entry(&worker->queue[task->cls], task, in_queue);
+	tt_pthread_mutex_unlock(&worker->mutex);
+	pm_atomic_fetch_add(&pool->queued[task->cls], 1);
+	coio_pool_wakeup();
+}
+
+static void
+coio_on_finish(struct coio_task *task);
+
+static void
+coio_async_cb(ev_loop *loop, MAYBE_UNUSED struct ev_async *w,
+	       MAYBE_UNUSED int events)
+{
+	(void) loop;
+	struct coio_manager *manager = &coio_manager;
+	struct stailq done;
+	stailq_create(&done);
+	tt_pthread_mutex_lock(&manager->mutex);
+	stailq_concat(&done, &manager->done);
+	tt_pthread_mutex_unlock(&manager->mutex);
+
+	struct coio_task *task, *next;
+	stailq_foreach_entry_safe(task, next, &done, in_queue) {
+		enum coio_class cls = task->cls;
+		double queue_time = task->start_time - task->submit_time;
+		manager->total[cls]++;
+		manager->queue_time[cls] += queue_time;
+		if (queue_time > manager->queue_time_max[cls])
+			manager->queue_time_max[cls] = queue_time;
+		coio_on_finish(task);
+	}
+}
+
+/**
+ * A forked child inherits the pool but none of the worker
+ * threads, and the pool locks may have been held by a worker
+ * at the time of fork. Reset the pool so that workers are
+ * started anew on demand. Tasks queued in the parent are
+ * dropped.
+ */
+static void
+coio_atfork_child(void)
+{
+	struct coio_pool *pool = &coio_pool;
+	tt_pthread_mutex_init(&pool->mutex, NULL);
+	tt_pthread_cond_init(&pool->cond, NULL);
+	pool->started = 0;
+	pool->idle = 0;
+	pool->running_low = 0;
+	for (int cls = 0; cls < coio_class_MAX; cls++) {
+		pool->queued[cls] = 0;
+		pool->running[cls] = 0;
+	}
+	/* The completion queue of the cord which forked. */
+	struct coio_manager *manager = &coio_manager;
+	if (manager->loop != NULL) {
+		tt_pthread_mutex_init(&manager->mutex, NULL);
+		stailq_create(&manager->done);
+	}
 }
 
 void
 coio_init(void)
 {
-	eio_set_thread_on_start(coio_on_start, NULL);
-	eio_set_thread_on_stop(coio_on_stop, NULL);
+	coio_set_worker_count(COIO_WORKER_COUNT_DEFAULT);
+	(void) tt_pthread_atfork(NULL, NULL, coio_atfork_child);
 }
 
 /**
  * Init coio subsystem.
  *
- * Create idle and async watchers, init eio.
+ * Create the completion queue of the current cord.
  */
 void
 coio_enable(void)
 {
-	eio_init(&coio_manager, coio_want_poll_cb, coio_done_poll_cb);
-	coio_manager.loop = loop();
-
-	ev_idle_init(&coio_manager.coio_idle, coio_idle_cb);
-	ev_async_init(&coio_manager.coio_async, coio_async_cb);
+	struct coio_manager *manager = &coio_manager;
+	manager->loop = loop();
+	tt_pthread_mutex_init(&manager->mutex, NULL);
+	stailq_create(&manager->done);
 
-	ev_async_start(loop(), &coio_manager.coio_async);
+	ev_async_init(&manager->coio_async, coio_async_cb);
+	ev_async_start(loop(), &manager->coio_async);
 }
 
 void
 coio_shutdown(void)
 {
-	eio_set_max_parallel(0);
+	struct coio_pool *pool = &coio_pool;
+	tt_pthread_mutex_lock(&pool->mutex);
+	pool->is_shutdown = true;
+	tt_pthread_cond_broadcast(&pool->cond);
+	tt_pthread_mutex_unlock(&pool->mutex);
+}
+
+void
+coio_set_worker_count(int count)
+{
+	struct coio_pool *pool = &coio_pool;
+	count = MAX(count, 1);
+	count = MIN(count, (int) COIO_WORKER_COUNT_MAX);
+	pm_atomic_store(&pool->size, count);
+	/* Let extra workers stop or new limits take effect. */
+	tt_pthread_mutex_lock(&pool->mutex);
+	tt_pthread_cond_broadcast(&pool->cond);
+	tt_pthread_mutex_unlock(&pool->mutex);
+}
+
+void
+coio_class_stat(enum coio_class cls, struct coio_class_stat *stat)
+{
+	struct coio_pool *pool = &coio_pool;
+	struct coio_manager *manager = &coio_manager;
+	/* Queued is decremented by a thief before the owner increments it. */
+	stat->queued = MAX(pm_atomic_load(&pool->queued[cls]), 0);
+	stat->running = pm_atomic_load(&pool->running[cls]);
+	stat->total = manager->total[cls];
+	stat->queue_time = manager->queue_time[cls];
+	stat->queue_time_max = manager->queue_time_max[cls];
+}
+
+void
+coio_reset_stat(void)
+{
+	struct coio_manager *manager = &coio_manager;
+	for (int cls = 0; cls < coio_class_MAX; cls++) {
+		manager->total[cls] = 0;
+		manager->queue_time[cls] = 0;
+		manager->queue_time_max[cls] = 0;
+	}
 }
 
 static void
-coio_on_feed(eio_req *req)
+coio_on_exec(struct coio_task *task)
 {
-	struct coio_task *task = (struct coio_task *) req;
-	req->result = task->task_cb(task);
-	if (req->result)
+	task->result = task->task_cb(task);
+	if (task->result)
 		diag_move(diag_get(), &task->diag);
 }
 
 /**
- * A callback invoked by eio_poll when associated
- * eio_request is complete.
+ * Invoked in the cord which posted the task when
+ * the task is complete.
  */
-static int
-coio_on_finish(eio_req *req)
+static void
+coio_on_finish(struct coio_task *task)
 {
-	struct coio_task *task = (struct coio_task *) req;
 	if (task->fiber == NULL) {
 		/*
-		 * Timed out. Resources will be freed by coio_on_destroy.
-		 * NOTE: it is not safe to run timeout_cb handler here.
+		 * Timed out or posted without waiting: free
+		 * the resources.
 		 */
-		return 0;
+		assert(task->complete == 0);
+		if (task->timeout_cb != NULL)
+			task->timeout_cb(task);
+		return;
 	}
 
 	task->complete = 1;
-	/* Reset on_timeout hook - resources will be freed by coio_task user */
-	task->base.destroy = NULL;
 	fiber_wakeup(task->fiber);
-	return 0;
-}
-
-/*
- * Free resources on timeout.
- */
-static void
-coio_on_destroy(eio_req *req)
-{
-	struct coio_task *task = (struct coio_task *) req;
-	assert(task->fiber == NULL && task->complete == 0);
-	if (task->timeout_cb != NULL)
-		task->timeout_cb(task);
 }
 
 void
@@ -206,14 +533,10 @@ coio_task_create(struct coio_task *task,
 {
 	assert(func != NULL && on_timeout != NULL);
 
-	/* from eio.c: REQ() definition */
-	memset(&task->base, 0, sizeof(task->base));
-	task->base.type = EIO_CUSTOM;
-	task->base.feed = coio_on_feed;
-	task->base.finish = coio_on_finish;
-	task->base.destroy = coio_on_destroy;
-	/* task->base.pri = 0; */
-
+	task->exec = coio_on_exec;
+	task->cls = COIO_LATENCY;
+	task->result = 0;
+	task->errorno = 0;
 	task->fiber = fiber();
 	task->task_cb = func;
 	task->timeout_cb = on_timeout;
@@ -230,10 +553,10 @@ coio_task_destroy(struct coio_task *task)
 int
 coio_task_post(struct coio_task *task, double timeout)
 {
-	assert(task->base.type == EIO_CUSTOM);
+	assert(task->exec == coio_on_exec);
 	assert(task->fiber == fiber());
 
-	eio_submit(&task->base);
+	coio_pool_submit(task);
 	if (timeout == 0) {
 		/*
 		* This is a special case:
@@ -257,46 +580,58 @@ coio_task_post(struct coio_task *task, double timeout)
 }
 
 static void
-coio_on_call(eio_req *req)
+coio_on_call(struct coio_task *task)
 {
-	struct coio_task *task = (struct coio_task *) req;
-	req->result = task->call_cb(task->ap);
-	if (req->result)
+	task->result = task->call_cb(task->ap);
+	if (task->result)
 		diag_move(diag_get(), &task->diag);
 }
 
-ssize_t
-coio_call(ssize_t (*func)(va_list ap), ...)
+static ssize_t
+coio_vcall(enum coio_class cls, ssize_t (*func)(va_list ap), va_list ap)
 {
-	struct coio_task *task = (struct coio_task *) calloc(1, sizeof(*task));
-	if (task == NULL)
-		return -1; /* errno = ENOMEM */
-	/* from eio.c: REQ() definition */
-	task->base.type = EIO_CUSTOM;
-	task->base.feed = coio_on_call;
-	task->base.finish = coio_on_finish;
-	/* task->base.destroy = NULL; */
-	/* task->base.pri = 0; */
-
-	task->fiber = fiber();
-	task->call_cb = func;
-	task->complete = 0;
-	diag_create(&task->diag);
-
-	va_start(task->ap, func);
-	eio_submit(&task->base);
-
+	/* The caller waits for completion, the task can't outlive it. */
+	struct coio_task task;
+	task.exec = coio_on_call;
+	task.cls = cls;
+	task.result = 0;
+	task.errorno = 0;
+	task.fiber = fiber();
+	task.call_cb = func;
+	task.complete = 0;
+	diag_create(&task.diag);
+	va_copy(task.ap, ap);
+
+	coio_pool_submit(&task);
 	do {
 		fiber_yield();
-	} while (task->complete == 0);
-	va_end(task->ap);
+	} while (task.complete == 0);
+	va_end(task.ap);
+
+	if (task.result)
+		diag_move(&task.diag, diag_get());
+	diag_destroy(&task.diag);
+	errno = task.errorno;
+	return task.result;
+}
 
-	ssize_t result = task->base.result;
-	int save_errno = errno;
-	if (result)
-		diag_move(&task->diag, diag_get());
-	free(task);
-	errno = save_errno;
+ssize_t
+coio_call(ssize_t (*func)(va_list ap), ...)
+{
+	va_list ap;
+	va_start(ap, func);
+	ssize_t result = coio_vcall(COIO_BACKGROUND, func, ap);
+	va_end(ap);
+	return result;
+}
+
+ssize_t
+coio_call_class(enum coio_class cls, ssize_t (*func)(va_list ap), ...)
+{
+	va_list ap;
+	va_start(ap, func);
+	ssize_t result = coio_vcall(cls, func, ap);
+	va_end(ap);
 	return result;
 }
 
@@ -315,7 +650,7 @@ struct async_getaddrinfo_task {
 
 /*
  * Resolver function, run in separate thread by
- * coio (libeio).
+ * the coio worker pool.
 */
 static int
 getaddrinfo_cb(struct coio_task *ptr)
@@ -35,8 +35,9 @@
 
 #include <sys/types.h> /* ssize_t */
 #include <stdarg.h>
+#include <stdint.h>
 
-#include "third_party/tarantool_eio.h"
+#include "salad/stailq.h"
 #include "diag.h"
 
 #if defined(__cplusplus)
@@ -44,25 +45,86 @@ extern "C" {
 #endif /* defined(__cplusplus) */
 
 /**
- * Asynchronous IO Tasks (libeio wrapper)
+ * Asynchronous IO Tasks
  *
+ * Blocking work is executed by a pool of worker threads.
  * Yield the current fiber until a created task is complete.
  */
 
+/**
+ * Priority class of a task. A worker always picks a task of
+ * the highest class available. Besides, background and bulk
+ * tasks may never occupy all workers, so that a latency-critical
+ * task doesn't wait for a slow fsync or unlink of a huge file.
+ */
+enum coio_class {
+	/** Short tasks somebody waits for, e.g. DNS lookups. */
+	COIO_LATENCY,
+	/** Ordinary file operations. */
+	COIO_BACKGROUND,
+	/** Long operations: fsync, unlink, file copying. */
+	COIO_BULK,
+	coio_class_MAX
+};
+
+extern const char *coio_class_strs[];
+
 void coio_init(void);
 void coio_enable(void);
 void coio_shutdown(void);
 
+/**
+ * Set the number of worker threads. Threads are started
+ * on demand, extra threads stop taking new tasks.
+ */
+void
+coio_set_worker_count(int count);
+
+/** Task statistics of a priority class. */
+struct coio_class_stat {
+	/** Number of tasks waiting in queues, all cords. */
+	int queued;
+	/** Number of tasks being executed, all cords. */
+	int running;
+	/** Number of tasks of the current cord completed so far. */
+	int64_t total;
+	/** Total and max time tasks of the current cord were queued. */
+	double queue_time;
+	double queue_time_max;
+};
+
+/** Get task statistics of the current cord. */
+void
+coio_class_stat(enum coio_class cls, struct coio_class_stat *stat);
+
+/** Reset task statistics of the current cord. */
+void
+coio_reset_stat(void);
+
 struct coio_task;
+struct coio_manager;
 
 typedef ssize_t (*coio_call_cb)(va_list ap);
-typedef int (*coio_task_cb)(struct coio_task *task); /* like eio_req */
+typedef int (*coio_task_cb)(struct coio_task *task);
 
 /**
  * A single task context.
  */
 struct coio_task {
-	struct eio_req base; /* eio_task - must be first */
+	/** Link in a worker queue or in the completion queue. */
+	struct stailq_entry in_queue;
+	/** Runs the task callback in a worker thread. */
+	void (*exec)(struct coio_task *task);
+	/** Completion queue of the cord which posted the task. */
+	struct coio_manager *manager;
+	/** Priority class, COIO_LATENCY unless set otherwise. */
+	enum coio_class cls;
+	/** Time the task was submitted and started at. */
+	double submit_time;
+	double start_time;
+	/** Result of the callback and errno it left. */
+	ssize_t result;
+	int errorno;
 	/** The calling fiber. */
 	struct fiber *fiber;
 	/** Callbacks. */
@@ -86,7 +148,7 @@ struct coio_task {
  * Create coio_task.
  *
  * @param task coio task
- * @param func a callback to execute in EIO thread pool.
+ * @param func a callback to execute in the worker pool.
  * @param on_timeout a callback to execute on timeout
  */
 void
@@ -102,12 +164,12 @@ void
 coio_task_destroy(struct coio_task *task);
 
 /**
- * Post coio task to EIO thread pool.
+ * Post coio task to the worker pool.
  *
  * @param task coio task.
  * @param timeout timeout in seconds.
  * @retval 0  the task completed successfully. Check the result
- *            code in task->base.result and free the task.
+ *            code in task->result and free the task.
  * @retval -1 timeout or the waiting fiber was cancelled (check diag);
  *            the caller should not free the task, it
  *            will be freed when it's finished in the timeout
@@ -119,16 +181,14 @@ coio_task_post(struct coio_task *task, double timeout);
 /** \cond public */
 
 /**
- * Create new eio task with specified function and
- * arguments. Yield and wait until the task is complete
- * or a timeout occurs.
+ * Create new coio task with specified function and
+ * arguments. Yield and wait until the task is complete.
  *
  * This function doesn't throw exceptions to avoid double error
  * checking: in most cases it's also necessary to check the return
  * value of the called function and perform necessary actions. If
  * func sets errno, the errno is preserved across the call.
  *
- * @retval -1 and errno = ENOMEM if failed to create a task
  * @retval the function return (errno is preserved).
  *
  * @code
@@ -147,6 +207,17 @@ coio_task_post(struct coio_task *task, double timeout);
 ssize_t
 coio_call(ssize_t (*func)(va_list), ...);
 
+/** \endcond public */
+
+/**
+ * Like coio_call(), but with the given priority class.
+ * coio_call() uses COIO_BACKGROUND.
+ */
+ssize_t
+coio_call_class(enum coio_class cls, ssize_t (*func)(va_list), ...);
+
+/** \cond public */
+
 struct addrinfo;
 
 /**
@@ -47,6 +47,9 @@ typedef int (*coll_cmp_f)(const char *s, size_t s_len, const char *t,
 typedef uint32_t (*coll_hash_f)(const char *s, size_t s_len, uint32_t *ph,
 				uint32_t *pcarry, struct coll *coll);
 
+typedef size_t (*coll_hint_f)(const char *s, size_t s_len, char *buf,
+			      size_t buf_len, struct coll *coll);
+
 struct UCollator;
 
 /**
@@ -61,6 +64,13 @@ struct coll {
 	/** String comparator. */
 	coll_cmp_f cmp;
 	coll_hash_f hash;
+	/**
+	 * Write at most buf_len leading bytes of the sort key of
+	 * a string, return the number of bytes written. Sort keys
+	 * compared with memcmp() are ordered as cmp() orders the
+	 * strings.
+	 */
+	coll_hint_f hint;
 	/** Reference counter. */
 	int refs;
 	/**
@@ -39,6 +39,7 @@
 #include <pmatomic.h>
 
 #include "assoc.h"
+#include "clock.h"
 #include "memory.h"
 #include "trigger.h"
 
@@ -154,6 +155,38 @@ fiber_recycle(struct fiber *fiber);
 static void
 fiber_destroy(struct cord *cord, struct fiber *f);
 
+/**
+ * A cheap monotonic clock for fiber CPU time accounting.
+ * The time stamp counter is constant-rate on all CPUs we
+ * care about, the rate is measured by the sampling timer.
+ */
+static inline uint64_t
+fiber_clock_cycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	return __builtin_ia32_rdtsc();
+#else
+	return clock_monotonic64();
+#endif
+}
+
+/**
+ * Charge the time passed since the last context switch to
+ * the given fiber. Called right before switching away from it.
+ */
+static inline void
+fiber_clock_account(struct cord *cord, struct fiber *fiber)
+{
+	if (likely(!cord->is_top_enabled))
+		return;
+	uint64_t now = fiber_clock_cycles();
+	/* The counter may step back if the thread migrates. */
+	uint64_t delta = now > cord->clock_last ? now - cord->clock_last : 0;
+	cord->clock_last = now;
+	fiber->clock_stat.acc += delta;
+	fiber->clock_stat.delta += delta;
+}
+
 /**
  * Transfer control to callee fiber.
  */
@@ -180,6 +213,7 @@ fiber_call_impl(struct fiber *callee)
 
 	callee->flags &= ~FIBER_IS_READY;
 	callee->csw++;
+	fiber_clock_account(cord, caller);
 	ASAN_START_SWITCH_FIBER(asan_state, 1,
 				callee->stack,
 				callee->stack_size);
@@ -422,6 +456,7 @@ fiber_yield(void)
 	cord->fiber = callee;
 	callee->csw++;
 	callee->flags &= ~FIBER_IS_READY;
+	fiber_clock_account(cord, caller);
 	ASAN_START_SWITCH_FIBER(asan_state,
 				(caller->flags & FIBER_IS_DEAD) == 0,
 				callee->stack,
@@ -806,6 +841,7 @@ fiber_new_ex(const char *name, const struct fiber_attr *fiber_attr,
 	}
 
 	fiber->f = f;
+	memset(&fiber->clock_stat, 0, sizeof(fiber->clock_stat));
 	/* fids from 0 to 100 are reserved */
 	if (++cord->max_fid < 100)
 		cord->max_fid = 101;
@@ -870,6 +906,97 @@ fiber_destroy_all(struct cord *cord)
 						      struct fiber, link));
 }
 
+static inline void
+fiber_clock_stat_rotate(struct fiber_clock_stat *stat)
+{
+	stat->prev_delta = stat->delta;
+	stat->delta = 0;
+}
+
+/**
+ * Start a new sampling period: remember how much time each
+ * fiber got in the last one and measure the clock rate.
+ */
+static void
+fiber_top_timer_cb(ev_loop *loop, ev_timer *watcher, int revents)
+{
+	(void) loop;
+	(void) revents;
+	struct cord *cord = (struct cord *) watcher->data;
+	fiber_clock_account(cord, cord->fiber);
+	uint64_t period = cord->clock_last - cord->clock_period_start;
+	double now = clock_monotonic();
+	if (now > cord->top_period_start)
+		cord->clock_per_sec = period / (now - cord->top_period_start);
+	cord->clock_period_start = cord->clock_last;
+	cord->top_period_start = now;
+	cord->clock_stat.acc += period;
+	cord->clock_stat.delta = 0;
+	cord->clock_stat.prev_delta = period;
+
+	fiber_clock_stat_rotate(&cord->sched.clock_stat);
+	struct fiber *fiber;
+	rlist_foreach_entry(fiber, &cord->alive, link)
+		fiber_clock_stat_rotate(&fiber->clock_stat);
+}
+
+void
+fiber_top_enable(void)
+{
+	struct cord *cord = cord();
+	if (cord->is_top_enabled)
+		return;
+	memset(&cord->clock_stat, 0, sizeof(cord->clock_stat));
+	memset(&cord->sched.clock_stat, 0, sizeof(cord->sched.clock_stat));
+	struct fiber *fiber;
+	rlist_foreach_entry(fiber, &cord->alive, link)
+		memset(&fiber->clock_stat, 0, sizeof(fiber->clock_stat));
+	cord->clock_last = fiber_clock_cycles();
+	cord->clock_period_start = cord->clock_last;
+	cord->top_period_start = clock_monotonic();
+	cord->clock_per_sec = 0;
+	ev_timer_again(cord->loop, &cord->top_timer);
+	cord->is_top_enabled = true;
+}
+
+void
+fiber_top_disable(void)
+{
+	struct cord *cord = cord();
+	if (!cord->is_top_enabled)
+		return;
+	ev_timer_stop(cord->loop, &cord->top_timer);
+	cord->is_top_enabled = false;
+}
+
+bool
+fiber_top_is_enabled(void)
+{
+	return cord()->is_top_enabled;
+}
+
+void
+fiber_top_stat(struct fiber *fiber, struct fiber_top_info *info)
+{
+	struct cord *cord = cord();
+	assert(cord->is_top_enabled);
+	/* Account the time spent by the caller so far. */
+	fiber_clock_account(cord, cord->fiber);
+	uint64_t elapsed = cord->clock_last - cord->clock_period_start;
+	uint64_t total = cord->clock_stat.acc + elapsed;
+	double clock_per_sec = cord->clock_per_sec;
+	if (clock_per_sec == 0) {
+		/* The first sampling period hasn't ended yet. */
+		double wall = clock_monotonic() - cord->top_period_start;
+		clock_per_sec = wall > 0 ? elapsed / wall : 0;
+	}
+	const struct fiber_clock_stat *stat = &fiber->clock_stat;
+	info->instant = cord->clock_stat.prev_delta == 0 ? 0 :
+			100.0 * stat->prev_delta / cord->clock_stat.prev_delta;
+	info->average = total == 0 ? 0 : 100.0 * stat->acc / total;
+	info->time = clock_per_sec == 0 ? 0 : stat->acc / clock_per_sec;
+}
+
 void
 cord_create(struct cord *cord, const char *name)
 {
@@ -903,6 +1030,12 @@ cord_create(struct cord *cord, const char *name)
 	ev_async_init(&cord->wakeup_event, fiber_schedule_wakeup);
 
 	ev_idle_init(&cord->idle_event, fiber_schedule_idle);
+
+	cord->is_top_enabled = false;
+	memset(&cord->clock_stat, 0, sizeof(cord->clock_stat));
+	memset(&cord->sched.clock_stat, 0, sizeof(cord->sched.clock_stat));
+	ev_timer_init(&cord->top_timer, fiber_top_timer_cb, 0, 1.);
+	cord->top_timer.data = cord;
 	cord_set_name(name);
 
 #if ENABLE_ASAN
@@ -107,7 +107,9 @@ enum fiber_key {
 	FIBER_KEY_MSG = 4,
 	/** Storage for lua stack */
 	FIBER_KEY_LUA_STACK = 5,
-	FIBER_KEY_MAX = 6
+	/** Accumulator of time spent waiting for WAL writes */
+	FIBER_KEY_WAL_TIME = 6,
+	FIBER_KEY_MAX = 7
 };
 
 /** \cond public */
@@ -349,6 +351,19 @@ struct fiber_attr {
 void
 fiber_attr_create(struct fiber_attr *fiber_attr);
 
+/**
+ * CPU time accounting used by fiber.top(). All values are
+ * measured in clock cycles, see fiber_clock_cycles().
+ */
+struct fiber_clock_stat {
+	/** Total time accumulated since accounting was enabled. */
+	uint64_t acc;
+	/** Time accumulated in the current sampling period. */
+	uint64_t delta;
+	/** Time accumulated in the previous sampling period. */
+	uint64_t prev_delta;
+};
+
 struct fiber {
 	coro_context ctx;
 	/** Coro stack slab. */
@@ -368,6 +383,8 @@ struct fiber {
 	struct fiber *caller;
 	/** Number of context switches. */
 	int csw;
+	/** CPU time spent by this fiber, if fiber.top() is on. */
+	struct fiber_clock_stat clock_stat;
 	/** Fiber id. */
 	uint32_t fid;
 	/** Fiber flags */
@@ -451,6 +468,22 @@ struct cord {
 	struct slab_cache slabc;
 	/** The "main" fiber of this cord, the scheduler. */
 	struct fiber sched;
+	/** True if per-fiber CPU time accounting is enabled. */
+	bool is_top_enabled;
+	/**
+	 * Clock value at the last context switch, the time
+	 * since then is charged to the current fiber.
+	 */
+	uint64_t clock_last;
+	/** CPU time of all fibers of this cord, sched included. */
+	struct fiber_clock_stat clock_stat;
+	/** Clock value and wall time the sampling period began at. */
+	uint64_t clock_period_start;
+	double top_period_start;
+	/** Clock rate measured over the last sampling period. */
+	double clock_per_sec;
+	/** A timer starting a new sampling period every second. */
+	ev_timer top_timer;
 	char name[FIBER_NAME_MAX];
 };
 
@@ -620,6 +653,40 @@ typedef int (*fiber_stat_cb)(struct fiber *f, void *ctx);
 int
 fiber_stat(fiber_stat_cb cb, void *cb_ctx);
 
+/**
+ * Enable CPU time accounting of the fibers of the current
+ * cord. The time spent by each fiber between context switches
+ * is measured with the CPU timestamp counter and accumulated
+ * both in total and per one second sampling period.
+ */
+void
+fiber_top_enable(void);
+
+/** Disable CPU time accounting of the current cord. */
+void
+fiber_top_disable(void);
+
+/** True if CPU time accounting of the current cord is on. */
+bool
+fiber_top_is_enabled(void);
+
+/** CPU usage of a fiber, see fiber_top_stat(). */
+struct fiber_top_info {
+	/** Share of the previous sampling period, in percent. */
+	double instant;
+	/** Share of the time since accounting was enabled, in percent. */
+	double average;
+	/** Total time spent by the fiber, in seconds. */
+	double time;
+};
+
+/**
+ * Get CPU usage of a fiber of the current cord. Must only
+ * be called when accounting is enabled.
+ */
+void
+fiber_top_stat(struct fiber *fiber, struct fiber_top_info *info);
+
 /** Useful for C unit tests */
 static inline int
 fiber_c_invoke(fiber_func f, va_list ap)
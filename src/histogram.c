@@ -34,6 +34,7 @@
 #include "histogram.h"
 
 #include <assert.h>
+#include <string.h>
 
 struct histogram *
 histogram_new(const int64_t *buckets, size_t n_buckets)
@@ -65,6 +66,14 @@ histogram_delete(struct histogram *hist)
 	free(hist);
 }
 
+void
+histogram_copy(struct histogram *dst, const struct histogram *src)
+{
+	assert(dst->n_buckets == src->n_buckets);
+	memcpy(dst, src, sizeof(*src) +
+	       src->n_buckets * sizeof(*src->buckets));
+}
+
 void
 histogram_reset(struct histogram *hist)
 {
@@ -70,6 +70,13 @@ histogram_delete(struct histogram *hist);
 void
 histogram_reset(struct histogram *hist);
 
+/**
+ * Copy observations of a histogram to another one, which must
+ * have the same buckets.
+ */
+void
+histogram_copy(struct histogram *dst, const struct histogram *src);
+
 /**
  * Update a histogram with a new observation.
  */
@@ -31,6 +31,7 @@
 
 #include "bitset/bitset.h"
 #include "page.h"
+#include "container.h"
 
 #include <stddef.h>
 #include <string.h>
@@ -46,6 +47,14 @@ bitset_create(struct bitset *bitset, void *(*realloc)(void *ptr, size_t size))
 	bitset_pages_new(&bitset->pages);
 }
 
+void
+bitset_create_roaring(struct bitset *bitset,
+		      void *(*realloc)(void *ptr, size_t size))
+{
+	bitset_create(bitset, realloc);
+	bitset->type = BITSET_ROARING;
+}
+
 static struct bitset_page *
 bitset_destroy_iter_cb(bitset_pages_t *t, struct bitset_page *page, void *arg)
 {
@@ -59,13 +68,117 @@ bitset_destroy_iter_cb(bitset_pages_t *t, struct bitset_page *page, void *arg)
 void
 bitset_destroy(struct bitset *bitset)
 {
+	for (size_t i = 0; i < bitset->container_count; i++)
+		bitset_container_destroy(&bitset->containers[i],
+					 bitset->realloc);
+	if (bitset->containers != NULL)
+		bitset->realloc(bitset->containers, 0);
+	bitset->containers = NULL;
+	bitset->container_count = 0;
+	bitset->container_capacity = 0;
+
 	bitset_pages_iter(&bitset->pages, NULL, bitset_destroy_iter_cb, bitset);
 	memset(&bitset->pages, 0, sizeof(bitset->pages));
 }
 
+/**
+ * Insert an empty container with key \a key at index \a i of
+ * the containers array.
+ */
+static struct bitset_container *
+bitset_containers_insert(struct bitset *bitset, size_t i, size_t key)
+{
+	if (bitset->container_count == bitset->container_capacity) {
+		size_t capacity = bitset->container_capacity > 0 ?
+				  bitset->container_capacity * 2 : 4;
+		struct bitset_container *containers =
+			bitset->realloc(bitset->containers,
+					capacity * sizeof(*containers));
+		if (containers == NULL)
+			return NULL;
+		bitset->containers = containers;
+		bitset->container_capacity = capacity;
+	}
+	struct bitset_container c;
+	if (bitset_container_create(&c, key, bitset->realloc) != 0)
+		return NULL;
+	memmove(&bitset->containers[i + 1], &bitset->containers[i],
+		(bitset->container_count - i) * sizeof(c));
+	bitset->containers[i] = c;
+	bitset->container_count++;
+	return &bitset->containers[i];
+}
+
+static void
+bitset_containers_remove(struct bitset *bitset, size_t i)
+{
+	bitset_container_destroy(&bitset->containers[i], bitset->realloc);
+	memmove(&bitset->containers[i], &bitset->containers[i + 1],
+		(bitset->container_count - i - 1) *
+		sizeof(*bitset->containers));
+	bitset->container_count--;
+}
+
+static bool
+bitset_roaring_test(struct bitset *bitset, size_t pos)
+{
+	struct bitset_container *c =
+		bitset_container_find(bitset, pos / BITSET_CONTAINER_BITS);
+	if (c == NULL)
+		return false;
+	return bitset_container_test(c, pos % BITSET_CONTAINER_BITS);
+}
+
+static int
+bitset_roaring_set(struct bitset *bitset, size_t pos)
+{
+	size_t key = pos / BITSET_CONTAINER_BITS;
+	size_t i = bitset_container_lower_bound(bitset, key);
+	struct bitset_container *c;
+	if (i < bitset->container_count && bitset->containers[i].key == key) {
+		c = &bitset->containers[i];
+	} else {
+		c = bitset_containers_insert(bitset, i, key);
+		if (c == NULL)
+			return -1;
+	}
+	int rc = bitset_container_set(c, pos % BITSET_CONTAINER_BITS,
+				      bitset->realloc);
+	if (rc < 0) {
+		if (c->cardinality == 0)
+			bitset_containers_remove(bitset, i);
+		return -1;
+	}
+	if (rc == 0)
+		bitset->cardinality++;
+	return rc;
+}
+
+static int
+bitset_roaring_clear(struct bitset *bitset, size_t pos)
+{
+	size_t key = pos / BITSET_CONTAINER_BITS;
+	size_t i = bitset_container_lower_bound(bitset, key);
+	if (i == bitset->container_count || bitset->containers[i].key != key)
+		return 0;
+	struct bitset_container *c = &bitset->containers[i];
+	int rc = bitset_container_clear(c, pos % BITSET_CONTAINER_BITS,
+					bitset->realloc);
+	if (rc <= 0)
+		return rc;
+	assert(bitset->cardinality > 0);
+	bitset->cardinality--;
+	if (c->cardinality == 0)
+		bitset_containers_remove(bitset, i);
+	return 1;
+}
+
 bool
 bitset_test(struct bitset *bitset, size_t pos)
 {
+	if (bitset->type == BITSET_ROARING)
+		return bitset_roaring_test(bitset, pos);
+
 	struct bitset_page key;
 	key.first_pos = bitset_page_first_pos(pos);
 
@@ -82,6 +195,9 @@ bitset_test(struct bitset *bitset, size_t pos)
 int
 bitset_set(struct bitset *bitset, size_t pos)
 {
+	if (bitset->type == BITSET_ROARING)
+		return bitset_roaring_set(bitset, pos);
+
 	struct bitset_page key;
 	key.first_pos = bitset_page_first_pos(pos);
 
@@ -118,6 +234,9 @@ bitset_set(struct bitset *bitset, size_t pos)
 int
 bitset_clear(struct bitset *bitset, size_t pos)
 {
+	if (bitset->type == BITSET_ROARING)
+		return bitset_roaring_clear(bitset, pos);
+
 	struct bitset_page key;
 	key.first_pos = bitset_page_first_pos(pos);
 
@@ -161,12 +280,26 @@ bitset_info(struct bitset *bitset, struct bitset_info *info)
 	info->page_data_alignment = BITSET_PAGE_DATA_ALIGNMENT;
 
 	size_t cardinality_check = 0;
+	if (bitset->type == BITSET_ROARING) {
+		info->containers = bitset->container_count;
+		info->mem_total = bitset->container_capacity *
+				  sizeof(*bitset->containers);
+		for (size_t i = 0; i < bitset->container_count; i++) {
+			struct bitset_container *c = &bitset->containers[i];
+			info->mem_total += bitset_container_alloc_size(c);
+			cardinality_check += c->cardinality;
+		}
+		assert(bitset_cardinality(bitset) == cardinality_check);
+		return;
+	}
+
 	struct bitset_page *page = bitset_pages_first(&bitset->pages);
 	while (page != NULL) {
 		info->pages++;
 		cardinality_check += page->cardinality;
 		page = bitset_pages_next(&bitset->pages, page);
 	}
+	info->mem_total = info->pages * info->page_total_size;
 
 	assert(bitset_cardinality(bitset) == cardinality_check);
 }
@@ -205,7 +338,7 @@ bitset_dump(struct bitset *bitset, int verbose, FILE *stream)
 			"utilization = undefined\n");
 	}
 	size_t mem_data  = info.page_data_size * info.pages;
-	size_t mem_total = info.page_total_size * info.pages;
+	size_t mem_total = info.mem_total;
 
 	fprintf(stream, "    " "mem_data    = %zu bytes\n", mem_data);
 	fprintf(stream, "    " "mem_total   = %zu bytes "
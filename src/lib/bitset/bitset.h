@@ -41,6 +41,13 @@
  * by \a size_t position number.  Initially all bits are set to
  * false. You can use any values in range [0,SIZE_MAX).  The
  * container grows automatically.
+ *
+ * Two storage layouts are supported. A paged bitset keeps fixed
+ * size pages in a tree. A roaring bitset keeps a sorted array of
+ * containers covering 65536 bits each, where a container is an
+ * array of positions, a bitmap or a list of runs, whichever is
+ * the most compact. Roaring bitsets use much less memory for
+ * sparse and clustered values.
  */
 
 #include "bit/bit.h"
@@ -74,14 +81,29 @@ struct bitset_page {
 };
 
 typedef rb_tree(struct bitset_page) bitset_pages_t;
+
+struct bitset_container;
 /** @endcond */
 
+/** Storage layout of a bitset */
+enum bitset_type {
+	/** Fixed size pages in a tree */
+	BITSET_PAGED,
+	/** Array, bitmap and run containers */
+	BITSET_ROARING,
+};
+
 /**
  * Bitset
  */
 struct bitset {
 	/** @cond false */
+	enum bitset_type type;
 	bitset_pages_t pages;
+	/** Containers of a roaring bitset sorted by key */
+	struct bitset_container *containers;
+	size_t container_count;
+	size_t container_capacity;
 	size_t cardinality;
 	void *(*realloc)(void *ptr, size_t size);
 	/** @endcond */
@@ -95,6 +117,15 @@ struct bitset {
 void
 bitset_create(struct bitset *bitset, void *(*realloc)(void *ptr, size_t size));
 
+/**
+ * @brief Construct a roaring \a bitset
+ * @param bitset bitset
+ * @param realloc memory allocator to use
+ */
+void
+bitset_create_roaring(struct bitset *bitset,
+		      void *(*realloc)(void *ptr, size_t size));
+
 /**
  * @brief Destruct \a bitset
  * @param bitset bitset
@@ -157,6 +188,10 @@ struct bitset_info {
 	size_t page_total_size;
 	/** A multiplier by which an address of page data is aligned **/
 	size_t page_data_alignment;
+	/** Number of containers of a roaring bitset */
+	size_t containers;
+	/** Total allocated memory (in bytes) */
+	size_t mem_total;
 };
 
 /**
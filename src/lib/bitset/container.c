@@ -0,0 +1,816 @@
+/*
+ * Copyright 2010-2019, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include "container.h"
+#include "page.h"
+
+#include <string.h>
+#include <assert.h>
+
+enum {
+	/** Initial capacity of an array or a run container */
+	BITSET_CONTAINER_MIN_CAPACITY = 4,
+};
+
+size_t
+bitset_bitmap_alloc_size(void)
+{
+	return BITSET_CONTAINER_BITMAP_SIZE + BITSET_PAGE_DATA_ALIGNMENT - 1;
+}
+
+void *
+bitset_bitmap_align(void *ptr)
+{
+	uintptr_t r = (uintptr_t) ptr + BITSET_PAGE_DATA_ALIGNMENT - 1;
+	return (void *) (r & ~((uintptr_t) BITSET_PAGE_DATA_ALIGNMENT - 1));
+}
+
+static inline uint64_t *
+bitset_container_bitmap(const struct bitset_container *c)
+{
+	assert(c->type == BITSET_CONTAINER_BITMAP);
+	return (uint64_t *) bitset_bitmap_align(c->data);
+}
+
+/* {{{ Bitmap helpers */
+
+static inline bool
+bitmap_test(const uint64_t *words, uint32_t pos)
+{
+	return (words[pos / 64] >> (pos % 64)) & 1;
+}
+
+/** Set bits [start, end] */
+static void
+bitmap_set_range(uint64_t *words, uint32_t start, uint32_t end)
+{
+	assert(start <= end && end < BITSET_CONTAINER_BITS);
+	uint32_t first = start / 64, last = end / 64;
+	uint64_t first_mask = UINT64_MAX << (start % 64);
+	uint64_t last_mask = UINT64_MAX >> (63 - end % 64);
+	if (first == last) {
+		words[first] |= first_mask & last_mask;
+		return;
+	}
+	words[first] |= first_mask;
+	for (uint32_t i = first + 1; i < last; i++)
+		words[i] = UINT64_MAX;
+	words[last] |= last_mask;
+}
+
+/** Clear bits [start, end] */
+static void
+bitmap_clear_range(uint64_t *words, uint32_t start, uint32_t end)
+{
+	assert(start <= end && end < BITSET_CONTAINER_BITS);
+	uint32_t first = start / 64, last = end / 64;
+	uint64_t first_mask = UINT64_MAX << (start % 64);
+	uint64_t last_mask = UINT64_MAX >> (63 - end % 64);
+	if (first == last) {
+		words[first] &= ~(first_mask & last_mask);
+		return;
+	}
+	words[first] &= ~first_mask;
+	for (uint32_t i = first + 1; i < last; i++)
+		words[i] = 0;
+	words[last] &= ~last_mask;
+}
+
+/**
+ * Return the first bit not less than \a pos that is equal to
+ * \a value or BITSET_CONTAINER_BITS if there is none.
+ */
+static uint32_t
+bitmap_find(const uint64_t *words, uint32_t pos, bool value)
+{
+	if (pos >= BITSET_CONTAINER_BITS)
+		return BITSET_CONTAINER_BITS;
+	uint64_t flip = value ? 0 : UINT64_MAX;
+	uint32_t i = pos / 64;
+	uint64_t word = (words[i] ^ flip) & (UINT64_MAX << (pos % 64));
+	while (word == 0) {
+		if (++i == BITSET_CONTAINER_WORDS)
+			return BITSET_CONTAINER_BITS;
+		word = words[i] ^ flip;
+	}
+	return i * 64 + __builtin_ctzll(word);
+}
+
+/* }}} */
+
+/* {{{ Run iterator */
+
+/** Iterates over runs of set bits of a container of any type */
+struct bitset_run_iterator {
+	const struct bitset_container *c;
+	/* Next array element, next run or next bitmap bit */
+	uint32_t pos;
+};
+
+static void
+bitset_run_iterator_create(struct bitset_run_iterator *it,
+			   const struct bitset_container *c)
+{
+	it->c = c;
+	it->pos = 0;
+}
+
+/**
+ * Return the next run [*start, *end] or false if there are no
+ * more runs.
+ */
+static bool
+bitset_run_iterator_next(struct bitset_run_iterator *it, uint32_t *start,
+			 uint32_t *end)
+{
+	const struct bitset_container *c = it->c;
+	switch (c->type) {
+	case BITSET_CONTAINER_ARRAY: {
+		const uint16_t *array = (const uint16_t *) c->data;
+		if (it->pos >= c->cardinality)
+			return false;
+		*start = array[it->pos];
+		while (it->pos + 1 < c->cardinality &&
+		       array[it->pos + 1] == array[it->pos] + 1)
+			it->pos++;
+		*end = array[it->pos++];
+		return true;
+	}
+	case BITSET_CONTAINER_RUN: {
+		const struct bitset_run *runs =
+			(const struct bitset_run *) c->data;
+		if (it->pos >= c->n_runs)
+			return false;
+		*start = runs[it->pos].start;
+		*end = runs[it->pos].start + runs[it->pos].length;
+		it->pos++;
+		return true;
+	}
+	case BITSET_CONTAINER_BITMAP: {
+		const uint64_t *words = bitset_container_bitmap(c);
+		uint32_t pos = bitmap_find(words, it->pos, true);
+		if (pos == BITSET_CONTAINER_BITS)
+			return false;
+		*start = pos;
+		it->pos = bitmap_find(words, pos, false);
+		*end = it->pos - 1;
+		return true;
+	}
+	default:
+		unreachable();
+	}
+	return false;
+}
+
+/* }}} */
+
+/* {{{ Conversion */
+
+static size_t
+bitset_container_size(const struct bitset_container *c,
+		      enum bitset_container_type type)
+{
+	switch (type) {
+	case BITSET_CONTAINER_ARRAY:
+		if (c->cardinality > BITSET_CONTAINER_ARRAY_MAX)
+			return SIZE_MAX;
+		return c->cardinality * sizeof(uint16_t);
+	case BITSET_CONTAINER_BITMAP:
+		return BITSET_CONTAINER_BITMAP_SIZE;
+	case BITSET_CONTAINER_RUN:
+		return c->n_runs * sizeof(struct bitset_run);
+	default:
+		unreachable();
+	}
+	return SIZE_MAX;
+}
+
+static int
+bitset_container_convert(struct bitset_container *c,
+			 enum bitset_container_type type,
+			 void *(*realloc)(void *ptr, size_t size))
+{
+	assert(c->type != type);
+	assert(c->cardinality > 0);
+	uint32_t capacity = 0;
+	size_t size;
+	switch (type) {
+	case BITSET_CONTAINER_ARRAY:
+		capacity = c->cardinality;
+		size = capacity * sizeof(uint16_t);
+		break;
+	case BITSET_CONTAINER_BITMAP:
+		size = bitset_bitmap_alloc_size();
+		break;
+	case BITSET_CONTAINER_RUN:
+		capacity = c->n_runs;
+		size = capacity * sizeof(struct bitset_run);
+		break;
+	default:
+		unreachable();
+	}
+	void *data = realloc(NULL, size);
+	if (data == NULL)
+		return -1;
+	uint16_t *array = (uint16_t *) data;
+	uint64_t *words = (uint64_t *) bitset_bitmap_align(data);
+	struct bitset_run *runs = (struct bitset_run *) data;
+	if (type == BITSET_CONTAINER_BITMAP)
+		memset(words, 0, BITSET_CONTAINER_BITMAP_SIZE);
+
+	struct bitset_run_iterator it;
+	bitset_run_iterator_create(&it, c);
+	uint32_t start, end, n = 0;
+	while (bitset_run_iterator_next(&it, &start, &end)) {
+		switch (type) {
+		case BITSET_CONTAINER_ARRAY:
+			for (uint32_t pos = start; pos <= end; pos++)
+				array[n++] = pos;
+			break;
+		case BITSET_CONTAINER_BITMAP:
+			bitmap_set_range(words, start, end);
+			break;
+		case BITSET_CONTAINER_RUN:
+			runs[n].start = start;
+			runs[n].length = end - start;
+			n++;
+			break;
+		}
+	}
+	assert(n == capacity);
+
+	realloc(c->data, 0);
+	c->data = data;
+	c->type = type;
+	c->capacity = capacity;
+	return 0;
+}
+
+/**
+ * Convert a container to the most compact type if it at least
+ * halves its size, so that a container doesn't flip between two
+ * types on every change near the boundary.
+ */
+static void
+bitset_container_optimize(struct bitset_container *c,
+			  void *(*realloc)(void *ptr, size_t size))
+{
+	size_t size = bitset_container_size(c, c->type);
+	enum bitset_container_type best = c->type;
+	size_t best_size = size;
+	for (int type = BITSET_CONTAINER_ARRAY; type <= BITSET_CONTAINER_RUN;
+	     type++) {
+		size_t type_size = bitset_container_size(c, type);
+		if (type_size < best_size) {
+			best = type;
+			best_size = type_size;
+		}
+	}
+	if (best != c->type && best_size * 2 <= size) {
+		/*
+		 * Ignore errors: the container stays valid,
+		 * only less compact.
+		 */
+		bitset_container_convert(c, best, realloc);
+	}
+}
+
+/* }}} */
+
+/* {{{ Array container */
+
+/** Return the first index of an element not less than \a pos */
+static uint32_t
+bitset_array_lower_bound(const uint16_t *array, uint32_t size, uint32_t pos)
+{
+	uint32_t lo = 0, hi = size;
+	while (lo < hi) {
+		uint32_t mid = lo + (hi - lo) / 2;
+		if (array[mid] < pos)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+/**
+ * Same as bitset_array_lower_bound(), but probes 1, 2, 4...
+ * elements ahead first, which is faster when the element is
+ * close to the beginning of the array.
+ */
+static uint32_t
+bitset_array_gallop(const uint16_t *array, uint32_t size, uint32_t pos)
+{
+	if (size == 0 || array[0] >= pos)
+		return 0;
+	/* array[lo] < pos */
+	uint32_t lo = 0, step = 1;
+	while (lo + step < size && array[lo + step] < pos) {
+		lo += step;
+		step *= 2;
+	}
+	uint32_t hi = lo + step < size ? lo + step : size;
+	return lo + 1 + bitset_array_lower_bound(array + lo + 1,
+						 hi - lo - 1, pos);
+}
+
+static bool
+bitset_array_test(const struct bitset_container *c, uint32_t pos)
+{
+	const uint16_t *array = (const uint16_t *) c->data;
+	uint32_t i = bitset_array_lower_bound(array, c->cardinality, pos);
+	return i < c->cardinality && array[i] == pos;
+}
+
+static int
+bitset_array_set(struct bitset_container *c, uint32_t pos,
+		 void *(*realloc)(void *ptr, size_t size))
+{
+	uint16_t *array = (uint16_t *) c->data;
+	uint32_t card = c->cardinality;
+	uint32_t i = bitset_array_lower_bound(array, card, pos);
+	if (i < card && array[i] == pos)
+		return 1;
+	assert(card < BITSET_CONTAINER_ARRAY_MAX);
+	if (card == c->capacity) {
+		uint32_t capacity = c->capacity * 2;
+		if (capacity > BITSET_CONTAINER_ARRAY_MAX)
+			capacity = BITSET_CONTAINER_ARRAY_MAX;
+		array = (uint16_t *) realloc(c->data,
+					     capacity * sizeof(*array));
+		if (array == NULL)
+			return -1;
+		c->data = array;
+		c->capacity = capacity;
+	}
+	bool prev = i > 0 && array[i - 1] + 1 == pos;
+	bool next = i < card && array[i] == pos + 1;
+	memmove(&array[i + 1], &array[i], (card - i) * sizeof(*array));
+	array[i] = pos;
+	c->cardinality++;
+	c->n_runs = c->n_runs + 1 - prev - next;
+	return 0;
+}
+
+static int
+bitset_array_clear(struct bitset_container *c, uint32_t pos)
+{
+	uint16_t *array = (uint16_t *) c->data;
+	uint32_t card = c->cardinality;
+	uint32_t i = bitset_array_lower_bound(array, card, pos);
+	if (i == card || array[i] != pos)
+		return 0;
+	bool prev = i > 0 && array[i - 1] + 1 == pos;
+	bool next = i + 1 < card && array[i + 1] == pos + 1;
+	memmove(&array[i], &array[i + 1], (card - i - 1) * sizeof(*array));
+	c->cardinality--;
+	c->n_runs = c->n_runs + prev + next - 1;
+	return 1;
+}
+
+/* }}} */
+
+/* {{{ Bitmap container */
+
+static int
+bitset_bitmap_set(struct bitset_container *c, uint32_t pos)
+{
+	uint64_t *words = bitset_container_bitmap(c);
+	if (bitmap_test(words, pos))
+		return 1;
+	bool prev = pos > 0 && bitmap_test(words, pos - 1);
+	bool next = pos + 1 < BITSET_CONTAINER_BITS &&
+		    bitmap_test(words, pos + 1);
+	words[pos / 64] |= (uint64_t) 1 << (pos % 64);
+	c->cardinality++;
+	c->n_runs = c->n_runs + 1 - prev - next;
+	return 0;
+}
+
+static int
+bitset_bitmap_clear(struct bitset_container *c, uint32_t pos)
+{
+	uint64_t *words = bitset_container_bitmap(c);
+	if (!bitmap_test(words, pos))
+		return 0;
+	bool prev = pos > 0 && bitmap_test(words, pos - 1);
+	bool next = pos + 1 < BITSET_CONTAINER_BITS &&
+		    bitmap_test(words, pos + 1);
+	words[pos / 64] &= ~((uint64_t) 1 << (pos % 64));
+	c->cardinality--;
+	c->n_runs = c->n_runs + prev + next - 1;
+	return 1;
+}
+
+/* }}} */
+
+/* {{{ Run container */
+
+/** Return the index of the last run starting at or before \a pos */
+static int32_t
+bitset_runs_find(const struct bitset_run *runs, uint32_t n_runs, uint32_t pos)
+{
+	uint32_t lo = 0, hi = n_runs;
+	while (lo < hi) {
+		uint32_t mid = lo + (hi - lo) / 2;
+		if (runs[mid].start <= pos)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return (int32_t) lo - 1;
+}
+
+static bool
+bitset_runs_test(const struct bitset_container *c, uint32_t pos)
+{
+	const struct bitset_run *runs = (const struct bitset_run *) c->data;
+	int32_t i = bitset_runs_find(runs, c->n_runs, pos);
+	return i >= 0 && pos <= (uint32_t) runs[i].start + runs[i].length;
+}
+
+/** Insert a run at index \a i */
+static int
+bitset_runs_insert(struct bitset_container *c, uint32_t i, uint32_t start,
+		   uint32_t length, void *(*realloc)(void *ptr, size_t size))
+{
+	struct bitset_run *runs = (struct bitset_run *) c->data;
+	if (c->n_runs == c->capacity) {
+		uint32_t capacity = c->capacity * 2;
+		runs = (struct bitset_run *) realloc(c->data,
+						     capacity * sizeof(*runs));
+		if (runs == NULL)
+			return -1;
+		c->data = runs;
+		c->capacity = capacity;
+	}
+	memmove(&runs[i + 1], &runs[i], (c->n_runs - i) * sizeof(*runs));
+	runs[i].start = start;
+	runs[i].length = length;
+	c->n_runs++;
+	return 0;
+}
+
+static void
+bitset_runs_remove(struct bitset_container *c, uint32_t i)
+{
+	struct bitset_run *runs = (struct bitset_run *) c->data;
+	memmove(&runs[i], &runs[i + 1], (c->n_runs - i - 1) * sizeof(*runs));
+	c->n_runs--;
+}
+
+static int
+bitset_runs_set(struct bitset_container *c, uint32_t pos,
+		void *(*realloc)(void *ptr, size_t size))
+{
+	struct bitset_run *runs = (struct bitset_run *) c->data;
+	int32_t i = bitset_runs_find(runs, c->n_runs, pos);
+	if (i >= 0 && pos <= (uint32_t) runs[i].start + runs[i].length)
+		return 1;
+	bool prev = i >= 0 &&
+		    (uint32_t) runs[i].start + runs[i].length + 1 == pos;
+	bool next = (uint32_t) (i + 1) < c->n_runs &&
+		    runs[i + 1].start == pos + 1;
+	if (prev && next) {
+		/* Glue the runs around pos. */
+		runs[i].length += runs[i + 1].length + 2;
+		bitset_runs_remove(c, i + 1);
+	} else if (prev) {
+		runs[i].length++;
+	} else if (next) {
+		runs[i + 1].start--;
+		runs[i + 1].length++;
+	} else if (bitset_runs_insert(c, i + 1, pos, 0, realloc) != 0) {
+		return -1;
+	}
+	c->cardinality++;
+	return 0;
+}
+
+static int
+bitset_runs_clear(struct bitset_container *c, uint32_t pos,
+		  void *(*realloc)(void *ptr, size_t size))
+{
+	struct bitset_run *runs = (struct bitset_run *) c->data;
+	int32_t i = bitset_runs_find(runs, c->n_runs, pos);
+	if (i < 0 || pos > (uint32_t) runs[i].start + runs[i].length)
+		return 0;
+	uint32_t start = runs[i].start;
+	uint32_t end = start + runs[i].length;
+	if (start == end) {
+		bitset_runs_remove(c, i);
+	} else if (pos == start) {
+		runs[i].start++;
+		runs[i].length--;
+	} else if (pos == end) {
+		runs[i].length--;
+	} else {
+		/* Split the run in two. */
+		if (bitset_runs_insert(c, i + 1, pos + 1, end - pos - 1,
+				       realloc) != 0)
+			return -1;
+		runs = (struct bitset_run *) c->data;
+		runs[i].length = pos - 1 - start;
+	}
+	c->cardinality--;
+	return 1;
+}
+
+/* }}} */
+
+/* {{{ Public methods */
+
+size_t
+bitset_container_lower_bound(const struct bitset *bitset, size_t key)
+{
+	size_t lo = 0, hi = bitset->container_count;
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+		if (bitset->containers[mid].key < key)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+struct bitset_container *
+bitset_container_find(const struct bitset *bitset, size_t key)
+{
+	size_t i = bitset_container_lower_bound(bitset, key);
+	if (i == bitset->container_count || bitset->containers[i].key != key)
+		return NULL;
+	return &bitset->containers[i];
+}
+
+int
+bitset_container_create(struct bitset_container *c, size_t key,
+			void *(*realloc)(void *ptr, size_t size))
+{
+	c->data = realloc(NULL, BITSET_CONTAINER_MIN_CAPACITY *
+			  sizeof(uint16_t));
+	if (c->data == NULL)
+		return -1;
+	c->key = key;
+	c->cardinality = 0;
+	c->n_runs = 0;
+	c->capacity = BITSET_CONTAINER_MIN_CAPACITY;
+	c->type = BITSET_CONTAINER_ARRAY;
+	return 0;
+}
+
+void
+bitset_container_destroy(struct bitset_container *c,
+			 void *(*realloc)(void *ptr, size_t size))
+{
+	realloc(c->data, 0);
+	c->data = NULL;
+}
+
+bool
+bitset_container_test(const struct bitset_container *c, uint32_t pos)
+{
+	assert(pos < BITSET_CONTAINER_BITS);
+	switch (c->type) {
+	case BITSET_CONTAINER_ARRAY:
+		return bitset_array_test(c, pos);
+	case BITSET_CONTAINER_BITMAP:
+		return bitmap_test(bitset_container_bitmap(c), pos);
+	case BITSET_CONTAINER_RUN:
+		return bitset_runs_test(c, pos);
+	default:
+		unreachable();
+	}
+	return false;
+}
+
+int
+bitset_container_set(struct bitset_container *c, uint32_t pos,
+		     void *(*realloc)(void *ptr, size_t size))
+{
+	assert(pos < BITSET_CONTAINER_BITS);
+	if (c->type == BITSET_CONTAINER_ARRAY &&
+	    c->cardinality == BITSET_CONTAINER_ARRAY_MAX) {
+		if (bitset_array_test(c, pos))
+			return 1;
+		if (bitset_container_convert(c, BITSET_CONTAINER_BITMAP,
+					     realloc) != 0)
+			return -1;
+	}
+	int rc;
+	switch (c->type) {
+	case BITSET_CONTAINER_ARRAY:
+		rc = bitset_array_set(c, pos, realloc);
+		break;
+	case BITSET_CONTAINER_BITMAP:
+		rc = bitset_bitmap_set(c, pos);
+		break;
+	case BITSET_CONTAINER_RUN:
+		rc = bitset_runs_set(c, pos, realloc);
+		break;
+	default:
+		unreachable();
+	}
+	if (rc == 0)
+		bitset_container_optimize(c, realloc);
+	return rc;
+}
+
+int
+bitset_container_clear(struct bitset_container *c, uint32_t pos,
+		       void *(*realloc)(void *ptr, size_t size))
+{
+	assert(pos < BITSET_CONTAINER_BITS);
+	int rc;
+	switch (c->type) {
+	case BITSET_CONTAINER_ARRAY:
+		rc = bitset_array_clear(c, pos);
+		break;
+	case BITSET_CONTAINER_BITMAP:
+		rc = bitset_bitmap_clear(c, pos);
+		break;
+	case BITSET_CONTAINER_RUN:
+		rc = bitset_runs_clear(c, pos, realloc);
+		break;
+	default:
+		unreachable();
+	}
+	if (rc == 1 && c->cardinality > 0)
+		bitset_container_optimize(c, realloc);
+	return rc;
+}
+
+size_t
+bitset_container_alloc_size(const struct bitset_container *c)
+{
+	switch (c->type) {
+	case BITSET_CONTAINER_ARRAY:
+		return c->capacity * sizeof(uint16_t);
+	case BITSET_CONTAINER_BITMAP:
+		return bitset_bitmap_alloc_size();
+	case BITSET_CONTAINER_RUN:
+		return c->capacity * sizeof(struct bitset_run);
+	default:
+		unreachable();
+	}
+	return 0;
+}
+
+uint32_t
+bitset_container_to_array(const struct bitset_container *c, uint16_t *dst)
+{
+	assert(c->type == BITSET_CONTAINER_ARRAY);
+	memcpy(dst, c->data, c->cardinality * sizeof(uint16_t));
+	return c->cardinality;
+}
+
+uint32_t
+bitset_container_filter(const struct bitset_container *c, uint16_t *pos,
+			uint32_t count, bool is_negated)
+{
+	uint32_t n = 0;
+	switch (c->type) {
+	case BITSET_CONTAINER_ARRAY: {
+		/* Both arrays are sorted, merge them. */
+		const uint16_t *array = (const uint16_t *) c->data;
+		uint32_t j = 0;
+		for (uint32_t i = 0; i < count; i++) {
+			j += bitset_array_gallop(array + j,
+						 c->cardinality - j, pos[i]);
+			bool is_set = j < c->cardinality && array[j] == pos[i];
+			if (is_set != is_negated)
+				pos[n++] = pos[i];
+		}
+		break;
+	}
+	case BITSET_CONTAINER_BITMAP: {
+		const uint64_t *words = bitset_container_bitmap(c);
+		for (uint32_t i = 0; i < count; i++) {
+			if (bitmap_test(words, pos[i]) != is_negated)
+				pos[n++] = pos[i];
+		}
+		break;
+	}
+	case BITSET_CONTAINER_RUN: {
+		const struct bitset_run *runs =
+			(const struct bitset_run *) c->data;
+		uint32_t j = 0;
+		for (uint32_t i = 0; i < count; i++) {
+			while (j < c->n_runs &&
+			       runs[j].start + runs[j].length < pos[i])
+				j++;
+			bool is_set = j < c->n_runs && runs[j].start <= pos[i];
+			if (is_set != is_negated)
+				pos[n++] = pos[i];
+		}
+		break;
+	}
+	default:
+		unreachable();
+	}
+	return n;
+}
+
+/*
+ * Bitmap containers are combined with the destination word by
+ * word using bitset_word_t, which is a SIMD vector type when
+ * the bitset library is built with SSE2 or AVX. Array and run
+ * containers are applied as ranges of set bits.
+ */
+
+void
+bitset_container_and(void *dst, const struct bitset_container *c)
+{
+	if (c->type == BITSET_CONTAINER_BITMAP) {
+		bitset_word_t *d = (bitset_word_t *) dst;
+		const bitset_word_t *s =
+			(const bitset_word_t *) bitset_container_bitmap(c);
+		for (size_t i = 0; i < BITSET_CONTAINER_BITMAP_SIZE /
+				       sizeof(bitset_word_t); i++)
+			d[i] &= s[i];
+		return;
+	}
+	/* Clear the gaps between runs. */
+	uint64_t *words = (uint64_t *) dst;
+	struct bitset_run_iterator it;
+	bitset_run_iterator_create(&it, c);
+	uint32_t start, end, pos = 0;
+	while (bitset_run_iterator_next(&it, &start, &end)) {
+		if (start > pos)
+			bitmap_clear_range(words, pos, start - 1);
+		pos = end + 1;
+	}
+	if (pos < BITSET_CONTAINER_BITS)
+		bitmap_clear_range(words, pos, BITSET_CONTAINER_BITS - 1);
+}
+
+void
+bitset_container_nand(void *dst, const struct bitset_container *c)
+{
+	if (c->type == BITSET_CONTAINER_BITMAP) {
+		bitset_word_t *d = (bitset_word_t *) dst;
+		const bitset_word_t *s =
+			(const bitset_word_t *) bitset_container_bitmap(c);
+		for (size_t i = 0; i < BITSET_CONTAINER_BITMAP_SIZE /
+				       sizeof(bitset_word_t); i++)
+			d[i] &= ~s[i];
+		return;
+	}
+	uint64_t *words = (uint64_t *) dst;
+	struct bitset_run_iterator it;
+	bitset_run_iterator_create(&it, c);
+	uint32_t start, end;
+	while (bitset_run_iterator_next(&it, &start, &end))
+		bitmap_clear_range(words, start, end);
+}
+
+void
+bitset_container_or(void *dst, const struct bitset_container *c)
+{
+	if (c->type == BITSET_CONTAINER_BITMAP) {
+		bitset_word_t *d = (bitset_word_t *) dst;
+		const bitset_word_t *s =
+			(const bitset_word_t *) bitset_container_bitmap(c);
+		for (size_t i = 0; i < BITSET_CONTAINER_BITMAP_SIZE /
+				       sizeof(bitset_word_t); i++)
+			d[i] |= s[i];
+		return;
+	}
+	uint64_t *words = (uint64_t *) dst;
+	struct bitset_run_iterator it;
+	bitset_run_iterator_create(&it, c);
+	uint32_t start, end;
+	while (bitset_run_iterator_next(&it, &start, &end))
+		bitmap_set_range(words, start, end);
+}
+
+/* }}} */
@@ -0,0 +1,223 @@
+#ifndef TARANTOOL_LIB_BITSET_CONTAINER_H_INCLUDED
+#define TARANTOOL_LIB_BITSET_CONTAINER_H_INCLUDED
+/*
+ * Copyright 2010-2019, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ * @brief Containers of a roaring bitset
+ *
+ * A roaring bitset splits positions into chunks of
+ * BITSET_CONTAINER_BITS bits and stores each non-empty chunk in
+ * a container of one of three kinds: a sorted array of positions,
+ * a plain bitmap or a sorted list of runs of consecutive set bits.
+ * A container is converted to another kind when that one becomes
+ * at least twice as compact.
+ *
+ * Private header file, please don't use directly.
+ * @internal
+ */
+
+#include "bitset/bitset.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+enum {
+	/** Number of positions covered by one container */
+	BITSET_CONTAINER_BITS = 1 << 16,
+	/** Size of a bitmap container data (in bytes) */
+	BITSET_CONTAINER_BITMAP_SIZE = BITSET_CONTAINER_BITS / CHAR_BIT,
+	/** Number of 64-bit words in a bitmap */
+	BITSET_CONTAINER_WORDS = BITSET_CONTAINER_BITS / 64,
+	/** Maximal cardinality of an array container */
+	BITSET_CONTAINER_ARRAY_MAX = 4096,
+};
+
+enum bitset_container_type {
+	/** Sorted array of uint16_t positions */
+	BITSET_CONTAINER_ARRAY,
+	/** Bitmap of BITSET_CONTAINER_BITS bits */
+	BITSET_CONTAINER_BITMAP,
+	/** Sorted array of struct bitset_run */
+	BITSET_CONTAINER_RUN,
+};
+
+/** Run of consecutive set bits */
+struct bitset_run {
+	/** The first bit of the run */
+	uint16_t start;
+	/** Number of bits in the run minus one */
+	uint16_t length;
+};
+
+struct bitset_container {
+	/** Position of the first bit divided by BITSET_CONTAINER_BITS */
+	size_t key;
+	/** Number of set bits, from 1 to BITSET_CONTAINER_BITS */
+	uint32_t cardinality;
+	/** Number of runs of consecutive set bits */
+	uint32_t n_runs;
+	/** Number of allocated array or run container elements */
+	uint32_t capacity;
+	/** enum bitset_container_type */
+	uint32_t type;
+	/** Array, bitmap or run data, see bitset_container_bitmap() */
+	void *data;
+};
+
+/**
+ * @brief Return the index of the first container of \a bitset
+ * with key not less than \a key (container_count if none)
+ */
+size_t
+bitset_container_lower_bound(const struct bitset *bitset, size_t key);
+
+/**
+ * @brief Find the container of \a bitset with key \a key
+ * @retval NULL if the container does not exist
+ */
+struct bitset_container *
+bitset_container_find(const struct bitset *bitset, size_t key);
+
+/**
+ * @brief Construct an empty array container
+ * @retval 0 on success
+ * @retval -1 on memory error
+ */
+int
+bitset_container_create(struct bitset_container *c, size_t key,
+			void *(*realloc)(void *ptr, size_t size));
+
+/**
+ * @brief Destruct \a c
+ */
+void
+bitset_container_destroy(struct bitset_container *c,
+			 void *(*realloc)(void *ptr, size_t size));
+
+/**
+ * @brief Test bit \a pos (relative to the container) in \a c
+ */
+bool
+bitset_container_test(const struct bitset_container *c, uint32_t pos);
+
+/**
+ * @brief Set bit \a pos in \a c
+ * @retval 1 if the bit was already set
+ * @retval 0 if the bit was not set
+ * @retval -1 on memory error, \a c is unchanged
+ */
+int
+bitset_container_set(struct bitset_container *c, uint32_t pos,
+		     void *(*realloc)(void *ptr, size_t size));
+
+/**
+ * @brief Clear bit \a pos in \a c
+ * @retval 1 if the bit was set
+ * @retval 0 if the bit was not set
+ * @retval -1 on memory error, \a c is unchanged
+ */
+int
+bitset_container_clear(struct bitset_container *c, uint32_t pos,
+		       void *(*realloc)(void *ptr, size_t size));
+
+/**
+ * @brief Return the size of memory allocated for \a c data
+ */
+size_t
+bitset_container_alloc_size(const struct bitset_container *c);
+
+/*
+ * The functions below evaluate expressions on sparse containers
+ * as sorted arrays of positions, which is cheaper than building
+ * a bitmap when an array container takes part in a conjunction.
+ */
+
+/**
+ * @brief Copy positions of an array container \a c to \a dst,
+ * which must have room for BITSET_CONTAINER_ARRAY_MAX of them
+ * @return the number of positions copied
+ */
+uint32_t
+bitset_container_to_array(const struct bitset_container *c, uint16_t *dst);
+
+/**
+ * @brief Keep those of \a count sorted positions \a pos which are
+ * set in \a c, or those which are not set if \a is_negated
+ * @return the number of positions kept
+ */
+uint32_t
+bitset_container_filter(const struct bitset_container *c, uint16_t *pos,
+			uint32_t count, bool is_negated);
+
+/*
+ * The functions below combine a container with a bitmap \a dst
+ * of BITSET_CONTAINER_BITMAP_SIZE bytes aligned to
+ * BITSET_PAGE_DATA_ALIGNMENT, used to evaluate expressions.
+ */
+
+/** dst &= c */
+void
+bitset_container_and(void *dst, const struct bitset_container *c);
+
+/** dst &= ~c */
+void
+bitset_container_nand(void *dst, const struct bitset_container *c);
+
+/** dst |= c */
+void
+bitset_container_or(void *dst, const struct bitset_container *c);
+
+/**
+ * @brief Return size of a bitmap allocation that leaves room to
+ * align the bitmap, see bitset_bitmap_align()
+ */
+size_t
+bitset_bitmap_alloc_size(void);
+
+/**
+ * @brief Align a pointer returned by allocation of
+ * bitset_bitmap_alloc_size() bytes
+ */
+void *
+bitset_bitmap_align(void *ptr);
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
+
+#endif /* TARANTOOL_LIB_BITSET_CONTAINER_H_INCLUDED */
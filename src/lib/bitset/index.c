@@ -47,6 +47,14 @@ bitset_index_create(struct bitset_index *index,
 	index->realloc = realloc;
 }
 
+void
+bitset_index_create_roaring(struct bitset_index *index,
+			    void *(*realloc)(void *ptr, size_t size))
+{
+	bitset_index_create(index, realloc);
+	index->type = BITSET_ROARING;
+}
+
 void
 bitset_index_destroy(struct bitset_index *index)
 {
@@ -108,7 +116,11 @@ bitset_index_reserve(struct bitset_index *index, size_t size)
 		if (index->bitsets[b] == NULL)
 			goto error_2;
 
-		bitset_create(index->bitsets[b], index->realloc);
+		if (index->type == BITSET_ROARING)
+			bitset_create_roaring(index->bitsets[b],
+					      index->realloc);
+		else
+			bitset_create(index->bitsets[b], index->realloc);
 	}
 
 	index->capacity = capacity;
@@ -384,7 +396,7 @@ bitset_index_bsize(const struct bitset_index *index)
 			continue;
 		struct bitset_info info;
 		bitset_info(index->bitsets[b], &info);
-		result += info.page_total_size * info.pages;
+		result += info.mem_total;
 	}
 	return result;
 }
@@ -133,6 +133,8 @@ struct bitset_index {
 	void *(*realloc)(void *ptr, size_t size);
 	/* A buffer used for rollback changes in bitset_insert */
 	char *rollback_buf;
+	/* Type of used bitsets */
+	enum bitset_type type;
 	/** @endcond **/
 };
 
@@ -145,6 +147,16 @@ void
 bitset_index_create(struct bitset_index *index,
 		    void *(*realloc)(void *ptr, size_t size));
 
+/**
+ * @brief Construct \a index storing values in roaring bitsets
+ * @param index bitset index
+ * @param realloc memory allocator to use
+ * @see bitset_create_roaring
+ */
+void
+bitset_index_create_roaring(struct bitset_index *index,
+			    void *(*realloc)(void *ptr, size_t size));
+
 /**
  * @brief Destruct \a index
  * @param index bitset index
@@ -32,6 +32,7 @@
 #include "bitset/iterator.h"
 #include "bitset/expr.h"
 #include "page.h"
+#include "container.h"
 
 #include <assert.h>
 
@@ -39,6 +40,7 @@ const size_t ITERATOR_DEFAULT_CAPACITY = 2;
 const size_t ITERATOR_CONJ_DEFAULT_CAPACITY = 32;
 
 struct bitset_iterator_conj {
+	/** The first position of the current page or window */
 	size_t page_first_pos;
 	size_t size;
 	size_t capacity;
@@ -91,6 +93,13 @@ bitset_iterator_destroy(struct bitset_iterator *it)
 		it->realloc(it->page_tmp, 0);
 	}
 
+	if (it->window != NULL)
+		it->realloc(it->window, 0);
+	if (it->window_tmp != NULL)
+		it->realloc(it->window_tmp, 0);
+	if (it->window_buf != NULL)
+		it->realloc(it->window_buf, 0);
+
 	memset(it, 0, sizeof(*it));
 }
 
@@ -202,6 +211,27 @@ bitset_iterator_init(struct bitset_iterator *it, struct bitset_expr *expr,
 
 	bitset_page_create(it->page_tmp);
 
+	it->type = bitsets_size > 0 ? p_bitsets[0]->type : BITSET_PAGED;
+	it->window_array = NULL;
+	if (it->type == BITSET_ROARING) {
+		size_t window_alloc_size = bitset_bitmap_alloc_size();
+		if (it->window == NULL) {
+			it->window = it->realloc(NULL, window_alloc_size);
+			if (it->window == NULL)
+				return -1;
+		}
+		if (it->window_tmp == NULL) {
+			it->window_tmp = it->realloc(NULL, window_alloc_size);
+			if (it->window_tmp == NULL)
+				return -1;
+		}
+		if (it->window_buf == NULL) {
+			it->window_buf = it->realloc(NULL, window_alloc_size);
+			if (it->window_buf == NULL)
+				return -1;
+		}
+	}
+
 	if (bitset_iterator_reserve(it, expr->size) != 0)
 		return -1;
 
@@ -216,6 +246,8 @@ bitset_iterator_init(struct bitset_iterator *it, struct bitset_expr *expr,
 		for (size_t b = 0; b < exconj->size; b++) {
 			assert(exconj->bitset_ids[b] < bitsets_size);
 			assert(p_bitsets[exconj->bitset_ids[b]] != NULL);
+			assert(p_bitsets[exconj->bitset_ids[b]]->type ==
+			       it->type);
 			itconj->bitsets[b] = p_bitsets[exconj->bitset_ids[b]];
 			itconj->pre_nots[b] = exconj->pre_nots[b];
 			itconj->pages[b] = NULL;
@@ -231,11 +263,45 @@ bitset_iterator_init(struct bitset_iterator *it, struct bitset_expr *expr,
 	return 0;
 }
 
+/**
+ * Rewind a conjunction of roaring bitsets to the first window
+ * not less than \a pos where all non-negated bitsets have
+ * containers.
+ */
+static void
+bitset_iterator_conj_rewind_roaring(struct bitset_iterator_conj *conj,
+				    size_t pos)
+{
+	assert(pos % BITSET_CONTAINER_BITS == 0);
+	size_t key = pos / BITSET_CONTAINER_BITS;
+
+	restart:
+	for (size_t b = 0; b < conj->size; b++) {
+		if (conj->pre_nots[b])
+			continue;
+
+		const struct bitset *bitset = conj->bitsets[b];
+		size_t i = bitset_container_lower_bound(bitset, key);
+		/* bitset b does not have more containers */
+		if (i == bitset->container_count) {
+			conj->page_first_pos = SIZE_MAX;
+			return;
+		}
+
+		/* bitset b have a next container, but it is beyond key */
+		if (bitset->containers[i].key > key) {
+			key = bitset->containers[i].key;
+			goto restart;
+		}
+	}
+
+	conj->page_first_pos = key * BITSET_CONTAINER_BITS;
+}
+
 static void
 bitset_iterator_conj_rewind(struct bitset_iterator_conj *conj, size_t pos)
 {
 	assert(conj != NULL);
-	assert(pos % (BITSET_PAGE_DATA_SIZE * CHAR_BIT) == 0);
 	assert(conj->page_first_pos <= pos);
 
 	if (conj->size == 0) {
@@ -243,6 +309,12 @@ bitset_iterator_conj_rewind(struct bitset_iterator_conj *conj, size_t pos)
 		return;
 	}
 
+	if (conj->bitsets[0]->type == BITSET_ROARING) {
+		bitset_iterator_conj_rewind_roaring(conj, pos);
+		return;
+	}
+	assert(pos % (BITSET_PAGE_DATA_SIZE * CHAR_BIT) == 0);
+
 	struct bitset_page key;
 	key.first_pos = pos;
 
@@ -329,9 +401,205 @@ bitset_iterator_conj_prepare_page(struct bitset_iterator_conj *conj,
 	}
 }
 
+static void
+bitset_iterator_conj_prepare_window(struct bitset_iterator_conj *conj,
+				    void *dst)
+{
+	assert(conj->size > 0);
+	assert(conj->page_first_pos != SIZE_MAX);
+
+	size_t key = conj->page_first_pos / BITSET_CONTAINER_BITS;
+	memset(dst, 0xff, BITSET_CONTAINER_BITMAP_SIZE);
+	for (size_t b = 0; b < conj->size; b++) {
+		struct bitset_container *c =
+			bitset_container_find(conj->bitsets[b], key);
+		if (!conj->pre_nots[b]) {
+			/* the conjunction is rewinded to the container */
+			assert(c != NULL);
+			bitset_container_and(dst, c);
+		} else if (c != NULL) {
+			/* NAND(a, zeros) => a, skip missing containers */
+			bitset_container_nand(dst, c);
+		}
+	}
+}
+
+/**
+ * Evaluate a conjunction in the current window as a sorted array
+ * of positions. The result is a subset of any non-negated array
+ * container, so it is cheaper to check the positions of the
+ * smallest one against the other containers than to build a
+ * bitmap.
+ * @retval -1 no non-negated array container, build a bitmap
+ * @return the number of positions stored in \a dst
+ */
+static int
+bitset_iterator_conj_prepare_array(struct bitset_iterator_conj *conj,
+				   uint16_t *dst)
+{
+	assert(conj->size > 0);
+	assert(conj->page_first_pos != SIZE_MAX);
+
+	size_t key = conj->page_first_pos / BITSET_CONTAINER_BITS;
+	const struct bitset_container *base = NULL;
+	size_t base_b = 0;
+	for (size_t b = 0; b < conj->size; b++) {
+		if (conj->pre_nots[b])
+			continue;
+		const struct bitset_container *c =
+			bitset_container_find(conj->bitsets[b], key);
+		assert(c != NULL);
+		if (c->type == BITSET_CONTAINER_ARRAY &&
+		    (base == NULL || c->cardinality < base->cardinality)) {
+			base = c;
+			base_b = b;
+		}
+	}
+	if (base == NULL)
+		return -1;
+
+	uint32_t count = bitset_container_to_array(base, dst);
+	for (size_t b = 0; b < conj->size && count > 0; b++) {
+		if (b == base_b)
+			continue;
+		const struct bitset_container *c =
+			bitset_container_find(conj->bitsets[b], key);
+		/* NAND(a, zeros) => a, skip missing containers */
+		if (c == NULL)
+			continue;
+		count = bitset_container_filter(c, dst, count,
+						conj->pre_nots[b]);
+	}
+	return count;
+}
+
+/** Merge sorted arrays \a a and \a b into \a dst, skip duplicates */
+static uint32_t
+bitset_array_union(const uint16_t *a, uint32_t a_size,
+		   const uint16_t *b, uint32_t b_size, uint16_t *dst)
+{
+	uint32_t i = 0, j = 0, n = 0;
+	while (i < a_size && j < b_size) {
+		if (a[i] < b[j]) {
+			dst[n++] = a[i++];
+		} else if (a[i] > b[j]) {
+			dst[n++] = b[j++];
+		} else {
+			dst[n++] = a[i++];
+			j++;
+		}
+	}
+	while (i < a_size)
+		dst[n++] = a[i++];
+	while (j < b_size)
+		dst[n++] = b[j++];
+	return n;
+}
+
+static void
+bitset_iterator_prepare_window(struct bitset_iterator *it)
+{
+	qsort(it->conjs, it->size, sizeof(*it->conjs),
+	      bitset_iterator_conj_cmp);
+
+	it->window_array = NULL;
+	it->window_size = 0;
+	it->window_idx = 0;
+	if (it->size > 0) {
+		it->window_first_pos = it->conjs[0].page_first_pos;
+	} else {
+		it->window_first_pos = SIZE_MAX;
+	}
+
+	/* There is no more conjunctions that can be ORed */
+	if (it->window_first_pos == SIZE_MAX)
+		return;
+
+	/*
+	 * Try to get the window as a sorted array of positions
+	 * first. Fall back on a bitmap if a conjunction has no
+	 * array container or the union doesn't fit an array.
+	 */
+	uint16_t *array = bitset_bitmap_align(it->window);
+	uint16_t *tmp = bitset_bitmap_align(it->window_tmp);
+	uint16_t *buf = bitset_bitmap_align(it->window_buf);
+	uint32_t size = 0;
+	int count = -1;
+	size_t c = 0;
+	/* For each conj where conj->page_first_pos == pos */
+	for (; c < it->size; c++) {
+		if (it->conjs[c].page_first_pos > it->window_first_pos)
+			break;
+		count = bitset_iterator_conj_prepare_array(&it->conjs[c],
+							   tmp);
+		if (count < 0 ||
+		    size + count > BITSET_CONTAINER_ARRAY_MAX)
+			break;
+		uint16_t *swap = array;
+		if (size == 0) {
+			array = tmp;
+			tmp = swap;
+			size = count;
+		} else {
+			size = bitset_array_union(array, size, tmp, count,
+						  buf);
+			array = buf;
+			buf = swap;
+		}
+		count = -1;
+	}
+	if (c == it->size ||
+	    it->conjs[c].page_first_pos > it->window_first_pos) {
+		it->window_array = array;
+		it->window_size = size;
+		return;
+	}
+
+	/*
+	 * Build a bitmap of the positions found so far and OR the
+	 * rest of conjunctions to it. The positions of the one
+	 * which didn't fit the array are in tmp.
+	 */
+	uint64_t *window = (uint64_t *) buf;
+	memset(window, 0, BITSET_CONTAINER_BITMAP_SIZE);
+	for (uint32_t i = 0; i < size; i++)
+		window[array[i] / 64] |= 1ULL << (array[i] % 64);
+	/* array isn't needed anymore, use it as scratch */
+	bitset_word_t *window_tmp = (bitset_word_t *) array;
+	for (; c < it->size; c++) {
+		if (it->conjs[c].page_first_pos > it->window_first_pos)
+			break;
+		if (count < 0) {
+			count = bitset_iterator_conj_prepare_array(
+				&it->conjs[c], tmp);
+		}
+		if (count >= 0) {
+			for (int i = 0; i < count; i++)
+				window[tmp[i] / 64] |= 1ULL << (tmp[i] % 64);
+		} else {
+			bitset_iterator_conj_prepare_window(&it->conjs[c],
+							    window_tmp);
+			bitset_word_t *dst = (bitset_word_t *) window;
+			for (size_t i = 0; i < BITSET_CONTAINER_BITMAP_SIZE /
+					       sizeof(bitset_word_t); i++)
+				dst[i] |= window_tmp[i];
+		}
+		count = -1;
+	}
+
+	/* Init the bit iterator on the window bitmap */
+	bit_iterator_init(&it->page_it, window, BITSET_CONTAINER_BITMAP_SIZE,
+			  true);
+}
+
 static void
 bitset_iterator_prepare_page(struct bitset_iterator *it)
 {
+	if (it->type == BITSET_ROARING) {
+		bitset_iterator_prepare_window(it);
+		return;
+	}
+
 	qsort(it->conjs, it->size, sizeof(*it->conjs),
 	      bitset_iterator_conj_cmp);
 
@@ -383,6 +651,10 @@ bitset_iterator_next_page(struct bitset_iterator *it)
 
 	size_t PAGE_BIT = BITSET_PAGE_DATA_SIZE * CHAR_BIT;
 	size_t pos = it->page->first_pos;
+	if (it->type == BITSET_ROARING) {
+		PAGE_BIT = BITSET_CONTAINER_BITS;
+		pos = it->window_first_pos;
+	}
 
 	/* Rewind all conjunctions that at the current position to the
 	 * next position */
@@ -414,12 +686,20 @@ bitset_iterator_next(struct bitset_iterator *it)
 	assert(it != NULL);
 
 	while (true) {
-		if (it->page->first_pos == SIZE_MAX)
+		size_t first_pos = it->type == BITSET_ROARING ?
+				   it->window_first_pos :
+				   it->page->first_pos;
+		if (first_pos == SIZE_MAX)
 			return SIZE_MAX;
 
-		size_t pos = bit_iterator_next(&it->page_it);
-		if (pos != SIZE_MAX) {
-			return it->page->first_pos + pos;
+		if (it->window_array != NULL) {
+			if (it->window_idx < it->window_size)
+				return first_pos +
+				       it->window_array[it->window_idx++];
+		} else {
+			size_t pos = bit_iterator_next(&it->page_it);
+			if (pos != SIZE_MAX)
+				return first_pos + pos;
 		}
 
 		bitset_iterator_next_page(it);
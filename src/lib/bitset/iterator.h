@@ -69,6 +69,26 @@ struct bitset_iterator {
 	struct bitset_iterator_conj *conjs;
 	struct bitset_page *page;
 	struct bitset_page *page_tmp;
+	/** Type of iterated bitsets */
+	enum bitset_type type;
+	/**
+	 * Scratch buffers of roaring bitsets, each holds either
+	 * a bitmap or a sorted array of positions of a window.
+	 */
+	void *window;
+	void *window_tmp;
+	void *window_buf;
+	/** The first position of the window, SIZE_MAX at the end */
+	size_t window_first_pos;
+	/**
+	 * Sorted positions of the window, NULL if the window is
+	 * a bitmap iterated with page_it.
+	 */
+	const uint16_t *window_array;
+	/** Number of positions in window_array */
+	uint32_t window_size;
+	/** Next position to return from window_array */
+	uint32_t window_idx;
 	void *(*realloc)(void *ptr, size_t size);
 	struct bit_iterator page_it;
 	/** @endcond **/
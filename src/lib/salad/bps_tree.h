@@ -136,11 +136,15 @@
  *                      alloc_ctx);
  * void bps_tree_destroy(tree);
  * int bps_tree_build(tree, sorted_array, array_size);
+ * void bps_tree_builder_create(builder, tree, fill_factor);
+ * int bps_tree_builder_append(builder, elem);
+ * int bps_tree_builder_finish(builder);
  * bps_tree_elem_t *bps_tree_find(tree, key);
  * int bps_tree_insert(tree, new_elem, replaced_elem);
  * int bps_tree_insert_get_iterator(tree, new_elem, replaced_elem,
  * 				    inserted_iterator)
  * int bps_tree_delete(tree, elem);
+ * int bps_tree_delete_value(tree, elem, deleted_elem);
  * size_t bps_tree_size(tree);
  * size_t bps_tree_mem_used(tree);
  * bps_tree_elem_t *bps_tree_random(tree, rnd);
@@ -342,16 +346,21 @@ typedef uint32_t bps_tree_block_id_t;
 #define bps_inner _bps(inner)
 #define bps_garbage _bps(garbage)
 #define bps_tree_iterator _api_name(iterator)
+#define bps_tree_builder _api_name(builder)
 #define bps_inner_path_elem _bps(inner_path_elem)
 #define bps_leaf_path_elem _bps(leaf_path_elem)
 
 #define bps_tree_create _api_name(create)
 #define bps_tree_build _api_name(build)
+#define bps_tree_builder_create _api_name(builder_create)
+#define bps_tree_builder_append _api_name(builder_append)
+#define bps_tree_builder_finish _api_name(builder_finish)
 #define bps_tree_destroy _api_name(destroy)
 #define bps_tree_find _api_name(find)
 #define bps_tree_insert _api_name(insert)
 #define bps_tree_insert_get_iterator _api_name(insert_get_iterator)
 #define bps_tree_delete _api_name(delete)
+#define bps_tree_delete_value _api_name(delete_value)
 #define bps_tree_size _api_name(size)
 #define bps_tree_mem_used _api_name(mem_used)
 #define bps_tree_random _api_name(random)
@@ -393,6 +402,9 @@ typedef uint32_t bps_tree_block_id_t;
 #define bps_tree_find_after_ins_point_key _bps_tree(find_after_ins_point_key)
 #define bps_tree_find_after_ins_point_elem _bps_tree(find_after_ins_point_elem)
 #define bps_tree_get_leaf_safe _bps_tree(get_leaf_safe)
+#define bps_tree_build_reset _bps_tree(build_reset)
+#define bps_tree_build_inner_levels _bps_tree(build_inner_levels)
+#define bps_tree_builder_balance_tail _bps_tree(builder_balance_tail)
 #define bps_tree_garbage_push _bps_tree(garbage_push)
 #define bps_tree_garbage_pop _bps_tree(garbage_pop)
 #define bps_tree_create_leaf _bps_tree(create_leaf)
@@ -583,6 +595,47 @@ static inline int
 bps_tree_build(struct bps_tree *tree, bps_tree_elem_t *sorted_array,
 	       size_t array_size);
 
+struct bps_tree_builder;
+
+/**
+ * @brief Start filling a new (asserted) tree with elements coming
+ *  in ascending order one by one. Unlike bps_tree_build() it
+ *  doesn't need all the elements in an array beforehand.
+ *  Leaves are filled up to the given share of their capacity to
+ *  leave room for later insertions; the share is clamped to
+ *  [2/3, 1], the range the tree keeps leaves in.
+ * @param builder - builder state
+ * @param tree - pointer to an empty tree
+ * @param fill_factor - share of leaf capacity to fill
+ */
+static inline void
+bps_tree_builder_create(struct bps_tree_builder *builder,
+			struct bps_tree *tree, double fill_factor);
+
+/**
+ * @brief Append an element to a tree being built. The element
+ *  must be greater than all the elements appended before, this
+ *  is not checked! The tree must not be used until
+ *  bps_tree_builder_finish() is called.
+ * @param builder - builder state
+ * @param elem - element to append
+ * @return 0 on success, -1 on memory error; the tree is left
+ *  empty in this case
+ */
+static inline int
+bps_tree_builder_append(struct bps_tree_builder *builder,
+			bps_tree_elem_t elem);
+
+/**
+ * @brief Complete building a tree: even out the last leaves and
+ *  build inner blocks over the leaves.
+ * @param builder - builder state
+ * @return 0 on success, -1 on memory error; the tree is left
+ *  empty in this case
+ */
+static inline int
+bps_tree_builder_finish(struct bps_tree_builder *builder);
+
 /**
  * @brief Tree destruction. Frees allocated memory.
  * @param tree - pointer to a tree
@@ -634,6 +687,16 @@ bps_tree_insert_get_iterator(struct bps_tree *tree, bps_tree_elem_t new_elem,
 static inline int
 bps_tree_delete(struct bps_tree *tree, bps_tree_elem_t elem);
 
+/**
+ * @sa bps_tree_delete + new parameter:
+ * @param[out] deleted_elem Optional pointer for the deleted
+ *             element, i.e. the one stored in the tree that is
+ *             equal to @a elem. Untouched if nothing is found.
+ */
+static inline int
+bps_tree_delete_value(struct bps_tree *tree, bps_tree_elem_t elem,
+		      bps_tree_elem_t *deleted_elem);
+
 /**
  * @brief Get size of tree, i.e. count of elements in tree
  * @param tree - pointer to a tree
@@ -989,6 +1052,19 @@ struct bps_garbage {
  */
 CT_ASSERT_G(sizeof(struct bps_garbage) <= BPS_TREE_BLOCK_SIZE);
 
+/**
+ * State of a tree being filled in ascending order,
+ * see bps_tree_builder_create().
+ */
+struct bps_tree_builder {
+	/* The tree being built */
+	struct bps_tree *tree;
+	/* The last leaf, elements are appended to it */
+	struct bps_leaf *leaf;
+	/* Count of elements to put to a leaf before starting a new one */
+	bps_tree_pos_t leaf_limit;
+};
+
 /**
  * Struct for collecting path in tree, corresponds to one inner block
  */
@@ -1089,19 +1165,35 @@ bps_tree_create(struct bps_tree *tree, bps_tree_arg_t arg,
  * @param array_size - size of the array (count of elements)
  * @return 0 on success, -1 on memory error
  */
-static inline int
-bps_tree_build(struct bps_tree *tree, bps_tree_elem_t *sorted_array,
-	       size_t array_size)
+/**
+ * @brief Reset a tree after a failure in the middle of building.
+ */
+static inline void
+bps_tree_build_reset(struct bps_tree *tree)
 {
-	assert(tree->size == 0);
-	assert(tree->root_id == (bps_tree_block_id_t)(-1));
-	assert(tree->garbage_head_id == (bps_tree_block_id_t)(-1));
-	assert(tree->matras.head.block_count == 0);
-	if (array_size == 0)
-		return 0;
-	bps_tree_block_id_t leaf_count = (array_size +
-		BPS_TREE_MAX_COUNT_IN_LEAF - 1) / BPS_TREE_MAX_COUNT_IN_LEAF;
+	matras_reset(&tree->matras);
+	tree->root_id = (bps_tree_block_id_t)(-1);
+	tree->first_id = (bps_tree_block_id_t)(-1);
+	tree->last_id = (bps_tree_block_id_t)(-1);
+	tree->leaf_count = 0;
+	tree->inner_count = 0;
+	tree->garbage_count = 0;
+	tree->garbage_head_id = (bps_tree_block_id_t)(-1);
+	tree->depth = 0;
+	tree->size = 0;
+}
 
+/**
+ * @brief Build inner blocks over the list of leaves of a tree
+ *  being built. Children are spread evenly over the inner blocks
+ *  of each level.
+ * @param tree - tree with the leaf list, counters and size set
+ * @return 0 on success, -1 on memory error
+ */
+static inline int
+bps_tree_build_inner_levels(struct bps_tree *tree)
+{
+	bps_tree_block_id_t leaf_count = tree->leaf_count;
 	bps_tree_block_id_t depth = 1;
 	bps_tree_block_id_t level_count = leaf_count;
 	while (level_count > 1) {
@@ -1123,36 +1215,12 @@ bps_tree_build(struct bps_tree *tree, bps_tree_elem_t *sorted_array,
 		parents[i] = 0;
 	}
 
-	bps_tree_block_id_t leaf_left = leaf_count;
-	size_t elems_left = array_size;
-	bps_tree_elem_t *current = sorted_array;
-	struct bps_leaf *leaf = 0;
-	bps_tree_block_id_t prev_leaf_id = (bps_tree_block_id_t)-1;
-	bps_tree_block_id_t first_leaf_id = (bps_tree_block_id_t)-1;
-	bps_tree_block_id_t last_leaf_id = (bps_tree_block_id_t)-1;
 	bps_tree_block_id_t inner_count = 0;
 	bps_tree_block_id_t root_if_inner_id = (bps_tree_block_id_t)-1;
-	do {
-		bps_tree_block_id_t id;
-		struct bps_leaf *new_leaf = (struct bps_leaf *)
-			matras_alloc(&tree->matras, &id);
-		if (!new_leaf) {
-			matras_reset(&tree->matras);
-			return -1;
-		}
-		if (first_leaf_id == (bps_tree_block_id_t)-1)
-			first_leaf_id = id;
-		last_leaf_id = id;
-		if (leaf)
-			leaf->next_id = id;
-
-		leaf = new_leaf;
-		leaf->header.type = BPS_TREE_BT_LEAF;
-		leaf->header.size = elems_left / leaf_left;
-		leaf->prev_id = prev_leaf_id;
-		prev_leaf_id = id;
-		memmove(leaf->elems, current,
-			leaf->header.size * sizeof(*current));
+	bps_tree_block_id_t id = tree->first_id;
+	while (id != (bps_tree_block_id_t)-1) {
+		struct bps_leaf *leaf = (struct bps_leaf *)
+			matras_get(&tree->matras, id);
 
 		bps_tree_block_id_t insert_id = id;
 		for (bps_tree_block_id_t i = 0; i < depth - 1; i++) {
@@ -1160,10 +1228,8 @@ bps_tree_build(struct bps_tree *tree, bps_tree_elem_t *sorted_array,
 			if (!parents[i]) {
 				parents[i] = (struct bps_inner *)
 					matras_alloc(&tree->matras, &new_id);
-				if (!parents[i]) {
-					matras_reset(&tree->matras);
+				if (!parents[i])
 					return -1;
-				}
 				parents[i]->header.type = BPS_TREE_BT_INNER;
 				parents[i]->header.size = 0;
 				inner_count++;
@@ -1179,7 +1245,8 @@ bps_tree_build(struct bps_tree *tree, bps_tree_elem_t *sorted_array,
 			}
 		}
 
-		bps_tree_elem_t insert_value = current[leaf->header.size - 1];
+		bps_tree_elem_t insert_value =
+			leaf->elems[leaf->header.size - 1];
 		for (bps_tree_block_id_t i = 0; i < depth - 1; i++) {
 			parents[i]->header.size++;
 			bps_tree_block_id_t max_size = level_child_count[i] /
@@ -1194,31 +1261,82 @@ bps_tree_build(struct bps_tree *tree, bps_tree_elem_t *sorted_array,
 				level_block_count[i]--;
 			}
 		}
+		id = leaf->next_id;
+	}
+
+	for (bps_tree_block_id_t i = 0; i < depth - 1; i++) {
+		assert(level_child_count[i] == 0);
+		assert(level_block_count[i] == 0);
+		assert(parents[i] == 0);
+	}
+
+	tree->inner_count = inner_count;
+	tree->depth = depth;
+	if (depth == 1) {
+		tree->root_id = tree->first_id;
+	} else {
+		tree->root_id = root_if_inner_id;
+	}
+	return 0;
+}
+
+static inline int
+bps_tree_build(struct bps_tree *tree, bps_tree_elem_t *sorted_array,
+	       size_t array_size)
+{
+	assert(tree->size == 0);
+	assert(tree->root_id == (bps_tree_block_id_t)(-1));
+	assert(tree->garbage_head_id == (bps_tree_block_id_t)(-1));
+	assert(tree->matras.head.block_count == 0);
+	if (array_size == 0)
+		return 0;
+	bps_tree_block_id_t leaf_count = (array_size +
+		BPS_TREE_MAX_COUNT_IN_LEAF - 1) / BPS_TREE_MAX_COUNT_IN_LEAF;
+
+	bps_tree_block_id_t leaf_left = leaf_count;
+	size_t elems_left = array_size;
+	bps_tree_elem_t *current = sorted_array;
+	struct bps_leaf *leaf = 0;
+	bps_tree_block_id_t prev_leaf_id = (bps_tree_block_id_t)-1;
+	bps_tree_block_id_t first_leaf_id = (bps_tree_block_id_t)-1;
+	bps_tree_block_id_t last_leaf_id = (bps_tree_block_id_t)-1;
+	do {
+		bps_tree_block_id_t id;
+		struct bps_leaf *new_leaf = (struct bps_leaf *)
+			matras_alloc(&tree->matras, &id);
+		if (!new_leaf) {
+			matras_reset(&tree->matras);
+			return -1;
+		}
+		if (first_leaf_id == (bps_tree_block_id_t)-1)
+			first_leaf_id = id;
+		last_leaf_id = id;
+		if (leaf)
+			leaf->next_id = id;
+
+		leaf = new_leaf;
+		leaf->header.type = BPS_TREE_BT_LEAF;
+		leaf->header.size = elems_left / leaf_left;
+		leaf->prev_id = prev_leaf_id;
+		prev_leaf_id = id;
+		memmove(leaf->elems, current,
+			leaf->header.size * sizeof(*current));
 
 		leaf_left--;
 		elems_left -= leaf->header.size;
 		current += leaf->header.size;
 	} while (leaf_left);
 	leaf->next_id = (bps_tree_block_id_t)-1;
-
 	assert(elems_left == 0);
-	for (bps_tree_block_id_t i = 0; i < depth - 1; i++) {
-		assert(level_child_count[i] == 0);
-		assert(level_block_count[i] == 0);
-		assert(parents[i] == 0);
-	}
 
 	tree->first_id = first_leaf_id;
 	tree->last_id = last_leaf_id;
 	tree->leaf_count = leaf_count;
-	tree->inner_count = inner_count;
-	tree->depth = depth;
 	tree->size = array_size;
 	tree->max_elem = sorted_array[array_size - 1];
-	if (depth == 1) {
-		tree->root_id = first_leaf_id;
-	} else {
-		tree->root_id = root_if_inner_id;
+	if (bps_tree_build_inner_levels(tree) != 0) {
+		bps_tree_build_reset(tree);
+		return -1;
 	}
 	return 0;
 }
@@ -2182,6 +2300,126 @@ bps_tree_dispose_inner(struct bps_tree *tree, struct bps_inner *inner,
 	bps_tree_garbage_push(tree, (struct bps_block *)inner, id);
 }
 
+static inline void
+bps_tree_builder_create(struct bps_tree_builder *builder,
+			struct bps_tree *tree, double fill_factor)
+{
+	assert(tree->size == 0);
+	assert(tree->root_id == (bps_tree_block_id_t)(-1));
+	assert(tree->garbage_head_id == (bps_tree_block_id_t)(-1));
+	assert(tree->matras.head.block_count == 0);
+	if (fill_factor > 1)
+		fill_factor = 1;
+	builder->tree = tree;
+	builder->leaf = NULL;
+	builder->leaf_limit = BPS_TREE_MAX_COUNT_IN_LEAF * fill_factor;
+	if (builder->leaf_limit < BPS_TREE_MAX_COUNT_IN_LEAF * 2 / 3)
+		builder->leaf_limit = BPS_TREE_MAX_COUNT_IN_LEAF * 2 / 3;
+	if (builder->leaf_limit < 1)
+		builder->leaf_limit = 1;
+}
+
+static inline int
+bps_tree_builder_append(struct bps_tree_builder *builder,
+			bps_tree_elem_t elem)
+{
+	struct bps_tree *tree = builder->tree;
+	struct bps_leaf *leaf = builder->leaf;
+	if (leaf == NULL || leaf->header.size == builder->leaf_limit) {
+		bps_tree_block_id_t id;
+		struct bps_leaf *new_leaf = (struct bps_leaf *)
+			matras_alloc(&tree->matras, &id);
+		if (new_leaf == NULL) {
+			bps_tree_build_reset(tree);
+			builder->leaf = NULL;
+			return -1;
+		}
+		new_leaf->header.type = BPS_TREE_BT_LEAF;
+		new_leaf->header.size = 0;
+		new_leaf->next_id = (bps_tree_block_id_t)(-1);
+		new_leaf->prev_id = tree->last_id;
+		if (leaf == NULL)
+			tree->first_id = id;
+		else
+			leaf->next_id = id;
+		tree->last_id = id;
+		tree->leaf_count++;
+		builder->leaf = leaf = new_leaf;
+	}
+	leaf->elems[leaf->header.size++] = elem;
+	tree->size++;
+	tree->max_elem = elem;
+	return 0;
+}
+
+/**
+ * @brief Even out the last leaves of a tree being built. All
+ *  leaves but the last one are filled up to the limit, which is
+ *  at least 2/3 of the capacity, while the last one may hold a
+ *  single element. Spread the elements of up to three last
+ *  leaves over as few leaves as possible. With three or more
+ *  leaves each of them ends up at least 2/3 full. A tree of two
+ *  leaves can't do better than about half full each, same as
+ *  after a split of the root leaf on insertion.
+ */
+static inline void
+bps_tree_builder_balance_tail(struct bps_tree_builder *builder)
+{
+	struct bps_tree *tree = builder->tree;
+	if (tree->leaf_count < 2 ||
+	    builder->leaf->header.size >= BPS_TREE_MAX_COUNT_IN_LEAF * 2 / 3)
+		return;
+	struct bps_leaf *leaves[3];
+	bps_tree_block_id_t ids[3];
+	bps_tree_elem_t elems[3 * BPS_TREE_MAX_COUNT_IN_LEAF];
+	int count = tree->leaf_count < 3 ? tree->leaf_count : 3;
+	leaves[count - 1] = builder->leaf;
+	ids[count - 1] = tree->last_id;
+	for (int i = count - 2; i >= 0; i--) {
+		ids[i] = leaves[i + 1]->prev_id;
+		leaves[i] = (struct bps_leaf *)
+			matras_get(&tree->matras, ids[i]);
+	}
+	size_t total = 0;
+	for (int i = 0; i < count; i++) {
+		memcpy(elems + total, leaves[i]->elems,
+		       leaves[i]->header.size * sizeof(*elems));
+		total += leaves[i]->header.size;
+	}
+	int new_count = (total + BPS_TREE_MAX_COUNT_IN_LEAF - 1) /
+			BPS_TREE_MAX_COUNT_IN_LEAF;
+	assert(new_count >= 1 && new_count <= count);
+	size_t done = 0;
+	for (int i = 0; i < new_count; i++) {
+		struct bps_leaf *leaf = leaves[i];
+		leaf->header.size = (total - done) / (new_count - i);
+		memcpy(leaf->elems, elems + done,
+		       leaf->header.size * sizeof(*elems));
+		done += leaf->header.size;
+	}
+	assert(done == total);
+	for (int i = new_count; i < count; i++)
+		bps_tree_dispose_leaf(tree, leaves[i], ids[i]);
+	leaves[new_count - 1]->next_id = (bps_tree_block_id_t)(-1);
+	tree->last_id = ids[new_count - 1];
+	builder->leaf = leaves[new_count - 1];
+}
+
+static inline int
+bps_tree_builder_finish(struct bps_tree_builder *builder)
+{
+	struct bps_tree *tree = builder->tree;
+	if (tree->size == 0)
+		return 0;
+	bps_tree_builder_balance_tail(builder);
+	if (bps_tree_build_inner_levels(tree) != 0) {
+		bps_tree_build_reset(tree);
+		builder->leaf = NULL;
+		return -1;
+	}
+	return 0;
+}
+
 /**
  * @brief Reserve a number of block, return false if failed.
  */
@@ -4508,6 +4746,31 @@ bps_tree_delete(struct bps_tree *tree, bps_tree_elem_t elem)
 	return 0;
 }
 
+/**
+ * @sa bps_tree_delete + new parameter:
+ * @param[out] deleted_elem Optional pointer for the deleted element
+ */
+static inline int
+bps_tree_delete_value(struct bps_tree *tree, bps_tree_elem_t elem,
+		      bps_tree_elem_t *deleted_elem)
+{
+	if (tree->root_id == (bps_tree_block_id_t)(-1))
+		return -1;
+	struct bps_inner_path_elem path[BPS_TREE_MAX_DEPTH];
+	struct bps_leaf_path_elem leaf_path_elem;
+	bool exact;
+	bps_tree_collect_path(tree, elem, path, &leaf_path_elem, &exact);
+
+	if (!exact)
+		return -1;
+
+	if (deleted_elem != NULL)
+		*deleted_elem = leaf_path_elem.block->elems[
+			leaf_path_elem.insertion_point];
+	bps_tree_process_delete_leaf(tree, &leaf_path_elem);
+	return 0;
+}
+
 /**
  * @brief Recursively find a maximum element in subtree.
  * Used only for debug purposes
@@ -6016,15 +6279,20 @@ bps_tree_debug_check_internal_functions(bool assertme)
 #undef bps_inner
 #undef bps_garbage
 #undef bps_tree_iterator
+#undef bps_tree_builder
 #undef bps_inner_path_elem
 #undef bps_leaf_path_elem
 
 #undef bps_tree_create
 #undef bps_tree_build
+#undef bps_tree_builder_create
+#undef bps_tree_builder_append
+#undef bps_tree_builder_finish
 #undef bps_tree_destroy
 #undef bps_tree_find
 #undef bps_tree_insert
 #undef bps_tree_delete
+#undef bps_tree_delete_value
 #undef bps_tree_size
 #undef bps_tree_mem_used
 #undef bps_tree_random
@@ -6065,6 +6333,9 @@ bps_tree_debug_check_internal_functions(bool assertme)
 #undef bps_tree_find_after_ins_point_key
 #undef bps_tree_find_after_ins_point_elem
 #undef bps_tree_get_leaf_safe
+#undef bps_tree_build_reset
+#undef bps_tree_build_inner_levels
+#undef bps_tree_builder_balance_tail
 #undef bps_tree_garbage_push
 #undef bps_tree_garbage_pop
 #undef bps_tree_create_leaf
@@ -29,12 +29,15 @@
  * SUCH DAMAGE.
  */
 #include "rtree.h"
+#include <stdlib.h>
 #include <string.h>
 #include <assert.h>
 #include <limits.h>
 #include <stddef.h>
 #include <sys/types.h>
 
+#include "third_party/qsort_arg.h"
+
 /*------------------------------------------------------------------------- */
 /* R-tree internal structures definition */
 /*------------------------------------------------------------------------- */
@@ -92,6 +95,28 @@ rb_gen(, rtnt_, rtnt_t, struct rtree_neighbor, link, neighbor_cmp);
 /* R-tree rectangle methods */
 /*------------------------------------------------------------------------- */
 
+/*
+ * Distance and predicate kernels below are written without
+ * data-dependent branches: per-axis results are combined with
+ * min/max and bitwise operations rather than by returning on the
+ * first mismatch. They are called for every branch of every
+ * visited page, where mispredicted early exits cost more than the
+ * few extra comparisons, and branch-free loops can be vectorized
+ * by the compiler.
+ */
+
+static coord_t
+rtree_min(coord_t a, coord_t b)
+{
+	return a < b ? a : b;
+}
+
+static coord_t
+rtree_max(coord_t a, coord_t b)
+{
+	return a > b ? a : b;
+}
+
 void
 rtree_rect_normalize(struct rtree_rect *rect, unsigned dimension)
 {
@@ -142,13 +167,11 @@ rtree_rect_neigh_distance(const struct rtree_rect *rect,
 	for (int i = dimension; --i >= 0; ) {
 		const coord_t *coords = &rect->coords[2 * i];
 		coord_t neigh_coord = neigh_rect->coords[2 * i];
-		if (neigh_coord < coords[0]) {
-			sq_coord_t diff = (sq_coord_t)(neigh_coord - coords[0]);
-			result += -diff;
-		} else if (neigh_coord > coords[1]) {
-			sq_coord_t diff = (sq_coord_t)(neigh_coord - coords[1]);
-			result += diff;
-		}
+		/* At most one of the two differences is positive. */
+		sq_coord_t diff = rtree_max(rtree_max(coords[0] - neigh_coord,
+						      neigh_coord - coords[1]),
+					    0);
+		result += diff;
 	}
 	return result;
 }
@@ -163,13 +186,10 @@ rtree_rect_neigh_distance2(const struct rtree_rect *rect,
 	for (int i = dimension; --i >= 0; ) {
 		const coord_t *coords = &rect->coords[2 * i];
 		coord_t neigh_coord = neigh_rect->coords[2 * i];
-		if (neigh_coord < coords[0]) {
-			sq_coord_t diff = (sq_coord_t)(neigh_coord - coords[0]);
-			result += diff * diff;
-		} else if (neigh_coord > coords[1]) {
-			sq_coord_t diff = (sq_coord_t)(neigh_coord - coords[1]);
-			result += diff * diff;
-		}
+		sq_coord_t diff = rtree_max(rtree_max(coords[0] - neigh_coord,
+						      neigh_coord - coords[1]),
+					    0);
+		result += diff * diff;
 	}
 	return result;
 }
@@ -203,25 +223,11 @@ rtree_rect_add(struct rtree_rect *to, const struct rtree_rect *item,
 	for (int i = dimension; --i >= 0; ) {
 		coord_t *to_coords = &to->coords[2 * i];
 		const coord_t *item_coords = &item->coords[2 * i];
-		if (to_coords[0] > item_coords[0])
-			to_coords[0] = item_coords[0];
-		if (to_coords[1] < item_coords[1])
-			to_coords[1] = item_coords[1];
+		to_coords[0] = rtree_min(to_coords[0], item_coords[0]);
+		to_coords[1] = rtree_max(to_coords[1], item_coords[1]);
 	}
 }
 
-static coord_t
-rtree_min(coord_t a, coord_t b)
-{
-	return a < b ? a : b;
-}
-
-static coord_t
-rtree_max(coord_t a, coord_t b)
-{
-	return a > b ? a : b;
-}
-
 static void
 rtree_rect_cover(const struct rtree_rect *item1,
 		 const struct rtree_rect *item2,
@@ -261,13 +267,14 @@ rtree_rect_intersects_rect(const struct rtree_rect *rt1,
 			   const struct rtree_rect *rt2,
 			   unsigned dimension)
 {
+	bool disjoint = false;
 	for (int i = dimension; --i >= 0; ) {
 		const coord_t *coords1 = &rt1->coords[2 * i];
 		const coord_t *coords2 = &rt2->coords[2 * i];
-		if (coords1[0] > coords2[1] || coords1[1] < coords2[0])
-			return false;
+		disjoint |= (coords1[0] > coords2[1]) |
+			    (coords1[1] < coords2[0]);
 	}
-	return true;
+	return !disjoint;
 }
 
 static bool
@@ -275,13 +282,14 @@ rtree_rect_in_rect(const struct rtree_rect *rt1,
 		   const struct rtree_rect *rt2,
 		   unsigned dimension)
 {
+	bool outside = false;
 	for (int i = dimension; --i >= 0; ) {
 		const coord_t *coords1 = &rt1->coords[2 * i];
 		const coord_t *coords2 = &rt2->coords[2 * i];
-		if (coords1[0] < coords2[0] || coords1[1] > coords2[1])
-			return false;
+		outside |= (coords1[0] < coords2[0]) |
+			   (coords1[1] > coords2[1]);
 	}
-	return true;
+	return !outside;
 }
 
 static bool
@@ -289,13 +297,14 @@ rtree_rect_strict_in_rect(const struct rtree_rect *rt1,
 			  const struct rtree_rect *rt2,
 			  unsigned dimension)
 {
+	bool outside = false;
 	for (int i = dimension; --i >= 0; ) {
 		const coord_t *coords1 = &rt1->coords[2 * i];
 		const coord_t *coords2 = &rt2->coords[2 * i];
-		if (coords1[0] <= coords2[0] || coords1[1] >= coords2[1])
-			return false;
+		outside |= (coords1[0] <= coords2[0]) |
+			   (coords1[1] >= coords2[1]);
 	}
-	return true;
+	return !outside;
 }
 
 static bool
@@ -319,10 +328,10 @@ rtree_rect_equal_to_rect(const struct rtree_rect *rt1,
 			 const struct rtree_rect *rt2,
 			 unsigned dimension)
 {
+	bool differ = false;
 	for (int i = dimension * 2; --i >= 0; )
-		if (rt1->coords[i] != rt2->coords[i])
-			return false;
-	return true;
+		differ |= rt1->coords[i] != rt2->coords[i];
+	return !differ;
 }
 
 static bool
@@ -1149,6 +1158,223 @@ rtree_number_of_records(const struct rtree *tree) {
 	return tree->n_records;
 }
 
+/*------------------------------------------------------------------------- */
+/* R-tree bulk loading */
+/*------------------------------------------------------------------------- */
+
+/*
+ * Entries of the builder have the layout of page branches, so
+ * that runs of them are copied to pages as is and a level of
+ * pages is described by an array of branches pointing to them.
+ */
+static struct rtree_page_branch *
+rtree_builder_entry(const struct rtree *tree, char *entries, size_t i)
+{
+	return (struct rtree_page_branch *)
+		(entries + i * tree->page_branch_size);
+}
+
+static int
+rtree_str_cmp(const void *a, const void *b, void *arg)
+{
+	unsigned axis = *(unsigned *)arg;
+	const coord_t *coords1 =
+		&((const struct rtree_page_branch *)a)->rect.coords[2 * axis];
+	const coord_t *coords2 =
+		&((const struct rtree_page_branch *)b)->rect.coords[2 * axis];
+	/* Compare doubled centers of the rectangles. */
+	coord_t c1 = coords1[0] + coords1[1];
+	coord_t c2 = coords2[0] + coords2[1];
+	return c1 < c2 ? -1 : c1 > c2 ? 1 : 0;
+}
+
+/*
+ * Number of slabs to cut n_pages pages into along an axis when
+ * dimension_left axes remain to be tiled: the least s such that
+ * s ^ dimension_left >= n_pages.
+ */
+static size_t
+rtree_str_slab_count(size_t n_pages, unsigned dimension_left)
+{
+	size_t lo = 1, hi = n_pages;
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+		size_t p = 1;
+		for (unsigned i = 0; i < dimension_left && p < n_pages; i++)
+			p *= mid;
+		if (p >= n_pages)
+			hi = mid;
+		else
+			lo = mid + 1;
+	}
+	return lo;
+}
+
+/*
+ * Sort-Tile-Recursive ordering: sort the entries by the center
+ * along the axis, cut them into slabs of whole pages and order
+ * each slab by the remaining axes. Afterwards, every run of
+ * page_max_fill entries forms a compact tile.
+ */
+static void
+rtree_str_sort(const struct rtree *tree, char *entries, size_t count,
+	       unsigned axis)
+{
+	qsort_arg(entries, count, tree->page_branch_size, rtree_str_cmp,
+		  &axis);
+	unsigned dimension_left = tree->dimension - axis;
+	if (dimension_left == 1)
+		return;
+	size_t max_fill = tree->page_max_fill;
+	size_t n_pages = (count + max_fill - 1) / max_fill;
+	size_t n_slabs = rtree_str_slab_count(n_pages, dimension_left);
+	size_t slab_size = (n_pages + n_slabs - 1) / n_slabs * max_fill;
+	for (size_t i = 0; i < count; i += slab_size) {
+		size_t n = count - i < slab_size ? count - i : slab_size;
+		rtree_str_sort(tree, (char *)rtree_builder_entry(tree, entries,
+								 i),
+			       n, axis + 1);
+	}
+}
+
+/*
+ * Free the pages created by rtree_builder_finish() before it
+ * failed to allocate a page at the given level (leaves are
+ * level 0): pages of the level written to the head of the
+ * entries and pages of the level below not consumed yet.
+ */
+static void
+rtree_builder_cleanup(struct rtree_builder *builder, unsigned level,
+		      size_t n_done, size_t pos, size_t count)
+{
+	struct rtree *tree = builder->tree;
+	for (size_t i = 0; i < n_done; i++) {
+		struct rtree_page_branch *b =
+			rtree_builder_entry(tree, builder->entries, i);
+		rtree_page_purge(tree, b->data.page, level + 1);
+	}
+	if (level > 0) {
+		for (size_t i = pos; i < count; i++) {
+			struct rtree_page_branch *b =
+				rtree_builder_entry(tree, builder->entries, i);
+			rtree_page_purge(tree, b->data.page, level);
+		}
+	}
+	tree->n_pages = 0;
+}
+
+void
+rtree_builder_create(struct rtree_builder *builder, struct rtree *tree)
+{
+	builder->tree = tree;
+	builder->entries = NULL;
+	builder->count = 0;
+	builder->capacity = 0;
+}
+
+void
+rtree_builder_destroy(struct rtree_builder *builder)
+{
+	free(builder->entries);
+	builder->entries = NULL;
+	builder->count = 0;
+	builder->capacity = 0;
+}
+
+int
+rtree_builder_reserve(struct rtree_builder *builder, size_t count)
+{
+	if (count <= builder->capacity)
+		return 0;
+	char *entries = (char *)realloc(builder->entries,
+					count * builder->tree->page_branch_size);
+	if (entries == NULL)
+		return -1;
+	builder->entries = entries;
+	builder->capacity = count;
+	return 0;
+}
+
+int
+rtree_builder_append(struct rtree_builder *builder,
+		     const struct rtree_rect *rect, record_t obj)
+{
+	if (builder->count == builder->capacity) {
+		size_t capacity = builder->capacity + builder->capacity / 2;
+		if (capacity < RTREE_OPTIMAL_BRANCHES_IN_PAGE)
+			capacity = RTREE_OPTIMAL_BRANCHES_IN_PAGE;
+		if (rtree_builder_reserve(builder, capacity) != 0)
+			return -1;
+	}
+	struct rtree *tree = builder->tree;
+	struct rtree_page_branch *b =
+		rtree_builder_entry(tree, builder->entries, builder->count++);
+	rtree_rect_copy(&b->rect, rect, tree->dimension);
+	b->data.record = obj;
+	return 0;
+}
+
+int
+rtree_builder_finish(struct rtree_builder *builder)
+{
+	struct rtree *tree = builder->tree;
+	assert(tree->root == NULL);
+	size_t count = builder->count;
+	if (count == 0)
+		return 0;
+	char *entries = builder->entries;
+	size_t branch_size = tree->page_branch_size;
+	size_t max_fill = tree->page_max_fill;
+	unsigned level = 0;
+	/*
+	 * Pack the entries into pages level by level, replacing
+	 * them with branches pointing to the pages, until the
+	 * root is left. A branch is written over entries that
+	 * were already copied to pages.
+	 */
+	do {
+		rtree_str_sort(tree, entries, count, 0);
+		size_t n_pages = (count + max_fill - 1) / max_fill;
+		size_t last_fill = count - (n_pages - 1) * max_fill;
+		/* Borrow entries to get the last page min-filled. */
+		size_t borrow = 0;
+		if (n_pages > 1 && last_fill < tree->page_min_fill)
+			borrow = tree->page_min_fill - last_fill;
+		size_t pos = 0;
+		for (size_t i = 0; i < n_pages; i++) {
+			size_t n = max_fill;
+			if (i + 2 == n_pages)
+				n -= borrow;
+			else if (i + 1 == n_pages)
+				n = last_fill + borrow;
+			struct rtree_page *page = rtree_page_alloc(tree);
+			if (page == NULL) {
+				rtree_builder_cleanup(builder, level, i,
+						      pos, count);
+				return -1;
+			}
+			tree->n_pages++;
+			page->n = n;
+			memcpy(page->data, entries + pos * branch_size,
+			       n * branch_size);
+			pos += n;
+			struct rtree_page_branch *b =
+				rtree_builder_entry(tree, entries, i);
+			rtree_page_cover(tree, page, &b->rect);
+			b->data.page = page;
+		}
+		assert(pos == count);
+		count = n_pages;
+		level++;
+	} while (count > 1);
+	assert(level <= RTREE_MAX_HEIGHT);
+	tree->root = rtree_builder_entry(tree, entries, 0)->data.page;
+	tree->height = level;
+	tree->n_records = builder->count;
+	tree->version++;
+	return 0;
+}
+
 #if 0
 #include <stdio.h>
 void
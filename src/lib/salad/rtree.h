@@ -154,6 +154,24 @@ struct rtree
 	enum rtree_distance_type distance_type;
 };
 
+/*
+ * Bulk loader of a tree. Records are collected in any order and
+ * then packed into pages by the Sort-Tile-Recursive algorithm,
+ * which is much faster than inserting them one by one and gives
+ * fully filled pages that barely overlap.
+ */
+struct rtree_builder
+{
+	/* The tree being built */
+	struct rtree *tree;
+	/* Collected records laid out as page branches */
+	char *entries;
+	/* Number of collected records */
+	size_t count;
+	/* Number of records the entries buffer can hold */
+	size_t capacity;
+};
+
 /* Struct for iteration and retrieving rtree values */
 struct rtree_iterator
 {
@@ -299,6 +317,51 @@ rtree_used_size(const struct rtree *tree);
 unsigned
 rtree_number_of_records(const struct rtree *tree);
 
+/**
+ * @brief Initialize a bulk loader of an empty tree
+ * @param builder - pointer to a builder
+ * @param tree - pointer to a tree to load
+ */
+void
+rtree_builder_create(struct rtree_builder *builder, struct rtree *tree);
+
+/**
+ * @brief Free the records collected by a builder
+ * @param builder - pointer to a builder
+ */
+void
+rtree_builder_destroy(struct rtree_builder *builder);
+
+/**
+ * @brief Preallocate memory for the given number of records
+ * @param builder - pointer to a builder
+ * @param count - expected number of records
+ * @return 0 on success, -1 on memory allocation error
+ */
+int
+rtree_builder_reserve(struct rtree_builder *builder, size_t count);
+
+/**
+ * @brief Add a record to be loaded into the tree
+ * @param builder - pointer to a builder
+ * @param rect - rectangle of the record
+ * @param obj - record to add
+ * @return 0 on success, -1 on memory allocation error
+ */
+int
+rtree_builder_append(struct rtree_builder *builder,
+		     const struct rtree_rect *rect, record_t obj);
+
+/**
+ * @brief Build the tree of all the records added to a builder.
+ * The builder must be destroyed afterwards.
+ * @param builder - pointer to a builder
+ * @return 0 on success, -1 if a page could not be allocated,
+ *  the tree is left empty then
+ */
+int
+rtree_builder_finish(struct rtree_builder *builder);
+
 #if 0
 /**
  * @brief Print a tree to stdout. Debug function, thus disabled.
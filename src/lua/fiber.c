@@ -216,6 +216,14 @@ lbox_fiber_statof(struct fiber *f, void *cb_ctx, bool backtrace)
 	lua_pushnumber(L, f->csw);
 	lua_settable(L, -3);
 
+	if (fiber_top_is_enabled()) {
+		struct fiber_top_info info;
+		fiber_top_stat(f, &info);
+		lua_pushliteral(L, "time");
+		lua_pushnumber(L, info.time);
+		lua_settable(L, -3);
+	}
+
 	lua_pushliteral(L, "memory");
 	lua_newtable(L);
 	lua_pushstring(L, "used");
@@ -673,8 +681,71 @@ static const struct luaL_Reg lbox_fiber_meta [] = {
 	{NULL, NULL}
 };
 
+static int
+lbox_fiber_top_entry(struct fiber *f, void *cb_ctx)
+{
+	struct lua_State *L = (struct lua_State *) cb_ctx;
+	struct fiber_top_info info;
+	fiber_top_stat(f, &info);
+
+	lua_pushfstring(L, "%d/%s", (int) f->fid, fiber_name(f));
+	lua_createtable(L, 0, 3);
+	lua_pushliteral(L, "instant");
+	lua_pushnumber(L, info.instant);
+	lua_settable(L, -3);
+	lua_pushliteral(L, "average");
+	lua_pushnumber(L, info.average);
+	lua_settable(L, -3);
+	lua_pushliteral(L, "time");
+	lua_pushnumber(L, info.time);
+	lua_settable(L, -3);
+	lua_settable(L, -3);
+	return 0;
+}
+
+/**
+ * Return CPU usage of the fibers of the current cord:
+ * the share of the last second (instant) and of the time since
+ * fiber.top_enable() (average) in percent, and the total time
+ * in seconds. The scheduler time includes the event loop.
+ */
+static int
+lbox_fiber_top(struct lua_State *L)
+{
+	if (!fiber_top_is_enabled()) {
+		return luaL_error(L, "fiber.top() is disabled. Enable it "
+				  "with fiber.top_enable() first");
+	}
+	lua_newtable(L);
+	lua_pushliteral(L, "cpu");
+	lua_newtable(L);
+	lbox_fiber_top_entry(&cord()->sched, L);
+	fiber_stat(lbox_fiber_top_entry, L);
+	lua_settable(L, -3);
+	return 1;
+}
+
+static int
+lbox_fiber_top_enable(struct lua_State *L)
+{
+	(void) L;
+	fiber_top_enable();
+	return 0;
+}
+
+static int
+lbox_fiber_top_disable(struct lua_State *L)
+{
+	(void) L;
+	fiber_top_disable();
+	return 0;
+}
+
 static const struct luaL_Reg fiberlib[] = {
 	{"info", lbox_fiber_info},
+	{"top", lbox_fiber_top},
+	{"top_enable", lbox_fiber_top_enable},
+	{"top_disable", lbox_fiber_top_disable},
 	{"sleep", lbox_fiber_sleep},
 	{"yield", lbox_fiber_yield},
 	{"self", lbox_fiber_self},
@@ -150,7 +150,7 @@ struct log {
 	/* Application identifier used to group syslog messages. */
 	char *syslog_ident;
 	/**
-	 * Used to wake up the main logger thread from a eio thread.
+	 * Used to wake up the main logger thread from a coio thread.
 	 */
 	ev_async log_async;
 	/**
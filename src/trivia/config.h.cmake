@@ -160,13 +160,15 @@
 #cmakedefine HAVE_NON_C99_PTHREAD_H 1
 
 #cmakedefine ENABLE_BUNDLED_LIBEV 1
-#cmakedefine ENABLE_BUNDLED_LIBEIO 1
 #cmakedefine ENABLE_BUNDLED_LIBCORO 1
 
 #cmakedefine HAVE_PTHREAD_YIELD 1
 #cmakedefine HAVE_SCHED_YIELD 1
 #cmakedefine HAVE_POSIX_FADVISE 1
 #cmakedefine HAVE_MREMAP 1
+#cmakedefine HAVE_MAP_HUGETLB 1
+#cmakedefine HAVE_MADV_HUGEPAGE 1
+#cmakedefine HAVE_MBIND 1
 
 #cmakedefine HAVE_PRCTL_H 1
 
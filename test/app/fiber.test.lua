@@ -505,4 +505,22 @@ fiber.name(f)
 fiber.name(f, long_name, {truncate = true})
 fiber.name(f)
 
+--
+-- fiber.top()
+--
+fiber.top()
+fiber.top_enable()
+f = fiber.new(function() for i = 1, 100 do fiber.yield() end end)
+f:name('top_test')
+name = f:id() .. '/top_test'
+fiber.sleep(0)
+cpu = fiber.top().cpu
+cpu[name] ~= nil
+cpu['1/sched'] ~= nil
+cpu[name].time >= 0 and cpu[name].average >= 0 and cpu[name].instant >= 0
+fiber.info()[fiber.self():id()].time ~= nil
+fiber.top_disable()
+fiber.top()
+fiber.info()[fiber.self():id()].time
+
 test_run:cmd("clear filter")
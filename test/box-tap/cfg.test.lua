@@ -6,7 +6,7 @@ local socket = require('socket')
 local fio = require('fio')
 local uuid = require('uuid')
 local msgpack = require('msgpack')
-test:plan(91)
+test:plan(102)
 
 --------------------------------------------------------------------------------
 -- Invalid values
@@ -46,6 +46,17 @@ invalid('vinyl_run_count_per_level', 0)
 invalid('vinyl_run_size_ratio', 1)
 invalid('vinyl_bloom_fpr', 0)
 invalid('vinyl_bloom_fpr', 1.1)
+invalid('memtx_huge_pages', 'invalid')
+invalid('memtx_numa_policy', 'invalid')
+invalid('memtx_numa_nodes', '')
+invalid('memtx_numa_nodes', 'x')
+invalid('memtx_numa_nodes', '0,')
+invalid('memtx_numa_nodes', '0,,1')
+invalid('memtx_numa_nodes', '0-')
+invalid('memtx_numa_nodes', '3-1')
+invalid('memtx_numa_nodes', '64')
+-- 'bind' needs an explicit node list
+invalid('memtx_numa_policy', 'bind')
 
 local function invalid_combinations(name, val)
     local status, result = pcall(box.cfg, val)
@@ -199,6 +210,11 @@ test:is(run_script(code), PANIC, 'snap_dir is invalid')
 code = [[ box.cfg{ wal_dir='invalid' } ]]
 test:is(run_script(code), PANIC, 'wal_dir is invalid')
 
+-- A tuple arena that can't be bound to the requested nodes
+-- must not let the instance start.
+code = [[ box.cfg{ memtx_numa_policy='bind', memtx_numa_nodes='63' } ]]
+test:is(run_script(code), PANIC, 'memtx_numa_policy bind failure')
+
 test:isnil(box.cfg.log_nonblock, "log_nonblock default value")
 code = [[
 box.cfg{log_nonblock = false }
@@ -0,0 +1,88 @@
+#!/usr/bin/env tarantool
+
+local tap = require('tap')
+local net_box = require('net.box')
+local test = tap.test('select_filter')
+
+box.cfg{
+    listen = os.getenv('LISTEN'),
+    log = 'tarantool.log',
+}
+box.schema.user.grant('guest', 'read,write,execute', 'universe')
+
+local s = box.schema.space.create('test')
+s:create_index('pk')
+for i = 1, 10 do
+    s:insert{i, i % 2 == 0 and 'even' or 'odd', i * 10}
+end
+
+local function ids(tuples)
+    local res = {}
+    for _, t in ipairs(tuples) do
+        table.insert(res, t[1])
+    end
+    return res
+end
+
+test:plan(3)
+
+local function check(test, select)
+    test:plan(10)
+    test:is_deeply(ids(select(nil, {filter = {'==', 2, 'even'}})),
+                   {2, 4, 6, 8, 10}, 'equality')
+    test:is_deeply(ids(select(nil, {filter = {'>=', 3, 70}})),
+                   {7, 8, 9, 10}, 'range')
+    test:is_deeply(ids(select(nil, {filter = {'and', {'==', 2, 'odd'},
+                                              {'<', 3, 50}}})),
+                   {1, 3}, 'and')
+    test:is_deeply(ids(select(nil, {filter = {'or', {'==', 1, 1},
+                                              {'==', 1, 10}}})),
+                   {1, 10}, 'or')
+    test:is_deeply(ids(select(nil, {filter = {'not', {'!=', 1, 5}}})),
+                   {5}, 'not')
+    test:is_deeply(ids(select(nil, {filter = {'==', 4, 1}})),
+                   {}, 'missing field never matches')
+    test:is_deeply(ids(select(nil, {filter = {'==', 2, 'even'},
+                                    offset = 1, limit = 2})),
+                   {4, 6}, 'offset and limit count matching tuples')
+    test:is_deeply(ids(select({5}, {iterator = 'GE',
+                                    filter = {'==', 2, 'odd'}})),
+                   {5, 7, 9}, 'filter with a key')
+    local ok, err = pcall(select, nil, {filter = {'~', 1, 1}})
+    test:ok(not ok and tostring(err):match('unknown operator') ~= nil,
+            'unknown operator')
+    ok, err = pcall(select, nil, {filter = {'==', 1, {1}}})
+    test:ok(not ok and tostring(err):match('must be a scalar') ~= nil,
+            'non-scalar value')
+end
+
+test:test('local', check, function(...) return s:select(...) end)
+
+local conn = net_box.connect(box.cfg.listen)
+test:test('remote', check, function(...)
+    return conn.space.test:select(...)
+end)
+conn:close()
+
+-- Fields which aren't indexed are only kept in the compressed
+-- data, the filter must see them.
+local c = box.schema.space.create('compressed', {compression = 'zstd'})
+c:create_index('pk')
+local pad = string.rep('lorem ipsum dolor sit amet ', 10)
+for i = 1, 3000 do
+    c:insert{i, i % 2 == 0 and 'even' or 'odd', i * 10, pad .. i}
+end
+test:test('compressed', function(test)
+    test:plan(3)
+    test:is(#c:select(nil, {filter = {'==', 2, 'even'}}), 1500,
+            'equality')
+    test:is_deeply(ids(c:select(nil, {filter = {'>=', 3, 29980}})),
+                   {2998, 2999, 3000}, 'range')
+    test:is_deeply(ids(c:select({2991}, {iterator = 'GE',
+                                         filter = {'==', 2, 'even'}})),
+                   {2992, 2994, 2996, 2998, 3000}, 'filter with a key')
+end)
+c:drop()
+
+s:drop()
+os.exit(test:check() and 0 or 1)
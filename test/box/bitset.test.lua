@@ -147,3 +147,26 @@ for j=1,100 do check(math.random(9) - 1, {iterator = box.index.BITS_ALL_NOT_SET}
 good
 s:drop()
 s = nil
+
+-- Roaring bitsets
+s = box.schema.space.create('test')
+_ = s:create_index('primary', { type = 'hash', parts = {1, 'unsigned'}, unique = true })
+s:create_index('tree', { type = 'tree', parts = {2, 'unsigned'}, roaring = true })
+paged = s:create_index('paged', { type = 'bitset', parts = {2, 'unsigned'}, unique = false })
+roaring = s:create_index('roaring', { type = 'bitset', parts = {2, 'unsigned'}, unique = false, roaring = true })
+roaring.roaring
+for i=1,10000 do s:insert{i, math.random(256) - 1} end
+for i=1,10000,3 do s:delete{i} end
+good = true
+function is_same(key, opts) return #paged:select({key}, opts) == #roaring:select({key}, opts) and paged:count({key}, opts) == roaring:count({key}, opts) end
+function check(key, opts) good = good and is_same(key, opts) end
+for j=1,20 do check(math.random(256) - 1) end
+for j=1,20 do check(math.random(256) - 1, {iterator = box.index.BITS_ANY_SET}) end
+for j=1,20 do check(math.random(256) - 1, {iterator = box.index.BITS_ALL_SET}) end
+for j=1,20 do check(math.random(256) - 1, {iterator = box.index.BITS_ALL_NOT_SET}) end
+good
+roaring:bsize() < paged:bsize()
+roaring:alter({roaring = false})
+roaring.roaring
+s:drop()
+s = nil
@@ -0,0 +1,53 @@
+test_run = require('test_run').new()
+-- Unknown compression type.
+box.schema.space.create('test', {compression = 'lz4'})
+-- Vinyl does not compress tuples.
+box.schema.space.create('test', {engine = 'vinyl', compression = 'zstd'})
+
+s = box.schema.space.create('test', {compression = 'zstd'})
+box.space._space:get(s.id)[6]
+pk = s:create_index('pk')
+sk = s:create_index('sk', {parts = {2, 'string'}})
+
+test_run:cmd("setopt delimiter ';'")
+function doc(i)
+    return {i, 'user' .. i, {name = 'name' .. i,
+            email = 'user' .. i .. '@example.com',
+            city = 'city' .. i % 10,
+            tags = {'alpha', 'beta', 'gamma', 'delta'}},
+            string.rep('lorem ipsum dolor sit amet ', 8) .. i}
+end;
+test_run:cmd("setopt delimiter ''");
+for i = 1, 4000 do s:insert(doc(i)) end
+-- Tuples stored after the dictionary was trained are compressed.
+total = 0
+for _, t in s:pairs() do total = total + t:bsize() end
+s:bsize() < total / 2
+
+-- Reads return the full tuple.
+s:get{3999}[4] == doc(3999)[4]
+s.index.sk:get{'user3998'}[3].email
+s:select({3990}, {iterator = 'ge', limit = 3})[3][3].city
+#s:select()
+
+-- Update and upsert see the full old tuple.
+s:update({3997}, {{'=', 2, 'updated'}})[3].name
+s.index.sk:get{'updated'}[1]
+s:upsert(doc(3996), {{'=', 2, 'upserted'}})
+s:get{3996}[2]
+s:get{3996}[4] == doc(3996)[4]
+s:replace(doc(3997))[2]
+
+-- Fields which were not indexed are not kept plain.
+s:create_index('text', {parts = {4, 'string'}, unique = false})
+pk2 = s:create_index('pk2', {parts = {1, 'unsigned', 2, 'string'}})
+s.index.pk2:get{3995, 'user3995'}[3].name
+
+-- Snapshot and restore the compressed data.
+box.snapshot()
+test_run:cmd('restart server default')
+s = box.space.test
+s:count()
+s:get{3999}[3].email
+s.index.sk:get{'user3998'}[1]
+s:drop()
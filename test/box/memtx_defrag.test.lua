@@ -0,0 +1,26 @@
+fiber = require('fiber')
+
+-- Bad threshold.
+box.cfg{memtx_defrag_threshold = -0.1}
+box.cfg{memtx_defrag_threshold = 1}
+
+s = box.schema.space.create('test')
+pk = s:create_index('pk')
+sk = s:create_index('sk', {type = 'hash', parts = {2, 'unsigned'}})
+for i = 1, 10000 do s:insert{i, i, string.rep('x', 100)} end
+for i = 1, 10000 do if i % 4 ~= 0 then s:delete{i} end end
+
+passes = box.slab.defrag_stat().passes
+box.slab.defrag()
+while box.slab.defrag_stat().passes == passes do fiber.sleep(0.01) end
+box.slab.defrag_stat().moved > 0
+box.slab.defrag_stat().running
+
+-- The data is intact and both indexes agree.
+s:count()
+pk:count() == sk:count()
+bad = 0
+for _, t in pk:pairs() do if sk:get{t[2]}[1] ~= t[1] or t[1] % 4 ~= 0 then bad = bad + 1 end end
+bad
+
+s:drop()
@@ -0,0 +1,39 @@
+fiber = require('fiber')
+
+--
+-- Defragmentation doesn't wait for all transactions to end:
+-- only tuples of uncommitted statements are left in place.
+--
+s = box.schema.space.create('test')
+pk = s:create_index('pk')
+sk = s:create_index('sk', {type = 'hash', parts = {2, 'unsigned'}})
+for i = 1, 10000 do s:insert{i, i, string.rep('x', 100)} end
+for i = 1, 10000 do if i % 4 ~= 0 then s:delete{i} end end
+
+box.error.injection.set('ERRINJ_WAL_DELAY', true)
+f1 = fiber.create(function() s:replace{4, 4, string.rep('y', 100)} end)
+f2 = fiber.create(function() s:insert{10001, 10001, string.rep('z', 100)} end)
+passes = box.slab.defrag_stat().passes
+moved = box.slab.defrag_stat().moved
+box.slab.defrag()
+while box.slab.defrag_stat().passes == passes do fiber.sleep(0.01) end
+box.slab.defrag_stat().moved > moved
+box.error.injection.set('ERRINJ_WAL_DELAY', false)
+while f1:status() ~= 'dead' or f2:status() ~= 'dead' do fiber.sleep(0.01) end
+
+-- The data is intact and both indexes agree.
+s:get{4}[3] == string.rep('y', 100)
+s:get{10001}[3] == string.rep('z', 100)
+s:count()
+pk:count() == sk:count()
+bad = 0
+for _, t in pk:pairs() do if sk:get{t[2]}[1] ~= t[1] or t[1] % 4 ~= 0 and t[1] ~= 10001 then bad = bad + 1 end end
+bad
+
+--
+-- A rolled back statement releases its tuple.
+--
+box.begin() s:replace{8, 8, string.rep('w', 100)} box.rollback()
+s:get{8}[3] == string.rep('x', 100)
+
+s:drop()
@@ -0,0 +1,61 @@
+test_run = require('test_run').new()
+fiber = require('fiber')
+
+-- Bad options.
+box.cfg{memtx_expire_batch_size = 0}
+box.cfg{memtx_expire_rate = -1}
+box.schema.space.create('test', {ttl = 1})
+box.schema.space.create('test', {ttl = 1, ttl_field = 'time'})
+box.schema.space.create('test', {ttl = -1, ttl_field = 1})
+box.schema.space.create('test', {engine = 'vinyl', ttl = 1, ttl_field = 1})
+
+box.cfg{memtx_expire_batch_size = 10}
+s = box.schema.space.create('test', {ttl = 60, format = {{'id', 'unsigned'}, {'time', 'number'}}, ttl_field = 'time'})
+box.space._space:get(s.id)[6].ttl_field
+pk = s:create_index('pk')
+-- Nothing expires without an index ordered by time.
+test_run:grep_log('default', "space 'test' has ttl, but ttl_field is not the first part of any TREE index") ~= nil
+for i = 1, 100 do s:insert{i, fiber.time() - 120} end
+fiber.sleep(0.1)
+s:count()
+
+expired = box.stat.expire().expired
+batches = box.stat.expire().batches
+tk = s:create_index('time', {parts = {'time'}, unique = false})
+for i = 101, 200 do s:insert{i, fiber.time()} end
+while s:count() > 100 do fiber.sleep(0.01) end
+box.stat.expire().expired - expired
+box.stat.expire().batches - batches
+box.stat.expire().errors
+s:min()[1]
+
+-- Expired tuples are deleted through the usual path.
+deleted = 0
+_ = s:on_replace(function(old, new) if new == nil then deleted = deleted + 1 end end)
+s:insert{1, fiber.time() - 61}
+while s:get{1} ~= nil do fiber.sleep(0.01) end
+deleted
+
+-- Nothing is deleted on a read-only instance.
+s:insert{1, fiber.time() - 59.9}
+box.cfg{read_only = true}
+fiber.sleep(1.5)
+s:get{1} ~= nil
+box.cfg{read_only = false}
+while s:get{1} ~= nil do fiber.sleep(0.01) end
+s:count()
+
+s:drop()
+
+-- ttl can't be set unless a TREE index starts with ttl_field.
+s = box.schema.space.create('test2', {format = {{'id', 'unsigned'}, {'time', 'number'}}})
+_ = s:create_index('pk')
+box.space._space:update(s.id, {{'=', 6, {ttl = 60, ttl_field = 1}}})
+tk = s:create_index('time', {parts = {'time'}, unique = false})
+box.space._space:update(s.id, {{'=', 6, {ttl = 60, ttl_field = 1}}})[6].ttl
+-- The index can be dropped, with a warning.
+tk:drop()
+test_run:grep_log('default', "space 'test2' has ttl, but") ~= nil
+s:drop()
+
+box.cfg{memtx_expire_batch_size = 100}
@@ -97,6 +97,7 @@ t = {};
 for k, v in pairs(box.slab.info()) do
     table.insert(t, k)
 end;
+table.sort(t);
 t;
 box.runtime.info().used > 0;
 box.runtime.info().maxalloc > 0;
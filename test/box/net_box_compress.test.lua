@@ -0,0 +1,36 @@
+net = require('net.box')
+
+box.schema.user.grant('guest', 'read,write,execute', 'universe')
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+pad = string.rep('x', 1000)
+for i = 1, 1000 do s:insert{i, pad} end
+
+ok, err = pcall(net.connect, box.cfg.listen, {compression = 'lz4'})
+ok
+err:match('Unsupported compression: lz4') ~= nil
+
+c = net.connect(box.cfg.listen, {compression = 'zstd'})
+c:ping()
+#c.space.test:select()
+c.space.test:get(500)[1]
+c:eval('return ...', {1, 2, 3})
+
+--
+-- Replies larger than the socket buffer interleaved with
+-- small ones, so that the output is flushed in parts.
+--
+futures = {}
+for i = 1, 20 do table.insert(futures, c.space.test:select({}, {is_async = true})) table.insert(futures, c:eval('return 1', {}, {is_async = true})) end
+ok = true
+for i, f in ipairs(futures) do local res = f:wait_result(10) if i % 2 == 1 then ok = ok and #res == 1000 else ok = ok and res[1] == 1 end end
+ok
+
+-- The padding is compressed.
+sent = box.stat.net.SENT.total
+_ = c.space.test:select()
+box.stat.net.SENT.total - sent < 100000
+c:close()
+
+s:drop()
+box.schema.user.revoke('guest', 'read,write,execute', 'universe')
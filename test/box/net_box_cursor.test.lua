@@ -0,0 +1,53 @@
+net = require('net.box')
+fiber = require('fiber')
+
+box.schema.user.grant('guest', 'read,write,execute', 'universe')
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+for i = 1, 10 do s:insert{i} end
+c = net.connect(box.cfg.listen)
+
+-- A cursor is closed once exhausted.
+cur = c.space.test.index.pk:cursor()
+cur:fetch(4)
+cur:fetch(4)
+cur:fetch(4)
+cur:fetch(4)
+c:_request('cursor_fetch', nil, cur.id, 1)
+
+-- Key, iterator and offset. Concurrent changes are visible.
+cur = c.space.test.index.pk:cursor({5}, {iterator = 'GE', offset = 2})
+cur:fetch(2)
+s:delete{9}
+cur:fetch(2)
+s:insert{9}
+
+-- Explicit close.
+cur = c.space.test.index.pk:cursor()
+cur:fetch(1)
+cur:close()
+c:_request('cursor_fetch', nil, cur.id, 1)
+c:_request('cursor_close', nil, 100)
+
+-- Limits.
+box.cfg{net_cursor_max = -1}
+box.cfg{net_cursor_timeout = 0}
+box.cfg{net_cursor_memory = -1}
+box.cfg{net_cursor_max = 1}
+cur = c.space.test.index.pk:cursor()
+c.space.test.index.pk:cursor()
+cur:close()
+box.cfg{net_cursor_max = 64, net_cursor_memory = 0}
+c.space.test.index.pk:cursor()
+box.cfg{net_cursor_memory = 16 * 1024 * 1024}
+
+-- An idle cursor is closed after net_cursor_timeout.
+box.cfg{net_cursor_timeout = 0.01}
+cur = c.space.test.index.pk:cursor()
+fiber.sleep(0.1)
+cur:fetch(1)
+box.cfg{net_cursor_timeout = 60}
+
+c:close()
+s:drop()
+box.schema.user.revoke('guest', 'read,write,execute', 'universe')
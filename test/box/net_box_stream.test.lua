@@ -0,0 +1,73 @@
+test_run = require('test_run').new()
+net = require('net.box')
+fiber = require('fiber')
+
+box.schema.user.grant('guest', 'read,write,execute', 'universe')
+s = box.schema.space.create('test', {engine = 'vinyl'})
+_ = s:create_index('pk')
+m = box.schema.space.create('test_memtx')
+_ = m:create_index('pk')
+
+c = net.connect(box.cfg.listen)
+stream = c:new_stream()
+stream2 = c:new_stream()
+
+-- Transaction control requests need a stream.
+c:_request('begin', nil)
+
+-- Requests of a stream are executed in order.
+order = {}
+f1 = stream:eval("require('fiber').sleep(0.05) table.insert(order, 1)", {}, {is_async = true})
+f2 = stream:eval("table.insert(order, 2)", {}, {is_async = true})
+f1:wait_result(10)
+f2:wait_result(10)
+order
+
+-- Commit.
+stream:begin()
+stream.space.test:replace{1}
+stream.space.test:replace{2}
+s:select()
+stream2.space.test:select()
+stream:commit()
+s:select()
+
+-- Rollback.
+stream:begin()
+stream.space.test:replace{3}
+stream.space.test:select()
+stream:rollback()
+s:select()
+
+-- A yield between requests doesn't abort the transaction.
+stream:begin()
+stream.space.test:replace{4}
+fiber.sleep(0.01)
+stream:eval("return box.space.test:replace{5}")
+stream:commit()
+s:select()
+
+-- BEGIN in an open transaction is an error.
+stream:begin()
+stream:begin()
+stream:rollback()
+
+-- memtx can't be used in a stream transaction.
+stream:begin()
+stream.space.test_memtx:replace{1}
+stream:rollback()
+stream.space.test_memtx:replace{1}
+
+-- A transaction left open is rolled back on disconnect.
+rollback = box.info.vinyl().tx.rollback
+stream:begin()
+stream.space.test:replace{6}
+box.info.vinyl().tx.transactions
+c:close()
+test_run:wait_cond(function() return box.info.vinyl().tx.rollback > rollback end, 10)
+box.info.vinyl().tx.transactions
+s:select()
+
+s:drop()
+m:drop()
+box.schema.user.revoke('guest', 'read,write,execute', 'universe')
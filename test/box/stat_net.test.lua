@@ -18,6 +18,9 @@ cn.space.tweedledum:select() --small request
 
 box.stat.net.SENT.total > 0
 box.stat.net.RECEIVED.total > 0
+latency = box.stat.net.LATENCY.SELECT
+latency.total.p99 >= latency.total.p50
+latency.queue.p50 <= latency.total.p50
 -- box.stat.net.EVENTS.total > 0
 -- box.stat.net.LOCKS.total > 0
 
@@ -25,6 +28,7 @@ box.stat.net.RECEIVED.total > 0
 box.stat.reset()
 box.stat.net.SENT.total
 box.stat.net.RECEIVED.total
+box.stat.net.LATENCY.SELECT
 
 space:drop()
 cn:close()
@@ -0,0 +1,57 @@
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+-- Included fields are supported by TREE indexes only.
+s:create_index('hash', {type = 'hash', parts = {2, 'unsigned'}, include = {3}})
+s:create_index('sk', {parts = {2, 'unsigned'}, include = 3})
+s:create_index('sk', {parts = {2, 'unsigned'}, include = {0}})
+s:create_index('sk', {parts = {2, 'unsigned'}, include = {'x'}})
+sk = s:create_index('sk', {parts = {2, 'unsigned'}, include = {4, 6}})
+box.space._index:get{s.id, sk.id}[5].include
+for i = 1, 5 do s:replace{i, 10 - i, 'x', i * i, 'y', i * 10} end
+sk:select()
+s:get{3}[4], s:get{3}[6]
+-- Covered reads return the fields stored in the index.
+sk:select({}, {covered = true})
+sk:select({7}, {iterator = 'le', limit = 2, covered = true})
+t = {} for _, c in sk:pairs({6}, {iterator = 'ge', covered = true}) do table.insert(t, c) end
+t
+sk:select({}, {covered = 1})
+s.index.pk:select({}, {covered = true})
+-- Included fields may be absent.
+s:replace{6, 4}
+s:get{6}[4], s:get{6}[6]
+sk:select({4}, {covered = true})
+bsize = sk:bsize()
+sk:alter({include = {}})
+box.space._index:get{s.id, sk.id}[5].include
+sk:select{4}
+sk:bsize() < bsize
+sk:select({4}, {covered = true})
+s:drop()
+
+-- Included fields can be given by name.
+s = box.schema.space.create('test', {format = {{'a', 'unsigned'}, {'b', 'unsigned'}, {'c', 'string', is_nullable = true}}})
+_ = s:create_index('pk')
+sk = s:create_index('sk', {parts = {'b'}, include = {'c'}})
+box.space._index:get{s.id, sk.id}[5].include
+s:replace{1, 2, 'x'}
+s:replace{2, 1}
+s:replace{3, 3, 3}
+sk:select()
+sk:select({}, {covered = true})
+s:drop()
+
+-- Included fields are kept plain in compressed tuples.
+s = box.schema.space.create('test', {compression = 'zstd'})
+_ = s:create_index('pk')
+sk = s:create_index('sk', {parts = {2, 'string'}, include = {3}})
+for i = 1, 2000 do s:insert{i, 'user' .. i, i * 2, string.rep('lorem ipsum dolor sit amet ', 8) .. i} end
+sk:select({'user1999'}, {covered = true})
+sk:select({'user1999'})[1][4] == string.rep('lorem ipsum dolor sit amet ', 8) .. 1999
+s:drop()
+
+s = box.schema.space.create('test', {engine = 'vinyl'})
+_ = s:create_index('pk', {include = {2}})
+_ = s:create_index('pk')
+s.index.pk:select({}, {covered = true})
+s:drop()
@@ -301,3 +301,15 @@ s:drop()
 
 box.internal.collation.drop('test')
 box.internal.collation.drop('test-ci')
+
+-- comparison hints: values out of the hinted range and strings
+-- with a common prefix are ordered by full comparison
+s = box.schema.space.create('test')
+i1 = s:create_index('i1', {type = 'tree', parts = {1, 'scalar'}})
+values = {'abcdefgh', 1, 18446744073709551615ULL, -1.5, '', true, -1152921504606846977LL, 'abcdefga', 0.5, -9223372036854775808LL, 1152921504606846976ULL, false, 'abc', 0, -1152921504606846976LL, 1152921504606846975ULL, -1, 'abcdefg'}
+for _, v in ipairs(values) do s:insert{v} end
+s:select{}
+s:select({0.5}, {iterator = 'GE', limit = 3})
+s:select({'abcdefgb'}, {iterator = 'LT', limit = 2})
+i1:get{-1152921504606846977LL}
+s:drop()
@@ -0,0 +1,36 @@
+test_run = require('test_run').new()
+engine = test_run:get_cfg('engine')
+
+--
+-- Field map slots are 1, 2 or 4 bytes wide depending on the
+-- tuple size. Check access to indexed fields for every width.
+--
+s = box.schema.space.create('test', {engine = engine})
+pk = s:create_index('pk')
+i2 = s:create_index('i2', {parts = {3, 'string'}})
+i3 = s:create_index('i3', {parts = {4, 'unsigned', 5, 'string'}})
+s:insert{1, string.rep('a', 10), 'k1', 10, 'x'} ~= nil
+s:insert{2, string.rep('b', 1000), 'k2', 20, 'y'} ~= nil
+s:insert{3, string.rep('c', 70000), 'k3', 30, 'z'} ~= nil
+i2:get{'k1'}[1]
+i2:get{'k2'}[1]
+i2:get{'k3'}[1]
+t = {}
+for _, v in i3:pairs() do table.insert(t, v[1]) end
+t
+
+-- A tuple grows and shrinks across slot width bounds.
+s:update(1, {{'=', 2, string.rep('a', 70000)}})[2]:len()
+i2:get{'k1'}[2]:len()
+i3:get{10, 'x'}[1]
+s:update(3, {{'=', 2, 'c'}})[2]
+i2:get{'k3'}[2]
+i3:get{30, 'z'}[1]
+
+-- An upsert is longer than the tuple it produces.
+s:upsert({4, string.rep('d', 240), 'k4', 40, 'w'}, {{'=', 2, 'd'}})
+s:upsert({4, string.rep('d', 240), 'k4', 40, 'w'}, {{'=', 2, 'd'}})
+i2:get{'k4'}[2]
+i3:get{40, 'w'}[1]
+
+s:drop()
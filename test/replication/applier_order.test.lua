@@ -0,0 +1,70 @@
+test_run = require('test_run').new()
+
+--
+-- Check that the applier submits rows to WAL in the master
+-- order when a transaction yields before the WAL write, e.g.
+-- waiting for vinyl memory quota.
+--
+box.schema.user.grant('guest', 'replication')
+s1 = box.schema.space.create('test1', {engine = 'vinyl'})
+_ = s1:create_index('pk')
+s2 = box.schema.space.create('test2', {engine = 'memtx'})
+_ = s2:create_index('pk')
+
+test_run:cmd("create server replica with rpl_master=default, script='replication/replica_quota.lua'")
+test_run:cmd("start server replica")
+test_run:cmd("switch replica")
+fiber = require('fiber')
+box.error.injection.set('ERRINJ_VY_SCHED_TIMEOUT', 0.01)
+box.error.injection.set('ERRINJ_VY_RUN_WRITE', true)
+
+test_run:cmd("switch default")
+pad = string.rep('x', 1100)
+for i = 1, 2000 do s1:insert{i, pad} end
+s2:insert{1}
+
+-- Vinyl dump is disabled, so the applier gets stuck on quota.
+test_run:cmd("switch replica")
+quota = box.info.vinyl().quota
+while quota.used + 2000 < quota.limit do fiber.sleep(0.01) quota = box.info.vinyl().quota end
+fiber.sleep(0.1)
+-- The memtx row must wait for the vinyl rows before it.
+box.space.test2:count()
+
+box.error.injection.set('ERRINJ_VY_RUN_WRITE', false)
+while box.space.test2:count() == 0 do fiber.sleep(0.01) end
+box.space.test1:count()
+
+-- Check the order of the rows in the replica xlogs.
+fio = require('fio')
+xlog = require('xlog')
+test_run = require('test_run').new()
+test_run:cmd("setopt delimiter ';'")
+function check_order()
+    local files = fio.glob(fio.pathjoin(box.cfg.wal_dir, '*.xlog'))
+    table.sort(files)
+    local prev_lsn = 0
+    local last_space_id = nil
+    for _, path in ipairs(files) do
+        for _, row in xlog.pairs(path) do
+            if row.HEADER.replica_id == 1 then
+                if row.HEADER.lsn <= prev_lsn then
+                    return false
+                end
+                prev_lsn = row.HEADER.lsn
+                last_space_id = row.BODY.space_id
+            end
+        end
+    end
+    return last_space_id == box.space.test2.id
+end;
+test_run:cmd("setopt delimiter ''");
+check_order()
+
+test_run:cmd("switch default")
+test_run:cmd("stop server replica")
+test_run:cmd("cleanup server replica")
+
+s1:drop()
+s2:drop()
+box.schema.user.revoke('guest', 'replication')
@@ -0,0 +1,72 @@
+test_run = require('test_run').new()
+
+box.schema.user.grant('guest', 'replication')
+s1 = box.schema.space.create('test1', {engine = 'vinyl'})
+_ = s1:create_index('pk')
+s2 = box.schema.space.create('test2', {engine = 'vinyl'})
+_ = s2:create_index('pk')
+s3 = box.schema.space.create('test3', {engine = 'memtx'})
+_ = s3:create_index('pk')
+
+test_run:cmd("create server replica with rpl_master=default, script='replication/replica_parallel.lua'")
+test_run:cmd("start server replica")
+test_run:cmd("switch replica")
+fiber = require('fiber')
+box.cfg.replication_parallel_apply
+
+--
+-- Rows of spaces with triggers are applied in order, since
+-- a trigger may depend on other spaces.
+--
+order = {}
+function on_replace(old, new) table.insert(order, new[1]) end
+_ = box.space.test1:on_replace(on_replace)
+_ = box.space.test2:on_replace(on_replace)
+
+test_run:cmd("switch default")
+for i = 1, 100 do box.space['test' .. (i % 2 + 1)]:insert{i} end
+test_run:cmd("switch replica")
+while #order < 100 do fiber.sleep(0.01) end
+ok = true
+for i = 1, 100 do ok = ok and order[i] == i end
+ok
+_ = box.space.test1:on_replace(nil, on_replace)
+_ = box.space.test2:on_replace(nil, on_replace)
+
+--
+-- The vclock sent to the master in ACKs covers only rows
+-- written to WAL on the replica.
+--
+vclock = box.info.replication[1].upstream.vclock
+while vclock[1] ~= box.info.vclock[1] do fiber.sleep(0.01) vclock = box.info.replication[1].upstream.vclock end
+box.error.injection.set('ERRINJ_VY_SCHED_TIMEOUT', 0.01)
+box.error.injection.set('ERRINJ_VY_RUN_WRITE', true)
+
+test_run:cmd("switch default")
+pad = string.rep('x', 1100)
+for i = 1, 1000 do s1:replace{i, pad} s2:replace{i, pad} end
+s3:insert{1}
+
+-- Vinyl dump is disabled, so the applier gets stuck on quota.
+test_run:cmd("switch replica")
+quota = box.info.vinyl().quota
+while quota.used + 2000 < quota.limit do fiber.sleep(0.01) quota = box.info.vinyl().quota end
+fiber.sleep(0.1)
+box.space.test3:count()
+box.info.replication[1].upstream.vclock[1] < box.info.vclock[1]
+
+box.error.injection.set('ERRINJ_VY_RUN_WRITE', false)
+while box.space.test3:count() == 0 do fiber.sleep(0.01) end
+vclock = box.info.replication[1].upstream.vclock
+while vclock[1] ~= box.info.vclock[1] do fiber.sleep(0.01) vclock = box.info.replication[1].upstream.vclock end
+box.space.test1:count()
+box.space.test2:count()
+
+test_run:cmd("switch default")
+test_run:cmd("stop server replica")
+test_run:cmd("cleanup server replica")
+
+s1:drop()
+s2:drop()
+s3:drop()
+box.schema.user.revoke('guest', 'replication')
@@ -0,0 +1,38 @@
+test_run = require('test_run').new()
+
+--
+-- Check that a multi-statement transaction of the master
+-- is applied by the replica as one transaction.
+--
+box.schema.user.grant('guest', 'replication')
+s = box.schema.space.create('test', {engine = test_run:get_cfg('engine')})
+_ = s:create_index('pk')
+
+test_run:cmd("create server replica with rpl_master=default, script='replication/replica.lua'")
+test_run:cmd("start server replica")
+test_run:cmd("switch replica")
+ffi = require('ffi')
+txn_ids = {}
+function on_replace() table.insert(txn_ids, tonumber(ffi.C.box_txn_id())) end
+_ = box.space.test:on_replace(on_replace)
+
+test_run:cmd("switch default")
+box.begin() s:insert{1} s:insert{2} s:insert{3} box.commit()
+s:insert{4}
+box.begin() s:delete{1} s:delete{2} box.commit()
+_ = test_run:wait_lsn('replica', 'default')
+
+test_run:cmd("switch replica")
+box.space.test:select()
+#txn_ids
+txn_ids[1] == txn_ids[2] and txn_ids[2] == txn_ids[3]
+txn_ids[3] ~= txn_ids[4] and txn_ids[4] ~= txn_ids[5]
+txn_ids[5] == txn_ids[6]
+_ = box.space.test:on_replace(nil, on_replace)
+
+test_run:cmd("switch default")
+test_run:cmd("stop server replica")
+test_run:cmd("cleanup server replica")
+
+s:drop()
+box.schema.user.revoke('guest', 'replication')
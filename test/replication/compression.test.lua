@@ -0,0 +1,44 @@
+test_run = require('test_run').new()
+engine = test_run:get_cfg('engine')
+
+box.schema.user.grant('guest', 'replication')
+s = box.schema.space.create('test', {engine = engine})
+_ = s:create_index('pk')
+
+--
+-- The replica negotiates compression on the main connection
+-- and on each JOIN_STREAM connection, so the snapshot file,
+-- the initial and the final join and the subscription all go
+-- compressed.
+--
+pad = string.rep('x', 1000)
+for i = 1, 3000 do s:insert{i, pad} end
+box.snapshot()
+for i = 3001, 3010 do s:insert{i, pad} end
+
+test_run:cmd("create server replica with rpl_master=default, script='replication/replica_compression.lua'")
+test_run:cmd("start server replica")
+
+test_run:cmd("setopt delimiter ';'")
+function check(count)
+    return test_run:wait_cond(function()
+        return test_run:eval('replica', 'return box.space.test:count()')[1] == count
+    end)
+end;
+test_run:cmd("setopt delimiter ''");
+check(3010)
+for i = 3011, 4000 do s:insert{i, pad} end
+check(4000)
+test_run:eval('replica', 'return box.space.test:get(4000)[2] == string.rep("x", 1000)')
+test_run:eval('replica', 'return box.info.replication[1].upstream.status')
+
+-- The replica acknowledgements come compressed too.
+master_id = test_run:get_server_id('default')
+replica_id = test_run:get_server_id('replica')
+test_run:wait_cond(function() return box.info.replication[replica_id].downstream.vclock[master_id] == box.info.vclock[master_id] end)
+
+test_run:cmd("stop server replica")
+test_run:cmd("cleanup server replica")
+test_run:cmd("delete server replica")
+s:drop()
+box.schema.user.revoke('guest', 'replication')
@@ -0,0 +1,34 @@
+test_run = require('test_run').new()
+engine = test_run:get_cfg('engine')
+
+box.schema.user.grant('guest', 'replication')
+s = box.schema.space.create('test', {engine = engine})
+_ = s:create_index('pk')
+
+--
+-- The snapshot is larger than a JOIN_FILE chunk, so it is sent
+-- in several chunks. Rows written after the checkpoint come
+-- with the final join.
+--
+pad = string.rep('x', 1000)
+for i = 1, 3000 do s:insert{i, pad} end
+box.snapshot()
+for i = 3001, 3010 do s:insert{i, pad} end
+
+test_run:cmd("create server replica with rpl_master=default, script='replication/replica_join_files.lua'")
+test_run:cmd("start server replica")
+test_run:cmd("switch replica")
+box.cfg.replication_join_files
+box.info.replication[1].upstream.status
+box.space.test:count()
+box.space.test:get(1)[2] == string.rep('x', 1000)
+box.space.test:get(3010)[1]
+-- The received file is removed once applied.
+fio = require('fio')
+#fio.glob(fio.pathjoin(box.cfg.memtx_dir, '*.inprogress'))
+
+test_run:cmd("switch default")
+test_run:cmd("stop server replica")
+test_run:cmd("cleanup server replica")
+s:drop()
+box.schema.user.revoke('guest', 'replication')
@@ -0,0 +1,55 @@
+test_run = require('test_run').new()
+engine = test_run:get_cfg('engine')
+
+box.schema.user.grant('guest', 'replication')
+
+--
+-- User spaces are partitioned among three join streams by space
+-- id; system spaces go over the JOIN connection.
+--
+spaces = {}
+for i = 1, 6 do spaces[i] = box.schema.space.create('test' .. i, {engine = engine}) spaces[i]:create_index('pk') end
+for i = 1, 6 do for j = 1, 100 * i do spaces[i]:insert{j} end end
+box.snapshot()
+for i = 1, 6 do spaces[i]:insert{1000} end
+
+test_run:cmd("create server replica with rpl_master=default, script='replication/replica_join_streams.lua'")
+test_run:cmd("start server replica")
+test_run:cmd("switch replica")
+box.cfg.replication_join_streams
+box.info.replication[1].upstream.status
+counts = {}
+for i = 1, 6 do counts[i] = box.space['test' .. i]:count() end
+counts
+test_run:cmd("switch default")
+test_run:cmd("stop server replica")
+test_run:cmd("cleanup server replica")
+test_run:cmd("delete server replica")
+
+--
+-- JOIN_STREAM is accepted only for a JOIN in progress.
+--
+msgpack = require('msgpack')
+socket = require('socket')
+uuid = require('uuid')
+LISTEN = require('uri').parse(box.cfg.listen)
+test_run:cmd("setopt delimiter ';'")
+function join_stream(id, count)
+    local s = socket.tcp_connect(LISTEN.host, LISTEN.service)
+    s:read(128)
+    local header = msgpack.encode({[0x00] = 69, [0x01] = 1})
+    local body = msgpack.encode({[0x24] = uuid.str(), [0x2c] = id, [0x2b] = count,
+                                 [0x26] = setmetatable({}, {__serialize = 'map'})})
+    s:write(msgpack.encode(#header + #body) .. header .. body)
+    local size = msgpack.decode(s:read(5))
+    local data = s:read(size)
+    s:close()
+    local _, pos = msgpack.decode(data)
+    return (msgpack.decode(data, pos))[0x31]
+end;
+test_run:cmd("setopt delimiter ''");
+join_stream(0, 2)
+join_stream(1, 2)
+
+for i = 1, 6 do spaces[i]:drop() end
+box.schema.user.revoke('guest', 'replication')
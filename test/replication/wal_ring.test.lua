@@ -0,0 +1,47 @@
+test_run = require('test_run').new()
+engine = test_run:get_cfg('engine')
+
+box.cfg{wal_ring_size = -1}
+box.cfg.wal_ring_size
+
+box.schema.user.grant('guest', 'replication')
+s = box.schema.space.create('test', {engine = engine})
+_ = s:create_index('pk')
+-- Rows written while there are no relays aren't kept in the ring.
+for i = 1, 100 do s:insert{i} end
+
+test_run:cmd("create server replica with rpl_master=default, script='replication/replica.lua'")
+test_run:cmd("start server replica")
+
+test_run:cmd("setopt delimiter ';'")
+function check(count)
+    return test_run:wait_cond(function()
+        return test_run:eval('replica', 'return box.space.test:count()')[1] == count
+    end)
+end;
+test_run:cmd("setopt delimiter ''");
+check(100)
+for i = 101, 200 do s:insert{i} end
+check(200)
+
+--
+-- The ring can be resized and disabled on the fly, relays fall
+-- back on xlog files when it doesn't have the rows they need.
+--
+box.cfg{wal_ring_size = 0}
+for i = 201, 300 do s:insert{i} end
+check(300)
+box.cfg{wal_ring_size = 1}
+pad = string.rep('x', 1000)
+for i = 301, 1000 do s:insert{i, pad} end
+check(1000)
+box.cfg{wal_ring_size = 16 * 1024 * 1024}
+for i = 1001, 1100 do s:insert{i} end
+check(1100)
+test_run:eval('replica', 'return box.info.replication[1].upstream.status')
+
+test_run:cmd("stop server replica")
+test_run:cmd("cleanup server replica")
+test_run:cmd("delete server replica")
+s:drop()
+box.schema.user.revoke('guest', 'replication')
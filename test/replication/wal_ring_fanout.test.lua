@@ -0,0 +1,54 @@
+test_run = require('test_run').new()
+engine = test_run:get_cfg('engine')
+
+box.schema.user.grant('guest', 'replication')
+s = box.schema.space.create('test', {engine = engine})
+_ = s:create_index('pk')
+
+test_run:cmd("create server replica1 with rpl_master=default, script='replication/replica.lua'")
+test_run:cmd("start server replica1")
+test_run:cmd("create server replica2 with rpl_master=default, script='replication/replica.lua'")
+test_run:cmd("start server replica2")
+
+test_run:cmd("setopt delimiter ';'")
+function count(replica)
+    return test_run:eval(replica, 'return box.space.test:count()')[1]
+end;
+function acked(id)
+    local downstream = box.info.replication[id].downstream
+    return downstream ~= nil and downstream.vclock ~= nil and
+           downstream.vclock[1] == box.info.vclock[1]
+end;
+test_run:cmd("setopt delimiter ''");
+
+--
+-- Rows are sent to all replicas from the WAL ring. A replica
+-- which stops reading blocks its relay, but not the others.
+--
+test_run:cmd("switch replica2")
+box.error.injection.set('ERRINJ_WAL_DELAY', true)
+test_run:cmd("switch default")
+pad = string.rep('x', 10000)
+for i = 1, 1000 do s:insert{i, pad} end
+test_run:wait_cond(function() return count('replica1') == 1000 end)
+count('replica2') < 1000
+test_run:cmd("switch replica2")
+box.error.injection.set('ERRINJ_WAL_DELAY', false)
+test_run:cmd("switch default")
+test_run:wait_cond(function() return count('replica2') == 1000 end)
+
+-- Both replicas have received and acknowledged all rows.
+test_run:wait_cond(function() return acked(2) and acked(3) end)
+for i = 1001, 1100 do s:insert{i} end
+test_run:wait_cond(function() return acked(2) and acked(3) end)
+count('replica1')
+count('replica2')
+
+test_run:cmd("stop server replica1")
+test_run:cmd("cleanup server replica1")
+test_run:cmd("delete server replica1")
+test_run:cmd("stop server replica2")
+test_run:cmd("cleanup server replica2")
+test_run:cmd("delete server replica2")
+s:drop()
+box.schema.user.revoke('guest', 'replication')
@@ -0,0 +1,40 @@
+test_run = require('test_run').new()
+engine = test_run:get_cfg('engine')
+
+box.schema.user.grant('guest', 'replication')
+s = box.schema.space.create('test', {engine = engine})
+_ = s:create_index('pk')
+
+test_run:cmd("create server replica with rpl_master=default, script='replication/replica.lua'")
+test_run:cmd("start server replica")
+
+function count() return test_run:eval('replica', 'return box.space.test:count()')[1] end
+for i = 1, 10 do s:insert{i} end
+test_run:wait_cond(function() return count() == 10 end)
+
+--
+-- A WAL write which fails to append its rows to the ring empties
+-- the ring. The relay must not take the ring for having all rows
+-- following its position then: the rows of the failed write are
+-- on disk, but not in the ring, so they are read from xlog files.
+--
+box.error.injection.set('ERRINJ_WAL_RING_APPEND', true)
+for i = 11, 20 do s:insert{i} end
+box.error.injection.set('ERRINJ_WAL_RING_APPEND', false)
+for i = 21, 30 do s:insert{i} end
+test_run:wait_cond(function() return count() == 30 end)
+
+-- Same when the ring is disabled and enabled again.
+box.cfg{wal_ring_size = 0}
+for i = 31, 40 do s:insert{i} end
+box.cfg{wal_ring_size = 16 * 1024 * 1024}
+for i = 41, 50 do s:insert{i} end
+test_run:wait_cond(function() return count() == 50 end)
+test_run:eval('replica', 'return box.space.test:select{}')[1]
+test_run:eval('replica', 'return box.info.replication[1].upstream.status')
+
+test_run:cmd("stop server replica")
+test_run:cmd("cleanup server replica")
+test_run:cmd("delete server replica")
+s:drop()
+box.schema.user.revoke('guest', 'replication')
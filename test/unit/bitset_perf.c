@@ -0,0 +1,153 @@
+/*
+ * A bitset set operation benchmark.
+ *
+ * Fills paged and roaring bitsets with values of several
+ * distributions, then reports memory usage and the time it takes
+ * to evaluate intersections and unions of the bitsets with
+ * iterators.
+ *
+ * Usage: bitset_perf [range [iteration_count]]
+ */
+#include <assert.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+#include <bitset/iterator.h>
+
+/* Values are taken from [0, range). */
+static size_t range = 1 << 24;
+/* Number of times each expression is evaluated. */
+static int iteration_count = 10;
+
+enum { BITSET_COUNT = 2 };
+
+struct distribution {
+	const char *name;
+	/* Return true if pos is set in bitset b. */
+	bool (*test)(size_t b, size_t pos);
+};
+
+static bool
+sparse_test(size_t b, size_t pos)
+{
+	(void)pos;
+	(void)b;
+	return rand() % 1000 == 0;
+}
+
+static bool
+dense_test(size_t b, size_t pos)
+{
+	(void)pos;
+	(void)b;
+	return rand() % 2 == 0;
+}
+
+static bool
+clustered_test(size_t b, size_t pos)
+{
+	/* Runs of 1000 set bits every 4000 bits, shifted per bitset. */
+	return (pos + b * 500) % 4000 < 1000;
+}
+
+static const struct distribution distributions[] = {
+	{ "sparse", sparse_test },
+	{ "dense", dense_test },
+	{ "clustered", clustered_test },
+};
+
+static double
+clock_now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static double
+bench_expr(struct bitset **bitsets, bool is_union, size_t *count)
+{
+	struct bitset_expr expr;
+	bitset_expr_create(&expr, realloc);
+	if (bitset_expr_add_conj(&expr) != 0)
+		abort();
+	for (size_t b = 0; b < BITSET_COUNT; b++) {
+		if (is_union && b > 0 && bitset_expr_add_conj(&expr) != 0)
+			abort();
+		if (bitset_expr_add_param(&expr, b, false) != 0)
+			abort();
+	}
+	struct bitset_iterator it;
+	bitset_iterator_create(&it, realloc);
+	double start = clock_now();
+	for (int i = 0; i < iteration_count; i++) {
+		if (bitset_iterator_init(&it, &expr, bitsets,
+					 BITSET_COUNT) != 0)
+			abort();
+		*count = 0;
+		while (bitset_iterator_next(&it) != SIZE_MAX)
+			++*count;
+	}
+	double elapsed = clock_now() - start;
+	bitset_iterator_destroy(&it);
+	bitset_expr_destroy(&expr);
+	return elapsed / iteration_count;
+}
+
+static void
+bench(const struct distribution *d, enum bitset_type type)
+{
+	struct bitset bitsets[BITSET_COUNT];
+	struct bitset *p_bitsets[BITSET_COUNT];
+	size_t mem_total = 0;
+	srand(0);
+	double start = clock_now();
+	for (size_t b = 0; b < BITSET_COUNT; b++) {
+		if (type == BITSET_ROARING)
+			bitset_create_roaring(&bitsets[b], realloc);
+		else
+			bitset_create(&bitsets[b], realloc);
+		p_bitsets[b] = &bitsets[b];
+		for (size_t pos = 0; pos < range; pos++) {
+			if (d->test(b, pos) && bitset_set(&bitsets[b], pos) < 0)
+				abort();
+		}
+	}
+	double fill = clock_now() - start;
+	for (size_t b = 0; b < BITSET_COUNT; b++) {
+		struct bitset_info info;
+		bitset_info(&bitsets[b], &info);
+		mem_total += info.mem_total;
+	}
+	size_t and_count, or_count;
+	double and_time = bench_expr(p_bitsets, false, &and_count);
+	double or_time = bench_expr(p_bitsets, true, &or_count);
+	printf("%-9s %-7s: %8zu KB, fill %.3f s, "
+	       "and %.4f s (%zu), or %.4f s (%zu)\n", d->name,
+	       type == BITSET_ROARING ? "roaring" : "paged", mem_total / 1024,
+	       fill, and_time, and_count, or_time, or_count);
+	for (size_t b = 0; b < BITSET_COUNT; b++)
+		bitset_destroy(&bitsets[b]);
+}
+
+int
+main(int argc, char **argv)
+{
+	if (argc > 1)
+		range = atol(argv[1]);
+	if (argc > 2)
+		iteration_count = atoi(argv[2]);
+	if (range == 0 || iteration_count <= 0) {
+		fprintf(stderr, "usage: %s [range [iteration_count]]\n",
+			argv[0]);
+		return 1;
+	}
+	for (size_t i = 0; i < sizeof(distributions) /
+			       sizeof(distributions[0]); i++) {
+		bench(&distributions[i], BITSET_PAGED);
+		bench(&distributions[i], BITSET_ROARING);
+	}
+	return 0;
+}
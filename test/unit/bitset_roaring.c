@@ -0,0 +1,273 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#include <bitset/iterator.h>
+#include <bitset/container.h>
+#include "unit.h"
+
+enum { BITSETS_SIZE = 4 };
+
+/*
+ * Positions are generated in a few clusters spread over several
+ * containers, so that all container types are exercised.
+ */
+static size_t
+rand_pos(void)
+{
+	static const size_t bases[] = {
+		0, 3 * BITSET_CONTAINER_BITS, 10 * BITSET_CONTAINER_BITS + 100,
+		SIZE_MAX / 2,
+	};
+	size_t base = bases[rand() % lengthof(bases)];
+	switch (rand() % 3) {
+	case 0:
+		return base + rand() % 64;
+	case 1:
+		return base + rand() % 5000;
+	default:
+		return base + rand() % (2 * BITSET_CONTAINER_BITS);
+	}
+}
+
+static void
+bitsets_create(struct bitset *bitsets, struct bitset *roaring, size_t count)
+{
+	for (size_t i = 0; i < count; i++) {
+		bitset_create(&bitsets[i], realloc);
+		bitset_create_roaring(&roaring[i], realloc);
+	}
+}
+
+static void
+bitsets_destroy(struct bitset *bitsets, struct bitset *roaring, size_t count)
+{
+	for (size_t i = 0; i < count; i++) {
+		bitset_destroy(&bitsets[i]);
+		bitset_destroy(&roaring[i]);
+	}
+}
+
+static void
+check_equal(struct bitset *bitset, struct bitset *roaring)
+{
+	fail_unless(bitset_cardinality(bitset) == bitset_cardinality(roaring));
+	struct bitset_info info;
+	/* Checks cardinality of containers. */
+	bitset_info(roaring, &info);
+
+	struct bitset_expr expr;
+	bitset_expr_create(&expr, realloc);
+	fail_unless(bitset_expr_add_conj(&expr) == 0);
+	fail_unless(bitset_expr_add_param(&expr, 0, false) == 0);
+
+	struct bitset_iterator it, roaring_it;
+	bitset_iterator_create(&it, realloc);
+	bitset_iterator_create(&roaring_it, realloc);
+	fail_unless(bitset_iterator_init(&it, &expr, &bitset, 1) == 0);
+	fail_unless(bitset_iterator_init(&roaring_it, &expr, &roaring, 1) == 0);
+	size_t pos;
+	size_t count = 0;
+	do {
+		pos = bitset_iterator_next(&it);
+		fail_unless(bitset_iterator_next(&roaring_it) == pos);
+		fail_unless(pos == SIZE_MAX || bitset_test(roaring, pos));
+		count++;
+	} while (pos != SIZE_MAX);
+	fail_unless(count == bitset_cardinality(bitset) + 1);
+	bitset_iterator_destroy(&it);
+	bitset_iterator_destroy(&roaring_it);
+	bitset_expr_destroy(&expr);
+}
+
+static void
+test_set_clear(void)
+{
+	header();
+
+	struct bitset bitset, roaring;
+	bitsets_create(&bitset, &roaring, 1);
+	for (int i = 0; i < 200000; i++) {
+		size_t pos = rand_pos();
+		/* Clear bits less often to let the bitset grow. */
+		if (rand() % 3 == 0) {
+			fail_unless(bitset_clear(&roaring, pos) ==
+				    bitset_clear(&bitset, pos));
+		} else {
+			fail_unless(bitset_set(&roaring, pos) ==
+				    bitset_set(&bitset, pos));
+		}
+		fail_unless(bitset_test(&roaring, pos) ==
+			    bitset_test(&bitset, pos));
+		if (i % 50000 == 0)
+			check_equal(&bitset, &roaring);
+	}
+	check_equal(&bitset, &roaring);
+	bitsets_destroy(&bitset, &roaring, 1);
+
+	footer();
+}
+
+static void
+check_container(struct bitset *bitset, size_t key,
+		enum bitset_container_type type)
+{
+	struct bitset_container *c = bitset_container_find(bitset, key);
+	fail_unless(c != NULL);
+	fail_unless(c->type == type);
+}
+
+static void
+test_containers(void)
+{
+	header();
+
+	struct bitset bitset;
+	bitset_create_roaring(&bitset, realloc);
+
+	/* Sparse values are kept in an array. */
+	for (size_t pos = 0; pos < 200; pos += 2)
+		fail_unless(bitset_set(&bitset, pos) == 0);
+	check_container(&bitset, 0, BITSET_CONTAINER_ARRAY);
+
+	/* A long sequence is kept as a run. */
+	for (size_t pos = 0; pos < 20000; pos++)
+		fail_if(bitset_set(&bitset, pos) < 0);
+	check_container(&bitset, 0, BITSET_CONTAINER_RUN);
+
+	/* Many short runs are kept in a bitmap. */
+	for (size_t pos = 1; pos < 20000; pos += 2)
+		fail_unless(bitset_clear(&bitset, pos) == 1);
+	check_container(&bitset, 0, BITSET_CONTAINER_BITMAP);
+
+	/* ... until there are few enough values for an array. */
+	for (size_t pos = 2000; pos < 20000; pos += 2)
+		fail_unless(bitset_clear(&bitset, pos) == 1);
+	check_container(&bitset, 0, BITSET_CONTAINER_ARRAY);
+	fail_unless(bitset_cardinality(&bitset) == 1000);
+
+	for (size_t pos = 0; pos < 2000; pos += 2)
+		fail_unless(bitset_clear(&bitset, pos) == 1);
+	fail_unless(bitset_container_find(&bitset, 0) == NULL);
+	fail_unless(bitset_cardinality(&bitset) == 0);
+
+	struct bitset_info info;
+	bitset_info(&bitset, &info);
+	fail_unless(info.containers == 0);
+
+	bitset_destroy(&bitset);
+
+	footer();
+}
+
+static void
+check_expr(struct bitset_expr *expr, struct bitset **bitsets,
+	   struct bitset **roaring)
+{
+	struct bitset_iterator it, roaring_it;
+	bitset_iterator_create(&it, realloc);
+	bitset_iterator_create(&roaring_it, realloc);
+	fail_unless(bitset_iterator_init(&it, expr, bitsets,
+					 BITSETS_SIZE) == 0);
+	fail_unless(bitset_iterator_init(&roaring_it, expr, roaring,
+					 BITSETS_SIZE) == 0);
+	size_t pos;
+	do {
+		pos = bitset_iterator_next(&it);
+		fail_unless(bitset_iterator_next(&roaring_it) == pos);
+	} while (pos != SIZE_MAX);
+	bitset_iterator_destroy(&it);
+	bitset_iterator_destroy(&roaring_it);
+}
+
+/** Check random expressions on paged and roaring bitsets. */
+static void
+check_exprs(struct bitset **bitsets, struct bitset **roaring)
+{
+	struct bitset_expr expr;
+	bitset_expr_create(&expr, realloc);
+	for (int i = 0; i < 100; i++) {
+		bitset_expr_clear(&expr);
+		int conj_count = 1 + rand() % 3;
+		for (int c = 0; c < conj_count; c++) {
+			fail_unless(bitset_expr_add_conj(&expr) == 0);
+			/* The first bitset is never negated. */
+			fail_unless(bitset_expr_add_param(&expr,
+					rand() % BITSETS_SIZE, false) == 0);
+			int param_count = rand() % 3;
+			for (int p = 0; p < param_count; p++) {
+				fail_unless(bitset_expr_add_param(&expr,
+						rand() % BITSETS_SIZE,
+						rand() % 2) == 0);
+			}
+		}
+		check_expr(&expr, bitsets, roaring);
+	}
+	bitset_expr_destroy(&expr);
+}
+
+static void
+test_iterator(void)
+{
+	header();
+
+	struct bitset bitsets[BITSETS_SIZE], roaring[BITSETS_SIZE];
+	struct bitset *p_bitsets[BITSETS_SIZE], *p_roaring[BITSETS_SIZE];
+	bitsets_create(bitsets, roaring, BITSETS_SIZE);
+	for (size_t b = 0; b < BITSETS_SIZE; b++) {
+		p_bitsets[b] = &bitsets[b];
+		p_roaring[b] = &roaring[b];
+	}
+	for (int i = 0; i < 100000; i++) {
+		size_t b = rand() % BITSETS_SIZE;
+		size_t pos = rand_pos();
+		fail_if(bitset_set(&bitsets[b], pos) < 0);
+		fail_if(bitset_set(&roaring[b], pos) < 0);
+	}
+	check_exprs(p_bitsets, p_roaring);
+	bitsets_destroy(bitsets, roaring, BITSETS_SIZE);
+
+	footer();
+}
+
+/*
+ * Array containers only: windows are evaluated as sorted arrays,
+ * except when the union of conjunctions doesn't fit an array.
+ */
+static void
+test_iterator_sparse(void)
+{
+	header();
+
+	struct bitset bitsets[BITSETS_SIZE], roaring[BITSETS_SIZE];
+	struct bitset *p_bitsets[BITSETS_SIZE], *p_roaring[BITSETS_SIZE];
+	bitsets_create(bitsets, roaring, BITSETS_SIZE);
+	for (size_t b = 0; b < BITSETS_SIZE; b++) {
+		p_bitsets[b] = &bitsets[b];
+		p_roaring[b] = &roaring[b];
+		for (int i = 0; i < 3000; i++) {
+			size_t pos = rand() % (2 * BITSET_CONTAINER_BITS);
+			fail_if(bitset_set(&bitsets[b], pos) < 0);
+			fail_if(bitset_set(&roaring[b], pos) < 0);
+		}
+		fail_unless(bitset_container_find(&roaring[b], 0)->type ==
+			    BITSET_CONTAINER_ARRAY);
+	}
+	check_exprs(p_bitsets, p_roaring);
+	bitsets_destroy(bitsets, roaring, BITSETS_SIZE);
+
+	footer();
+}
+
+int
+main(void)
+{
+	setbuf(stdout, NULL);
+	srand(0);
+	test_set_clear();
+	test_containers();
+	test_iterator();
+	test_iterator_sparse();
+	return 0;
+}
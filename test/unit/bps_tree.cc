@@ -70,6 +70,32 @@ compare(type_t a, type_t b);
 #define bps_tree_key_t uint32_t
 #define bps_tree_arg_t int
 #include "salad/bps_tree.h"
+#undef BPS_TREE_NAME
+#undef BPS_TREE_BLOCK_SIZE
+#undef BPS_TREE_EXTENT_SIZE
+#undef BPS_TREE_COMPARE
+#undef BPS_TREE_COMPARE_KEY
+#undef bps_tree_elem_t
+#undef bps_tree_key_t
+#undef bps_tree_arg_t
+
+/* tree of elements with a payload for delete_value test */
+struct pair {
+	type_t key;
+	type_t payload;
+};
+
+#define BPS_TREE_NAME pair_tree
+#define BPS_TREE_BLOCK_SIZE 128 /* value is to low specially for tests */
+#define BPS_TREE_EXTENT_SIZE 2048 /* value is to low specially for tests */
+#define BPS_TREE_COMPARE(a, b, arg) compare((a).key, (b).key)
+#define BPS_TREE_COMPARE_KEY(a, b, arg) compare((a).key, b)
+#define bps_tree_elem_t struct pair
+#define bps_tree_key_t type_t
+#define bps_tree_arg_t int
+#define BPS_TREE_NO_DEBUG
+#include "salad/bps_tree.h"
+#undef BPS_TREE_NO_DEBUG
 
 #define bps_insert_and_check(tree_name, tree, elem, replaced) \
 {\
@@ -582,6 +608,85 @@ loading_test()
 	footer();
 }
 
+/**
+ * Check the leaf occupancy the builder promises: at least 2/3
+ * of the capacity when there are three leaves or more, at least
+ * half of it when there are two.
+ */
+static void
+builder_check_leaves(test *tree)
+{
+	if (tree->leaf_count < 2)
+		return;
+	const int min_count = tree->leaf_count == 2 ?
+			      BPS_TREE_test_MAX_COUNT_IN_LEAF / 2 :
+			      BPS_TREE_test_MAX_COUNT_IN_LEAF * 2 / 3;
+	bps_tree_block_id_t id = tree->first_id;
+	while (id != (bps_tree_block_id_t)(-1)) {
+		struct bpstest_leaf *leaf = (struct bpstest_leaf *)
+			matras_get(&tree->matras, id);
+		if (leaf->header.size < min_count)
+			fail("builder leaf is underfilled", "true");
+		id = leaf->next_id;
+	}
+}
+
+static void
+builder_test()
+{
+	header();
+
+	test tree;
+	struct test_builder builder;
+
+	const type_t test_count = 1000;
+	const double fill_factors[] = {1, 0.8, 0.5};
+	const size_t fill_factor_count =
+		sizeof(fill_factors) / sizeof(fill_factors[0]);
+
+	for (size_t f = 0; f < fill_factor_count; f++) {
+		for (type_t i = 0; i <= test_count; i++) {
+			test_create(&tree, 0, extent_alloc, extent_free,
+				    &extents_count);
+			test_builder_create(&builder, &tree, fill_factors[f]);
+			for (type_t j = 0; j < i; j++) {
+				if (test_builder_append(&builder, 2 * j))
+					fail("building failed", "true");
+			}
+			if (test_builder_finish(&builder))
+				fail("building failed", "true");
+
+			if (test_debug_check(&tree))
+				fail("debug check nonzero", "true");
+			builder_check_leaves(&tree);
+
+			struct test_iterator iterator;
+			iterator = test_iterator_first(&tree);
+			for (type_t j = 0; j < i; j++) {
+				type_t *v = test_iterator_get_elem(&tree,
+								   &iterator);
+				if (!v || *v != 2 * j)
+					fail("wrong build result", "true");
+				test_iterator_next(&tree, &iterator);
+			}
+			if (!test_iterator_is_invalid(&iterator))
+				fail("wrong build result", "true");
+
+			/* The tree must stay valid after modifications. */
+			for (type_t j = 0; j < i; j++)
+				test_insert(&tree, 2 * j + 1, 0);
+			for (type_t j = 0; j < 2 * i; j += 3)
+				test_delete(&tree, j);
+			if (test_debug_check(&tree))
+				fail("debug check nonzero", "true");
+
+			test_destroy(&tree);
+		}
+	}
+
+	footer();
+}
+
 static void
 printing_test()
 {
@@ -792,6 +897,41 @@ insert_get_iterator()
 	footer();
 }
 
+static void
+delete_value()
+{
+	header();
+
+	pair_tree tree;
+	pair_tree_create(&tree, 0, extent_alloc, extent_free, &extents_count);
+	const type_t count = 10000;
+	for (type_t i = 0; i < count; i++) {
+		struct pair p = {i, i * 10};
+		pair_tree_insert(&tree, p, NULL);
+	}
+	for (type_t i = 0; i < count; i += 2) {
+		struct pair p = {i, -1};
+		struct pair deleted = {-1, -1};
+		if (pair_tree_delete_value(&tree, p, &deleted) != 0)
+			fail("element is not deleted", "true");
+		if (deleted.key != i || deleted.payload != i * 10)
+			fail("wrong element is returned", "true");
+		if (pair_tree_find(&tree, i) != NULL)
+			fail("element is found after delete", "true");
+	}
+	struct pair p = {0, -1};
+	struct pair deleted = {-1, -1};
+	if (pair_tree_delete_value(&tree, p, &deleted) == 0)
+		fail("deleted element is deleted again", "true");
+	if (deleted.key != -1 || deleted.payload != -1)
+		fail("deleted element is touched on miss", "true");
+	if (pair_tree_size(&tree) != (size_t)count / 2)
+		fail("wrong tree size", "true");
+	pair_tree_destroy(&tree);
+
+	footer();
+}
+
 int
 main(void)
 {
@@ -800,10 +940,12 @@ main(void)
 	compare_with_sptree_check_branches();
 	bps_tree_debug_self_check();
 	loading_test();
+	builder_test();
 	printing_test();
 	white_box_test();
 	approximate_count();
 	if (extents_count != 0)
 		fail("memory leak!", "true");
 	insert_get_iterator();
+	delete_value();
 }
@@ -0,0 +1,185 @@
+/*
+ * A cbus throughput benchmark.
+ *
+ * Several producer threads send messages to a single consumer
+ * thread, which routes them back, like the net thread does with
+ * requests to tx. Each producer keeps a fixed number of messages
+ * in flight and re-sends each message as soon as it returns.
+ *
+ * Usage: cbus_perf [producer_count [message_count [window]]]
+ */
+#include <assert.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "clock.h"
+#include "memory.h"
+#include "fiber.h"
+#include "cbus.h"
+
+/* Number of producer threads. */
+static int producer_count = 4;
+/* Number of round trips made by each producer. */
+static int message_count = 1000000;
+/* Number of messages in flight per producer. */
+static int window = 64;
+
+struct producer {
+	/* Name of the endpoint hosted by the producer thread. */
+	char name[32];
+	struct cord cord;
+	/* Pipe from the producer to the consumer. */
+	struct cpipe to_consumer;
+	/* Pipe from the consumer back to the producer. */
+	struct cpipe to_producer;
+	/* Route of the messages sent by this producer. */
+	struct cmsg_hop route[2];
+	struct cmsg *msgs;
+	/* Number of messages sent and returned. */
+	int sent;
+	int received;
+};
+
+static void
+consume_cb(struct cmsg *msg)
+{
+	(void)msg;
+}
+
+static void
+producer_send(struct producer *p, struct cmsg *msg)
+{
+	cmsg_init(msg, p->route);
+	cpipe_push_input(&p->to_consumer, msg);
+	p->sent++;
+}
+
+static void
+return_cb(struct cmsg *msg)
+{
+	struct producer *p = container_of(msg->route, struct producer,
+					  route[0]);
+	p->received++;
+	if (p->sent < message_count)
+		producer_send(p, msg);
+}
+
+static int
+producer_f(va_list ap)
+{
+	struct producer *p = va_arg(ap, struct producer *);
+
+	struct cbus_endpoint endpoint;
+	cbus_endpoint_create(&endpoint, p->name, fiber_schedule_cb, fiber());
+	cbus_pair("consumer", p->name, &p->to_consumer, &p->to_producer,
+		  NULL, NULL, cbus_process);
+
+	p->route[0].f = consume_cb;
+	p->route[0].pipe = &p->to_producer;
+	p->route[1].f = return_cb;
+	p->route[1].pipe = NULL;
+	p->msgs = calloc(window, sizeof(*p->msgs));
+	assert(p->msgs != NULL);
+	for (int i = 0; i < window && i < message_count; i++)
+		producer_send(p, &p->msgs[i]);
+	cpipe_flush_input(&p->to_consumer);
+
+	while (p->received < p->sent) {
+		cbus_process(&endpoint);
+		cpipe_flush_input(&p->to_consumer);
+		if (p->received < p->sent)
+			fiber_yield();
+	}
+
+	cbus_unpair(&p->to_consumer, &p->to_producer, NULL, NULL,
+		    cbus_process);
+	cbus_endpoint_destroy(&endpoint, cbus_process);
+	free(p->msgs);
+	return 0;
+}
+
+static int
+consumer_f(va_list ap)
+{
+	(void)ap;
+	struct cbus_endpoint endpoint;
+	cbus_endpoint_create(&endpoint, "consumer", fiber_schedule_cb,
+			     fiber());
+	cbus_endpoint_set_spin(&endpoint, CBUS_SPIN_TIMEOUT);
+	cbus_loop(&endpoint);
+	cbus_endpoint_destroy(&endpoint, cbus_process);
+	return 0;
+}
+
+static int
+main_f(va_list ap)
+{
+	(void)ap;
+	struct cord consumer;
+	if (cord_costart(&consumer, "consumer", consumer_f, NULL) != 0)
+		unreachable();
+	struct cpipe consumer_pipe;
+	cpipe_create(&consumer_pipe, "consumer");
+
+	struct producer *producers = calloc(producer_count,
+					    sizeof(*producers));
+	assert(producers != NULL);
+
+	double start = clock_monotonic();
+	for (int i = 0; i < producer_count; i++) {
+		struct producer *p = &producers[i];
+		snprintf(p->name, sizeof(p->name), "producer_%d", i);
+		if (cord_costart(&p->cord, p->name, producer_f, p) != 0)
+			unreachable();
+	}
+	for (int i = 0; i < producer_count; i++) {
+		if (cord_cojoin(&producers[i].cord) != 0)
+			unreachable();
+	}
+	double elapsed = clock_monotonic() - start;
+
+	long long total = (long long)producer_count * message_count;
+	printf("producers: %d, round trips: %lld, window: %d\n",
+	       producer_count, total, window);
+	printf("elapsed: %.3f s, %.0f round trips/s\n",
+	       elapsed, total / elapsed);
+
+	free(producers);
+	cbus_stop_loop(&consumer_pipe);
+	cpipe_destroy(&consumer_pipe);
+	if (cord_cojoin(&consumer) != 0)
+		unreachable();
+	ev_break(loop(), EVBREAK_ALL);
+	return 0;
+}
+
+int
+main(int argc, char **argv)
+{
+	if (argc > 1)
+		producer_count = atoi(argv[1]);
+	if (argc > 2)
+		message_count = atoi(argv[2]);
+	if (argc > 3)
+		window = atoi(argv[3]);
+	if (producer_count <= 0 || message_count <= 0 || window <= 0) {
+		fprintf(stderr, "usage: %s [producer_count "
+			"[message_count [window]]]\n", argv[0]);
+		return 1;
+	}
+
+	memory_init();
+	fiber_init(fiber_c_invoke);
+	cbus_init();
+
+	struct fiber *main_fiber = fiber_new("main", main_f);
+	assert(main_fiber != NULL);
+	fiber_wakeup(main_fiber);
+	ev_run(loop(), 0);
+
+	cbus_free();
+	fiber_free();
+	memory_free();
+	return 0;
+}
@@ -68,6 +68,47 @@ test_call_f(va_list ap)
 	return res;
 }
 
+static bool bulk_is_released = false;
+
+static ssize_t
+coio_test_bulk(va_list ap)
+{
+	while (!__atomic_load_n(&bulk_is_released, __ATOMIC_SEQ_CST))
+		usleep(1000);
+	return 0;
+}
+
+static int
+bulk_f(va_list ap)
+{
+	return coio_call_class(COIO_BULK, coio_test_bulk);
+}
+
+static int
+test_priority_f(va_list ap)
+{
+	header();
+	enum { BULK_COUNT = 8 };
+	coio_set_worker_count(4);
+	struct fiber *bulk[BULK_COUNT];
+	for (int i = 0; i < BULK_COUNT; i++) {
+		bulk[i] = fiber_new_xc("bulk", bulk_f);
+		fiber_set_joinable(bulk[i], true);
+		fiber_start(bulk[i]);
+	}
+	/* Bulk tasks must leave a worker for a latency-critical one. */
+	int res = coio_call_class(COIO_LATENCY, coio_test_wakeup);
+	note("latency call done with res %i", res);
+	__atomic_store_n(&bulk_is_released, true, __ATOMIC_SEQ_CST);
+	for (int i = 0; i < BULK_COUNT; i++)
+		fiber_join(bulk[i]);
+	struct coio_class_stat stat;
+	coio_class_stat(COIO_BULK, &stat);
+	note("bulk tasks completed: %lld", (long long) stat.total);
+	footer();
+	return 0;
+}
+
 static int
 main_f(va_list ap)
 {
@@ -86,6 +127,12 @@ main_f(va_list ap)
 	fiber_cancel(call_fiber);
 	fiber_join(call_fiber);
 
+	struct fiber *priority_fiber = fiber_new_xc("coio priority",
+						    test_priority_f);
+	fiber_set_joinable(priority_fiber, true);
+	fiber_start(priority_fiber);
+	fiber_join(priority_fiber);
+
 	ev_break(loop(), EVBREAK_ALL);
 	return 0;
 }
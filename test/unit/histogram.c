@@ -129,6 +129,41 @@ test_discard(void)
 	footer();
 }
 
+static void
+test_copy(void)
+{
+	header();
+
+	size_t n_buckets;
+	int64_t *buckets = gen_buckets(&n_buckets);
+
+	size_t data_len;
+	int64_t *data = gen_rand_data(&data_len);
+
+	struct histogram *hist = histogram_new(buckets, n_buckets);
+	struct histogram *copy = histogram_new(buckets, n_buckets);
+	histogram_collect(copy, 1);
+	for (size_t i = 0; i < data_len; i++)
+		histogram_collect(hist, data[i]);
+
+	histogram_copy(copy, hist);
+	fail_if(copy->total != hist->total);
+	fail_if(copy->max != hist->max);
+	for (size_t b = 0; b < n_buckets; b++)
+		fail_if(copy->buckets[b].count != hist->buckets[b].count);
+	for (int pct = 5; pct < 100; pct += 5) {
+		fail_if(histogram_percentile(copy, pct) !=
+			histogram_percentile(hist, pct));
+	}
+
+	histogram_delete(copy);
+	histogram_delete(hist);
+	free(data);
+	free(buckets);
+
+	footer();
+}
+
 static void
 test_percentile(void)
 {
@@ -177,5 +212,6 @@ main()
 	srand(time(NULL));
 	test_counts();
 	test_discard();
+	test_copy();
 	test_percentile();
 }
@@ -23,6 +23,8 @@ const unsigned BOX_POINT_CHANCE_PERCENT = 5;
 const unsigned NEIGH_COUNT = 5;
 const unsigned AVERAGE_COUNT = 500;
 const unsigned TEST_ROUNDS = 1000;
+const unsigned BULK_COUNTS[] = {0, 1, 20, 100, 2000};
+const unsigned BULK_TEST_ROUNDS = 100;
 
 static int page_count = 0;
 
@@ -534,6 +536,83 @@ rand_test()
 	footer();
 }
 
+template<unsigned DIMENSION>
+static void
+bulk_test_count(unsigned count)
+{
+	CBoxSet<DIMENSION> set;
+
+	struct rtree tree, ref_tree;
+	rtree_init(&tree, DIMENSION, extent_size,
+		   extent_alloc, extent_free, &page_count,
+		   RTREE_EUCLID);
+	rtree_init(&ref_tree, DIMENSION, extent_size,
+		   extent_alloc, extent_free, &page_count,
+		   RTREE_EUCLID);
+
+	struct rtree_builder builder;
+	rtree_builder_create(&builder, &tree);
+	if (rtree_builder_reserve(&builder, count / 2) != 0)
+		fail("reserve failed", "true");
+	for (unsigned i = 0; i < count; i++) {
+		CBox<DIMENSION> box;
+		box.Randomize();
+		size_t id = set.AddBox(box);
+		struct rtree_rect rt;
+		box.FillRTreeRect(&rt);
+		if (rtree_builder_append(&builder, &rt, (void *)(id + 1)) != 0)
+			fail("append failed", "true");
+		rtree_insert(&ref_tree, &rt, (void *)(id + 1));
+	}
+	if (rtree_builder_finish(&builder) != 0)
+		fail("bulk load failed", "true");
+	rtree_builder_destroy(&builder);
+
+	printf("\tcount: %u, records: %u, not more pages than insert: %d\n",
+	       count, tree.n_records, tree.n_pages <= ref_tree.n_pages);
+	rtree_destroy(&ref_tree);
+
+	/* The loaded tree must stay consistent under modifications. */
+	for (unsigned i = 0; i < BULK_TEST_ROUNDS; i++) {
+		if (set.boxCount > 0 && rand() % 2 == 0) {
+			size_t id = set.RandUsedID();
+			struct rtree_rect rt;
+			set.entries[id].box.FillRTreeRect(&rt);
+			if (!rtree_remove(&tree, &rt, (void *)(id + 1)))
+				printf("Error in remove\n");
+			set.DeleteBox(id);
+		} else {
+			CBox<DIMENSION> box;
+			box.Randomize();
+			size_t id = set.AddBox(box);
+			struct rtree_rect rt;
+			box.FillRTreeRect(&rt);
+			rtree_insert(&tree, &rt, (void *)(id + 1));
+		}
+		assert(set.boxCount == tree.n_records);
+		test_select_neigh<DIMENSION>(set, &tree);
+		test_select_neigh_man<DIMENSION>(set, &tree);
+		test_select_in<DIMENSION>(set, &tree);
+		test_select_strict_in<DIMENSION>(set, &tree);
+	}
+
+	rtree_destroy(&tree);
+}
+
+template<unsigned DIMENSION>
+static void
+bulk_test()
+{
+	header();
+
+	printf("\tDIMENSION: %u\n", DIMENSION);
+	for (unsigned i = 0; i < sizeof(BULK_COUNTS) / sizeof(BULK_COUNTS[0]);
+	     i++)
+		bulk_test_count<DIMENSION>(BULK_COUNTS[i]);
+
+	footer();
+}
+
 int
 main(void)
 {
@@ -543,6 +622,11 @@ main(void)
 	rand_test<3>();
 	rand_test<8>();
 	rand_test<16>();
+	bulk_test<1>();
+	bulk_test<2>();
+	bulk_test<3>();
+	bulk_test<8>();
+	bulk_test<16>();
 	if (page_count != 0) {
 		fail("memory leak!", "true");
 	}
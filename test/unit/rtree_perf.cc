@@ -0,0 +1,156 @@
+/*
+ * An R-tree build and search benchmark.
+ *
+ * Builds a tree of random 2D boxes by inserting them one by one
+ * and by bulk loading, then runs the same overlap and neighbor
+ * searches against both trees.
+ *
+ * Usage: rtree_perf [record_count [search_count]]
+ */
+#include <assert.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "salad/rtree.h"
+
+enum { DIMENSION = 2 };
+
+static const uint32_t extent_size = 16 * 1024;
+static const coord_t space_limit = 10000;
+static const coord_t box_limit = 10;
+/* Number of neighbors fetched by a neighbor search. */
+static const int neigh_count = 10;
+
+/* Number of records in the tree. */
+static int record_count = 1000000;
+/* Number of searches of each kind. */
+static int search_count = 100000;
+
+static void *
+extent_alloc(void *ctx)
+{
+	(void)ctx;
+	return malloc(extent_size);
+}
+
+static void
+extent_free(void *ctx, void *extent)
+{
+	(void)ctx;
+	free(extent);
+}
+
+static double
+clock_now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static coord_t
+rand_coord(coord_t limit)
+{
+	return (coord_t)rand() / RAND_MAX * limit;
+}
+
+static void
+rand_box(struct rtree_rect *rect)
+{
+	coord_t x = rand_coord(space_limit);
+	coord_t y = rand_coord(space_limit);
+	rtree_set2d(rect, x, y, x + rand_coord(box_limit),
+		    y + rand_coord(box_limit));
+}
+
+static void
+bench_search(const char *name, struct rtree *tree)
+{
+	struct rtree_iterator iterator;
+	rtree_iterator_init(&iterator);
+	srand(1);
+	long long found = 0;
+	double start = clock_now();
+	for (int i = 0; i < search_count; i++) {
+		struct rtree_rect rect;
+		coord_t x = rand_coord(space_limit);
+		coord_t y = rand_coord(space_limit);
+		rtree_set2d(&rect, x, y, x + 100, y + 100);
+		if (!rtree_search(tree, &rect, SOP_OVERLAPS, &iterator))
+			continue;
+		while (rtree_iterator_next(&iterator) != NULL)
+			found++;
+	}
+	double overlaps = clock_now() - start;
+	start = clock_now();
+	for (int i = 0; i < search_count; i++) {
+		struct rtree_rect rect;
+		rtree_set2dp(&rect, rand_coord(space_limit),
+			     rand_coord(space_limit));
+		if (!rtree_search(tree, &rect, SOP_NEIGHBOR, &iterator))
+			continue;
+		for (int j = 0; j < neigh_count; j++) {
+			if (rtree_iterator_next(&iterator) == NULL)
+				break;
+		}
+	}
+	double neighbors = clock_now() - start;
+	rtree_iterator_destroy(&iterator);
+	printf("%s: %u pages, height %u, %.0f overlap searches/s "
+	       "(%lld found), %.0f neighbor searches/s\n", name,
+	       tree->n_pages, tree->height, search_count / overlaps, found,
+	       search_count / neighbors);
+}
+
+int
+main(int argc, char **argv)
+{
+	if (argc > 1)
+		record_count = atoi(argv[1]);
+	if (argc > 2)
+		search_count = atoi(argv[2]);
+	if (record_count <= 0 || search_count <= 0) {
+		fprintf(stderr, "usage: %s [record_count [search_count]]\n",
+			argv[0]);
+		return 1;
+	}
+
+	struct rtree tree;
+	rtree_init(&tree, DIMENSION, extent_size, extent_alloc,
+		   extent_free, NULL, RTREE_EUCLID);
+	srand(0);
+	double start = clock_now();
+	for (int i = 0; i < record_count; i++) {
+		struct rtree_rect rect;
+		rand_box(&rect);
+		rtree_insert(&tree, &rect, (record_t)(uintptr_t)(i + 1));
+	}
+	printf("insert: %d records in %.3f s\n", record_count,
+	       clock_now() - start);
+	bench_search("insert", &tree);
+	rtree_destroy(&tree);
+
+	rtree_init(&tree, DIMENSION, extent_size, extent_alloc,
+		   extent_free, NULL, RTREE_EUCLID);
+	struct rtree_builder builder;
+	rtree_builder_create(&builder, &tree);
+	srand(0);
+	start = clock_now();
+	for (int i = 0; i < record_count; i++) {
+		struct rtree_rect rect;
+		rand_box(&rect);
+		if (rtree_builder_append(&builder, &rect,
+					 (record_t)(uintptr_t)(i + 1)) != 0)
+			abort();
+	}
+	if (rtree_builder_finish(&builder) != 0)
+		abort();
+	rtree_builder_destroy(&builder);
+	printf("bulk load: %d records in %.3f s\n", record_count,
+	       clock_now() - start);
+	bench_search("bulk load", &tree);
+	rtree_destroy(&tree);
+	return 0;
+}
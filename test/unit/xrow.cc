@@ -210,6 +210,7 @@ test_xrow_header_encode_decode()
 	is(xrow_header_decode(&header, (const char **) &pos,
 			      buffer + 100), -1, "bad msgpack end");
 
+	memset(&header, 0, sizeof(header));
 	header.type = 100;
 	header.replica_id = 200;
 	header.lsn = 400;
@@ -239,6 +240,85 @@ test_xrow_header_encode_decode()
 	check_plan();
 }
 
+/** Encode and decode a row of a transaction. */
+static int
+test_xrow_header_tsn_roundtrip(struct xrow_header *header,
+			       struct xrow_header *decoded, int *map_size)
+{
+	struct iovec vec[1];
+	if (xrow_header_encode(header, 0, vec, 0) != 1)
+		return -1;
+	if (vec[0].iov_len > XROW_HEADER_LEN_MAX)
+		return -1;
+	const char *pos = (const char *)vec[0].iov_base;
+	const char *end = pos + vec[0].iov_len;
+	const char *map = pos;
+	*map_size = mp_decode_map(&map);
+	return xrow_header_decode(decoded, &pos, end);
+}
+
+void
+test_xrow_header_tsn()
+{
+	plan(15);
+	struct xrow_header header, decoded;
+	int map_size;
+
+	/* A single-row transaction carries no TSN and no flags. */
+	memset(&header, 0, sizeof(header));
+	header.type = IPROTO_INSERT;
+	header.replica_id = 1;
+	header.lsn = 100;
+	header.tsn = 100;
+	header.is_commit = true;
+	is(test_xrow_header_tsn_roundtrip(&header, &decoded, &map_size), 0,
+	   "single-row decode");
+	is(map_size, 3, "single-row map size");
+	is(decoded.tsn, 100, "single-row tsn");
+	ok(decoded.is_commit, "single-row is_commit");
+
+	/* The first row of a multi-row transaction. */
+	header.is_commit = false;
+	is(test_xrow_header_tsn_roundtrip(&header, &decoded, &map_size), 0,
+	   "first row decode");
+	is(map_size, 4, "first row map size");
+	is(decoded.tsn, 100, "first row tsn");
+	ok(!decoded.is_commit, "first row is not commit");
+
+	/* The last row of a multi-row transaction. */
+	header.lsn = 102;
+	header.is_commit = true;
+	is(test_xrow_header_tsn_roundtrip(&header, &decoded, &map_size), 0,
+	   "commit row decode");
+	is(map_size, 5, "commit row map size");
+	is(decoded.tsn, 100, "commit row tsn");
+	ok(decoded.is_commit, "commit row is commit");
+
+	/* All header keys of max length fit XROW_HEADER_LEN_MAX. */
+	header.type = IPROTO_TYPE_STAT_MAX - 1;
+	header.replica_id = UINT32_MAX;
+	header.lsn = INT64_MAX;
+	header.tsn = 1;
+	header.tm = 123.456;
+	struct iovec vec[1];
+	is(xrow_header_encode(&header, UINT64_MAX, vec, 0), 1,
+	   "max header encode");
+	ok(vec[0].iov_len <= XROW_HEADER_LEN_MAX, "max header length");
+
+	/* A row without IPROTO_TSN, e.g. from an old xlog. */
+	char buffer[64];
+	char *d = mp_encode_map(buffer, 2);
+	d = mp_encode_uint(d, IPROTO_REQUEST_TYPE);
+	d = mp_encode_uint(d, IPROTO_INSERT);
+	d = mp_encode_uint(d, IPROTO_LSN);
+	d = mp_encode_uint(d, 200);
+	const char *pos = buffer;
+	xrow_header_decode(&decoded, &pos, d);
+	ok(decoded.tsn == 200 && decoded.is_commit, "row without tsn");
+
+	check_plan();
+}
+
 void
 test_request_str()
 {
@@ -275,7 +355,7 @@ main(void)
 {
 	memory_init();
 	fiber_init(fiber_c_invoke);
-	plan(3);
+	plan(4);
 
 	random_init();
 
@@ -283,6 +363,7 @@ main(void)
 	test_greeting();
 	test_xrow_header_encode_decode();
 	test_request_str();
+	test_xrow_header_tsn();
 
 	random_free();
 	fiber_free();
@@ -1,3 +0,0 @@
-#!/bin/sh
-
-autoreconf --install --symlink --force